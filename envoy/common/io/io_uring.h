@@ -42,9 +42,23 @@ public:
    */
   IoUringSocket& socket() const { return socket_; }
 
+  /**
+   * Returns the flags of the latest completion of the request, i.e. the `IORING_CQE_F_*` bits of
+   * the completion queue entry. Only multishot requests and requests which read into a provided
+   * buffer set any flags.
+   */
+  uint32_t completionFlags() const { return completion_flags_; }
+
+  /**
+   * Sets the flags of the latest completion of the request. Called by the io_uring before the
+   * completion is handed to the socket.
+   */
+  void setCompletionFlags(uint32_t flags) { completion_flags_ = flags; }
+
 private:
   RequestType type_;
   IoUringSocket& socket_;
+  uint32_t completion_flags_{0};
 };
 
 /**
@@ -101,6 +115,15 @@ public:
   virtual IoUringResult prepareAccept(os_fd_t fd, struct sockaddr* remote_addr,
                                       socklen_t* remote_addr_len, Request* user_data) PURE;
 
+  /**
+   * Prepares a multishot accept and puts it into the submission queue. The request stays armed
+   * and completes once for every accepted connection, as long as the completion flags carry
+   * `IORING_CQE_F_MORE`. Accepted sockets are non-blocking.
+   * Returns IoUringResult::Failed in case the submission queue is full already
+   * and IoUringResult::Ok otherwise.
+   */
+  virtual IoUringResult prepareAcceptMultishot(os_fd_t fd, Request* user_data) PURE;
+
   /**
    * Prepares a connect system call and puts it into the submission queue.
    * Returns IoUringResult::Failed in case the submission queue is full already
@@ -118,6 +141,15 @@ public:
   virtual IoUringResult prepareReadv(os_fd_t fd, const struct iovec* iovecs, unsigned nr_vecs,
                                      off_t offset, Request* user_data) PURE;
 
+  /**
+   * Prepares a multishot receive which reads into buffers picked from the provided buffer ring,
+   * see registerBufferRing(). The request stays armed as long as the completion flags carry
+   * `IORING_CQE_F_MORE`, and the buffer of each completion is identified by its flags.
+   * Returns IoUringResult::Failed in case the submission queue is full already
+   * and IoUringResult::Ok otherwise.
+   */
+  virtual IoUringResult prepareRecvMultishot(os_fd_t fd, Request* user_data) PURE;
+
   /**
    * Prepares a writev system call and puts it into the submission queue.
    * Returns IoUringResult::Failed in case the submission queue is full already
@@ -175,6 +207,51 @@ public:
    * @param fd is used to refer to the completions will be removed.
    */
   virtual void removeInjectedCompletion(os_fd_t fd) PURE;
+
+  /**
+   * Registers a ring of `buffer_count` buffers of `buffer_size` bytes each with the kernel. The
+   * kernel picks the buffers for multishot receive requests from this ring.
+   * @param buffer_count the number of buffers, which must be a power of two.
+   * @param buffer_size the size of each buffer.
+   * @return whether the ring was registered. This fails on kernels without buffer ring support.
+   */
+  virtual bool registerBufferRing(uint32_t buffer_count, uint32_t buffer_size) PURE;
+
+  /**
+   * Hands the provided buffer selected by a receive completion over to a buffer as a fragment,
+   * without copying. The buffer is given back to the ring once the fragment is released.
+   * @param buffer_id the buffer id from the completion flags.
+   * @param length the number of bytes received into the provided buffer.
+   * @param buffer the buffer to append the data to.
+   */
+  virtual void takeProvidedBuffer(uint16_t buffer_id, uint32_t length,
+                                  Buffer::Instance& buffer) PURE;
+
+  /**
+   * Gives the provided buffer selected by a receive completion back to the ring, discarding its
+   * data.
+   * @param buffer_id the buffer id from the completion flags.
+   */
+  virtual void recycleProvidedBuffer(uint16_t buffer_id) PURE;
+
+  /**
+   * Creates a sparse table of registered files with `size` slots. File descriptors registered in
+   * the table are referenced by the kernel without looking them up for every request.
+   * @return whether the table was created.
+   */
+  virtual bool registerFileTable(uint32_t size) PURE;
+
+  /**
+   * Registers a file descriptor in the file table, if there is one and the descriptor fits in it.
+   * Subsequent requests on the descriptor use the registered file.
+   */
+  virtual void registerFile(os_fd_t fd) PURE;
+
+  /**
+   * Removes a file descriptor from the file table. This has to happen before the descriptor is
+   * closed, since the table holds a reference to the file.
+   */
+  virtual void unregisterFile(os_fd_t fd) PURE;
 };
 
 using IoUringPtr = std::unique_ptr<IoUring>;
@@ -376,6 +453,12 @@ public:
    * @param cb the callback function.
    */
   virtual void setFileReadyCb(Event::FileReadyCb cb) PURE;
+
+  /**
+   * Pop a connection accepted by a multishot accept request of a listening socket.
+   * @return the file descriptor of the accepted connection, or INVALID_SOCKET if there is none.
+   */
+  virtual os_fd_t popAcceptedSocket() PURE;
 };
 
 using IoUringSocketPtr = std::unique_ptr<IoUringSocket>;
@@ -405,6 +488,17 @@ public:
   virtual IoUringSocket& addClientSocket(os_fd_t fd, Event::FileReadyCb cb,
                                          bool enable_close_event) PURE;
 
+  /**
+   * Add a listening socket to the worker. Connections are accepted with a multishot accept
+   * request, so this is only supported if supportsMultishot() returns true.
+   */
+  virtual IoUringSocket& addAcceptSocket(os_fd_t fd, Event::FileReadyCb cb) PURE;
+
+  /**
+   * Return whether the worker uses multishot accept and receive requests.
+   */
+  virtual bool supportsMultishot() const PURE;
+
   /**
    * Return the current thread's dispatcher.
    */
@@ -417,6 +511,11 @@ public:
   submitConnectRequest(IoUringSocket& socket,
                        const Network::Address::InstanceConstSharedPtr& address) PURE;
 
+  /**
+   * Submit an accept request for a listening socket.
+   */
+  virtual Request* submitAcceptRequest(IoUringSocket& socket) PURE;
+
   /**
    * Submit a read request for a socket.
    */
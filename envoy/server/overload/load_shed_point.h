@@ -33,6 +33,10 @@ public:
 
   const std::string HttpDownstreamFilterCheck =
       "envoy.load_shed_points.http_downstream_filter_check";
+
+  // Envoy will stop adaptively preconnecting upstream connections ahead of predicted demand.
+  const std::string UpstreamAdaptivePreconnect =
+      "envoy.load_shed_points.upstream_adaptive_preconnect";
 };
 
 using LoadShedPointName = ConstSingleton<LoadShedPointNameValues>;
@@ -99,6 +99,23 @@ public:
    */
   virtual void setSinkPredicates(std::unique_ptr<SinkPredicates>&& sink_predicates) PURE;
 
+  /**
+   * Selects, by their name, the counters and gauges which are sharded.
+   */
+  using ShardedStatPredicate = std::function<bool(absl::string_view)>;
+
+  /**
+   * Sets the number of per-thread slots of the counters and gauges allocated from now on. Each
+   * slot takes a cache line of its own, so threads updating the same stat don't contend on it, at
+   * the cost of summing the slots whenever the stat is read. 0 or 1 keeps a single value per stat.
+   * Stats allocated before the call keep their layout.
+   *
+   * As the slots cost a cache line per stat and thread, only the stats accepted by `predicate`
+   * are sharded, which should be the few ones that every request updates. A null predicate
+   * shards all of them.
+   */
+  virtual void setShardCount(uint32_t shard_count, ShardedStatPredicate predicate) PURE;
+
   // TODO(jmarantz): create a parallel mechanism to instantiate histograms. At
   // the moment, histograms don't fit the same pattern of counters and gauges
   // as they are not actually created in the context of a stats allocator.
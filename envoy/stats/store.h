@@ -6,6 +6,7 @@
 
 #include "envoy/common/optref.h"
 #include "envoy/common/pure.h"
+#include "envoy/stats/allocator.h"
 #include "envoy/stats/histogram.h"
 #include "envoy/stats/scope.h"
 #include "envoy/stats/stats.h"
@@ -266,6 +267,13 @@ public:
   virtual void setSinkPredicates(std::unique_ptr<SinkPredicates>&& sink_predicates) PURE;
 
   virtual OptRef<SinkPredicates> sinkPredicates() PURE;
+
+  /**
+   * Set the number of per-thread slots of the counters and gauges selected by `predicate`, see
+   * Allocator::setShardCount().
+   */
+  virtual void setShardCount(uint32_t shard_count,
+                             Allocator::ShardedStatPredicate predicate) PURE;
 };
 
 using StoreRootPtr = std::unique_ptr<StoreRoot>;
@@ -24,6 +24,7 @@
 #include "envoy/secret/secret_manager.h"
 #include "envoy/server/admin.h"
 #include "envoy/server/options.h"
+#include "envoy/server/overload/load_shed_point.h"
 #include "envoy/singleton/manager.h"
 #include "envoy/ssl/context_manager.h"
 #include "envoy/stats/store.h"
@@ -199,6 +200,8 @@ struct ClusterConnectivityState {
   // a late-received SETTINGS frame, this MAY BE NEGATIVE.
   // Note this tracks the sum of multiple 32 bit stream capacities so must remain 64 bit.
   int64_t connecting_and_connected_stream_capacity_{};
+  // If set and shedding load, connection pools stop preconnecting for predicted stream arrivals.
+  Server::LoadShedPoint* adaptive_preconnect_load_shed_point_{};
 };
 
 /**
@@ -907,6 +907,17 @@ class TypedLoadBalancerFactory;
 using AddressSelectFn = std::function<const Network::Address::InstanceConstSharedPtr(
     const Network::Address::InstanceConstSharedPtr&)>;
 
+/**
+ * Adaptive preconnect configuration of a cluster.
+ * @see envoy::config::cluster::v3::Cluster::PreconnectPolicy::AdaptivePreconnect.
+ */
+struct AdaptivePreconnectConfig {
+  // The time constant of the stream arrival rate and connection latency moving averages.
+  std::chrono::milliseconds averaging_window_;
+  // The most streams a connection pool preconnects for in anticipation of arrivals.
+  uint32_t max_anticipated_streams_;
+};
+
 /**
  * Information about a given upstream cluster.
  * This includes the information and interfaces for building an upstream filter chain.
@@ -966,6 +977,11 @@ public:
    */
   virtual float peekaheadRatio() const PURE;
 
+  /**
+   * @return the adaptive preconnect configuration, if adaptive preconnect is enabled.
+   */
+  virtual const absl::optional<AdaptivePreconnectConfig>& adaptivePreconnect() const PURE;
+
   /**
    * @return soft limit on size of the cluster's connections read and write buffers.
    */
@@ -1167,6 +1183,12 @@ public:
    */
   virtual bool connectionPoolPerDownstreamConnection() const PURE;
 
+  /**
+   * @return the number of workers owning the HTTP/2 connections to each host which are shared
+   *         between workers, or 0 if workers do not share connections.
+   */
+  virtual uint32_t sharedConnectionPoolOwnersPerHost() const PURE;
+
   /**
    * @return true if this cluster is configured to ignore hosts for the purpose of load balancing
    * computations until they have been health checked for the first time.
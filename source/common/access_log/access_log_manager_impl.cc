@@ -1,5 +1,7 @@
 #include "source/common/access_log/access_log_manager_impl.h"
 
+#include <algorithm>
+#include <cstring>
 #include <string>
 
 #include "envoy/common/exception.h"
@@ -7,6 +9,7 @@
 #include "source/common/common/assert.h"
 #include "source/common/common/fmt.h"
 #include "source/common/common/lock_guard.h"
+#include "source/common/runtime/runtime_features.h"
 
 #include "absl/container/fixed_array.h"
 
@@ -16,6 +19,30 @@ namespace {
 static constexpr Filesystem::FlagSet default_flags{1 << Filesystem::File::Operation::Write |
                                                    1 << Filesystem::File::Operation::Create |
                                                    1 << Filesystem::File::Operation::Append};
+
+// Number of files whose buffers a thread caches. When the cache is full, the least recently used
+// entry is evicted, so that the entries of destroyed files are eventually dropped.
+constexpr size_t MaxCachedThreadBuffers = 64;
+
+// The buffers of the calling thread, by file id.
+struct ThreadBufferCache {
+  struct Entry {
+    AccessLogRingBuffer* buffer_;
+    // The value of clock_ when the entry was last used.
+    uint64_t last_use_;
+  };
+
+  absl::flat_hash_map<uint64_t, Entry> entries_;
+  uint64_t clock_{0};
+};
+
+ThreadBufferCache& threadBufferCache() {
+  thread_local ThreadBufferCache cache;
+  return cache;
+}
+
+std::atomic<uint64_t> next_file_id{0};
+
 } // namespace
 
 AccessLogManagerImpl::~AccessLogManagerImpl() {
@@ -46,23 +73,57 @@ AccessLogManagerImpl::createAccessLog(const Filesystem::FilePathAndType& file_in
                                                   open_result.err_->getErrorDetails()));
   }
 
-  access_logs_[file_name] =
-      std::make_shared<AccessLogFileImpl>(std::move(file), dispatcher_, lock_, file_stats_,
-                                          file_flush_interval_msec_, api_.threadFactory());
+  access_logs_[file_name] = std::make_shared<AccessLogFileImpl>(
+      std::move(file), dispatcher_, lock_, file_stats_, file_flush_interval_msec_,
+      api_.threadFactory(),
+      Runtime::runtimeFeatureEnabled("envoy.reloadable_features.access_log_per_thread_buffers"));
   return access_logs_[file_name];
 }
 
+AccessLogRingBuffer::AccessLogRingBuffer(uint64_t capacity)
+    : capacity_(capacity), data_(new char[capacity]) {
+  ASSERT(capacity_ > 0 && (capacity_ & (capacity_ - 1)) == 0);
+}
+
+bool AccessLogRingBuffer::write(absl::string_view data) {
+  const uint64_t head = head_.load(std::memory_order_relaxed);
+  const uint64_t tail = tail_.load(std::memory_order_acquire);
+  if (capacity_ - (head - tail) < data.size()) {
+    return false;
+  }
+  const uint64_t offset = head & (capacity_ - 1);
+  const uint64_t first = std::min<uint64_t>(data.size(), capacity_ - offset);
+  memcpy(data_.get() + offset, data.data(), first);
+  memcpy(data_.get(), data.data() + first, data.size() - first);
+  head_.store(head + data.size(), std::memory_order_release);
+  return true;
+}
+
+uint64_t AccessLogRingBuffer::drainTo(std::string& output) {
+  const uint64_t tail = tail_.load(std::memory_order_relaxed);
+  const uint64_t head = head_.load(std::memory_order_acquire);
+  const uint64_t length = head - tail;
+  const uint64_t offset = tail & (capacity_ - 1);
+  const uint64_t first = std::min(length, capacity_ - offset);
+  output.append(data_.get() + offset, first);
+  output.append(data_.get(), length - first);
+  tail_.store(head, std::memory_order_release);
+  return length;
+}
+
 AccessLogFileImpl::AccessLogFileImpl(Filesystem::FilePtr&& file, Event::Dispatcher& dispatcher,
                                      Thread::BasicLockable& lock, AccessLogFileStats& stats,
                                      std::chrono::milliseconds flush_interval_msec,
-                                     Thread::ThreadFactory& thread_factory)
+                                     Thread::ThreadFactory& thread_factory,
+                                     bool per_thread_buffers)
     : file_(std::move(file)), file_lock_(lock),
       flush_timer_(dispatcher.createTimer([this]() -> void {
         stats_.flushed_by_timer_.inc();
         flush_event_.notifyOne();
         flush_timer_->enableTimer(flush_interval_msec_);
       })),
-      thread_factory_(thread_factory), flush_interval_msec_(flush_interval_msec), stats_(stats) {
+      thread_factory_(thread_factory), flush_interval_msec_(flush_interval_msec), stats_(stats),
+      per_thread_buffers_(per_thread_buffers), id_(next_file_id++) {
   flush_timer_->enableTimer(flush_interval_msec_);
 }
 
@@ -85,7 +146,10 @@ AccessLogFileImpl::~AccessLogFileImpl() {
 
   // Flush any remaining data. If file was not opened for some reason, skip flushing part.
   if (file_->isOpen()) {
-    if (flush_buffer_.length() > 0) {
+    if (per_thread_buffers_) {
+      drainThreadBuffers();
+      writeDrained();
+    } else if (flush_buffer_.length() > 0) {
       doWrite(flush_buffer_);
     }
     const Api::IoCallBoolResult result = file_->close();
@@ -123,6 +187,46 @@ void AccessLogFileImpl::doWrite(Buffer::Instance& buffer) {
   buffer.drain(buffer.length());
 }
 
+void AccessLogFileImpl::drainThreadBuffers() {
+  absl::MutexLock lock(&thread_buffers_lock_);
+  for (auto& [thread_id, buffer] : thread_buffers_) {
+    buffer->drainTo(drained_);
+  }
+}
+
+void AccessLogFileImpl::writeDrained() {
+  if (drained_.empty()) {
+    return;
+  }
+
+  {
+    // See doWrite() for why the file lock is needed.
+    Thread::LockGuard lock(file_lock_);
+    const Api::IoCallSizeResult result = file_->write(drained_);
+    if (result.ok() && result.return_value_ == static_cast<ssize_t>(drained_.size())) {
+      stats_.write_completed_.inc();
+    } else {
+      stats_.write_failed_.inc();
+    }
+  }
+
+  stats_.write_total_buffered_.sub(drained_.size());
+  drained_.clear();
+}
+
+bool AccessLogFileImpl::hasBufferedData() {
+  if (!per_thread_buffers_) {
+    return flush_buffer_.length() > 0;
+  }
+  absl::MutexLock lock(&thread_buffers_lock_);
+  for (const auto& [thread_id, buffer] : thread_buffers_) {
+    if (buffer->size() > 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
 void AccessLogFileImpl::flushThreadFunc() {
 
   // Transfer the action from `reopen_file_` to this variable so that `reopen_file_` is only
@@ -142,7 +246,7 @@ void AccessLogFileImpl::flushThreadFunc() {
       // Note: do not stop waiting when only `do_reopen` is true. In this case, we tried to
       // reopen and failed. We don't want to retry this in a tight loop, so wait for the next
       // event (timer or flush).
-      while (flush_buffer_.length() == 0 && !flush_thread_exit_ && !reopen_file_) {
+      while (!hasBufferedData() && !flush_thread_exit_ && !reopen_file_) {
         // CondVar::wait() does not throw, so it's safe to pass the mutex rather than the guard.
         flush_event_.wait(write_lock_);
       }
@@ -152,6 +256,7 @@ void AccessLogFileImpl::flushThreadFunc() {
       }
 
       flush_lock = std::unique_lock<Thread::BasicLockable>(flush_lock_);
+      // The thread buffers are drained once the write lock is released.
       about_to_write_buffer_.move(flush_buffer_);
       ASSERT(flush_buffer_.length() == 0);
 
@@ -175,11 +280,23 @@ void AccessLogFileImpl::flushThreadFunc() {
       }
     }
     // doWrite no matter file isOpen, if not, we can drain buffer
-    doWrite(about_to_write_buffer_);
+    if (per_thread_buffers_) {
+      drainThreadBuffers();
+      writeDrained();
+    } else {
+      doWrite(about_to_write_buffer_);
+    }
   }
 }
 
 void AccessLogFileImpl::flush() {
+  if (per_thread_buffers_) {
+    std::unique_lock<Thread::BasicLockable> flush_lock(flush_lock_);
+    drainThreadBuffers();
+    writeDrained();
+    return;
+  }
+
   std::unique_lock<Thread::BasicLockable> flush_buffer_lock;
 
   {
@@ -204,6 +321,11 @@ void AccessLogFileImpl::flush() {
 }
 
 void AccessLogFileImpl::write(absl::string_view data) {
+  if (per_thread_buffers_) {
+    writeToThreadBuffer(data);
+    return;
+  }
+
   Thread::LockGuard lock(write_lock_);
 
   if (flush_thread_ == nullptr) {
@@ -218,6 +340,92 @@ void AccessLogFileImpl::write(absl::string_view data) {
   }
 }
 
+void AccessLogFileImpl::writeToThreadBuffer(absl::string_view data) {
+  AccessLogRingBuffer& buffer = threadBuffer();
+  const uint64_t buffered = buffer.size();
+
+  // The bytes are accounted for before they are visible to the flush thread, which subtracts them.
+  stats_.write_total_buffered_.add(data.length());
+  if (!buffer.write(data) && !growThreadBuffer(buffer, data.size()).write(data)) {
+    stats_.write_total_buffered_.sub(data.length());
+    stats_.write_dropped_.inc();
+    return;
+  }
+  stats_.write_buffered_.inc();
+
+  // Wake up the flush thread when the buffer crosses the flush size, rather than on every write
+  // above it. The lock is only taken then, and it ensures the wake up isn't lost.
+  if (buffered <= MIN_FLUSH_SIZE && buffered + data.size() > MIN_FLUSH_SIZE) {
+    Thread::LockGuard lock(write_lock_);
+    flush_event_.notifyOne();
+  }
+}
+
+AccessLogRingBuffer& AccessLogFileImpl::threadBuffer() {
+  ThreadBufferCache& cache = threadBufferCache();
+  const uint64_t now = ++cache.clock_;
+  auto it = cache.entries_.find(id_);
+  if (it != cache.entries_.end()) {
+    it->second.last_use_ = now;
+    return *it->second.buffer_;
+  }
+  if (cache.entries_.size() >= MaxCachedThreadBuffers) {
+    auto oldest = cache.entries_.begin();
+    for (auto entry = cache.entries_.begin(); entry != cache.entries_.end(); ++entry) {
+      if (entry->second.last_use_ < oldest->second.last_use_) {
+        oldest = entry;
+      }
+    }
+    cache.entries_.erase(oldest);
+  }
+
+  AccessLogRingBuffer* buffer;
+  bool created = false;
+  {
+    absl::MutexLock lock(&thread_buffers_lock_);
+    std::unique_ptr<AccessLogRingBuffer>& thread_buffer =
+        thread_buffers_[thread_factory_.currentThreadId()];
+    if (thread_buffer == nullptr) {
+      thread_buffer = std::make_unique<AccessLogRingBuffer>(INITIAL_THREAD_BUFFER_SIZE);
+      created = true;
+    }
+    buffer = thread_buffer.get();
+  }
+  // Only the first write of a thread may have to start the flush thread. write_lock_ is taken
+  // after thread_buffers_lock_ is released, as the flush thread takes them in the other order.
+  if (created) {
+    Thread::LockGuard lock(write_lock_);
+    if (flush_thread_ == nullptr) {
+      createFlushStructures();
+    }
+  }
+  cache.entries_[id_] = {buffer, now};
+  return *buffer;
+}
+
+AccessLogRingBuffer& AccessLogFileImpl::growThreadBuffer(AccessLogRingBuffer& buffer,
+                                                        uint64_t size) {
+  uint64_t capacity = buffer.capacity();
+  absl::MutexLock lock(&thread_buffers_lock_);
+  while (capacity < THREAD_BUFFER_SIZE && capacity - buffer.size() < size) {
+    capacity <<= 1;
+  }
+  if (capacity == buffer.capacity()) {
+    return buffer;
+  }
+  // The flush thread only drains the buffers while holding thread_buffers_lock_, so the buffered
+  // lines can be moved to the larger buffer here, in order.
+  auto grown = std::make_unique<AccessLogRingBuffer>(capacity);
+  std::string buffered;
+  buffer.drainTo(buffered);
+  const bool written = grown->write(buffered);
+  ASSERT(written);
+  AccessLogRingBuffer* result = grown.get();
+  thread_buffers_[thread_factory_.currentThreadId()] = std::move(grown);
+  threadBufferCache().entries_[id_].buffer_ = result;
+  return *result;
+}
+
 void AccessLogFileImpl::createFlushStructures() {
   flush_thread_ = thread_factory_.createThread([this]() -> void { flushThreadFunc(); },
                                                Thread::Options{"AccessLogFlush"});
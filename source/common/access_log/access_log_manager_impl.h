@@ -1,5 +1,7 @@
 #pragma once
 
+#include <atomic>
+#include <memory>
 #include <string>
 
 #include "envoy/access_log/access_log.h"
@@ -11,9 +13,12 @@
 
 #include "source/common/buffer/buffer_impl.h"
 #include "source/common/common/logger.h"
+#include "source/common/common/non_copyable.h"
 #include "source/common/common/thread.h"
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/container/node_hash_map.h"
+#include "absl/synchronization/mutex.h"
 
 namespace Envoy {
 
@@ -22,6 +27,7 @@ namespace Envoy {
   COUNTER(reopen_failed)                                                                           \
   COUNTER(write_buffered)                                                                          \
   COUNTER(write_completed)                                                                         \
+  COUNTER(write_dropped)                                                                           \
   COUNTER(write_failed)                                                                            \
   GAUGE(write_total_buffered, Accumulate)
 
@@ -56,6 +62,47 @@ private:
   absl::node_hash_map<std::string, AccessLogFileSharedPtr> access_logs_;
 };
 
+/**
+ * Bounded single producer, single consumer ring of log bytes. A line is either written to the ring
+ * in full or not at all, and becomes visible to the consumer only once it has been copied in, so
+ * the consumer never sees a partial line.
+ */
+class AccessLogRingBuffer : NonCopyable {
+public:
+  // capacity must be a power of two.
+  explicit AccessLogRingBuffer(uint64_t capacity);
+
+  /**
+   * Called by the producer.
+   * @return false, without writing anything, if there is no room for data.
+   */
+  bool write(absl::string_view data);
+
+  /**
+   * Called by the consumer. Appends the buffered bytes to output and releases them.
+   * @return the number of bytes appended.
+   */
+  uint64_t drainTo(std::string& output);
+
+  /**
+   * @return the number of buffered bytes. This is exact only on the consumer, the producer may
+   *         see a stale, larger value.
+   */
+  uint64_t size() const {
+    return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+  }
+
+  uint64_t capacity() const { return capacity_; }
+
+private:
+  const uint64_t capacity_;
+  const std::unique_ptr<char[]> data_;
+  // Total bytes written by the producer, and total bytes released by the consumer. They are kept
+  // on separate cache lines so that the two sides don't false share.
+  alignas(64) std::atomic<uint64_t> head_{0};
+  alignas(64) std::atomic<uint64_t> tail_{0};
+};
+
 /**
  * This is a file implementation geared for writing out access logs. It turn out that in certain
  * cases even if a standard file is opened with O_NONBLOCK, the kernel can still block when writing.
@@ -68,9 +115,15 @@ public:
   AccessLogFileImpl(Filesystem::FilePtr&& file, Event::Dispatcher& dispatcher,
                     Thread::BasicLockable& lock, AccessLogFileStats& stats,
                     std::chrono::milliseconds flush_interval_msec,
-                    Thread::ThreadFactory& thread_factory);
+                    Thread::ThreadFactory& thread_factory, bool per_thread_buffers = false);
   ~AccessLogFileImpl() override;
 
+  // Initial and maximum capacity of the buffer of each writing thread, if per thread buffers are
+  // used. A buffer doubles when a line doesn't fit in it, so that threads which seldom log keep a
+  // small one. Lines which don't fit in a buffer of the maximum capacity are dropped.
+  static constexpr uint64_t INITIAL_THREAD_BUFFER_SIZE = 1024 * 16;
+  static constexpr uint64_t THREAD_BUFFER_SIZE = 1024 * 256;
+
   // AccessLog::AccessLogFile
   void write(absl::string_view data) override;
 
@@ -86,6 +139,15 @@ private:
   void doWrite(Buffer::Instance& buffer);
   void flushThreadFunc();
   void createFlushStructures();
+  bool hasBufferedData() ABSL_EXCLUSIVE_LOCKS_REQUIRED(write_lock_);
+
+  // Per thread buffers. Each writing thread appends to its own ring without taking any lock, and
+  // the flush thread drains all the rings into one contiguous write.
+  void writeToThreadBuffer(absl::string_view data);
+  AccessLogRingBuffer& threadBuffer();
+  AccessLogRingBuffer& growThreadBuffer(AccessLogRingBuffer& buffer, uint64_t size);
+  void drainThreadBuffers();
+  void writeDrained();
 
   // Minimum size before the flush thread will be told to flush.
   static const uint64_t MIN_FLUSH_SIZE = 1024 * 64;
@@ -95,7 +157,8 @@ private:
   // These locks are always acquired in the following order if multiple locks are held:
   //    1) write_lock_
   //    2) flush_lock_
-  //    3) file_lock_
+  //    3) thread_buffers_lock_
+  //    4) file_lock_
   Thread::BasicLockable& file_lock_;      // This lock is used only by the flush thread when writing
                                           // to disk. This is used to make sure that file blocks do
                                           // not get interleaved by multiple processes writing to
@@ -131,6 +194,18 @@ private:
                                                         // matter if it reached the MIN_FLUSH_SIZE
                                                         // or not.
   AccessLogFileStats& stats_;
+
+  // Set if writes go to per thread buffers rather than to flush_buffer_.
+  const bool per_thread_buffers_;
+  // Identifies this file in the per thread cache of buffers. Unlike the address of the file, it is
+  // never reused.
+  const uint64_t id_;
+  absl::Mutex thread_buffers_lock_;
+  absl::flat_hash_map<Thread::ThreadId, std::unique_ptr<AccessLogRingBuffer>>
+      thread_buffers_ ABSL_GUARDED_BY(thread_buffers_lock_);
+  // Used only while holding flush_lock_. The thread buffers are drained into it, so that they are
+  // written to disk with a single write.
+  std::string drained_;
 };
 
 } // namespace AccessLog
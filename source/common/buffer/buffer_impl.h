@@ -9,6 +9,7 @@
 #include "envoy/buffer/buffer.h"
 #include "envoy/http/stream_reset_handler.h"
 
+#include "source/common/buffer/slice_pool.h"
 #include "source/common/common/assert.h"
 #include "source/common/common/non_copyable.h"
 #include "source/common/common/utility.h"
@@ -37,7 +38,7 @@ namespace Buffer {
 class Slice {
 public:
   using Reservation = RawSlice;
-  using StoragePtr = std::unique_ptr<uint8_t[]>;
+  using StoragePtr = SliceStoragePtr;
 
   struct SizedStorage {
     StoragePtr mem_{};
@@ -57,13 +58,7 @@ public:
    * @param account the account to charge.
    */
   Slice(uint64_t min_capacity, const BufferMemoryAccountSharedPtr& account)
-      : capacity_(sliceSize(min_capacity)), storage_(new uint8_t[capacity_]),
-        base_(storage_.get()) {
-    if (account) {
-      account->charge(capacity_);
-      account_ = account;
-    }
-  }
+      : Slice(newStorage(min_capacity), 0, account) {}
 
   /**
    * Create an empty mutable Slice that owns its storage, which it charges to the provided account,
@@ -363,6 +358,8 @@ public:
   }
 
   static constexpr uint32_t default_slice_size_ = 16384;
+  static_assert(default_slice_size_ == SlicePool::BlockSize,
+                "slice pool blocks must hold a default sized slice");
 
 public:
   /**
@@ -385,6 +382,10 @@ public:
    */
   static inline SizedStorage newStorage(uint64_t min_capacity) {
     const uint64_t slice_size = sliceSize(min_capacity);
+    // Default sized storage is served from the per-thread slice pool, if enabled.
+    if (slice_size == default_slice_size_ && SlicePool::enabled()) {
+      return {SlicePool::allocate(), static_cast<size_t>(slice_size)};
+    }
     return {StoragePtr{new uint8_t[slice_size]}, static_cast<size_t>(slice_size)};
   }
 
@@ -787,6 +788,10 @@ private:
 
     OwnedImplReservationSlicesOwnerMultiple() : free_list_ref_(free_list_) {}
     ~OwnedImplReservationSlicesOwnerMultiple() override {
+      if (SlicePool::enabled()) {
+        // Unused storages are returned to the slice pool when owned_storages_ is destroyed.
+        return;
+      }
       for (auto r = owned_storages_.rbegin(); r != owned_storages_.rend(); r++) {
         if (r->mem_ != nullptr) {
           ASSERT(r->len_ == Slice::default_slice_size_);
@@ -799,6 +804,9 @@ private:
 
     Slice::SizedStorage newStorage() {
       ASSERT(Slice::sliceSize(Slice::default_slice_size_) == Slice::default_slice_size_);
+      if (SlicePool::enabled()) {
+        return Slice::newStorage(Slice::default_slice_size_);
+      }
 
       Slice::SizedStorage storage{nullptr, Slice::default_slice_size_};
       if (!free_list_ref_.empty()) {
@@ -0,0 +1,198 @@
+#include "source/common/buffer/slice_pool.h"
+
+#include <new>
+
+#include "source/common/common/assert.h"
+#include "source/common/common/macros.h"
+
+#include "absl/container/flat_hash_set.h"
+#include "absl/synchronization/mutex.h"
+
+namespace Envoy {
+namespace Buffer {
+namespace {
+
+// Tracks the live pools so that their stats can be summed, along with the totals of the pools
+// whose owning threads have exited.
+struct SlicePoolRegistry {
+  absl::Mutex mutex_;
+  absl::flat_hash_set<const SlicePool*> pools_ ABSL_GUARDED_BY(mutex_);
+  SlicePoolStats retired_ ABSL_GUARDED_BY(mutex_);
+};
+
+SlicePoolRegistry& registry() { MUTABLE_CONSTRUCT_ON_FIRST_USE(SlicePoolRegistry); }
+
+} // namespace
+
+// Owns the calling thread's reference to its pool, and drops it when the thread exits.
+class ThreadLocalSlicePool {
+public:
+  ~ThreadLocalSlicePool() {
+    exited_ = true;
+    if (pool_ != nullptr) {
+      // Blocks released later on this thread, e.g. by other thread_local destructors, must take
+      // the cross thread path, as the pool no longer has an owner to reclaim them.
+      SlicePool* pool = pool_;
+      pool_ = nullptr;
+      pool->ownerExited();
+    }
+  }
+
+  // Returns nullptr once the thread is exiting, in which case blocks come from the heap.
+  SlicePool* get() {
+    if (pool_ == nullptr && !exited_) {
+      pool_ = new SlicePool();
+    }
+    return pool_;
+  }
+
+  bool owns(const SlicePool* pool) const { return pool_ == pool; }
+
+private:
+  SlicePool* pool_{nullptr};
+  bool exited_{false};
+};
+
+namespace {
+thread_local ThreadLocalSlicePool thread_local_pool;
+} // namespace
+
+std::atomic<bool> SlicePool::enabled_{false};
+
+void SliceStorageDeleter::operator()(uint8_t* mem) const {
+  if (pool_ != nullptr) {
+    pool_->release(mem);
+  } else {
+    delete[] mem;
+  }
+}
+
+SlicePool::SlicePool() {
+  free_blocks_.reserve(MaxCachedBlocks);
+  absl::MutexLock lock(&registry().mutex_);
+  registry().pools_.insert(this);
+}
+
+SliceStoragePtr SlicePool::allocate() {
+  SlicePool* pool = thread_local_pool.get();
+  if (pool == nullptr) {
+    return SliceStoragePtr(new uint8_t[BlockSize], SliceStorageDeleter{});
+  }
+  return SliceStoragePtr(pool->allocateBlock(), SliceStorageDeleter{pool});
+}
+
+uint8_t* SlicePool::allocateBlock() {
+  if (free_blocks_.empty()) {
+    reclaimRemoteFrees();
+  }
+
+  uint8_t* mem;
+  if (!free_blocks_.empty()) {
+    mem = free_blocks_.back();
+    free_blocks_.pop_back();
+    hits_.store(hits_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  } else {
+    mem = new uint8_t[BlockSize];
+    misses_.store(misses_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  }
+  refs_.fetch_add(1, std::memory_order_relaxed);
+  return mem;
+}
+
+void SlicePool::release(uint8_t* mem) {
+  if (thread_local_pool.owns(this)) {
+    if (free_blocks_.size() < MaxCachedBlocks) {
+      free_blocks_.push_back(mem);
+    } else {
+      delete[] mem;
+    }
+  } else {
+    // The block is handed back to the owner through a lock-free stack. The owner only ever takes
+    // the whole stack at once, so there is no ABA hazard.
+    cross_thread_frees_.fetch_add(1, std::memory_order_relaxed);
+    FreeBlock* block = new (mem) FreeBlock();
+    FreeBlock* head = remote_free_blocks_.load(std::memory_order_relaxed);
+    do {
+      block->next_ = head;
+    } while (!remote_free_blocks_.compare_exchange_weak(head, block, std::memory_order_release,
+                                                        std::memory_order_relaxed));
+  }
+  unref();
+}
+
+void SlicePool::reclaimRemoteFrees() {
+  FreeBlock* block = remote_free_blocks_.exchange(nullptr, std::memory_order_acquire);
+  while (block != nullptr) {
+    FreeBlock* next = block->next_;
+    uint8_t* mem = reinterpret_cast<uint8_t*>(block);
+    if (free_blocks_.size() < MaxCachedBlocks) {
+      free_blocks_.push_back(mem);
+    } else {
+      delete[] mem;
+    }
+    block = next;
+  }
+}
+
+void SlicePool::ownerExited() {
+  for (uint8_t* mem : free_blocks_) {
+    delete[] mem;
+  }
+  free_blocks_.clear();
+  reclaimRemoteFrees();
+  for (uint8_t* mem : free_blocks_) {
+    delete[] mem;
+  }
+  free_blocks_.clear();
+
+  {
+    SlicePoolRegistry& r = registry();
+    absl::MutexLock lock(&r.mutex_);
+    const SlicePoolStats stats = localStats();
+    r.retired_.hits_ += stats.hits_;
+    r.retired_.misses_ += stats.misses_;
+    r.retired_.cross_thread_frees_ += stats.cross_thread_frees_;
+    r.pools_.erase(this);
+  }
+  unref();
+}
+
+void SlicePool::unref() {
+  if (refs_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    destroy();
+  }
+}
+
+void SlicePool::destroy() {
+  // The owning thread is gone and all blocks have been returned, but blocks released after the
+  // owner exited are still on the remote stack.
+  FreeBlock* block = remote_free_blocks_.exchange(nullptr, std::memory_order_acquire);
+  while (block != nullptr) {
+    FreeBlock* next = block->next_;
+    delete[] reinterpret_cast<uint8_t*>(block);
+    block = next;
+  }
+  ASSERT(free_blocks_.empty());
+  delete this;
+}
+
+SlicePoolStats SlicePool::localStats() const {
+  return {hits_.load(std::memory_order_relaxed), misses_.load(std::memory_order_relaxed),
+          cross_thread_frees_.load(std::memory_order_relaxed)};
+}
+
+SlicePoolStats SlicePool::stats() {
+  SlicePoolRegistry& r = registry();
+  absl::MutexLock lock(&r.mutex_);
+  SlicePoolStats total = r.retired_;
+  for (const SlicePool* pool : r.pools_) {
+    const SlicePoolStats stats = pool->localStats();
+    total.hits_ += stats.hits_;
+    total.misses_ += stats.misses_;
+    total.cross_thread_frees_ += stats.cross_thread_frees_;
+  }
+  return total;
+}
+
+} // namespace Buffer
+} // namespace Envoy
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "source/common/common/non_copyable.h"
+
+namespace Envoy {
+namespace Buffer {
+
+class SlicePool;
+
+/**
+ * Deleter for the backing storage of a Slice. Storage handed out by a SlicePool is returned to the
+ * pool of the thread that allocated it, all other storage is released to the heap.
+ */
+struct SliceStorageDeleter {
+  void operator()(uint8_t* mem) const;
+
+  SlicePool* pool_{nullptr};
+};
+
+using SliceStoragePtr = std::unique_ptr<uint8_t[], SliceStorageDeleter>;
+
+/**
+ * Process wide totals of the slice pool activity, summed across all threads.
+ */
+struct SlicePoolStats {
+  // Allocations served from a free list.
+  uint64_t hits_{};
+  // Allocations which had to go to the heap.
+  uint64_t misses_{};
+  // Blocks released on a thread other than the one which allocated them.
+  uint64_t cross_thread_frees_{};
+};
+
+/**
+ * Per-thread pool of default sized slice blocks. Each thread (in practice each worker, since
+ * workers do the bulk of the buffer allocations) owns a free list of blocks that is accessed
+ * without synchronization. Blocks freed by other threads are pushed onto a lock-free stack of the
+ * owning pool, and are reclaimed by the owner the next time its free list runs dry. This keeps the
+ * blocks local to the thread (and hence NUMA node) which first touched them, and avoids
+ * cross-core frees through the allocator's transfer caches.
+ *
+ * A pool is reference counted by its owning thread and by every block it has handed out, so it
+ * outlives its thread until the last outstanding block is released.
+ */
+class SlicePool : NonCopyable {
+public:
+  // Must match Slice::default_slice_size_.
+  static constexpr uint64_t BlockSize = 16384;
+  // Maximum number of free blocks cached per thread, i.e. 4MiB per thread.
+  static constexpr uint32_t MaxCachedBlocks = 256;
+
+  /**
+   * Enable or disable the pool for the whole process. This should be set once during startup
+   * before workers are created. Blocks allocated while the pool was enabled are still returned to
+   * their pool after it is disabled.
+   */
+  static void setEnabled(bool enabled) { enabled_.store(enabled, std::memory_order_relaxed); }
+  static bool enabled() { return enabled_.load(std::memory_order_relaxed); }
+
+  /**
+   * @return a block of BlockSize bytes from the calling thread's pool.
+   */
+  static SliceStoragePtr allocate();
+
+  /**
+   * @return the activity of all pools, including the ones of threads which have exited.
+   */
+  static SlicePoolStats stats();
+
+  /**
+   * Return a block to this pool. Called by SliceStorageDeleter.
+   */
+  void release(uint8_t* mem);
+
+private:
+  friend class ThreadLocalSlicePool;
+
+  struct FreeBlock {
+    FreeBlock* next_;
+  };
+
+  SlicePool();
+  ~SlicePool() = default;
+
+  uint8_t* allocateBlock();
+  void reclaimRemoteFrees();
+  void ownerExited();
+  void unref();
+  void destroy();
+  SlicePoolStats localStats() const;
+
+  static std::atomic<bool> enabled_;
+
+  // Only accessed by the owning thread.
+  std::vector<uint8_t*> free_blocks_;
+  // Written by the owning thread only, read by stats().
+  std::atomic<uint64_t> hits_{0};
+  std::atomic<uint64_t> misses_{0};
+
+  // Accessed by other threads, so kept off the cache line of the owner-only fields.
+  alignas(64) std::atomic<FreeBlock*> remote_free_blocks_{nullptr};
+  std::atomic<uint64_t> cross_thread_frees_{0};
+  // One reference for the owning thread plus one per outstanding block.
+  std::atomic<uint64_t> refs_{1};
+};
+
+} // namespace Buffer
+} // namespace Envoy
@@ -1,5 +1,7 @@
 #include "source/common/conn_pool/conn_pool_base.h"
 
+#include <cmath>
+
 #include "source/common/common/assert.h"
 #include "source/common/common/debug_recursion_checker.h"
 #include "source/common/network/transport_socket_options_impl.h"
@@ -26,7 +28,13 @@ ConnPoolImplBase::ConnPoolImplBase(
     Upstream::ClusterConnectivityState& state)
     : state_(state), host_(host), priority_(priority), dispatcher_(dispatcher),
       socket_options_(options), transport_socket_options_(transport_socket_options),
-      upstream_ready_cb_(dispatcher_.createSchedulableCallback([this]() { onUpstreamReady(); })) {}
+      upstream_ready_cb_(dispatcher_.createSchedulableCallback([this]() { onUpstreamReady(); })) {
+  const absl::optional<Upstream::AdaptivePreconnectConfig>& adaptive_preconnect =
+      host_->cluster().adaptivePreconnect();
+  if (adaptive_preconnect.has_value()) {
+    adaptive_preconnect_ = std::make_unique<AdaptivePreconnectEstimator>(*adaptive_preconnect);
+  }
+}
 
 ConnPoolImplBase::~ConnPoolImplBase() {
   ASSERT(isIdleImpl());
@@ -50,9 +58,49 @@ void ConnPoolImplBase::destructAllConnections() {
   dispatcher_.clearDeferredDeleteList();
 }
 
+AdaptivePreconnectEstimator::AdaptivePreconnectEstimator(
+    const Upstream::AdaptivePreconnectConfig& config)
+    : averaging_window_seconds_(
+          std::chrono::duration<double>(config.averaging_window_).count()),
+      max_anticipated_streams_(config.max_anticipated_streams_) {
+  ASSERT(averaging_window_seconds_ > 0);
+}
+
+void AdaptivePreconnectEstimator::onStreamArrival(MonotonicTime now) {
+  // Each arrival adds 1/window to a rate which decays with time constant window, so a steady
+  // stream of arrivals converges on its actual rate.
+  stream_rate_ = streamRate(now) + 1 / averaging_window_seconds_;
+  last_arrival_ = now;
+}
+
+void AdaptivePreconnectEstimator::onConnectLatency(std::chrono::milliseconds latency) {
+  const double sample = std::chrono::duration<double>(latency).count();
+  connect_latency_seconds_ =
+      connect_latency_seconds_.has_value()
+          ? ConnectLatencyWeight * sample + (1 - ConnectLatencyWeight) * *connect_latency_seconds_
+          : sample;
+}
+
+double AdaptivePreconnectEstimator::streamRate(MonotonicTime now) const {
+  if (!last_arrival_.has_value() || now <= *last_arrival_) {
+    return stream_rate_;
+  }
+  const double elapsed = std::chrono::duration<double>(now - *last_arrival_).count();
+  return stream_rate_ * std::exp(-elapsed / averaging_window_seconds_);
+}
+
+uint32_t AdaptivePreconnectEstimator::anticipatedStreams(MonotonicTime now) const {
+  if (!connect_latency_seconds_.has_value()) {
+    return 0;
+  }
+  const double anticipated = std::round(streamRate(now) * *connect_latency_seconds_);
+  return static_cast<uint32_t>(std::min<double>(anticipated, max_anticipated_streams_));
+}
+
 bool ConnPoolImplBase::shouldConnect(size_t pending_streams, size_t active_streams,
                                      int64_t connecting_and_connected_capacity,
-                                     float preconnect_ratio, bool anticipate_incoming_stream) {
+                                     float preconnect_ratio, bool anticipate_incoming_stream,
+                                     uint32_t predicted_streams, int64_t ready_capacity) {
   // This is set to true any time global preconnect is being calculated.
   // ClusterManagerImpl::maybePreconnect is called directly before a stream is created, so the
   // stream must be anticipated.
@@ -68,8 +116,14 @@ bool ConnPoolImplBase::shouldConnect(size_t pending_streams, size_t active_strea
   //
   // If preconnect ratio is not set, it defaults to 1, and this simplifies to the
   // legacy value of pending_streams_.size() > connecting_stream_capacity_
-  return (pending_streams + active_streams + anticipated_streams) * preconnect_ratio >
-         connecting_and_connected_capacity + active_streams;
+  //
+  // Adaptive preconnect also provisions for the streams predicted to arrive
+  // while a connection is being established. The idle capacity of the connected
+  // clients can serve these as well.
+  const size_t demand = pending_streams + active_streams + anticipated_streams;
+  const int64_t provisioned = connecting_and_connected_capacity + active_streams;
+  return demand * preconnect_ratio > provisioned ||
+         static_cast<int64_t>(demand + predicted_streams) > provisioned + ready_capacity;
 }
 
 bool ConnPoolImplBase::shouldCreateNewConnection(float global_preconnect_ratio) const {
@@ -97,8 +151,10 @@ bool ConnPoolImplBase::shouldCreateNewConnection(float global_preconnect_ratio)
     // Local preconnect does not need to anticipate a stream. It is called as
     // new streams are established or torn down and simply attempts to maintain
     // the correct ratio of streams and anticipated capacity.
+    const uint32_t predicted_streams = adaptivePreconnectStreams();
     return shouldConnect(pending_streams_.size(), num_active_streams_, connecting_stream_capacity_,
-                         perUpstreamPreconnectRatio());
+                         perUpstreamPreconnectRatio(), false, predicted_streams,
+                         predicted_streams > 0 ? readyStreamCapacity() : 0);
   }
 }
 
@@ -106,6 +162,25 @@ float ConnPoolImplBase::perUpstreamPreconnectRatio() const {
   return host_->cluster().perUpstreamPreconnectRatio();
 }
 
+uint32_t ConnPoolImplBase::adaptivePreconnectStreams() const {
+  if (adaptive_preconnect_ == nullptr) {
+    return 0;
+  }
+  if (state_.adaptive_preconnect_load_shed_point_ != nullptr &&
+      state_.adaptive_preconnect_load_shed_point_->shouldShedLoad()) {
+    return 0;
+  }
+  return adaptive_preconnect_->anticipatedStreams(dispatcher_.timeSource().monotonicTime());
+}
+
+int64_t ConnPoolImplBase::readyStreamCapacity() const {
+  int64_t capacity = 0;
+  for (const auto& client : ready_clients_) {
+    capacity += client->currentUnusedCapacity();
+  }
+  return capacity;
+}
+
 ConnPoolImplBase::ConnectionResult ConnPoolImplBase::tryCreateNewConnections() {
   ConnPoolImplBase::ConnectionResult result;
   // Somewhat arbitrarily cap the number of connections preconnected due to new
@@ -257,6 +332,10 @@ ConnectionPool::Cancellable* ConnPoolImplBase::newStreamImpl(AttachContext& cont
   ASSERT(!is_draining_for_deletion_);
   ASSERT(!deferred_deleting_);
 
+  if (adaptive_preconnect_ != nullptr) {
+    adaptive_preconnect_->onStreamArrival(dispatcher_.timeSource().monotonicTime());
+  }
+
   ASSERT(static_cast<ssize_t>(connecting_stream_capacity_) ==
          connectingCapacity(connecting_clients_) +
              connectingCapacity(early_data_clients_)); // O(n) debug check.
@@ -575,6 +654,9 @@ void ConnPoolImplBase::onConnectionEvent(ActiveClient& client, absl::string_view
     ASSERT(connecting_stream_capacity_ >= client.currentUnusedCapacity());
     connecting_stream_capacity_ -= client.currentUnusedCapacity();
     client.has_handshake_completed_ = true;
+    if (adaptive_preconnect_ != nullptr) {
+      adaptive_preconnect_->onConnectLatency(client.conn_connect_ms_->elapsed());
+    }
     client.conn_connect_ms_->complete();
     client.conn_connect_ms_.reset();
     if (client.state() == ActiveClient::State::Connecting ||
@@ -660,8 +742,18 @@ bool ConnPoolImplBase::connectingConnectionIsExcess(const ActiveClient& client)
   // If preconnect ratio is set, it also factors in the anticipated load based on both queued
   // streams and active streams, and makes sure the connecting capacity would still be sufficient to
   // serve that even with the most recent client removed.
-  return (pending_streams_.size() + num_active_streams_) * perUpstreamPreconnectRatio() <=
-         (connecting_stream_capacity_ - client.currentUnusedCapacity() + num_active_streams_);
+  //
+  // With adaptive preconnect, capacity for the predicted stream arrivals is not excess either,
+  // unless the idle capacity of the ready clients covers them.
+  const size_t demand = pending_streams_.size() + num_active_streams_;
+  const int64_t provisioned =
+      connecting_stream_capacity_ - client.currentUnusedCapacity() + num_active_streams_;
+  if (demand * perUpstreamPreconnectRatio() > provisioned) {
+    return false;
+  }
+  const uint32_t predicted_streams = adaptivePreconnectStreams();
+  return predicted_streams == 0 || static_cast<int64_t>(demand + predicted_streams) <=
+                                       provisioned + readyStreamCapacity();
 }
 
 void ConnPoolImplBase::onPendingStreamCancel(PendingStream& stream,
@@ -11,6 +11,7 @@
 #include "source/common/common/linked_object.h"
 
 #include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
 #include "fmt/ostream.h"
 
 namespace Envoy {
@@ -182,6 +183,37 @@ using PendingStreamPtr = std::unique_ptr<PendingStream>;
 
 using ActiveClientPtr = std::unique_ptr<ActiveClient>;
 
+// Predicts how many streams will arrive at a connection pool while a new connection is being
+// established, from exponentially weighted moving averages of the stream arrival rate and of the
+// connection setup latency.
+class AdaptivePreconnectEstimator {
+public:
+  explicit AdaptivePreconnectEstimator(const Upstream::AdaptivePreconnectConfig& config);
+
+  // Records a stream arriving at the pool.
+  void onStreamArrival(MonotonicTime now);
+  // Records the time it took a connection of the pool to connect.
+  void onConnectLatency(std::chrono::milliseconds latency);
+
+  // Returns the average stream arrival rate in streams per second, decayed to now.
+  double streamRate(MonotonicTime now) const;
+  // Returns the number of streams expected to arrive within one connection setup latency, rounded
+  // and capped at the configured maximum. Returns 0 until a connection setup latency has been
+  // recorded.
+  uint32_t anticipatedStreams(MonotonicTime now) const;
+
+private:
+  // The weight of a new connection setup latency sample in its moving average.
+  static constexpr double ConnectLatencyWeight = 0.25;
+
+  const double averaging_window_seconds_;
+  const uint32_t max_anticipated_streams_;
+  // The stream arrival rate as of last_arrival_.
+  double stream_rate_{};
+  absl::optional<MonotonicTime> last_arrival_;
+  absl::optional<double> connect_latency_seconds_;
+};
+
 // Base class that handles stream queueing logic shared between connection pool implementations.
 class ConnPoolImplBase : protected Logger::Loggable<Logger::Id::pool> {
 public:
@@ -210,9 +242,14 @@ public:
   //
   // If anticipate_incoming_stream is true this assumes a call to newStream is
   // pending, which is true for global preconnect.
+  //
+  // predicted_streams is the number of streams adaptive preconnect expects to
+  // arrive before a new connection could be established. ready_capacity is the
+  // unused capacity of the connected clients, which can serve them as well.
   static bool shouldConnect(size_t pending_streams, size_t active_streams,
                             int64_t connecting_and_connected_capacity, float preconnect_ratio,
-                            bool anticipate_incoming_stream = false);
+                            bool anticipate_incoming_stream = false,
+                            uint32_t predicted_streams = 0, int64_t ready_capacity = 0);
 
   // Envoy::ConnectionPool::Instance implementation helpers
   void addIdleCallbackImpl(Instance::IdleCb cb);
@@ -345,6 +382,13 @@ protected:
 
   float perUpstreamPreconnectRatio() const;
 
+  // Returns the number of streams adaptive preconnect provisions for beyond the pending and
+  // active ones, or 0 if adaptive preconnect is disabled or shed by the overload manager.
+  uint32_t adaptivePreconnectStreams() const;
+
+  // Returns the unused stream capacity of the ready clients.
+  int64_t readyStreamCapacity() const;
+
   ConnectionPool::Cancellable*
   addPendingStream(Envoy::ConnectionPool::PendingStreamPtr&& pending_stream) {
     LinkedList::moveIntoList(std::move(pending_stream), pending_streams_);
@@ -408,6 +452,9 @@ private:
   // True iff this object is in the deferred delete list.
   bool deferred_deleting_{false};
 
+  // Set if the cluster has adaptive preconnect configured.
+  std::unique_ptr<AdaptivePreconnectEstimator> adaptive_preconnect_;
+
   Event::SchedulableCallbackPtr upstream_ready_cb_;
   Common::DebugRecursionChecker recursion_checker_;
 };
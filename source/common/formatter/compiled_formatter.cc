@@ -0,0 +1,90 @@
+#include "source/common/formatter/compiled_formatter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+#include "source/common/common/fmt.h"
+
+namespace Envoy {
+namespace Formatter {
+namespace {
+
+// Log lines longer than this don't raise the size reserved for the following ones.
+constexpr size_t MaxReservedSize = 64 * 1024;
+
+// The size of the last log line formatted on this thread.
+thread_local size_t last_size = 0;
+
+} // namespace
+
+std::string CompiledFormatterUtil::formatReserved(absl::FunctionRef<void(std::string&)> fill) {
+  std::string output;
+  output.reserve(last_size);
+  fill(output);
+  last_size = std::min(output.size(), MaxReservedSize);
+  return output;
+}
+
+void CompiledFormatterUtil::appendJsonNumber(std::string& output, double number) {
+  if (!std::isfinite(number)) {
+    output.append("null");
+    return;
+  }
+  // Same representation as Buffer::Util::serializeDouble(), written in place.
+  fmt::format_to(std::back_inserter(output), "{}", number);
+}
+
+void CompiledFormatterUtil::appendJsonValue(std::string& output, const ProtobufWkt::Value& value) {
+  switch (value.kind_case()) {
+  case ProtobufWkt::Value::kNumberValue:
+    appendJsonNumber(output, value.number_value());
+    break;
+  case ProtobufWkt::Value::kStringValue:
+    appendJsonString(output, value.string_value());
+    break;
+  case ProtobufWkt::Value::kBoolValue:
+    output.append(value.bool_value() ? "true" : "false");
+    break;
+  case ProtobufWkt::Value::kStructValue: {
+    const auto& fields = value.struct_value().fields();
+    std::vector<absl::string_view> keys;
+    keys.reserve(fields.size());
+    for (const auto& pair : fields) {
+      keys.push_back(pair.first);
+    }
+    std::sort(keys.begin(), keys.end());
+    output.push_back('{');
+    for (size_t i = 0; i < keys.size(); ++i) {
+      if (i > 0) {
+        output.push_back(',');
+      }
+      appendJsonString(output, keys[i]);
+      output.push_back(':');
+      appendJsonValue(output, fields.at(std::string(keys[i])));
+    }
+    output.push_back('}');
+    break;
+  }
+  case ProtobufWkt::Value::kListValue: {
+    output.push_back('[');
+    bool first = true;
+    for (const auto& element : value.list_value().values()) {
+      if (!first) {
+        output.push_back(',');
+      }
+      first = false;
+      appendJsonValue(output, element);
+    }
+    output.push_back(']');
+    break;
+  }
+  case ProtobufWkt::Value::kNullValue:
+  case ProtobufWkt::Value::KIND_NOT_SET:
+    output.append("null");
+    break;
+  }
+}
+
+} // namespace Formatter
+} // namespace Envoy
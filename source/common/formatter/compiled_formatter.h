@@ -0,0 +1,362 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "envoy/formatter/substitution_formatter.h"
+
+#include "source/common/formatter/substitution_formatter.h"
+#include "source/common/json/json_sanitizer.h"
+
+#include "absl/container/inlined_vector.h"
+#include "absl/functional/function_ref.h"
+
+namespace Envoy {
+namespace Formatter {
+
+/**
+ * Helpers shared by the compiled formatters.
+ */
+class CompiledFormatterUtil {
+public:
+  /**
+   * Runs fill on a string which has the size of the previous log line of this thread reserved, so
+   * that it is usually allocated once, and returns it.
+   */
+  static std::string formatReserved(absl::FunctionRef<void(std::string&)> fill);
+
+  /**
+   * Appends a number the way it is rendered in JSON. Non-finite numbers, which JSON can't
+   * represent, are rendered as null.
+   */
+  static void appendJsonNumber(std::string& output, double number);
+
+  /**
+   * Appends a string surrounded by double-quotes and escaped for JSON.
+   */
+  static void appendJsonString(std::string& output, absl::string_view str) {
+    output.push_back('"');
+    Json::appendEscaped(output, str);
+    output.push_back('"');
+  }
+
+  /**
+   * Appends the JSON representation of a value. The fields of a struct are rendered in the order of
+   * their keys.
+   */
+  static void appendJsonValue(std::string& output, const ProtobufWkt::Value& value);
+};
+
+/**
+ * Text formatter which produces the same output as FormatterBaseImpl. The format string is compiled
+ * into a tape of literals and commands at configuration time. Literals are appended directly
+ * rather than being copied out of a provider, and the log line is built directly in the returned
+ * string, so that the only allocations per log line are the ones made by the commands and the
+ * returned string.
+ */
+template <class FormatterContext>
+class CompiledFormatterBase : public FormatterBase<FormatterContext> {
+public:
+  using CommandParsers = std::vector<CommandParserBasePtr<FormatterContext>>;
+
+  CompiledFormatterBase(absl::string_view format, bool omit_empty_values,
+                        const CommandParsers& command_parsers = {})
+      : empty_value_string_(omit_empty_values ? absl::string_view{}
+                                              : DefaultUnspecifiedValueStringView) {
+    for (auto& provider :
+         SubstitutionFormatParser::parse<FormatterContext>(format, command_parsers)) {
+      const auto* plain =
+          dynamic_cast<const PlainStringFormatterBase<FormatterContext>*>(provider.get());
+      if (plain != nullptr) {
+        tape_.push_back({std::string(plain->value()), nullptr});
+      } else {
+        tape_.push_back({std::string(), std::move(provider)});
+      }
+    }
+  }
+
+  /**
+   * Appends the formatted log line to output.
+   */
+  void formatInto(const FormatterContext& context, const StreamInfo::StreamInfo& stream_info,
+                  std::string& output) const {
+    for (const Instruction& instruction : tape_) {
+      if (instruction.provider_ == nullptr) {
+        output.append(instruction.literal_);
+        continue;
+      }
+      const absl::optional<std::string> bit =
+          instruction.provider_->formatWithContext(context, stream_info);
+      output.append(bit.has_value() ? absl::string_view(*bit) : empty_value_string_);
+    }
+  }
+
+  // FormatterBase
+  std::string formatWithContext(const FormatterContext& context,
+                                const StreamInfo::StreamInfo& stream_info) const override {
+    return CompiledFormatterUtil::formatReserved(
+        [&](std::string& output) { formatInto(context, stream_info, output); });
+  }
+
+private:
+  struct Instruction {
+    // Appended as it is if provider_ is null.
+    std::string literal_;
+    FormatterProviderBasePtr<FormatterContext> provider_;
+  };
+
+  const std::string empty_value_string_;
+  std::vector<Instruction> tape_;
+};
+
+/**
+ * JSON formatter which produces the same document as JsonFormatterBaseImpl, with the properties
+ * sorted, without building a ProtobufWkt::Struct and serializing it for every log line.
+ *
+ * The format is compiled into a flat tape at configuration time: the keys, punctuation and
+ * constant values are pre-rendered and pre-escaped, so formatting a log line is a single pass over
+ * the tape which writes the JSON text straight into the returned string. Values are only
+ * escaped if they contain characters which need it, see Json::appendEscaped().
+ *
+ * Properties whose values are empty are omitted, if configured to, by rewinding the output to the
+ * start of the property, and a nested map whose properties were all omitted is omitted itself.
+ */
+template <class FormatterContext>
+class CompiledJsonFormatterBase : public FormatterBase<FormatterContext> {
+public:
+  using CommandParsers = std::vector<CommandParserBasePtr<FormatterContext>>;
+
+  CompiledJsonFormatterBase(const ProtobufWkt::Struct& format_mapping, bool preserve_types,
+                            bool omit_empty_values, const CommandParsers& commands = {})
+      : omit_empty_values_(omit_empty_values), preserve_types_(preserve_types),
+        empty_value_(omit_empty_values ? std::string()
+                                       : std::string(DefaultUnspecifiedValueStringView)) {
+    compileMap(format_mapping, commands);
+  }
+
+  /**
+   * Appends the formatted log line, including the trailing new line, to output.
+   */
+  void formatInto(const FormatterContext& context, const StreamInfo::StreamInfo& stream_info,
+                  std::string& output) const {
+    absl::InlinedVector<Frame, 8> frames;
+    for (const Instruction& instruction : tape_) {
+      switch (instruction.op_) {
+      case OpCode::OpenMap:
+      case OpCode::OpenList:
+        output.append(instruction.literal_);
+        frames.push_back({output.size(), true});
+        break;
+      case OpCode::CloseMap:
+      case OpCode::CloseList: {
+        const bool empty = frames.back().empty_;
+        frames.pop_back();
+        output.append(instruction.literal_);
+        if (!frames.empty()) {
+          endEntry(frames.back(), output,
+                   omit_empty_values_ && empty && instruction.op_ == OpCode::CloseMap);
+        }
+        break;
+      }
+      case OpCode::Entry: {
+        Frame& frame = frames.back();
+        frame.entry_start_ = output.size();
+        if (!frame.empty_) {
+          output.push_back(',');
+        }
+        output.append(instruction.literal_);
+        break;
+      }
+      case OpCode::Constant:
+        output.append(instruction.literal_);
+        endEntry(frames.back(), output, false);
+        break;
+      case OpCode::Value:
+        endEntry(frames.back(), output,
+                 !appendValue(instruction.segments_, context, stream_info, output) &&
+                     omit_empty_values_);
+        break;
+      }
+    }
+    output.push_back('\n');
+  }
+
+  // FormatterBase
+  std::string formatWithContext(const FormatterContext& context,
+                                const StreamInfo::StreamInfo& stream_info) const override {
+    return CompiledFormatterUtil::formatReserved(
+        [&](std::string& output) { formatInto(context, stream_info, output); });
+  }
+
+private:
+  enum class OpCode : uint8_t {
+    OpenMap,
+    CloseMap,
+    OpenList,
+    CloseList,
+    // Starts an entry of the enclosing map or list. The literal is the escaped key of a map entry.
+    Entry,
+    // The literal is the JSON value of the entry.
+    Constant,
+    // The value of the entry is formatted by the providers.
+    Value,
+  };
+
+  // A part of a value: a pre-escaped literal if provider_ is null, else a command.
+  struct Segment {
+    std::string literal_;
+    FormatterProviderBasePtr<FormatterContext> provider_;
+  };
+
+  struct Instruction {
+    OpCode op_;
+    std::string literal_;
+    std::vector<Segment> segments_;
+  };
+
+  // The state of an open map or list while formatting.
+  struct Frame {
+    size_t entry_start_;
+    bool empty_;
+  };
+
+  void addInstruction(OpCode op, std::string literal) {
+    tape_.push_back({op, std::move(literal), {}});
+  }
+
+  void compileMap(const ProtobufWkt::Struct& struct_format, const CommandParsers& commands) {
+    addInstruction(OpCode::OpenMap, "{");
+    // The properties are sorted, as they are by StructFormatterBase.
+    std::map<std::string, const ProtobufWkt::Value*> fields;
+    for (const auto& pair : struct_format.fields()) {
+      fields.emplace(pair.first, &pair.second);
+    }
+    for (const auto& [key, value] : fields) {
+      std::string literal;
+      CompiledFormatterUtil::appendJsonString(literal, key);
+      literal.push_back(':');
+      addInstruction(OpCode::Entry, std::move(literal));
+      compileValue(*value, commands);
+    }
+    addInstruction(OpCode::CloseMap, "}");
+  }
+
+  void compileList(const ProtobufWkt::ListValue& list_format, const CommandParsers& commands) {
+    addInstruction(OpCode::OpenList, "[");
+    for (const auto& value : list_format.values()) {
+      addInstruction(OpCode::Entry, "");
+      compileValue(value, commands);
+    }
+    addInstruction(OpCode::CloseList, "]");
+  }
+
+  void compileValue(const ProtobufWkt::Value& value, const CommandParsers& commands) {
+    switch (value.kind_case()) {
+    case ProtobufWkt::Value::kStringValue:
+      compileString(value.string_value(), commands);
+      break;
+    case ProtobufWkt::Value::kStructValue:
+      compileMap(value.struct_value(), commands);
+      break;
+    case ProtobufWkt::Value::kListValue:
+      compileList(value.list_value(), commands);
+      break;
+    case ProtobufWkt::Value::kNumberValue: {
+      std::string literal;
+      if (preserve_types_) {
+        CompiledFormatterUtil::appendJsonNumber(literal, value.number_value());
+      } else {
+        CompiledFormatterUtil::appendJsonString(literal,
+                                                absl::StrFormat("%g", value.number_value()));
+      }
+      addInstruction(OpCode::Constant, std::move(literal));
+      break;
+    }
+    default:
+      throwEnvoyExceptionOrPanic(
+          "Only string values, nested structs, list values and number values are "
+          "supported in structured access log format.");
+    }
+  }
+
+  void compileString(const std::string& string_format, const CommandParsers& commands) {
+    std::vector<Segment> segments;
+    for (auto& provider :
+         SubstitutionFormatParser::parse<FormatterContext>(string_format, commands)) {
+      const auto* plain =
+          dynamic_cast<const PlainStringFormatterBase<FormatterContext>*>(provider.get());
+      if (plain != nullptr) {
+        std::string literal;
+        Json::appendEscaped(literal, plain->value());
+        segments.push_back({std::move(literal), nullptr});
+      } else {
+        segments.push_back({std::string(), std::move(provider)});
+      }
+    }
+    if (segments.size() == 1 && segments.front().provider_ == nullptr) {
+      // A plain string is always rendered as a string, whether types are preserved or not.
+      addInstruction(OpCode::Constant, absl::StrCat("\"", segments.front().literal_, "\""));
+      return;
+    }
+    tape_.push_back({OpCode::Value, std::string(), std::move(segments)});
+  }
+
+  // Appends the value formatted by the providers, or nothing if it is null and empty values are
+  // omitted. Returns false if the value is null.
+  bool appendValue(const std::vector<Segment>& segments, const FormatterContext& context,
+                   const StreamInfo::StreamInfo& stream_info, std::string& output) const {
+    if (segments.size() == 1) {
+      const auto& provider = segments.front().provider_;
+      if (preserve_types_) {
+        const ProtobufWkt::Value value = provider->formatValueWithContext(context, stream_info);
+        const bool null = value.kind_case() == ProtobufWkt::Value::kNullValue ||
+                          value.kind_case() == ProtobufWkt::Value::KIND_NOT_SET;
+        if (!null || !omit_empty_values_) {
+          CompiledFormatterUtil::appendJsonValue(output, value);
+        }
+        return !null;
+      }
+      const absl::optional<std::string> str = provider->formatWithContext(context, stream_info);
+      if (!str.has_value() && omit_empty_values_) {
+        return false;
+      }
+      CompiledFormatterUtil::appendJsonString(output, str.has_value() ? *str : empty_value_);
+      return true;
+    }
+
+    // Multiple providers force string output.
+    output.push_back('"');
+    for (const Segment& segment : segments) {
+      if (segment.provider_ == nullptr) {
+        output.append(segment.literal_);
+        continue;
+      }
+      const absl::optional<std::string> bit =
+          segment.provider_->formatWithContext(context, stream_info);
+      Json::appendEscaped(output, bit.has_value() ? absl::string_view(*bit) : empty_value_);
+    }
+    output.push_back('"');
+    return true;
+  }
+
+  // Ends the current entry of frame. An omitted entry is removed from the output.
+  static void endEntry(Frame& frame, std::string& output, bool omit) {
+    if (omit) {
+      output.resize(frame.entry_start_);
+    } else {
+      frame.empty_ = false;
+    }
+  }
+
+  const bool omit_empty_values_;
+  const bool preserve_types_;
+  const std::string empty_value_;
+  std::vector<Instruction> tape_;
+};
+
+using CompiledFormatterImpl = CompiledFormatterBase<HttpFormatterContext>;
+using CompiledJsonFormatterImpl = CompiledJsonFormatterBase<HttpFormatterContext>;
+
+} // namespace Formatter
+} // namespace Envoy
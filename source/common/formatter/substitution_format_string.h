@@ -9,9 +9,11 @@
 
 #include "source/common/config/datasource.h"
 #include "source/common/config/utility.h"
+#include "source/common/formatter/compiled_formatter.h"
 #include "source/common/formatter/substitution_formatter.h"
 #include "source/common/protobuf/message_validator_impl.h"
 #include "source/common/protobuf/protobuf.h"
+#include "source/common/runtime/runtime_features.h"
 #include "source/server/generic_factory_context.h"
 
 namespace Envoy {
@@ -63,15 +65,15 @@ public:
     auto commands = parseFormatters<FormatterContext>(config.formatters(), context);
     switch (config.format_case()) {
     case envoy::config::core::v3::SubstitutionFormatString::FormatCase::kTextFormat:
-      return std::make_unique<FormatterBaseImpl<FormatterContext>>(
-          config.text_format(), config.omit_empty_values(), commands);
+      return createTextFormatter<FormatterContext>(config.text_format(),
+                                                   config.omit_empty_values(), commands);
     case envoy::config::core::v3::SubstitutionFormatString::FormatCase::kJsonFormat:
       return createJsonFormatter<FormatterContext>(
           config.json_format(), true, config.omit_empty_values(),
           config.has_json_format_options() ? config.json_format_options().sort_properties() : false,
           commands);
     case envoy::config::core::v3::SubstitutionFormatString::FormatCase::kTextFormatSource:
-      return std::make_unique<FormatterBaseImpl<FormatterContext>>(
+      return createTextFormatter<FormatterContext>(
           THROW_OR_RETURN_VALUE(Config::DataSource::read(config.text_format_source(), true,
                                                          context.serverFactoryContext().api()),
                                 std::string),
@@ -91,9 +93,31 @@ public:
   createJsonFormatter(const ProtobufWkt::Struct& struct_format, bool preserve_types,
                       bool omit_empty_values, bool sort_properties,
                       const std::vector<CommandParserBasePtr<FormatterContext>>& commands = {}) {
+    // The compiled formatter always sorts the properties, so it only replaces the sorted
+    // serialization.
+    if (sort_properties &&
+        Runtime::runtimeFeatureEnabled("envoy.reloadable_features.compiled_access_log_formatter")) {
+      return std::make_unique<CompiledJsonFormatterBase<FormatterContext>>(
+          struct_format, preserve_types, omit_empty_values, commands);
+    }
     return std::make_unique<JsonFormatterBaseImpl<FormatterContext>>(
         struct_format, preserve_types, omit_empty_values, sort_properties, commands);
   }
+
+  /**
+   * Generate a text formatter object from a format string.
+   */
+  template <class FormatterContext = HttpFormatterContext>
+  static FormatterBasePtr<FormatterContext>
+  createTextFormatter(absl::string_view format, bool omit_empty_values,
+                      const std::vector<CommandParserBasePtr<FormatterContext>>& commands = {}) {
+    if (Runtime::runtimeFeatureEnabled("envoy.reloadable_features.compiled_access_log_formatter")) {
+      return std::make_unique<CompiledFormatterBase<FormatterContext>>(format, omit_empty_values,
+                                                                       commands);
+    }
+    return std::make_unique<FormatterBaseImpl<FormatterContext>>(format, omit_empty_values,
+                                                                 commands);
+  }
 };
 
 } // namespace Formatter
@@ -31,6 +31,8 @@ class PlainStringFormatterBase : public FormatterProviderBase<FormatterContext>
 public:
   PlainStringFormatterBase(absl::string_view str) { str_.set_string_value(str); }
 
+  absl::string_view value() const { return str_.string_value(); }
+
   // FormatterProviderBase
   absl::optional<std::string> formatWithContext(const FormatterContext&,
                                                 const StreamInfo::StreamInfo&) const override {
@@ -22,6 +22,7 @@
 #include "source/common/http/headers.h"
 #include "source/common/http/http1/balsa_parser.h"
 #include "source/common/http/http1/header_formatter.h"
+#include "source/common/http/http1/header_scanner.h"
 #include "source/common/http/http1/legacy_parser_impl.h"
 #include "source/common/http/utility.h"
 #include "source/common/network/common_connection_filter_states.h"
@@ -529,8 +530,10 @@ ConnectionImpl::ConnectionImpl(Network::Connection& connection, CodecStats& stat
     : connection_(connection), stats_(stats), codec_settings_(settings),
       encode_only_header_key_formatter_(encodeOnlyFormatterFromSettings(settings)),
       processing_trailers_(false), handling_upgrade_(false), reset_stream_called_(false),
-      deferred_end_stream_headers_(false), dispatching_(false), max_headers_kb_(max_headers_kb),
-      max_headers_count_(max_headers_count) {
+      deferred_end_stream_headers_(false), dispatching_(false),
+      vectorized_header_validation_(Runtime::runtimeFeatureEnabled(
+          "envoy.reloadable_features.http1_vectorized_header_validation")),
+      max_headers_kb_(max_headers_kb), max_headers_count_(max_headers_count) {
   if (codec_settings_.use_balsa_parser_) {
     parser_ = std::make_unique<BalsaParser>(type, this, max_headers_kb_ * 1024, enableTrailers(),
                                             codec_settings_.allow_custom_methods_);
@@ -813,7 +816,10 @@ Status ConnectionImpl::onHeaderValueImpl(const char* data, size_t length) {
   }
 
   absl::string_view header_value{data, length};
-  if (!Http::HeaderUtility::headerValueIsValid(header_value)) {
+  const bool valid_header_value = vectorized_header_validation_
+                                      ? HeaderScanner::headerValueIsValid(header_value)
+                                      : Http::HeaderUtility::headerValueIsValid(header_value);
+  if (!valid_header_value) {
     ENVOY_CONN_LOG(debug, "invalid header value: {}", connection_, header_value);
     error_code_ = Http::Code::BadRequest;
     RETURN_IF_ERROR(sendProtocolError(Http1ResponseCodeDetails::get().InvalidCharacters));
@@ -317,6 +317,8 @@ protected:
   bool deferred_end_stream_headers_ : 1;
   bool dispatching_ : 1;
   bool dispatching_slice_already_drained_ : 1;
+  // Validate header values with the vectorized HeaderScanner rather than the scalar validator.
+  const bool vectorized_header_validation_ : 1;
   StreamInfo::BytesMeterSharedPtr bytes_meter_before_stream_;
   const uint32_t max_headers_kb_;
   const uint32_t max_headers_count_;
@@ -0,0 +1,69 @@
+#include "source/common/http/http1/header_scanner.h"
+
+#include <cstdint>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace Envoy {
+namespace Http {
+namespace Http1 {
+namespace {
+
+inline bool isInvalidHeaderValueChar(uint8_t c) { return (c < 0x20 && c != '\t') || c == 0x7f; }
+
+} // namespace
+
+size_t HeaderScanner::findInvalidHeaderValueCharScalar(absl::string_view value, size_t start) {
+  for (size_t i = start; i < value.size(); ++i) {
+    if (isInvalidHeaderValueChar(static_cast<uint8_t>(value[i]))) {
+      return i;
+    }
+  }
+  return absl::string_view::npos;
+}
+
+size_t HeaderScanner::findInvalidHeaderValueChar(absl::string_view value) {
+  const uint8_t* data = reinterpret_cast<const uint8_t*>(value.data());
+  const size_t size = value.size();
+  size_t i = 0;
+
+#if defined(__SSE2__)
+  const __m128i max_control = _mm_set1_epi8(0x1f);
+  const __m128i tab = _mm_set1_epi8('\t');
+  const __m128i del = _mm_set1_epi8(0x7f);
+  for (; i + 16 <= size; i += 16) {
+    const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+    // An unsigned byte is a control character iff min(byte, 0x1f) == byte.
+    const __m128i control = _mm_cmpeq_epi8(_mm_min_epu8(chunk, max_control), chunk);
+    const __m128i invalid = _mm_or_si128(_mm_andnot_si128(_mm_cmpeq_epi8(chunk, tab), control),
+                                         _mm_cmpeq_epi8(chunk, del));
+    const int mask = _mm_movemask_epi8(invalid);
+    if (mask != 0) {
+      return i + __builtin_ctz(mask);
+    }
+  }
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+  const uint8x16_t space = vdupq_n_u8(0x20);
+  const uint8x16_t tab = vdupq_n_u8('\t');
+  const uint8x16_t del = vdupq_n_u8(0x7f);
+  for (; i + 16 <= size; i += 16) {
+    const uint8x16_t chunk = vld1q_u8(data + i);
+    const uint8x16_t invalid = vorrq_u8(vbicq_u8(vcltq_u8(chunk, space), vceqq_u8(chunk, tab)),
+                                        vceqq_u8(chunk, del));
+    if (vmaxvq_u8(invalid) != 0) {
+      // Let the scalar loop pinpoint the offending byte within this block.
+      return findInvalidHeaderValueCharScalar(value, i);
+    }
+  }
+#endif
+
+  return findInvalidHeaderValueCharScalar(value, i);
+}
+
+} // namespace Http1
+} // namespace Http
+} // namespace Envoy
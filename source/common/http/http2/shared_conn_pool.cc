@@ -0,0 +1,599 @@
+#include "source/common/http/http2/shared_conn_pool.h"
+
+#include <algorithm>
+
+#include "source/common/buffer/buffer_impl.h"
+#include "source/common/common/assert.h"
+#include "source/common/common/dump_state_utils.h"
+#include "source/common/common/hash.h"
+#include "source/common/http/header_map_impl.h"
+
+namespace Envoy {
+namespace Http {
+namespace Http2 {
+
+void SharedConnPoolWorkers::addWorker(Event::Dispatcher& dispatcher) {
+  absl::MutexLock lock(&mutex_);
+  const auto position = std::lower_bound(
+      workers_.begin(), workers_.end(), &dispatcher,
+      [](Event::Dispatcher* lhs, Event::Dispatcher* rhs) { return lhs->name() < rhs->name(); });
+  workers_.insert(position, &dispatcher);
+}
+
+void SharedConnPoolWorkers::removeWorker(Event::Dispatcher& dispatcher) {
+  absl::MutexLock lock(&mutex_);
+  workers_.erase(std::remove(workers_.begin(), workers_.end(), &dispatcher), workers_.end());
+}
+
+Event::Dispatcher* SharedConnPoolWorkers::ownerFor(const Upstream::HostDescription& host,
+                                                   Event::Dispatcher& dispatcher,
+                                                   uint32_t owners_per_host) const {
+  absl::MutexLock lock(&mutex_);
+  const uint64_t worker_count = workers_.size();
+  if (worker_count == 0 || worker_count != concurrency_) {
+    return nullptr;
+  }
+  const auto worker = std::find(workers_.begin(), workers_.end(), &dispatcher);
+  if (worker == workers_.end()) {
+    return nullptr;
+  }
+
+  // The owners of a host are the owners_per_host workers following its hash, and every other
+  // worker hands its streams to one of them by its own position.
+  const uint64_t owners = std::min<uint64_t>(std::max<uint32_t>(owners_per_host, 1), worker_count);
+  const uint64_t first_owner =
+      HashUtil::xxHash64(host.address() != nullptr ? host.address()->asStringView()
+                                                   : absl::string_view(host.hostname())) %
+      worker_count;
+  const uint64_t offset = (worker - workers_.begin() + worker_count - first_owner) % worker_count;
+  if (offset < owners) {
+    return nullptr;
+  }
+  return workers_[(first_owner + offset % owners) % worker_count];
+}
+
+OwnerStream::OwnerStream(Event::Dispatcher& dispatcher, Event::Dispatcher& client_dispatcher,
+                         std::weak_ptr<ClientStream> client)
+    : dispatcher_(dispatcher), client_dispatcher_(client_dispatcher), client_(std::move(client)) {}
+
+void OwnerStream::start(ConnectionPool::Instance* pool,
+                        const ConnectionPool::Instance::StreamOptions& options) {
+  ASSERT(dispatcher_.isThreadSafe());
+  if (pool == nullptr) {
+    postToClient([](ClientStream& client) {
+      client.onPoolFailure(ConnectionPool::PoolFailureReason::LocalConnectionFailure,
+                           "no shared connection pool");
+    });
+    return;
+  }
+
+  self_ = shared_from_this();
+  ConnectionPool::Cancellable* pending = pool->newStream(*this, *this, options);
+  if (self_ != nullptr) {
+    pending_ = pending;
+  }
+}
+
+void OwnerStream::encodeHeaders(RequestHeaderMapPtr headers, bool end_stream) {
+  if (encoder_ == nullptr) {
+    return;
+  }
+  request_headers_ = std::move(headers);
+  const Status status = encoder_->encodeHeaders(*request_headers_, end_stream);
+  if (!status.ok()) {
+    ENVOY_LOG(debug, "failed to encode handed off request headers: {}", status.message());
+    RequestEncoder* encoder = encoder_;
+    const std::string details(status.message());
+    postToClient([details](ClientStream& client) {
+      client.onRemoteReset(StreamResetReason::LocalReset, details);
+    });
+    onComplete();
+    encoder->getStream().resetStream(StreamResetReason::LocalReset);
+    return;
+  }
+  if (end_stream && encoder_ != nullptr) {
+    local_complete_ = true;
+    if (remote_complete_) {
+      onComplete();
+    }
+  }
+}
+
+void OwnerStream::encodeData(Buffer::InstancePtr data, bool end_stream) {
+  postToClient([length = data->length()](ClientStream& client) { client.onDataWritten(length); });
+  if (encoder_ == nullptr) {
+    return;
+  }
+  encoder_->encodeData(*data, end_stream);
+  if (end_stream && encoder_ != nullptr) {
+    local_complete_ = true;
+    if (remote_complete_) {
+      onComplete();
+    }
+  }
+}
+
+void OwnerStream::encodeTrailers(RequestTrailerMapPtr trailers) {
+  if (encoder_ == nullptr) {
+    return;
+  }
+  encoder_->encodeTrailers(*trailers);
+  if (encoder_ != nullptr) {
+    local_complete_ = true;
+    if (remote_complete_) {
+      onComplete();
+    }
+  }
+}
+
+void OwnerStream::encodeMetadata(MetadataMapVector metadata_map_vector) {
+  if (encoder_ != nullptr) {
+    encoder_->encodeMetadata(metadata_map_vector);
+  }
+}
+
+void OwnerStream::enableTcpTunneling() {
+  if (encoder_ != nullptr) {
+    encoder_->enableTcpTunneling();
+  }
+}
+
+void OwnerStream::readDisable(bool disable) {
+  if (encoder_ != nullptr) {
+    encoder_->getStream().readDisable(disable);
+  }
+}
+
+void OwnerStream::setFlushTimeout(std::chrono::milliseconds timeout) {
+  if (encoder_ != nullptr) {
+    encoder_->getStream().setFlushTimeout(timeout);
+  }
+}
+
+void OwnerStream::resetStream(StreamResetReason reason) {
+  if (encoder_ == nullptr) {
+    return;
+  }
+  RequestEncoder* encoder = encoder_;
+  onComplete();
+  encoder->getStream().resetStream(reason);
+}
+
+void OwnerStream::cancel(Envoy::ConnectionPool::CancelPolicy policy) {
+  if (pending_ != nullptr) {
+    ConnectionPool::Cancellable* pending = pending_;
+    onComplete();
+    pending->cancel(policy);
+    return;
+  }
+  // The stream became ready while the cancellation was in flight.
+  resetStream(StreamResetReason::LocalReset);
+}
+
+void OwnerStream::decode1xxHeaders(ResponseHeaderMapPtr&& headers) {
+  postToClient([headers = std::move(headers)](ClientStream& client) mutable {
+    client.decode1xxHeaders(std::move(headers));
+  });
+}
+
+void OwnerStream::decodeHeaders(ResponseHeaderMapPtr&& headers, bool end_stream) {
+  if (end_stream) {
+    postBytesToClient();
+  }
+  postToClient([headers = std::move(headers), end_stream](ClientStream& client) mutable {
+    client.decodeHeaders(std::move(headers), end_stream);
+  });
+  if (end_stream) {
+    onRemoteComplete();
+  }
+}
+
+void OwnerStream::decodeData(Buffer::Instance& data, bool end_stream) {
+  if (end_stream) {
+    postBytesToClient();
+  }
+  auto buffer = std::make_unique<Buffer::OwnedImpl>();
+  buffer->move(data, data.length(), /*reset_drain_trackers_and_accounting=*/true);
+  postToClient([buffer = std::move(buffer), end_stream](ClientStream& client) {
+    client.decodeData(*buffer, end_stream);
+  });
+  if (end_stream) {
+    onRemoteComplete();
+  }
+}
+
+void OwnerStream::decodeTrailers(ResponseTrailerMapPtr&& trailers) {
+  postBytesToClient();
+  postToClient([trailers = std::move(trailers)](ClientStream& client) mutable {
+    client.decodeTrailers(std::move(trailers));
+  });
+  onRemoteComplete();
+}
+
+void OwnerStream::decodeMetadata(MetadataMapPtr&& metadata_map) {
+  postToClient([metadata_map = std::move(metadata_map)](ClientStream& client) mutable {
+    client.decodeMetadata(std::move(metadata_map));
+  });
+}
+
+void OwnerStream::dumpState(std::ostream& os, int indent_level) const {
+  const char* spaces = spacesForLevel(indent_level);
+  os << spaces << "Http2::OwnerStream " << this << DUMP_MEMBER(local_complete_)
+     << DUMP_MEMBER(remote_complete_) << "\n";
+}
+
+void OwnerStream::onResetStream(StreamResetReason reason,
+                                absl::string_view transport_failure_reason) {
+  postBytesToClient();
+  postToClient([reason, details = std::string(transport_failure_reason)](ClientStream& client) {
+    client.onRemoteReset(reason, details);
+  });
+  onComplete();
+}
+
+void OwnerStream::onAboveWriteBufferHighWatermark() {
+  postToClient([](ClientStream& client) { client.onAboveWriteBufferHighWatermark(); });
+}
+
+void OwnerStream::onBelowWriteBufferLowWatermark() {
+  postToClient([](ClientStream& client) { client.onBelowWriteBufferLowWatermark(); });
+}
+
+void OwnerStream::onPoolFailure(ConnectionPool::PoolFailureReason reason,
+                                absl::string_view transport_failure_reason,
+                                Upstream::HostDescriptionConstSharedPtr) {
+  pending_ = nullptr;
+  postToClient([reason, details = std::string(transport_failure_reason)](ClientStream& client) {
+    client.onPoolFailure(reason, details);
+  });
+  onComplete();
+}
+
+void OwnerStream::onPoolReady(RequestEncoder& encoder, Upstream::HostDescriptionConstSharedPtr,
+                              StreamInfo::StreamInfo&, absl::optional<Http::Protocol> protocol) {
+  pending_ = nullptr;
+  encoder_ = &encoder;
+  Stream& stream = encoder.getStream();
+  stream.addCallbacks(*this);
+  const Network::ConnectionInfoProvider& connection_info = stream.connectionInfoProvider();
+  postToClient([local_address = connection_info.localAddress(),
+                remote_address = connection_info.remoteAddress(),
+                connection_id = connection_info.connectionID(), buffer_limit = stream.bufferLimit(),
+                protocol](ClientStream& client) {
+    client.onPoolReady(local_address, remote_address, connection_id, buffer_limit, protocol);
+  });
+}
+
+void OwnerStream::postToClient(absl::AnyInvocable<void(ClientStream&)> cb) {
+  client_dispatcher_.post([client = client_, cb = std::move(cb)]() mutable {
+    if (ClientStreamSharedPtr stream = client.lock(); stream != nullptr) {
+      cb(*stream);
+    }
+  });
+}
+
+void OwnerStream::onRemoteComplete() {
+  remote_complete_ = true;
+  if (local_complete_) {
+    onComplete();
+  }
+}
+
+void OwnerStream::postBytesToClient() {
+  if (encoder_ == nullptr) {
+    return;
+  }
+  const StreamInfo::BytesMeterSharedPtr& bytes_meter = encoder_->getStream().bytesMeter();
+  if (bytes_meter == nullptr) {
+    return;
+  }
+  postToClient([header_bytes_sent = bytes_meter->headerBytesSent(),
+                header_bytes_received = bytes_meter->headerBytesReceived(),
+                wire_bytes_sent = bytes_meter->wireBytesSent(),
+                wire_bytes_received = bytes_meter->wireBytesReceived()](ClientStream& client) {
+    client.addBytes(header_bytes_sent, header_bytes_received, wire_bytes_sent,
+                    wire_bytes_received);
+  });
+}
+
+void OwnerStream::onComplete() {
+  if (self_ == nullptr) {
+    return;
+  }
+  if (encoder_ != nullptr) {
+    encoder_->getStream().removeCallbacks(*this);
+    encoder_ = nullptr;
+  }
+  pending_ = nullptr;
+  // The owner's pool or codec may still be on the stack, so release this once they unwind.
+  dispatcher_.post([self = std::move(self_)]() {});
+}
+
+ClientStream::ClientStream(SharedConnPoolClient& parent, ResponseDecoder& response_decoder,
+                           ConnectionPool::Callbacks& callbacks)
+    : parent_(&parent), dispatcher_(parent.dispatcher()), host_(parent.host()),
+      response_decoder_(response_decoder), pool_callbacks_(&callbacks) {}
+
+void ClientStream::start(Event::Dispatcher& owner_dispatcher,
+                         const std::function<ConnectionPool::Instance*()>& owner_pool,
+                         const ConnectionPool::Instance::StreamOptions& options) {
+  owner_dispatcher_ = &owner_dispatcher;
+  owner_ = std::make_shared<OwnerStream>(owner_dispatcher, dispatcher_, weak_from_this());
+  owner_dispatcher.post(
+      [owner = owner_, owner_pool, options]() { owner->start(owner_pool(), options); });
+}
+
+void ClientStream::abort() {
+  parent_ = nullptr;
+  if (pool_callbacks_ != nullptr) {
+    ConnectionPool::Callbacks* callbacks = pool_callbacks_;
+    cancel(Envoy::ConnectionPool::CancelPolicy::Default);
+    callbacks->onPoolFailure(ConnectionPool::PoolFailureReason::LocalConnectionFailure,
+                             "connection pool destroyed", host_);
+    return;
+  }
+  resetStream(StreamResetReason::ConnectionTermination);
+}
+
+void ClientStream::onPoolFailure(ConnectionPool::PoolFailureReason reason,
+                                 absl::string_view transport_failure_reason) {
+  if (complete_) {
+    return;
+  }
+  ConnectionPool::Callbacks* callbacks = pool_callbacks_;
+  onComplete();
+  callbacks->onPoolFailure(reason, transport_failure_reason, host_);
+}
+
+void ClientStream::onPoolReady(Network::Address::InstanceConstSharedPtr local_address,
+                               Network::Address::InstanceConstSharedPtr remote_address,
+                               absl::optional<uint64_t> connection_id, uint32_t buffer_limit,
+                               absl::optional<Http::Protocol> protocol) {
+  if (complete_) {
+    return;
+  }
+  connection_info_provider_ =
+      std::make_shared<Network::ConnectionInfoSetterImpl>(local_address, remote_address);
+  if (connection_id.has_value()) {
+    connection_info_provider_->setConnectionID(connection_id.value());
+  }
+  stream_info_ = std::make_unique<StreamInfo::StreamInfoImpl>(
+      Protocol::Http2, dispatcher_.timeSource(), connection_info_provider_,
+      StreamInfo::FilterState::LifeSpan::Connection);
+  buffer_limit_ = buffer_limit;
+  ConnectionPool::Callbacks* callbacks = pool_callbacks_;
+  pool_callbacks_ = nullptr;
+  callbacks->onPoolReady(*this, host_, *stream_info_, protocol);
+}
+
+void ClientStream::decode1xxHeaders(ResponseHeaderMapPtr&& headers) {
+  if (!complete_) {
+    response_decoder_.decode1xxHeaders(std::move(headers));
+  }
+}
+
+void ClientStream::decodeHeaders(ResponseHeaderMapPtr&& headers, bool end_stream) {
+  if (complete_) {
+    return;
+  }
+  remote_complete_ = end_stream;
+  response_decoder_.decodeHeaders(std::move(headers), end_stream);
+  maybeComplete();
+}
+
+void ClientStream::decodeData(Buffer::Instance& data, bool end_stream) {
+  if (complete_) {
+    return;
+  }
+  remote_complete_ = end_stream;
+  response_decoder_.decodeData(data, end_stream);
+  maybeComplete();
+}
+
+void ClientStream::decodeTrailers(ResponseTrailerMapPtr&& trailers) {
+  if (complete_) {
+    return;
+  }
+  remote_complete_ = true;
+  response_decoder_.decodeTrailers(std::move(trailers));
+  maybeComplete();
+}
+
+void ClientStream::decodeMetadata(MetadataMapPtr&& metadata_map) {
+  if (!complete_) {
+    response_decoder_.decodeMetadata(std::move(metadata_map));
+  }
+}
+
+void ClientStream::onRemoteReset(StreamResetReason reason,
+                                 absl::string_view transport_failure_reason) {
+  if (complete_) {
+    return;
+  }
+  runResetCallbacks(reason, transport_failure_reason);
+  onComplete();
+}
+
+void ClientStream::onDataWritten(uint64_t length) {
+  if (complete_) {
+    return;
+  }
+  ASSERT(pending_bytes_ >= length);
+  pending_bytes_ -= length;
+  if (above_pending_high_watermark_ && pending_bytes_ <= buffer_limit_ / 2) {
+    above_pending_high_watermark_ = false;
+    runLowWatermarkCallbacks();
+  }
+}
+
+void ClientStream::addBytes(uint64_t header_bytes_sent, uint64_t header_bytes_received,
+                            uint64_t wire_bytes_sent, uint64_t wire_bytes_received) {
+  bytes_meter_->addHeaderBytesSent(header_bytes_sent);
+  bytes_meter_->addHeaderBytesReceived(header_bytes_received);
+  bytes_meter_->addWireBytesSent(wire_bytes_sent);
+  bytes_meter_->addWireBytesReceived(wire_bytes_received);
+}
+
+Status ClientStream::encodeHeaders(const RequestHeaderMap& headers, bool end_stream) {
+  ASSERT(!complete_);
+  local_end_stream_ = end_stream;
+  postToOwner([headers = createHeaderMap<RequestHeaderMapImpl>(headers),
+               end_stream](OwnerStream& owner) mutable {
+    owner.encodeHeaders(std::move(headers), end_stream);
+  });
+  maybeComplete();
+  return okStatus();
+}
+
+void ClientStream::encodeTrailers(const RequestTrailerMap& trailers) {
+  ASSERT(!complete_);
+  local_end_stream_ = true;
+  postToOwner([trailers = createHeaderMap<RequestTrailerMapImpl>(trailers)](
+                  OwnerStream& owner) mutable { owner.encodeTrailers(std::move(trailers)); });
+  maybeComplete();
+}
+
+void ClientStream::enableTcpTunneling() {
+  postToOwner([](OwnerStream& owner) { owner.enableTcpTunneling(); });
+}
+
+void ClientStream::encodeData(Buffer::Instance& data, bool end_stream) {
+  ASSERT(!complete_);
+  local_end_stream_ = end_stream;
+  // The owner half only relays the watermarks of its own stream, so bound the data which is
+  // still queued on the owner's worker here as well.
+  pending_bytes_ += data.length();
+  if (buffer_limit_ > 0 && !above_pending_high_watermark_ && pending_bytes_ > buffer_limit_) {
+    above_pending_high_watermark_ = true;
+    runHighWatermarkCallbacks();
+  }
+  auto buffer = std::make_unique<Buffer::OwnedImpl>();
+  buffer->move(data, data.length(), /*reset_drain_trackers_and_accounting=*/true);
+  postToOwner([buffer = std::move(buffer), end_stream](OwnerStream& owner) mutable {
+    owner.encodeData(std::move(buffer), end_stream);
+  });
+  maybeComplete();
+}
+
+void ClientStream::encodeMetadata(const MetadataMapVector& metadata_map_vector) {
+  MetadataMapVector metadata_copy;
+  for (const MetadataMapPtr& metadata_map : metadata_map_vector) {
+    metadata_copy.push_back(std::make_unique<MetadataMap>(*metadata_map));
+  }
+  postToOwner([metadata_copy = std::move(metadata_copy)](OwnerStream& owner) mutable {
+    owner.encodeMetadata(std::move(metadata_copy));
+  });
+}
+
+CodecEventCallbacks*
+ClientStream::registerCodecEventCallbacks(CodecEventCallbacks* codec_callbacks) {
+  std::swap(codec_callbacks, codec_callbacks_);
+  return codec_callbacks;
+}
+
+void ClientStream::resetStream(StreamResetReason reason) {
+  if (complete_) {
+    return;
+  }
+  postToOwner([reason](OwnerStream& owner) { owner.resetStream(reason); });
+  // The reset callbacks may drop the last reference the parent pool holds.
+  ClientStreamSharedPtr self = shared_from_this();
+  runResetCallbacks(reason, absl::string_view());
+  onComplete();
+}
+
+void ClientStream::readDisable(bool disable) {
+  if (!complete_) {
+    postToOwner([disable](OwnerStream& owner) { owner.readDisable(disable); });
+  }
+}
+
+void ClientStream::setFlushTimeout(std::chrono::milliseconds timeout) {
+  if (!complete_) {
+    postToOwner([timeout](OwnerStream& owner) { owner.setFlushTimeout(timeout); });
+  }
+}
+
+void ClientStream::cancel(Envoy::ConnectionPool::CancelPolicy policy) {
+  ASSERT(pool_callbacks_ != nullptr);
+  postToOwner([policy](OwnerStream& owner) { owner.cancel(policy); });
+  onComplete();
+}
+
+void ClientStream::postToOwner(absl::AnyInvocable<void(OwnerStream&)> cb) {
+  owner_dispatcher_->post([owner = owner_, cb = std::move(cb)]() mutable { cb(*owner); });
+}
+
+void ClientStream::maybeComplete() {
+  if (!complete_ && remote_complete_ && local_end_stream_) {
+    onComplete();
+  }
+}
+
+void ClientStream::onComplete() {
+  if (complete_) {
+    return;
+  }
+  complete_ = true;
+  pool_callbacks_ = nullptr;
+  if (parent_ != nullptr) {
+    SharedConnPoolClient* parent = parent_;
+    parent_ = nullptr;
+    parent->onStreamComplete(*this);
+  }
+}
+
+SharedConnPoolClient::SharedConnPoolClient(Event::Dispatcher& dispatcher,
+                                           Event::Dispatcher& owner_dispatcher,
+                                           Upstream::HostConstSharedPtr host,
+                                           OwnerPoolFn owner_pool)
+    : dispatcher_(dispatcher), owner_dispatcher_(owner_dispatcher), host_(std::move(host)),
+      owner_pool_(std::move(owner_pool)) {}
+
+SharedConnPoolClient::~SharedConnPoolClient() {
+  while (!streams_.empty()) {
+    ClientStreamSharedPtr stream = std::move(streams_.front());
+    streams_.pop_front();
+    stream->abort();
+  }
+}
+
+void SharedConnPoolClient::drainConnections(Envoy::ConnectionPool::DrainBehavior drain_behavior) {
+  // There are no connections to drain here, those belong to the owner's pool.
+  if (drain_behavior == Envoy::ConnectionPool::DrainBehavior::DrainAndDelete) {
+    draining_for_deletion_ = true;
+    checkForIdleAndNotify();
+  }
+}
+
+ConnectionPool::Cancellable* SharedConnPoolClient::newStream(ResponseDecoder& response_decoder,
+                                                             ConnectionPool::Callbacks& callbacks,
+                                                             const StreamOptions& options) {
+  ENVOY_LOG(debug, "handing off stream to the worker owning connections to {}",
+            host_->address() != nullptr ? host_->address()->asStringView() : host_->hostname());
+  auto stream = std::make_shared<ClientStream>(*this, response_decoder, callbacks);
+  streams_.push_front(stream);
+  stream->entry_ = streams_.begin();
+  stream->start(owner_dispatcher_, owner_pool_, options);
+  return stream.get();
+}
+
+void SharedConnPoolClient::onStreamComplete(ClientStream& stream) {
+  // The stream may still be on the stack, so release it once the current event unwinds.
+  dispatcher_.post([stream = std::move(*stream.entry_)]() {});
+  streams_.erase(stream.entry_);
+  checkForIdleAndNotify();
+}
+
+void SharedConnPoolClient::checkForIdleAndNotify() {
+  if (!draining_for_deletion_ || !streams_.empty()) {
+    return;
+  }
+  for (const IdleCb& cb : idle_callbacks_) {
+    cb();
+  }
+}
+
+} // namespace Http2
+} // namespace Http
+} // namespace Envoy
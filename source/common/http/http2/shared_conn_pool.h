@@ -0,0 +1,283 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "envoy/event/dispatcher.h"
+#include "envoy/http/codec.h"
+#include "envoy/http/conn_pool.h"
+#include "envoy/upstream/upstream.h"
+
+#include "source/common/common/logger.h"
+#include "source/common/http/codec_helper.h"
+#include "source/common/network/socket_impl.h"
+#include "source/common/stream_info/stream_info_impl.h"
+
+#include "absl/synchronization/mutex.h"
+
+namespace Envoy {
+namespace Http {
+namespace Http2 {
+
+/**
+ * The workers which share upstream HTTP/2 connections. For each upstream host a few of the workers
+ * own the connections, and the others hand their streams to one of those owners.
+ */
+class SharedConnPoolWorkers {
+public:
+  explicit SharedConnPoolWorkers(uint32_t concurrency) : concurrency_(concurrency) {}
+
+  /**
+   * Called on each worker as it starts and stops serving upstream connections.
+   */
+  void addWorker(Event::Dispatcher& dispatcher);
+  void removeWorker(Event::Dispatcher& dispatcher);
+
+  /**
+   * @return the dispatcher of the worker that the streams of dispatcher's worker to host should be
+   *         handed to, or nullptr if dispatcher's worker owns connections to host itself. Until all
+   *         workers are running every worker owns its connections, so that workers never disagree
+   *         on the owners of a host.
+   */
+  Event::Dispatcher* ownerFor(const Upstream::HostDescription& host, Event::Dispatcher& dispatcher,
+                              uint32_t owners_per_host) const;
+
+private:
+  const uint32_t concurrency_;
+  mutable absl::Mutex mutex_;
+  // Sorted by dispatcher name, so that all workers choose the same owners.
+  std::vector<Event::Dispatcher*> workers_ ABSL_GUARDED_BY(mutex_);
+};
+
+class ClientStream;
+class SharedConnPoolClient;
+using ClientStreamSharedPtr = std::shared_ptr<ClientStream>;
+
+/**
+ * The half of a handed off stream which lives on the owner's worker. It creates the stream on the
+ * owner's connection pool, replays what the client encodes onto it and forwards what it decodes
+ * back to the client's worker.
+ */
+class OwnerStream : public ResponseDecoder,
+                    public StreamCallbacks,
+                    public ConnectionPool::Callbacks,
+                    public std::enable_shared_from_this<OwnerStream>,
+                    protected Logger::Loggable<Logger::Id::pool> {
+public:
+  OwnerStream(Event::Dispatcher& dispatcher, Event::Dispatcher& client_dispatcher,
+              std::weak_ptr<ClientStream> client);
+
+  // Creates the stream on the owner's pool, or fails it if there is no pool.
+  void start(ConnectionPool::Instance* pool,
+             const ConnectionPool::Instance::StreamOptions& options);
+
+  // Handed off by the client stream.
+  void encodeHeaders(RequestHeaderMapPtr headers, bool end_stream);
+  void encodeData(Buffer::InstancePtr data, bool end_stream);
+  void encodeTrailers(RequestTrailerMapPtr trailers);
+  void encodeMetadata(MetadataMapVector metadata_map_vector);
+  void enableTcpTunneling();
+  void readDisable(bool disable);
+  void setFlushTimeout(std::chrono::milliseconds timeout);
+  void resetStream(StreamResetReason reason);
+  void cancel(Envoy::ConnectionPool::CancelPolicy policy);
+
+  // Http::ResponseDecoder
+  void decode1xxHeaders(ResponseHeaderMapPtr&& headers) override;
+  void decodeHeaders(ResponseHeaderMapPtr&& headers, bool end_stream) override;
+  void decodeData(Buffer::Instance& data, bool end_stream) override;
+  void decodeTrailers(ResponseTrailerMapPtr&& trailers) override;
+  void decodeMetadata(MetadataMapPtr&& metadata_map) override;
+  void dumpState(std::ostream& os, int indent_level) const override;
+
+  // Http::StreamCallbacks
+  void onResetStream(StreamResetReason reason,
+                     absl::string_view transport_failure_reason) override;
+  void onAboveWriteBufferHighWatermark() override;
+  void onBelowWriteBufferLowWatermark() override;
+
+  // Http::ConnectionPool::Callbacks
+  void onPoolFailure(ConnectionPool::PoolFailureReason reason,
+                     absl::string_view transport_failure_reason,
+                     Upstream::HostDescriptionConstSharedPtr host) override;
+  void onPoolReady(RequestEncoder& encoder, Upstream::HostDescriptionConstSharedPtr host,
+                   StreamInfo::StreamInfo& info, absl::optional<Http::Protocol> protocol) override;
+
+private:
+  // Runs cb on the client's worker, unless the client stream is gone by then.
+  void postToClient(absl::AnyInvocable<void(ClientStream&)> cb);
+  void onRemoteComplete();
+  // Hands the byte counts of the stream to the client, just before its last event.
+  void postBytesToClient();
+  // Detaches from the owner's pool or stream and releases self_.
+  void onComplete();
+
+  Event::Dispatcher& dispatcher_;
+  Event::Dispatcher& client_dispatcher_;
+  const std::weak_ptr<ClientStream> client_;
+  // Keeps this alive while the owner's pool or stream refers to it.
+  std::shared_ptr<OwnerStream> self_;
+  ConnectionPool::Cancellable* pending_{};
+  RequestEncoder* encoder_{};
+  // The codec may refer to the request headers until the stream completes.
+  RequestHeaderMapPtr request_headers_;
+  bool local_complete_{};
+  bool remote_complete_{};
+};
+
+/**
+ * The half of a handed off stream which lives on the client's worker. To the client it looks like a
+ * stream of a local connection pool. Headers and trailers are copied and data is moved with its
+ * drain trackers and accounting reset, so nothing handed to the other worker refers back to this
+ * one.
+ */
+class ClientStream : public RequestEncoder,
+                     public Stream,
+                     public StreamCallbackHelper,
+                     public ConnectionPool::Cancellable,
+                     public std::enable_shared_from_this<ClientStream>,
+                     protected Logger::Loggable<Logger::Id::pool> {
+public:
+  ClientStream(SharedConnPoolClient& parent, ResponseDecoder& response_decoder,
+               ConnectionPool::Callbacks& callbacks);
+
+  // Creates the owner half of the stream on owner_dispatcher's worker.
+  void start(Event::Dispatcher& owner_dispatcher,
+             const std::function<ConnectionPool::Instance*()>& owner_pool,
+             const ConnectionPool::Instance::StreamOptions& options);
+  // Resets the stream because the client's pool is going away.
+  void abort();
+
+  // Forwarded from the owner half.
+  void onPoolFailure(ConnectionPool::PoolFailureReason reason,
+                     absl::string_view transport_failure_reason);
+  void onPoolReady(Network::Address::InstanceConstSharedPtr local_address,
+                   Network::Address::InstanceConstSharedPtr remote_address,
+                   absl::optional<uint64_t> connection_id, uint32_t buffer_limit,
+                   absl::optional<Http::Protocol> protocol);
+  void decode1xxHeaders(ResponseHeaderMapPtr&& headers);
+  void decodeHeaders(ResponseHeaderMapPtr&& headers, bool end_stream);
+  void decodeData(Buffer::Instance& data, bool end_stream);
+  void decodeTrailers(ResponseTrailerMapPtr&& trailers);
+  void decodeMetadata(MetadataMapPtr&& metadata_map);
+  void onRemoteReset(StreamResetReason reason, absl::string_view transport_failure_reason);
+  void onAboveWriteBufferHighWatermark() { runHighWatermarkCallbacks(); }
+  void onBelowWriteBufferLowWatermark() { runLowWatermarkCallbacks(); }
+  // Called once the owner half has handed length bytes of request data to its encoder.
+  void onDataWritten(uint64_t length);
+  void addBytes(uint64_t header_bytes_sent, uint64_t header_bytes_received,
+                uint64_t wire_bytes_sent, uint64_t wire_bytes_received);
+
+  // Http::RequestEncoder
+  Status encodeHeaders(const RequestHeaderMap& headers, bool end_stream) override;
+  void encodeTrailers(const RequestTrailerMap& trailers) override;
+  void enableTcpTunneling() override;
+
+  // Http::StreamEncoder
+  void encodeData(Buffer::Instance& data, bool end_stream) override;
+  Stream& getStream() override { return *this; }
+  void encodeMetadata(const MetadataMapVector& metadata_map_vector) override;
+  Http1StreamEncoderOptionsOptRef http1StreamEncoderOptions() override { return absl::nullopt; }
+
+  // Http::Stream
+  void addCallbacks(StreamCallbacks& callbacks) override { addCallbacksHelper(callbacks); }
+  void removeCallbacks(StreamCallbacks& callbacks) override { removeCallbacksHelper(callbacks); }
+  CodecEventCallbacks* registerCodecEventCallbacks(CodecEventCallbacks* codec_callbacks) override;
+  void resetStream(StreamResetReason reason) override;
+  void readDisable(bool disable) override;
+  uint32_t bufferLimit() const override { return buffer_limit_; }
+  const Network::ConnectionInfoProvider& connectionInfoProvider() override {
+    return *connection_info_provider_;
+  }
+  void setFlushTimeout(std::chrono::milliseconds timeout) override;
+  Buffer::BufferMemoryAccountSharedPtr account() const override { return account_; }
+  void setAccount(Buffer::BufferMemoryAccountSharedPtr account) override {
+    account_ = std::move(account);
+  }
+  const StreamInfo::BytesMeterSharedPtr& bytesMeter() override { return bytes_meter_; }
+
+  // Envoy::ConnectionPool::Cancellable
+  void cancel(Envoy::ConnectionPool::CancelPolicy policy) override;
+
+  std::list<ClientStreamSharedPtr>::iterator entry_;
+
+private:
+  // Runs cb with the owner half on the owner's worker.
+  void postToOwner(absl::AnyInvocable<void(OwnerStream&)> cb);
+  void maybeComplete();
+  // Stops delivering events to the client and removes this from the parent pool.
+  void onComplete();
+
+  SharedConnPoolClient* parent_;
+  Event::Dispatcher& dispatcher_;
+  const Upstream::HostDescriptionConstSharedPtr host_;
+  Event::Dispatcher* owner_dispatcher_{};
+  std::shared_ptr<OwnerStream> owner_;
+  ResponseDecoder& response_decoder_;
+  ConnectionPool::Callbacks* pool_callbacks_;
+  CodecEventCallbacks* codec_callbacks_{};
+  std::shared_ptr<Network::ConnectionInfoSetterImpl> connection_info_provider_{
+      std::make_shared<Network::ConnectionInfoSetterImpl>(nullptr, nullptr)};
+  std::unique_ptr<StreamInfo::StreamInfoImpl> stream_info_;
+  Buffer::BufferMemoryAccountSharedPtr account_;
+  StreamInfo::BytesMeterSharedPtr bytes_meter_{std::make_shared<StreamInfo::BytesMeter>()};
+  uint32_t buffer_limit_{};
+  // Request data posted to the owner half which it has not handed to its encoder yet.
+  uint64_t pending_bytes_{};
+  bool above_pending_high_watermark_{};
+  bool remote_complete_{};
+  bool complete_{};
+};
+
+/**
+ * A connection pool for the workers which do not own connections to a host. It opens no
+ * connections itself, and hands every stream to the owner worker's pool for the host instead.
+ */
+class SharedConnPoolClient : public ConnectionPool::Instance,
+                             protected Logger::Loggable<Logger::Id::pool> {
+public:
+  /**
+   * Returns the owner worker's connection pool for the host, or nullptr if it has none. It is only
+   * called on the owner's worker.
+   */
+  using OwnerPoolFn = std::function<ConnectionPool::Instance*()>;
+
+  SharedConnPoolClient(Event::Dispatcher& dispatcher, Event::Dispatcher& owner_dispatcher,
+                       Upstream::HostConstSharedPtr host, OwnerPoolFn owner_pool);
+  ~SharedConnPoolClient() override;
+
+  // Http::ConnectionPool::Instance
+  void addIdleCallback(IdleCb cb) override { idle_callbacks_.push_back(std::move(cb)); }
+  bool isIdle() const override { return streams_.empty(); }
+  void drainConnections(Envoy::ConnectionPool::DrainBehavior drain_behavior) override;
+  Upstream::HostDescriptionConstSharedPtr host() const override { return host_; }
+  bool maybePreconnect(float) override { return false; }
+  bool hasActiveConnections() const override { return !streams_.empty(); }
+  ConnectionPool::Cancellable* newStream(ResponseDecoder& response_decoder,
+                                         ConnectionPool::Callbacks& callbacks,
+                                         const StreamOptions& options) override;
+  absl::string_view protocolDescription() const override { return "HTTP/2"; }
+
+  Event::Dispatcher& dispatcher() { return dispatcher_; }
+  void onStreamComplete(ClientStream& stream);
+
+private:
+  void checkForIdleAndNotify();
+
+  Event::Dispatcher& dispatcher_;
+  Event::Dispatcher& owner_dispatcher_;
+  const Upstream::HostConstSharedPtr host_;
+  const OwnerPoolFn owner_pool_;
+  std::list<ClientStreamSharedPtr> streams_;
+  std::list<IdleCb> idle_callbacks_;
+  bool draining_for_deletion_{};
+};
+
+} // namespace Http2
+} // namespace Http
+} // namespace Envoy
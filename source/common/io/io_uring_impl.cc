@@ -17,6 +17,105 @@ bool isIoUringSupported() {
   return is_supported;
 }
 
+ProvidedBufferRing* ProvidedBufferRing::create(struct io_uring& ring, uint16_t group_id,
+                                               uint32_t buffer_count, uint32_t buffer_size) {
+  ASSERT(buffer_count > 0 && (buffer_count & (buffer_count - 1)) == 0);
+  int ret = 0;
+  struct io_uring_buf_ring* buf_ring =
+      io_uring_setup_buf_ring(&ring, buffer_count, group_id, 0, &ret);
+  if (buf_ring == nullptr) {
+    ENVOY_LOG_MISC(debug, "unable to register provided buffer ring: {}", errorDetails(-ret));
+    return nullptr;
+  }
+  return new ProvidedBufferRing(buf_ring, group_id, buffer_count, buffer_size);
+}
+
+ProvidedBufferRing::ProvidedBufferRing(struct io_uring_buf_ring* buf_ring, uint16_t group_id,
+                                       uint32_t buffer_count, uint32_t buffer_size)
+    : buf_ring_(buf_ring), group_id_(group_id), buffer_count_(buffer_count),
+      buffer_size_(buffer_size), owner_thread_(std::this_thread::get_id()),
+      memory_(std::make_unique<uint8_t[]>(static_cast<size_t>(buffer_count) * buffer_size)),
+      fragments_(buffer_count) {
+  const int mask = io_uring_buf_ring_mask(buffer_count_);
+  for (uint32_t i = 0; i < buffer_count_; ++i) {
+    Fragment& fragment = fragments_[i];
+    fragment.ring_ = this;
+    fragment.data_ = memory_.get() + static_cast<size_t>(i) * buffer_size_;
+    fragment.buffer_id_ = static_cast<uint16_t>(i);
+    io_uring_buf_ring_add(buf_ring_, fragment.data_, buffer_size_, fragment.buffer_id_, mask, i);
+  }
+  io_uring_buf_ring_advance(buf_ring_, buffer_count_);
+}
+
+void ProvidedBufferRing::takeBuffer(uint16_t buffer_id, uint32_t length,
+                                    Buffer::Instance& buffer) {
+  ASSERT(buffer_id < buffer_count_);
+  ASSERT(length <= buffer_size_);
+  Fragment& fragment = fragments_[buffer_id];
+  fragment.size_ = length;
+  refs_.fetch_add(1, std::memory_order_relaxed);
+  buffer.addBufferFragment(fragment);
+}
+
+void ProvidedBufferRing::recycleBuffer(uint16_t buffer_id) {
+  ASSERT(buffer_id < buffer_count_);
+  ASSERT(std::this_thread::get_id() == owner_thread_);
+  if (!released_) {
+    addToKernelRing(buffer_id);
+  }
+}
+
+void ProvidedBufferRing::addToKernelRing(uint16_t buffer_id) {
+  io_uring_buf_ring_add(buf_ring_, fragments_[buffer_id].data_, buffer_size_, buffer_id,
+                        io_uring_buf_ring_mask(buffer_count_), 0);
+  io_uring_buf_ring_advance(buf_ring_, 1);
+}
+
+void ProvidedBufferRing::onFragmentDone(Fragment& fragment) {
+  if (std::this_thread::get_id() == owner_thread_) {
+    recycleBuffer(fragment.buffer_id_);
+  } else {
+    Thread::LockGuard lock(remote_mutex_);
+    if (registered_) {
+      remote_buffers_.push_back(fragment.buffer_id_);
+      has_remote_buffers_.store(true, std::memory_order_release);
+    }
+  }
+  unref();
+}
+
+void ProvidedBufferRing::recycleRemoteBuffers() {
+  if (!has_remote_buffers_.load(std::memory_order_acquire)) {
+    return;
+  }
+  std::vector<uint16_t> buffers;
+  {
+    Thread::LockGuard lock(remote_mutex_);
+    buffers.swap(remote_buffers_);
+    has_remote_buffers_.store(false, std::memory_order_relaxed);
+  }
+  for (const uint16_t buffer_id : buffers) {
+    addToKernelRing(buffer_id);
+  }
+}
+
+void ProvidedBufferRing::release(struct io_uring& ring) {
+  {
+    Thread::LockGuard lock(remote_mutex_);
+    registered_ = false;
+    remote_buffers_.clear();
+  }
+  released_ = true;
+  io_uring_free_buf_ring(&ring, buf_ring_, buffer_count_, group_id_);
+  unref();
+}
+
+void ProvidedBufferRing::unref() {
+  if (refs_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    delete this;
+  }
+}
+
 IoUringImpl::IoUringImpl(uint32_t io_uring_size, bool use_submission_queue_polling)
     : cqes_(io_uring_size, nullptr) {
   struct io_uring_params p {};
@@ -30,7 +129,12 @@ IoUringImpl::IoUringImpl(uint32_t io_uring_size, bool use_submission_queue_polli
   RELEASE_ASSERT(ret == 0, fmt::format("unable to initialize io_uring: {}", errorDetails(-ret)));
 }
 
-IoUringImpl::~IoUringImpl() { io_uring_queue_exit(&ring_); }
+IoUringImpl::~IoUringImpl() {
+  if (buffer_ring_ != nullptr) {
+    buffer_ring_->release(ring_);
+  }
+  io_uring_queue_exit(&ring_);
+}
 
 os_fd_t IoUringImpl::registerEventfd() {
   ASSERT(!isEventfdRegistered());
@@ -65,11 +169,20 @@ void IoUringImpl::forEveryCompletion(const CompletionCb& completion_cb) {
     }
   }
 
+  // Buffers released on other threads since the last pass can be read into again.
+  if (buffer_ring_ != nullptr) {
+    buffer_ring_->recycleRemoteBuffers();
+  }
+
   unsigned count = io_uring_peek_batch_cqe(&ring_, cqes_.data(), cqes_.size());
 
   for (unsigned i = 0; i < count; ++i) {
     struct io_uring_cqe* cqe = cqes_[i];
-    completion_cb(reinterpret_cast<Request*>(cqe->user_data), cqe->res, false);
+    Request* req = reinterpret_cast<Request*>(cqe->user_data);
+    if (req != nullptr) {
+      req->setCompletionFlags(cqe->flags);
+    }
+    completion_cb(req, cqe->res, false);
   }
 
   io_uring_cq_advance(&ring_, count);
@@ -101,6 +214,7 @@ IoUringResult IoUringImpl::prepareAccept(os_fd_t fd, struct sockaddr* remote_add
   }
 
   io_uring_prep_accept(sqe, fd, remote_addr, remote_addr_len, 0);
+  useRegisteredFile(sqe, fd);
   io_uring_sqe_set_data(sqe, user_data);
   return IoUringResult::Ok;
 }
@@ -117,6 +231,7 @@ IoUringResult IoUringImpl::prepareConnect(os_fd_t fd,
   }
 
   io_uring_prep_connect(sqe, fd, address->sockAddr(), address->sockAddrLen());
+  useRegisteredFile(sqe, fd);
   io_uring_sqe_set_data(sqe, user_data);
   return IoUringResult::Ok;
 }
@@ -132,6 +247,7 @@ IoUringResult IoUringImpl::prepareReadv(os_fd_t fd, const struct iovec* iovecs,
   }
 
   io_uring_prep_readv(sqe, fd, iovecs, nr_vecs, offset);
+  useRegisteredFile(sqe, fd);
   io_uring_sqe_set_data(sqe, user_data);
   return IoUringResult::Ok;
 }
@@ -147,12 +263,15 @@ IoUringResult IoUringImpl::prepareWritev(os_fd_t fd, const struct iovec* iovecs,
   }
 
   io_uring_prep_writev(sqe, fd, iovecs, nr_vecs, offset);
+  useRegisteredFile(sqe, fd);
   io_uring_sqe_set_data(sqe, user_data);
   return IoUringResult::Ok;
 }
 
 IoUringResult IoUringImpl::prepareClose(os_fd_t fd, Request* user_data) {
   ENVOY_LOG(trace, "prepare close for fd = {}", fd);
+  // The file table holds a reference to the file, which would keep it open after the close.
+  unregisterFile(fd);
   // TODO (soulxu): Handling the case of CQ ring is overflow.
   ASSERT(!(*(ring_.sq.kflags) & IORING_SQ_CQ_OVERFLOW));
   struct io_uring_sqe* sqe = io_uring_get_sqe(&ring_);
@@ -191,6 +310,7 @@ IoUringResult IoUringImpl::prepareShutdown(os_fd_t fd, int how, Request* user_da
   }
 
   io_uring_prep_shutdown(sqe, fd, how);
+  useRegisteredFile(sqe, fd);
   io_uring_sqe_set_data(sqe, user_data);
   return IoUringResult::Ok;
 }
@@ -219,5 +339,101 @@ void IoUringImpl::removeInjectedCompletion(os_fd_t fd) {
   });
 }
 
+IoUringResult IoUringImpl::prepareAcceptMultishot(os_fd_t fd, Request* user_data) {
+  ENVOY_LOG(trace, "prepare multishot accept for fd = {}", fd);
+  // TODO (soulxu): Handling the case of CQ ring is overflow.
+  ASSERT(!(*(ring_.sq.kflags) & IORING_SQ_CQ_OVERFLOW));
+  struct io_uring_sqe* sqe = io_uring_get_sqe(&ring_);
+  if (sqe == nullptr) {
+    return IoUringResult::Failed;
+  }
+
+  // The peer address isn't reported, since all completions would share the same storage.
+  io_uring_prep_multishot_accept(sqe, fd, nullptr, nullptr, SOCK_NONBLOCK);
+  useRegisteredFile(sqe, fd);
+  io_uring_sqe_set_data(sqe, user_data);
+  return IoUringResult::Ok;
+}
+
+IoUringResult IoUringImpl::prepareRecvMultishot(os_fd_t fd, Request* user_data) {
+  ENVOY_LOG(trace, "prepare multishot recv for fd = {}", fd);
+  ASSERT(buffer_ring_ != nullptr);
+  // TODO (soulxu): Handling the case of CQ ring is overflow.
+  ASSERT(!(*(ring_.sq.kflags) & IORING_SQ_CQ_OVERFLOW));
+  struct io_uring_sqe* sqe = io_uring_get_sqe(&ring_);
+  if (sqe == nullptr) {
+    return IoUringResult::Failed;
+  }
+
+  io_uring_prep_recv_multishot(sqe, fd, nullptr, 0, 0);
+  sqe->flags |= IOSQE_BUFFER_SELECT;
+  sqe->buf_group = BufferGroupId;
+  useRegisteredFile(sqe, fd);
+  io_uring_sqe_set_data(sqe, user_data);
+  return IoUringResult::Ok;
+}
+
+bool IoUringImpl::registerBufferRing(uint32_t buffer_count, uint32_t buffer_size) {
+  ASSERT(buffer_ring_ == nullptr);
+  buffer_ring_ = ProvidedBufferRing::create(ring_, BufferGroupId, buffer_count, buffer_size);
+  return buffer_ring_ != nullptr;
+}
+
+void IoUringImpl::takeProvidedBuffer(uint16_t buffer_id, uint32_t length,
+                                     Buffer::Instance& buffer) {
+  ASSERT(buffer_ring_ != nullptr);
+  buffer_ring_->takeBuffer(buffer_id, length, buffer);
+}
+
+void IoUringImpl::recycleProvidedBuffer(uint16_t buffer_id) {
+  ASSERT(buffer_ring_ != nullptr);
+  buffer_ring_->recycleBuffer(buffer_id);
+}
+
+bool IoUringImpl::registerFileTable(uint32_t size) {
+  ASSERT(registered_files_.empty());
+  const int ret = io_uring_register_files_sparse(&ring_, size);
+  if (ret != 0) {
+    ENVOY_LOG(debug, "unable to register file table: {}", errorDetails(-ret));
+    return false;
+  }
+  registered_files_.assign(size, false);
+  return true;
+}
+
+void IoUringImpl::registerFile(os_fd_t fd) {
+  if (fd < 0 || static_cast<size_t>(fd) >= registered_files_.size() || registered_files_[fd]) {
+    return;
+  }
+  // The slot of a registered file is the descriptor itself.
+  const int ret = io_uring_register_files_update(&ring_, fd, &fd, 1);
+  if (ret != 1) {
+    ENVOY_LOG(debug, "unable to register fd = {}: {}", fd, errorDetails(-ret));
+    return;
+  }
+  registered_files_[fd] = true;
+}
+
+void IoUringImpl::unregisterFile(os_fd_t fd) {
+  if (fd < 0 || static_cast<size_t>(fd) >= registered_files_.size() || !registered_files_[fd]) {
+    return;
+  }
+  // Requests on the descriptor stop using the slot even if the update fails, and the next
+  // registration of the same descriptor number overwrites it.
+  registered_files_[fd] = false;
+  int unused_slot = -1;
+  const int ret = io_uring_register_files_update(&ring_, fd, &unused_slot, 1);
+  if (ret != 1) {
+    ENVOY_LOG(error, "unable to unregister fd = {}, the file stays referenced by its slot: {}", fd,
+              errorDetails(-ret));
+  }
+}
+
+void IoUringImpl::useRegisteredFile(struct io_uring_sqe* sqe, os_fd_t fd) const {
+  if (fd >= 0 && static_cast<size_t>(fd) < registered_files_.size() && registered_files_[fd]) {
+    sqe->flags |= IOSQE_FIXED_FILE;
+  }
+}
+
 } // namespace Io
 } // namespace Envoy
@@ -1,9 +1,15 @@
 #pragma once
 
+#include <atomic>
+#include <thread>
+
+#include "envoy/buffer/buffer.h"
 #include "envoy/common/io/io_uring.h"
 #include "envoy/thread_local/thread_local.h"
 
 #include "source/common/common/logger.h"
+#include "source/common/common/non_copyable.h"
+#include "source/common/common/thread.h"
 
 #include "liburing.h"
 
@@ -21,6 +27,73 @@ struct InjectedCompletion {
   const int32_t result_;
 };
 
+/**
+ * A ring of buffers registered with the kernel, from which multishot receive requests pick the
+ * buffer to read into. Received data is handed to Buffer::Instance as a fragment which references
+ * the provided buffer, and the buffer goes back to the ring when the fragment is released.
+ *
+ * The ring is reference counted by the owning IoUringImpl and by every outstanding fragment, so
+ * that fragments may outlive the io_uring. The kernel ring may only be refilled by the owning
+ * thread: fragments released on other threads are queued and given back by the owner on its next
+ * completion pass, and fragments released after the ring was unregistered just drop their
+ * reference.
+ */
+class ProvidedBufferRing : NonCopyable {
+public:
+  /**
+   * @return a ring registered with `ring`, or nullptr if the kernel does not support buffer rings.
+   */
+  static ProvidedBufferRing* create(struct io_uring& ring, uint16_t group_id,
+                                    uint32_t buffer_count, uint32_t buffer_size);
+
+  void takeBuffer(uint16_t buffer_id, uint32_t length, Buffer::Instance& buffer);
+  void recycleBuffer(uint16_t buffer_id);
+  // Gives the buffers released on other threads back to the kernel. Owner thread only.
+  void recycleRemoteBuffers();
+  // Unregisters the ring from `ring` and drops the owner's reference. Owner thread only.
+  void release(struct io_uring& ring);
+
+private:
+  class Fragment : public Buffer::BufferFragment {
+  public:
+    // Buffer::BufferFragment
+    const void* data() const override { return data_; }
+    size_t size() const override { return size_; }
+    void done() override { ring_->onFragmentDone(*this); }
+
+    ProvidedBufferRing* ring_{};
+    uint8_t* data_{};
+    size_t size_{};
+    uint16_t buffer_id_{};
+  };
+
+  ProvidedBufferRing(struct io_uring_buf_ring* buf_ring, uint16_t group_id, uint32_t buffer_count,
+                     uint32_t buffer_size);
+  ~ProvidedBufferRing() = default;
+
+  void addToKernelRing(uint16_t buffer_id);
+  void onFragmentDone(Fragment& fragment);
+  void unref();
+
+  struct io_uring_buf_ring* const buf_ring_;
+  const uint16_t group_id_;
+  const uint32_t buffer_count_;
+  const uint32_t buffer_size_;
+  const std::thread::id owner_thread_;
+  // Set once the ring is unregistered. Owner thread only.
+  bool released_{false};
+  std::unique_ptr<uint8_t[]> memory_;
+  // One fragment per buffer, since a buffer can only be handed out once at a time.
+  std::vector<Fragment> fragments_;
+  // One reference for the owner plus one per outstanding fragment.
+  std::atomic<uint32_t> refs_{1};
+  Thread::MutexBasicLockable remote_mutex_;
+  // Cleared by the owner when the ring is unregistered.
+  bool registered_ ABSL_GUARDED_BY(remote_mutex_){true};
+  std::vector<uint16_t> remote_buffers_ ABSL_GUARDED_BY(remote_mutex_);
+  std::atomic<bool> has_remote_buffers_{false};
+};
+
 class IoUringImpl : public IoUring,
                     public ThreadLocal::ThreadLocalObject,
                     protected Logger::Loggable<Logger::Id::io> {
@@ -46,12 +119,30 @@ public:
   IoUringResult submit() override;
   void injectCompletion(os_fd_t fd, Request* user_data, int32_t result) override;
   void removeInjectedCompletion(os_fd_t fd) override;
+  IoUringResult prepareAcceptMultishot(os_fd_t fd, Request* user_data) override;
+  IoUringResult prepareRecvMultishot(os_fd_t fd, Request* user_data) override;
+  bool registerBufferRing(uint32_t buffer_count, uint32_t buffer_size) override;
+  void takeProvidedBuffer(uint16_t buffer_id, uint32_t length, Buffer::Instance& buffer) override;
+  void recycleProvidedBuffer(uint16_t buffer_id) override;
+  bool registerFileTable(uint32_t size) override;
+  void registerFile(os_fd_t fd) override;
+  void unregisterFile(os_fd_t fd) override;
+
+  // The buffer group of the provided buffer ring.
+  static constexpr uint16_t BufferGroupId = 0;
 
 private:
+  // Makes the request refer to the registered file of `fd`, if there is one. The slot of a
+  // registered file is the descriptor itself, so only the flag has to be set.
+  void useRegisteredFile(struct io_uring_sqe* sqe, os_fd_t fd) const;
+
   struct io_uring ring_ {};
   std::vector<struct io_uring_cqe*> cqes_;
   os_fd_t event_fd_{INVALID_SOCKET};
   std::list<InjectedCompletion> injected_completions_;
+  ProvidedBufferRing* buffer_ring_{nullptr};
+  // Indexed by file descriptor. Empty if there is no file table.
+  std::vector<bool> registered_files_;
 };
 
 } // namespace Io
@@ -1,5 +1,7 @@
 #include "source/common/io/io_uring_worker_impl.h"
 
+#include "source/common/api/os_sys_calls_impl.h"
+
 namespace Envoy {
 namespace Io {
 
@@ -60,14 +62,30 @@ void IoUringSocketEntry::onRemoteClose() {
 
 IoUringWorkerImpl::IoUringWorkerImpl(uint32_t io_uring_size, bool use_submission_queue_polling,
                                      uint32_t read_buffer_size, uint32_t write_timeout_ms,
-                                     Event::Dispatcher& dispatcher)
+                                     Event::Dispatcher& dispatcher, uint32_t read_buffer_ring_size)
     : IoUringWorkerImpl(std::make_unique<IoUringImpl>(io_uring_size, use_submission_queue_polling),
-                        read_buffer_size, write_timeout_ms, dispatcher) {}
+                        read_buffer_size, write_timeout_ms, dispatcher, read_buffer_ring_size) {}
 
 IoUringWorkerImpl::IoUringWorkerImpl(IoUringPtr&& io_uring, uint32_t read_buffer_size,
-                                     uint32_t write_timeout_ms, Event::Dispatcher& dispatcher)
+                                     uint32_t write_timeout_ms, Event::Dispatcher& dispatcher,
+                                     uint32_t read_buffer_ring_size)
     : io_uring_(std::move(io_uring)), read_buffer_size_(read_buffer_size),
       write_timeout_ms_(write_timeout_ms), dispatcher_(dispatcher) {
+  if (read_buffer_ring_size > 0) {
+    // The kernel requires a power of two number of provided buffers, of at most 32768.
+    uint32_t buffer_count = 1;
+    while (buffer_count < std::min<uint32_t>(read_buffer_ring_size, 32768)) {
+      buffer_count <<= 1;
+    }
+    multishot_ = io_uring_->registerBufferRing(buffer_count, read_buffer_size_);
+    multishot_recv_ = multishot_;
+    if (multishot_) {
+      use_registered_files_ = io_uring_->registerFileTable(RegisteredFileTableSize);
+    }
+    ENVOY_LOG(debug, "io_uring worker multishot = {}, registered files = {}", multishot_,
+              use_registered_files_);
+  }
+
   const os_fd_t event_fd = io_uring_->registerEventfd();
   // We only care about the read event of Eventfd, since we only receive the
   // event here.
@@ -127,6 +145,22 @@ IoUringSocket& IoUringWorkerImpl::addClientSocket(os_fd_t fd, Event::FileReadyCb
   return addSocket(std::move(socket));
 }
 
+IoUringSocket& IoUringWorkerImpl::addAcceptSocket(os_fd_t fd, Event::FileReadyCb cb) {
+  ENVOY_LOG(trace, "add accept socket, fd = {}", fd);
+  ASSERT(multishot_);
+  std::unique_ptr<IoUringAcceptSocket> socket =
+      std::make_unique<IoUringAcceptSocket>(fd, *this, std::move(cb));
+  // Only listening sockets are registered. Registering a connection costs a file table update
+  // syscall when it is added and another one when it is removed, which is more than a short lived
+  // connection saves, since its multishot receive request only looks the descriptor up once.
+  if (use_registered_files_) {
+    io_uring_->registerFile(fd);
+  }
+  IoUringSocketEntry& entry = addSocket(std::move(socket));
+  entry.enableRead();
+  return entry;
+}
+
 Event::Dispatcher& IoUringWorkerImpl::dispatcher() { return dispatcher_; }
 
 IoUringSocketEntry& IoUringWorkerImpl::addSocket(IoUringSocketEntryPtr&& socket) {
@@ -152,7 +186,44 @@ IoUringWorkerImpl::submitConnectRequest(IoUringSocket& socket,
   return req;
 }
 
+Request* IoUringWorkerImpl::submitAcceptRequest(IoUringSocket& socket) {
+  Request* req = new Request(Request::RequestType::Accept, socket);
+
+  ENVOY_LOG(trace, "submit accept request, fd = {}, accept req = {}", socket.fd(), fmt::ptr(req));
+
+  auto res = io_uring_->prepareAcceptMultishot(socket.fd(), req);
+  if (res == IoUringResult::Failed) {
+    // TODO(rojkov): handle `EBUSY` in case the completion queue is never reaped.
+    submit();
+    res = io_uring_->prepareAcceptMultishot(socket.fd(), req);
+    RELEASE_ASSERT(res == IoUringResult::Ok, "unable to prepare multishot accept");
+  }
+  submit();
+  return req;
+}
+
 Request* IoUringWorkerImpl::submitReadRequest(IoUringSocket& socket) {
+  if (!multishot_recv_) {
+    return submitSingleShotReadRequest(socket);
+  }
+
+  Request* req = new Request(Request::RequestType::Read, socket);
+
+  ENVOY_LOG(trace, "submit multishot recv request, fd = {}, read req = {}", socket.fd(),
+            fmt::ptr(req));
+
+  auto res = io_uring_->prepareRecvMultishot(socket.fd(), req);
+  if (res == IoUringResult::Failed) {
+    // TODO(rojkov): handle `EBUSY` in case the completion queue is never reaped.
+    submit();
+    res = io_uring_->prepareRecvMultishot(socket.fd(), req);
+    RELEASE_ASSERT(res == IoUringResult::Ok, "unable to prepare multishot recv");
+  }
+  submit();
+  return req;
+}
+
+Request* IoUringWorkerImpl::submitSingleShotReadRequest(IoUringSocket& socket) {
   ReadRequest* req = new ReadRequest(socket, read_buffer_size_);
 
   ENVOY_LOG(trace, "submit read request, fd = {}, read req = {}", socket.fd(), fmt::ptr(req));
@@ -235,12 +306,27 @@ Request* IoUringWorkerImpl::submitShutdownRequest(IoUringSocket& socket, int how
   return req;
 }
 
+void IoUringWorkerImpl::disableMultishotRecv() {
+  if (multishot_recv_) {
+    ENVOY_LOG(warn, "multishot recv is not supported by the kernel, using single shot reads");
+    multishot_recv_ = false;
+  }
+}
+
 IoUringSocketEntryPtr IoUringWorkerImpl::removeSocket(IoUringSocketEntry& socket) {
   // Remove all the injection completion for this socket.
   io_uring_->removeInjectedCompletion(socket.fd());
+  // The descriptor may be kept open and move to another worker.
+  unregisterFile(socket.fd());
   return socket.removeFromList(sockets_);
 }
 
+void IoUringWorkerImpl::unregisterFile(os_fd_t fd) {
+  if (use_registered_files_) {
+    io_uring_->unregisterFile(fd);
+  }
+}
+
 void IoUringWorkerImpl::injectCompletion(IoUringSocket& socket, Request::RequestType type,
                                          int32_t result) {
   Request* req = new Request(type, socket);
@@ -294,7 +380,10 @@ void IoUringWorkerImpl::onFileEvent() {
       break;
     }
 
-    delete req;
+    // A multishot request stays armed until its last completion.
+    if (!(req->completionFlags() & IORING_CQE_F_MORE)) {
+      delete req;
+    }
   });
   delay_submit_ = false;
   submit();
@@ -333,12 +422,13 @@ void IoUringServerSocket::close(bool keep_fd_open, IoUringSocketOnClosedCb cb) {
   keep_fd_open_ = keep_fd_open;
 
   // Delay close until read request and write (or shutdown) request are drained.
-  if (read_req_ == nullptr && write_or_shutdown_req_ == nullptr) {
+  if (read_req_ == nullptr && write_or_shutdown_req_ == nullptr && read_cancel_req_ == nullptr) {
     closeInternal();
     return;
   }
 
-  if (read_req_ != nullptr) {
+  // The multishot receive request may already be cancelled since reads were disabled.
+  if (read_req_ != nullptr && read_cancel_req_ == nullptr) {
     ENVOY_LOG(trace, "cancel the read request, fd = {}", fd_);
     read_cancel_req_ = parent_.submitCancelRequest(*this, read_req_);
   }
@@ -372,7 +462,19 @@ void IoUringServerSocket::enableRead() {
   submitReadRequest();
 }
 
-void IoUringServerSocket::disableRead() { IoUringSocketEntry::disableRead(); }
+void IoUringServerSocket::disableRead() {
+  IoUringSocketEntry::disableRead();
+  ENVOY_LOG(trace, "disable read, fd = {}", fd_);
+
+  // A multishot receive request would keep moving data into the read buffer, and keep taking
+  // buffers of the provided buffer ring shared by the sockets of the worker, while the handler
+  // doesn't read. Cancel it, and watch for the remote close with single shot reads until reads
+  // are enabled again.
+  if (read_req_ != nullptr && read_multishot_ && read_cancel_req_ == nullptr) {
+    ENVOY_LOG(trace, "cancel the multishot read request, fd = {}", fd_);
+    read_cancel_req_ = parent_.submitCancelRequest(*this, read_req_);
+  }
+}
 
 void IoUringServerSocket::write(Buffer::Instance& data) {
   ENVOY_LOG(trace, "write, buffer size = {}, fd = {}", data.length(), fd_);
@@ -429,6 +531,14 @@ void IoUringServerSocket::onCancel(Request* req, int32_t result, bool injected)
 }
 
 void IoUringServerSocket::moveReadDataToBuffer(Request* req, size_t data_length) {
+  // Data received by a multishot request lives in a buffer of the provided buffer ring.
+  if (req->completionFlags() & IORING_CQE_F_BUFFER) {
+    parent_.takeProvidedBuffer(
+        static_cast<uint16_t>(req->completionFlags() >> IORING_CQE_BUFFER_SHIFT), data_length,
+        read_buf_);
+    return;
+  }
+
   ReadRequest* read_req = static_cast<ReadRequest*>(req);
   Buffer::BufferFragment* fragment = new Buffer::BufferFragmentImpl(
       read_req->buf_.release(), data_length,
@@ -439,6 +549,13 @@ void IoUringServerSocket::moveReadDataToBuffer(Request* req, size_t data_length)
   read_buf_.addBufferFragment(*fragment);
 }
 
+void IoUringServerSocket::discardReadData(Request* req) {
+  if (req->completionFlags() & IORING_CQE_F_BUFFER) {
+    parent_.recycleProvidedBuffer(
+        static_cast<uint16_t>(req->completionFlags() >> IORING_CQE_BUFFER_SHIFT));
+  }
+}
+
 void IoUringServerSocket::onReadCompleted(int32_t result) {
   ENVOY_LOG(trace, "read from socket, fd = {}, result = {}", fd_, result);
   ReadParam param{read_buf_, result};
@@ -456,13 +573,32 @@ void IoUringServerSocket::onRead(Request* req, int32_t result, bool injected) {
   ENVOY_LOG(trace,
             "onRead with result {}, fd = {}, injected = {}, status_ = {}, enable_close_event = {}",
             result, fd_, injected, static_cast<int>(status_), enable_close_event_);
+  // Whether the multishot receive request ended without an error of the socket, in which case a
+  // new read request is submitted.
+  bool rearm_read = false;
   if (!injected) {
-    read_req_ = nullptr;
+    // A multishot receive request stays armed as long as its completions carry
+    // IORING_CQE_F_MORE.
+    const bool request_done = !(req->completionFlags() & IORING_CQE_F_MORE);
+    if (request_done) {
+      read_req_ = nullptr;
+    }
+    // A multishot receive ends with ENOBUFS when the provided buffer ring ran dry, and with EINVAL
+    // on kernels which don't support it. The next read then uses a buffer of its own.
+    if (request_done && read_multishot_ && (result == -ENOBUFS || result == -EINVAL)) {
+      if (result == -EINVAL) {
+        parent_.disableMultishotRecv();
+      }
+      single_shot_read_ = true;
+      rearm_read = true;
+    }
     // If the socket is going to close, discard all results.
-    if (status_ == Closed && write_or_shutdown_req_ == nullptr && read_cancel_req_ == nullptr &&
-        write_or_shutdown_cancel_req_ == nullptr) {
+    if (status_ == Closed && read_req_ == nullptr && write_or_shutdown_req_ == nullptr &&
+        read_cancel_req_ == nullptr && write_or_shutdown_cancel_req_ == nullptr) {
       if (result > 0 && keep_fd_open_) {
         moveReadDataToBuffer(req, result);
+      } else if (result > 0) {
+        discardReadData(req);
       }
       closeInternal();
       return;
@@ -473,7 +609,7 @@ void IoUringServerSocket::onRead(Request* req, int32_t result, bool injected) {
   if (result > 0) {
     moveReadDataToBuffer(req, result);
   } else {
-    if (result != -ECANCELED) {
+    if (result != -ECANCELED && !rearm_read) {
       read_error_ = result;
     }
   }
@@ -540,8 +676,9 @@ void IoUringServerSocket::onRead(Request* req, int32_t result, bool injected) {
     }
   } else if (status_ == ReadDisabled) {
     // Since error in a disabled socket will not be handled by the handler, stop submit read
-    // request if there is any error.
-    if (!read_error_.has_value()) {
+    // request if there is any error. Also stop once a read buffer worth of data is waiting for
+    // the handler, so that a peer which keeps sending can't grow the read buffer without limit.
+    if (!read_error_.has_value() && read_buf_.length() < parent_.readBufferSize()) {
       // Submit a read request for monitoring the remote close event, otherwise there is no
       // way to know the connection is closed by the remote.
       submitReadRequest();
@@ -622,7 +759,14 @@ void IoUringServerSocket::closeInternal() {
 
 void IoUringServerSocket::submitReadRequest() {
   if (!read_req_) {
-    read_req_ = parent_.submitReadRequest(*this);
+    if (single_shot_read_ || status_ == ReadDisabled || !parent_.multishotRecvEnabled()) {
+      read_req_ = parent_.submitSingleShotReadRequest(*this);
+      read_multishot_ = false;
+      single_shot_read_ = false;
+    } else {
+      read_req_ = parent_.submitReadRequest(*this);
+      read_multishot_ = true;
+    }
   }
 }
 
@@ -642,6 +786,162 @@ void IoUringServerSocket::submitWriteOrShutdownRequest() {
   }
 }
 
+IoUringAcceptSocket::IoUringAcceptSocket(os_fd_t fd, IoUringWorkerImpl& parent,
+                                         Event::FileReadyCb cb)
+    : IoUringSocketEntry(fd, parent, std::move(cb), false) {}
+
+IoUringAcceptSocket::~IoUringAcceptSocket() { closeAcceptedSockets(); }
+
+void IoUringAcceptSocket::close(bool keep_fd_open, IoUringSocketOnClosedCb cb) {
+  ENVOY_LOG(trace, "close the accept socket, fd = {}, status = {}", fd_,
+            static_cast<int>(status_));
+
+  IoUringSocketEntry::close(keep_fd_open, cb);
+  keep_fd_open_ = keep_fd_open;
+  closeAcceptedSockets();
+  // Drop the registered file right away rather than once the accept request is drained. The
+  // owner may close a kept open descriptor before that, and a socket reusing its number must not
+  // find the slot still taken by the old file.
+  parent_.unregisterFile(fd_);
+
+  // Delay close until the accept request is drained.
+  if (accept_req_ == nullptr && accept_cancel_req_ == nullptr) {
+    closeInternal();
+    return;
+  }
+  cancelAcceptRequest();
+}
+
+void IoUringAcceptSocket::enableRead() {
+  IoUringSocketEntry::enableRead();
+  ENVOY_LOG(trace, "enable accept, fd = {}", fd_);
+
+  // Deliver the connections which were accepted before the socket got disabled.
+  if (!accepted_sockets_.empty()) {
+    injectCompletion(Request::RequestType::Accept);
+  }
+  submitAcceptRequest();
+}
+
+void IoUringAcceptSocket::disableRead() {
+  IoUringSocketEntry::disableRead();
+  ENVOY_LOG(trace, "disable accept, fd = {}", fd_);
+
+  // Stop accepting, so that new connections wait in the listen backlog as they would for a
+  // disabled listener on the libevent path.
+  cancelAcceptRequest();
+}
+
+void IoUringAcceptSocket::onAccept(Request* req, int32_t result, bool injected) {
+  IoUringSocketEntry::onAccept(req, result, injected);
+
+  ENVOY_LOG(trace, "onAccept with result {}, fd = {}, injected = {}, status_ = {}", result, fd_,
+            injected, static_cast<int>(status_));
+  if (!injected) {
+    // The multishot accept request stays armed as long as its completions carry
+    // IORING_CQE_F_MORE.
+    if (!(req->completionFlags() & IORING_CQE_F_MORE)) {
+      accept_req_ = nullptr;
+    }
+    if (result >= 0) {
+      if (status_ == Closed) {
+        Api::OsSysCallsSingleton::get().close(result);
+      } else {
+        accepted_sockets_.push_back(result);
+      }
+    } else if (result != -ECANCELED) {
+      ENVOY_LOG(debug, "accept error, fd = {}, error = {}", fd_, errorDetails(-result));
+    }
+
+    if (status_ == Closed) {
+      if (accept_req_ == nullptr && accept_cancel_req_ == nullptr) {
+        closeInternal();
+      }
+      return;
+    }
+  }
+
+  if (status_ != ReadEnabled) {
+    return;
+  }
+
+  // An injected completion emulates a read event, so it is delivered even without a connection.
+  if (injected || !accepted_sockets_.empty()) {
+    THROW_IF_NOT_OK(cb_(Event::FileReadyType::Read));
+  }
+
+  // The handler may have disabled or closed the socket.
+  if (status_ == ReadEnabled) {
+    // The handler may only accept a limited number of connections per event. Unlike a level
+    // triggered file event, nothing else reports the remaining ones.
+    if (!accepted_sockets_.empty()) {
+      injectCompletion(Request::RequestType::Accept);
+    }
+    submitAcceptRequest();
+  }
+}
+
+void IoUringAcceptSocket::onClose(Request* req, int32_t result, bool injected) {
+  IoUringSocketEntry::onClose(req, result, injected);
+  ASSERT(!injected);
+  cleanup();
+}
+
+void IoUringAcceptSocket::onCancel(Request* req, int32_t result, bool injected) {
+  IoUringSocketEntry::onCancel(req, result, injected);
+  ASSERT(!injected);
+  if (accept_cancel_req_ == req) {
+    accept_cancel_req_ = nullptr;
+  }
+  if (status_ == Closed && accept_req_ == nullptr && accept_cancel_req_ == nullptr) {
+    closeInternal();
+  }
+}
+
+os_fd_t IoUringAcceptSocket::popAcceptedSocket() {
+  if (accepted_sockets_.empty()) {
+    return INVALID_SOCKET;
+  }
+  const os_fd_t fd = accepted_sockets_.front();
+  accepted_sockets_.pop_front();
+  return fd;
+}
+
+void IoUringAcceptSocket::submitAcceptRequest() {
+  if (accept_req_ == nullptr) {
+    accept_req_ = parent_.submitAcceptRequest(*this);
+  }
+}
+
+void IoUringAcceptSocket::cancelAcceptRequest() {
+  if (accept_req_ != nullptr && accept_cancel_req_ == nullptr) {
+    ENVOY_LOG(trace, "cancel the accept request, fd = {}", fd_);
+    accept_cancel_req_ = parent_.submitCancelRequest(*this, accept_req_);
+  }
+}
+
+void IoUringAcceptSocket::closeAcceptedSockets() {
+  for (const os_fd_t fd : accepted_sockets_) {
+    Api::OsSysCallsSingleton::get().close(fd);
+  }
+  accepted_sockets_.clear();
+}
+
+void IoUringAcceptSocket::closeInternal() {
+  closeAcceptedSockets();
+  if (keep_fd_open_) {
+    if (on_closed_cb_) {
+      Buffer::OwnedImpl empty_buffer;
+      on_closed_cb_(empty_buffer);
+    }
+    cleanup();
+    return;
+  }
+  if (close_req_ == nullptr) {
+    close_req_ = parent_.submitCloseRequest(*this);
+  }
+}
+
 IoUringClientSocket::IoUringClientSocket(os_fd_t fd, IoUringWorkerImpl& parent,
                                          Event::FileReadyCb cb, uint32_t write_timeout_ms,
                                          bool enable_close_event)
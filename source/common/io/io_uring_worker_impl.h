@@ -1,5 +1,7 @@
 #pragma once
 
+#include <deque>
+
 #include "envoy/common/io/io_uring.h"
 
 #include "source/common/buffer/buffer_impl.h"
@@ -30,13 +32,22 @@ using IoUringSocketEntryPtr = std::unique_ptr<IoUringSocketEntry>;
 
 class IoUringWorkerImpl : public IoUringWorker, private Logger::Loggable<Logger::Id::io> {
 public:
+  /**
+   * @param read_buffer_ring_size the number of buffers of `read_buffer_size` bytes in the provided
+   * buffer ring of the worker, rounded up to a power of two. A non-zero size enables multishot
+   * accept and receive requests, as well as registered file descriptors, if the kernel supports
+   * them. Zero keeps one single shot request per read.
+   */
   IoUringWorkerImpl(uint32_t io_uring_size, bool use_submission_queue_polling,
                     uint32_t read_buffer_size, uint32_t write_timeout_ms,
-                    Event::Dispatcher& dispatcher);
+                    Event::Dispatcher& dispatcher, uint32_t read_buffer_ring_size = 0);
   IoUringWorkerImpl(IoUringPtr&& io_uring, uint32_t read_buffer_size, uint32_t write_timeout_ms,
-                    Event::Dispatcher& dispatcher);
+                    Event::Dispatcher& dispatcher, uint32_t read_buffer_ring_size = 0);
   ~IoUringWorkerImpl() override;
 
+  // The number of slots of the registered file table. Descriptors beyond it are used unregistered.
+  static constexpr uint32_t RegisteredFileTableSize = 65536;
+
   // IoUringWorker
   IoUringSocket& addServerSocket(os_fd_t fd, Event::FileReadyCb cb,
                                  bool enable_close_event) override;
@@ -44,9 +55,12 @@ public:
                                  bool enable_close_event) override;
   IoUringSocket& addClientSocket(os_fd_t fd, Event::FileReadyCb cb,
                                  bool enable_close_event) override;
+  IoUringSocket& addAcceptSocket(os_fd_t fd, Event::FileReadyCb cb) override;
+  bool supportsMultishot() const override { return multishot_; }
 
   Request* submitConnectRequest(IoUringSocket& socket,
                                 const Network::Address::InstanceConstSharedPtr& address) override;
+  Request* submitAcceptRequest(IoUringSocket& socket) override;
   Request* submitReadRequest(IoUringSocket& socket) override;
   Request* submitWriteRequest(IoUringSocket& socket, const Buffer::RawSliceVector& slices) override;
   Request* submitCloseRequest(IoUringSocket& socket) override;
@@ -64,6 +78,23 @@ public:
   // Return the number of sockets in this worker.
   uint32_t getNumOfSockets() const override { return sockets_.size(); }
 
+  // Submit a read request into a buffer of its own, even if multishot receive is enabled.
+  Request* submitSingleShotReadRequest(IoUringSocket& socket);
+  // Return whether read requests are submitted as multishot receive requests.
+  bool multishotRecvEnabled() const { return multishot_recv_; }
+  // Return the size of the buffer of a read request.
+  uint32_t readBufferSize() const { return read_buffer_size_; }
+  // Fall back to single shot read requests, after the kernel rejected a multishot receive.
+  void disableMultishotRecv();
+  // Hand the provided buffer of a receive completion over to a buffer, or give it back to the
+  // ring.
+  void takeProvidedBuffer(uint16_t buffer_id, uint32_t length, Buffer::Instance& buffer) {
+    io_uring_->takeProvidedBuffer(buffer_id, length, buffer);
+  }
+  void recycleProvidedBuffer(uint16_t buffer_id) { io_uring_->recycleProvidedBuffer(buffer_id); }
+  // Remove a descriptor from the registered file table, if it is registered.
+  void unregisterFile(os_fd_t fd);
+
 protected:
   // Add a socket to the worker.
   IoUringSocketEntry& addSocket(IoUringSocketEntryPtr&& socket);
@@ -84,6 +115,13 @@ protected:
   // The IoUringWorker will delay the submit the requests which are submitted in request completion
   // callback.
   bool delay_submit_{false};
+  // Whether a provided buffer ring is registered, which enables multishot requests.
+  bool multishot_{false};
+  // Whether read requests are multishot receive requests.
+  bool multishot_recv_{false};
+  // Whether the listening sockets of this worker are registered in the file table of the
+  // io_uring.
+  bool use_registered_files_{false};
 };
 
 class IoUringSocketEntry : public IoUringSocket,
@@ -152,6 +190,8 @@ public:
 
   void setFileReadyCb(Event::FileReadyCb cb) override { cb_ = std::move(cb); }
 
+  os_fd_t popAcceptedSocket() override { return INVALID_SOCKET; }
+
 protected:
   /**
    * For the socket to remove itself from the IoUringWorker and defer deletion.
@@ -242,15 +282,57 @@ protected:
   Request* write_or_shutdown_cancel_req_{nullptr};
   // This is used for tracking the close request.
   Request* close_req_{nullptr};
+  // Whether read_req_ is a multishot receive request, which stays armed over several completions.
+  // It is cancelled when reads are disabled, and single shot reads are used until reads are
+  // enabled again.
+  bool read_multishot_{false};
+  // Submit the next read into a buffer of its own, since the provided buffer ring ran dry.
+  bool single_shot_read_{false};
 
   void closeInternal();
   void submitReadRequest();
   void submitWriteOrShutdownRequest();
   void moveReadDataToBuffer(Request* req, size_t data_length);
+  // Drop the data of a read completion, giving its provided buffer (if any) back to the ring.
+  void discardReadData(Request* req);
   void onReadCompleted(int32_t result);
   void onWriteCompleted(int32_t result);
 };
 
+/**
+ * A listening socket which accepts connections with a single multishot accept request. Accepted
+ * connections are queued until the handler pops them with popAcceptedSocket().
+ */
+class IoUringAcceptSocket : public IoUringSocketEntry {
+public:
+  IoUringAcceptSocket(os_fd_t fd, IoUringWorkerImpl& parent, Event::FileReadyCb cb);
+  ~IoUringAcceptSocket() override;
+
+  // IoUringSocket
+  void close(bool keep_fd_open, IoUringSocketOnClosedCb cb = nullptr) override;
+  void enableRead() override;
+  void disableRead() override;
+  void write(Buffer::Instance&) override { PANIC("not implemented"); }
+  uint64_t write(const Buffer::RawSlice*, uint64_t) override { PANIC("not implemented"); }
+  void shutdown(int) override { PANIC("not implemented"); }
+  void onAccept(Request* req, int32_t result, bool injected) override;
+  void onClose(Request* req, int32_t result, bool injected) override;
+  void onCancel(Request* req, int32_t result, bool injected) override;
+  os_fd_t popAcceptedSocket() override;
+
+private:
+  void submitAcceptRequest();
+  void cancelAcceptRequest();
+  void closeAcceptedSockets();
+  void closeInternal();
+
+  Request* accept_req_{nullptr};
+  Request* accept_cancel_req_{nullptr};
+  Request* close_req_{nullptr};
+  bool keep_fd_open_{false};
+  std::deque<os_fd_t> accepted_sockets_;
+};
+
 class IoUringClientSocket : public IoUringServerSocket {
 public:
   IoUringClientSocket(os_fd_t fd, IoUringWorkerImpl& parent, Event::FileReadyCb cb,
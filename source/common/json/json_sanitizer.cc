@@ -6,6 +6,12 @@
 
 #include "absl/strings/str_format.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 namespace Envoy {
 namespace Json {
 
@@ -96,6 +102,150 @@ absl::string_view sanitize(std::string& buffer, absl::string_view str) {
   return buffer;
 }
 
+namespace {
+
+// Control characters, double-quote and backslash are escaped, and the bytes of multi-byte utf-8
+// sequences are validated.
+inline bool needsEscape(uint8_t c) { return c < 0x20 || c == '"' || c == '\\' || c >= 0x80; }
+
+// Returns the position of the first character of str at or after start which needs an escape or
+// a utf-8 validation, or str.size() if there is none.
+size_t findEscape(absl::string_view str, size_t start) {
+  const uint8_t* data = reinterpret_cast<const uint8_t*>(str.data());
+  const size_t size = str.size();
+  size_t i = start;
+
+#if defined(__SSE2__)
+  const __m128i max_control = _mm_set1_epi8(0x1f);
+  const __m128i quote = _mm_set1_epi8('"');
+  const __m128i backslash = _mm_set1_epi8('\\');
+  for (; i + 16 <= size; i += 16) {
+    const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+    // An unsigned byte is a control character iff min(byte, 0x1f) == byte.
+    const __m128i escape =
+        _mm_or_si128(_mm_cmpeq_epi8(_mm_min_epu8(chunk, max_control), chunk),
+                     _mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash)));
+    // Bytes with their high bit set start or continue a multi-byte utf-8 sequence.
+    const int mask = _mm_movemask_epi8(escape) | _mm_movemask_epi8(chunk);
+    if (mask != 0) {
+      return i + __builtin_ctz(mask);
+    }
+  }
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+  const uint8x16_t max_control = vdupq_n_u8(0x1f);
+  const uint8x16_t quote = vdupq_n_u8('"');
+  const uint8x16_t backslash = vdupq_n_u8('\\');
+  const uint8x16_t min_multi_byte = vdupq_n_u8(0x80);
+  for (; i + 16 <= size; i += 16) {
+    const uint8x16_t chunk = vld1q_u8(data + i);
+    const uint8x16_t escape =
+        vorrq_u8(vorrq_u8(vcleq_u8(chunk, max_control), vcgeq_u8(chunk, min_multi_byte)),
+                 vorrq_u8(vceqq_u8(chunk, quote), vceqq_u8(chunk, backslash)));
+    if (vmaxvq_u8(escape) != 0) {
+      break;
+    }
+  }
+#endif
+
+  for (; i < size; ++i) {
+    if (needsEscape(data[i])) {
+      return i;
+    }
+  }
+  return size;
+}
+
+// Returns the length of the utf-8 sequence starting at str[start], which has its high bit set. If
+// the sequence is invalid, returns the length of its maximal prefix which could start a valid
+// sequence, at least 1, and sets valid to false. These are the boundaries of Unicode's "maximal
+// subparts", at which invalid sequences are replaced.
+size_t utf8SequenceLength(absl::string_view str, size_t start, bool& valid) {
+  const uint8_t* data = reinterpret_cast<const uint8_t*>(str.data()) + start;
+  const size_t size = str.size() - start;
+  // Ranges of the second byte which exclude overlong encodings, surrogates and code points above
+  // U+10FFFF.
+  uint8_t lower = 0x80;
+  uint8_t upper = 0xbf;
+  size_t length;
+  if (data[0] >= 0xc2 && data[0] <= 0xdf) {
+    length = 2;
+  } else if (data[0] >= 0xe0 && data[0] <= 0xef) {
+    length = 3;
+    lower = data[0] == 0xe0 ? 0xa0 : lower;
+    upper = data[0] == 0xed ? 0x9f : upper;
+  } else if (data[0] >= 0xf0 && data[0] <= 0xf4) {
+    length = 4;
+    lower = data[0] == 0xf0 ? 0x90 : lower;
+    upper = data[0] == 0xf4 ? 0x8f : upper;
+  } else {
+    valid = false;
+    return 1;
+  }
+  for (size_t i = 1; i < length; ++i) {
+    if (i >= size || data[i] < lower || data[i] > upper) {
+      valid = false;
+      return i;
+    }
+    lower = 0x80;
+    upper = 0xbf;
+  }
+  valid = true;
+  return length;
+}
+
+} // namespace
+
+void appendEscaped(std::string& output, absl::string_view str) {
+  size_t pos = 0;
+  while (pos < str.size()) {
+    const size_t escape = findEscape(str, pos);
+    output.append(str.data() + pos, escape - pos);
+    if (escape == str.size()) {
+      break;
+    }
+    const char c = str[escape];
+    if (static_cast<uint8_t>(c) >= 0x80) {
+      bool valid;
+      const size_t length = utf8SequenceLength(str, escape, valid);
+      if (valid) {
+        output.append(str.data() + escape, length);
+      } else {
+        // U+FFFD REPLACEMENT CHARACTER, as written by the JSON serializer.
+        output.append("\xef\xbf\xbd");
+      }
+      pos = escape + length;
+      continue;
+    }
+    switch (c) {
+    case '"':
+      output.append("\\\"");
+      break;
+    case '\\':
+      output.append("\\\\");
+      break;
+    case '\b':
+      output.append("\\b");
+      break;
+    case '\f':
+      output.append("\\f");
+      break;
+    case '\n':
+      output.append("\\n");
+      break;
+    case '\r':
+      output.append("\\r");
+      break;
+    case '\t':
+      output.append("\\t");
+      break;
+    default:
+      absl::StrAppendFormat(&output, "\\u%04x", static_cast<uint8_t>(c));
+      break;
+    }
+    pos = escape + 1;
+  }
+}
+
 absl::string_view stripDoubleQuotes(absl::string_view str) {
   if (str.size() >= 2 && str[0] == '"' && str[str.size() - 1] == '"') {
     str = str.substr(1, str.size() - 2);
@@ -37,6 +37,19 @@ namespace Json {
  */
 absl::string_view sanitize(std::string& buffer, absl::string_view str);
 
+/**
+ * Appends str to output, escaped for a double-quoted JSON context, without the surrounding
+ * double-quotes. Double-quote, backslash and control characters are escaped, and valid utf-8
+ * sequences are copied as they are. Invalid utf-8 is replaced with U+FFFD, like
+ * Json::Object::asJsonString() does. Unlike sanitize() this never throws, so it can be used on
+ * worker threads. The string is scanned 16 bytes at a time for characters requiring an escape or
+ * a validation, so ASCII strings which don't need escaping are copied with a single append.
+ *
+ * @param output the string to append to.
+ * @param str the string to escape.
+ */
+void appendEscaped(std::string& output, absl::string_view str);
+
 /**
  * Strips double-quotes on first and last characters of str. It's a
  * precondition to call this on a string that is surrounded by double-quotes.
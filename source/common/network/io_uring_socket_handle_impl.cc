@@ -40,8 +40,9 @@ IoUringSocketHandleImpl::~IoUringSocketHandleImpl() {
   // TODO(zhxie): for current usage of server socket and client socket, the check may be
   // redundant.
   if (io_uring_socket_type_ != IoUringSocketType::Unknown &&
-      io_uring_socket_type_ != IoUringSocketType::Accept &&
       io_uring_worker_factory_.currentThreadRegistered() && io_uring_socket_.has_value()) {
+    // A listening socket is only attached to the worker while it accepts with a multishot accept
+    // request. The worker closes the descriptor once the request is cancelled.
     if (io_uring_socket_->getStatus() != Io::IoUringSocketStatus::Closed) {
       io_uring_socket_.ref().close(false);
     }
@@ -57,13 +58,14 @@ Api::IoCallUint64Result IoUringSocketHandleImpl::close() {
 
   ASSERT(SOCKET_VALID(fd_));
 
-  if (io_uring_socket_type_ == IoUringSocketType::Unknown ||
-      io_uring_socket_type_ == IoUringSocketType::Accept || !io_uring_socket_.has_value()) {
+  if (io_uring_socket_type_ == IoUringSocketType::Unknown || !io_uring_socket_.has_value()) {
     if (file_event_) {
       file_event_.reset();
     }
     ::close(fd_);
   } else {
+    // The worker closes the descriptor once the pending requests are cancelled, which for a
+    // listening socket is its multishot accept request.
     io_uring_socket_.ref().close(false);
     io_uring_socket_.reset();
   }
@@ -186,6 +188,25 @@ IoHandlePtr IoUringSocketHandleImpl::accept(struct sockaddr* addr, socklen_t* ad
 
   ASSERT(io_uring_socket_type_ == IoUringSocketType::Accept);
 
+  if (io_uring_socket_.has_value()) {
+    // The connection was accepted by a multishot accept request, which doesn't report the peer
+    // address.
+    while (true) {
+      const os_fd_t fd = io_uring_socket_->popAcceptedSocket();
+      if (SOCKET_INVALID(fd)) {
+        return nullptr;
+      }
+      if (addr != nullptr &&
+          Api::OsSysCallsSingleton::get().getpeername(fd, addr, addrlen).return_value_ != 0) {
+        // The peer is already gone.
+        ::close(fd);
+        continue;
+      }
+      return std::make_unique<IoUringSocketHandleImpl>(io_uring_worker_factory_, fd,
+                                                       socket_v6only_, domain_, true);
+    }
+  }
+
   Envoy::Api::SysCallSocketResult result =
       Api::OsSysCallsSingleton::get().accept(fd_, addr, addrlen);
   if (SOCKET_INVALID(result.return_value_)) {
@@ -277,7 +298,12 @@ void IoUringSocketHandleImpl::initializeFileEvent(Event::Dispatcher& dispatcher,
 
   switch (io_uring_socket_type_) {
   case IoUringSocketType::Accept:
-    file_event_ = dispatcher.createFileEvent(fd_, cb, trigger, events);
+    if (io_uring_worker_factory_.getIoUringWorker()->supportsMultishot()) {
+      io_uring_socket_ =
+          io_uring_worker_factory_.getIoUringWorker()->addAcceptSocket(fd_, std::move(cb));
+    } else {
+      file_event_ = dispatcher.createFileEvent(fd_, cb, trigger, events);
+    }
     break;
   case IoUringSocketType::Server:
     io_uring_socket_ = io_uring_worker_factory_.getIoUringWorker()->addServerSocket(
@@ -297,6 +323,12 @@ void IoUringSocketHandleImpl::activateFileEvents(uint32_t events) {
             ioUringSocketTypeStr());
 
   if (io_uring_socket_type_ == IoUringSocketType::Accept) {
+    if (io_uring_socket_.has_value()) {
+      if (events & Event::FileReadyType::Read) {
+        io_uring_socket_->injectCompletion(Io::Request::RequestType::Accept);
+      }
+      return;
+    }
     ASSERT(file_event_ != nullptr);
     file_event_->activate(events);
     return;
@@ -315,6 +347,14 @@ void IoUringSocketHandleImpl::enableFileEvents(uint32_t events) {
             ioUringSocketTypeStr());
 
   if (io_uring_socket_type_ == IoUringSocketType::Accept) {
+    if (io_uring_socket_.has_value()) {
+      if (events & Event::FileReadyType::Read) {
+        io_uring_socket_->enableRead();
+      } else {
+        io_uring_socket_->disableRead();
+      }
+      return;
+    }
     ASSERT(file_event_ != nullptr);
     file_event_->setEnabled(events);
     return;
@@ -332,6 +372,12 @@ void IoUringSocketHandleImpl::resetFileEvents() {
   ENVOY_LOG(trace, "reset file events, fd = {}, type = {}", fd_, ioUringSocketTypeStr());
 
   if (io_uring_socket_type_ == IoUringSocketType::Accept) {
+    if (io_uring_socket_.has_value()) {
+      // The listener goes away on the worker thread, while the socket may be closed later on the
+      // main thread. Detach from the worker now, keeping the descriptor open.
+      io_uring_socket_->close(true);
+      io_uring_socket_.reset();
+    }
     file_event_.reset();
     return;
   }
@@ -544,6 +544,25 @@ Api::IoCallUint64Result Utility::writeToSocket(IoHandle& handle, Buffer::RawSlic
 
 namespace {
 
+// A gso_size segment of the buffer read by a GRO recvmsg call. Each segment holds a reference to
+// that buffer, which is freed once all of its segments are released, possibly by another worker.
+class GroSegmentFragment : public Buffer::BufferFragment {
+public:
+  GroSegmentFragment(std::shared_ptr<const Buffer::Instance> gro_buffer, const void* data,
+                     size_t size)
+      : gro_buffer_(std::move(gro_buffer)), data_(data), size_(size) {}
+
+  // Buffer::BufferFragment
+  const void* data() const override { return data_; }
+  size_t size() const override { return size_; }
+  void done() override { delete this; }
+
+private:
+  const std::shared_ptr<const Buffer::Instance> gro_buffer_;
+  const void* const data_;
+  const size_t size_;
+};
+
 void passPayloadToProcessor(uint64_t bytes_read, Buffer::InstancePtr buffer,
                             Address::InstanceConstSharedPtr peer_addess,
                             Address::InstanceConstSharedPtr local_address,
@@ -607,6 +626,27 @@ Api::IoCallUint64Result readFromSocketRecvGro(IoHandle& handle,
     return result;
   }
 
+  if (Runtime::runtimeFeatureEnabled("envoy.reloadable_features.udp_gro_segments_without_copy")) {
+    // Hand out gso_sized sub buffers which point into the single slice read by the recvmsg
+    // syscall, so that the processor, e.g. QUICHE, reads each datagram in place.
+    const Buffer::RawSlice gro_slice = buffer->frontSlice();
+    ASSERT(gro_slice.len_ == buffer->length());
+    std::shared_ptr<const Buffer::Instance> gro_buffer = std::move(buffer);
+    for (uint64_t offset = 0; offset < gro_slice.len_; offset += gso_size) {
+      const uint64_t segment_size = std::min(gro_slice.len_ - offset, gso_size);
+      Buffer::InstancePtr sub_buffer = std::make_unique<Buffer::OwnedImpl>();
+      sub_buffer->addBufferFragment(*new GroSegmentFragment(
+          gro_buffer, static_cast<const uint8_t*>(gro_slice.mem_) + offset, segment_size));
+      if (num_packets_read != nullptr) {
+        *num_packets_read += 1;
+      }
+      passPayloadToProcessor(segment_size, std::move(sub_buffer), output.msg_[0].peer_address_,
+                             output.msg_[0].local_address_, udp_packet_processor, receive_time,
+                             output.msg_[0].tos_, output.msg_[0].saved_cmsg_);
+    }
+    return result;
+  }
+
   // Segment the buffer read by the recvmsg syscall into gso_sized sub buffers.
   // TODO(mattklein123): The following code should be optimized to avoid buffer copies, either by
   // switching to slices or by using a CoW buffer type.
@@ -0,0 +1,177 @@
+#include "source/common/router/compiled_route_matcher.h"
+
+#include <algorithm>
+
+#include "source/common/common/regex.h"
+#include "source/common/http/path_utility.h"
+#include "source/common/protobuf/utility.h"
+
+#include "absl/strings/ascii.h"
+
+namespace Envoy {
+namespace Router {
+namespace {
+
+// The tries are keyed by the path without the query, the fragment and, when they are ignored, the
+// path parameters. A prefix which contains one of their delimiters can only match the full path,
+// so it is left out of the tries and its route is always evaluated.
+bool prefixFitsTrie(absl::string_view prefix, bool ignore_path_parameters) {
+  return prefix.find_first_of(ignore_path_parameters ? "?#;" : "?#") == absl::string_view::npos;
+}
+
+} // namespace
+
+RoutePathTrie::RoutePathTrie() { nodes_.emplace_back(); }
+
+uint32_t RoutePathTrie::findOrCreate(absl::string_view key) {
+  empty_ = false;
+  uint32_t current = 0;
+  for (const char c : key) {
+    auto& children = nodes_[current].children_;
+    auto it = std::lower_bound(
+        children.begin(), children.end(), c,
+        [](const std::pair<char, uint32_t>& child, char value) { return child.first < value; });
+    if (it != children.end() && it->first == c) {
+      current = it->second;
+      continue;
+    }
+    const uint32_t next = nodes_.size();
+    children.insert(it, {c, next});
+    // Note that this may invalidate `children`, so it must happen after the insertion.
+    nodes_.emplace_back();
+    current = next;
+  }
+  return current;
+}
+
+void RoutePathTrie::addPrefix(absl::string_view prefix, uint32_t route_index) {
+  const uint32_t node = findOrCreate(prefix);
+  nodes_[node].prefix_routes_.push_back(route_index);
+}
+
+void RoutePathTrie::addExact(absl::string_view path, uint32_t route_index) {
+  const uint32_t node = findOrCreate(path);
+  nodes_[node].exact_routes_.push_back(route_index);
+}
+
+const RoutePathTrie::Node* RoutePathTrie::findChild(const Node& node, char c) const {
+  const auto& children = node.children_;
+  auto it = std::lower_bound(
+      children.begin(), children.end(), c,
+      [](const std::pair<char, uint32_t>& child, char value) { return child.first < value; });
+  if (it == children.end() || it->first != c) {
+    return nullptr;
+  }
+  return &nodes_[it->second];
+}
+
+void RoutePathTrie::collect(absl::string_view path,
+                            absl::InlinedVector<uint32_t, 16>& out) const {
+  const Node* node = &nodes_[0];
+  for (const char c : path) {
+    out.insert(out.end(), node->prefix_routes_.begin(), node->prefix_routes_.end());
+    node = findChild(*node, c);
+    if (node == nullptr) {
+      return;
+    }
+  }
+  out.insert(out.end(), node->prefix_routes_.begin(), node->prefix_routes_.end());
+  out.insert(out.end(), node->exact_routes_.begin(), node->exact_routes_.end());
+}
+
+CompiledRouteMatcher::CompiledRouteMatcher(
+    const Protobuf::RepeatedPtrField<envoy::config::route::v3::Route>& routes,
+    bool ignore_path_parameters, Server::Configuration::ServerFactoryContext& factory_context)
+    : ignore_path_parameters_(ignore_path_parameters) {
+  // Only the Google RE2 engine is guaranteed to agree with RE2::Set on what matches.
+  const bool default_engine_is_re2 =
+      dynamic_cast<const Regex::GoogleReEngine*>(&factory_context.regexEngine()) != nullptr;
+  auto regex_set = std::make_unique<re2::RE2::Set>(re2::RE2::Options(re2::RE2::Quiet),
+                                                   re2::RE2::ANCHOR_BOTH);
+  std::vector<uint32_t> regex_routes;
+
+  for (int i = 0; i < routes.size(); ++i) {
+    const uint32_t index = static_cast<uint32_t>(i);
+    const auto& match = routes[i].match();
+    const bool case_sensitive = PROTOBUF_GET_WRAPPED_OR_DEFAULT(match, case_sensitive, true);
+    RoutePathTrie& trie = case_sensitive ? case_sensitive_trie_ : case_insensitive_trie_;
+
+    switch (match.path_specifier_case()) {
+    case envoy::config::route::v3::RouteMatch::PathSpecifierCase::kPrefix:
+      if (!prefixFitsTrie(match.prefix(), ignore_path_parameters)) {
+        always_routes_.push_back(index);
+        break;
+      }
+      trie.addPrefix(case_sensitive ? match.prefix() : absl::AsciiStrToLower(match.prefix()),
+                     index);
+      break;
+    case envoy::config::route::v3::RouteMatch::PathSpecifierCase::kPathSeparatedPrefix:
+      // The trailing separator check is left to the route itself.
+      trie.addPrefix(case_sensitive ? match.path_separated_prefix()
+                                    : absl::AsciiStrToLower(match.path_separated_prefix()),
+                     index);
+      break;
+    case envoy::config::route::v3::RouteMatch::PathSpecifierCase::kPath:
+      trie.addExact(case_sensitive ? match.path() : absl::AsciiStrToLower(match.path()), index);
+      break;
+    case envoy::config::route::v3::RouteMatch::PathSpecifierCase::kSafeRegex:
+      if ((default_engine_is_re2 || match.safe_regex().has_google_re2()) &&
+          regex_set->Add(match.safe_regex().regex(), nullptr) >= 0) {
+        regex_routes.push_back(index);
+      } else {
+        always_routes_.push_back(index);
+      }
+      break;
+    default:
+      always_routes_.push_back(index);
+      break;
+    }
+  }
+
+  if (!regex_routes.empty()) {
+    if (regex_set->Compile()) {
+      regex_set_ = std::move(regex_set);
+      regex_routes_ = std::move(regex_routes);
+    } else {
+      // The combined program is too large; fall back to evaluating the regex routes one by one.
+      always_routes_.insert(always_routes_.end(), regex_routes.begin(), regex_routes.end());
+      std::sort(always_routes_.begin(), always_routes_.end());
+    }
+  }
+}
+
+void CompiledRouteMatcher::candidates(absl::string_view path, CandidateVector& out) const {
+  out.clear();
+
+  absl::string_view key = Http::PathUtil::removeQueryAndFragment(path);
+  if (ignore_path_parameters_) {
+    const auto pos = key.find_first_of(';');
+    if (pos != absl::string_view::npos) {
+      key.remove_suffix(key.length() - pos);
+    }
+  }
+
+  case_sensitive_trie_.collect(key, out);
+  if (!case_insensitive_trie_.empty()) {
+    case_insensitive_trie_.collect(absl::AsciiStrToLower(key), out);
+  }
+
+  if (regex_set_ != nullptr) {
+    std::vector<int> matched;
+    re2::RE2::Set::ErrorInfo error_info;
+    if (regex_set_->Match(key, &matched, &error_info)) {
+      for (const int pattern : matched) {
+        out.push_back(regex_routes_[pattern]);
+      }
+    } else if (error_info.kind != re2::RE2::Set::kNoError) {
+      // The DFA ran out of memory. Be conservative and let every regex route be evaluated.
+      out.insert(out.end(), regex_routes_.begin(), regex_routes_.end());
+    }
+  }
+
+  out.insert(out.end(), always_routes_.begin(), always_routes_.end());
+  std::sort(out.begin(), out.end());
+}
+
+} // namespace Router
+} // namespace Envoy
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "envoy/config/route/v3/route_components.pb.h"
+#include "envoy/server/factory_context.h"
+
+#include "source/common/protobuf/protobuf.h"
+
+#include "absl/container/inlined_vector.h"
+#include "absl/strings/string_view.h"
+#include "re2/set.h"
+
+namespace Envoy {
+namespace Router {
+
+/**
+ * A simple byte trie keyed by route path prefixes or exact paths. Each node records the indices of
+ * routes whose prefix (or exact path) ends at that node. Children are kept in a small sorted
+ * vector, which is cheap to probe for the low fan-out typical of URL paths.
+ */
+class RoutePathTrie {
+public:
+  RoutePathTrie();
+
+  void addPrefix(absl::string_view prefix, uint32_t route_index);
+  void addExact(absl::string_view path, uint32_t route_index);
+
+  /**
+   * Appends the indices of all routes whose prefix is a prefix of `path`, and of all routes whose
+   * exact path equals `path`. Indices are appended in trie walk order, not route order.
+   */
+  void collect(absl::string_view path, absl::InlinedVector<uint32_t, 16>& out) const;
+
+  bool empty() const { return empty_; }
+
+private:
+  struct Node {
+    std::vector<std::pair<char, uint32_t>> children_;
+    std::vector<uint32_t> prefix_routes_;
+    std::vector<uint32_t> exact_routes_;
+  };
+
+  uint32_t findOrCreate(absl::string_view key);
+  const Node* findChild(const Node& node, char c) const;
+
+  std::vector<Node> nodes_;
+  bool empty_{true};
+};
+
+/**
+ * Pre-compiled index over the routes of a virtual host. Instead of evaluating every route in turn,
+ * the index narrows the route table down to the (ordered) set of routes whose path specifier can
+ * match the request path:
+ * - prefix, path separated prefix and exact path routes are looked up in a trie (one for case
+ *   sensitive and one for case insensitive routes). Prefixes which contain a query, fragment or
+ *   ignored path parameter delimiter are always considered instead.
+ * - regex routes are evaluated in a single pass with an RE2::Set.
+ * - all other routes (CONNECT matchers, path match policies, non RE2 regex engines) are always
+ *   considered.
+ *
+ * The candidates still have to be fully evaluated by the caller with RouteEntryImplBase::matches(),
+ * in ascending index order, which keeps the first-match semantics of the linear route scan.
+ */
+class CompiledRouteMatcher {
+public:
+  using CandidateVector = absl::InlinedVector<uint32_t, 16>;
+
+  CompiledRouteMatcher(const Protobuf::RepeatedPtrField<envoy::config::route::v3::Route>& routes,
+                       bool ignore_path_parameters,
+                       Server::Configuration::ServerFactoryContext& factory_context);
+
+  /**
+   * Fills `out` with the indices of the routes which may match `path`, in ascending order.
+   * @param path supplies the full :path header value, including query and fragment.
+   * @param out supplies the vector to fill. It is cleared first.
+   */
+  void candidates(absl::string_view path, CandidateVector& out) const;
+
+private:
+  RoutePathTrie case_sensitive_trie_;
+  RoutePathTrie case_insensitive_trie_;
+  std::unique_ptr<re2::RE2::Set> regex_set_;
+  // Maps the RE2::Set pattern index to the route index.
+  std::vector<uint32_t> regex_routes_;
+  // Routes that must be evaluated for every request.
+  std::vector<uint32_t> always_routes_;
+  const bool ignore_path_parameters_;
+};
+
+using CompiledRouteMatcherConstPtr = std::unique_ptr<const CompiledRouteMatcher>;
+
+} // namespace Router
+} // namespace Envoy
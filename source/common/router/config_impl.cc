@@ -1999,6 +1999,13 @@ VirtualHostImpl::VirtualHostImpl(
       SET_AND_RETURN_IF_NOT_OK(route_or_error.status(), creation_status);
       routes_.emplace_back(route_or_error.value());
     }
+    if (!routes_.empty() &&
+        Runtime::runtimeFeatureEnabled("envoy.reloadable_features.compiled_route_matcher")) {
+      compiled_matcher_ = std::make_unique<const CompiledRouteMatcher>(
+          virtual_host.routes(),
+          shared_virtual_host_->globalRouteConfig().ignorePathParametersInPathMatching(),
+          factory_context);
+    }
   }
 }
 
@@ -2041,6 +2048,52 @@ RouteConstSharedPtr VirtualHostImpl::getRouteFromRoutes(
   return nullptr;
 }
 
+RouteConstSharedPtr
+VirtualHostImpl::getRouteFromCompiledRoutes(const RouteCallback& cb,
+                                            const Http::RequestHeaderMap& headers,
+                                            const StreamInfo::StreamInfo& stream_info,
+                                            uint64_t random_value) const {
+  ASSERT(compiled_matcher_ != nullptr);
+  // Requests without a path can only be served by routes that support pathless headers, which the
+  // linear scan already handles.
+  if (!headers.Path()) {
+    return getRouteFromRoutes(cb, headers, stream_info, random_value, routes_);
+  }
+
+  CompiledRouteMatcher::CandidateVector candidates;
+  compiled_matcher_->candidates(headers.getPathValue(), candidates);
+
+  for (const uint32_t index : candidates) {
+    const auto& route = routes_[index];
+    RouteConstSharedPtr route_entry = route->matches(headers, stream_info, random_value);
+    if (route_entry == nullptr) {
+      continue;
+    }
+
+    if (cb == nullptr) {
+      return route_entry;
+    }
+
+    // Report the position relative to the full route table, so that the callback observes the
+    // same evaluation status as with the linear scan.
+    RouteEvalStatus eval_status = (index + 1 == routes_.size()) ? RouteEvalStatus::NoMoreRoutes
+                                                                : RouteEvalStatus::HasMoreRoutes;
+    RouteMatchStatus match_status = cb(route_entry, eval_status);
+    if (match_status == RouteMatchStatus::Accept) {
+      return route_entry;
+    }
+    if (match_status == RouteMatchStatus::Continue &&
+        eval_status == RouteEvalStatus::NoMoreRoutes) {
+      ENVOY_LOG(debug,
+                "return null when route match status is Continue but there is no more routes");
+      return nullptr;
+    }
+  }
+
+  ENVOY_LOG(debug, "route was resolved but final route list did not match incoming request");
+  return nullptr;
+}
+
 RouteConstSharedPtr VirtualHostImpl::getRouteFromEntries(const RouteCallback& cb,
                                                          const Http::RequestHeaderMap& headers,
                                                          const StreamInfo::StreamInfo& stream_info,
@@ -2090,6 +2143,9 @@ RouteConstSharedPtr VirtualHostImpl::getRouteFromEntries(const RouteCallback& cb
   }
 
   // Check for a route that matches the request.
+  if (compiled_matcher_ != nullptr) {
+    return getRouteFromCompiledRoutes(cb, headers, stream_info, random_value);
+  }
   return getRouteFromRoutes(cb, headers, stream_info, random_value, routes_);
 }
 
@@ -29,6 +29,7 @@
 #include "source/common/http/hash_policy.h"
 #include "source/common/http/header_utility.h"
 #include "source/common/matcher/matcher.h"
+#include "source/common/router/compiled_route_matcher.h"
 #include "source/common/router/config_utility.h"
 #include "source/common/router/header_parser.h"
 #include "source/common/router/metadatamatchcriteria_impl.h"
@@ -413,12 +414,19 @@ public:
 private:
   enum class SslRequirements : uint8_t { None, ExternalOnly, All };
 
+  RouteConstSharedPtr getRouteFromCompiledRoutes(const RouteCallback& cb,
+                                                 const Http::RequestHeaderMap& headers,
+                                                 const StreamInfo::StreamInfo& stream_info,
+                                                 uint64_t random_value) const;
+
   CommonVirtualHostSharedPtr shared_virtual_host_;
 
   std::shared_ptr<const SslRedirectRoute> ssl_redirect_route_;
   SslRequirements ssl_requirements_;
 
   std::vector<RouteEntryImplBaseConstSharedPtr> routes_;
+  // Only set when the compiled route matcher is enabled and the virtual host uses `routes`.
+  CompiledRouteMatcherConstPtr compiled_matcher_;
   Matcher::MatchTreeSharedPtr<Http::HttpMatchingData> matcher_;
 };
 
@@ -160,6 +160,63 @@ FALSE_RUNTIME_GUARD(envoy_reloadable_features_google_grpc_disable_tls_13);
 // before downstream.
 FALSE_RUNTIME_GUARD(envoy_reloadable_features_allow_multiplexed_upstream_half_close);
 
+// Narrows the routes of a virtual host down to the candidates that can match the request path,
+// using a prefix trie and an RE2::Set built at config load time.
+// Off by default until the compiled matcher has selected the same routes as the linear one on
+// production route tables.
+FALSE_RUNTIME_GUARD(envoy_reloadable_features_compiled_route_matcher);
+
+// Serves default sized buffer slices from per-thread pools instead of the heap.
+// Off by default since idle workers keep the slices of their pools resident.
+FALSE_RUNTIME_GUARD(envoy_restart_features_buffer_slice_pool);
+
+// Records thread local histogram values into hybrid dense/sparse storage, which is merged
+// incrementally, and skips refreshing the cumulative histograms which recorded nothing.
+FALSE_RUNTIME_GUARD(envoy_reloadable_features_hybrid_tls_histograms);
+
+// Splits the counters and gauges selected by the sharded_stats matcher of the stats config into
+// per-worker slots, which are summed when the stats are read.
+// Off by default since each sharded stat takes a cache line per worker.
+FALSE_RUNTIME_GUARD(envoy_restart_features_sharded_stats);
+
+// Builds access log lines from formats compiled at config time, without the intermediate Struct of
+// JSON formats.
+FALSE_RUNTIME_GUARD(envoy_reloadable_features_compiled_access_log_formatter);
+
+// Buffers file access log lines in lock-free per thread rings, which the flush thread drains.
+FALSE_RUNTIME_GUARD(envoy_reloadable_features_access_log_per_thread_buffers);
+
+// Fills the Maglev tables of large clusters on several threads. Off by default as each load
+// balancer doing so keeps its own threads.
+FALSE_RUNTIME_GUARD(envoy_reloadable_features_maglev_parallel_table_build);
+
+// Reuses the hosts of EDS endpoints which did not change since the previous update.
+FALSE_RUNTIME_GUARD(envoy_reloadable_features_eds_reuse_unchanged_hosts);
+
+// Checks HTTP/1 header values 16 bytes at a time with SSE2 or NEON instead of byte by byte.
+FALSE_RUNTIME_GUARD(envoy_reloadable_features_http1_vectorized_header_validation);
+
+// Probes the ring or table of bounded load hashing load balancers for an alternative to an
+// overloaded host before visiting every host.
+FALSE_RUNTIME_GUARD(envoy_reloadable_features_bounded_load_probe_hashing_lb);
+
+// Hands out the datagrams of a GRO read as fragments of the received buffer instead of copies.
+// Off by default since a datagram which is held on to keeps the whole GRO buffer alive.
+FALSE_RUNTIME_GUARD(envoy_reloadable_features_udp_gro_segments_without_copy);
+
+// Moves the bodies of large Redis bulk strings out of the connection buffer rather than copying.
+// Off by default since a decoded value holds on to the whole slice its body was read into.
+FALSE_RUNTIME_GUARD(envoy_reloadable_features_redis_buffered_bulk_strings);
+
+// Sends the keys of Redis multi-key commands which are served by the same shard as one command.
+// Off by default because a -TRYAGAIN for a batch whose keys are in a migrating slot fails every
+// key of the batch, instead of retrying them one by one.
+FALSE_RUNTIME_GUARD(envoy_reloadable_features_redis_batch_multi_key_commands);
+
+// Skips the values of the Thrift fields which the payload to metadata filter can't match rather
+// than decoding them.
+FALSE_RUNTIME_GUARD(envoy_reloadable_features_thrift_payload_to_metadata_skip_unmatched_fields);
+
 // Block of non-boolean flags. Use of int flags is deprecated. Do not add more.
 ABSL_FLAG(uint64_t, re2_max_program_size_error_level, 100, ""); // NOLINT
 ABSL_FLAG(uint64_t, re2_max_program_size_warn_level,            // NOLINT
@@ -9,6 +9,7 @@
 #include "source/common/common/hash.h"
 #include "source/common/common/lock_guard.h"
 #include "source/common/common/logger.h"
+#include "source/common/common/macros.h"
 #include "source/common/common/thread.h"
 #include "source/common/common/thread_annotations.h"
 #include "source/common/common/utility.h"
@@ -23,6 +24,45 @@ namespace Stats {
 
 const char AllocatorImpl::DecrementToZeroSyncPoint[] = "decrement-zero";
 
+namespace {
+
+// Hands out consecutive shard indices to threads in the order in which they first update a
+// sharded stat. Workers are started one after another, so up to the shard count each of them ends
+// up with a slot of its own.
+uint32_t threadShardIndex() {
+  static std::atomic<uint32_t> next_index{0};
+  thread_local const uint32_t index = next_index.fetch_add(1, std::memory_order_relaxed);
+  return index;
+}
+
+} // namespace
+
+void AllocatorImpl::setShardCount(uint32_t shard_count, ShardedStatPredicate predicate) {
+  uint32_t rounded = 1;
+  while (rounded < std::min(shard_count, MaxShardCount)) {
+    rounded <<= 1;
+  }
+  Thread::LockGuard lock(mutex_);
+  shard_count_ = shard_count <= 1 ? 0 : rounded;
+  sharded_stat_predicate_ = std::move(predicate);
+}
+
+uint32_t AllocatorImpl::shardCount() const {
+  Thread::LockGuard lock(mutex_);
+  return shard_count_;
+}
+
+uint32_t AllocatorImpl::shardCountFor(StatName name) const {
+  if (shard_count_ <= 1) {
+    return 0;
+  }
+  if (sharded_stat_predicate_ != nullptr &&
+      !sharded_stat_predicate_(symbol_table_.toString(name))) {
+    return 0;
+  }
+  return shard_count_;
+}
+
 AllocatorImpl::~AllocatorImpl() {
   ASSERT(counters_.empty());
   ASSERT(gauges_.empty());
@@ -262,11 +302,127 @@ public:
 
   void setParentValue(uint64_t value) override { parent_value_ = value; }
 
-private:
+protected:
   std::atomic<uint64_t> parent_value_{0};
+
+private:
   std::atomic<uint64_t> child_value_{0};
 };
 
+// A value split into per-thread slots, each on a cache line of its own, so that threads updating
+// the same stat don't bounce its cache line between cores. The slots are only summed when the
+// value is read, i.e. at flush time or from the admin handlers.
+//
+// Slots wrap around on underflow, e.g. when a gauge is incremented on one thread and decremented
+// on another. The sum is still exact, modulo 2^64.
+class ShardedValue {
+public:
+  explicit ShardedValue(uint32_t shard_count)
+      : mask_(shard_count - 1), slots_(std::make_unique<Slot[]>(shard_count)) {
+    ASSERT(shard_count > 0 && (shard_count & mask_) == 0);
+  }
+
+  void add(uint64_t amount) { localSlot().value_.fetch_add(amount, std::memory_order_relaxed); }
+  // Adds to the value and to the amount returned by the next latch().
+  void addPending(uint64_t amount) {
+    Slot& slot = localSlot();
+    slot.value_.fetch_add(amount, std::memory_order_relaxed);
+    slot.pending_.fetch_add(amount, std::memory_order_relaxed);
+  }
+  void sub(uint64_t amount) { localSlot().value_.fetch_sub(amount, std::memory_order_relaxed); }
+  // Adds the difference to the current sum instead of overwriting the slots, so that the updates
+  // other threads make concurrently are not lost: each of them counts either before or after the
+  // set().
+  void set(uint64_t value) { add(value - this->value()); }
+  uint64_t value() const {
+    uint64_t sum = 0;
+    for (uint32_t i = 0; i <= mask_; ++i) {
+      sum += slots_[i].value_.load(std::memory_order_relaxed);
+    }
+    return sum;
+  }
+  uint64_t latch() {
+    uint64_t sum = 0;
+    for (uint32_t i = 0; i <= mask_; ++i) {
+      sum += slots_[i].pending_.exchange(0, std::memory_order_relaxed);
+    }
+    return sum;
+  }
+
+private:
+  struct alignas(64) Slot {
+    std::atomic<uint64_t> value_{0};
+    // Only used by counters.
+    std::atomic<uint64_t> pending_{0};
+  };
+
+  Slot& localSlot() { return slots_[threadShardIndex() & mask_]; }
+
+  const uint32_t mask_;
+  std::unique_ptr<Slot[]> slots_;
+};
+
+class ShardedCounterImpl : public CounterImpl {
+public:
+  ShardedCounterImpl(StatName name, AllocatorImpl& alloc, StatName tag_extracted_name,
+                     const StatNameTagVector& stat_name_tags, uint32_t shard_count)
+      : CounterImpl(name, alloc, tag_extracted_name, stat_name_tags), shards_(shard_count) {}
+
+  // Stats::Counter
+  void add(uint64_t amount) override {
+    shards_.addPending(amount);
+    // Only write the shared flags once, as that is the kind of contention the shards avoid.
+    if (!used()) {
+      flags_ |= Flags::Used;
+    }
+  }
+  void inc() override { add(1); }
+  uint64_t latch() override { return shards_.latch(); }
+  // Also drops the increments not latched yet, so that they are not reported after the reset.
+  void reset() override {
+    shards_.latch();
+    shards_.set(0);
+  }
+  uint64_t value() const override { return shards_.value(); }
+
+private:
+  ShardedValue shards_;
+};
+
+class ShardedGaugeImpl : public GaugeImpl {
+public:
+  ShardedGaugeImpl(StatName name, AllocatorImpl& alloc, StatName tag_extracted_name,
+                   const StatNameTagVector& stat_name_tags, ImportMode import_mode,
+                   uint32_t shard_count)
+      : GaugeImpl(name, alloc, tag_extracted_name, stat_name_tags, import_mode),
+        child_shards_(shard_count) {}
+
+  // Stats::Gauge
+  void add(uint64_t amount) override {
+    child_shards_.add(amount);
+    if (!used()) {
+      flags_ |= Flags::Used;
+    }
+  }
+  void dec() override { sub(1); }
+  void inc() override { add(1); }
+  void set(uint64_t value) override {
+    child_shards_.set(value);
+    if (!used()) {
+      flags_ |= Flags::Used;
+    }
+  }
+  void sub(uint64_t amount) override {
+    ASSERT(child_shards_.value() >= amount);
+    ASSERT(used() || amount == 0);
+    child_shards_.sub(amount);
+  }
+  uint64_t value() const override { return child_shards_.value() + parent_value_; }
+
+private:
+  ShardedValue child_shards_;
+};
+
 class TextReadoutImpl : public StatsSharedImpl<TextReadout> {
 public:
   TextReadoutImpl(StatName name, AllocatorImpl& alloc, StatName tag_extracted_name,
@@ -325,8 +481,11 @@ GaugeSharedPtr AllocatorImpl::makeGauge(StatName name, StatName tag_extracted_na
   if (iter != gauges_.end()) {
     return {*iter};
   }
-  auto gauge =
-      GaugeSharedPtr(new GaugeImpl(name, *this, tag_extracted_name, stat_name_tags, import_mode));
+  const uint32_t shard_count = shardCountFor(name);
+  auto gauge = GaugeSharedPtr(
+      shard_count > 1 ? new ShardedGaugeImpl(name, *this, tag_extracted_name, stat_name_tags,
+                                             import_mode, shard_count)
+                      : new GaugeImpl(name, *this, tag_extracted_name, stat_name_tags, import_mode));
   gauges_.insert(gauge.get());
   // Add gauge to sinked_gauges_ if it matches the sink predicate.
   if (sink_predicates_ != nullptr && sink_predicates_->includeGauge(*gauge)) {
@@ -366,6 +525,10 @@ bool AllocatorImpl::isMutexLockedForTest() {
 
 Counter* AllocatorImpl::makeCounterInternal(StatName name, StatName tag_extracted_name,
                                             const StatNameTagVector& stat_name_tags) {
+  const uint32_t shard_count = shardCountFor(name);
+  if (shard_count > 1) {
+    return new ShardedCounterImpl(name, *this, tag_extracted_name, stat_name_tags, shard_count);
+  }
   return new CounterImpl(name, *this, tag_extracted_name, stat_name_tags);
 }
 
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <atomic>
+#include <cstdint>
+#include <functional>
 #include <vector>
 
 #include "envoy/common/optref.h"
@@ -19,6 +22,7 @@ namespace Stats {
 class AllocatorImpl : public Allocator {
 public:
   static const char DecrementToZeroSyncPoint[];
+  static constexpr uint32_t MaxShardCount = 64;
 
   AllocatorImpl(SymbolTable& symbol_table) : symbol_table_(symbol_table) {}
   ~AllocatorImpl() override;
@@ -49,6 +53,10 @@ public:
   void debugPrint();
 #endif
 
+  // The shard count is rounded up to a power of two and capped at MaxShardCount.
+  void setShardCount(uint32_t shard_count, ShardedStatPredicate predicate) override;
+  uint32_t shardCount() const;
+
   /**
    * @return a thread synchronizer object used for reproducing a race-condition in tests.
    */
@@ -71,9 +79,16 @@ private:
   template <class BaseClass> friend class StatsSharedImpl;
   friend class CounterImpl;
   friend class GaugeImpl;
+  friend class ShardedCounterImpl;
+  friend class ShardedGaugeImpl;
   friend class TextReadoutImpl;
   friend class NotifyingAllocatorImpl;
 
+  // Returns the number of slots of a new counter or gauge, 0 if it is not sharded. Only called
+  // while allocating a stat, with mutex_ held, but makeCounterInternal() is not annotated as such
+  // since it is overridden in tests.
+  uint32_t shardCountFor(StatName name) const ABSL_NO_THREAD_SAFETY_ANALYSIS;
+
   // A mutex is needed here to protect both the stats_ object from both
   // alloc() and free() operations. Although alloc() operations are called under existing locking,
   // free() operations are made from the destructors of the individual stat objects, which are not
@@ -84,6 +99,9 @@ private:
   StatSet<Gauge> gauges_ ABSL_GUARDED_BY(mutex_);
   StatSet<TextReadout> text_readouts_ ABSL_GUARDED_BY(mutex_);
 
+  uint32_t shard_count_ ABSL_GUARDED_BY(mutex_){0};
+  ShardedStatPredicate sharded_stat_predicate_ ABSL_GUARDED_BY(mutex_);
+
   template <typename StatType> using StatPointerSet = absl::flat_hash_set<StatType*>;
   // Stat pointers that participate in the flush to sink process.
   StatPointerSet<Counter> sinked_counters_ ABSL_GUARDED_BY(mutex_);
@@ -0,0 +1,82 @@
+#include "source/common/stats/hybrid_histogram.h"
+
+#include <algorithm>
+
+#include "source/common/common/assert.h"
+
+namespace Envoy {
+namespace Stats {
+
+void HybridHistogram::recordValue(uint64_t value) {
+  insert(int_scale_to_hist_bucket(value, 0), 1);
+}
+
+void HybridHistogram::insert(hist_bucket_t bucket, uint64_t count) {
+  if (isDense(bucket)) {
+    for (uint16_t decade = 0; decade < dense_.size(); ++decade) {
+      if (dense_[decade].exp_ == bucket.exp) {
+        addDense(decade, bucket, count);
+        return;
+      }
+    }
+  }
+
+  uint32_t same_decade = 0;
+  for (SparseBucket& sparse : sparse_) {
+    if (sparse.bucket_.val == bucket.val && sparse.bucket_.exp == bucket.exp) {
+      sparse.count_ += count;
+      return;
+    }
+    if (sparse.bucket_.exp == bucket.exp && isDense(sparse.bucket_)) {
+      ++same_decade;
+    }
+  }
+  sparse_.push_back({bucket, count});
+  if (isDense(bucket) && same_decade + 1 >= PromoteThreshold) {
+    promote(bucket.exp);
+  }
+}
+
+void HybridHistogram::addDense(uint16_t decade, hist_bucket_t bucket, uint64_t count) {
+  const uint8_t index = bucket.val - MinDenseValue;
+  uint64_t& bucket_count = dense_[decade].counts_[index];
+  if (bucket_count == 0) {
+    changed_.push_back({decade, index});
+  }
+  bucket_count += count;
+}
+
+void HybridHistogram::promote(int8_t exp) {
+  ASSERT(dense_.size() < UINT16_MAX);
+  const uint16_t decade = dense_.size();
+  dense_.push_back({exp, std::make_unique<uint64_t[]>(BucketsPerDecade)});
+  sparse_.erase(std::remove_if(sparse_.begin(), sparse_.end(),
+                               [this, exp, decade](const SparseBucket& sparse) {
+                                 if (sparse.bucket_.exp != exp || !isDense(sparse.bucket_)) {
+                                   return false;
+                                 }
+                                 addDense(decade, sparse.bucket_, sparse.count_);
+                                 return true;
+                               }),
+                sparse_.end());
+}
+
+void HybridHistogram::drainInto(histogram_t* target) {
+  for (const ChangedBucket& changed : changed_) {
+    DenseDecade& dense = dense_[changed.decade_];
+    hist_bucket_t bucket;
+    bucket.val = static_cast<int8_t>(changed.index_ + MinDenseValue);
+    bucket.exp = dense.exp_;
+    hist_insert_raw(target, bucket, dense.counts_[changed.index_]);
+    dense.counts_[changed.index_] = 0;
+  }
+  changed_.clear();
+
+  for (const SparseBucket& sparse : sparse_) {
+    hist_insert_raw(target, sparse.bucket_, sparse.count_);
+  }
+  sparse_.clear();
+}
+
+} // namespace Stats
+} // namespace Envoy
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "source/common/common/non_copyable.h"
+
+#include "absl/container/inlined_vector.h"
+#include "circllhist.h"
+
+namespace Envoy {
+namespace Stats {
+
+/**
+ * Recording side storage of a histogram, in the log linear buckets of circllhist, which is drained
+ * incrementally into a circllhist.
+ *
+ * The buckets of hot decades, i.e. decades in which many distinct values are recorded, are kept in
+ * dense arrays of counts, indexed directly by the bucket. All other buckets are kept in a small
+ * sparse vector until PromoteThreshold distinct buckets of the same decade are seen, at which
+ * point the decade is promoted to a dense array. Dense arrays are kept across drains, so that a
+ * histogram whose values keep falling into the same decades stops allocating once warmed up.
+ *
+ * The buckets which changed since the last drain are tracked, so that the cost of drainInto() is
+ * proportional to the number of changed buckets rather than to the number of buckets of the
+ * histogram. Recording a value doesn't need circllhist's sorted insertion either.
+ *
+ * This class is not thread safe. ThreadLocalHistogramImpl keeps two of them and swaps them before
+ * draining, as it does for circllhist.
+ */
+class HybridHistogram : NonCopyable {
+public:
+  // Number of distinct sparse buckets in a decade which promote it to dense storage.
+  static constexpr uint32_t PromoteThreshold = 8;
+
+  void recordValue(uint64_t value);
+  void insert(hist_bucket_t bucket, uint64_t count);
+
+  /**
+   * Adds the counts recorded since the last drain to `target`, and resets them.
+   */
+  void drainInto(histogram_t* target);
+
+  /**
+   * @return whether nothing was recorded since the last drain.
+   */
+  bool empty() const { return changed_.empty() && sparse_.empty(); }
+
+  /**
+   * @return the number of decades in dense storage.
+   */
+  uint32_t denseDecades() const { return dense_.size(); }
+
+private:
+  // The buckets of a decade with positive values, i.e. 1.0 to 9.9 times 10^exp.
+  static constexpr int8_t MinDenseValue = 10;
+  static constexpr int8_t MaxDenseValue = 99;
+  static constexpr uint32_t BucketsPerDecade = MaxDenseValue - MinDenseValue + 1;
+
+  struct DenseDecade {
+    int8_t exp_;
+    std::unique_ptr<uint64_t[]> counts_;
+  };
+  struct SparseBucket {
+    hist_bucket_t bucket_;
+    uint64_t count_;
+  };
+  // A bucket of dense storage which changed since the last drain.
+  struct ChangedBucket {
+    uint16_t decade_;
+    uint8_t index_;
+  };
+
+  static bool isDense(hist_bucket_t bucket) {
+    return bucket.val >= MinDenseValue && bucket.val <= MaxDenseValue;
+  }
+  void addDense(uint16_t decade, hist_bucket_t bucket, uint64_t count);
+  void promote(int8_t exp);
+
+  std::vector<DenseDecade> dense_;
+  absl::InlinedVector<SparseBucket, 4> sparse_;
+  std::vector<ChangedBucket> changed_;
+};
+
+} // namespace Stats
+} // namespace Envoy
@@ -14,6 +14,7 @@
 #include "source/common/common/thread_synchronizer.h"
 #include "source/common/stats/allocator_impl.h"
 #include "source/common/stats/histogram_impl.h"
+#include "source/common/stats/hybrid_histogram.h"
 #include "source/common/stats/null_counter.h"
 #include "source/common/stats/null_gauge.h"
 #include "source/common/stats/null_text_readout.h"
@@ -30,11 +31,15 @@ namespace Stats {
  * A histogram that is stored in TLS and used to record values per thread. This holds two
  * histograms, one to collect the values and other as backup that is used for merge process. The
  * swap happens during the merge process.
+ *
+ * With hybrid storage the two histograms are HybridHistograms instead of circllhists, which only
+ * merge the buckets that changed since the previous merge.
  */
 class ThreadLocalHistogramImpl : public HistogramImplHelper {
 public:
   ThreadLocalHistogramImpl(StatName name, Histogram::Unit unit, StatName tag_extracted_name,
-                           const StatNameTagVector& stat_name_tags, SymbolTable& symbol_table);
+                           const StatNameTagVector& stat_name_tags, SymbolTable& symbol_table,
+                           bool hybrid_storage = false);
   ~ThreadLocalHistogramImpl() override;
 
   void merge(histogram_t* target);
@@ -66,7 +71,9 @@ private:
   Histogram::Unit unit_;
   uint64_t otherHistogramIndex() const { return 1 - current_active_; }
   uint64_t current_active_{0};
-  histogram_t* histograms_[2];
+  histogram_t* histograms_[2]{};
+  // Used instead of histograms_ with hybrid storage.
+  std::unique_ptr<HybridHistogram> hybrid_histograms_[2];
   std::atomic<bool> used_;
   std::thread::id created_thread_id_;
   SymbolTable& symbol_table_;
@@ -206,6 +213,9 @@ public:
 
   void setSinkPredicates(std::unique_ptr<SinkPredicates>&& sink_predicates) override;
   OptRef<SinkPredicates> sinkPredicates() override { return sink_predicates_; }
+  void setShardCount(uint32_t shard_count, Allocator::ShardedStatPredicate predicate) override {
+    alloc_.setShardCount(shard_count, std::move(predicate));
+  }
 
   /**
    * @return a thread synchronizer object used for controlling thread behavior in tests.
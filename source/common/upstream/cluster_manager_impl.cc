@@ -24,6 +24,7 @@
 #include "source/common/common/assert.h"
 #include "source/common/common/enum_to_int.h"
 #include "source/common/common/fmt.h"
+#include "source/common/common/thread.h"
 #include "source/common/common/utility.h"
 #include "source/common/config/custom_config_validators_impl.h"
 #include "source/common/config/null_grpc_mux_impl.h"
@@ -311,7 +312,7 @@ ClusterManagerImpl::ClusterManagerImpl(
     Api::Api& api, Http::Context& http_context, Grpc::Context& grpc_context,
     Router::Context& router_context, Server::Instance& server)
     : server_(server), factory_(factory), runtime_(runtime), stats_(stats), tls_(tls),
-      random_(api.randomGenerator()),
+      shared_conn_pool_workers_(server.options().concurrency()), random_(api.randomGenerator()),
       deferred_cluster_creation_(bootstrap.cluster_manager().enable_deferred_cluster_creation()),
       bind_config_(bootstrap.cluster_manager().has_upstream_bind_config()
                        ? absl::make_optional(bootstrap.cluster_manager().upstream_bind_config())
@@ -1776,6 +1777,12 @@ ClusterManagerImpl::ThreadLocalClusterManagerImpl::ThreadLocalClusterManagerImpl
     const absl::optional<LocalClusterParams>& local_cluster_params)
     : parent_(parent), thread_local_dispatcher_(dispatcher), cdm_(dispatcher.name(), *this),
       local_stats_(generateStats(*parent.stats_.rootScope(), dispatcher.name())) {
+  cluster_manager_state_.adaptive_preconnect_load_shed_point_ =
+      parent.server_.overloadManager().getLoadShedPoint(
+          Server::LoadShedPointName::get().UpstreamAdaptivePreconnect);
+  if (!Thread::MainThread::isMainOrTestThread()) {
+    parent_.shared_conn_pool_workers_.addWorker(dispatcher);
+  }
   // If local cluster is defined then we need to initialize it first.
   if (local_cluster_params.has_value()) {
     const auto& local_cluster_name = local_cluster_params->info_->name();
@@ -1794,6 +1801,9 @@ ClusterManagerImpl::ThreadLocalClusterManagerImpl::~ThreadLocalClusterManagerImp
   // member update callback registered with the local cluster.
   ENVOY_LOG(debug, "shutting down thread local cluster manager");
   destroying_ = true;
+  if (!Thread::MainThread::isMainOrTestThread()) {
+    parent_.shared_conn_pool_workers_.removeWorker(thread_local_dispatcher_);
+  }
   host_http_conn_pool_map_.clear();
   host_tcp_conn_pool_map_.clear();
   ASSERT(host_tcp_conn_map_.empty());
@@ -2035,16 +2045,77 @@ ClusterManagerImpl::ThreadLocalClusterManagerImpl::ClusterEntry::httpConnPoolImp
     context->downstreamConnection()->hashKey(hash_key);
   }
 
+  // If the HTTP/2 connections to the host are shared between workers and this worker does not own
+  // them, its streams are handed to an owner. Requests which need connections of their own, with
+  // socket or transport socket options or per downstream connection, are never handed off.
+  const bool shareable =
+      cluster_info_->sharedConnectionPoolOwnersPerHost() > 0 && upstream_protocols.size() == 1 &&
+      upstream_protocols[0] == Http::Protocol::Http2 && upstream_options->empty() &&
+      !have_transport_socket_options && !cluster_info_->connectionPoolPerDownstreamConnection();
+
   ConnPoolsContainer& container = *parent_.getHttpConnPoolsContainer(host, true);
 
   // Note: to simplify this, we assume that the factory is only called in the scope of this
   // function. Otherwise, we'd need to capture a few of these variables by value.
+  ConnPoolsContainer::ConnPools::PoolOptRef pool =
+      container.pools_->getPool(priority, hash_key, [&]() {
+        Http::ConnectionPool::InstancePtr pool;
+        // The owner is looked up only when the pool is created, which keeps the lock and the
+        // hash of the lookup off the path of requests which find their pool.
+        Event::Dispatcher* owner_dispatcher =
+            shareable ? parent_.parent_.shared_conn_pool_workers_.ownerFor(
+                            *host, parent_.thread_local_dispatcher_,
+                            cluster_info_->sharedConnectionPoolOwnersPerHost())
+                      : nullptr;
+        if (owner_dispatcher != nullptr) {
+          pool = std::make_unique<Http::Http2::SharedConnPoolClient>(
+              parent_.thread_local_dispatcher_, *owner_dispatcher, host,
+              [&cluster_manager = parent_.parent_, cluster_name = cluster_info_->name(), host,
+               priority]() -> Http::ConnectionPool::Instance* {
+                OptRef<ThreadLocalClusterManagerImpl> owner = cluster_manager.tls_.get();
+                if (!owner.has_value()) {
+                  return nullptr;
+                }
+                auto entry = owner->thread_local_clusters_.find(cluster_name);
+                if (entry == owner->thread_local_clusters_.end()) {
+                  return nullptr;
+                }
+                return entry->second->sharedHttpConnPool(host, priority);
+              });
+        } else {
+          pool = parent_.parent_.factory_.allocateConnPool(
+              parent_.thread_local_dispatcher_, host, priority, upstream_protocols,
+              alternate_protocol_options, !upstream_options->empty() ? upstream_options : nullptr,
+              have_transport_socket_options ? context->upstreamTransportSocketOptions() : nullptr,
+              parent_.parent_.time_source_, parent_.cluster_manager_state_, quic_info_,
+              parent_.getNetworkObserverRegistry());
+        }
+
+        pool->addIdleCallback([&parent = parent_, host, priority, hash_key]() {
+          parent.httpConnPoolIsIdle(host, priority, hash_key);
+        });
+
+        return pool;
+      });
+
+  if (pool.has_value()) {
+    return &(pool.value().get());
+  } else {
+    return nullptr;
+  }
+}
+
+Http::ConnectionPool::Instance*
+ClusterManagerImpl::ThreadLocalClusterManagerImpl::ClusterEntry::sharedHttpConnPool(
+    const HostConstSharedPtr& host, ResourcePriority priority) {
+  const std::vector<Http::Protocol> upstream_protocols{Http::Protocol::Http2};
+  const std::vector<uint8_t> hash_key{uint8_t(Http::Protocol::Http2)};
+  ConnPoolsContainer& container = *parent_.getHttpConnPoolsContainer(host, true);
   ConnPoolsContainer::ConnPools::PoolOptRef pool =
       container.pools_->getPool(priority, hash_key, [&]() {
         auto pool = parent_.parent_.factory_.allocateConnPool(
             parent_.thread_local_dispatcher_, host, priority, upstream_protocols,
-            alternate_protocol_options, !upstream_options->empty() ? upstream_options : nullptr,
-            have_transport_socket_options ? context->upstreamTransportSocketOptions() : nullptr,
+            host->cluster().alternateProtocolsCacheOptions(), nullptr, nullptr,
             parent_.parent_.time_source_, parent_.cluster_manager_state_, quic_info_,
             parent_.getNetworkObserverRegistry());
 
@@ -31,6 +31,7 @@
 #include "source/common/common/cleanup.h"
 #include "source/common/config/subscription_factory_impl.h"
 #include "source/common/http/async_client_impl.h"
+#include "source/common/http/http2/shared_conn_pool.h"
 #include "source/common/http/http_server_properties_cache_impl.h"
 #include "source/common/http/http_server_properties_cache_manager_impl.h"
 #include "source/common/quic/envoy_quic_network_observer_registry_factory.h"
@@ -611,6 +612,10 @@ private:
                           ConnectionPool::DrainBehavior behavior);
       UnitFloat dropOverload() const override { return drop_overload_; }
       void setDropOverload(UnitFloat drop_overload) override { drop_overload_ = drop_overload; }
+      // Returns this worker's pool for the HTTP/2 connections to host which it shares with other
+      // workers.
+      Http::ConnectionPool::Instance* sharedHttpConnPool(const HostConstSharedPtr& host,
+                                                         ResourcePriority priority);
 
     private:
       Http::ConnectionPool::Instance*
@@ -898,6 +903,7 @@ private:
   Runtime::Loader& runtime_;
   Stats::Store& stats_;
   ThreadLocal::TypedSlot<ThreadLocalClusterManagerImpl> tls_;
+  Http::Http2::SharedConnPoolWorkers shared_conn_pool_workers_;
   // Contains information about ongoing on-demand cluster discoveries.
   ClusterCreationsMap pending_cluster_creations_;
   Random::RandomGenerator& random_;
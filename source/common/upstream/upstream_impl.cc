@@ -1156,6 +1156,15 @@ ClusterInfoImpl::ClusterInfoImpl(
           config.preconnect_policy(), per_upstream_preconnect_ratio, 1.0)),
       peekahead_ratio_(PROTOBUF_GET_WRAPPED_OR_DEFAULT(config.preconnect_policy(),
                                                        predictive_preconnect_ratio, 0)),
+      adaptive_preconnect_(
+          config.preconnect_policy().has_adaptive_preconnect()
+              ? absl::make_optional(AdaptivePreconnectConfig{
+                    std::chrono::milliseconds(PROTOBUF_GET_MS_OR_DEFAULT(
+                        config.preconnect_policy().adaptive_preconnect(), averaging_window, 1000)),
+                    PROTOBUF_GET_WRAPPED_OR_DEFAULT(
+                        config.preconnect_policy().adaptive_preconnect(),
+                        max_anticipated_streams, 16)})
+              : absl::nullopt),
       socket_matcher_(std::move(socket_matcher)), stats_scope_(std::move(stats_scope)),
       traffic_stats_(generateStats(stats_scope_,
                                    factory_context.clusterManager().clusterStatNames(),
@@ -1219,6 +1228,11 @@ ClusterInfoImpl::ClusterInfoImpl(
           http_protocol_options_->common_http_protocol_options_, max_headers_count,
           runtime_.snapshot().getInteger(Http::MaxResponseHeadersCountOverrideKey,
                                          Http::DEFAULT_MAX_HEADERS_COUNT))),
+      shared_connection_pool_owners_per_host_(
+          config.has_shared_connection_pool()
+              ? PROTOBUF_GET_WRAPPED_OR_DEFAULT(config.shared_connection_pool(),
+                                                owner_workers_per_host, 1)
+              : 0),
       type_(config.type()),
       drain_connections_on_host_removal_(config.ignore_health_on_host_removal()),
       connection_pool_per_downstream_connection_(
@@ -2202,7 +2216,7 @@ void PriorityStateManager::updateClusterPrioritySet(
   // As per HostsPerLocality::get(), the per_locality vector must have the local locality hosts
   // first if non_empty_local_locality.
   if (non_empty_local_locality) {
-    per_locality.emplace_back(hosts_per_locality[local_locality]);
+    per_locality.emplace_back(std::move(hosts_per_locality[local_locality]));
     locality_weights->emplace_back(locality_weights_map[local_locality]);
   }
 
@@ -2210,7 +2224,7 @@ void PriorityStateManager::updateClusterPrioritySet(
   // lexicographic order. This provides a stable ordering for zone aware routing.
   for (auto& entry : hosts_per_locality) {
     if (!non_empty_local_locality || !LocalityEqualTo()(local_locality, entry.first)) {
-      per_locality.emplace_back(entry.second);
+      per_locality.emplace_back(std::move(entry.second));
       locality_weights->emplace_back(locality_weights_map[entry.first]);
     }
   }
@@ -2262,15 +2276,16 @@ bool BaseDynamicClusterImpl::updateDynamicHostList(
   // Keep track of hosts we see in new_hosts that we are able to match up with an existing host.
   absl::flat_hash_set<std::string> existing_hosts_for_current_priority(
       current_priority_hosts.size());
-  // Keep track of hosts we're adding (or replacing)
-  absl::flat_hash_set<std::string> new_hosts_for_current_priority(new_hosts.size());
+  // Keep track of hosts we're adding (or replacing). The sets below are not sized upfront: an
+  // update usually adds few hosts, and rarely changes the locality or the active health check
+  // flag of any, so sizing them for the whole priority would cost more than it saves.
+  absl::flat_hash_set<std::string> new_hosts_for_current_priority;
   // Keep track of hosts for which locality is changed.
-  absl::flat_hash_set<std::string> hosts_with_updated_locality_for_current_priority(
-      current_priority_hosts.size());
+  absl::flat_hash_set<std::string> hosts_with_updated_locality_for_current_priority;
   // Keep track of hosts for which active health check flag is changed.
-  absl::flat_hash_set<std::string> hosts_with_active_health_check_flag_changed(
-      current_priority_hosts.size());
+  absl::flat_hash_set<std::string> hosts_with_active_health_check_flag_changed;
   HostVector final_hosts;
+  final_hosts.reserve(new_hosts.size());
   for (const HostSharedPtr& host : new_hosts) {
     // To match a new host with an existing host means comparing their addresses.
     auto existing_host = all_hosts.find(addressToString(host->address()));
@@ -2327,12 +2342,16 @@ bool BaseDynamicClusterImpl::updateDynamicHostList(
       hosts_changed |= updateEdsHealthFlag(*host, *existing_host->second);
 
       // Did metadata change?
+      // Equal metadata is usually shared through constMetadataSharedPool(), in which case there is
+      // no need to compare it.
+      const MetadataConstSharedPtr metadata = host->metadata();
+      const MetadataConstSharedPtr existing_metadata = existing_host->second->metadata();
       bool metadata_changed = true;
-      if (host->metadata() && existing_host->second->metadata()) {
-        metadata_changed = !Protobuf::util::MessageDifferencer::Equivalent(
-            *host->metadata(), *existing_host->second->metadata());
-      } else if (!host->metadata() && !existing_host->second->metadata()) {
+      if (metadata == existing_metadata) {
         metadata_changed = false;
+      } else if (metadata && existing_metadata) {
+        metadata_changed =
+            !Protobuf::util::MessageDifferencer::Equivalent(*metadata, *existing_metadata);
       }
 
       if (metadata_changed) {
@@ -6,6 +6,7 @@
 #include "envoy/service/discovery/v3/discovery.pb.h"
 
 #include "source/common/common/assert.h"
+#include "source/common/common/hash.h"
 #include "source/common/common/utility.h"
 #include "source/common/config/api_version.h"
 #include "source/common/config/decoded_resource_impl.h"
@@ -13,6 +14,21 @@
 
 namespace Envoy {
 namespace Upstream {
+namespace {
+
+// Hashes the configuration shared by all the endpoints of a locality, which seeds the hash of the
+// endpoints.
+uint64_t
+localityHash(const envoy::config::endpoint::v3::LocalityLbEndpoints& locality_lb_endpoint) {
+  uint64_t hash = HashUtil::xxHash64(locality_lb_endpoint.locality().SerializeAsString(),
+                                     locality_lb_endpoint.priority());
+  if (locality_lb_endpoint.has_metadata()) {
+    hash = HashUtil::xxHash64(locality_lb_endpoint.metadata().SerializeAsString(), hash);
+  }
+  return hash;
+}
+
+} // namespace
 
 absl::StatusOr<std::unique_ptr<EdsClusterImpl>>
 EdsClusterImpl::create(const envoy::config::cluster::v3::Cluster& cluster,
@@ -61,14 +77,28 @@ EdsClusterImpl::~EdsClusterImpl() {
 
 void EdsClusterImpl::startPreInit() { subscription_->start({edsServiceName()}); }
 
+EdsClusterImpl::BatchUpdateHelper::BatchUpdateHelper(
+    EdsClusterImpl& parent,
+    const envoy::config::endpoint::v3::ClusterLoadAssignment& cluster_load_assignment)
+    : parent_(parent), cluster_load_assignment_(cluster_load_assignment),
+      reuse_unchanged_hosts_(
+          Runtime::runtimeFeatureEnabled("envoy.reloadable_features.eds_reuse_unchanged_hosts")) {}
+
 void EdsClusterImpl::BatchUpdateHelper::batchUpdate(PrioritySet::HostUpdateCb& host_update_cb) {
   absl::flat_hash_set<std::string> all_new_hosts;
   PriorityStateManager priority_state_manager(parent_, parent_.local_info_, &host_update_cb,
                                               parent_.random_);
+
+  // Get the map of all the latest existing hosts, which is used to filter out the existing
+  // hosts in the process of updating cluster memberships.
+  HostMapConstSharedPtr all_hosts = parent_.prioritySet().crossPriorityHostMap();
+  ASSERT(all_hosts != nullptr);
+
   for (const auto& locality_lb_endpoint : cluster_load_assignment_.endpoints()) {
     THROW_IF_NOT_OK(parent_.validateEndpointsForZoneAwareRouting(locality_lb_endpoint));
 
     priority_state_manager.initializePriorityFor(locality_lb_endpoint);
+    const uint64_t locality_hash = reuse_unchanged_hosts_ ? localityHash(locality_lb_endpoint) : 0;
 
     if (locality_lb_endpoint.has_leds_cluster_locality_config()) {
       // The locality uses LEDS, fetch its dynamic data, which must be ready, or otherwise
@@ -81,13 +111,13 @@ void EdsClusterImpl::BatchUpdateHelper::batchUpdate(PrioritySet::HostUpdateCb& h
              parent_.leds_localities_[leds_config]->isUpdated());
       for (const auto& [_, lb_endpoint] :
            parent_.leds_localities_[leds_config]->getEndpointsMap()) {
-        updateLocalityEndpoints(lb_endpoint, locality_lb_endpoint, priority_state_manager,
-                                all_new_hosts);
+        updateLocalityEndpoints(lb_endpoint, locality_lb_endpoint, locality_hash,
+                                priority_state_manager, all_new_hosts, *all_hosts);
       }
     } else {
       for (const auto& lb_endpoint : locality_lb_endpoint.lb_endpoints()) {
-        updateLocalityEndpoints(lb_endpoint, locality_lb_endpoint, priority_state_manager,
-                                all_new_hosts);
+        updateLocalityEndpoints(lb_endpoint, locality_lb_endpoint, locality_hash,
+                                priority_state_manager, all_new_hosts, *all_hosts);
       }
     }
   }
@@ -95,11 +125,6 @@ void EdsClusterImpl::BatchUpdateHelper::batchUpdate(PrioritySet::HostUpdateCb& h
   // Track whether we rebuilt any LB structures.
   bool cluster_rebuilt = false;
 
-  // Get the map of all the latest existing hosts, which is used to filter out the existing
-  // hosts in the process of updating cluster memberships.
-  HostMapConstSharedPtr all_hosts = parent_.prioritySet().crossPriorityHostMap();
-  ASSERT(all_hosts != nullptr);
-
   const uint32_t overprovisioning_factor = PROTOBUF_GET_WRAPPED_OR_DEFAULT(
       cluster_load_assignment_.policy(), overprovisioning_factor, kDefaultOverProvisioningFactor);
   const bool weighted_priority_health =
@@ -144,6 +169,21 @@ void EdsClusterImpl::BatchUpdateHelper::batchUpdate(PrioritySet::HostUpdateCb& h
     parent_.info_->configUpdateStats().update_no_rebuild_.inc();
   }
 
+  if (reuse_unchanged_hosts_) {
+    // A host created by this update may have been discarded in favor of an existing host with the
+    // same address, which was updated in place. The endpoint maps to the host which was kept.
+    const HostMapConstSharedPtr updated_hosts = parent_.prioritySet().crossPriorityHostMap();
+    for (const auto& [endpoint_hash, address] : created_hosts_) {
+      const auto host = updated_hosts->find(address);
+      if (host != updated_hosts->end()) {
+        reused_hosts_.emplace(endpoint_hash, host->second);
+      }
+    }
+    parent_.hosts_by_endpoint_hash_ = std::move(reused_hosts_);
+  } else {
+    parent_.hosts_by_endpoint_hash_.clear();
+  }
+
   // If we didn't setup to initialize when our first round of health checking is complete, just
   // do it now.
   parent_.onPreInitComplete();
@@ -152,7 +192,17 @@ void EdsClusterImpl::BatchUpdateHelper::batchUpdate(PrioritySet::HostUpdateCb& h
 void EdsClusterImpl::BatchUpdateHelper::updateLocalityEndpoints(
     const envoy::config::endpoint::v3::LbEndpoint& lb_endpoint,
     const envoy::config::endpoint::v3::LocalityLbEndpoints& locality_lb_endpoint,
-    PriorityStateManager& priority_state_manager, absl::flat_hash_set<std::string>& all_new_hosts) {
+    uint64_t locality_hash, PriorityStateManager& priority_state_manager,
+    absl::flat_hash_set<std::string>& all_new_hosts, const HostMap& all_hosts) {
+  uint64_t endpoint_hash = 0;
+  if (reuse_unchanged_hosts_) {
+    endpoint_hash = HashUtil::xxHash64(lb_endpoint.SerializeAsString(), locality_hash);
+    if (reuseUnchangedHost(endpoint_hash, locality_lb_endpoint, priority_state_manager,
+                           all_new_hosts, all_hosts)) {
+      return;
+    }
+  }
+
   const auto address =
       THROW_OR_RETURN_VALUE(parent_.resolveProtoAddress(lb_endpoint.endpoint().address()),
                             const Network::Address::InstanceConstSharedPtr);
@@ -176,6 +226,37 @@ void EdsClusterImpl::BatchUpdateHelper::updateLocalityEndpoints(
                                                  address_list, locality_lb_endpoint, lb_endpoint,
                                                  parent_.time_source_);
   all_new_hosts.emplace(address_as_string);
+  if (reuse_unchanged_hosts_) {
+    created_hosts_.emplace_back(endpoint_hash, address_as_string);
+  }
+}
+
+bool EdsClusterImpl::BatchUpdateHelper::reuseUnchangedHost(
+    uint64_t endpoint_hash,
+    const envoy::config::endpoint::v3::LocalityLbEndpoints& locality_lb_endpoint,
+    PriorityStateManager& priority_state_manager, absl::flat_hash_set<std::string>& all_new_hosts,
+    const HostMap& all_hosts) {
+  const auto previous = parent_.hosts_by_endpoint_hash_.find(endpoint_hash);
+  if (previous == parent_.hosts_by_endpoint_hash_.end()) {
+    return false;
+  }
+  const HostSharedPtr& host = previous->second;
+  const std::string& address_as_string = host->address()->asString();
+  // The host is only reused if it is still the cluster's host for its address, in which case
+  // updateDynamicHostList() would have updated it in place with the same configuration.
+  const auto existing_host = all_hosts.find(address_as_string);
+  if (existing_host == all_hosts.end() || existing_host->second != host) {
+    return false;
+  }
+  // When the configuration contains duplicate hosts, only the first one will be retained.
+  if (all_new_hosts.contains(address_as_string)) {
+    return true;
+  }
+
+  priority_state_manager.registerHostForPriority(host, locality_lb_endpoint);
+  all_new_hosts.emplace(address_as_string);
+  reused_hosts_.emplace(endpoint_hash, host);
+  return true;
 }
 
 absl::Status
@@ -83,12 +83,13 @@ private:
   // Returns true iff all the LEDS based localities were updated.
   bool validateAllLedsUpdated() const;
 
+  using HostsByEndpointHash = absl::flat_hash_map<uint64_t, HostSharedPtr>;
+
   class BatchUpdateHelper : public PrioritySet::BatchUpdateCb {
   public:
     BatchUpdateHelper(
         EdsClusterImpl& parent,
-        const envoy::config::endpoint::v3::ClusterLoadAssignment& cluster_load_assignment)
-        : parent_(parent), cluster_load_assignment_(cluster_load_assignment) {}
+        const envoy::config::endpoint::v3::ClusterLoadAssignment& cluster_load_assignment);
 
     // Upstream::PrioritySet::BatchUpdateCb
     void batchUpdate(PrioritySet::HostUpdateCb& host_update_cb) override;
@@ -97,11 +98,23 @@ private:
     void updateLocalityEndpoints(
         const envoy::config::endpoint::v3::LbEndpoint& lb_endpoint,
         const envoy::config::endpoint::v3::LocalityLbEndpoints& locality_lb_endpoint,
+        uint64_t locality_hash, PriorityStateManager& priority_state_manager,
+        absl::flat_hash_set<std::string>& all_new_hosts, const HostMap& all_hosts);
+    // Registers the host of the previous update for the endpoint, if the endpoint is unchanged
+    // since then. Returns false if a new host must be created for the endpoint.
+    bool reuseUnchangedHost(
+        uint64_t endpoint_hash,
+        const envoy::config::endpoint::v3::LocalityLbEndpoints& locality_lb_endpoint,
         PriorityStateManager& priority_state_manager,
-        absl::flat_hash_set<std::string>& all_new_hosts);
+        absl::flat_hash_set<std::string>& all_new_hosts, const HostMap& all_hosts);
 
     EdsClusterImpl& parent_;
     const envoy::config::endpoint::v3::ClusterLoadAssignment& cluster_load_assignment_;
+    const bool reuse_unchanged_hosts_;
+    // The hosts of this update which can be reused by the next update, keyed by endpoint hash.
+    HostsByEndpointHash reused_hosts_;
+    // The endpoints of this update for which a new host was created, and the address of the host.
+    std::vector<std::pair<uint64_t, std::string>> created_hosts_;
   };
 
   Config::SubscriptionPtr subscription_;
@@ -127,6 +140,11 @@ private:
 
   // Tracks whether a cached resource is used as the current EDS resource.
   bool using_cached_resource_{false};
+
+  // The hosts of the last update, keyed by a hash of their endpoint, locality and priority
+  // configuration. An endpoint which is unchanged in the next update reuses its host instead of
+  // creating a new one, which is then discarded in favor of the existing host.
+  HostsByEndpointHash hosts_by_endpoint_hash_;
 };
 
 using EdsClusterImplSharedPtr = std::shared_ptr<EdsClusterImpl>;
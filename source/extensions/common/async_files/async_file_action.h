@@ -63,13 +63,30 @@ public:
       : on_complete_(on_complete) {}
 
   void execute() final {
+    if (!startExecution()) {
+      return;
+    }
+    deliverResult(executeImpl());
+  }
+
+protected:
+  // Moves the action from queued to executing. Returns false if the action was
+  // cancelled before it started, in which case it must not be performed.
+  bool startExecution() {
     State expected = State::Queued;
     if (!state_.compare_exchange_strong(expected, State::Executing)) {
       ASSERT(expected == State::Cancelled);
-      return;
+      return false;
     }
-    expected = State::Executing;
-    T result = executeImpl();
+    return true;
+  }
+
+  // Calls the callback with the result of an executing action, or
+  // onCancelledBeforeCallback if the action was cancelled while executing.
+  // Actions whose execution completes asynchronously (e.g. io_uring operations)
+  // call startExecution and deliverResult themselves rather than using execute.
+  void deliverResult(T result) {
+    State expected = State::Executing;
     if (!state_.compare_exchange_strong(expected, State::InCallback)) {
       ASSERT(expected == State::Cancelled);
       onCancelledBeforeCallback(std::move(result));
@@ -79,7 +96,6 @@ public:
     state_.store(State::Done);
   }
 
-protected:
   // Performs any action to undo side-effects of the execution if the callback
   // has not yet been called (e.g. closing a file that was just opened).
   // Not necessary for things that don't make persistent resources,
@@ -0,0 +1,328 @@
+#include "source/extensions/common/async_files/async_file_context_io_uring.h"
+
+#include <fcntl.h>
+#include <limits.h>
+
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "source/common/buffer/buffer_impl.h"
+#include "source/extensions/common/async_files/async_file_action.h"
+#include "source/extensions/common/async_files/async_file_context_base.h"
+#include "source/extensions/common/async_files/async_file_manager_io_uring.h"
+#include "source/extensions/common/async_files/status_after_file_error.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace Common {
+namespace AsyncFiles {
+
+namespace {
+
+template <typename T> class AsyncFileActionIoUring : public AsyncFileActionWithResult<T> {
+public:
+  explicit AsyncFileActionIoUring(AsyncFileHandle handle, std::function<void(T)> on_complete)
+      : AsyncFileActionWithResult<T>(on_complete), handle_(std::move(handle)) {}
+
+protected:
+  int& fileDescriptor() { return context()->fileDescriptor(); }
+  AsyncFileContextIoUring* context() const {
+    return static_cast<AsyncFileContextIoUring*>(handle_.get());
+  }
+
+  Api::OsSysCalls& posix() const {
+    return static_cast<AsyncFileManagerIoUring&>(context()->manager()).posix();
+  }
+
+  AsyncFileHandle handle_;
+};
+
+class ActionStat : public AsyncFileActionIoUring<absl::StatusOr<struct stat>> {
+public:
+  ActionStat(AsyncFileHandle handle, std::function<void(absl::StatusOr<struct stat>)> on_complete)
+      : AsyncFileActionIoUring<absl::StatusOr<struct stat>>(handle, on_complete) {}
+
+  absl::StatusOr<struct stat> executeImpl() override {
+    ASSERT(fileDescriptor() != -1);
+    struct stat stat_result;
+    auto result = posix().fstat(fileDescriptor(), &stat_result);
+    if (result.return_value_ != 0) {
+      return statusAfterFileError(result);
+    }
+    return stat_result;
+  }
+};
+
+class ActionCreateHardLink : public AsyncFileActionIoUring<absl::Status> {
+public:
+  ActionCreateHardLink(AsyncFileHandle handle, absl::string_view filename,
+                       std::function<void(absl::Status)> on_complete)
+      : AsyncFileActionIoUring<absl::Status>(handle, on_complete), filename_(filename) {}
+
+  absl::Status executeImpl() override {
+    ASSERT(fileDescriptor() != -1);
+    std::string procfile = absl::StrCat("/proc/self/fd/", fileDescriptor());
+    auto result = posix().linkat(fileDescriptor(), procfile.c_str(), AT_FDCWD, filename_.c_str(),
+                                 AT_SYMLINK_FOLLOW);
+    if (result.return_value_ == -1) {
+      return statusAfterFileError(result);
+    }
+    return absl::OkStatus();
+  }
+
+  void onCancelledBeforeCallback(absl::Status result) override {
+    if (result.ok()) {
+      posix().unlink(filename_.c_str());
+    }
+  }
+
+private:
+  const std::string filename_;
+};
+
+class ActionCloseFile : public AsyncFileActionIoUring<absl::Status> {
+public:
+  // As with the thread pool, take a copy of the file descriptor because close
+  // sets the context's file descriptor to -1.
+  explicit ActionCloseFile(AsyncFileHandle handle, std::function<void(absl::Status)> on_complete)
+      : AsyncFileActionIoUring<absl::Status>(handle, on_complete),
+        file_descriptor_(fileDescriptor()) {}
+
+  absl::Status executeImpl() override {
+    auto result = posix().close(file_descriptor_);
+    if (result.return_value_ == -1) {
+      return statusAfterFileError(result);
+    }
+    return absl::OkStatus();
+  }
+
+private:
+  const int file_descriptor_;
+};
+
+class ActionDuplicateFile : public AsyncFileActionIoUring<absl::StatusOr<AsyncFileHandle>> {
+public:
+  ActionDuplicateFile(AsyncFileHandle handle,
+                      std::function<void(absl::StatusOr<AsyncFileHandle>)> on_complete)
+      : AsyncFileActionIoUring<absl::StatusOr<AsyncFileHandle>>(handle, on_complete) {}
+
+  absl::StatusOr<AsyncFileHandle> executeImpl() override {
+    ASSERT(fileDescriptor() != -1);
+    auto newfd = posix().duplicate(fileDescriptor());
+    if (newfd.return_value_ == -1) {
+      return statusAfterFileError(newfd);
+    }
+    return std::make_shared<AsyncFileContextIoUring>(context()->manager(), newfd.return_value_,
+                                                     context()->directIo());
+  }
+
+  void onCancelledBeforeCallback(absl::StatusOr<AsyncFileHandle> result) override {
+    if (result.ok()) {
+      result.value()->close([](absl::Status) {}).IgnoreError();
+    }
+  }
+};
+
+// Base for the actions performed by the ring rather than by execute().
+template <typename T>
+class AsyncFileActionSubmitted : public AsyncFileActionIoUring<T>, public IoUringFileAction {
+public:
+  using AsyncFileActionIoUring<T>::AsyncFileActionIoUring;
+
+  bool start() override { return this->startExecution(); }
+
+protected:
+  T executeImpl() override { PANIC("io_uring actions are not executed synchronously"); }
+  bool cancelled() const {
+    return this->state_.load() == AsyncFileAction::State::Cancelled;
+  }
+};
+
+struct FreeDeleter {
+  void operator()(uint8_t* p) const { std::free(p); }
+};
+
+size_t alignUp(size_t n) {
+  return (n + AsyncFileContextIoUring::DirectIoAlignment - 1) &
+         ~(AsyncFileContextIoUring::DirectIoAlignment - 1);
+}
+
+class ActionReadFile : public AsyncFileActionSubmitted<absl::StatusOr<Buffer::InstancePtr>> {
+public:
+  ActionReadFile(AsyncFileHandle handle, off_t offset, size_t length,
+                 std::function<void(absl::StatusOr<Buffer::InstancePtr>)> on_complete)
+      : AsyncFileActionSubmitted<absl::StatusOr<Buffer::InstancePtr>>(handle, on_complete),
+        offset_(offset), length_(length) {
+    if (context()->directIo()) {
+      // O_DIRECT requires the offset, length and buffer to all be aligned.
+      read_offset_ = offset_ & ~static_cast<off_t>(AsyncFileContextIoUring::DirectIoAlignment - 1);
+      read_length_ = alignUp(offset_ + length_) - read_offset_;
+    } else {
+      read_offset_ = offset_;
+      read_length_ = length_;
+    }
+  }
+
+  bool start() override {
+    if (!startExecution()) {
+      return false;
+    }
+    // Allocated here rather than on construction so that queued reads that are
+    // cancelled don't hold memory.
+    memory_.reset(static_cast<uint8_t*>(
+        std::aligned_alloc(AsyncFileContextIoUring::DirectIoAlignment,
+                           std::max(alignUp(read_length_),
+                                    AsyncFileContextIoUring::DirectIoAlignment))));
+    RELEASE_ASSERT(memory_ != nullptr, "aligned_alloc failed");
+    return true;
+  }
+
+  void prepare(struct io_uring_sqe* sqe) override {
+    ASSERT(fileDescriptor() != -1);
+    io_uring_prep_read(sqe, fileDescriptor(), memory_.get(), read_length_, read_offset_);
+  }
+
+  bool onCompletion(int32_t result) override {
+    if (result < 0) {
+      deliverResult(statusAfterFileError(-result));
+      return true;
+    }
+    const size_t skip = offset_ - read_offset_;
+    const size_t bytes_read = static_cast<size_t>(result);
+    const size_t available = bytes_read > skip ? std::min(bytes_read - skip, length_) : 0;
+    auto buffer = std::make_unique<Buffer::OwnedImpl>();
+    if (available * 2 <= read_length_) {
+      // Most of the block is unused (a short read, or a small read widened for
+      // direct I/O); copy the result so the block can be released now.
+      buffer->add(memory_.get() + skip, available);
+    } else {
+      uint8_t* memory = memory_.release();
+      auto* fragment = new Buffer::BufferFragmentImpl(
+          memory + skip, available,
+          [memory](const void*, size_t, const Buffer::BufferFragmentImpl* fragment) {
+            std::free(memory);
+            delete fragment;
+          });
+      buffer->addBufferFragment(*fragment);
+    }
+    deliverResult(std::move(buffer));
+    return true;
+  }
+
+private:
+  const off_t offset_;
+  const size_t length_;
+  off_t read_offset_;
+  size_t read_length_;
+  std::unique_ptr<uint8_t, FreeDeleter> memory_;
+};
+
+class ActionWriteFile : public AsyncFileActionSubmitted<absl::StatusOr<size_t>> {
+public:
+  ActionWriteFile(AsyncFileHandle handle, Buffer::Instance& contents, off_t offset,
+                  std::function<void(absl::StatusOr<size_t>)> on_complete)
+      : AsyncFileActionSubmitted<absl::StatusOr<size_t>>(handle, on_complete), offset_(offset) {
+    contents_.move(contents);
+  }
+
+  void prepare(struct io_uring_sqe* sqe) override {
+    ASSERT(fileDescriptor() != -1);
+    // The whole buffer is written with one writev; if there are more slices than
+    // a writev accepts, the remainder is written like a short write.
+    iovecs_.clear();
+    for (const Buffer::RawSlice& slice : contents_.getRawSlices(IOV_MAX)) {
+      iovecs_.push_back({slice.mem_, slice.len_});
+    }
+    io_uring_prep_writev(sqe, fileDescriptor(), iovecs_.data(), iovecs_.size(),
+                         offset_ + bytes_written_);
+  }
+
+  bool onCompletion(int32_t result) override {
+    if (result < 0) {
+      deliverResult(statusAfterFileError(-result));
+      return true;
+    }
+    bytes_written_ += result;
+    contents_.drain(result);
+    if (contents_.length() > 0) {
+      if (result == 0) {
+        deliverResult(absl::InternalError("AsyncFileContextIoUring::write made no progress"));
+        return true;
+      }
+      if (!cancelled()) {
+        return false;
+      }
+    }
+    deliverResult(bytes_written_);
+    return true;
+  }
+
+private:
+  Buffer::OwnedImpl contents_;
+  const off_t offset_;
+  size_t bytes_written_ = 0;
+  std::vector<struct iovec> iovecs_;
+};
+
+} // namespace
+
+absl::StatusOr<CancelFunction>
+AsyncFileContextIoUring::stat(std::function<void(absl::StatusOr<struct stat>)> on_complete) {
+  return checkFileAndEnqueue(std::make_shared<ActionStat>(handle(), std::move(on_complete)));
+}
+
+absl::StatusOr<CancelFunction>
+AsyncFileContextIoUring::createHardLink(absl::string_view filename,
+                                        std::function<void(absl::Status)> on_complete) {
+  return checkFileAndEnqueue(
+      std::make_shared<ActionCreateHardLink>(handle(), filename, std::move(on_complete)));
+}
+
+absl::Status AsyncFileContextIoUring::close(std::function<void(absl::Status)> on_complete) {
+  auto status =
+      checkFileAndEnqueue(std::make_shared<ActionCloseFile>(handle(), std::move(on_complete)))
+          .status();
+  fileDescriptor() = -1;
+  return status;
+}
+
+absl::StatusOr<CancelFunction> AsyncFileContextIoUring::read(
+    off_t offset, size_t length,
+    std::function<void(absl::StatusOr<Buffer::InstancePtr>)> on_complete) {
+  return checkFileAndEnqueue(
+      std::make_shared<ActionReadFile>(handle(), offset, length, std::move(on_complete)));
+}
+
+absl::StatusOr<CancelFunction>
+AsyncFileContextIoUring::write(Buffer::Instance& contents, off_t offset,
+                               std::function<void(absl::StatusOr<size_t>)> on_complete) {
+  return checkFileAndEnqueue(
+      std::make_shared<ActionWriteFile>(handle(), contents, offset, std::move(on_complete)));
+}
+
+absl::StatusOr<CancelFunction> AsyncFileContextIoUring::duplicate(
+    std::function<void(absl::StatusOr<AsyncFileHandle>)> on_complete) {
+  return checkFileAndEnqueue(
+      std::make_shared<ActionDuplicateFile>(handle(), std::move(on_complete)));
+}
+
+absl::StatusOr<CancelFunction>
+AsyncFileContextIoUring::checkFileAndEnqueue(std::shared_ptr<AsyncFileAction> action) {
+  if (fileDescriptor() == -1) {
+    return absl::FailedPreconditionError("file was already closed");
+  }
+  return enqueue(action);
+}
+
+AsyncFileContextIoUring::AsyncFileContextIoUring(AsyncFileManager& manager, int fd,
+                                                 bool direct_io)
+    : AsyncFileContextBase(manager), file_descriptor_(fd), direct_io_(direct_io) {}
+
+AsyncFileContextIoUring::~AsyncFileContextIoUring() { ASSERT(file_descriptor_ == -1); }
+
+} // namespace AsyncFiles
+} // namespace Common
+} // namespace Extensions
+} // namespace Envoy
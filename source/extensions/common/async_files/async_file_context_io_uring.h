@@ -0,0 +1,62 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "source/common/buffer/buffer_impl.h"
+#include "source/extensions/common/async_files/async_file_context_base.h"
+
+#include "absl/status/statusor.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace Common {
+namespace AsyncFiles {
+
+class AsyncFileManager;
+
+// The io_uring implementation of an AsyncFileContext - reads and writes are
+// submitted to the manager's ring, other operations are synchronous posix calls
+// on the ring thread.
+//
+// If the file was opened with O_DIRECT, reads are widened to the direct I/O
+// alignment and read into aligned memory, and the requested range is returned
+// without copying where that doesn't waste most of the block.
+class AsyncFileContextIoUring final : public AsyncFileContextBase {
+public:
+  // The offset, length and memory alignment used for O_DIRECT reads.
+  static constexpr size_t DirectIoAlignment = 4096;
+
+  AsyncFileContextIoUring(AsyncFileManager& manager, int fd, bool direct_io);
+
+  absl::StatusOr<CancelFunction>
+  stat(std::function<void(absl::StatusOr<struct stat>)> on_complete) override;
+  absl::StatusOr<CancelFunction>
+  createHardLink(absl::string_view filename,
+                 std::function<void(absl::Status)> on_complete) override;
+  absl::Status close(std::function<void(absl::Status)> on_complete) override;
+  absl::StatusOr<CancelFunction>
+  read(off_t offset, size_t length,
+       std::function<void(absl::StatusOr<Buffer::InstancePtr>)> on_complete) override;
+  absl::StatusOr<CancelFunction>
+  write(Buffer::Instance& contents, off_t offset,
+        std::function<void(absl::StatusOr<size_t>)> on_complete) override;
+  absl::StatusOr<CancelFunction>
+  duplicate(std::function<void(absl::StatusOr<AsyncFileHandle>)> on_complete) override;
+
+  int& fileDescriptor() { return file_descriptor_; }
+  bool directIo() const { return direct_io_; }
+
+  ~AsyncFileContextIoUring() override;
+
+protected:
+  absl::StatusOr<CancelFunction> checkFileAndEnqueue(std::shared_ptr<AsyncFileAction> action);
+
+  int file_descriptor_;
+  const bool direct_io_;
+};
+
+} // namespace AsyncFiles
+} // namespace Common
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,395 @@
+#include "source/extensions/common/async_files/async_file_manager_io_uring.h"
+
+#include <fcntl.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "envoy/common/exception.h"
+
+#include "source/common/common/utility.h"
+#include "source/common/io/io_uring_impl.h"
+#include "source/extensions/common/async_files/async_file_action.h"
+#include "source/extensions/common/async_files/async_file_context_io_uring.h"
+#include "source/extensions/common/async_files/status_after_file_error.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace Common {
+namespace AsyncFiles {
+
+namespace {
+// The manager whose ring thread is the current thread, if any. Actions enqueued
+// from a callback on the ring thread are chained rather than queued.
+thread_local AsyncFileManagerIoUring* ThreadRingManager = nullptr;
+
+constexpr uint32_t DefaultQueueDepth = 256;
+} // namespace
+
+AsyncFileManagerIoUring::AsyncFileManagerIoUring(
+    const envoy::extensions::common::async_files::v3::AsyncFileManagerConfig& config,
+    Api::OsSysCalls& posix)
+    : queue_depth_(config.io_uring().queue_depth() == 0 ? DefaultQueueDepth
+                                                        : config.io_uring().queue_depth()),
+      direct_io_(config.io_uring().direct_io()), posix_(posix) {
+  if (!posix.supportsAllPosixFileOperations()) {
+    throw EnvoyException("AsyncFileManagerIoUring not supported");
+  }
+  if (!Io::isIoUringSupported()) {
+    throw EnvoyException("AsyncFileManagerIoUring: io_uring is not supported by this kernel");
+  }
+  int ret = io_uring_queue_init(queue_depth_, &ring_, 0);
+  if (ret < 0) {
+    throw EnvoyException(fmt::format("AsyncFileManagerIoUring: unable to initialize io_uring: {}",
+                                     errorDetails(-ret)));
+  }
+  wakeup_fd_ = eventfd(0, EFD_CLOEXEC);
+  if (wakeup_fd_ == -1) {
+    const int error = errno;
+    io_uring_queue_exit(&ring_);
+    throw EnvoyException(
+        fmt::format("AsyncFileManagerIoUring: unable to create eventfd: {}", errorDetails(error)));
+  }
+  ENVOY_LOG(info, fmt::format("AsyncFileManagerIoUring created with id '{}', with queue depth {}{}",
+                              config.id(), queue_depth_, direct_io_ ? " and direct I/O" : ""));
+  ring_thread_ = std::thread([this]() { run(); });
+}
+
+AsyncFileManagerIoUring::~AsyncFileManagerIoUring() ABSL_LOCKS_EXCLUDED(queue_mutex_) {
+  {
+    absl::MutexLock lock(&queue_mutex_);
+    terminate_ = true;
+  }
+  const uint64_t one = 1;
+  RELEASE_ASSERT(::write(wakeup_fd_, &one, sizeof(one)) == sizeof(one), "eventfd write failed");
+  ring_thread_.join();
+  io_uring_queue_exit(&ring_);
+  ::close(wakeup_fd_);
+}
+
+std::string AsyncFileManagerIoUring::describe() const {
+  return absl::StrCat("io_uring queue_depth = ", queue_depth_, direct_io_ ? ", direct_io" : "");
+}
+
+CancelFunction AsyncFileManagerIoUring::enqueue(std::shared_ptr<AsyncFileAction> action) {
+  auto cancel_func = [action]() { action->cancel(); };
+  if (ThreadRingManager == this) {
+    chained_.push_back(std::move(action));
+    return cancel_func;
+  }
+  bool was_empty;
+  {
+    absl::MutexLock lock(&queue_mutex_);
+    was_empty = queue_.empty();
+    queue_.push_back(std::move(action));
+  }
+  // Only the first action of a batch needs to wake the ring thread; it takes
+  // the whole queue at once.
+  if (was_empty) {
+    const uint64_t one = 1;
+    RELEASE_ASSERT(::write(wakeup_fd_, &one, sizeof(one)) == sizeof(one), "eventfd write failed");
+  }
+  return cancel_func;
+}
+
+void AsyncFileManagerIoUring::run() {
+  ThreadRingManager = this;
+  armWakeup();
+  std::vector<std::shared_ptr<AsyncFileAction>> actions;
+  while (true) {
+    {
+      absl::MutexLock lock(&queue_mutex_);
+      if (terminate_) {
+        break;
+      }
+      actions.swap(queue_);
+    }
+    startActions(actions);
+    actions.clear();
+    int ret = io_uring_submit_and_wait(&ring_, 1);
+    if (ret < 0 && ret != -EINTR) {
+      ENVOY_LOG(warn, "AsyncFileManagerIoUring: io_uring_submit_and_wait failed: {}",
+                errorDetails(-ret));
+    }
+    reapCompletions();
+  }
+  // Queued actions are dropped, as with the thread pool. Operations already in
+  // the ring must finish before the ring and their buffers are released, but
+  // their callbacks are not called.
+  draining_ = true;
+  for (auto& [uring_action, action] : in_flight_) {
+    action->cancel();
+  }
+  if (wakeup_armed_) {
+    const uint64_t one = 1;
+    RELEASE_ASSERT(::write(wakeup_fd_, &one, sizeof(one)) == sizeof(one), "eventfd write failed");
+  }
+  while (!in_flight_.empty() || wakeup_armed_) {
+    io_uring_submit_and_wait(&ring_, 1);
+    reapCompletions();
+  }
+  chained_.clear();
+  ThreadRingManager = nullptr;
+}
+
+void AsyncFileManagerIoUring::startActions(std::vector<std::shared_ptr<AsyncFileAction>>& actions) {
+  for (std::shared_ptr<AsyncFileAction>& action : actions) {
+    startAction(std::move(action));
+  }
+  // Synchronous actions may have chained further actions from their callbacks.
+  while (!chained_.empty()) {
+    std::vector<std::shared_ptr<AsyncFileAction>> chained;
+    chained.swap(chained_);
+    for (std::shared_ptr<AsyncFileAction>& action : chained) {
+      startAction(std::move(action));
+    }
+  }
+}
+
+void AsyncFileManagerIoUring::startAction(std::shared_ptr<AsyncFileAction> action) {
+  auto* uring_action = dynamic_cast<IoUringFileAction*>(action.get());
+  if (uring_action == nullptr) {
+    action->execute();
+    return;
+  }
+  if (!uring_action->start()) {
+    return;
+  }
+  struct io_uring_sqe* sqe = getSqe();
+  uring_action->prepare(sqe);
+  io_uring_sqe_set_data(sqe, uring_action);
+  in_flight_.emplace(uring_action, std::move(action));
+}
+
+void AsyncFileManagerIoUring::reapCompletions() {
+  // Copy the completions out before handling them, so that resubmissions and
+  // callbacks don't interleave with walking the completion queue.
+  std::vector<std::pair<IoUringFileAction*, int32_t>> completions;
+  struct io_uring_cqe* cqe;
+  unsigned head;
+  io_uring_for_each_cqe(&ring_, head, cqe) {
+    completions.emplace_back(static_cast<IoUringFileAction*>(io_uring_cqe_get_data(cqe)),
+                             cqe->res);
+  }
+  io_uring_cq_advance(&ring_, completions.size());
+
+  for (const auto& [uring_action, result] : completions) {
+    if (uring_action == nullptr) {
+      wakeup_armed_ = false;
+      continue;
+    }
+    auto it = in_flight_.find(uring_action);
+    ASSERT(it != in_flight_.end());
+    if (uring_action->onCompletion(result)) {
+      in_flight_.erase(it);
+    } else {
+      struct io_uring_sqe* sqe = getSqe();
+      uring_action->prepare(sqe);
+      io_uring_sqe_set_data(sqe, uring_action);
+    }
+  }
+  if (!wakeup_armed_ && !draining_) {
+    armWakeup();
+  }
+}
+
+void AsyncFileManagerIoUring::armWakeup() {
+  struct io_uring_sqe* sqe = getSqe();
+  io_uring_prep_read(sqe, wakeup_fd_, &wakeup_value_, sizeof(wakeup_value_), 0);
+  io_uring_sqe_set_data(sqe, nullptr);
+  wakeup_armed_ = true;
+}
+
+struct io_uring_sqe* AsyncFileManagerIoUring::getSqe() {
+  struct io_uring_sqe* sqe = io_uring_get_sqe(&ring_);
+  if (sqe == nullptr) {
+    // The submission queue is full; submitting empties it.
+    io_uring_submit(&ring_);
+    sqe = io_uring_get_sqe(&ring_);
+  }
+  RELEASE_ASSERT(sqe != nullptr, "io_uring submission queue still full after submit");
+  return sqe;
+}
+
+namespace {
+
+class ActionWithFileResult : public AsyncFileActionWithResult<absl::StatusOr<AsyncFileHandle>> {
+public:
+  ActionWithFileResult(AsyncFileManagerIoUring& manager,
+                       std::function<void(absl::StatusOr<AsyncFileHandle>)> on_complete)
+      : AsyncFileActionWithResult(on_complete), manager_(manager) {}
+
+protected:
+  void onCancelledBeforeCallback(absl::StatusOr<AsyncFileHandle> result) override {
+    if (result.ok()) {
+      result.value()->close([](absl::Status) {}).IgnoreError();
+    }
+  }
+  AsyncFileManagerIoUring& manager_;
+  Api::OsSysCalls& posix() { return manager_.posix(); }
+};
+
+class ActionCreateAnonymousFile : public ActionWithFileResult {
+public:
+  ActionCreateAnonymousFile(AsyncFileManagerIoUring& manager, absl::string_view path,
+                            std::function<void(absl::StatusOr<AsyncFileHandle>)> on_complete)
+      : ActionWithFileResult(manager, on_complete), path_(path) {}
+
+  absl::StatusOr<AsyncFileHandle> executeImpl() override {
+    Api::SysCallIntResult open_result;
+#ifdef O_TMPFILE
+    // All actions run on the ring thread, so the first attempt needs no once_flag.
+    if (manager_.supports_o_tmpfile_.value_or(true)) {
+      open_result = posix().open(path_.c_str(), O_TMPFILE | O_RDWR, S_IRUSR | S_IWUSR);
+      if (open_result.return_value_ != -1) {
+        manager_.supports_o_tmpfile_ = true;
+        return std::make_shared<AsyncFileContextIoUring>(manager_, open_result.return_value_,
+                                                         false);
+      }
+      if (manager_.supports_o_tmpfile_.has_value()) {
+        return statusAfterFileError(open_result);
+      }
+      manager_.supports_o_tmpfile_ = false;
+    }
+#endif // O_TMPFILE
+    // If O_TMPFILE didn't work, fall back to creating a named file and unlinking it.
+    char filename[4096];
+    static const char file_suffix[] = "/buffer.XXXXXX";
+    if (path_.size() + sizeof(file_suffix) > sizeof(filename)) {
+      return absl::InvalidArgumentError(
+          "AsyncFileManagerIoUring::createAnonymousFile: pathname too long for tmpfile");
+    }
+    snprintf(filename, sizeof(filename), "%s%s", path_.c_str(), file_suffix);
+    open_result = posix().mkstemp(filename);
+    if (open_result.return_value_ == -1) {
+      return statusAfterFileError(open_result);
+    }
+    if (posix().unlink(filename).return_value_ != 0) {
+      posix().close(open_result.return_value_);
+      posix().unlink(filename);
+      return absl::UnimplementedError(
+          "AsyncFileManagerIoUring::createAnonymousFile: not supported for "
+          "target filesystem (failed to unlink an open file)");
+    }
+    return std::make_shared<AsyncFileContextIoUring>(manager_, open_result.return_value_, false);
+  }
+
+private:
+  const std::string path_;
+};
+
+class ActionOpenExistingFile : public ActionWithFileResult {
+public:
+  ActionOpenExistingFile(AsyncFileManagerIoUring& manager, absl::string_view filename,
+                         AsyncFileManager::Mode mode,
+                         std::function<void(absl::StatusOr<AsyncFileHandle>)> on_complete)
+      : ActionWithFileResult(manager, on_complete), filename_(filename), mode_(mode) {}
+
+  absl::StatusOr<AsyncFileHandle> executeImpl() override {
+    // Only files opened for reading use direct I/O; writes go through the page
+    // cache so that callers don't have to align what they write.
+    if (mode_ == AsyncFileManager::Mode::ReadOnly && manager_.directIo()) {
+      auto open_result = posix().open(filename_.c_str(), O_RDONLY | O_DIRECT);
+      if (open_result.return_value_ != -1) {
+        return std::make_shared<AsyncFileContextIoUring>(manager_, open_result.return_value_,
+                                                         true);
+      }
+      // EINVAL means the filesystem doesn't support O_DIRECT; use buffered reads instead.
+      if (open_result.errno_ != EINVAL) {
+        return statusAfterFileError(open_result);
+      }
+    }
+    auto open_result = posix().open(filename_.c_str(), openFlags());
+    if (open_result.return_value_ == -1) {
+      return statusAfterFileError(open_result);
+    }
+    return std::make_shared<AsyncFileContextIoUring>(manager_, open_result.return_value_, false);
+  }
+
+private:
+  int openFlags() const {
+    switch (mode_) {
+    case AsyncFileManager::Mode::ReadOnly:
+      return O_RDONLY;
+    case AsyncFileManager::Mode::WriteOnly:
+      return O_WRONLY;
+    case AsyncFileManager::Mode::ReadWrite:
+      return O_RDWR;
+    }
+    PANIC_DUE_TO_CORRUPT_ENUM;
+  }
+  const std::string filename_;
+  const AsyncFileManager::Mode mode_;
+};
+
+class ActionStat : public AsyncFileActionWithResult<absl::StatusOr<struct stat>> {
+public:
+  ActionStat(Api::OsSysCalls& posix, absl::string_view filename,
+             std::function<void(absl::StatusOr<struct stat>)> on_complete)
+      : AsyncFileActionWithResult(on_complete), posix_(posix), filename_(filename) {}
+
+  absl::StatusOr<struct stat> executeImpl() override {
+    struct stat ret;
+    Api::SysCallIntResult stat_result = posix_.stat(filename_.c_str(), &ret);
+    if (stat_result.return_value_ == -1) {
+      return statusAfterFileError(stat_result);
+    }
+    return ret;
+  }
+
+private:
+  Api::OsSysCalls& posix_;
+  const std::string filename_;
+};
+
+class ActionUnlink : public AsyncFileActionWithResult<absl::Status> {
+public:
+  ActionUnlink(Api::OsSysCalls& posix, absl::string_view filename,
+               std::function<void(absl::Status)> on_complete)
+      : AsyncFileActionWithResult(on_complete), posix_(posix), filename_(filename) {}
+
+  absl::Status executeImpl() override {
+    Api::SysCallIntResult unlink_result = posix_.unlink(filename_.c_str());
+    if (unlink_result.return_value_ == -1) {
+      return statusAfterFileError(unlink_result);
+    }
+    return absl::OkStatus();
+  }
+
+private:
+  Api::OsSysCalls& posix_;
+  const std::string filename_;
+};
+
+} // namespace
+
+CancelFunction AsyncFileManagerIoUring::createAnonymousFile(
+    absl::string_view path, std::function<void(absl::StatusOr<AsyncFileHandle>)> on_complete) {
+  return enqueue(std::make_shared<ActionCreateAnonymousFile>(*this, path, on_complete));
+}
+
+CancelFunction AsyncFileManagerIoUring::openExistingFile(
+    absl::string_view filename, Mode mode,
+    std::function<void(absl::StatusOr<AsyncFileHandle>)> on_complete) {
+  return enqueue(std::make_shared<ActionOpenExistingFile>(*this, filename, mode, on_complete));
+}
+
+CancelFunction
+AsyncFileManagerIoUring::stat(absl::string_view filename,
+                              std::function<void(absl::StatusOr<struct stat>)> on_complete) {
+  return enqueue(std::make_shared<ActionStat>(posix(), filename, on_complete));
+}
+
+CancelFunction AsyncFileManagerIoUring::unlink(absl::string_view filename,
+                                               std::function<void(absl::Status)> on_complete) {
+  return enqueue(std::make_shared<ActionUnlink>(posix(), filename, on_complete));
+}
+
+} // namespace AsyncFiles
+} // namespace Common
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "envoy/extensions/common/async_files/v3/async_file_manager.pb.h"
+
+#include "source/common/common/logger.h"
+#include "source/extensions/common/async_files/async_file_handle.h"
+#include "source/extensions/common/async_files/async_file_manager.h"
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/statusor.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/types/optional.h"
+#include "liburing.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace Common {
+namespace AsyncFiles {
+
+// An action whose file operation is submitted to the io_uring instead of being
+// performed by execute(). Implemented by the read and write actions of
+// AsyncFileContextIoUring.
+class IoUringFileAction {
+public:
+  virtual ~IoUringFileAction() = default;
+
+  // Called on the ring thread when the action reaches the front of the queue.
+  // Returns false if the action was cancelled before it started, in which case
+  // nothing is submitted.
+  virtual bool start() PURE;
+
+  // Fills in sqe with the next operation to perform for this action.
+  virtual void prepare(struct io_uring_sqe* sqe) PURE;
+
+  // Called on the ring thread with the result of the submitted operation.
+  // Returns true if the action is complete, or false if it must be prepared and
+  // submitted again (e.g. to finish a short write).
+  virtual bool onCompletion(int32_t result) PURE;
+};
+
+// An AsyncFileManager which performs reads and writes with io_uring.
+//
+// A single ring thread owns the ring. Actions enqueued from other threads are
+// collected by the ring thread and submitted together, so a burst of requests
+// costs one io_uring_enter rather than one thread wake-up per request. Actions
+// enqueued from a callback are submitted in the same batch as the other
+// callbacks' follow-ups, without going back through the queue.
+//
+// Operations that io_uring does not make cheaper (open, stat, link, unlink,
+// close) are performed synchronously on the ring thread, as the thread pool
+// manager does. Callbacks are called on the ring thread.
+class AsyncFileManagerIoUring : public AsyncFileManager,
+                                protected Logger::Loggable<Logger::Id::main> {
+public:
+  explicit AsyncFileManagerIoUring(
+      const envoy::extensions::common::async_files::v3::AsyncFileManagerConfig& config,
+      Api::OsSysCalls& posix);
+  ~AsyncFileManagerIoUring() ABSL_LOCKS_EXCLUDED(queue_mutex_) override;
+  CancelFunction
+  createAnonymousFile(absl::string_view path,
+                      std::function<void(absl::StatusOr<AsyncFileHandle>)> on_complete) override;
+  CancelFunction
+  openExistingFile(absl::string_view filename, Mode mode,
+                   std::function<void(absl::StatusOr<AsyncFileHandle>)> on_complete) override;
+  CancelFunction stat(absl::string_view filename,
+                      std::function<void(absl::StatusOr<struct stat>)> on_complete) override;
+  CancelFunction unlink(absl::string_view filename,
+                        std::function<void(absl::Status)> on_complete) override;
+  std::string describe() const override;
+  Api::OsSysCalls& posix() const { return posix_; }
+
+  // True if files opened read-only should be opened with O_DIRECT.
+  bool directIo() const { return direct_io_; }
+
+  // Whether opening anonymous files with O_TMPFILE works; unset until the first
+  // attempt. Only accessed from the ring thread.
+  absl::optional<bool> supports_o_tmpfile_;
+
+private:
+  CancelFunction enqueue(std::shared_ptr<AsyncFileAction> action)
+      ABSL_LOCKS_EXCLUDED(queue_mutex_) override;
+  void run() ABSL_LOCKS_EXCLUDED(queue_mutex_);
+  void startActions(std::vector<std::shared_ptr<AsyncFileAction>>& actions);
+  void startAction(std::shared_ptr<AsyncFileAction> action);
+  void reapCompletions();
+  void armWakeup();
+  struct io_uring_sqe* getSqe();
+
+  const uint32_t queue_depth_;
+  const bool direct_io_;
+  Api::OsSysCalls& posix_;
+  struct io_uring ring_;
+  // Written by enqueue to wake the ring thread; the ring keeps a read of it in flight.
+  int wakeup_fd_;
+  uint64_t wakeup_value_;
+  bool wakeup_armed_ = false;
+  // Set by the ring thread once it stops taking new actions.
+  bool draining_ = false;
+
+  absl::Mutex queue_mutex_;
+  std::vector<std::shared_ptr<AsyncFileAction>> queue_ ABSL_GUARDED_BY(queue_mutex_);
+  bool terminate_ ABSL_GUARDED_BY(queue_mutex_) = false;
+
+  // Actions enqueued from callbacks on the ring thread, started after the
+  // current batch of completions has been handled.
+  std::vector<std::shared_ptr<AsyncFileAction>> chained_;
+  // Actions with an operation in the ring, keyed by the sqe user_data.
+  absl::flat_hash_map<IoUringFileAction*, std::shared_ptr<AsyncFileAction>> in_flight_;
+
+  std::thread ring_thread_;
+};
+
+} // namespace AsyncFiles
+} // namespace Common
+} // namespace Extensions
+} // namespace Envoy
@@ -1,10 +1,12 @@
 #include "source/extensions/filters/common/local_ratelimit/local_ratelimit_impl.h"
 
+#include <algorithm>
 #include <chrono>
 #include <cmath>
 
 #include "envoy/runtime/runtime.h"
 
+#include "source/common/common/lock_guard.h"
 #include "source/common/protobuf/utility.h"
 #include "source/common/runtime/runtime_features.h"
 
@@ -167,12 +169,98 @@ bool AtomicTokenBucket::consume(double factor) {
   return token_bucket_.consume(cb) != 0.0;
 }
 
+namespace {
+// Shards are added for every this many dynamic descriptors, so that small maps keep a strict LRU
+// order and large ones spread their lookups over several mutexes.
+constexpr uint32_t MinDynamicDescriptorsPerShard = 1024;
+constexpr uint32_t MaxDynamicDescriptorShards = 16;
+} // namespace
+
+DynamicDescriptorMap::DynamicDescriptorMap(uint32_t max_descriptors, TimeSource& time_source)
+    : time_source_(time_source) {
+  const uint32_t num_shards = std::clamp(max_descriptors / MinDynamicDescriptorsPerShard, 1U,
+                                         MaxDynamicDescriptorShards);
+  shards_.reserve(num_shards);
+  for (uint32_t i = 0; i < num_shards; i++) {
+    shards_.push_back(std::make_unique<Shard>());
+  }
+  max_buckets_per_shard_ = std::max(1U, (max_descriptors + num_shards - 1) / num_shards);
+}
+
+void DynamicDescriptorMap::addDescriptor(RateLimit::LocalDescriptor descriptor,
+                                         uint32_t max_tokens, uint32_t tokens_per_fill,
+                                         std::chrono::milliseconds fill_interval) {
+  descriptors_.push_back({std::move(descriptor), max_tokens, tokens_per_fill, fill_interval});
+}
+
+bool DynamicDescriptorMap::matches(const RateLimit::LocalDescriptor& wildcard_descriptor,
+                                   const RateLimit::LocalDescriptor& request_descriptor) {
+  if (wildcard_descriptor.entries_.size() != request_descriptor.entries_.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < wildcard_descriptor.entries_.size(); i++) {
+    const auto& wildcard_entry = wildcard_descriptor.entries_[i];
+    const auto& request_entry = request_descriptor.entries_[i];
+    if (wildcard_entry.key_ != request_entry.key_ ||
+        (!wildcard_entry.value_.empty() && wildcard_entry.value_ != request_entry.value_)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+RateLimitTokenBucketSharedPtr
+DynamicDescriptorMap::getBucket(const RateLimit::LocalDescriptor& request_descriptor) {
+  const WildcardDescriptor* wildcard_descriptor = nullptr;
+  for (const auto& descriptor : descriptors_) {
+    if (matches(descriptor.descriptor_, request_descriptor)) {
+      wildcard_descriptor = &descriptor;
+      break;
+    }
+  }
+  if (wildcard_descriptor == nullptr) {
+    return nullptr;
+  }
+
+  // Pick the shard by the high bits of the hash, as the hash map of the shard uses the low ones.
+  const uint64_t hash = RateLimit::LocalDescriptor::Hash()(request_descriptor);
+  Shard& shard = *shards_[(hash >> 32) % shards_.size()];
+
+  Thread::LockGuard lock(shard.mutex_);
+  if (auto it = shard.buckets_.find(request_descriptor); it != shard.buckets_.end()) {
+    shard.lru_list_.splice(shard.lru_list_.begin(), shard.lru_list_, it->second);
+    return it->second->second;
+  }
+
+  // Dynamic buckets are always refilled lazily, so that they need no timer.
+  auto bucket = std::make_shared<AtomicTokenBucket>(
+      wildcard_descriptor->max_tokens_, wildcard_descriptor->tokens_per_fill_,
+      wildcard_descriptor->fill_interval_, time_source_);
+  shard.lru_list_.emplace_front(request_descriptor, bucket);
+  shard.buckets_.emplace(request_descriptor, shard.lru_list_.begin());
+  if (shard.lru_list_.size() > max_buckets_per_shard_) {
+    shard.buckets_.erase(shard.lru_list_.back().first);
+    shard.lru_list_.pop_back();
+  }
+  return bucket;
+}
+
+size_t DynamicDescriptorMap::size() const {
+  size_t size = 0;
+  for (const auto& shard : shards_) {
+    Thread::LockGuard lock(shard->mutex_);
+    size += shard->buckets_.size();
+  }
+  return size;
+}
+
 LocalRateLimiterImpl::LocalRateLimiterImpl(
     const std::chrono::milliseconds fill_interval, const uint32_t max_tokens,
     const uint32_t tokens_per_fill, Event::Dispatcher& dispatcher,
     const Protobuf::RepeatedPtrField<
         envoy::extensions::common::ratelimit::v3::LocalRateLimitDescriptor>& descriptors,
-    bool always_consume_default_token_bucket, ShareProviderSharedPtr shared_provider)
+    bool always_consume_default_token_bucket, ShareProviderSharedPtr shared_provider,
+    uint32_t max_dynamic_descriptors)
     : fill_timer_(fill_interval > std::chrono::milliseconds(0)
                       ? dispatcher.createTimer([this] { onFillTimer(); })
                       : nullptr),
@@ -217,6 +305,18 @@ LocalRateLimiterImpl::LocalRateLimiterImpl(
     // Save the multiplicative factor to control the descriptor refill frequency.
     const auto per_descriptor_multiplier = per_descriptor_fill_interval / fill_interval;
 
+    if (std::any_of(new_descriptor.entries_.begin(), new_descriptor.entries_.end(),
+                    [](const RateLimit::DescriptorEntry& entry) { return entry.value_.empty(); })) {
+      if (dynamic_descriptors_ == nullptr) {
+        dynamic_descriptors_ =
+            std::make_unique<DynamicDescriptorMap>(max_dynamic_descriptors, time_source_);
+      }
+      dynamic_descriptors_->addDescriptor(std::move(new_descriptor), per_descriptor_max_tokens,
+                                          per_descriptor_tokens_per_fill,
+                                          per_descriptor_fill_interval);
+      continue;
+    }
+
     RateLimitTokenBucketSharedPtr per_descriptor_token_bucket;
     if (no_timer_based_rate_limit_token_bucket_) {
       per_descriptor_token_bucket = std::make_shared<AtomicTokenBucket>(
@@ -267,15 +367,31 @@ LocalRateLimiterImpl::Result LocalRateLimiterImpl::requestAllowed(
   // In most cases the request descriptors has only few elements. We use a inlined vector to
   // avoid heap allocation.
   absl::InlinedVector<RateLimitTokenBucket*, 8> matched_descriptors;
+  // The matched buckets of dynamic descriptors, which must outlive the request.
+  absl::InlinedVector<RateLimitTokenBucketSharedPtr, 4> dynamic_descriptors;
 
   // Find all matched descriptors.
   for (const auto& request_descriptor : request_descriptors) {
     auto iter = descriptors_.find(request_descriptor);
     if (iter != descriptors_.end()) {
       matched_descriptors.push_back(iter->second.get());
+    } else if (dynamic_descriptors_ != nullptr) {
+      if (auto bucket = dynamic_descriptors_->getBucket(request_descriptor); bucket != nullptr) {
+        matched_descriptors.push_back(bucket.get());
+        dynamic_descriptors.push_back(std::move(bucket));
+      }
     }
   }
 
+  const auto keep_alive = [&dynamic_descriptors](const RateLimitTokenBucket* descriptor) {
+    for (const auto& bucket : dynamic_descriptors) {
+      if (bucket.get() == descriptor) {
+        return std::shared_ptr<const TokenBucketContext>(bucket);
+      }
+    }
+    return std::shared_ptr<const TokenBucketContext>();
+  };
+
   if (matched_descriptors.size() > 1) {
     // Sort the matched descriptors by token bucket fill rate to ensure the descriptor with the
     // smallest fill rate is consumed first.
@@ -293,7 +409,7 @@ LocalRateLimiterImpl::Result LocalRateLimiterImpl::requestAllowed(
     if (!descriptor->consume(share_factor)) {
       // If the request is forbidden by a descriptor, return the result and the descriptor
       // token bucket.
-      return {false, makeOptRefFromPtr<TokenBucketContext>(descriptor)};
+      return {false, makeOptRefFromPtr<TokenBucketContext>(descriptor), keep_alive(descriptor)};
     }
   }
 
@@ -307,13 +423,14 @@ LocalRateLimiterImpl::Result LocalRateLimiterImpl::requestAllowed(
 
     // If the request is allowed then return the result the token bucket. The descriptor
     // token bucket will be selected as priority if it exists.
-    return {true, makeOptRefFromPtr<TokenBucketContext>(matched_descriptors.empty()
-                                                            ? default_token_bucket_.get()
-                                                            : matched_descriptors[0])};
-  };
+    if (matched_descriptors.empty()) {
+      return {true, makeOptRefFromPtr<TokenBucketContext>(default_token_bucket_.get())};
+    }
+  }
 
   ASSERT(!matched_descriptors.empty());
-  return {true, makeOptRefFromPtr<TokenBucketContext>(matched_descriptors[0])};
+  return {true, makeOptRefFromPtr<TokenBucketContext>(matched_descriptors[0]),
+          keep_alive(matched_descriptors[0])};
 }
 
 } // namespace LocalRateLimit
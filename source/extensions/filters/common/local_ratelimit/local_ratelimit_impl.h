@@ -1,6 +1,7 @@
 #pragma once
 
 #include <chrono>
+#include <list>
 #include <ratio>
 
 #include "envoy/event/dispatcher.h"
@@ -10,6 +11,7 @@
 #include "envoy/singleton/instance.h"
 #include "envoy/upstream/cluster_manager.h"
 
+#include "source/common/common/thread.h"
 #include "source/common/common/thread_synchronizer.h"
 #include "source/common/common/token_bucket_impl.h"
 #include "source/common/protobuf/protobuf.h"
@@ -129,20 +131,75 @@ private:
   AtomicTokenBucketImpl token_bucket_;
 };
 
+// Token buckets of the descriptors with wildcard entries, i.e. entries with an empty value. A
+// bucket is created for each distinct request descriptor matching one of them when it is first
+// seen, and the least recently used buckets are evicted beyond max_descriptors. The buckets are
+// split into shards with a mutex each, which is held to find a bucket but never to consume from it.
+class DynamicDescriptorMap {
+public:
+  DynamicDescriptorMap(uint32_t max_descriptors, TimeSource& time_source);
+
+  void addDescriptor(RateLimit::LocalDescriptor descriptor, uint32_t max_tokens,
+                     uint32_t tokens_per_fill, std::chrono::milliseconds fill_interval);
+  bool empty() const { return descriptors_.empty(); }
+
+  /**
+   * @return the token bucket of the request descriptor, or nullptr if it matches none of the
+   *         wildcard descriptors.
+   */
+  RateLimitTokenBucketSharedPtr getBucket(const RateLimit::LocalDescriptor& request_descriptor);
+
+  /**
+   * @return the number of token buckets currently held.
+   */
+  size_t size() const;
+
+private:
+  struct WildcardDescriptor {
+    RateLimit::LocalDescriptor descriptor_;
+    uint32_t max_tokens_;
+    uint32_t tokens_per_fill_;
+    std::chrono::milliseconds fill_interval_;
+  };
+
+  struct Shard {
+    using LruList = std::list<std::pair<RateLimit::LocalDescriptor, RateLimitTokenBucketSharedPtr>>;
+
+    mutable Thread::MutexBasicLockable mutex_;
+    // Most recently used first.
+    LruList lru_list_ ABSL_GUARDED_BY(mutex_);
+    RateLimit::LocalDescriptor::Map<LruList::iterator> buckets_ ABSL_GUARDED_BY(mutex_);
+  };
+
+  static bool matches(const RateLimit::LocalDescriptor& wildcard_descriptor,
+                      const RateLimit::LocalDescriptor& request_descriptor);
+
+  TimeSource& time_source_;
+  std::vector<WildcardDescriptor> descriptors_;
+  std::vector<std::unique_ptr<Shard>> shards_;
+  uint32_t max_buckets_per_shard_{};
+};
+
 class LocalRateLimiterImpl {
 public:
   struct Result {
     bool allowed{};
     OptRef<const TokenBucketContext> token_bucket_context{};
+    // Keeps the token bucket of a dynamic descriptor, which may be evicted at any time, alive for
+    // as long as token_bucket_context refers to it.
+    std::shared_ptr<const TokenBucketContext> dynamic_token_bucket{};
   };
 
+  static constexpr uint32_t DefaultMaxDynamicDescriptors = 20;
+
   LocalRateLimiterImpl(
       const std::chrono::milliseconds fill_interval, const uint32_t max_tokens,
       const uint32_t tokens_per_fill, Event::Dispatcher& dispatcher,
       const Protobuf::RepeatedPtrField<
           envoy::extensions::common::ratelimit::v3::LocalRateLimitDescriptor>& descriptors,
       bool always_consume_default_token_bucket = true,
-      ShareProviderSharedPtr shared_provider = nullptr);
+      ShareProviderSharedPtr shared_provider = nullptr,
+      uint32_t max_dynamic_descriptors = DefaultMaxDynamicDescriptors);
   ~LocalRateLimiterImpl();
 
   Result requestAllowed(absl::Span<const RateLimit::LocalDescriptor> request_descriptors) const;
@@ -155,6 +212,8 @@ private:
   const Event::TimerPtr fill_timer_;
   TimeSource& time_source_;
   RateLimit::LocalDescriptor::Map<RateLimitTokenBucketSharedPtr> descriptors_;
+  // Only set if some of the descriptors have wildcard entries.
+  std::unique_ptr<DynamicDescriptorMap> dynamic_descriptors_;
   // Refill counter is incremented per each refill timer hit.
   uint64_t refill_counter_{0};
 
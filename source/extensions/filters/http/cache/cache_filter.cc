@@ -5,6 +5,7 @@
 #include "source/common/common/enum_to_int.h"
 #include "source/common/http/headers.h"
 #include "source/common/http/utility.h"
+#include "source/common/protobuf/utility.h"
 #include "source/extensions/filters/http/cache/cache_custom_headers.h"
 #include "source/extensions/filters/http/cache/cache_entry_utils.h"
 #include "source/extensions/filters/http/cache/cache_filter_logging_info.h"
@@ -43,9 +44,15 @@ using CacheResponseCodeDetails = ConstSingleton<CacheResponseCodeDetailValues>;
 
 CacheFilterConfig::CacheFilterConfig(
     const envoy::extensions::filters::http::cache::v3::CacheConfig& config,
+    const std::string& stats_prefix, Stats::Scope& scope,
     Server::Configuration::CommonFactoryContext& context)
     : vary_allow_list_(config.allowed_vary_headers(), context), time_source_(context.timeSource()),
-      ignore_request_cache_control_header_(config.ignore_request_cache_control_header()) {}
+      ignore_request_cache_control_header_(config.ignore_request_cache_control_header()),
+      stats_(generateStats(stats_prefix + "cache.", scope)),
+      fill_coalescer_(config.has_request_coalescing_timeout() ? std::make_shared<FillCoalescer>()
+                                                              : nullptr),
+      request_coalescing_timeout_(
+          PROTOBUF_GET_MS_OR_DEFAULT(config, request_coalescing_timeout, 0)) {}
 
 CacheFilter::CacheFilter(std::shared_ptr<const CacheFilterConfig> config,
                          std::shared_ptr<HttpCache> http_cache)
@@ -53,6 +60,12 @@ CacheFilter::CacheFilter(std::shared_ptr<const CacheFilterConfig> config,
 
 void CacheFilter::onDestroy() {
   filter_state_ = FilterState::Destroyed;
+  if (fill_wait_timer_ != nullptr) {
+    fill_wait_timer_->disableTimer();
+  }
+  // If this request was filling the cache but never got as far as inserting
+  // the response, release any requests waiting on it.
+  fill_.reset();
   if (lookup_ != nullptr) {
     lookup_->onDestroy();
   }
@@ -107,6 +120,9 @@ Http::FilterHeadersStatus CacheFilter::decodeHeaders(Http::RequestHeaderMap& hea
                                config_->ignoreRequestCacheControlHeader());
   request_allows_inserts_ = !lookup_request.requestCacheControl().no_store_;
   is_head_request_ = headers.getMethodValue() == Http::Headers::get().MethodValues.Head;
+  if (config_->fillCoalescer() != nullptr) {
+    fill_key_ = lookup_request.key().SerializeAsString();
+  }
   lookup_ = cache_->makeLookupContext(std::move(lookup_request), *decoder_callbacks_);
 
   ASSERT(lookup_);
@@ -130,6 +146,14 @@ Http::FilterHeadersStatus CacheFilter::encodeHeaders(Http::ResponseHeaderMap& he
     return Http::FilterHeadersStatus::Continue;
   }
 
+  if (fill_wait_timer_ != nullptr) {
+    // A local reply was generated while this request was waiting on another
+    // request's fill, e.g. because the stream timed out; don't cache it.
+    fill_wait_timer_.reset();
+    filter_state_ = FilterState::NotServingFromCache;
+    return Http::FilterHeadersStatus::Continue;
+  }
+
   if (lookup_result_ == nullptr) {
     // Filter chain iteration is paused while a lookup is outstanding, but the filter chain manager
     // can still generate a local reply. One case where this can happen is when a downstream idle
@@ -170,6 +194,8 @@ Http::FilterHeadersStatus CacheFilter::encodeHeaders(Http::ResponseHeaderMap& he
                                                insert_queue_ = nullptr;
                                                insert_status_ = InsertStatus::InsertAbortedByCache;
                                              });
+      // Requests waiting on this one are released when the insert completes.
+      insert_queue_->setFill(std::move(fill_));
       // Add metadata associated with the cached response. Right now this is only response_time;
       const ResponseMetadata metadata = {config_->timeSource().systemTime()};
       insert_queue_->insertHeaders(headers, metadata, end_stream);
@@ -182,6 +208,8 @@ Http::FilterHeadersStatus CacheFilter::encodeHeaders(Http::ResponseHeaderMap& he
   } else {
     insert_status_ = InsertStatus::NoInsertResponseNotCacheable;
   }
+  // If the response isn't being inserted, requests waiting on this one go upstream themselves.
+  fill_.reset();
   filter_state_ = FilterState::NotServingFromCache;
   return Http::FilterHeadersStatus::Continue;
 }
@@ -402,6 +430,9 @@ void CacheFilter::onHeaders(LookupResult&& result, Http::RequestHeaderMap& reque
   case CacheEntryStatus::FoundNotModified:
     PANIC("unsupported code");
   case CacheEntryStatus::RequiresValidation:
+    if (waitForInFlightFill(request_headers)) {
+      return;
+    }
     // If a cache entry requires validation, inject validation headers in the
     // request and let it pass through as if no cache entry was found. If the
     // cache entry was valid, the response status should be 304 (unmodified)
@@ -409,6 +440,9 @@ void CacheFilter::onHeaders(LookupResult&& result, Http::RequestHeaderMap& reque
     handleCacheHitWithValidation(request_headers);
     return;
   case CacheEntryStatus::Ok:
+    if (waited_for_fill_) {
+      config_->stats().collapsed_requests_served_from_cache_.inc();
+    }
     if (lookup_result_->range_details_.has_value()) {
       handleCacheHitWithRangeRequest();
       return;
@@ -416,6 +450,9 @@ void CacheFilter::onHeaders(LookupResult&& result, Http::RequestHeaderMap& reque
     handleCacheHit(/* end_stream_after_headers = */ end_stream);
     return;
   case CacheEntryStatus::Unusable:
+    if (waitForInFlightFill(request_headers)) {
+      return;
+    }
     decoder_callbacks_->continueDecoding();
     return;
   case CacheEntryStatus::LookupError:
@@ -430,6 +467,74 @@ void CacheFilter::onHeaders(LookupResult&& result, Http::RequestHeaderMap& reque
   decoder_callbacks_->continueDecoding();
 }
 
+bool CacheFilter::waitForInFlightFill(Http::RequestHeaderMap& request_headers) {
+  const FillCoalescerSharedPtr& coalescer = config_->fillCoalescer();
+  // HEAD requests and requests that don't allow inserts can't fill the cache,
+  // so they neither lead nor wait.
+  if (coalescer == nullptr || waited_for_fill_ || !request_allows_inserts_ || is_head_request_) {
+    return false;
+  }
+  // As with the lookup callbacks, the filter may be destroyed before the
+  // posted callback runs.
+  CacheFilterWeakPtr self = weak_from_this();
+  fill_ = coalescer->joinOrStartFill(fill_key_, decoder_callbacks_->dispatcher(),
+                                     [self, &request_headers](bool fill_succeeded) {
+                                       if (CacheFilterSharedPtr cache_filter = self.lock()) {
+                                         cache_filter->onFillComplete(request_headers,
+                                                                      fill_succeeded);
+                                       }
+                                     });
+  if (fill_ != nullptr) {
+    // This request fills the cache; others for the same key will wait on it.
+    return false;
+  }
+  ENVOY_STREAM_LOG(debug, "CacheFilter waiting for in-flight fill", *decoder_callbacks_);
+  config_->stats().collapsed_requests_.inc();
+  waited_for_fill_ = true;
+  fill_wait_timer_ = decoder_callbacks_->dispatcher().createTimer([this, &request_headers]() {
+    ENVOY_STREAM_LOG(debug, "CacheFilter timed out waiting for in-flight fill",
+                     *decoder_callbacks_);
+    config_->stats().collapsed_requests_timed_out_.inc();
+    continueWithoutFill(request_headers);
+  });
+  fill_wait_timer_->enableTimer(config_->requestCoalescingTimeout());
+  return true;
+}
+
+void CacheFilter::onFillComplete(Http::RequestHeaderMap& request_headers, bool fill_succeeded) {
+  if (filter_state_ == FilterState::Destroyed || fill_wait_timer_ == nullptr) {
+    // The filter is being destroyed, or stopped waiting already.
+    return;
+  }
+  if (!fill_succeeded) {
+    continueWithoutFill(request_headers);
+    return;
+  }
+  fill_wait_timer_->disableTimer();
+  fill_wait_timer_.reset();
+  // The response should now be in the cache; look it up again.
+  lookup_->onDestroy();
+  lookup_result_.reset();
+  lookup_ = cache_->makeLookupContext(LookupRequest(request_headers,
+                                                    config_->timeSource().systemTime(),
+                                                    config_->varyAllowList(),
+                                                    config_->ignoreRequestCacheControlHeader()),
+                                      *decoder_callbacks_);
+  ASSERT(lookup_);
+  getHeaders(request_headers);
+}
+
+void CacheFilter::continueWithoutFill(Http::RequestHeaderMap& request_headers) {
+  ASSERT(fill_wait_timer_ != nullptr);
+  fill_wait_timer_->disableTimer();
+  fill_wait_timer_.reset();
+  if (lookup_result_->cache_entry_status_ == CacheEntryStatus::RequiresValidation) {
+    handleCacheHitWithValidation(request_headers);
+  } else {
+    decoder_callbacks_->continueDecoding();
+  }
+}
+
 // TODO(toddmgreer): Handle downstream backpressure.
 void CacheFilter::onBody(Buffer::InstancePtr&& body, bool end_stream) {
   // Can be called during decoding if a valid cache hit is found,
@@ -618,10 +723,16 @@ void CacheFilter::processSuccessfulValidation(Http::ResponseHeaderMap& response_
     // TODO(yosrym93): else the cached entry should be deleted.
     // Update metadata associated with the cached response. Right now this is only response_time;
     const ResponseMetadata metadata = {config_->timeSource().systemTime()};
+    // Requests waiting on this validation are released once the entry is updated.
     cache_->updateHeaders(*lookup_, response_headers, metadata,
-                          [](bool updated ABSL_ATTRIBUTE_UNUSED) {});
+                          [fill = std::move(fill_)](bool updated) {
+                            if (fill != nullptr) {
+                              fill->complete(updated);
+                            }
+                          });
     insert_status_ = InsertStatus::HeaderUpdate;
   }
+  fill_.reset();
 
   // A cache entry was successfully validated -> encode cached body and trailers.
   encodeCachedResponse(/* end_stream_after_headers = */ false);
@@ -735,7 +846,7 @@ void CacheFilter::finalizeEncodingCachedResponse() {
 }
 
 LookupStatus CacheFilter::lookupStatus() const {
-  if (lookup_result_ == nullptr && lookup_ != nullptr) {
+  if ((lookup_result_ == nullptr && lookup_ != nullptr) || fill_wait_timer_ != nullptr) {
     return LookupStatus::RequestIncomplete;
   }
 
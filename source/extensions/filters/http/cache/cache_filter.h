@@ -6,11 +6,14 @@
 #include <vector>
 
 #include "envoy/extensions/filters/http/cache/v3/cache.pb.h"
+#include "envoy/stats/scope.h"
+#include "envoy/stats/stats_macros.h"
 
 #include "source/common/common/logger.h"
 #include "source/extensions/filters/http/cache/cache_filter_logging_info.h"
 #include "source/extensions/filters/http/cache/cache_headers_utils.h"
 #include "source/extensions/filters/http/cache/cache_insert_queue.h"
+#include "source/extensions/filters/http/cache/fill_coalescer.h"
 #include "source/extensions/filters/http/cache/http_cache.h"
 #include "source/extensions/filters/http/common/pass_through_filter.h"
 
@@ -46,20 +49,52 @@ enum class FilterState {
   Destroyed
 };
 
+/**
+ * All cache filter stats. @see stats_macros.h
+ */
+#define ALL_CACHE_FILTER_STATS(COUNTER)                                                            \
+  COUNTER(collapsed_requests)                                                                      \
+  COUNTER(collapsed_requests_served_from_cache)                                                    \
+  COUNTER(collapsed_requests_timed_out)
+
+/**
+ * Struct definition for cache filter stats. @see stats_macros.h
+ */
+struct CacheFilterStats {
+  ALL_CACHE_FILTER_STATS(GENERATE_COUNTER_STRUCT)
+};
+
 class CacheFilterConfig {
 public:
   CacheFilterConfig(const envoy::extensions::filters::http::cache::v3::CacheConfig& config,
+                    const std::string& stats_prefix, Stats::Scope& scope,
                     Server::Configuration::CommonFactoryContext& context);
 
   // The allow list rules that decide if a header can be varied upon.
   const VaryAllowList& varyAllowList() const { return vary_allow_list_; }
   TimeSource& timeSource() const { return time_source_; }
   bool ignoreRequestCacheControlHeader() const { return ignore_request_cache_control_header_; }
+  CacheFilterStats& stats() const { return stats_; }
+
+  // The in-flight fills of all the workers using this config, or nullptr if
+  // request coalescing is disabled.
+  const FillCoalescerSharedPtr& fillCoalescer() const { return fill_coalescer_; }
+  // How long a request waits on another request's fill before going upstream.
+  std::chrono::milliseconds requestCoalescingTimeout() const {
+    return request_coalescing_timeout_;
+  }
 
 private:
+  static CacheFilterStats generateStats(const std::string& prefix, Stats::Scope& scope) {
+    return CacheFilterStats{ALL_CACHE_FILTER_STATS(POOL_COUNTER_PREFIX(scope, prefix))};
+  }
+
   const VaryAllowList vary_allow_list_;
   TimeSource& time_source_;
   const bool ignore_request_cache_control_header_;
+  mutable CacheFilterStats stats_;
+  const FillCoalescerSharedPtr fill_coalescer_;
+  const std::chrono::milliseconds request_coalescing_timeout_;
 };
 
 /**
@@ -97,6 +132,21 @@ private:
   void onBody(Buffer::InstancePtr&& bod, bool end_stream);
   void onTrailers(Http::ResponseTrailerMapPtr&& trailers);
 
+  // If request coalescing is enabled and another request is already filling
+  // the cache for this request's key, starts waiting for that fill to complete
+  // and returns true. Otherwise, if possible, makes this request the one
+  // filling the cache, and returns false.
+  bool waitForInFlightFill(Http::RequestHeaderMap& request_headers);
+
+  // Called when the fill this request was waiting on completes. Looks the
+  // response up again if the fill succeeded, otherwise carries on with the
+  // original lookup result.
+  void onFillComplete(Http::RequestHeaderMap& request_headers, bool fill_succeeded);
+
+  // Stops waiting on another request's fill and handles the original lookup
+  // result (a miss or an entry requiring validation) as if it hadn't waited.
+  void continueWithoutFill(Http::RequestHeaderMap& request_headers);
+
   // Set required state in the CacheFilter for handling a cache hit.
   void handleCacheHit(bool end_stream_after_headers);
 
@@ -167,6 +217,19 @@ private:
   // The status of the insert operation or header update, or decision not to insert or update.
   // If it's too early to determine the final status, this is empty.
   absl::optional<InsertStatus> insert_status_;
+
+  // The serialized cache key, used to find fills in flight. Only set if
+  // request coalescing is enabled.
+  std::string fill_key_;
+  // The fill this request is responsible for, which other requests for the
+  // same key may be waiting on. Handed to the insert queue once the response
+  // is being inserted, and released as failed if the response won't be.
+  FillSharedPtr fill_;
+  // Non-null while this request is waiting on another request's fill.
+  Event::TimerPtr fill_wait_timer_;
+  // True once this request has waited on another request's fill, so that it
+  // never waits twice.
+  bool waited_for_fill_ = false;
 };
 
 using CacheFilterSharedPtr = std::shared_ptr<CacheFilter>;
@@ -153,6 +153,7 @@ void CacheInsertQueue::onFragmentComplete(bool cache_success, bool end_stream, s
         watermarked_ = false;
       }
       fragments_.clear();
+      fill_.reset();
       // Clearing self-ownership might provoke the destructor, so take a copy of the
       // abort callback to avoid reading from 'this' after it may be deleted.
       auto abort_callback = abort_callback_;
@@ -163,6 +164,10 @@ void CacheInsertQueue::onFragmentComplete(bool cache_success, bool end_stream, s
     if (end_stream) {
       ASSERT(fragments_.empty(), "ending a stream with the queue not empty is a bug");
       ASSERT(!watermarked_, "being over the high watermark when the queue is empty makes no sense");
+      if (fill_ != nullptr) {
+        fill_->complete(true);
+        fill_.reset();
+      }
       self_ownership_.reset();
       return;
     }
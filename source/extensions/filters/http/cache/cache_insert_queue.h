@@ -3,6 +3,7 @@
 #include <deque>
 #include <functional>
 
+#include "source/extensions/filters/http/cache/fill_coalescer.h"
 #include "source/extensions/filters/http/cache/http_cache.h"
 
 namespace Envoy {
@@ -42,6 +43,10 @@ public:
   void insertBody(const Buffer::Instance& fragment, bool end_stream);
   void insertTrailers(const Http::ResponseTrailerMap& trailers);
   void setSelfOwned(std::unique_ptr<CacheInsertQueue> self);
+  // Completes fill, releasing any requests collapsed onto it, once the whole
+  // response has been accepted by the cache. If the insert is aborted the fill
+  // is released as failed.
+  void setFill(FillSharedPtr fill) { fill_ = std::move(fill); }
   ~CacheInsertQueue();
 
 private:
@@ -78,6 +83,8 @@ private:
   // while a cache action is still in flight, which can cause the cache to be
   // deleted prematurely.
   std::shared_ptr<HttpCache> cache_;
+  // The fill other requests may be waiting on, if request coalescing is enabled.
+  FillSharedPtr fill_;
 };
 
 } // namespace Cache
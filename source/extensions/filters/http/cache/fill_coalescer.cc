@@ -0,0 +1,61 @@
+#include "source/extensions/filters/http/cache/fill_coalescer.h"
+
+#include "source/common/common/assert.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace Cache {
+
+Fill::Fill(std::shared_ptr<FillCoalescer> coalescer, std::string key)
+    : coalescer_(std::move(coalescer)), key_(std::move(key)) {}
+
+Fill::~Fill() { complete(false); }
+
+void Fill::complete(bool fill_succeeded) {
+  if (completed_.exchange(true)) {
+    return;
+  }
+  coalescer_->completeFill(key_, fill_succeeded);
+}
+
+FillSharedPtr FillCoalescer::joinOrStartFill(const std::string& key,
+                                             Event::Dispatcher& dispatcher,
+                                             FillCompleteCallback on_complete) {
+  {
+    absl::MutexLock lock(&mutex_);
+    auto [it, inserted] = fills_.try_emplace(key);
+    if (!inserted) {
+      it->second.push_back(Waiter{dispatcher, std::move(on_complete)});
+      return nullptr;
+    }
+  }
+  return std::make_shared<Fill>(shared_from_this(), key);
+}
+
+size_t FillCoalescer::fillsInFlight() const {
+  absl::MutexLock lock(&mutex_);
+  return fills_.size();
+}
+
+void FillCoalescer::completeFill(const std::string& key, bool fill_succeeded) {
+  std::vector<Waiter> waiters;
+  {
+    absl::MutexLock lock(&mutex_);
+    auto it = fills_.find(key);
+    ASSERT(it != fills_.end(), "completing a fill that is not in flight");
+    waiters = std::move(it->second);
+    fills_.erase(it);
+  }
+  // Post outside the lock; the waiters may be on any worker.
+  for (Waiter& waiter : waiters) {
+    waiter.dispatcher_.post([on_complete = std::move(waiter.on_complete_), fill_succeeded]() {
+      on_complete(fill_succeeded);
+    });
+  }
+}
+
+} // namespace Cache
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "envoy/event/dispatcher.h"
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/synchronization/mutex.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace Cache {
+
+// Called on the waiting request's dispatcher when the fill it was waiting on
+// completes. fill_succeeded is true if the response was handed to the cache
+// in full (or, for a validation, if the cached entry was updated), i.e. if a
+// new lookup is expected to be served from the cache.
+using FillCompleteCallback = std::function<void(bool fill_succeeded)>;
+
+class FillCoalescer;
+
+// Represents a fill (an upstream fetch whose response is being inserted into
+// the cache) that other requests for the same key may be waiting on. Waiters
+// are released when complete() is called or when the last reference to the
+// Fill is dropped, in which case the fill is considered failed.
+class Fill {
+public:
+  Fill(std::shared_ptr<FillCoalescer> coalescer, std::string key);
+  ~Fill();
+
+  // Releases the requests waiting on this fill. Only the first call has any
+  // effect. May be called from any thread.
+  void complete(bool fill_succeeded);
+
+private:
+  const std::shared_ptr<FillCoalescer> coalescer_;
+  const std::string key_;
+  std::atomic<bool> completed_{false};
+};
+using FillSharedPtr = std::shared_ptr<Fill>;
+
+// Tracks the fills in flight for a cache, so that concurrent cache misses for
+// the same key can wait for a single upstream response instead of each
+// sending their own request upstream ("collapsed forwarding").
+//
+// A FillCoalescer is shared by all the workers using the same filter config,
+// so its state is guarded by a mutex, and waiters are resumed by posting to
+// their own dispatcher.
+class FillCoalescer : public std::enable_shared_from_this<FillCoalescer> {
+public:
+  // If no fill is in flight for key, starts one and returns it; the caller is
+  // then expected to fetch the response from upstream and insert it into the
+  // cache. Otherwise registers on_complete to be posted to dispatcher when the
+  // fill in flight completes, and returns nullptr.
+  //
+  // on_complete may be called after the caller has stopped waiting, so it must
+  // check that the caller is still alive and interested.
+  FillSharedPtr joinOrStartFill(const std::string& key, Event::Dispatcher& dispatcher,
+                                FillCompleteCallback on_complete);
+
+  // Returns the number of keys with a fill in flight. For testing.
+  size_t fillsInFlight() const;
+
+private:
+  friend class Fill;
+
+  struct Waiter {
+    Event::Dispatcher& dispatcher_;
+    FillCompleteCallback on_complete_;
+  };
+
+  void completeFill(const std::string& key, bool fill_succeeded);
+
+  mutable absl::Mutex mutex_;
+  // The waiters of each fill in flight, keyed by serialized cache key. A key
+  // is present (with possibly no waiters) for as long as its fill is in flight.
+  absl::flat_hash_map<std::string, std::vector<Waiter>> fills_ ABSL_GUARDED_BY(mutex_);
+};
+using FillCoalescerSharedPtr = std::shared_ptr<FillCoalescer>;
+
+} // namespace Cache
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -38,6 +38,9 @@ FilterConfig::FilterConfig(
           config.has_always_consume_default_token_bucket()
               ? config.always_consume_default_token_bucket().value()
               : true),
+      max_dynamic_descriptors_(PROTOBUF_GET_WRAPPED_OR_DEFAULT(
+          config, max_dynamic_descriptors,
+          Filters::Common::LocalRateLimit::LocalRateLimiterImpl::DefaultMaxDynamicDescriptors)),
       local_info_(local_info), runtime_(runtime),
       filter_enabled_(
           config.has_filter_enabled()
@@ -96,7 +99,7 @@ FilterConfig::FilterConfig(
 
   rate_limiter_ = std::make_unique<Filters::Common::LocalRateLimit::LocalRateLimiterImpl>(
       fill_interval_, max_tokens_, tokens_per_fill_, dispatcher, descriptors_,
-      always_consume_default_token_bucket_, std::move(share_provider));
+      always_consume_default_token_bucket_, std::move(share_provider), max_dynamic_descriptors_);
 }
 
 Filters::Common::LocalRateLimit::LocalRateLimiterImpl::Result FilterConfig::requestAllowed(
@@ -148,8 +151,10 @@ Http::FilterHeadersStatus Filter::decodeHeaders(Http::RequestHeaderMap& headers,
 
   auto result = requestAllowed(descriptors);
   // The global limiter, route limiter, or connection level limiter are all have longer life
-  // than the request, so we can safely store the token bucket context reference.
+  // than the request, so we can safely store the token bucket context reference. Only the token
+  // buckets of dynamic descriptors may be evicted before, so they are kept alive.
   token_bucket_context_ = result.token_bucket_context;
+  dynamic_token_bucket_ = std::move(result.dynamic_token_bucket);
 
   if (result.allowed) {
     used_config_->stats().ok_.inc();
@@ -214,7 +219,7 @@ const Filters::Common::LocalRateLimit::LocalRateLimiterImpl& Filter::getPerConne
     auto limiter = std::make_shared<PerConnectionRateLimiter>(
         used_config_->fillInterval(), used_config_->maxTokens(), used_config_->tokensPerFill(),
         decoder_callbacks_->dispatcher(), used_config_->descriptors(),
-        used_config_->consumeDefaultTokenBucket());
+        used_config_->consumeDefaultTokenBucket(), used_config_->maxDynamicDescriptors());
 
     decoder_callbacks_->streamInfo().filterState()->setData(
         PerConnectionRateLimiter::key(), limiter, StreamInfo::FilterState::StateType::ReadOnly,
@@ -54,9 +54,9 @@ public:
       Envoy::Event::Dispatcher& dispatcher,
       const Protobuf::RepeatedPtrField<
           envoy::extensions::common::ratelimit::v3::LocalRateLimitDescriptor>& descriptor,
-      bool always_consume_default_token_bucket)
+      bool always_consume_default_token_bucket, uint32_t max_dynamic_descriptors)
       : rate_limiter_(fill_interval, max_tokens, tokens_per_fill, dispatcher, descriptor,
-                      always_consume_default_token_bucket) {}
+                      always_consume_default_token_bucket, nullptr, max_dynamic_descriptors) {}
   static const std::string& key();
   const Filters::Common::LocalRateLimit::LocalRateLimiterImpl& value() const {
     return rate_limiter_;
@@ -109,6 +109,7 @@ public:
     return vh_rate_limits_;
   }
   bool consumeDefaultTokenBucket() const { return always_consume_default_token_bucket_; }
+  uint32_t maxDynamicDescriptors() const { return max_dynamic_descriptors_; }
   const absl::optional<Grpc::Status::GrpcStatus> rateLimitedGrpcStatus() const {
     return rate_limited_grpc_status_;
   }
@@ -137,6 +138,7 @@ private:
       descriptors_;
   const bool rate_limit_per_connection_;
   const bool always_consume_default_token_bucket_{};
+  const uint32_t max_dynamic_descriptors_{};
   Filters::Common::LocalRateLimit::ShareProviderManagerSharedPtr share_provider_manager_;
   std::unique_ptr<Filters::Common::LocalRateLimit::LocalRateLimiterImpl> rate_limiter_;
   const LocalInfo::LocalInfo& local_info_;
@@ -188,6 +190,7 @@ private:
   // per-route config.
   const FilterConfig* used_config_{};
   OptRef<const Filters::Common::LocalRateLimit::TokenBucketContext> token_bucket_context_;
+  std::shared_ptr<const Filters::Common::LocalRateLimit::TokenBucketContext> dynamic_token_bucket_;
 
   VhRateLimitOptions vh_rate_limits_;
 };
@@ -121,6 +121,7 @@ public:
   const std::vector<RespValue>& asArray() const;
   std::string& asString();
   const std::string& asString() const;
+  Buffer::Instance& asBufferedString();
   int64_t& asInteger();
   int64_t asInteger() const;
   CompositeArray& asCompositeArray();
@@ -133,17 +134,46 @@ public:
   RespType type() const { return type_; }
   void type(RespType type);
 
+  /**
+   * A bulk string may hold its payload as the buffer slices it was decoded from rather than as a
+   * std::string, so that large values are passed between connections without being copied.
+   * asBufferedString() switches a bulk string to this representation and must only be used while
+   * the value is being built, as copies of the value share the buffer. The non-const asString()
+   * copies the buffer into a std::string the first time it is called, which is only expected for
+   * the arguments which are needed for routing. The const asString() must not be called on a
+   * buffered bulk string, so these arguments are read through a non-const value first. If it is,
+   * it copies the buffer on every call instead.
+   * @return the buffer holding the payload of a bulk string, or nullptr if the payload is held as
+   *         a std::string.
+   */
+  const Buffer::Instance* bufferedString() const { return buffered_string_.get(); }
+
+  /**
+   * @return the buffer holding the payload of a bulk string as a reference which can outlive this
+   *         value, or nullptr if the payload is held as a std::string.
+   */
+  std::shared_ptr<const Buffer::Instance> sharedBufferedString() const { return buffered_string_; }
+
+  /**
+   * @return the length of the payload of a bulk string, error or simple string without copying a
+   *         buffered payload.
+   */
+  uint64_t stringLength() const;
+
 private:
   union {
     std::vector<RespValue> array_;
-    std::string string_;
+    // Mutable so that the const asString() can flatten a buffered bulk string.
+    mutable std::string string_;
     int64_t integer_;
     CompositeArray composite_array_;
   };
 
   void cleanup();
+  void materializeString();
 
   RespType type_{};
+  std::shared_ptr<Buffer::Instance> buffered_string_;
 };
 
 using RespValuePtr = std::unique_ptr<RespValue>;
@@ -7,9 +7,11 @@
 
 #include "envoy/common/platform.h"
 
+#include "source/common/buffer/buffer_impl.h"
 #include "source/common/common/assert.h"
 #include "source/common/common/fmt.h"
 #include "source/common/common/utility.h"
+#include "source/common/runtime/runtime_features.h"
 
 #include "absl/container/fixed_array.h"
 
@@ -18,6 +20,27 @@ namespace Extensions {
 namespace NetworkFilters {
 namespace Common {
 namespace Redis {
+namespace {
+
+// A slice of a buffered bulk string which is being encoded. Each slice holds a reference to the
+// buffer, so that the decoded value can be released before the encoded one is written.
+class BufferedStringSliceFragment : public Buffer::BufferFragment {
+public:
+  BufferedStringSliceFragment(std::shared_ptr<const Buffer::Instance> string,
+                              const Buffer::RawSlice& slice)
+      : string_(std::move(string)), slice_(slice) {}
+
+  // Buffer::BufferFragment
+  const void* data() const override { return slice_.mem_; }
+  size_t size() const override { return slice_.len_; }
+  void done() override { delete this; }
+
+private:
+  const std::shared_ptr<const Buffer::Instance> string_;
+  const Buffer::RawSlice slice_;
+};
+
+} // namespace
 
 std::string RespValue::toString() const {
   switch (type_) {
@@ -45,7 +68,9 @@ std::string RespValue::toString() const {
   case RespType::SimpleString:
   case RespType::BulkString:
   case RespType::Error:
-    return fmt::format("\"{}\"", asString());
+    // Don't copy a buffered bulk string into the value just to log it.
+    return fmt::format("\"{}\"",
+                       buffered_string_ != nullptr ? buffered_string_->toString() : string_);
   case RespType::Null:
     return "null";
   case RespType::Integer:
@@ -68,15 +93,43 @@ const std::vector<RespValue>& RespValue::asArray() const {
 std::string& RespValue::asString() {
   ASSERT(type_ == RespType::BulkString || type_ == RespType::Error ||
          type_ == RespType::SimpleString);
+  materializeString();
   return string_;
 }
 
 const std::string& RespValue::asString() const {
   ASSERT(type_ == RespType::BulkString || type_ == RespType::Error ||
          type_ == RespType::SimpleString);
+  if (buffered_string_ != nullptr) {
+    ENVOY_BUG(false, "buffered bulk strings are read with the non-const asString");
+    // string_ is otherwise unused while the payload is buffered, so flatten the buffer into it.
+    string_ = buffered_string_->toString();
+  }
   return string_;
 }
 
+Buffer::Instance& RespValue::asBufferedString() {
+  ASSERT(type_ == RespType::BulkString);
+  if (buffered_string_ == nullptr) {
+    buffered_string_ = std::make_shared<Buffer::OwnedImpl>(string_);
+    string_.clear();
+  }
+  return *buffered_string_;
+}
+
+uint64_t RespValue::stringLength() const {
+  ASSERT(type_ == RespType::BulkString || type_ == RespType::Error ||
+         type_ == RespType::SimpleString);
+  return buffered_string_ != nullptr ? buffered_string_->length() : string_.size();
+}
+
+void RespValue::materializeString() {
+  if (buffered_string_ != nullptr) {
+    string_ = buffered_string_->toString();
+    buffered_string_.reset();
+  }
+}
+
 int64_t& RespValue::asInteger() {
   ASSERT(type_ == RespType::Integer);
   return integer_;
@@ -112,6 +165,7 @@ void RespValue::cleanup() {
   case RespType::BulkString:
   case RespType::Error: {
     string_.~basic_string<char>();
+    buffered_string_.reset();
     break;
   }
   case RespType::Null:
@@ -162,7 +216,12 @@ RespValue::RespValue(const RespValue& other) : type_(RespType::Null) {
   case RespType::SimpleString:
   case RespType::BulkString:
   case RespType::Error: {
-    asString() = other.asString();
+    // Buffered bulk strings are not modified once decoded, so copies share the buffer.
+    if (other.buffered_string_ != nullptr) {
+      buffered_string_ = other.buffered_string_;
+    } else {
+      asString() = other.asString();
+    }
     break;
   }
   case RespType::Integer: {
@@ -174,7 +233,8 @@ RespValue::RespValue(const RespValue& other) : type_(RespType::Null) {
   }
 }
 
-RespValue::RespValue(RespValue&& other) noexcept : type_(other.type_) {
+RespValue::RespValue(RespValue&& other) noexcept
+    : type_(other.type_), buffered_string_(std::move(other.buffered_string_)) {
   switch (type_) {
   case RespType::Array: {
     new (&array_) std::vector<RespValue>(std::move(other.array_));
@@ -216,7 +276,12 @@ RespValue& RespValue::operator=(const RespValue& other) {
   case RespType::SimpleString:
   case RespType::BulkString:
   case RespType::Error: {
-    asString() = other.asString();
+    // Buffered bulk strings are not modified once decoded, so copies share the buffer.
+    if (other.buffered_string_ != nullptr) {
+      buffered_string_ = other.buffered_string_;
+    } else {
+      asString() = other.asString();
+    }
     break;
   }
   case RespType::Integer: {
@@ -248,6 +313,7 @@ RespValue& RespValue::operator=(RespValue&& other) noexcept {
   case RespType::BulkString:
   case RespType::Error: {
     string_ = std::move(other.string_);
+    buffered_string_ = std::move(other.buffered_string_);
     break;
   }
   case RespType::Integer: {
@@ -278,7 +344,16 @@ bool RespValue::operator==(const RespValue& other) const {
   case RespType::SimpleString:
   case RespType::BulkString:
   case RespType::Error: {
-    result = (asString() == other.asString());
+    if (buffered_string_ == nullptr && other.buffered_string_ == nullptr) {
+      result = (asString() == other.asString());
+    } else {
+      // Compare buffered bulk strings without copying them into either value.
+      const auto contents = [](const RespValue& value) {
+        return value.buffered_string_ != nullptr ? value.buffered_string_->toString()
+                                                 : value.string_;
+      };
+      result = (contents(*this) == contents(other));
+    }
     break;
   }
   case RespType::Integer: {
@@ -329,15 +404,32 @@ RespValue::CompositeArray::CompositeArrayConstIterator::empty() {
   return *instance;
 }
 
+DecoderImpl::DecoderImpl(DecoderCallbacks& callbacks)
+    : callbacks_(callbacks), buffer_bulk_strings_(Runtime::runtimeFeatureEnabled(
+                                 "envoy.reloadable_features.redis_buffered_bulk_strings")) {}
+
 void DecoderImpl::decode(Buffer::Instance& data) {
-  for (const Buffer::RawSlice& slice : data.getRawSlices()) {
-    parseSlice(slice);
-  }
+  while (data.length() != 0) {
+    if (state_ == State::BulkStringBody &&
+        pending_value_stack_.front().value_->bufferedString() != nullptr) {
+      // Move the body out of the connection buffer instead of parsing it. Whole slices are moved
+      // without copying them.
+      const uint64_t length_to_move = std::min(pending_integer_.integer_, data.length());
+      pending_value_stack_.front().value_->asBufferedString().move(data, length_to_move);
+      pending_integer_.integer_ -= length_to_move;
+      if (pending_integer_.integer_ == 0) {
+        ENVOY_LOG(trace, "parse slice: buffered BulkStringBody complete: {} bytes",
+                  pending_value_stack_.front().value_->stringLength());
+        state_ = State::CR;
+      }
+      continue;
+    }
 
-  data.drain(data.length());
+    data.drain(parseSlice(data.frontSlice()));
+  }
 }
 
-void DecoderImpl::parseSlice(const Buffer::RawSlice& slice) {
+uint64_t DecoderImpl::parseSlice(const Buffer::RawSlice& slice) {
   const char* buffer = reinterpret_cast<const char*>(slice.mem_);
   uint64_t remaining = slice.len_;
 
@@ -652,6 +744,9 @@ void DecoderImpl::parseSlice(const Buffer::RawSlice& slice) {
         ASSERT(current_value.value_->type() == RespType::BulkString);
         if (!pending_integer_.negative_) {
           // TODO(mattklein123): reserve and define max length since we don't stream currently.
+          if (buffer_bulk_strings_ && pending_integer_.integer_ >= MinBufferedBulkStringLength) {
+            current_value.value_->asBufferedString();
+          }
           state_ = State::BulkStringBody;
         } else {
           // Null bulk string. Switch type to null and move to value complete.
@@ -665,6 +760,10 @@ void DecoderImpl::parseSlice(const Buffer::RawSlice& slice) {
 
     case State::BulkStringBody: {
       ASSERT(!pending_integer_.negative_);
+      if (pending_value_stack_.front().value_->bufferedString() != nullptr) {
+        // decode() moves the body of a buffered bulk string.
+        return slice.len_ - remaining;
+      }
       uint64_t length_to_copy =
           std::min(static_cast<uint64_t>(pending_integer_.integer_), remaining);
       pending_value_stack_.front().value_->asString().append(buffer, length_to_copy);
@@ -740,6 +839,8 @@ void DecoderImpl::parseSlice(const Buffer::RawSlice& slice) {
     }
     }
   }
+
+  return slice.len_;
 }
 
 void EncoderImpl::encode(const RespValue& value, Buffer::Instance& out) {
@@ -757,7 +858,11 @@ void EncoderImpl::encode(const RespValue& value, Buffer::Instance& out) {
     break;
   }
   case RespType::BulkString: {
-    encodeBulkString(value.asString(), out);
+    if (value.bufferedString() != nullptr) {
+      encodeBufferedBulkString(value.sharedBufferedString(), out);
+    } else {
+      encodeBulkString(value.asString(), out);
+    }
     break;
   }
   case RespType::Error: {
@@ -814,6 +919,21 @@ void EncoderImpl::encodeBulkString(const std::string& string, Buffer::Instance&
   out.add("\r\n", 2);
 }
 
+void EncoderImpl::encodeBufferedBulkString(std::shared_ptr<const Buffer::Instance> string,
+                                           Buffer::Instance& out) {
+  char buffer[32];
+  char* current = buffer;
+  *current++ = '$';
+  current += StringUtil::itoa(current, 21, string->length());
+  *current++ = '\r';
+  *current++ = '\n';
+  out.add(buffer, current - buffer);
+  for (const Buffer::RawSlice& slice : string->getRawSlices()) {
+    out.addBufferFragment(*new BufferedStringSliceFragment(string, slice));
+  }
+  out.add("\r\n", 2);
+}
+
 void EncoderImpl::encodeError(const std::string& string, Buffer::Instance& out) {
   out.add("-", 1);
   out.add(string);
@@ -2,6 +2,7 @@
 
 #include <cstdint>
 #include <forward_list>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -18,10 +19,16 @@ namespace Redis {
  * Decoder implementation of https://redis.io/topics/protocol
  *
  * This implementation buffers when needed and will always consume all bytes passed for decoding.
+ * The bodies of large bulk strings are moved out of the decoded buffer rather than copied, see
+ * RespValue::asBufferedString().
  */
 class DecoderImpl : public Decoder, Logger::Loggable<Logger::Id::redis> {
 public:
-  DecoderImpl(DecoderCallbacks& callbacks) : callbacks_(callbacks) {}
+  DecoderImpl(DecoderCallbacks& callbacks);
+
+  // Bulk strings shorter than this are copied. They are likely to share the slices of the decoded
+  // buffer with other values, and moving part of a slice copies it anyway.
+  static constexpr uint64_t MinBufferedBulkStringLength = 16 * 1024;
 
   // RedisProxy::Decoder
   void decode(Buffer::Instance& data) override;
@@ -63,9 +70,15 @@ private:
     uint64_t current_array_element_;
   };
 
-  void parseSlice(const Buffer::RawSlice& slice);
+  /**
+   * Parses a slice of the decoded buffer.
+   * @return the number of bytes parsed, which is less than the length of the slice if the body of
+   *         a buffered bulk string starts in the slice.
+   */
+  uint64_t parseSlice(const Buffer::RawSlice& slice);
 
   DecoderCallbacks& callbacks_;
+  const bool buffer_bulk_strings_;
   State state_{State::ValueRootStart};
   PendingInteger pending_integer_;
   RespValuePtr pending_value_root_;
@@ -95,6 +108,8 @@ private:
   void encodeArray(const std::vector<RespValue>& array, Buffer::Instance& out);
   void encodeCompositeArray(const RespValue::CompositeArray& array, Buffer::Instance& out);
   void encodeBulkString(const std::string& string, Buffer::Instance& out);
+  void encodeBufferedBulkString(std::shared_ptr<const Buffer::Instance> string,
+                                Buffer::Instance& out);
   void encodeError(const std::string& string, Buffer::Instance& out);
   void encodeInteger(int64_t integer, Buffer::Instance& out);
   void encodeSimpleString(const std::string& string, Buffer::Instance& out);
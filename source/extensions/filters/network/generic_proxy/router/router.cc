@@ -3,10 +3,12 @@
 #include <cstdint>
 
 #include "envoy/common/conn_pool.h"
+#include "envoy/common/exception.h"
 #include "envoy/network/connection.h"
 
 #include "source/common/common/assert.h"
 #include "source/common/config/well_known_names.h"
+#include "source/common/protobuf/utility.h"
 #include "source/common/router/metadatamatchcriteria_impl.h"
 #include "source/common/tracing/tracer_impl.h"
 #include "source/extensions/filters/network/generic_proxy/interface/filter.h"
@@ -37,8 +39,30 @@ ReasonViewAndFlag resetReasonToViewAndFlag(StreamResetReason reason) {
   return ReasonViewAndFlags[static_cast<uint32_t>(reason)];
 }
 
+constexpr uint32_t DefaultMaxConcurrentStreams = 1024;
+
 } // namespace
 
+RouterConfig::RouterConfig(
+    const envoy::extensions::filters::network::generic_proxy::router::v3::Router& config,
+    ThreadLocal::SlotAllocator& tls)
+    : bind_upstream_connection_(config.bind_upstream_connection()) {
+  if (!config.has_upstream_multiplexing()) {
+    return;
+  }
+  if (bind_upstream_connection_) {
+    throw EnvoyException(
+        "generic proxy router: upstream_multiplexing and bind_upstream_connection are exclusive");
+  }
+
+  const uint32_t max_concurrent_streams = PROTOBUF_GET_WRAPPED_OR_DEFAULT(
+      config.upstream_multiplexing(), max_concurrent_streams, DefaultMaxConcurrentStreams);
+  multiplexed_pools_ = ThreadLocal::TypedSlot<MultiplexedGenericUpstreamPools>::makeUnique(tls);
+  multiplexed_pools_->set([max_concurrent_streams](Event::Dispatcher&) {
+    return std::make_shared<MultiplexedGenericUpstreamPools>(max_concurrent_streams);
+  });
+}
+
 UpstreamRequest::UpstreamRequest(RouterFilter& parent, FrameFlags header_frame_flags,
                                  GenericUpstreamSharedPtr generic_upstream)
     : parent_(parent), generic_upstream_(std::move(generic_upstream)),
@@ -86,8 +110,16 @@ void UpstreamRequest::resetStream(StreamResetReason reason, absl::string_view re
 
   ENVOY_LOG(debug, "generic proxy upstream request: reset upstream request");
 
-  generic_upstream_->removeUpstreamRequest(stream_id_);
-  generic_upstream_->cleanUp(true);
+  // The response of the reset request may still be received from a shared upstream connection.
+  if (expects_response_) {
+    generic_upstream_->resetUpstreamRequest(stream_id_);
+  } else {
+    generic_upstream_->removeUpstreamRequest(stream_id_);
+  }
+  // A multiplexed upstream connection is shared with other requests and is only closed if the
+  // state of the connection may be broken.
+  generic_upstream_->cleanUp(!parent_.config_->multiplexUpstreamConnection() ||
+                             reason == StreamResetReason::ProtocolError);
 
   if (span_ != nullptr) {
     span_->setTag(Tracing::Tags::get().Error, Tracing::Tags::get().True);
@@ -116,7 +148,13 @@ void UpstreamRequest::clearStream(bool close_connection) {
   }
 
   generic_upstream_->removeUpstreamRequest(stream_id_);
-  generic_upstream_->cleanUp(close_connection);
+  if (close_connection) {
+    // The upstream asks to close the connection. Any other requests that are using it still
+    // wait for their responses if the connection is shared.
+    generic_upstream_->drainConnection();
+  } else {
+    generic_upstream_->cleanUp(false);
+  }
 
   // Remove this stream form the parent's list because this upstream request is complete.
   deferredDelete();
@@ -190,7 +228,7 @@ OptRef<const RouteEntry> UpstreamRequest::routeEntry() const {
 
 void UpstreamRequest::onUpstreamFailure(ConnectionPool::PoolFailureReason reason,
                                         absl::string_view transport_failure_reason) {
-  ENVOY_LOG(debug, "upstream request: tcp connection (bound or owned) failure");
+  ENVOY_LOG(debug, "upstream request: tcp connection (bound, owned or multiplexed) failure");
   onUpstreamConnectionReady();
 
   if (reason == ConnectionPool::PoolFailureReason::Overflow) {
@@ -202,7 +240,9 @@ void UpstreamRequest::onUpstreamFailure(ConnectionPool::PoolFailureReason reason
 
 void UpstreamRequest::onUpstreamSuccess() {
   ENVOY_LOG(debug, "upstream request: {} tcp connection has ready",
-            parent_.config_->bindUpstreamConnection() ? "bound" : "owned");
+            parent_.config_->multiplexUpstreamConnection()
+                ? "multiplexed"
+                : (parent_.config_->bindUpstreamConnection() ? "bound" : "owned"));
   onUpstreamConnectionReady();
 
   const auto upstream_host = upstream_info_->upstream_host_.get();
@@ -430,7 +470,8 @@ void RouterFilter::kickOffNewUpstreamRequest() {
 
   GenericUpstreamSharedPtr generic_upstream = generic_upstream_factory_->createGenericUpstream(
       *thread_local_cluster, this, const_cast<Network::Connection&>(*callbacks_->connection()),
-      callbacks_->codecFactory(), config_->bindUpstreamConnection());
+      callbacks_->codecFactory(), config_->bindUpstreamConnection(),
+      config_->multiplexedUpstreamPools());
   if (generic_upstream == nullptr) {
     completeAndSendLocalReply(Status(StatusCode::kUnavailable, "no_healthy_upstream"), {},
                               StreamInfo::CoreResponseFlag::NoHealthyUpstream);
@@ -6,6 +6,7 @@
 #include "envoy/extensions/filters/network/generic_proxy/router/v3/router.pb.validate.h"
 #include "envoy/network/connection.h"
 #include "envoy/server/factory_context.h"
+#include "envoy/thread_local/thread_local.h"
 
 #include "source/common/buffer/buffer_impl.h"
 #include "source/common/common/linked_object.h"
@@ -104,13 +105,24 @@ using UpstreamRequestPtr = std::unique_ptr<UpstreamRequest>;
 
 class RouterConfig {
 public:
-  RouterConfig(const envoy::extensions::filters::network::generic_proxy::router::v3::Router& config)
-      : bind_upstream_connection_(config.bind_upstream_connection()) {}
+  RouterConfig(const envoy::extensions::filters::network::generic_proxy::router::v3::Router& config,
+               ThreadLocal::SlotAllocator& tls);
 
   bool bindUpstreamConnection() const { return bind_upstream_connection_; }
+  bool multiplexUpstreamConnection() const { return multiplexed_pools_ != nullptr; }
+
+  // The multiplexed upstream pools of the current worker, if the upstream connections are
+  // multiplexed.
+  OptRef<MultiplexedGenericUpstreamPools> multiplexedUpstreamPools() const {
+    if (multiplexed_pools_ == nullptr) {
+      return {};
+    }
+    return multiplexed_pools_->get();
+  }
 
 private:
   const bool bind_upstream_connection_{};
+  ThreadLocal::TypedSlotPtr<MultiplexedGenericUpstreamPools> multiplexed_pools_;
 };
 using RouterConfigSharedPtr = std::shared_ptr<RouterConfig>;
 
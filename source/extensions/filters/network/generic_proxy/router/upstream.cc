@@ -1,5 +1,7 @@
 #include "source/extensions/filters/network/generic_proxy/router/upstream.h"
 
+#include <algorithm>
+
 namespace Envoy {
 namespace Extensions {
 namespace NetworkFilters {
@@ -15,7 +17,31 @@ void SharedRequestManager::removeUpstreamRequest(uint64_t stream_id) {
   pending_requests_.erase(stream_id);
 }
 
+void SharedRequestManager::resetUpstreamRequest(uint64_t stream_id) {
+  // The request may have been sent and the rest of its response may still be received. Keep the
+  // stream id reserved until then so that the response will not be matched to another request.
+  if (pending_requests_.erase(stream_id) != 0) {
+    reset_stream_ids_.insert(stream_id);
+  }
+}
+
+bool SharedRequestManager::dropResetStreamFrame(uint64_t stream_id, bool end_stream) {
+  auto it = reset_stream_ids_.find(stream_id);
+  if (it == reset_stream_ids_.end()) {
+    return false;
+  }
+
+  ENVOY_LOG(debug, "generic proxy: drop response frame of reset request (id: {})", stream_id);
+  if (end_stream) {
+    reset_stream_ids_.erase(it);
+  }
+  return true;
+}
+
 void SharedRequestManager::onConnectionClose(Network::ConnectionEvent event) {
+  // No more responses will be received for the reset requests.
+  reset_stream_ids_.clear();
+
   while (!pending_requests_.empty()) {
     // Remove then notify.
     auto it = pending_requests_.begin();
@@ -33,7 +59,9 @@ void SharedRequestManager::onDecodingSuccess(ResponseHeaderFramePtr header_frame
 
   auto it = pending_requests_.find(stream_id);
   if (it == pending_requests_.end()) {
-    ENVOY_LOG(error, "generic proxy: id {} not found for header frame", stream_id);
+    if (!dropResetStreamFrame(stream_id, end_stream)) {
+      ENVOY_LOG(error, "generic proxy: id {} not found for header frame", stream_id);
+    }
     return;
   }
 
@@ -53,7 +81,9 @@ void SharedRequestManager::onDecodingSuccess(ResponseCommonFramePtr common_frame
 
   auto it = pending_requests_.find(stream_id);
   if (it == pending_requests_.end()) {
-    ENVOY_LOG(error, "generic proxy: id {} not found for common frame", stream_id);
+    if (!dropResetStreamFrame(stream_id, end_stream)) {
+      ENVOY_LOG(error, "generic proxy: id {} not found for common frame", stream_id);
+    }
     return;
   }
 
@@ -70,6 +100,7 @@ void SharedRequestManager::onDecodingSuccess(ResponseCommonFramePtr common_frame
 
 void SharedRequestManager::onDecodingFailure(absl::string_view reason) {
   ENVOY_LOG(error, "generic proxy shared encoder decoder: decoding failure ({})", reason);
+  reset_stream_ids_.clear();
 
   // Notify all pending requests that the decoding is failed.
   while (!pending_requests_.empty()) {
@@ -316,9 +347,283 @@ void OwnedGenericUpstream::onUpstreamFailure(ConnectionPool::PoolFailureReason r
   upstream_request->onUpstreamFailure(reason, transport_failure_reason);
 }
 
+MultiplexedGenericUpstream::MultiplexedGenericUpstream(Upstream::TcpPoolData tcp_pool_data,
+                                                       const CodecFactory& codec_factory,
+                                                       MultiplexedGenericUpstreamPool& pool)
+    : UpstreamBase(std::move(tcp_pool_data), codec_factory), pool_(&pool) {}
+
+void MultiplexedGenericUpstream::detach() {
+  if (pool_ != nullptr) {
+    auto pool = pool_;
+    pool_ = nullptr;
+    pool->onUpstreamDetached(*this);
+  }
+}
+
+void MultiplexedGenericUpstream::appendUpstreamRequest(uint64_t stream_id,
+                                                       UpstreamRequestCallbacks* pending_request) {
+  // The pool never picks an upstream that already has a request with the same stream id.
+  ASSERT(!containsRequest(stream_id));
+
+  if (upstream_conn_ok_.has_value()) {
+    // Only the upstreams in the pool will be picked and the upstream will be removed from the
+    // pool once the upstream connection is failed.
+    ASSERT(upstream_conn_ok_.value());
+    ASSERT(encoder_decoder_ != nullptr);
+
+    encoder_decoder_->appendUpstreamRequest(stream_id, pending_request);
+    pending_request->onUpstreamSuccess();
+  } else {
+    pending_requests_[stream_id] = pending_request;
+
+    // Try to initialize the upstream connection after there is at least one pending request.
+    // If the upstream connection is already initialized, this is a no-op.
+    tryInitialize();
+  }
+}
+
+void MultiplexedGenericUpstream::removeUpstreamRequest(uint64_t stream_id) {
+  pending_requests_.erase(stream_id);
+  if (encoder_decoder_ != nullptr) {
+    encoder_decoder_->removeUpstreamRequest(stream_id);
+  }
+}
+
+void MultiplexedGenericUpstream::resetUpstreamRequest(uint64_t stream_id) {
+  // The request that is waiting for the upstream connection has not been sent yet.
+  if (pending_requests_.erase(stream_id) != 0) {
+    return;
+  }
+  if (encoder_decoder_ != nullptr) {
+    encoder_decoder_->resetUpstreamRequest(stream_id);
+  }
+}
+
+void MultiplexedGenericUpstream::cleanUp(bool close_connection) {
+  if (close_connection && upstream_conn_ok_.has_value()) {
+    // Stop picking this upstream for new requests and close the connection. The other requests
+    // that are waiting for responses will be reset by the connection close event.
+    detach();
+    MultiplexedGenericUpstreamBase::cleanUp(true);
+    return;
+  }
+
+  if (activeRequestsSize() != resetRequestsSize()) {
+    // The upstream is still used by other requests.
+    return;
+  }
+
+  if (draining_ || resetRequestsSize() != 0) {
+    // The upstream asked to close the connection, or the responses of the reset requests may
+    // never be received. The connection cannot be released to the connection pool while their
+    // stream ids are reserved, so close it rather than keep it for the late responses.
+    detach();
+    MultiplexedGenericUpstreamBase::cleanUp(true);
+    encoder_decoder_ = nullptr;
+    return;
+  }
+
+  // No request is using this upstream. Cancel the pending connection or release the connection
+  // back to the connection pool, where it is reused by the next upstream of this host or closed
+  // by the idle timeout.
+  detach();
+  MultiplexedGenericUpstreamBase::cleanUp(false);
+  owned_conn_data_.reset();
+  encoder_decoder_ = nullptr;
+}
+
+void MultiplexedGenericUpstream::drainConnection() {
+  // Stop picking this upstream for new requests. The connection is closed once the other requests
+  // that are waiting for responses on it are complete.
+  draining_ = true;
+  detach();
+  cleanUp(false);
+}
+
+void MultiplexedGenericUpstream::onEvent(Network::ConnectionEvent event) {
+  if (event == Network::ConnectionEvent::LocalClose ||
+      event == Network::ConnectionEvent::RemoteClose) {
+    // The pool may hold the last reference to this upstream.
+    const auto self = shared_from_this();
+    detach();
+
+    if (encoder_decoder_ != nullptr) {
+      encoder_decoder_->onConnectionClose(event);
+    }
+  }
+}
+
+void MultiplexedGenericUpstream::onUpstreamData(Buffer::Instance& data, bool end_stream) {
+  // The responses may release this upstream and the pool may hold the last reference to it.
+  const auto self = shared_from_this();
+  MultiplexedGenericUpstreamBase::onUpstreamData(data, end_stream);
+}
+
+void MultiplexedGenericUpstream::onUpstreamSuccess() {
+  ASSERT(!upstream_conn_ok_.has_value());
+  ASSERT(encoder_decoder_ != nullptr);
+  upstream_conn_ok_ = true;
+
+  while (!pending_requests_.empty()) {
+    auto it = pending_requests_.begin();
+    auto cb = it->second;
+
+    // Insert it to the waiting response list and remove it from the waiting upstream list.
+    encoder_decoder_->appendUpstreamRequest(it->first, cb);
+    pending_requests_.erase(it);
+
+    // Notify the upstream request that the upstream connection is ready and request could be sent.
+    cb->onUpstreamSuccess();
+  }
+}
+
+void MultiplexedGenericUpstream::onUpstreamFailure(ConnectionPool::PoolFailureReason reason,
+                                                   absl::string_view transport_reason) {
+  ASSERT(!upstream_conn_ok_.has_value());
+  upstream_conn_ok_ = false;
+
+  // The pool may hold the last reference to this upstream.
+  const auto self = shared_from_this();
+  detach();
+
+  while (!pending_requests_.empty()) {
+    auto it = pending_requests_.begin();
+    auto cb = it->second;
+
+    // Remove it from the waiting upstream list.
+    pending_requests_.erase(it);
+
+    // Now, notify the upstream request that the upstream connection is failed.
+    cb->onUpstreamFailure(reason, transport_reason);
+  }
+}
+
+MultiplexedGenericUpstreamPool::MultiplexedGenericUpstreamPool(
+    MultiplexedGenericUpstreamPools& parent, Upstream::HostDescriptionConstSharedPtr host,
+    const CodecFactory& codec_factory, uint32_t max_concurrent_streams)
+    : parent_(&parent), host_(std::move(host)), codec_factory_(codec_factory),
+      max_concurrent_streams_(max_concurrent_streams) {}
+
+MultiplexedGenericUpstreamPool::~MultiplexedGenericUpstreamPool() {
+  for (const auto& upstream : upstreams_) {
+    upstream->pool_ = nullptr;
+  }
+}
+
+MultiplexedGenericUpstreamSharedPtr
+MultiplexedGenericUpstreamPool::pickUpstream(uint64_t stream_id,
+                                             const Upstream::TcpPoolData& tcp_pool_data) {
+  // Fill the earlier upstreams first to keep the number of upstream connections small.
+  for (const auto& upstream : upstreams_) {
+    if (upstream->activeRequestsSize() < max_concurrent_streams_ &&
+        !upstream->containsRequest(stream_id)) {
+      return upstream;
+    }
+  }
+
+  ENVOY_LOG(debug, "generic proxy multiplexed upstream pool: new upstream (host: {}, count: {})",
+            host_->address()->asStringView(), upstreams_.size() + 1);
+  auto upstream =
+      std::make_shared<MultiplexedGenericUpstream>(tcp_pool_data, codec_factory_, *this);
+  upstreams_.push_back(upstream);
+  return upstream;
+}
+
+void MultiplexedGenericUpstreamPool::onUpstreamDetached(MultiplexedGenericUpstream& upstream) {
+  auto it = std::find_if(upstreams_.begin(), upstreams_.end(),
+                         [&upstream](const auto& item) { return item.get() == &upstream; });
+  if (it != upstreams_.end()) {
+    upstreams_.erase(it);
+  }
+
+  if (upstreams_.empty() && parent_ != nullptr) {
+    // This may destroy the pool if no one else holds it.
+    auto parent = parent_;
+    parent_ = nullptr;
+    parent->removePool(*this);
+  }
+}
+
+MultiplexedGenericUpstreamPools::~MultiplexedGenericUpstreamPools() {
+  for (const auto& [key, pool] : pools_) {
+    pool->parent_ = nullptr;
+  }
+}
+
+MultiplexedGenericUpstreamPoolSharedPtr
+MultiplexedGenericUpstreamPools::getOrCreatePool(Upstream::HostDescriptionConstSharedPtr host,
+                                                 const CodecFactory& codec_factory) {
+  auto& pool = pools_[PoolKey{host.get(), &codec_factory}];
+  if (pool == nullptr) {
+    pool = std::make_shared<MultiplexedGenericUpstreamPool>(*this, std::move(host), codec_factory,
+                                                            max_concurrent_streams_);
+  }
+  return pool;
+}
+
+void MultiplexedGenericUpstreamPools::removePool(MultiplexedGenericUpstreamPool& pool) {
+  pools_.erase(PoolKey{pool.host().get(), &pool.codecFactory()});
+}
+
+void MultiplexedGenericUpstreamHandle::appendUpstreamRequest(
+    uint64_t stream_id, UpstreamRequestCallbacks* pending_request) {
+  ASSERT(upstream_ == nullptr);
+  upstream_ = pool_->pickUpstream(stream_id, tcp_pool_data_);
+  upstream_->appendUpstreamRequest(stream_id, pending_request);
+}
+
+void MultiplexedGenericUpstreamHandle::removeUpstreamRequest(uint64_t stream_id) {
+  if (upstream_ != nullptr) {
+    upstream_->removeUpstreamRequest(stream_id);
+  }
+}
+
+void MultiplexedGenericUpstreamHandle::resetUpstreamRequest(uint64_t stream_id) {
+  if (upstream_ != nullptr) {
+    upstream_->resetUpstreamRequest(stream_id);
+  }
+}
+
+ClientCodec& MultiplexedGenericUpstreamHandle::clientCodec() {
+  ASSERT(upstream_ != nullptr);
+  return upstream_->clientCodec();
+}
+
+OptRef<Network::Connection> MultiplexedGenericUpstreamHandle::upstreamConnection() {
+  if (upstream_ == nullptr) {
+    return {};
+  }
+  return upstream_->upstreamConnection();
+}
+
+void MultiplexedGenericUpstreamHandle::cleanUp(bool close_connection) {
+  if (upstream_ != nullptr) {
+    upstream_->cleanUp(close_connection);
+  }
+}
+
+void MultiplexedGenericUpstreamHandle::drainConnection() {
+  if (upstream_ != nullptr) {
+    upstream_->drainConnection();
+  }
+}
+
 GenericUpstreamSharedPtr ProdGenericUpstreamFactory::createGenericUpstream(
     Upstream::ThreadLocalCluster& cluster, Upstream::LoadBalancerContext* context,
-    Network::Connection& downstream_conn, const CodecFactory& codec_factory, bool bound) const {
+    Network::Connection& downstream_conn, const CodecFactory& codec_factory, bool bound,
+    OptRef<MultiplexedGenericUpstreamPools> multiplexed_pools) const {
+
+  if (multiplexed_pools.has_value()) {
+    // The multiplexed upstream of the request is picked from the pool of the selected host when
+    // the request is started.
+    auto pool_data = cluster.tcpConnPool(Upstream::ResourcePriority::Default, context);
+    if (!pool_data.has_value()) {
+      return nullptr;
+    }
+    auto pool = multiplexed_pools->getOrCreatePool(pool_data->host(), codec_factory);
+    return std::make_shared<MultiplexedGenericUpstreamHandle>(std::move(pool_data.value()),
+                                                              std::move(pool));
+  }
 
   if (bound) {
     auto* bound_upstream =
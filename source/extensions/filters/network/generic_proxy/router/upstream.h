@@ -1,12 +1,15 @@
 #pragma once
 
 #include <cstdint>
+#include <list>
 
 #include "envoy/network/connection.h"
+#include "envoy/thread_local/thread_local_object.h"
 
 #include "source/common/buffer/buffer_impl.h"
 #include "source/extensions/filters/network/generic_proxy/interface/codec.h"
 
+#include "absl/container/flat_hash_set.h"
 #include "quiche/common/quiche_linked_hash_map.h"
 
 namespace Envoy {
@@ -47,6 +50,12 @@ public:
   // request is reset or completed.
   virtual void removeUpstreamRequest(uint64_t stream_id) PURE;
 
+  // Remove a pending request that is waiting response from the upstream when the upstream
+  // request is reset before the response is complete. An upstream which is shared by different
+  // downstream connections may reserve the stream id until the rest of the response is received,
+  // so that the late response will not be matched to another request with the same stream id.
+  virtual void resetUpstreamRequest(uint64_t stream_id) { removeUpstreamRequest(stream_id); }
+
   // Return the upstream host description.
   virtual Upstream::HostDescriptionConstSharedPtr upstreamHost() const PURE;
 
@@ -61,19 +70,30 @@ public:
   // Any implementation should ensure that it is safe to call cleanUp() multiple times and
   // ensure it works correctly.
   virtual void cleanUp(bool close_connection) PURE;
+
+  // Clean up the upstream after the upstream asked to close the connection. An upstream which is
+  // shared by different downstream connections stops taking new requests and closes the
+  // connection once the requests which are using it are complete.
+  virtual void drainConnection() { cleanUp(true); }
 };
 
 using GenericUpstreamSharedPtr = std::shared_ptr<GenericUpstream>;
 
+class MultiplexedGenericUpstreamPools;
+
 class GenericUpstreamFactory {
 public:
   virtual ~GenericUpstreamFactory() = default;
 
-  virtual GenericUpstreamSharedPtr createGenericUpstream(Upstream::ThreadLocalCluster& cluster,
-                                                         Upstream::LoadBalancerContext* context,
-                                                         Network::Connection& downstream_conn,
-                                                         const CodecFactory& codec_factory,
-                                                         bool bound) const PURE;
+  // Create the upstream for an upstream request. If the multiplexed_pools is set, the upstream
+  // connections are shared by the requests of all the downstream connections of the worker.
+  // Otherwise, if bound is true, the upstream connection is bound to the downstream connection.
+  virtual GenericUpstreamSharedPtr
+  createGenericUpstream(Upstream::ThreadLocalCluster& cluster,
+                        Upstream::LoadBalancerContext* context,
+                        Network::Connection& downstream_conn, const CodecFactory& codec_factory,
+                        bool bound,
+                        OptRef<MultiplexedGenericUpstreamPools> multiplexed_pools) const PURE;
 };
 
 template <class RequestManager>
@@ -97,6 +117,12 @@ public:
     request_manager_.removeUpstreamRequest(stream_id);
   }
 
+  // Remove a pending request that is reset before its response is complete from the
+  // encoder/decoder and reserve its stream id until the rest of the response is received.
+  void resetUpstreamRequest(uint64_t stream_id) {
+    request_manager_.resetUpstreamRequest(stream_id);
+  }
+
   // Called when the upstream connection is closed. All pending requests should
   // be failed.
   void onConnectionClose(Network::ConnectionEvent event) {
@@ -104,6 +130,7 @@ public:
   }
 
   size_t requestsSize() const { return request_manager_.size(); }
+  size_t resetRequestsSize() const { return request_manager_.resetRequestsSize(); }
   bool containsRequest(uint64_t stream_id) const { return request_manager_.contains(stream_id); }
 
   // ClientCodecCallbacks
@@ -140,16 +167,28 @@ class SharedRequestManager : Logger::Loggable<Logger::Id::upstream> {
 public:
   void appendUpstreamRequest(uint64_t stream_id, UpstreamRequestCallbacks* pending_request);
   void removeUpstreamRequest(uint64_t stream_id);
+  void resetUpstreamRequest(uint64_t stream_id);
   void onConnectionClose(Network::ConnectionEvent event);
 
   void onDecodingSuccess(ResponseHeaderFramePtr header_frame, absl::optional<StartTime> start_time);
   void onDecodingSuccess(ResponseCommonFramePtr common_frame);
   void onDecodingFailure(absl::string_view reason);
 
-  size_t size() const { return pending_requests_.size(); }
-  bool contains(uint64_t stream_id) const { return pending_requests_.contains(stream_id); }
+  // The reserved stream ids of the reset requests are counted because their responses are still
+  // expected on the connection.
+  size_t size() const { return pending_requests_.size() + reset_stream_ids_.size(); }
+  size_t resetRequestsSize() const { return reset_stream_ids_.size(); }
+  bool contains(uint64_t stream_id) const {
+    return pending_requests_.contains(stream_id) || reset_stream_ids_.contains(stream_id);
+  }
 
   absl::flat_hash_map<uint64_t, UpstreamRequestCallbacks*> pending_requests_;
+  // The stream ids of the requests that were reset before their responses were complete.
+  absl::flat_hash_set<uint64_t> reset_stream_ids_;
+
+private:
+  // Drop a response frame of a reset request. Returns false if the stream id is not reserved.
+  bool dropResetStreamFrame(uint64_t stream_id, bool end_stream);
 };
 
 class UniqueRequestManager : Logger::Loggable<Logger::Id::upstream> {
@@ -165,6 +204,8 @@ public:
   void onDecodingFailure(absl::string_view reason);
 
   size_t size() const { return pending_request_ != nullptr ? 1 : 0; }
+  // The unique request manager never keeps a reset request.
+  size_t resetRequestsSize() const { return 0; }
   // Stream id is not used in the unique request manager.
   bool contains(uint64_t) const { return pending_request_ != nullptr; }
 
@@ -389,13 +430,177 @@ private:
   UpstreamRequestCallbacks* upstream_request_{};
 };
 
+class MultiplexedGenericUpstreamPool;
+
+using MultiplexedGenericUpstreamBase = UpstreamBase<SharedEncoderDecoder>;
+/**
+ * An upstream connection that is shared by the requests of all the downstream connections of
+ * the same worker. Multiple requests could be waiting for responses on it at the same time and
+ * the responses are matched to the requests by the stream id.
+ */
+class MultiplexedGenericUpstream
+    : public MultiplexedGenericUpstreamBase,
+      public std::enable_shared_from_this<MultiplexedGenericUpstream> {
+public:
+  MultiplexedGenericUpstream(Upstream::TcpPoolData tcp_pool_data,
+                             const CodecFactory& codec_factory,
+                             MultiplexedGenericUpstreamPool& pool);
+
+  // Tcp::ConnectionPool::UpstreamCallbacks
+  void onEvent(Network::ConnectionEvent event) override;
+  void onUpstreamData(Buffer::Instance& data, bool end_stream) override;
+
+  // UpstreamBase
+  void onUpstreamSuccess() override;
+  void onUpstreamFailure(ConnectionPool::PoolFailureReason reason,
+                         absl::string_view transport_failure_reason) override;
+
+  // Upstream
+  void appendUpstreamRequest(uint64_t stream_id,
+                             UpstreamRequestCallbacks* pending_request) override;
+  void removeUpstreamRequest(uint64_t stream_id) override;
+  void resetUpstreamRequest(uint64_t stream_id) override;
+  void cleanUp(bool close_connection) override;
+  void drainConnection() override;
+
+  size_t waitingUpstreamRequestsSize() const { return pending_requests_.size(); }
+  // This includes the reset requests whose responses are not complete yet.
+  size_t waitingResponseRequestsSize() const {
+    return encoder_decoder_ ? encoder_decoder_->requestsSize() : 0;
+  }
+  size_t activeRequestsSize() const {
+    return waitingUpstreamRequestsSize() + waitingResponseRequestsSize();
+  }
+  // The reset requests whose stream ids are reserved until their responses are complete.
+  size_t resetRequestsSize() const {
+    return encoder_decoder_ ? encoder_decoder_->resetRequestsSize() : 0;
+  }
+  bool containsRequest(uint64_t stream_id) const {
+    return pending_requests_.contains(stream_id) ||
+           (encoder_decoder_ != nullptr && encoder_decoder_->containsRequest(stream_id));
+  }
+
+  // Whether this upstream is still in the pool and could be picked for new requests.
+  bool attached() const { return pool_ != nullptr; }
+
+private:
+  friend class MultiplexedGenericUpstreamPool;
+
+  // Remove this upstream from the pool. Note the pool may hold the last reference to this
+  // upstream, so the caller must ensure that this upstream is still alive after this call.
+  void detach();
+
+  MultiplexedGenericUpstreamPool* pool_{};
+  absl::optional<bool> upstream_conn_ok_;
+  // Whether the connection will be closed once the requests which are using it are complete.
+  bool draining_{};
+
+  // The requests that are waiting for the upstream connection, in the order in which they were
+  // received.
+  using LinkedAbslHashMap = quiche::QuicheLinkedHashMap<uint64_t, UpstreamRequestCallbacks*>;
+  LinkedAbslHashMap pending_requests_;
+};
+using MultiplexedGenericUpstreamSharedPtr = std::shared_ptr<MultiplexedGenericUpstream>;
+
+/**
+ * The multiplexed upstreams of an upstream host and codec in a worker. The pool is dropped from
+ * the worker's pools when it has no upstreams.
+ */
+class MultiplexedGenericUpstreamPool
+    : public std::enable_shared_from_this<MultiplexedGenericUpstreamPool>,
+      Logger::Loggable<Logger::Id::upstream> {
+public:
+  MultiplexedGenericUpstreamPool(MultiplexedGenericUpstreamPools& parent,
+                                 Upstream::HostDescriptionConstSharedPtr host,
+                                 const CodecFactory& codec_factory,
+                                 uint32_t max_concurrent_streams);
+  ~MultiplexedGenericUpstreamPool();
+
+  // Pick the first upstream which has less than max_concurrent_streams active requests and no
+  // active request, or reset request that is waiting for its response, with the same stream id.
+  // If there is no such upstream, a new one is created with the tcp_pool_data and the request
+  // will wait for its connection.
+  MultiplexedGenericUpstreamSharedPtr pickUpstream(uint64_t stream_id,
+                                                   const Upstream::TcpPoolData& tcp_pool_data);
+
+  // Called when an upstream is closed, failed, or released back to the connection pool.
+  void onUpstreamDetached(MultiplexedGenericUpstream& upstream);
+
+  const Upstream::HostDescriptionConstSharedPtr& host() const { return host_; }
+  const CodecFactory& codecFactory() const { return codec_factory_; }
+  size_t upstreamsSize() const { return upstreams_.size(); }
+
+private:
+  friend class MultiplexedGenericUpstreamPools;
+
+  MultiplexedGenericUpstreamPools* parent_{};
+  const Upstream::HostDescriptionConstSharedPtr host_;
+  const CodecFactory& codec_factory_;
+  const uint32_t max_concurrent_streams_{};
+  std::list<MultiplexedGenericUpstreamSharedPtr> upstreams_;
+};
+using MultiplexedGenericUpstreamPoolSharedPtr = std::shared_ptr<MultiplexedGenericUpstreamPool>;
+
+/**
+ * The multiplexed upstream pools of a worker. There is one pool for every upstream host and codec.
+ */
+class MultiplexedGenericUpstreamPools : public ThreadLocal::ThreadLocalObject {
+public:
+  MultiplexedGenericUpstreamPools(uint32_t max_concurrent_streams)
+      : max_concurrent_streams_(max_concurrent_streams) {}
+  ~MultiplexedGenericUpstreamPools() override;
+
+  MultiplexedGenericUpstreamPoolSharedPtr
+  getOrCreatePool(Upstream::HostDescriptionConstSharedPtr host, const CodecFactory& codec_factory);
+  void removePool(MultiplexedGenericUpstreamPool& pool);
+
+  size_t poolsSize() const { return pools_.size(); }
+
+private:
+  using PoolKey = std::pair<const Upstream::HostDescription*, const CodecFactory*>;
+
+  const uint32_t max_concurrent_streams_{};
+  absl::flat_hash_map<PoolKey, MultiplexedGenericUpstreamPoolSharedPtr> pools_;
+};
+
+/**
+ * The upstream of a single upstream request when the upstream connections are multiplexed. The
+ * multiplexed upstream that carries the request is picked from the pool by the stream id of the
+ * request when the request is started.
+ */
+class MultiplexedGenericUpstreamHandle : public GenericUpstream {
+public:
+  MultiplexedGenericUpstreamHandle(Upstream::TcpPoolData tcp_pool_data,
+                                   MultiplexedGenericUpstreamPoolSharedPtr pool)
+      : tcp_pool_data_(std::move(tcp_pool_data)), pool_(std::move(pool)) {}
+
+  // Upstream
+  void appendUpstreamRequest(uint64_t stream_id,
+                             UpstreamRequestCallbacks* pending_request) override;
+  void removeUpstreamRequest(uint64_t stream_id) override;
+  void resetUpstreamRequest(uint64_t stream_id) override;
+  Upstream::HostDescriptionConstSharedPtr upstreamHost() const override { return pool_->host(); }
+  ClientCodec& clientCodec() override;
+  OptRef<Network::Connection> upstreamConnection() override;
+  void cleanUp(bool close_connection) override;
+  void drainConnection() override;
+
+  const MultiplexedGenericUpstreamSharedPtr& upstream() const { return upstream_; }
+
+private:
+  const Upstream::TcpPoolData tcp_pool_data_;
+  MultiplexedGenericUpstreamPoolSharedPtr pool_;
+  MultiplexedGenericUpstreamSharedPtr upstream_;
+};
+
 class ProdGenericUpstreamFactory : public GenericUpstreamFactory {
 public:
-  GenericUpstreamSharedPtr createGenericUpstream(Upstream::ThreadLocalCluster& cluster,
-                                                 Upstream::LoadBalancerContext* context,
-                                                 Network::Connection& downstream_conn,
-                                                 const CodecFactory& codec_factory,
-                                                 bool bound) const override;
+  GenericUpstreamSharedPtr
+  createGenericUpstream(Upstream::ThreadLocalCluster& cluster,
+                        Upstream::LoadBalancerContext* context,
+                        Network::Connection& downstream_conn, const CodecFactory& codec_factory,
+                        bool bound,
+                        OptRef<MultiplexedGenericUpstreamPools> multiplexed_pools) const override;
 };
 
 using DefaultGenericUpstreamFactory = ConstSingleton<ProdGenericUpstreamFactory>;
@@ -28,6 +28,11 @@ Config::Config(const envoy::extensions::filters::network::ratelimit::v3::RateLim
   for (const auto& descriptor : config.descriptors()) {
     RateLimit::Descriptor new_descriptor;
     for (const auto& entry : descriptor.entries()) {
+      // Empty values are only meaningful to the local rate limit filter.
+      if (entry.value().empty()) {
+        throw EnvoyException(
+            fmt::format("rate limit descriptor entry '{}' must have a value", entry.key()));
+      }
       new_descriptor.entries_.push_back({entry.key(), entry.value()});
       substitution_formatters_.push_back(
           std::make_unique<Formatter::FormatterImpl>(entry.value(), false));
@@ -0,0 +1,370 @@
+#include "source/extensions/filters/network/redis_proxy/client_cache.h"
+
+#include <algorithm>
+#include <iterator>
+
+#include "envoy/common/exception.h"
+
+#include "source/common/common/assert.h"
+#include "source/common/common/fmt.h"
+#include "source/extensions/filters/network/common/redis/utility.h"
+
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace NetworkFilters {
+namespace RedisProxy {
+namespace ConnPool {
+namespace {
+
+// The channel that invalidations are published to when they are redirected to a RESP2 connection.
+constexpr absl::string_view InvalidationChannel = "__redis__:invalidate";
+
+} // namespace
+
+ClientCacheConfig::ClientCacheConfig(
+    const envoy::extensions::filters::network::redis_proxy::v3::RedisProxy::ClientCache& config,
+    Stats::Scope& scope)
+    : key_prefixes_(config.key_prefixes().begin(), config.key_prefixes().end()),
+      max_size_bytes_(config.max_size_bytes()),
+      stats_{REDIS_CLIENT_CACHE_STATS(POOL_COUNTER_PREFIX(scope, "client_cache."),
+                                      POOL_GAUGE_PREFIX(scope, "client_cache."))} {
+  // Redis rejects overlapping prefixes in broadcasting mode. Once sorted, a prefix which overlaps
+  // with others is immediately followed by one of them.
+  std::sort(key_prefixes_.begin(), key_prefixes_.end());
+  for (size_t i = 1; i < key_prefixes_.size(); i++) {
+    if (absl::StartsWith(key_prefixes_[i], key_prefixes_[i - 1])) {
+      throw EnvoyException(fmt::format("redis client cache key prefixes '{}' and '{}' overlap",
+                                       key_prefixes_[i - 1], key_prefixes_[i]));
+    }
+  }
+}
+
+bool ClientCacheConfig::cacheable(absl::string_view key) const {
+  if (key_prefixes_.empty()) {
+    return true;
+  }
+  return std::any_of(key_prefixes_.begin(), key_prefixes_.end(),
+                     [key](const std::string& prefix) { return absl::StartsWith(key, prefix); });
+}
+
+ClientCache::Entry::Entry(absl::string_view key, uint64_t fill_id)
+    : key_(key), fill_id_(fill_id), size_bytes_(sizeof(Entry) + key.size()) {}
+
+ClientCache::ClientCache(ClientCacheConfigSharedPtr config, Event::Dispatcher& dispatcher)
+    : config_(std::move(config)), stats_(config_->stats()), dispatcher_(dispatcher) {}
+
+ClientCache::~ClientCache() {
+  tracking_connections_.clear();
+  stats_.size_bytes_.sub(size_bytes_);
+}
+
+const Common::Redis::RespValue* ClientCache::lookup(absl::string_view key) {
+  auto it = entries_.find(key);
+  if (it == entries_.end() || it->second->fill_id_ != 0) {
+    stats_.miss_.inc();
+    return nullptr;
+  }
+
+  stats_.hit_.inc();
+  lru_list_.splice(lru_list_.begin(), lru_list_, it->second);
+  return &it->second->response_;
+}
+
+uint64_t ClientCache::startFill(absl::string_view key, const Upstream::HostConstSharedPtr& host,
+                                const std::string& auth_username,
+                                const std::string& auth_password) {
+  TrackingConnectionPtr& tracking_connection = tracking_connections_[host];
+  if (tracking_connection == nullptr || tracking_connection->retryable()) {
+    tracking_connection =
+        std::make_unique<TrackingConnection>(*this, host, auth_username, auth_password);
+  }
+  if (!tracking_connection->subscribed()) {
+    // Invalidations could be missed until the subscription is confirmed.
+    return 0;
+  }
+
+  auto it = entries_.find(key);
+  if (it != entries_.end()) {
+    // The response is already being requested by an earlier GET command. Either response can fill
+    // the cache, as long as the key isn't invalidated in the meantime.
+    return it->second->fill_id_;
+  }
+
+  lru_list_.emplace_front(key, next_fill_id_++);
+  Entry& entry = lru_list_.front();
+  entries_.emplace(entry.key_, lru_list_.begin());
+  size_bytes_ += entry.size_bytes_;
+  stats_.size_bytes_.add(entry.size_bytes_);
+  const uint64_t fill_id = entry.fill_id_;
+  evict();
+  return fill_id;
+}
+
+void ClientCache::fill(absl::string_view key, uint64_t fill_id,
+                       const Common::Redis::RespValue& response) {
+  auto it = entries_.find(key);
+  if (it == entries_.end() || it->second->fill_id_ != fill_id) {
+    // The key was invalidated or evicted since the response was requested.
+    return;
+  }
+
+  LruList::iterator entry = it->second;
+  if (response.type() != Common::Redis::RespType::BulkString &&
+      response.type() != Common::Redis::RespType::Null) {
+    erase(entry);
+    return;
+  }
+  const uint64_t response_size =
+      response.type() == Common::Redis::RespType::BulkString ? response.stringLength() : 0;
+  if (entry->size_bytes_ + response_size > config_->maxSizeBytes()) {
+    erase(entry);
+    return;
+  }
+
+  // Copying a response shares the buffer of a large bulk string.
+  entry->response_ = response;
+  entry->fill_id_ = 0;
+  entry->size_bytes_ += response_size;
+  size_bytes_ += response_size;
+  stats_.size_bytes_.add(response_size);
+  lru_list_.splice(lru_list_.begin(), lru_list_, entry);
+  evict();
+}
+
+void ClientCache::cancelFill(absl::string_view key, uint64_t fill_id) {
+  auto it = entries_.find(key);
+  if (it != entries_.end() && it->second->fill_id_ == fill_id) {
+    erase(it->second);
+  }
+}
+
+void ClientCache::invalidate(absl::string_view key) {
+  auto it = entries_.find(key);
+  if (it != entries_.end()) {
+    stats_.invalidation_.inc();
+    erase(it->second);
+  }
+}
+
+void ClientCache::flush() {
+  stats_.flush_.inc();
+  entries_.clear();
+  lru_list_.clear();
+  stats_.size_bytes_.sub(size_bytes_);
+  size_bytes_ = 0;
+}
+
+void ClientCache::removeHost(const Upstream::HostConstSharedPtr& host) {
+  auto it = tracking_connections_.find(host);
+  if (it == tracking_connections_.end()) {
+    return;
+  }
+
+  const bool subscribed = it->second->subscribed();
+  tracking_connections_.erase(it);
+  if (subscribed) {
+    // Invalidations for the responses of the host are no longer received.
+    flush();
+  }
+}
+
+void ClientCache::removeAllHosts() {
+  const bool subscribed =
+      std::any_of(tracking_connections_.begin(), tracking_connections_.end(),
+                  [](const auto& tracking_connection) {
+                    return tracking_connection.second->subscribed();
+                  });
+  tracking_connections_.clear();
+  if (subscribed) {
+    flush();
+  }
+}
+
+void ClientCache::erase(LruList::iterator it) {
+  size_bytes_ -= it->size_bytes_;
+  stats_.size_bytes_.sub(it->size_bytes_);
+  entries_.erase(absl::string_view(it->key_));
+  lru_list_.erase(it);
+}
+
+void ClientCache::evict() {
+  while (size_bytes_ > config_->maxSizeBytes() && !lru_list_.empty()) {
+    stats_.eviction_.inc();
+    erase(std::prev(lru_list_.end()));
+  }
+}
+
+ClientCache::TrackingConnection::TrackingConnection(ClientCache& parent,
+                                                    Upstream::HostConstSharedPtr host,
+                                                    const std::string& auth_username,
+                                                    const std::string& auth_password)
+    : parent_(parent), host_(std::move(host)), decoder_(*this),
+      connect_timer_(parent.dispatcher_.createTimer([this]() {
+        ENVOY_LOG(debug, "redis client cache: tracking connection to {} timed out",
+                  host_->address()->asString());
+        connection_->close(Network::ConnectionCloseType::NoFlush);
+      })),
+      state_(auth_username.empty() && auth_password.empty() ? State::RequestingClientId
+                                                            : State::Authenticating) {
+  connection_ = host_->createConnection(parent.dispatcher_, nullptr, nullptr).connection_;
+  connection_->addConnectionCallbacks(*this);
+  connection_->addReadFilter(std::make_shared<UpstreamReadFilter>(*this));
+  connection_->connect();
+  connection_->noDelay(true);
+  connect_timer_->enableTimer(host_->cluster().connectTimeout());
+
+  if (!auth_username.empty()) {
+    encoder_.encode(Common::Redis::Utility::AuthRequest(auth_username, auth_password),
+                    encoder_buffer_);
+  } else if (!auth_password.empty()) {
+    encoder_.encode(Common::Redis::Utility::AuthRequest(auth_password), encoder_buffer_);
+  }
+  // The ID of the connection is needed to redirect the invalidations to it.
+  send({"CLIENT", "ID"});
+}
+
+ClientCache::TrackingConnection::~TrackingConnection() {
+  if (state_ == State::Subscribed) {
+    parent_.stats_.tracked_hosts_.dec();
+  }
+  if (state_ != State::Closed) {
+    connection_->removeConnectionCallbacks(*this);
+    connection_->close(Network::ConnectionCloseType::NoFlush);
+  }
+  parent_.dispatcher_.deferredDelete(std::move(connection_));
+}
+
+bool ClientCache::TrackingConnection::retryable() const {
+  return state_ == State::Closed &&
+         parent_.dispatcher_.timeSource().monotonicTime() - close_time_ >= TrackingRetryDelay;
+}
+
+void ClientCache::TrackingConnection::onEvent(Network::ConnectionEvent event) {
+  if (event != Network::ConnectionEvent::RemoteClose &&
+      event != Network::ConnectionEvent::LocalClose) {
+    return;
+  }
+
+  ENVOY_LOG(debug, "redis client cache: tracking connection to {} closed",
+            host_->address()->asString());
+  const bool subscribed = state_ == State::Subscribed;
+  state_ = State::Closed;
+  close_time_ = parent_.dispatcher_.timeSource().monotonicTime();
+  connect_timer_->disableTimer();
+  parent_.stats_.tracking_failure_.inc();
+  if (subscribed) {
+    parent_.stats_.tracked_hosts_.dec();
+    // Invalidations may have been lost.
+    parent_.flush();
+  }
+}
+
+void ClientCache::TrackingConnection::onData(Buffer::Instance& data) {
+  TRY_NEEDS_AUDIT { decoder_.decode(data); }
+  END_TRY catch (Common::Redis::ProtocolError&) {
+    connection_->close(Network::ConnectionCloseType::NoFlush);
+  }
+}
+
+void ClientCache::TrackingConnection::onRespValue(Common::Redis::RespValuePtr&& value) {
+  if (state_ == State::Closed) {
+    return;
+  }
+  if (value->type() == Common::Redis::RespType::Error) {
+    // For example, the host doesn't support CLIENT TRACKING, or the prefixes overlap with the
+    // prefixes of another tracking connection.
+    ENVOY_LOG(debug, "redis client cache: tracking connection to {} failed: {}",
+              host_->address()->asString(), value->asString());
+    connection_->close(Network::ConnectionCloseType::NoFlush);
+    return;
+  }
+
+  switch (state_) {
+  case State::Authenticating:
+    state_ = State::RequestingClientId;
+    break;
+  case State::RequestingClientId: {
+    if (value->type() != Common::Redis::RespType::Integer) {
+      connection_->close(Network::ConnectionCloseType::NoFlush);
+      return;
+    }
+    std::vector<std::string> tracking{"CLIENT", "TRACKING", "ON", "REDIRECT",
+                                      absl::StrCat(value->asInteger()), "BCAST"};
+    for (const std::string& prefix : parent_.config_->keyPrefixes()) {
+      tracking.push_back("PREFIX");
+      tracking.push_back(prefix);
+    }
+    // Tracking must be enabled before subscribing, as a subscribed RESP2 connection only accepts
+    // subscription commands.
+    send(tracking);
+    send({"SUBSCRIBE", std::string(InvalidationChannel)});
+    state_ = State::EnablingTracking;
+    break;
+  }
+  case State::EnablingTracking:
+    state_ = State::Subscribing;
+    break;
+  case State::Subscribing:
+    ENVOY_LOG(debug, "redis client cache: tracking {}", host_->address()->asString());
+    connect_timer_->disableTimer();
+    state_ = State::Subscribed;
+    parent_.stats_.tracked_hosts_.inc();
+    break;
+  case State::Subscribed:
+    onInvalidation(*value);
+    break;
+  case State::Closed:
+    break;
+  }
+}
+
+void ClientCache::TrackingConnection::onInvalidation(Common::Redis::RespValue& message) {
+  // Invalidations are published as ["message", "__redis__:invalidate", keys], where keys is an
+  // array of keys, or null when the database is flushed.
+  if (message.type() != Common::Redis::RespType::Array || message.asArray().size() != 3 ||
+      message.asArray()[0].type() != Common::Redis::RespType::BulkString ||
+      message.asArray()[0].asString() != "message") {
+    return;
+  }
+
+  // The keys are read through non-const values, as large keys may be buffered bulk strings.
+  Common::Redis::RespValue& keys = message.asArray()[2];
+  switch (keys.type()) {
+  case Common::Redis::RespType::Null:
+    parent_.flush();
+    break;
+  case Common::Redis::RespType::Array:
+    for (Common::Redis::RespValue& key : keys.asArray()) {
+      if (key.type() == Common::Redis::RespType::BulkString) {
+        parent_.invalidate(key.asString());
+      }
+    }
+    break;
+  case Common::Redis::RespType::BulkString:
+    parent_.invalidate(keys.asString());
+    break;
+  default:
+    break;
+  }
+}
+
+void ClientCache::TrackingConnection::send(const std::vector<std::string>& command) {
+  Common::Redis::RespValue request;
+  request.type(Common::Redis::RespType::Array);
+  request.asArray().resize(command.size());
+  for (size_t i = 0; i < command.size(); i++) {
+    request.asArray()[i].type(Common::Redis::RespType::BulkString);
+    request.asArray()[i].asString() = command[i];
+  }
+  encoder_.encode(request, encoder_buffer_);
+  connection_->write(encoder_buffer_, false);
+}
+
+} // namespace ConnPool
+} // namespace RedisProxy
+} // namespace NetworkFilters
+} // namespace Extensions
+} // namespace Envoy
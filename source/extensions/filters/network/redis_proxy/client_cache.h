@@ -0,0 +1,245 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "envoy/common/time.h"
+#include "envoy/event/dispatcher.h"
+#include "envoy/event/timer.h"
+#include "envoy/extensions/filters/network/redis_proxy/v3/redis_proxy.pb.h"
+#include "envoy/network/connection.h"
+#include "envoy/stats/scope.h"
+#include "envoy/stats/stats_macros.h"
+#include "envoy/upstream/upstream.h"
+
+#include "source/common/buffer/buffer_impl.h"
+#include "source/common/common/logger.h"
+#include "source/common/network/filter_impl.h"
+#include "source/extensions/filters/network/common/redis/codec_impl.h"
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/node_hash_map.h"
+#include "absl/strings/string_view.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace NetworkFilters {
+namespace RedisProxy {
+namespace ConnPool {
+
+#define REDIS_CLIENT_CACHE_STATS(COUNTER, GAUGE)                                                   \
+  COUNTER(eviction)                                                                                \
+  COUNTER(flush)                                                                                   \
+  COUNTER(hit)                                                                                     \
+  COUNTER(invalidation)                                                                            \
+  COUNTER(miss)                                                                                    \
+  COUNTER(tracking_failure)                                                                        \
+  GAUGE(size_bytes, Accumulate)                                                                    \
+  GAUGE(tracked_hosts, Accumulate)
+
+struct ClientCacheStats {
+  REDIS_CLIENT_CACHE_STATS(GENERATE_COUNTER_STRUCT, GENERATE_GAUGE_STRUCT)
+};
+
+/**
+ * Configuration of the client cache, which is shared by the caches of all workers.
+ */
+class ClientCacheConfig {
+public:
+  ClientCacheConfig(
+      const envoy::extensions::filters::network::redis_proxy::v3::RedisProxy::ClientCache& config,
+      Stats::Scope& scope);
+
+  /**
+   * @return whether the responses for a key may be cached.
+   */
+  bool cacheable(absl::string_view key) const;
+
+  const std::vector<std::string>& keyPrefixes() const { return key_prefixes_; }
+  uint64_t maxSizeBytes() const { return max_size_bytes_; }
+  ClientCacheStats& stats() { return stats_; }
+
+private:
+  std::vector<std::string> key_prefixes_;
+  const uint64_t max_size_bytes_;
+  ClientCacheStats stats_;
+};
+
+using ClientCacheConfigSharedPtr = std::shared_ptr<ClientCacheConfig>;
+
+/**
+ * A worker's cache of the responses to GET commands, evicted in LRU order.
+ *
+ * The cache keeps a tracking connection to every upstream host that it caches responses from. The
+ * connection enables CLIENT TRACKING in broadcasting mode for the configured key prefixes, with
+ * invalidations redirected to itself, and subscribes to them. This only needs RESP2, which is the
+ * protocol spoken by the codec. A response is only cached if the host's tracking connection was
+ * subscribed when the response was requested, and if no invalidation for its key was received
+ * since. The whole cache is flushed when a subscribed tracking connection is lost.
+ */
+class ClientCache : Logger::Loggable<Logger::Id::redis> {
+public:
+  // A tracking connection which failed is retried after this delay, on the next fill for its host.
+  static constexpr std::chrono::seconds TrackingRetryDelay{1};
+
+  ClientCache(ClientCacheConfigSharedPtr config, Event::Dispatcher& dispatcher);
+  ~ClientCache();
+
+  /**
+   * @return whether the responses for a key may be cached.
+   */
+  bool cacheable(absl::string_view key) const { return config_->cacheable(key); }
+
+  /**
+   * Looks up the cached response for a key.
+   * @param key supplies the key of the GET command.
+   * @return the cached response, or nullptr if there is none.
+   */
+  const Common::Redis::RespValue* lookup(absl::string_view key);
+
+  /**
+   * Starts to fill the cache for a key whose response is requested from a host. Starts tracking
+   * the host if it isn't yet.
+   * @param key supplies the key of the GET command.
+   * @param host supplies the host which the GET command is sent to.
+   * @param auth_username supplies the username to authenticate the tracking connection with.
+   * @param auth_password supplies the password to authenticate the tracking connection with.
+   * @return the fill ID to pass to fill(), or 0 if the response can't be cached.
+   */
+  uint64_t startFill(absl::string_view key, const Upstream::HostConstSharedPtr& host,
+                     const std::string& auth_username, const std::string& auth_password);
+
+  /**
+   * Caches the response for a key, unless the key was invalidated since startFill().
+   * @param key supplies the key of the GET command.
+   * @param fill_id supplies the ID returned by startFill().
+   * @param response supplies the response to the GET command.
+   */
+  void fill(absl::string_view key, uint64_t fill_id, const Common::Redis::RespValue& response);
+
+  /**
+   * Abandons a fill, when no response will be received for the GET command.
+   * @param key supplies the key of the GET command.
+   * @param fill_id supplies the ID returned by startFill().
+   */
+  void cancelFill(absl::string_view key, uint64_t fill_id);
+
+  /**
+   * Drops the cached response for a key, and any response that is being requested for it.
+   */
+  void invalidate(absl::string_view key);
+
+  /**
+   * Drops all the cached responses, and the responses that are being requested.
+   */
+  void flush();
+
+  /**
+   * Stops tracking a host that left the cluster.
+   */
+  void removeHost(const Upstream::HostConstSharedPtr& host);
+
+  /**
+   * Stops tracking all the hosts, when the cluster is removed.
+   */
+  void removeAllHosts();
+
+  uint64_t sizeBytes() const { return size_bytes_; }
+
+private:
+  friend class ClientCacheTest;
+
+  struct Entry {
+    Entry(absl::string_view key, uint64_t fill_id);
+
+    const std::string key_;
+    Common::Redis::RespValue response_;
+    // Non-zero while the response is being requested.
+    uint64_t fill_id_;
+    uint64_t size_bytes_;
+  };
+
+  using LruList = std::list<Entry>;
+
+  class TrackingConnection : public Network::ConnectionCallbacks,
+                             public Common::Redis::DecoderCallbacks {
+  public:
+    TrackingConnection(ClientCache& parent, Upstream::HostConstSharedPtr host,
+                       const std::string& auth_username, const std::string& auth_password);
+    ~TrackingConnection() override;
+
+    bool subscribed() const { return state_ == State::Subscribed; }
+    bool retryable() const;
+
+    // Network::ConnectionCallbacks
+    void onEvent(Network::ConnectionEvent event) override;
+    void onAboveWriteBufferHighWatermark() override {}
+    void onBelowWriteBufferLowWatermark() override {}
+
+    // Common::Redis::DecoderCallbacks
+    void onRespValue(Common::Redis::RespValuePtr&& value) override;
+
+  private:
+    enum class State {
+      Authenticating,
+      RequestingClientId,
+      EnablingTracking,
+      Subscribing,
+      Subscribed,
+      Closed
+    };
+
+    struct UpstreamReadFilter : public Network::ReadFilterBaseImpl {
+      UpstreamReadFilter(TrackingConnection& parent) : parent_(parent) {}
+
+      // Network::ReadFilter
+      Network::FilterStatus onData(Buffer::Instance& data, bool) override {
+        parent_.onData(data);
+        return Network::FilterStatus::Continue;
+      }
+
+      TrackingConnection& parent_;
+    };
+
+    void onData(Buffer::Instance& data);
+    void onInvalidation(Common::Redis::RespValue& message);
+    void send(const std::vector<std::string>& command);
+
+    ClientCache& parent_;
+    const Upstream::HostConstSharedPtr host_;
+    Common::Redis::EncoderImpl encoder_;
+    Common::Redis::DecoderImpl decoder_;
+    Buffer::OwnedImpl encoder_buffer_;
+    Network::ClientConnectionPtr connection_;
+    const Event::TimerPtr connect_timer_;
+    State state_;
+    MonotonicTime close_time_;
+  };
+
+  using TrackingConnectionPtr = std::unique_ptr<TrackingConnection>;
+
+  void erase(LruList::iterator it);
+  void evict();
+
+  const ClientCacheConfigSharedPtr config_;
+  ClientCacheStats& stats_;
+  Event::Dispatcher& dispatcher_;
+  LruList lru_list_;
+  // The keys are views of the keys of the entries in lru_list_.
+  absl::flat_hash_map<absl::string_view, LruList::iterator> entries_;
+  absl::node_hash_map<Upstream::HostConstSharedPtr, TrackingConnectionPtr> tracking_connections_;
+  uint64_t size_bytes_{};
+  uint64_t next_fill_id_{1};
+};
+
+using ClientCachePtr = std::unique_ptr<ClientCache>;
+
+} // namespace ConnPool
+} // namespace RedisProxy
+} // namespace NetworkFilters
+} // namespace Extensions
+} // namespace Envoy
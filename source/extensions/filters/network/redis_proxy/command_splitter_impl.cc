@@ -1,8 +1,11 @@
 #include "source/extensions/filters/network/redis_proxy/command_splitter_impl.h"
 
 #include "source/common/common/logger.h"
+#include "source/common/runtime/runtime_features.h"
 #include "source/extensions/filters/network/common/redis/supported_commands.h"
 
+#include "absl/container/flat_hash_map.h"
+
 namespace Envoy {
 namespace Extensions {
 namespace NetworkFilters {
@@ -233,6 +236,63 @@ void FragmentedRequest::onChildFailure(uint32_t index) {
   onChildResponse(Common::Redis::Utility::makeError(Response::get().UpstreamFailure), index);
 }
 
+std::vector<FragmentedRequest::Fragment>
+FragmentedRequest::groupKeys(Router& router, const std::string& command,
+                            Common::Redis::RespValue& request, uint32_t args_per_key,
+                            const StreamInfo::StreamInfo& stream_info) {
+  const bool batch =
+      Runtime::runtimeFeatureEnabled("envoy.reloadable_features.redis_batch_multi_key_commands");
+  const uint32_t num_keys = (request.asArray().size() - 1) / args_per_key;
+  std::vector<Fragment> fragments;
+  fragments.reserve(num_keys);
+  // Maps the route and shard of the keys which can be grouped to the index of their fragment.
+  absl::flat_hash_map<std::pair<const Route*, uint64_t>, uint32_t> shards;
+
+  for (uint32_t key = 0; key < num_keys; key++) {
+    std::string& key_string = request.asArray()[1 + key * args_per_key].asString();
+    RouteSharedPtr route = router.upstreamPool(key_string, stream_info);
+    absl::optional<uint64_t> shard;
+    if (batch && route != nullptr && route->mirrorPolicies().empty()) {
+      shard = route->upstream(command)->shard(key_string, request);
+    }
+    if (shard.has_value()) {
+      const auto [it, inserted] =
+          shards.try_emplace(std::make_pair(route.get(), shard.value()), fragments.size());
+      if (!inserted) {
+        fragments[it->second].keys_.push_back(key);
+        continue;
+      }
+    }
+    fragments.push_back({std::move(route), {key}});
+  }
+  return fragments;
+}
+
+Common::Redis::Client::PoolRequest* FragmentedRequest::makeBatchRequest(
+    const std::string& command, const std::string& single_command,
+    Common::Redis::RespValue& request, uint32_t args_per_key, const RouteSharedPtr& route,
+    PendingRequest& pending_request, Common::Redis::Client::Transaction& transaction) {
+  ASSERT(route->mirrorPolicies().empty());
+  auto batch_request = std::make_shared<Common::Redis::RespValue>();
+  batch_request->type(Common::Redis::RespType::Array);
+  std::vector<Common::Redis::RespValue>& args = batch_request->asArray();
+  args.reserve(1 + pending_request.keys_.size() * args_per_key);
+  args.emplace_back();
+  args.back().type(Common::Redis::RespType::BulkString);
+  args.back().asString() = command;
+  for (const uint32_t key : pending_request.keys_) {
+    for (uint32_t i = 1 + key * args_per_key; i < 1 + (key + 1) * args_per_key; i++) {
+      args.push_back(std::move(request.asArray()[i]));
+    }
+  }
+  ENVOY_LOG(debug, "batched {}: '{}'", command, batch_request->toString());
+
+  const std::string& key = args[1].asString();
+  return route->upstream(single_command)
+      ->makeRequest(key, ConnPool::RespVariant(Common::Redis::RespValueConstSharedPtr(batch_request)),
+                    pending_request, transaction);
+}
+
 SplitRequestPtr MGETRequest::create(Router& router, Common::Redis::RespValuePtr&& incoming_request,
                                     SplitCallbacks& callbacks, CommandStats& command_stats,
                                     TimeSource& time_source, bool delay_command_latency,
@@ -240,27 +300,33 @@ SplitRequestPtr MGETRequest::create(Router& router, Common::Redis::RespValuePtr&
   std::unique_ptr<MGETRequest> request_ptr{
       new MGETRequest(callbacks, command_stats, time_source, delay_command_latency)};
 
-  request_ptr->num_pending_responses_ = incoming_request->asArray().size() - 1;
-  request_ptr->pending_requests_.reserve(request_ptr->num_pending_responses_);
-
   request_ptr->pending_response_ = std::make_unique<Common::Redis::RespValue>();
   request_ptr->pending_response_->type(Common::Redis::RespType::Array);
-  std::vector<Common::Redis::RespValue> responses(request_ptr->num_pending_responses_);
+  std::vector<Common::Redis::RespValue> responses(incoming_request->asArray().size() - 1);
   request_ptr->pending_response_->asArray().swap(responses);
 
   Common::Redis::RespValueSharedPtr base_request = std::move(incoming_request);
-  for (uint32_t i = 1; i < base_request->asArray().size(); i++) {
-    request_ptr->pending_requests_.emplace_back(*request_ptr, i - 1);
+  std::vector<Fragment> fragments = groupKeys(router, "get", *base_request, 1, stream_info);
+  request_ptr->num_pending_responses_ = fragments.size();
+  request_ptr->pending_requests_.reserve(request_ptr->num_pending_responses_);
+
+  for (uint32_t index = 0; index < fragments.size(); index++) {
+    Fragment& fragment = fragments[index];
+    request_ptr->pending_requests_.emplace_back(*request_ptr, index, std::move(fragment.keys_));
     PendingRequest& pending_request = request_ptr->pending_requests_.back();
 
-    const auto route = router.upstreamPool(base_request->asArray()[i].asString(), stream_info);
-    if (route) {
+    if (fragment.route_ && pending_request.keys_.size() > 1) {
+      pending_request.handle_ =
+          makeBatchRequest("mget", "get", *base_request, 1, fragment.route_, pending_request,
+                           callbacks.transaction());
+    } else if (fragment.route_) {
+      const uint32_t i = pending_request.keys_[0] + 1;
       // Create composite array for a single get.
       const Common::Redis::RespValue single_mget(
           base_request, Common::Redis::Utility::GetRequest::instance(), i, i);
       pending_request.handle_ =
-          makeFragmentedRequest(route, "get", base_request->asArray()[i].asString(), single_mget,
-                                pending_request, callbacks.transaction());
+          makeFragmentedRequest(fragment.route_, "get", base_request->asArray()[i].asString(),
+                                single_mget, pending_request, callbacks.transaction());
     }
 
     if (!pending_request.handle_) {
@@ -275,17 +341,15 @@ SplitRequestPtr MGETRequest::create(Router& router, Common::Redis::RespValuePtr&
   return nullptr;
 }
 
-void MGETRequest::onChildResponse(Common::Redis::RespValuePtr&& value, uint32_t index) {
-  pending_requests_[index].handle_ = nullptr;
-
-  pending_response_->asArray()[index].type(value->type());
-  switch (value->type()) {
+void MGETRequest::onKeyResponse(Common::Redis::RespValue&& value, uint32_t key) {
+  pending_response_->asArray()[key].type(value.type());
+  switch (value.type()) {
   case Common::Redis::RespType::Array:
   case Common::Redis::RespType::Integer:
   case Common::Redis::RespType::SimpleString:
   case Common::Redis::RespType::CompositeArray: {
-    pending_response_->asArray()[index].type(Common::Redis::RespType::Error);
-    pending_response_->asArray()[index].asString() = Response::get().UpstreamProtocolError;
+    pending_response_->asArray()[key].type(Common::Redis::RespType::Error);
+    pending_response_->asArray()[key].asString() = Response::get().UpstreamProtocolError;
     error_count_++;
     break;
   }
@@ -294,12 +358,33 @@ void MGETRequest::onChildResponse(Common::Redis::RespValuePtr&& value, uint32_t
     FALLTHRU;
   }
   case Common::Redis::RespType::BulkString: {
-    pending_response_->asArray()[index].asString().swap(value->asString());
+    // Move the whole value so that a buffered bulk string isn't copied.
+    pending_response_->asArray()[key] = std::move(value);
     break;
   }
   case Common::Redis::RespType::Null:
     break;
   }
+}
+
+void MGETRequest::onChildResponse(Common::Redis::RespValuePtr&& value, uint32_t index) {
+  PendingRequest& pending_request = pending_requests_[index];
+  pending_request.handle_ = nullptr;
+
+  const KeyIndexes& keys = pending_request.keys_;
+  if (keys.size() == 1) {
+    onKeyResponse(std::move(*value), keys[0]);
+  } else if (value->type() == Common::Redis::RespType::Array &&
+             value->asArray().size() == keys.size()) {
+    for (uint32_t i = 0; i < keys.size(); i++) {
+      onKeyResponse(std::move(value->asArray()[i]), keys[i]);
+    }
+  } else {
+    // The whole MGET failed, so each of its keys gets the error.
+    for (const uint32_t key : keys) {
+      onKeyResponse(Common::Redis::RespValue(*value), key);
+    }
+  }
 
   ASSERT(num_pending_responses_ > 0);
   if (--num_pending_responses_ == 0) {
@@ -321,27 +406,32 @@ SplitRequestPtr MSETRequest::create(Router& router, Common::Redis::RespValuePtr&
   std::unique_ptr<MSETRequest> request_ptr{
       new MSETRequest(callbacks, command_stats, time_source, delay_command_latency)};
 
-  request_ptr->num_pending_responses_ = (incoming_request->asArray().size() - 1) / 2;
-  request_ptr->pending_requests_.reserve(request_ptr->num_pending_responses_);
-
   request_ptr->pending_response_ = std::make_unique<Common::Redis::RespValue>();
   request_ptr->pending_response_->type(Common::Redis::RespType::SimpleString);
 
   Common::Redis::RespValueSharedPtr base_request = std::move(incoming_request);
-  uint32_t fragment_index = 0;
-  for (uint32_t i = 1; i < base_request->asArray().size(); i += 2) {
-    request_ptr->pending_requests_.emplace_back(*request_ptr, fragment_index++);
+  std::vector<Fragment> fragments = groupKeys(router, "set", *base_request, 2, stream_info);
+  request_ptr->num_pending_responses_ = fragments.size();
+  request_ptr->pending_requests_.reserve(request_ptr->num_pending_responses_);
+
+  for (uint32_t index = 0; index < fragments.size(); index++) {
+    Fragment& fragment = fragments[index];
+    request_ptr->pending_requests_.emplace_back(*request_ptr, index, std::move(fragment.keys_));
     PendingRequest& pending_request = request_ptr->pending_requests_.back();
 
-    const auto route = router.upstreamPool(base_request->asArray()[i].asString(), stream_info);
-    if (route) {
+    if (fragment.route_ && pending_request.keys_.size() > 1) {
+      pending_request.handle_ =
+          makeBatchRequest("mset", "set", *base_request, 2, fragment.route_, pending_request,
+                           callbacks.transaction());
+    } else if (fragment.route_) {
+      const uint32_t i = pending_request.keys_[0] * 2 + 1;
       // Create composite array for a single set command.
       const Common::Redis::RespValue single_set(
           base_request, Common::Redis::Utility::SetRequest::instance(), i, i + 1);
       ENVOY_LOG(debug, "parallel set: '{}'", single_set.toString());
       pending_request.handle_ =
-          makeFragmentedRequest(route, "set", base_request->asArray()[i].asString(), single_set,
-                                pending_request, callbacks.transaction());
+          makeFragmentedRequest(fragment.route_, "set", base_request->asArray()[i].asString(),
+                                single_set, pending_request, callbacks.transaction());
     }
 
     if (!pending_request.handle_) {
@@ -367,7 +457,8 @@ void MSETRequest::onChildResponse(Common::Redis::RespValuePtr&& value, uint32_t
     FALLTHRU;
   }
   default: {
-    error_count_++;
+    // Each key of a failed MSET counts as an error.
+    error_count_ += pending_requests_[index].keys_.size();
     break;
   }
   }
@@ -393,26 +484,33 @@ SplitKeysSumResultRequest::create(Router& router, Common::Redis::RespValuePtr&&
   std::unique_ptr<SplitKeysSumResultRequest> request_ptr{
       new SplitKeysSumResultRequest(callbacks, command_stats, time_source, delay_command_latency)};
 
-  request_ptr->num_pending_responses_ = incoming_request->asArray().size() - 1;
-  request_ptr->pending_requests_.reserve(request_ptr->num_pending_responses_);
-
   request_ptr->pending_response_ = std::make_unique<Common::Redis::RespValue>();
   request_ptr->pending_response_->type(Common::Redis::RespType::Integer);
 
   Common::Redis::RespValueSharedPtr base_request = std::move(incoming_request);
-  for (uint32_t i = 1; i < base_request->asArray().size(); i++) {
-    request_ptr->pending_requests_.emplace_back(*request_ptr, i - 1);
+  const std::string& command = base_request->asArray()[0].asString();
+  std::vector<Fragment> fragments = groupKeys(router, command, *base_request, 1, stream_info);
+  request_ptr->num_pending_responses_ = fragments.size();
+  request_ptr->pending_requests_.reserve(request_ptr->num_pending_responses_);
+
+  for (uint32_t index = 0; index < fragments.size(); index++) {
+    Fragment& fragment = fragments[index];
+    request_ptr->pending_requests_.emplace_back(*request_ptr, index, std::move(fragment.keys_));
     PendingRequest& pending_request = request_ptr->pending_requests_.back();
 
-    // Create the composite array for a single fragment.
-    const Common::Redis::RespValue single_fragment(base_request, base_request->asArray()[0], i, i);
-    ENVOY_LOG(debug, "parallel {}: '{}'", base_request->asArray()[0].asString(),
-              single_fragment.toString());
-    const auto route = router.upstreamPool(base_request->asArray()[i].asString(), stream_info);
-    if (route) {
-      pending_request.handle_ = makeFragmentedRequest(
-          route, base_request->asArray()[0].asString(), base_request->asArray()[i].asString(),
-          single_fragment, pending_request, callbacks.transaction());
+    if (fragment.route_ && pending_request.keys_.size() > 1) {
+      pending_request.handle_ =
+          makeBatchRequest(command, command, *base_request, 1, fragment.route_, pending_request,
+                           callbacks.transaction());
+    } else if (fragment.route_) {
+      const uint32_t i = pending_request.keys_[0] + 1;
+      // Create the composite array for a single fragment.
+      const Common::Redis::RespValue single_fragment(base_request, base_request->asArray()[0], i,
+                                                     i);
+      ENVOY_LOG(debug, "parallel {}: '{}'", command, single_fragment.toString());
+      pending_request.handle_ =
+          makeFragmentedRequest(fragment.route_, command, base_request->asArray()[i].asString(),
+                                single_fragment, pending_request, callbacks.transaction());
     }
 
     if (!pending_request.handle_) {
@@ -437,7 +535,8 @@ void SplitKeysSumResultRequest::onChildResponse(Common::Redis::RespValuePtr&& va
     break;
   }
   default: {
-    error_count_++;
+    // Each key of a failed batch counts as an error.
+    error_count_ += pending_requests_[index].keys_.size();
     break;
   }
   }
@@ -18,6 +18,8 @@
 #include "source/extensions/filters/network/redis_proxy/conn_pool_impl.h"
 #include "source/extensions/filters/network/redis_proxy/router.h"
 
+#include "absl/container/inlined_vector.h"
+
 namespace Envoy {
 namespace Extensions {
 namespace NetworkFilters {
@@ -223,8 +225,8 @@ private:
 
 /**
  * FragmentedRequest is a base class for requests that contains multiple keys. An individual request
- * is sent to the appropriate server for each key. The responses from all servers are combined and
- * returned to the client.
+ * is sent to the appropriate server for each key, or for each group of keys served by the same
+ * shard. The responses from all servers are combined and returned to the client.
  */
 class FragmentedRequest : public SplitRequestBase {
 public:
@@ -239,8 +241,18 @@ protected:
       : SplitRequestBase(command_stats, time_source, delay_command_latency), callbacks_(callbacks) {
   }
 
+  using KeyIndexes = absl::InlinedVector<uint32_t, 1>;
+
+  // The keys of a multi-key command which are sent to the same upstream shard.
+  struct Fragment {
+    RouteSharedPtr route_;
+    // The positions of the keys in the command, starting at 0 for the first key.
+    KeyIndexes keys_;
+  };
+
   struct PendingRequest : public ConnPool::PoolCallbacks {
-    PendingRequest(FragmentedRequest& parent, uint32_t index) : parent_(parent), index_(index) {}
+    PendingRequest(FragmentedRequest& parent, uint32_t index, KeyIndexes&& keys)
+        : parent_(parent), index_(index), keys_(std::move(keys)) {}
 
     // ConnPool::PoolCallbacks
     void onResponse(Common::Redis::RespValuePtr&& value) override {
@@ -250,9 +262,43 @@ protected:
 
     FragmentedRequest& parent_;
     const uint32_t index_;
+    const KeyIndexes keys_;
     Common::Redis::Client::PoolRequest* handle_{};
   };
 
+  /**
+   * Groups the keys of a multi-key command by the upstream shard that serves them. Keys are only
+   * grouped if their route has no mirror policies, as mirrors may be sharded differently.
+   * @param router supplies the router of the keys.
+   * @param command supplies the command that each key would be sent with on its own.
+   * @param request supplies the multi-key command.
+   * @param args_per_key supplies the number of arguments of each key, including the key.
+   * @param stream_info supplies the stream info of the downstream connection.
+   * @return the fragments of the command, in the order of their first key.
+   */
+  static std::vector<Fragment> groupKeys(Router& router, const std::string& command,
+                                         Common::Redis::RespValue& request, uint32_t args_per_key,
+                                         const StreamInfo::StreamInfo& stream_info);
+
+  /**
+   * Sends the keys of a fragment as a single command. Their arguments are moved out of the
+   * multi-key command, as no other fragment refers to them.
+   * @param command supplies the name of the multi-key command.
+   * @param single_command supplies the command that each key would be sent with on its own.
+   * @param request supplies the multi-key command.
+   * @param args_per_key supplies the number of arguments of each key, including the key.
+   * @param route supplies the route of the fragment.
+   * @param pending_request supplies the pending request of the fragment.
+   * @param transaction supplies the transaction info of the current connection.
+   * @return PoolRequest* a handle to the active request or nullptr if the request could not be
+   *         made for some reason.
+   */
+  static Common::Redis::Client::PoolRequest*
+  makeBatchRequest(const std::string& command, const std::string& single_command,
+                   Common::Redis::RespValue& request, uint32_t args_per_key,
+                   const RouteSharedPtr& route, PendingRequest& pending_request,
+                   Common::Redis::Client::Transaction& transaction);
+
   virtual void onChildResponse(Common::Redis::RespValuePtr&& value, uint32_t index) PURE;
   void onChildFailure(uint32_t index);
 
@@ -266,7 +312,8 @@ protected:
 
 /**
  * MGETRequest takes each key from the command and sends a GET for each to the appropriate Redis
- * server. The response contains the result from each command.
+ * server, or a single MGET for the keys that share a shard. The response contains the result for
+ * each key.
  */
 class MGETRequest : public FragmentedRequest {
 public:
@@ -280,14 +327,16 @@ private:
               bool delay_command_latency)
       : FragmentedRequest(callbacks, command_stats, time_source, delay_command_latency) {}
 
+  void onKeyResponse(Common::Redis::RespValue&& value, uint32_t key);
+
   // RedisProxy::CommandSplitter::FragmentedRequest
   void onChildResponse(Common::Redis::RespValuePtr&& value, uint32_t index) override;
 };
 
 /**
  * SplitKeysSumResultRequest takes each key from the command and sends the same incoming command
- * with each key to the appropriate Redis server. The response from each Redis (which must be an
- * integer) is summed and returned to the user. If there is any error or failure in processing the
+ * with each key, or with the keys that share a shard, to the appropriate Redis server. The
+ * response from each Redis (which must be an integer) is summed and returned to the user. If there is any error or failure in processing the
  * fragmented commands, an error will be returned.
  */
 class SplitKeysSumResultRequest : public FragmentedRequest {
@@ -310,7 +359,7 @@ private:
 
 /**
  * MSETRequest takes each key and value pair from the command and sends a SET for each to the
- * appropriate Redis server. The response is an OK if all commands succeeded or an ERR if any
+ * appropriate Redis server, or a single MSET for the pairs whose keys share a shard. The response is an OK if all commands succeeded or an ERR if any
  * failed.
  */
 class MSETRequest : public FragmentedRequest {
@@ -9,6 +9,7 @@
 #include "source/extensions/filters/network/common/redis/client.h"
 #include "source/extensions/filters/network/common/redis/codec.h"
 
+#include "absl/types/optional.h"
 #include "absl/types/variant.h"
 
 namespace Envoy {
@@ -64,6 +65,17 @@ public:
   virtual Common::Redis::Client::PoolRequest*
   makeRequest(const std::string& hash_key, RespVariant&& request, PoolCallbacks& callbacks,
               Common::Redis::Client::Transaction& transaction) PURE;
+
+  /**
+   * Returns the shard that serves a key. The keys of a multi-key command which share a shard can
+   * be sent to it as a single command. Keys only have a shard in a Redis Cluster, where it is the
+   * hash slot, and in clusters with a consistent hashing load balancer, where it is the host.
+   * @param hash_key supplies the key to use for consistent hashing.
+   * @param request supplies the multi-key request.
+   * @return the shard of the key, or nullopt if the key must be sent in a command of its own.
+   */
+  virtual absl::optional<uint64_t> shard(const std::string& hash_key,
+                                         const Common::Redis::RespValue& request) PURE;
 };
 
 using InstanceSharedPtr = std::shared_ptr<Instance>;
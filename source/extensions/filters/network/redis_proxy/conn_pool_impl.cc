@@ -14,8 +14,11 @@
 #include "source/common/common/assert.h"
 #include "source/common/common/logger.h"
 #include "source/common/stats/utility.h"
+#include "source/extensions/filters/network/common/redis/supported_commands.h"
 #include "source/extensions/filters/network/redis_proxy/config.h"
 
+#include "absl/strings/ascii.h"
+
 namespace Envoy {
 namespace Extensions {
 namespace NetworkFilters {
@@ -34,10 +37,27 @@ const Common::Redis::RespValue& getRequest(const RespVariant& request) {
   }
 }
 
+// Returns the lowercase name of the command of a request, or an empty string if it has none.
+std::string commandName(const Common::Redis::RespValue& request) {
+  if (request.type() == Common::Redis::RespType::CompositeArray) {
+    return absl::AsciiStrToLower(request.asCompositeArray().command()->asString());
+  }
+  if (request.type() == Common::Redis::RespType::Array && !request.asArray().empty() &&
+      request.asArray()[0].type() == Common::Redis::RespType::BulkString) {
+    return absl::AsciiStrToLower(request.asArray()[0].asString());
+  }
+  return "";
+}
+
 static uint16_t default_port = 6379;
 
-bool isClusterProvidedLb(const Upstream::ClusterInfo& info) {
-  return info.loadBalancerFactory().name() == "envoy.load_balancing_policies.cluster_provided";
+bool isClusterProvidedLb(absl::string_view lb_name) {
+  return lb_name == "envoy.load_balancing_policies.cluster_provided";
+}
+
+bool isConsistentHashLb(absl::string_view lb_name) {
+  return lb_name == "envoy.load_balancing_policies.ring_hash" ||
+         lb_name == "envoy.load_balancing_policies.maglev";
 }
 
 } // namespace
@@ -56,7 +76,11 @@ InstanceImpl::InstanceImpl(
       stats_scope_(std::move(stats_scope)),
       redis_command_stats_(redis_command_stats), redis_cluster_stats_{REDIS_CLUSTER_STATS(
                                                      POOL_COUNTER(*stats_scope_))},
-      refresh_manager_(std::move(refresh_manager)), dns_cache_(dns_cache) {}
+      refresh_manager_(std::move(refresh_manager)), dns_cache_(dns_cache),
+      client_cache_config_(config.has_client_cache()
+                               ? std::make_shared<ClientCacheConfig>(config.client_cache(),
+                                                                     *stats_scope_)
+                               : nullptr) {}
 
 void InstanceImpl::init() {
   // Note: `this` and `cluster_name` have a a lifetime of the filter.
@@ -82,6 +106,13 @@ InstanceImpl::makeRequest(const std::string& key, RespVariant&& request, PoolCal
                                                        transaction);
 }
 
+// This method is always called from a InstanceSharedPtr we don't have to worry about tls_->getTyped
+// failing due to InstanceImpl going away.
+absl::optional<uint64_t> InstanceImpl::shard(const std::string& key,
+                                             const Common::Redis::RespValue& request) {
+  return tls_->getTyped<ThreadLocalPool>().shard(key, request);
+}
+
 // This method is always called from a InstanceSharedPtr we don't have to worry about tls_->getTyped
 // failing due to InstanceImpl going away.
 Common::Redis::Client::PoolRequest*
@@ -100,7 +131,12 @@ InstanceImpl::ThreadLocalPool::ThreadLocalPool(
       client_factory_(parent->client_factory_), config_(parent->config_),
       stats_scope_(parent->stats_scope_), redis_command_stats_(parent->redis_command_stats_),
       redis_cluster_stats_(parent->redis_cluster_stats_),
-      refresh_manager_(parent->refresh_manager_) {
+      refresh_manager_(parent->refresh_manager_),
+      client_cache_(parent->client_cache_config_ != nullptr
+                        ? std::make_unique<ClientCache>(parent->client_cache_config_, dispatcher)
+                        : nullptr),
+      cached_responses_cb_(
+          dispatcher.createSchedulableCallback([this]() { onCachedResponses(); })) {
   cluster_update_handle_ = parent->cm_.addThreadLocalClusterUpdateCallbacks(*this);
   Upstream::ThreadLocalCluster* cluster = parent->cm_.getThreadLocalCluster(cluster_name_);
   if (cluster != nullptr) {
@@ -115,6 +151,11 @@ InstanceImpl::ThreadLocalPool::~ThreadLocalPool() {
   while (!pending_requests_.empty()) {
     pending_requests_.pop_front();
   }
+  for (CachedResponse& cached_response : cached_responses_) {
+    if (!cached_response.canceled_) {
+      cached_response.pool_callbacks_.onFailure();
+    }
+  }
   while (!client_map_.empty()) {
     client_map_.begin()->second->redis_client_->close();
   }
@@ -168,8 +209,10 @@ void InstanceImpl::ThreadLocalPool::onClusterAddOrUpdateNonVirtual(
   Upstream::ClusterInfoConstSharedPtr info = cluster_->info();
   OptRef<const envoy::config::cluster::v3::Cluster::CustomClusterType> cluster_type =
       info->clusterType();
-  is_redis_cluster_ = isClusterProvidedLb(*info) && cluster_type.has_value() &&
+  const std::string lb_name = info->loadBalancerFactory().name();
+  is_redis_cluster_ = isClusterProvidedLb(lb_name) && cluster_type.has_value() &&
                       cluster_type->name() == "envoy.clusters.redis";
+  is_consistent_hash_lb_ = isConsistentHashLb(lb_name);
 }
 
 void InstanceImpl::ThreadLocalPool::onClusterRemoval(const std::string& cluster_name) {
@@ -190,6 +233,9 @@ void InstanceImpl::ThreadLocalPool::onClusterRemoval(const std::string& cluster_
   cluster_ = nullptr;
   host_address_map_.clear();
   cx_rate_limiter_map_.clear();
+  if (client_cache_ != nullptr) {
+    client_cache_->removeAllHosts();
+  }
 }
 
 void InstanceImpl::ThreadLocalPool::onHostsAdded(
@@ -216,6 +262,9 @@ void InstanceImpl::ThreadLocalPool::onHostsRemoved(
     if (token_bucket != cx_rate_limiter_map_.end()) {
       cx_rate_limiter_map_.erase(token_bucket);
     }
+    if (client_cache_ != nullptr) {
+      client_cache_->removeHost(host);
+    }
     auto it = client_map_.find(host);
     if (it != client_map_.end()) {
       if (it->second->redis_client_->active()) {
@@ -283,6 +332,25 @@ InstanceImpl::ThreadLocalPool::makeRequest(const std::string& key, RespVariant&&
     return nullptr;
   }
 
+  // GET commands are served from the client cache outside of transactions. Other commands which
+  // write to a cached key drop it right away, so that later GET commands on this worker don't have
+  // to wait for the invalidation to read the write.
+  bool fill_client_cache = false;
+  if (client_cache_ != nullptr && !transaction.active_ && client_cache_->cacheable(key)) {
+    const std::string command = commandName(getRequest(request));
+    if (command == "get") {
+      const Common::Redis::RespValue* cached = client_cache_->lookup(key);
+      if (cached != nullptr) {
+        cached_responses_.emplace_back(*cached, callbacks);
+        cached_responses_cb_->scheduleCallbackCurrentIteration();
+        return &cached_responses_.back();
+      }
+      fill_client_cache = true;
+    } else if (!Common::Redis::SupportedCommands::isReadCommand(command)) {
+      client_cache_->invalidate(key);
+    }
+  }
+
   Clusters::Redis::RedisLoadBalancerContextImpl lb_context(
       key, config_->enableHashtagging(), is_redis_cluster_, getRequest(request),
       transaction.active_ ? Common::Redis::Client::ReadPolicy::Primary : config_->readPolicy());
@@ -306,6 +374,13 @@ InstanceImpl::ThreadLocalPool::makeRequest(const std::string& key, RespVariant&&
 
   pending_requests_.emplace_back(*this, std::move(request), callbacks, host);
   PendingRequest& pending_request = pending_requests_.back();
+  if (fill_client_cache) {
+    pending_request.client_cache_fill_id_ =
+        client_cache_->startFill(key, host, auth_username_, auth_password_);
+    if (pending_request.client_cache_fill_id_ != 0) {
+      pending_request.client_cache_key_ = key;
+    }
+  }
 
   if (!transaction.active_) {
     ThreadLocalActiveClientPtr& client = this->threadLocalActiveClient(host);
@@ -331,6 +406,38 @@ InstanceImpl::ThreadLocalPool::makeRequest(const std::string& key, RespVariant&&
   }
 }
 
+absl::optional<uint64_t>
+InstanceImpl::ThreadLocalPool::shard(const std::string& key,
+                                     const Common::Redis::RespValue& request) {
+  if (cluster_ == nullptr) {
+    return absl::nullopt;
+  }
+  if (client_cache_ != nullptr && client_cache_->cacheable(key)) {
+    // The command for the key must be seen by the client cache on its own.
+    return absl::nullopt;
+  }
+
+  Clusters::Redis::RedisLoadBalancerContextImpl lb_context(
+      key, config_->enableHashtagging(), is_redis_cluster_, request, config_->readPolicy());
+  if (is_redis_cluster_) {
+    // A Redis Cluster only accepts multi-key commands whose keys hash to the same slot, and so to
+    // the same hash key.
+    return lb_context.computeHashKey();
+  }
+  if (!is_consistent_hash_lb_) {
+    // Other load balancers may choose another host for the command of the batch than for its keys,
+    // so batching would only add a host choice per key.
+    return absl::nullopt;
+  }
+
+  // A consistent hashing load balancer chooses this host again for the command of the batch.
+  Upstream::HostConstSharedPtr host = cluster_->loadBalancer().chooseHost(&lb_context);
+  if (!host) {
+    return absl::nullopt;
+  }
+  return reinterpret_cast<uintptr_t>(host.get());
+}
+
 Common::Redis::Client::PoolRequest* InstanceImpl::ThreadLocalPool::makeRequestToHost(
     const std::string& host_address, const Common::Redis::RespValue& request,
     Common::Redis::Client::ClientCallbacks& callbacks) {
@@ -404,6 +511,17 @@ Common::Redis::Client::PoolRequest* InstanceImpl::ThreadLocalPool::makeRequestTo
   return client->redis_client_->makeRequest(request, callbacks);
 }
 
+void InstanceImpl::ThreadLocalPool::onCachedResponses() {
+  // The list is swapped out first, as the callbacks may serve more requests from the cache.
+  std::list<CachedResponse> cached_responses;
+  cached_responses.swap(cached_responses_);
+  for (CachedResponse& cached_response : cached_responses) {
+    if (!cached_response.canceled_) {
+      cached_response.pool_callbacks_.onResponse(std::move(cached_response.response_));
+    }
+  }
+}
+
 void InstanceImpl::ThreadLocalPool::onRequestCompleted() {
   ASSERT(!pending_requests_.empty());
 
@@ -458,12 +576,20 @@ InstanceImpl::PendingRequest::~PendingRequest() {
 
 void InstanceImpl::PendingRequest::onResponse(Common::Redis::RespValuePtr&& response) {
   request_handler_ = nullptr;
+  if (client_cache_fill_id_ != 0) {
+    parent_.client_cache_->fill(client_cache_key_, client_cache_fill_id_, *response);
+    client_cache_fill_id_ = 0;
+  }
   pool_callbacks_.onResponse(std::move(response));
   parent_.onRequestCompleted();
 }
 
 void InstanceImpl::PendingRequest::onFailure() {
   request_handler_ = nullptr;
+  if (client_cache_fill_id_ != 0) {
+    parent_.client_cache_->cancelFill(client_cache_key_, client_cache_fill_id_);
+    client_cache_fill_id_ = 0;
+  }
   pool_callbacks_.onFailure();
   parent_.refresh_manager_->onFailure(parent_.cluster_name_);
   parent_.onRequestCompleted();
@@ -472,6 +598,12 @@ void InstanceImpl::PendingRequest::onFailure() {
 void InstanceImpl::PendingRequest::onRedirection(Common::Redis::RespValuePtr&& value,
                                                  const std::string& host_address,
                                                  bool ask_redirection) {
+  // The response of the redirected request comes from another host, which the client cache may
+  // not be tracking.
+  if (client_cache_fill_id_ != 0) {
+    parent_.client_cache_->cancelFill(client_cache_key_, client_cache_fill_id_);
+    client_cache_fill_id_ = 0;
+  }
   if (!parent_.dns_cache_) {
     doRedirection(std::move(value), host_address, ask_redirection);
     return;
@@ -562,6 +694,10 @@ void InstanceImpl::PendingRequest::doRedirection(Common::Redis::RespValuePtr&& v
 void InstanceImpl::PendingRequest::cancel() {
   request_handler_->cancel();
   request_handler_ = nullptr;
+  if (client_cache_fill_id_ != 0) {
+    parent_.client_cache_->cancelFill(client_cache_key_, client_cache_fill_id_);
+    client_cache_fill_id_ = 0;
+  }
   parent_.onRequestCompleted();
 }
 
@@ -27,6 +27,7 @@
 #include "source/extensions/filters/network/common/redis/client_impl.h"
 #include "source/extensions/filters/network/common/redis/codec_impl.h"
 #include "source/extensions/filters/network/common/redis/utility.h"
+#include "source/extensions/filters/network/redis_proxy/client_cache.h"
 #include "source/extensions/filters/network/redis_proxy/conn_pool.h"
 
 #include "absl/container/node_hash_map.h"
@@ -70,6 +71,8 @@ public:
   Common::Redis::Client::PoolRequest*
   makeRequest(const std::string& key, RespVariant&& request, PoolCallbacks& callbacks,
               Common::Redis::Client::Transaction& transaction) override;
+  absl::optional<uint64_t> shard(const std::string& key,
+                                 const Common::Redis::RespValue& request) override;
   /**
    * Makes a redis request based on IP address and TCP port of the upstream host (e.g.,
    * moved/ask cluster redirection). This is now only kept mostly for testing.
@@ -142,6 +145,24 @@ private:
     bool ask_redirection_;
     Extensions::Common::DynamicForwardProxy::DnsCache::LoadDnsCacheEntryHandlePtr
         cache_load_handle_;
+    // The key and fill ID of a GET command whose response fills the client cache.
+    std::string client_cache_key_;
+    uint64_t client_cache_fill_id_{};
+  };
+
+  // A response served from the client cache. It is delivered on the next iteration of the event
+  // loop, as the caller expects the callbacks to be invoked after makeRequest() returns.
+  struct CachedResponse : public Common::Redis::Client::PoolRequest {
+    CachedResponse(const Common::Redis::RespValue& response, PoolCallbacks& pool_callbacks)
+        : response_(std::make_unique<Common::Redis::RespValue>(response)),
+          pool_callbacks_(pool_callbacks) {}
+
+    // PoolRequest
+    void cancel() override { canceled_ = true; }
+
+    Common::Redis::RespValuePtr response_;
+    PoolCallbacks& pool_callbacks_;
+    bool canceled_{};
   };
 
   struct ThreadLocalPool : public ThreadLocal::ThreadLocalObject,
@@ -155,6 +176,7 @@ private:
     Common::Redis::Client::PoolRequest*
     makeRequest(const std::string& key, RespVariant&& request, PoolCallbacks& callbacks,
                 Common::Redis::Client::Transaction& transaction);
+    absl::optional<uint64_t> shard(const std::string& key, const Common::Redis::RespValue& request);
     Common::Redis::Client::PoolRequest*
     makeRequestToHost(const std::string& host_address, const Common::Redis::RespValue& request,
                       Common::Redis::Client::ClientCallbacks& callbacks);
@@ -173,6 +195,7 @@ private:
     void onClusterRemoval(const std::string& cluster_name) override;
 
     void onRequestCompleted();
+    void onCachedResponses();
 
     std::weak_ptr<InstanceImpl> parent_;
     Event::Dispatcher& dispatcher_;
@@ -198,12 +221,16 @@ private:
      */
     Event::TimerPtr drain_timer_;
     bool is_redis_cluster_{false};
+    bool is_consistent_hash_lb_{false};
     Common::Redis::Client::ClientFactory& client_factory_;
     Common::Redis::Client::ConfigSharedPtr config_;
     Stats::ScopeSharedPtr stats_scope_;
     Common::Redis::RedisCommandStatsSharedPtr redis_command_stats_;
     RedisClusterStats redis_cluster_stats_;
     const Extensions::Common::Redis::ClusterRefreshManagerSharedPtr refresh_manager_;
+    const ClientCachePtr client_cache_;
+    std::list<CachedResponse> cached_responses_;
+    Event::SchedulableCallbackPtr cached_responses_cb_;
   };
 
   const std::string cluster_name_;
@@ -217,6 +244,7 @@ private:
   RedisClusterStats redis_cluster_stats_;
   const Extensions::Common::Redis::ClusterRefreshManagerSharedPtr refresh_manager_;
   const Extensions::Common::DynamicForwardProxy::DnsCacheSharedPtr dns_cache_{nullptr};
+  const ClientCacheConfigSharedPtr client_cache_config_;
 };
 
 } // namespace ConnPool
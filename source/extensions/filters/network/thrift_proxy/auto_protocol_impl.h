@@ -83,6 +83,9 @@ public:
   bool readBinary(Buffer::Instance& buffer, std::string& value) override {
     return protocol_->readBinary(buffer, value);
   }
+  bool skipValue(Buffer::Instance& buffer, FieldType field_type) override {
+    return protocol_->skipValue(buffer, field_type);
+  }
   void writeMessageBegin(Buffer::Instance& buffer, const MessageMetadata& metadata) override {
     protocol_->writeMessageBegin(buffer, metadata);
   }
@@ -10,10 +10,51 @@
 #include "source/common/runtime/runtime_features.h"
 #include "source/extensions/filters/network/thrift_proxy/buffer_helper.h"
 
+#include "absl/container/inlined_vector.h"
+
 namespace Envoy {
 namespace Extensions {
 namespace NetworkFilters {
 namespace ThriftProxy {
+namespace {
+
+// Returns the encoded size of a value of the given type, or 0 if the size depends on the value.
+uint64_t fixedValueSize(FieldType type) {
+  switch (type) {
+  case FieldType::Bool:
+  case FieldType::Byte:
+    return 1;
+  case FieldType::I16:
+    return 2;
+  case FieldType::I32:
+    return 4;
+  case FieldType::I64:
+  case FieldType::Double:
+    return 8;
+  default:
+    return 0;
+  }
+}
+
+int32_t peekBEInt32(const uint8_t* data) {
+  return static_cast<int32_t>(static_cast<uint32_t>(data[0]) << 24 |
+                              static_cast<uint32_t>(data[1]) << 16 |
+                              static_cast<uint32_t>(data[2]) << 8 | static_cast<uint32_t>(data[3]));
+}
+
+// A struct, list, set, or map which is being skipped by skipValue.
+struct SkipFrame {
+  enum class Type { Struct, List, Map };
+
+  Type type_;
+  // The list or set element type, or the map key type.
+  FieldType elem_type_;
+  FieldType value_type_;
+  // The number of list or set elements, or of map keys and values, which are left to skip.
+  uint64_t remaining_;
+};
+
+} // namespace
 
 const uint16_t BinaryProtocolImpl::Magic = 0x8001;
 
@@ -276,6 +317,145 @@ bool BinaryProtocolImpl::readBinary(Buffer::Instance& buffer, std::string& value
   return readString(buffer, value);
 }
 
+bool BinaryProtocolImpl::skipValue(Buffer::Instance& buffer, FieldType field_type) {
+  const uint64_t length = buffer.length();
+  if (length == 0) {
+    return false;
+  }
+
+  // The value is scanned without linearizing the buffer: only the lengths, sizes, and types are
+  // peeked at, and nothing is drained until all of the value is available. Nested values are
+  // tracked with an explicit stack rather than recursion, and lists, sets, and maps of fixed size
+  // elements are skipped in one step.
+  BufferPeeker peeker(buffer);
+  absl::InlinedVector<SkipFrame, 8> stack;
+  uint64_t offset = 0;
+  FieldType type = field_type;
+  while (true) {
+    switch (type) {
+    case FieldType::String: {
+      if (length - offset < 4) {
+        return false;
+      }
+      const int32_t str_len = peekBEInt32(peeker.peek(offset, 4));
+      if (str_len < 0) {
+        throw EnvoyException(
+            fmt::format("negative binary protocol string/binary length {}", str_len));
+      }
+      if (length - offset - 4 < static_cast<uint64_t>(str_len)) {
+        return false;
+      }
+      offset += 4 + str_len;
+      break;
+    }
+    case FieldType::Struct:
+      stack.push_back({SkipFrame::Type::Struct, FieldType::Stop, FieldType::Stop, 0});
+      break;
+    case FieldType::Map: {
+      if (length - offset < 6) {
+        return false;
+      }
+      const uint8_t* header = peeker.peek(offset, 6);
+      const FieldType key_type = static_cast<FieldType>(header[0]);
+      const FieldType value_type = static_cast<FieldType>(header[1]);
+      const int32_t size = peekBEInt32(header + 2);
+      if (size < 0) {
+        throw EnvoyException(absl::StrCat("negative binary protocol map size ", size));
+      }
+      offset += 6;
+
+      const uint64_t key_size = fixedValueSize(key_type);
+      const uint64_t value_size = fixedValueSize(value_type);
+      if (key_size != 0 && value_size != 0) {
+        const uint64_t map_len = (key_size + value_size) * size;
+        if (length - offset < map_len) {
+          return false;
+        }
+        offset += map_len;
+      } else if (size > 0) {
+        stack.push_back(
+            {SkipFrame::Type::Map, key_type, value_type, 2 * static_cast<uint64_t>(size)});
+      }
+      break;
+    }
+    case FieldType::List:
+    case FieldType::Set: {
+      if (length - offset < 5) {
+        return false;
+      }
+      const uint8_t* header = peeker.peek(offset, 5);
+      const FieldType elem_type = static_cast<FieldType>(header[0]);
+      const int32_t size = peekBEInt32(header + 1);
+      if (size < 0) {
+        throw EnvoyException(fmt::format("negative binary protocol list/set size {}", size));
+      }
+      offset += 5;
+
+      const uint64_t elem_size = fixedValueSize(elem_type);
+      if (elem_size != 0) {
+        const uint64_t list_len = elem_size * size;
+        if (length - offset < list_len) {
+          return false;
+        }
+        offset += list_len;
+      } else if (size > 0) {
+        stack.push_back({SkipFrame::Type::List, elem_type, FieldType::Stop,
+                         static_cast<uint64_t>(size)});
+      }
+      break;
+    }
+    default: {
+      const uint64_t size = fixedValueSize(type);
+      if (size == 0) {
+        throw EnvoyException(fmt::format("unknown field type {}", static_cast<int8_t>(type)));
+      }
+      if (length - offset < size) {
+        return false;
+      }
+      offset += size;
+      break;
+    }
+    }
+
+    // Find the next value to skip, leaving the structs and containers which are complete.
+    while (true) {
+      if (stack.empty()) {
+        buffer.drain(offset);
+        return true;
+      }
+
+      SkipFrame& frame = stack.back();
+      if (frame.type_ == SkipFrame::Type::Struct) {
+        if (length - offset < 1) {
+          return false;
+        }
+        type = static_cast<FieldType>(peeker.peek(offset, 1)[0]);
+        if (type == FieldType::Stop) {
+          offset += 1;
+          stack.pop_back();
+          continue;
+        }
+        // FieldType followed by 2 bytes of field id.
+        if (length - offset < 3) {
+          return false;
+        }
+        offset += 3;
+        break;
+      }
+
+      if (frame.remaining_ == 0) {
+        stack.pop_back();
+        continue;
+      }
+      // Map keys and values alternate, starting with a key.
+      type = frame.type_ == SkipFrame::Type::Map && frame.remaining_ % 2 == 1 ? frame.value_type_
+                                                                               : frame.elem_type_;
+      frame.remaining_--;
+      break;
+    }
+  }
+}
+
 void BinaryProtocolImpl::writeMessageBegin(Buffer::Instance& buffer,
                                            const MessageMetadata& metadata) {
   buffer.writeBEInt<uint16_t>(Magic);
@@ -47,6 +47,7 @@ public:
   bool readDouble(Buffer::Instance& buffer, double& value) override;
   bool readString(Buffer::Instance& buffer, std::string& value) override;
   bool readBinary(Buffer::Instance& buffer, std::string& value) override;
+  bool skipValue(Buffer::Instance& buffer, FieldType field_type) override;
   void writeMessageBegin(Buffer::Instance& buffer, const MessageMetadata& metadata) override;
   void writeMessageEnd(Buffer::Instance& buffer) override;
   void writeStructBegin(Buffer::Instance& buffer, const std::string& name) override;
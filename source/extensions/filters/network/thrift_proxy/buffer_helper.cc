@@ -1,5 +1,7 @@
 #include "source/extensions/filters/network/thrift_proxy/buffer_helper.h"
 
+#include <algorithm>
+
 #include "source/common/common/byte_order.h"
 #include "source/common/common/safe_memcpy.h"
 
@@ -177,6 +179,36 @@ void BufferHelper::writeZigZagI64(Buffer::Instance& buffer, int64_t value) {
   writeVarIntI64(buffer, zz64);
 }
 
+BufferPeeker::BufferPeeker(const Buffer::Instance& buffer)
+    : buffer_(buffer), length_(buffer.length()) {
+  if (length_ != 0) {
+    slices_.push_back(buffer.frontSlice());
+  }
+}
+
+const uint8_t* BufferPeeker::peek(uint64_t offset, uint64_t size) {
+  ASSERT(offset <= length_ && offset >= slice_start_ && size <= MaxPeekSize);
+  size = std::min(size, length_ - offset);
+  if (size == 0) {
+    return scratch_;
+  }
+  if (offset + size > slice_start_ + slices_[slice_].len_ && slices_.size() == 1) {
+    slices_ = buffer_.getRawSlices();
+  }
+  // Offsets only increase, so the slice holding offset is found by moving forward.
+  while (offset >= slice_start_ + slices_[slice_].len_) {
+    slice_start_ += slices_[slice_].len_;
+    slice_++;
+  }
+
+  const uint64_t slice_offset = offset - slice_start_;
+  if (slice_offset + size <= slices_[slice_].len_) {
+    return static_cast<const uint8_t*>(slices_[slice_].mem_) + slice_offset;
+  }
+  buffer_.copyOut(offset, size, scratch_);
+  return scratch_;
+}
+
 } // namespace ThriftProxy
 } // namespace NetworkFilters
 } // namespace Extensions
@@ -116,6 +116,43 @@ private:
   static uint64_t peekVarInt(Buffer::Instance& buffer, uint64_t offset, int& size);
 };
 
+/**
+ * BufferPeeker peeks at the bytes of a buffer at increasing offsets without linearizing it. Bytes
+ * within a slice are read in place, and the few bytes of a read which spans slices are copied.
+ */
+class BufferPeeker {
+public:
+  // The most bytes which one peek can read.
+  static constexpr uint64_t MaxPeekSize = 10;
+
+  explicit BufferPeeker(const Buffer::Instance& buffer);
+
+  /**
+   * @return the length of the buffer when the peeker was created.
+   */
+  uint64_t length() const { return length_; }
+
+  /**
+   * Peeks at up to size bytes at offset, which must be at most length() and not less than the
+   * offset of the previous peek.
+   * @param offset offset into buffer to peek at
+   * @param size the number of bytes to peek at, at most MaxPeekSize. Fewer bytes are peeked at if
+   *        the buffer ends first.
+   * @return the bytes at offset, which are valid until the next peek.
+   */
+  const uint8_t* peek(uint64_t offset, uint64_t size);
+
+private:
+  const Buffer::Instance& buffer_;
+  const uint64_t length_;
+  // The slices of the buffer, which are only listed once a peek goes past the front slice.
+  Buffer::RawSliceVector slices_;
+  uint64_t slice_{};
+  // The offset of slices_[slice_] in the buffer.
+  uint64_t slice_start_{};
+  uint8_t scratch_[MaxPeekSize];
+};
+
 } // namespace ThriftProxy
 } // namespace NetworkFilters
 } // namespace Extensions
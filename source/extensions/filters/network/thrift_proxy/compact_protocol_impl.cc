@@ -10,10 +10,61 @@
 #include "source/common/runtime/runtime_features.h"
 #include "source/extensions/filters/network/thrift_proxy/buffer_helper.h"
 
+#include "absl/container/inlined_vector.h"
+
 namespace Envoy {
 namespace Extensions {
 namespace NetworkFilters {
 namespace ThriftProxy {
+namespace {
+
+// Returns the encoded size of a list, set, or map element of the given type, or 0 if the size
+// depends on the value.
+uint64_t fixedElementSize(FieldType type) {
+  switch (type) {
+  case FieldType::Bool:
+  case FieldType::Byte:
+    return 1;
+  case FieldType::Double:
+    return 8;
+  default:
+    return 0;
+  }
+}
+
+// Peeks at the var int at data, which is at most max_size bytes long. Updates size with the number
+// of bytes it is encoded in, or with 0 if more data is required.
+uint64_t peekVarInt(const uint8_t* data, uint64_t available, uint64_t max_size, uint64_t& size) {
+  const uint64_t last = std::min(available, max_size);
+  uint64_t result = 0;
+  for (uint64_t i = 0; i < last; i++) {
+    result |= static_cast<uint64_t>(data[i] & 0x7f) << (7 * i);
+    if ((data[i] & 0x80) == 0) {
+      size = i + 1;
+      return result;
+    }
+  }
+
+  if (last == max_size) {
+    throw EnvoyException("invalid compact protocol varint");
+  }
+  size = 0;
+  return 0;
+}
+
+// A struct, list, set, or map which is being skipped by skipValue.
+struct SkipFrame {
+  enum class Type { Struct, List, Map };
+
+  Type type_;
+  // The list or set element type, or the map key type.
+  FieldType elem_type_;
+  FieldType value_type_;
+  // The number of list or set elements, or of map keys and values, which are left to skip.
+  uint64_t remaining_;
+};
+
+} // namespace
 
 const uint16_t CompactProtocolImpl::Magic = 0x8201;
 const uint16_t CompactProtocolImpl::MagicMask = 0xFF1F;
@@ -423,6 +474,206 @@ bool CompactProtocolImpl::readBinary(Buffer::Instance& buffer, std::string& valu
   return readString(buffer, value);
 }
 
+bool CompactProtocolImpl::skipValue(Buffer::Instance& buffer, FieldType field_type) {
+  // Boolean struct fields have their value encoded in the field type.
+  if (field_type == FieldType::Bool && bool_value_.has_value()) {
+    return true;
+  }
+
+  const uint64_t length = buffer.length();
+  if (length == 0) {
+    return false;
+  }
+
+  // The value is scanned without linearizing the buffer: only the var ints and types are peeked
+  // at, and nothing is drained until all of the value is available. Nested values are tracked
+  // with an explicit stack rather than recursion, and lists, sets, and maps of fixed size elements
+  // are skipped in one step.
+  BufferPeeker peeker(buffer);
+  absl::InlinedVector<SkipFrame, 8> stack;
+  uint64_t offset = 0;
+  uint64_t size = 0;
+  FieldType type = field_type;
+  while (true) {
+    switch (type) {
+    case FieldType::Bool:
+    case FieldType::Byte:
+    case FieldType::Double: {
+      const uint64_t value_size = fixedElementSize(type);
+      if (length - offset < value_size) {
+        return false;
+      }
+      offset += value_size;
+      break;
+    }
+    case FieldType::I16:
+    case FieldType::I32:
+      peekVarInt(peeker.peek(offset, 5), length - offset, 5, size);
+      if (size == 0) {
+        return false;
+      }
+      offset += size;
+      break;
+    case FieldType::I64:
+      peekVarInt(peeker.peek(offset, 10), length - offset, 10, size);
+      if (size == 0) {
+        return false;
+      }
+      offset += size;
+      break;
+    case FieldType::String: {
+      const int32_t str_len =
+          static_cast<int32_t>(peekVarInt(peeker.peek(offset, 5), length - offset, 5, size));
+      if (size == 0) {
+        return false;
+      }
+      if (str_len < 0) {
+        throw EnvoyException(
+            fmt::format("negative compact protocol string/binary length {}", str_len));
+      }
+      if (length - offset - size < static_cast<uint64_t>(str_len)) {
+        return false;
+      }
+      offset += size + str_len;
+      break;
+    }
+    case FieldType::Struct:
+      stack.push_back({SkipFrame::Type::Struct, FieldType::Stop, FieldType::Stop, 0});
+      break;
+    case FieldType::Map: {
+      const int32_t map_size =
+          static_cast<int32_t>(peekVarInt(peeker.peek(offset, 5), length - offset, 5, size));
+      if (size == 0) {
+        return false;
+      }
+      if (map_size < 0) {
+        throw EnvoyException(absl::StrCat("negative compact protocol map size ", map_size));
+      }
+      if (map_size == 0) {
+        // Empty map. Compact protocol provides no type information in this case.
+        offset += size;
+        break;
+      }
+      if (length - offset - size < 1) {
+        return false;
+      }
+
+      const uint8_t types = peeker.peek(offset + size, 1)[0];
+      const FieldType key_type = convertCompactFieldType(static_cast<CompactFieldType>(types >> 4));
+      const FieldType value_type =
+          convertCompactFieldType(static_cast<CompactFieldType>(types & 0xF));
+      offset += size + 1;
+
+      const uint64_t key_size = fixedElementSize(key_type);
+      const uint64_t value_size = fixedElementSize(value_type);
+      if (key_size != 0 && value_size != 0) {
+        const uint64_t map_len = (key_size + value_size) * map_size;
+        if (length - offset < map_len) {
+          return false;
+        }
+        offset += map_len;
+      } else {
+        stack.push_back(
+            {SkipFrame::Type::Map, key_type, value_type, 2 * static_cast<uint64_t>(map_size)});
+      }
+      break;
+    }
+    case FieldType::List:
+    case FieldType::Set: {
+      if (length - offset < 1) {
+        return false;
+      }
+      const uint8_t size_and_type = peeker.peek(offset, 1)[0];
+      uint64_t list_size = size_and_type >> 4;
+      size = 1;
+      if (list_size == 0xF) {
+        // Long form list header: type byte followed by var int size.
+        uint64_t s_size;
+        const int32_t s = static_cast<int32_t>(
+            peekVarInt(peeker.peek(offset + 1, 5), length - offset - 1, 5, s_size));
+        if (s_size == 0) {
+          return false;
+        }
+        if (s < 0) {
+          throw EnvoyException(fmt::format("negative compact protocol list/set size {}", s));
+        }
+        list_size = static_cast<uint64_t>(s);
+        size += s_size;
+      }
+      const FieldType elem_type =
+          convertCompactFieldType(static_cast<CompactFieldType>(size_and_type & 0x0F));
+      offset += size;
+
+      const uint64_t elem_size = fixedElementSize(elem_type);
+      if (elem_size != 0) {
+        const uint64_t list_len = elem_size * list_size;
+        if (length - offset < list_len) {
+          return false;
+        }
+        offset += list_len;
+      } else if (list_size > 0) {
+        stack.push_back({SkipFrame::Type::List, elem_type, FieldType::Stop, list_size});
+      }
+      break;
+    }
+    default:
+      throw EnvoyException(fmt::format("unknown field type {}", static_cast<int8_t>(type)));
+    }
+
+    // Find the next value to skip, leaving the structs and containers which are complete.
+    while (true) {
+      if (stack.empty()) {
+        buffer.drain(offset);
+        return true;
+      }
+
+      SkipFrame& frame = stack.back();
+      if (frame.type_ == SkipFrame::Type::Struct) {
+        if (length - offset < 1) {
+          return false;
+        }
+        const uint8_t delta_and_type = peeker.peek(offset, 1)[0];
+        if ((delta_and_type & 0x0F) == 0) {
+          offset += 1;
+          stack.pop_back();
+          continue;
+        }
+
+        size = 1;
+        if ((delta_and_type >> 4) == 0) {
+          // Long form field header, followed by zig-zag field id.
+          uint64_t id_size;
+          peekVarInt(peeker.peek(offset + 1, 5), length - offset - 1, 5, id_size);
+          if (id_size == 0) {
+            return false;
+          }
+          size += id_size;
+        }
+        offset += size;
+
+        const auto compact_field_type = static_cast<CompactFieldType>(delta_and_type & 0x0F);
+        if (compact_field_type == CompactFieldType::BoolTrue ||
+            compact_field_type == CompactFieldType::BoolFalse) {
+          // Boolean struct fields have no further data.
+          continue;
+        }
+        type = convertCompactFieldType(compact_field_type);
+        break;
+      }
+
+      if (frame.remaining_ == 0) {
+        stack.pop_back();
+        continue;
+      }
+      // Map keys and values alternate, starting with a key.
+      type = frame.type_ == SkipFrame::Type::Map && frame.remaining_ % 2 == 1 ? frame.value_type_
+                                                                               : frame.elem_type_;
+      frame.remaining_--;
+      break;
+    }
+  }
+}
+
 void CompactProtocolImpl::writeMessageBegin(Buffer::Instance& buffer,
                                             const MessageMetadata& metadata) {
   MessageType msg_type = metadata.messageType();
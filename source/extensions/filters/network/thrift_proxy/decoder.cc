@@ -112,8 +112,9 @@ DecoderStateMachine::DecoderStatus DecoderStateMachine::fieldBegin(Buffer::Insta
 
   stack_.emplace_back(Frame(ProtocolState::FieldEnd, field_type));
 
-  return {ProtocolState::FieldValue,
-          handler_.fieldBegin(absl::string_view(name), field_type, field_id)};
+  const FilterStatus status = handler_.fieldBegin(absl::string_view(name), field_type, field_id);
+  skip_field_value_ = callbacks_.skipFieldValue(field_type, field_id);
+  return {ProtocolState::FieldValue, status};
 }
 
 // FieldValue -> FieldEnd (via stack return state)
@@ -121,6 +122,15 @@ DecoderStateMachine::DecoderStatus DecoderStateMachine::fieldValue(Buffer::Insta
   ASSERT(!stack_.empty());
 
   Frame& frame = stack_.back();
+  if (skip_field_value_) {
+    if (!proto_.skipValue(buffer, frame.elem_type_)) {
+      return {ProtocolState::WaitForData};
+    }
+
+    skip_field_value_ = false;
+    return {frame.return_state_, FilterStatus::Continue};
+  }
+
   return handleValue(buffer, frame.elem_type_, frame.return_state_);
 }
 
@@ -183,6 +183,8 @@ private:
   DecoderCallbacks& callbacks_;
   ProtocolState state_{ProtocolState::MessageBegin};
   std::vector<Frame> stack_;
+  // Whether the value of the current field is skipped, rather than decoded.
+  bool skip_field_value_{};
   uint32_t body_start_{};
   uint32_t body_bytes_{};
 };
@@ -214,6 +216,20 @@ public:
    * @return True if payload header keys should be treated as case-sensitive.
    */
   virtual bool headerKeysPreserveCase() const PURE;
+
+  /**
+   * Called after the DecoderEventHandler's fieldBegin for each struct field. The value of a skipped
+   * field is consumed by Protocol::skipValue, without any DecoderEventHandler events but the
+   * field's fieldEnd.
+   * @param field_type the type of the field
+   * @param field_id the id of the field
+   * @return True if the value of the field is not needed by the DecoderEventHandler.
+   */
+  virtual bool skipFieldValue(FieldType field_type, int16_t field_id) {
+    UNREFERENCED_PARAMETER(field_type);
+    UNREFERENCED_PARAMETER(field_id);
+    return false;
+  }
 };
 
 /**
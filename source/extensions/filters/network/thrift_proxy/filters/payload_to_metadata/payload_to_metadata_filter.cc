@@ -154,6 +154,21 @@ FilterStatus TrieMatchHandler::fieldEnd() {
   return FilterStatus::Continue;
 }
 
+bool TrieMatchHandler::skipFieldValue(FieldType field_type, int16_t field_id) {
+  if (!skip_unmatched_fields_) {
+    return false;
+  }
+
+  // Only the structs on the path to a rule's field, and the value of that field, are decoded.
+  // Values within lists, sets, and maps never match a rule.
+  if (steps_ > 0 || field_type == FieldType::Map || field_type == FieldType::List ||
+      field_type == FieldType::Set) {
+    return true;
+  }
+  assertNode();
+  return !node_->children_.contains(field_id);
+}
+
 FilterStatus TrieMatchHandler::stringValue(absl::string_view value) {
   assertLastFieldId();
   ENVOY_LOG(trace, "TrieMatchHandler stringValue id:{} value:{}", field_ids_.back(), value);
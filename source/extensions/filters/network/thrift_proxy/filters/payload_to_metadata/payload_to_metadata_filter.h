@@ -8,6 +8,7 @@
 
 #include "source/common/common/logger.h"
 #include "source/common/common/matchers.h"
+#include "source/common/runtime/runtime_features.h"
 #include "source/extensions/filters/network/thrift_proxy/decoder.h"
 #include "source/extensions/filters/network/thrift_proxy/filters/pass_through_filter.h"
 
@@ -91,7 +92,10 @@ class TrieMatchHandler : public DecoderCallbacks,
                          public PassThroughDecoderEventHandler,
                          protected Logger::Loggable<Envoy::Logger::Id::thrift> {
 public:
-  TrieMatchHandler(MetadataHandler& parent, TrieSharedPtr root) : parent_(parent), node_(root) {}
+  TrieMatchHandler(MetadataHandler& parent, TrieSharedPtr root)
+      : parent_(parent), node_(root),
+        skip_unmatched_fields_(Runtime::runtimeFeatureEnabled(
+            "envoy.reloadable_features.thrift_payload_to_metadata_skip_unmatched_fields")) {}
 
   // DecoderEventHandler
   FilterStatus messageEnd() override;
@@ -121,6 +125,7 @@ public:
   bool passthroughEnabled() const override { return false; }
   bool isRequest() const override { return true; }
   bool headerKeysPreserveCase() const override { return false; }
+  bool skipFieldValue(FieldType field_type, int16_t field_id) override;
 
   bool isComplete() const { return complete_; };
 
@@ -143,6 +148,8 @@ private:
 
   MetadataHandler& parent_;
   TrieSharedPtr node_;
+  // Whether the values of the fields which can't match a rule are skipped, rather than decoded.
+  const bool skip_unmatched_fields_;
   bool complete_{false};
   std::vector<int16_t> field_ids_;
   int16_t steps_{0};
@@ -270,6 +270,18 @@ public:
    */
   virtual bool readBinary(Buffer::Instance& buffer, std::string& value) PURE;
 
+  /**
+   * Skips a whole value of the given type, including any structs, lists, maps, and sets nested in
+   * it, without decoding it. If successful, the value is removed from the buffer. For a struct
+   * field, this is called in place of reading the field value, after readFieldBegin.
+   * @param buffer the buffer to read from
+   * @param field_type the type of the value to skip
+   * @return true if the value was skipped, false if more data is required, in which case nothing
+   *         is removed from the buffer
+   * @throw EnvoyException if the data is not a valid value
+   */
+  virtual bool skipValue(Buffer::Instance& buffer, FieldType field_type) PURE;
+
   /**
    * Writes the start of a Thrift protocol message to the buffer.
    * @param buffer Buffer::Instance to modify
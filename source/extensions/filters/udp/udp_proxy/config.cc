@@ -1,5 +1,6 @@
 #include "source/extensions/filters/udp/udp_proxy/config.h"
 
+#include "source/common/config/utility.h"
 #include "source/common/filter/config_discovery_impl.h"
 #include "source/common/formatter/substitution_format_string.h"
 
@@ -102,6 +103,11 @@ UdpProxyFilterConfigImpl::UdpProxyFilterConfigImpl(
         "Only one of use_per_packet_load_balancing or session_filters can be used.");
   }
 
+  if (config.has_upstream_packet_writer_config() && config.has_tunneling_config()) {
+    throw EnvoyException(
+        "Only one of upstream_packet_writer_config or tunneling_config can be used.");
+  }
+
   if (use_original_src_ip_ &&
       !Api::OsSysCallsSingleton::get().supportsIpTransparent(
           context.serverFactoryContext().options().localAddressIpVersion())) {
@@ -128,6 +134,15 @@ UdpProxyFilterConfigImpl::UdpProxyFilterConfigImpl(
     tunneling_config_ = std::make_unique<TunnelingConfigImpl>(config.tunneling_config(), context);
   }
 
+  if (config.has_upstream_packet_writer_config()) {
+    auto& factory_factory = Config::Utility::getAndCheckFactory<
+        Network::UdpPacketWriterFactoryFactory>(config.upstream_packet_writer_config());
+    // A factory may not be able to create writers in this build, e.g. GSO without QUIC. Datagrams
+    // are then written directly to the socket.
+    upstream_packet_writer_factory_ =
+        factory_factory.createUdpPacketWriterFactory(config.upstream_packet_writer_config());
+  }
+
   if (config.has_access_log_options()) {
     flush_access_log_on_tunnel_connected_ =
         config.access_log_options().flush_access_log_on_tunnel_connected();
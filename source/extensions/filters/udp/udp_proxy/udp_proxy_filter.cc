@@ -3,6 +3,7 @@
 #include "envoy/network/listener.h"
 
 #include "source/common/buffer/buffer_impl.h"
+#include "source/common/network/io_socket_error_impl.h"
 #include "source/common/network/socket_option_factory.h"
 
 namespace Envoy {
@@ -303,6 +304,14 @@ UdpProxyFilter::UdpActiveSession::UdpActiveSession(
     : ActiveSession(cluster, std::move(addresses), std::move(host)),
       use_original_src_ip_(cluster.filter_.config_->usingOriginalSrcIp()) {}
 
+UdpProxyFilter::UdpActiveSession::~UdpActiveSession() {
+  // Don't lose the datagrams buffered by a batching writer during the current iteration.
+  if (upstream_flush_cb_ != nullptr && upstream_flush_cb_->enabled()) {
+    upstream_flush_cb_->cancel();
+    flushUpstream();
+  }
+}
+
 UdpProxyFilter::ActiveSession::~ActiveSession() {
   ENVOY_BUG(on_session_complete_called_, "onSessionComplete() not called");
 }
@@ -415,6 +424,14 @@ void UdpProxyFilter::UdpActiveSession::onReadReady() {
   cluster_.filter_.read_callbacks_->udpListener().flush();
 }
 
+void UdpProxyFilter::UdpActiveSession::onWriteReady() {
+  ASSERT(upstream_writer_ != nullptr);
+  if (upstream_writer_->isWriteBlocked()) {
+    upstream_writer_->setWritable();
+    flushUpstream();
+  }
+}
+
 bool UdpProxyFilter::ActiveSession::onNewSession() {
   if (cluster_.filter_.config_->accessLogFlushInterval().has_value() &&
       !cluster_.filter_.config_->sessionAccessLogs().empty()) {
@@ -501,8 +518,11 @@ void UdpProxyFilter::UdpActiveSession::writeUpstream(Network::UdpRecvData& data)
             host_->address()->asStringView());
 
   const Network::Address::Ip* local_ip = use_original_src_ip_ ? addresses_.peer_->ip() : nullptr;
-  Api::IoCallUint64Result rc = Network::Utility::writeToSocket(
-      udp_socket_->ioHandle(), *data.buffer_, local_ip, *host_->address());
+  Api::IoCallUint64Result rc =
+      upstream_writer_ != nullptr
+          ? writeUpstreamPacket(*data.buffer_, local_ip)
+          : Network::Utility::writeToSocket(udp_socket_->ioHandle(), *data.buffer_, local_ip,
+                                            *host_->address());
 
   if (!rc.ok()) {
     cluster_.cluster_stats_.sess_tx_errors_.inc();
@@ -512,6 +532,44 @@ void UdpProxyFilter::UdpActiveSession::writeUpstream(Network::UdpRecvData& data)
   }
 }
 
+Api::IoCallUint64Result
+UdpProxyFilter::UdpActiveSession::writeUpstreamPacket(const Buffer::Instance& buffer,
+                                                      const Network::Address::Ip* local_ip) {
+  if (upstream_writer_->isWriteBlocked()) {
+    // Drop the datagram until the socket becomes writable again, as a direct send would.
+    return {0, Network::IoSocketError::getIoSocketEagainError()};
+  }
+
+  const Network::Address::Instance& peer_address = *host_->address();
+  if (!upstream_writer_->isBatchMode()) {
+    return upstream_writer_->writePacket(buffer, local_ip, peer_address);
+  }
+
+  if (buffer.length() > upstream_writer_->getMaxPacketSize(peer_address)) {
+    // The datagram cannot be coalesced. Send what is buffered first to preserve ordering.
+    flushUpstream();
+    return Network::Utility::writeToSocket(udp_socket_->ioHandle(), buffer, local_ip,
+                                           peer_address);
+  }
+
+  Api::IoCallUint64Result rc = upstream_writer_->writePacket(buffer, local_ip, peer_address);
+  if (rc.ok() && !upstream_flush_cb_->enabled()) {
+    // All the datagrams written upstream during this iteration, e.g. those read by one recvmmsg
+    // call on the listener, are sent together.
+    upstream_flush_cb_->scheduleCallbackCurrentIteration();
+  }
+  return rc;
+}
+
+void UdpProxyFilter::UdpActiveSession::flushUpstream() {
+  const Api::IoCallUint64Result rc = upstream_writer_->flush();
+  // On EAGAIN the writer keeps the datagrams and they are flushed once the socket is writable.
+  if (!rc.ok() && rc.err_->getErrorCode() != Api::IoError::IoErrorCode::Again) {
+    ENVOY_LOG(debug, "cannot flush upstream datagrams: {}", rc.err_->getErrorDetails());
+    cluster_.cluster_stats_.sess_tx_errors_.inc();
+  }
+}
+
 bool UdpProxyFilter::ActiveSession::onContinueFilterChain(ActiveReadFilter* filter) {
   ASSERT(filter != nullptr);
 
@@ -562,13 +620,29 @@ void UdpProxyFilter::UdpActiveSession::createUdpSocket(const Upstream::HostConst
   // NOTE: The socket call can only fail due to memory/fd exhaustion. No local ephemeral port
   //       is bound until the first packet is sent to the upstream host.
   udp_socket_ = cluster_.filter_.createUdpSocket(host);
+  Event::Dispatcher& dispatcher = cluster_.filter_.read_callbacks_->udpListener().dispatcher();
+  uint32_t file_events = Event::FileReadyType::Read;
+  Network::UdpPacketWriterFactory* writer_factory =
+      cluster_.filter_.config_->upstreamPacketWriterFactory();
+  if (writer_factory != nullptr) {
+    upstream_writer_ = writer_factory->createUdpPacketWriter(udp_socket_->ioHandle(),
+                                                             cluster_.cluster_.info()->statsScope());
+    upstream_flush_cb_ = dispatcher.createSchedulableCallback([this] { flushUpstream(); });
+    // Write events unblock the writer after a send returned EAGAIN.
+    file_events |= Event::FileReadyType::Write;
+  }
   udp_socket_->ioHandle().initializeFileEvent(
-      cluster_.filter_.read_callbacks_->udpListener().dispatcher(),
-      [this](uint32_t) {
-        onReadReady();
+      dispatcher,
+      [this](uint32_t events) {
+        if (events & Event::FileReadyType::Write) {
+          onWriteReady();
+        }
+        if (events & Event::FileReadyType::Read) {
+          onReadReady();
+        }
         return absl::OkStatus();
       },
-      Event::PlatformDefaultTriggerType, Event::FileReadyType::Read);
+      Event::PlatformDefaultTriggerType, file_events);
 
   ENVOY_LOG(debug, "creating new session: downstream={} local={} upstream={}",
             addresses_.peer_->asStringView(), addresses_.local_->asStringView(),
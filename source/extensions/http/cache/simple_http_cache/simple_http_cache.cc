@@ -1,9 +1,11 @@
 #include "source/extensions/http/cache/simple_http_cache/simple_http_cache.h"
 
+#include "envoy/common/exception.h"
 #include "envoy/extensions/http/cache/simple_http_cache/v3/config.pb.h"
 #include "envoy/registry/registry.h"
 
 #include "source/common/buffer/buffer_impl.h"
+#include "source/common/common/hash.h"
 #include "source/common/http/header_map_impl.h"
 
 namespace Envoy {
@@ -31,25 +33,49 @@ absl::optional<Key> variedRequestKey(const LookupRequest& request,
   return varied_request_key;
 }
 
+// A fragment of a cached body, which keeps the body alive until the buffer referring to it is done
+// with it.
+class CachedBodyFragment : public Buffer::BufferFragment {
+public:
+  CachedBodyFragment(SimpleHttpCache::BodySharedPtr body, const AdjustedByteRange& range)
+      : body_(std::move(body)), begin_(range.begin()), length_(range.length()) {}
+
+  // Buffer::BufferFragment
+  const void* data() const override { return body_->data() + begin_; }
+  size_t size() const override { return length_; }
+  void done() override { delete this; }
+
+private:
+  const SimpleHttpCache::BodySharedPtr body_;
+  const uint64_t begin_;
+  const uint64_t length_;
+};
+
 class SimpleLookupContext : public LookupContext {
 public:
   SimpleLookupContext(SimpleHttpCache& cache, LookupRequest&& request)
-      : cache_(cache), request_(std::move(request)) {}
+      : cache_(cache), request_(std::move(request)), key_(request_.key()) {}
 
   void getHeaders(LookupHeadersCallback&& cb) override {
-    auto entry = cache_.lookup(request_);
+    auto entry = cache_.lookup(request_, key_);
     body_ = std::move(entry.body_);
     trailers_ = std::move(entry.trailers_);
+    const uint64_t body_size = body_ ? body_->size() : 0;
     cb(entry.response_headers_ ? request_.makeLookupResult(std::move(entry.response_headers_),
-                                                           std::move(entry.metadata_), body_.size())
+                                                           std::move(entry.metadata_), body_size)
                                : LookupResult{},
-       body_.empty() && trailers_ == nullptr);
+       body_size == 0 && trailers_ == nullptr);
   }
 
   void getBody(const AdjustedByteRange& range, LookupBodyCallback&& cb) override {
-    ASSERT(range.end() <= body_.length(), "Attempt to read past end of body.");
-    cb(std::make_unique<Buffer::OwnedImpl>(&body_[range.begin()], range.length()),
-       trailers_ == nullptr && range.end() == body_.length());
+    const uint64_t body_size = body_ ? body_->size() : 0;
+    ASSERT(range.end() <= body_size, "Attempt to read past end of body.");
+    auto buffer = std::make_unique<Buffer::OwnedImpl>();
+    if (range.length() > 0) {
+      // The buffer refers to the cached body rather than copying it.
+      buffer->addBufferFragment(*new CachedBodyFragment(body_, range));
+    }
+    cb(std::move(buffer), trailers_ == nullptr && range.end() == body_size);
   }
 
   // The cache must call cb with the cached trailers.
@@ -59,12 +85,14 @@ public:
   }
 
   const LookupRequest& request() const { return request_; }
+  const SimpleHttpCache::HashedKey& key() const { return key_; }
   void onDestroy() override {}
 
 private:
   SimpleHttpCache& cache_;
   const LookupRequest request_;
-  std::string body_;
+  const SimpleHttpCache::HashedKey key_;
+  SimpleHttpCache::BodySharedPtr body_;
   Http::ResponseTrailerMapPtr trailers_;
 };
 
@@ -72,6 +100,7 @@ class SimpleInsertContext : public InsertContext {
 public:
   SimpleInsertContext(LookupContext& lookup_context, SimpleHttpCache& cache)
       : key_(dynamic_cast<SimpleLookupContext&>(lookup_context).request().key()),
+        hashed_key_(dynamic_cast<SimpleLookupContext&>(lookup_context).key()),
         request_headers_(
             dynamic_cast<SimpleLookupContext&>(lookup_context).request().requestHeaders()),
         vary_allow_list_(
@@ -97,7 +126,11 @@ public:
     ASSERT(ready_for_next_chunk || end_stream);
 
     body_.add(chunk);
-    if (end_stream) {
+    if (cache_.maxEntrySizeBytes() > 0 && body_.length() > cache_.maxEntrySizeBytes()) {
+      // The response is too large to be cached, so there is no point in buffering the rest.
+      committed_ = true;
+      ready_for_next_chunk(false);
+    } else if (end_stream) {
       ready_for_next_chunk(commit());
     } else {
       ready_for_next_chunk(true);
@@ -116,17 +149,20 @@ public:
 private:
   bool commit() {
     committed_ = true;
+    auto body = std::make_shared<const std::string>(body_.toString());
+    body_.drain(body_.length());
     if (VaryHeaderUtils::hasVary(*response_headers_)) {
-      return cache_.varyInsert(key_, std::move(response_headers_), std::move(metadata_),
-                               body_.toString(), request_headers_, vary_allow_list_,
-                               std::move(trailers_));
+      return cache_.varyInsert(key_, hashed_key_, std::move(response_headers_),
+                               std::move(metadata_), std::move(body), request_headers_,
+                               vary_allow_list_, std::move(trailers_));
     } else {
-      return cache_.insert(key_, std::move(response_headers_), std::move(metadata_),
-                           body_.toString(), std::move(trailers_));
+      return cache_.insert(hashed_key_, std::move(response_headers_), std::move(metadata_),
+                           std::move(body), std::move(trailers_));
     }
   }
 
   Key key_;
+  const SimpleHttpCache::HashedKey hashed_key_;
   const Http::RequestHeaderMap& request_headers_;
   const VaryAllowList& vary_allow_list_;
   Http::ResponseHeaderMapPtr response_headers_;
@@ -136,8 +172,38 @@ private:
   bool committed_ = false;
   Http::ResponseTrailerMapPtr trailers_;
 };
+
+uint64_t entrySizeBytes(const std::string& serialized_key,
+                        const Http::ResponseHeaderMap& response_headers,
+                        const SimpleHttpCache::BodySharedPtr& body,
+                        const Http::ResponseTrailerMapPtr& trailers) {
+  return serialized_key.size() + response_headers.byteSize() + (body ? body->size() : 0) +
+         (trailers ? trailers->byteSize() : 0);
+}
+
 } // namespace
 
+SimpleHttpCache::HashedKey::HashedKey(const Key& key)
+    : serialized_key_(key.SerializeAsString()), hash_(HashUtil::xxHash64(serialized_key_)) {}
+
+SimpleHttpCache::SimpleHttpCache(uint64_t max_cache_size_bytes) {
+  setMaxCacheSizeBytes(max_cache_size_bytes);
+}
+
+void SimpleHttpCache::setMaxCacheSizeBytes(uint64_t max_cache_size_bytes) {
+  const uint64_t max_shard_size_bytes =
+      max_cache_size_bytes == 0 ? 0 : std::max<uint64_t>(max_cache_size_bytes / NumShards, 1);
+  max_cache_size_bytes_.store(max_cache_size_bytes, std::memory_order_relaxed);
+  max_shard_size_bytes_.store(max_shard_size_bytes, std::memory_order_relaxed);
+  if (max_shard_size_bytes == 0) {
+    return;
+  }
+  for (Shard& shard : shards_) {
+    absl::WriterMutexLock lock(&shard.mutex_);
+    shard.evict(max_shard_size_bytes);
+  }
+}
+
 LookupContextPtr SimpleHttpCache::makeLookupContext(LookupRequest&& request,
                                                     Http::StreamDecoderFilterCallbacks&) {
   return std::make_unique<SimpleLookupContext>(*this, std::move(request));
@@ -148,98 +214,107 @@ void SimpleHttpCache::updateHeaders(const LookupContext& lookup_context,
                                     const ResponseMetadata& metadata,
                                     std::function<void(bool)> on_complete) {
   const auto& simple_lookup_context = static_cast<const SimpleLookupContext&>(lookup_context);
-  const Key& key = simple_lookup_context.request().key();
-  absl::WriterMutexLock lock(&mutex_);
-  auto iter = map_.find(key);
-  if (iter == map_.end() || !iter->second.response_headers_) {
-    on_complete(false);
-    return;
-  }
-  if (VaryHeaderUtils::hasVary(*iter->second.response_headers_)) {
-    absl::optional<Key> varied_key =
-        variedRequestKey(simple_lookup_context.request(), *iter->second.response_headers_);
-    if (!varied_key.has_value()) {
+  absl::optional<HashedKey> varied_key;
+  {
+    Shard& shard = shardFor(simple_lookup_context.key());
+    absl::WriterMutexLock lock(&shard.mutex_);
+    StoredEntry* entry = shard.findMutable(simple_lookup_context.key());
+    if (entry == nullptr || !entry->response_headers_) {
       on_complete(false);
       return;
     }
-    iter = map_.find(varied_key.value());
-    if (iter == map_.end() || !iter->second.response_headers_) {
+    if (!VaryHeaderUtils::hasVary(*entry->response_headers_)) {
+      applyHeaderUpdate(response_headers, *entry->response_headers_);
+      entry->metadata_ = metadata;
+      shard.resize(*entry, maxEntrySizeBytes());
+      on_complete(true);
+      return;
+    }
+    absl::optional<Key> key =
+        variedRequestKey(simple_lookup_context.request(), *entry->response_headers_);
+    if (!key.has_value()) {
       on_complete(false);
       return;
     }
+    varied_key.emplace(key.value());
   }
-  Entry& entry = iter->second;
 
-  applyHeaderUpdate(response_headers, *entry.response_headers_);
-  entry.metadata_ = metadata;
+  Shard& shard = shardFor(varied_key.value());
+  absl::WriterMutexLock lock(&shard.mutex_);
+  StoredEntry* entry = shard.findMutable(varied_key.value());
+  if (entry == nullptr || !entry->response_headers_) {
+    on_complete(false);
+    return;
+  }
+  applyHeaderUpdate(response_headers, *entry->response_headers_);
+  entry->metadata_ = metadata;
+  shard.resize(*entry, maxEntrySizeBytes());
   on_complete(true);
 }
 
-SimpleHttpCache::Entry SimpleHttpCache::lookup(const LookupRequest& request) {
-  absl::ReaderMutexLock lock(&mutex_);
-  auto iter = map_.find(request.key());
-  if (iter == map_.end()) {
-    return Entry{};
+SimpleHttpCache::Entry SimpleHttpCache::copyEntry(const StoredEntry& entry) {
+  const uint8_t frequency = entry.frequency_.load(std::memory_order_relaxed);
+  if (frequency < MaxFrequency) {
+    // Concurrent lookups may lose an increment, which only makes the eviction slightly less
+    // accurate.
+    entry.frequency_.store(static_cast<uint8_t>(frequency + 1), std::memory_order_relaxed);
   }
-  ASSERT(iter->second.response_headers_);
-
-  if (VaryHeaderUtils::hasVary(*iter->second.response_headers_)) {
-    return varyLookup(request, iter->second.response_headers_);
-  } else {
-    Http::ResponseTrailerMapPtr trailers_map;
-    if (iter->second.trailers_) {
-      trailers_map = Http::createHeaderMap<Http::ResponseTrailerMapImpl>(*iter->second.trailers_);
-    }
-    return SimpleHttpCache::Entry{
-        Http::createHeaderMap<Http::ResponseHeaderMapImpl>(*iter->second.response_headers_),
-        iter->second.metadata_, iter->second.body_, std::move(trailers_map)};
+  Http::ResponseTrailerMapPtr trailers_map;
+  if (entry.trailers_) {
+    trailers_map = Http::createHeaderMap<Http::ResponseTrailerMapImpl>(*entry.trailers_);
   }
+  return SimpleHttpCache::Entry{
+      Http::createHeaderMap<Http::ResponseHeaderMapImpl>(*entry.response_headers_),
+      entry.metadata_, entry.body_, std::move(trailers_map)};
 }
 
-bool SimpleHttpCache::insert(const Key& key, Http::ResponseHeaderMapPtr&& response_headers,
-                             ResponseMetadata&& metadata, std::string&& body,
-                             Http::ResponseTrailerMapPtr&& trailers) {
-  absl::WriterMutexLock lock(&mutex_);
-  map_[key] = SimpleHttpCache::Entry{std::move(response_headers), std::move(metadata),
-                                     std::move(body), std::move(trailers)};
-  return true;
-}
-
-SimpleHttpCache::Entry
-SimpleHttpCache::varyLookup(const LookupRequest& request,
-                            const Http::ResponseHeaderMapPtr& response_headers) {
-  // This method should be called from lookup, which holds the mutex for reading.
-  mutex_.AssertReaderHeld();
-
-  absl::optional<Key> varied_key = variedRequestKey(request, *response_headers);
+SimpleHttpCache::Entry SimpleHttpCache::lookup(const LookupRequest& request,
+                                               const HashedKey& key) {
+  absl::optional<Key> varied_key;
+  {
+    Shard& shard = shardFor(key);
+    absl::ReaderMutexLock lock(&shard.mutex_);
+    const StoredEntry* entry = shard.find(key);
+    if (entry == nullptr) {
+      return Entry{};
+    }
+    ASSERT(entry->response_headers_);
+    if (!VaryHeaderUtils::hasVary(*entry->response_headers_)) {
+      return copyEntry(*entry);
+    }
+    // Looks for a response that has been varied, which may be in another shard.
+    varied_key = variedRequestKey(request, *entry->response_headers_);
+  }
   if (!varied_key.has_value()) {
-    return SimpleHttpCache::Entry{};
+    return Entry{};
   }
-  Key& varied_request_key = varied_key.value();
 
-  auto iter = map_.find(varied_request_key);
-  if (iter == map_.end()) {
-    return SimpleHttpCache::Entry{};
-  }
-  ASSERT(iter->second.response_headers_);
-  Http::ResponseTrailerMapPtr trailers_map;
-  if (iter->second.trailers_) {
-    trailers_map = Http::createHeaderMap<Http::ResponseTrailerMapImpl>(*iter->second.trailers_);
+  const HashedKey hashed_varied_key(varied_key.value());
+  Shard& shard = shardFor(hashed_varied_key);
+  absl::ReaderMutexLock lock(&shard.mutex_);
+  const StoredEntry* entry = shard.find(hashed_varied_key);
+  if (entry == nullptr) {
+    return Entry{};
   }
+  ASSERT(entry->response_headers_);
+  return copyEntry(*entry);
+}
 
-  return SimpleHttpCache::Entry{
-      Http::createHeaderMap<Http::ResponseHeaderMapImpl>(*iter->second.response_headers_),
-      iter->second.metadata_, iter->second.body_, std::move(trailers_map)};
+bool SimpleHttpCache::insert(const HashedKey& key, Http::ResponseHeaderMapPtr&& response_headers,
+                             ResponseMetadata&& metadata, BodySharedPtr&& body,
+                             Http::ResponseTrailerMapPtr&& trailers) {
+  Shard& shard = shardFor(key);
+  absl::WriterMutexLock lock(&shard.mutex_);
+  return shard.insert(key, std::move(response_headers), std::move(metadata), std::move(body),
+                      std::move(trailers), maxEntrySizeBytes());
 }
 
-bool SimpleHttpCache::varyInsert(const Key& request_key,
+bool SimpleHttpCache::varyInsert(const Key& request_key, const HashedKey& hashed_request_key,
                                  Http::ResponseHeaderMapPtr&& response_headers,
-                                 ResponseMetadata&& metadata, std::string&& body,
+                                 ResponseMetadata&& metadata, BodySharedPtr&& body,
                                  const Http::RequestHeaderMap& request_headers,
                                  const VaryAllowList& vary_allow_list,
                                  Http::ResponseTrailerMapPtr&& trailers) {
-  absl::WriterMutexLock lock(&mutex_);
-
   absl::btree_set<absl::string_view> vary_header_values =
       VaryHeaderUtils::getVaryValues(*response_headers);
   ASSERT(!vary_header_values.empty());
@@ -252,25 +327,28 @@ bool SimpleHttpCache::varyInsert(const Key& request_key,
     // Skip the insert if we are unable to create a vary key.
     return false;
   }
-
   varied_request_key.add_custom_fields(vary_identifier.value());
-  map_[varied_request_key] = SimpleHttpCache::Entry{
-      std::move(response_headers), std::move(metadata), std::move(body), std::move(trailers)};
+
+  // The vary header values refer to the response headers, which are moved into the cache.
+  const std::string vary_header = absl::StrJoin(vary_header_values, ",");
+  if (!insert(HashedKey(varied_request_key), std::move(response_headers), std::move(metadata),
+              std::move(body), std::move(trailers))) {
+    return false;
+  }
 
   // Add a special entry to flag that this request generates varied responses.
-  auto iter = map_.find(request_key);
-  if (iter == map_.end()) {
+  Shard& shard = shardFor(hashed_request_key);
+  absl::WriterMutexLock lock(&shard.mutex_);
+  if (shard.find(hashed_request_key) == nullptr) {
     Envoy::Http::ResponseHeaderMapPtr vary_only_map =
         Envoy::Http::createHeaderMap<Envoy::Http::ResponseHeaderMapImpl>({});
-    vary_only_map->setCopy(Envoy::Http::CustomHeaders::get().Vary,
-                           absl::StrJoin(vary_header_values, ","));
+    vary_only_map->setCopy(Envoy::Http::CustomHeaders::get().Vary, vary_header);
     // TODO(cbdm): In a cache that evicts entries, we could maintain a list of the "varykey"s that
     // we have inserted as the body for this first lookup. This way, we would know which keys we
     // have inserted for that resource. For the first entry simply use vary_identifier as the
     // entry_list; for future entries append vary_identifier to existing list.
-    std::string entry_list;
-    map_[request_key] =
-        SimpleHttpCache::Entry{std::move(vary_only_map), {}, std::move(entry_list), {}};
+    shard.insert(hashed_request_key, std::move(vary_only_map), {}, nullptr, nullptr,
+                 maxEntrySizeBytes());
   }
   return true;
 }
@@ -281,6 +359,147 @@ InsertContextPtr SimpleHttpCache::makeInsertContext(LookupContextPtr&& lookup_co
   return std::make_unique<SimpleInsertContext>(*lookup_context, *this);
 }
 
+uint64_t SimpleHttpCache::sizeBytes() {
+  uint64_t size_bytes = 0;
+  for (Shard& shard : shards_) {
+    absl::ReaderMutexLock lock(&shard.mutex_);
+    size_bytes += shard.sizeBytes();
+  }
+  return size_bytes;
+}
+
+const SimpleHttpCache::StoredEntry* SimpleHttpCache::Shard::find(const HashedKey& key) const {
+  const auto it = entries_.find(key.hash_);
+  if (it == entries_.end() || it->second->serialized_key_ != key.serialized_key_) {
+    return nullptr;
+  }
+  return &*it->second;
+}
+
+SimpleHttpCache::StoredEntry* SimpleHttpCache::Shard::findMutable(const HashedKey& key) {
+  const auto it = entries_.find(key.hash_);
+  if (it == entries_.end() || it->second->serialized_key_ != key.serialized_key_) {
+    return nullptr;
+  }
+  return &*it->second;
+}
+
+bool SimpleHttpCache::Shard::insert(const HashedKey& key,
+                                    Http::ResponseHeaderMapPtr&& response_headers,
+                                    ResponseMetadata&& metadata, BodySharedPtr&& body,
+                                    Http::ResponseTrailerMapPtr&& trailers,
+                                    uint64_t max_size_bytes) {
+  const uint64_t size_bytes =
+      entrySizeBytes(key.serialized_key_, *response_headers, body, trailers);
+  // An entry with the same hash is replaced, whether it has the same key or not.
+  bool in_main = false;
+  const auto existing = entries_.find(key.hash_);
+  if (existing != entries_.end()) {
+    in_main = existing->second->in_main_;
+    remove(existing->second);
+  } else {
+    // An entry evicted from the small queue recently is likely to be looked up again.
+    in_main = ghosts_.erase(key.hash_) > 0;
+  }
+  if (max_size_bytes > 0 && size_bytes > max_size_bytes) {
+    return false;
+  }
+
+  EntryList& queue = in_main ? main_ : small_;
+  StoredEntry& entry = queue.emplace_front();
+  entry.serialized_key_ = key.serialized_key_;
+  entry.hash_ = key.hash_;
+  entry.response_headers_ = std::move(response_headers);
+  entry.metadata_ = std::move(metadata);
+  entry.body_ = std::move(body);
+  entry.trailers_ = std::move(trailers);
+  entry.size_bytes_ = size_bytes;
+  entry.in_main_ = in_main;
+  (in_main ? main_size_bytes_ : small_size_bytes_) += size_bytes;
+  entries_[key.hash_] = queue.begin();
+
+  if (max_size_bytes > 0) {
+    evict(max_size_bytes);
+  }
+  return true;
+}
+
+void SimpleHttpCache::Shard::resize(StoredEntry& entry, uint64_t max_size_bytes) {
+  const uint64_t size_bytes =
+      entrySizeBytes(entry.serialized_key_, *entry.response_headers_, entry.body_, entry.trailers_);
+  uint64_t& queue_size_bytes = entry.in_main_ ? main_size_bytes_ : small_size_bytes_;
+  queue_size_bytes = queue_size_bytes - entry.size_bytes_ + size_bytes;
+  entry.size_bytes_ = size_bytes;
+  if (max_size_bytes > 0) {
+    evict(max_size_bytes);
+  }
+}
+
+void SimpleHttpCache::Shard::remove(EntryList::iterator entry) {
+  entries_.erase(entry->hash_);
+  if (entry->in_main_) {
+    main_size_bytes_ -= entry->size_bytes_;
+    main_.erase(entry);
+  } else {
+    small_size_bytes_ -= entry->size_bytes_;
+    small_.erase(entry);
+  }
+}
+
+void SimpleHttpCache::Shard::evict(uint64_t max_size_bytes) {
+  const uint64_t max_small_size_bytes = max_size_bytes * SmallQueuePercent / 100;
+  while (sizeBytes() > max_size_bytes) {
+    // The most recently inserted entry is kept in the small queue even if it exceeds the small
+    // queue's share, as long as other entries can be evicted.
+    if (main_.empty() || (small_size_bytes_ > max_small_size_bytes && small_.size() > 1)) {
+      evictFromSmall();
+    } else {
+      evictFromMain();
+    }
+  }
+}
+
+void SimpleHttpCache::Shard::evictFromSmall() {
+  const auto entry = std::prev(small_.end());
+  if (entry->frequency_.load(std::memory_order_relaxed) == 0) {
+    addGhost(entry->hash_);
+    remove(entry);
+    return;
+  }
+  // The entry was looked up while in the small queue, so it moves to the main queue.
+  entry->frequency_.store(0, std::memory_order_relaxed);
+  entry->in_main_ = true;
+  small_size_bytes_ -= entry->size_bytes_;
+  main_size_bytes_ += entry->size_bytes_;
+  main_.splice(main_.begin(), small_, entry);
+}
+
+void SimpleHttpCache::Shard::evictFromMain() {
+  const auto entry = std::prev(main_.end());
+  const uint8_t frequency = entry->frequency_.load(std::memory_order_relaxed);
+  if (frequency == 0) {
+    remove(entry);
+    return;
+  }
+  entry->frequency_.store(static_cast<uint8_t>(frequency - 1), std::memory_order_relaxed);
+  main_.splice(main_.begin(), main_, entry);
+}
+
+void SimpleHttpCache::Shard::addGhost(uint64_t hash) {
+  const uint64_t sequence = ++ghost_sequence_;
+  ghosts_[hash] = sequence;
+  ghost_queue_.emplace_back(hash, sequence);
+  // Remember as many evictions as there are entries in the main queue.
+  while (ghost_queue_.size() > std::max<size_t>(main_.size(), 1)) {
+    const auto [oldest_hash, oldest_sequence] = ghost_queue_.front();
+    ghost_queue_.pop_front();
+    const auto ghost = ghosts_.find(oldest_hash);
+    if (ghost != ghosts_.end() && ghost->second == oldest_sequence) {
+      ghosts_.erase(ghost);
+    }
+  }
+}
+
 constexpr absl::string_view Name = "envoy.extensions.http.cache.simple";
 
 CacheInfo SimpleHttpCache::cacheInfo() const {
@@ -302,15 +521,24 @@ public:
   }
   // From HttpCacheFactory
   std::shared_ptr<HttpCache>
-  getCache(const envoy::extensions::filters::http::cache::v3::CacheConfig&,
+  getCache(const envoy::extensions::filters::http::cache::v3::CacheConfig& filter_config,
            Server::Configuration::FactoryContext& context) override {
-    return context.serverFactoryContext().singletonManager().getTyped<SimpleHttpCache>(
-        SINGLETON_MANAGER_REGISTERED_NAME(simple_http_cache_singleton), &createCache);
-  }
-
-private:
-  static std::shared_ptr<Singleton::Instance> createCache() {
-    return std::make_shared<SimpleHttpCache>();
+    envoy::extensions::http::cache::simple_http_cache::v3::SimpleHttpCacheConfig config;
+    THROW_IF_NOT_OK(MessageUtil::unpackTo(filter_config.typed_config(), config));
+    const uint64_t max_cache_size_bytes =
+        PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, max_cache_size_bytes, 0);
+    std::shared_ptr<SimpleHttpCache> cache =
+        context.serverFactoryContext().singletonManager().getTyped<SimpleHttpCache>(
+            SINGLETON_MANAGER_REGISTERED_NAME(simple_http_cache_singleton),
+            [max_cache_size_bytes] {
+              return std::make_shared<SimpleHttpCache>(max_cache_size_bytes);
+            });
+    // The cache is shared by all the filters using it, so the latest configuration applies, e.g.
+    // after a listener update which changed the size.
+    if (cache->maxCacheSizeBytes() != max_cache_size_bytes) {
+      cache->setMaxCacheSizeBytes(max_cache_size_bytes);
+    }
+    return cache;
   }
 };
 
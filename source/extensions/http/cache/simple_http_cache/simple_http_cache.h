@@ -1,5 +1,11 @@
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <deque>
+#include <list>
+#include <memory>
+
 #include "source/common/protobuf/utility.h"
 #include "source/extensions/filters/http/cache/http_cache.h"
 
@@ -12,27 +18,53 @@ namespace Extensions {
 namespace HttpFilters {
 namespace Cache {
 
-// Example cache backend that never evicts. Not suitable for production use.
+/**
+ * In-memory cache backend.
+ *
+ * Entries are spread over NumShards shards by a hash of their key, which is computed once per
+ * request. Each shard has its own lock, so that requests for different resources rarely contend.
+ *
+ * When a maximum size is configured, each shard keeps its entries within its share of it, evicting
+ * them following the S3-FIFO algorithm: new entries go to a small FIFO queue, and only the ones
+ * which are looked up again before reaching its end move to the main FIFO queue, which holds most
+ * of the cache. Entries at the end of the main queue which were looked up since they were last
+ * there are reinserted instead of evicted. The keys of the entries evicted from the small queue
+ * are remembered for a while, so that an entry inserted again soon after goes to the main queue.
+ *
+ * Bodies are stored once and shared by the responses served from the cache, without copying them.
+ */
 class SimpleHttpCache : public HttpCache, public Singleton::Instance {
-private:
+public:
+  static constexpr uint32_t NumShards = 16;
+  // Share of a shard's maximum size held by its small queue, in percent.
+  static constexpr uint64_t SmallQueuePercent = 10;
+  // Maximum number of lookups counted for an entry between two passes at the end of a queue.
+  static constexpr uint8_t MaxFrequency = 3;
+
+  using BodySharedPtr = std::shared_ptr<const std::string>;
+
+  // A key, along with the hash which selects its shard and its entry in the shard.
+  struct HashedKey {
+    explicit HashedKey(const Key& key);
+
+    // Key has no map fields, so its serialization is deterministic and identifies it.
+    std::string serialized_key_;
+    uint64_t hash_;
+  };
+
+  // A response found in the cache.
   struct Entry {
     Http::ResponseHeaderMapPtr response_headers_;
     ResponseMetadata metadata_;
-    std::string body_;
+    BodySharedPtr body_;
     Http::ResponseTrailerMapPtr trailers_;
   };
 
-  // Looks for a response that has been varied. Only called from lookup.
-  Entry varyLookup(const LookupRequest& request,
-                   const Http::ResponseHeaderMapPtr& response_headers);
+  /**
+   * @param max_cache_size_bytes the maximum size of the cache, or 0 for a cache which never evicts.
+   */
+  explicit SimpleHttpCache(uint64_t max_cache_size_bytes = 0);
 
-  // A list of headers that we do not want to update upon validation
-  // We skip these headers because either it's updated by other application logic
-  // or they are fall into categories defined in the IETF doc below
-  // https://www.ietf.org/archive/id/draft-ietf-httpbis-cache-18.html s3.2
-  static const absl::flat_hash_set<Http::LowerCaseString> headersNotToUpdate();
-
-public:
   // HttpCache
   LookupContextPtr makeLookupContext(LookupRequest&& request,
                                      Http::StreamDecoderFilterCallbacks& callbacks) override;
@@ -44,19 +76,105 @@ public:
                      std::function<void(bool)> on_complete) override;
   CacheInfo cacheInfo() const override;
 
-  Entry lookup(const LookupRequest& request);
-  bool insert(const Key& key, Http::ResponseHeaderMapPtr&& response_headers,
-              ResponseMetadata&& metadata, std::string&& body,
+  Entry lookup(const LookupRequest& request, const HashedKey& key);
+  bool insert(const HashedKey& key, Http::ResponseHeaderMapPtr&& response_headers,
+              ResponseMetadata&& metadata, BodySharedPtr&& body,
               Http::ResponseTrailerMapPtr&& trailers);
 
   // Inserts a response that has been varied on certain headers.
-  bool varyInsert(const Key& request_key, Http::ResponseHeaderMapPtr&& response_headers,
-                  ResponseMetadata&& metadata, std::string&& body,
-                  const Http::RequestHeaderMap& request_headers,
+  bool varyInsert(const Key& request_key, const HashedKey& hashed_request_key,
+                  Http::ResponseHeaderMapPtr&& response_headers, ResponseMetadata&& metadata,
+                  BodySharedPtr&& body, const Http::RequestHeaderMap& request_headers,
                   const VaryAllowList& vary_allow_list, Http::ResponseTrailerMapPtr&& trailers);
 
-  absl::Mutex mutex_;
-  absl::flat_hash_map<Key, Entry, MessageUtil, MessageUtil> map_ ABSL_GUARDED_BY(mutex_);
+  uint64_t maxCacheSizeBytes() const {
+    return max_cache_size_bytes_.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * Changes the maximum size of the cache, evicting entries right away if it shrinks.
+   * @param max_cache_size_bytes the maximum size of the cache, or 0 for a cache which never evicts.
+   */
+  void setMaxCacheSizeBytes(uint64_t max_cache_size_bytes);
+
+  /**
+   * @return the largest response the cache accepts, or 0 if there is no limit.
+   */
+  uint64_t maxEntrySizeBytes() const {
+    return max_shard_size_bytes_.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * @return the sum of the sizes of the entries of the cache.
+   */
+  uint64_t sizeBytes();
+
+private:
+  struct StoredEntry {
+    std::string serialized_key_;
+    uint64_t hash_{};
+    Http::ResponseHeaderMapPtr response_headers_;
+    ResponseMetadata metadata_;
+    BodySharedPtr body_;
+    Http::ResponseTrailerMapPtr trailers_;
+    uint64_t size_bytes_{};
+    // Number of lookups since the entry was inserted, or last reached the end of a queue.
+    mutable std::atomic<uint8_t> frequency_{0};
+    bool in_main_{false};
+  };
+  using EntryList = std::list<StoredEntry>;
+
+  class Shard {
+  public:
+    const StoredEntry* find(const HashedKey& key) const ABSL_SHARED_LOCKS_REQUIRED(mutex_);
+    StoredEntry* findMutable(const HashedKey& key) ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+    bool insert(const HashedKey& key, Http::ResponseHeaderMapPtr&& response_headers,
+                ResponseMetadata&& metadata, BodySharedPtr&& body,
+                Http::ResponseTrailerMapPtr&& trailers, uint64_t max_size_bytes)
+        ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+    // Accounts for a change of the size of an entry, e.g. after updating its headers.
+    void resize(StoredEntry& entry, uint64_t max_size_bytes) ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+    uint64_t sizeBytes() const ABSL_SHARED_LOCKS_REQUIRED(mutex_) {
+      return small_size_bytes_ + main_size_bytes_;
+    }
+    // Evicts entries until the shard is within max_size_bytes.
+    void evict(uint64_t max_size_bytes) ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+    mutable absl::Mutex mutex_;
+
+  private:
+    void remove(EntryList::iterator entry) ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+    void evictFromSmall() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+    void evictFromMain() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+    void addGhost(uint64_t hash) ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+    absl::flat_hash_map<uint64_t, EntryList::iterator> entries_ ABSL_GUARDED_BY(mutex_);
+    // The queues, from the most to the least recently inserted entry.
+    EntryList small_ ABSL_GUARDED_BY(mutex_);
+    EntryList main_ ABSL_GUARDED_BY(mutex_);
+    uint64_t small_size_bytes_ ABSL_GUARDED_BY(mutex_){0};
+    uint64_t main_size_bytes_ ABSL_GUARDED_BY(mutex_){0};
+    // The hashes of the keys recently evicted from the small queue, mapped to the sequence number
+    // of their eviction, and the queue of these evictions, from the oldest to the newest. The
+    // queue may refer to hashes which were removed from the map, or evicted again since.
+    absl::flat_hash_map<uint64_t, uint64_t> ghosts_ ABSL_GUARDED_BY(mutex_);
+    std::deque<std::pair<uint64_t, uint64_t>> ghost_queue_ ABSL_GUARDED_BY(mutex_);
+    uint64_t ghost_sequence_ ABSL_GUARDED_BY(mutex_){0};
+  };
+
+  static Entry copyEntry(const StoredEntry& entry);
+  Shard& shardFor(const HashedKey& key) { return shards_[key.hash_ % NumShards]; }
+
+  // A list of headers that we do not want to update upon validation
+  // We skip these headers because either it's updated by other application logic
+  // or they are fall into categories defined in the IETF doc below
+  // https://www.ietf.org/archive/id/draft-ietf-httpbis-cache-18.html s3.2
+  static const absl::flat_hash_set<Http::LowerCaseString> headersNotToUpdate();
+
+  // Atomic as the size may change while requests use the cache on the workers.
+  std::atomic<uint64_t> max_cache_size_bytes_{0};
+  std::atomic<uint64_t> max_shard_size_bytes_{0};
+  std::array<Shard, NumShards> shards_;
 };
 
 } // namespace Cache
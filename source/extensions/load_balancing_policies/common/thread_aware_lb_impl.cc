@@ -1,8 +1,11 @@
 #include "source/extensions/load_balancing_policies/common/thread_aware_lb_impl.h"
 
+#include <algorithm>
 #include <memory>
 #include <random>
 
+#include "absl/container/inlined_vector.h"
+
 namespace Envoy {
 namespace Upstream {
 
@@ -233,8 +236,11 @@ ThreadAwareLoadBalancerBase::BoundedLoadHashingLoadBalancer::chooseHost(uint64_t
   //
   // If weights are specified on the hosts, they are respected.
   //
-  // This is an O(N) algorithm, unlike other load balancers. Using a lower `hash_balance_factor`
-  // results in more hosts being probed, so use a higher value if you require better performance.
+  // Hashing load balancers which provide a probe sequence are probed first, at a single lookup per
+  // probe and up to MaxBoundedLoadProbes probes. Only if none of the probes finds a host with spare
+  // capacity, and the probes did not cover every host, is every host visited, which is an O(N)
+  // algorithm, unlike other load balancers. Using a lower `hash_balance_factor` results in more
+  // hosts being probed, so use a higher value if you require better performance.
 
   if (normalized_host_weights_.empty()) {
     return nullptr;
@@ -254,10 +260,50 @@ ThreadAwareLoadBalancerBase::BoundedLoadHashingLoadBalancer::chooseHost(uint64_t
     return host;
   }
 
+  const uint32_t num_hosts = normalized_host_weights_.size();
+  HostConstSharedPtr alt_host, least_overloaded_host = host;
+  double least_overload_factor = overload_factor;
+
+  // The probes of each attempt are distinct, so that a retry does not get the same host again.
+  if (probe_hashing_lb_) {
+    // The distinct hosts probed so far, besides the chosen one. Once they are all the other hosts,
+    // the least overloaded host is known and visiting every host would not change it.
+    absl::InlinedVector<const Host*, MaxBoundedLoadProbes> probed_hosts;
+    const uint32_t num_probes = std::min(num_hosts, MaxBoundedLoadProbes);
+    for (uint32_t probe = 0; probe < num_probes; probe++) {
+      alt_host = hashing_lb_ptr_->probeHost(hash, attempt * num_probes + probe);
+      if (alt_host == nullptr) {
+        break;
+      }
+      if (alt_host == host ||
+          std::find(probed_hosts.begin(), probed_hosts.end(), alt_host.get()) !=
+              probed_hosts.end()) {
+        continue;
+      }
+      probed_hosts.push_back(alt_host.get());
+
+      overload_factor = hostOverloadFactor(*alt_host, normalized_host_weights_map_.at(alt_host));
+      if (overload_factor <= 1.0) {
+        ENVOY_LOG_MISC(debug,
+                       "ThreadAwareLoadBalancerBase::BoundedLoadHashingLoadBalancer::chooseHost: "
+                       "selected host {} (probe:{})",
+                       alt_host->address()->asString(), probe + 1);
+        return alt_host;
+      }
+
+      if (least_overload_factor > overload_factor) {
+        least_overloaded_host = alt_host;
+        least_overload_factor = overload_factor;
+      }
+      if (probed_hosts.size() + 1 == num_hosts) {
+        return least_overloaded_host;
+      }
+    }
+  }
+
   // When a host is overloaded, we choose the next host in a random manner rather than picking the
   // next one in the ring. The random sequence is seeded by the hash, so the same input gets the
   // same sequence of hosts all the time.
-  const uint32_t num_hosts = normalized_host_weights_.size();
   auto host_index = std::vector<uint32_t>(num_hosts);
   for (uint32_t i = 0; i < num_hosts; i++) {
     host_index[i] = i;
@@ -279,8 +325,6 @@ ThreadAwareLoadBalancerBase::BoundedLoadHashingLoadBalancer::chooseHost(uint64_t
     return x;
   };
 
-  HostConstSharedPtr alt_host, least_overloaded_host = host;
-  double least_overload_factor = overload_factor;
   for (uint32_t i = 0; i < num_hosts; i++) {
     // The random shuffle algorithm
     const uint32_t j = uniform_int(random, num_hosts - i);
@@ -8,6 +8,7 @@
 #include "source/common/common/logger.h"
 #include "source/common/config/metadata.h"
 #include "source/common/config/well_known_names.h"
+#include "source/common/runtime/runtime_features.h"
 #include "source/extensions/load_balancing_policies/common/load_balancer_impl.h"
 
 #include "absl/strings/string_view.h"
@@ -33,6 +34,16 @@ public:
   public:
     virtual ~HashingLoadBalancer() = default;
     virtual HostConstSharedPtr chooseHost(uint64_t hash, uint32_t attempt) const PURE;
+    /**
+     * @return the host at the given position of the sequence of hosts probed for hash when the
+     *         host chosen for it is overloaded, or nullptr if this load balancer has no such
+     *         sequence. The positions are spread over the ring or table, so hosts are probed in
+     *         proportion to their weight and the overflow of a host does not cascade onto its
+     *         neighbours.
+     */
+    virtual HostConstSharedPtr probeHost(uint64_t /* hash */, uint32_t /* probe */) const {
+      return nullptr;
+    }
     const absl::string_view hashKey(HostConstSharedPtr host, bool use_hostname) const {
       const ProtobufWkt::Value& val = Config::Metadata::metadataValue(
           host->metadata().get(), Config::MetadataFilters::get().ENVOY_LB,
@@ -57,13 +68,18 @@ public:
    */
   class BoundedLoadHashingLoadBalancer : public HashingLoadBalancer {
   public:
+    // The most probes of the hashing load balancer per attempt, before every host is visited.
+    static constexpr uint32_t MaxBoundedLoadProbes = 8;
+
     BoundedLoadHashingLoadBalancer(HashingLoadBalancerSharedPtr hashing_lb_ptr,
                                    NormalizedHostWeightVector normalized_host_weights,
                                    uint32_t hash_balance_factor)
         : normalized_host_weights_map_(initNormalizedHostWeightMap(normalized_host_weights)),
           hashing_lb_ptr_(std::move(hashing_lb_ptr)),
           normalized_host_weights_(std::move(normalized_host_weights)),
-          hash_balance_factor_(hash_balance_factor) {
+          hash_balance_factor_(hash_balance_factor),
+          probe_hashing_lb_(Runtime::runtimeFeatureEnabled(
+              "envoy.reloadable_features.bounded_load_probe_hashing_lb")) {
       ASSERT(hashing_lb_ptr_ != nullptr);
       ASSERT(hash_balance_factor > 0);
     }
@@ -85,6 +101,8 @@ public:
     const HashingLoadBalancerSharedPtr hashing_lb_ptr_;
     const NormalizedHostWeightVector normalized_host_weights_;
     const uint32_t hash_balance_factor_;
+    // Whether to probe the hashing load balancer before visiting every host.
+    const bool probe_hashing_lb_;
   };
   // Upstream::ThreadAwareLoadBalancer
   LoadBalancerFactorySharedPtr factory() override { return factory_; }
@@ -1,12 +1,19 @@
 #include "source/extensions/load_balancing_policies/maglev/maglev_lb.h"
 
+#include <limits>
+#include <thread>
+
 #include "envoy/config/cluster/v3/cluster.pb.h"
 
+#include "source/common/common/thread_impl.h"
 #include "source/common/runtime/runtime_features.h"
 
+#include "absl/container/flat_hash_map.h"
+
 namespace Envoy {
 namespace Upstream {
 namespace {
+
 bool shouldUseCompactTable(size_t num_hosts, uint64_t table_size) {
   // Don't use compact maglev on 32-bit platforms.
   if constexpr (!(ENVOY_BIT_ARRAY_SUPPORTED)) {
@@ -38,19 +45,20 @@ public:
   static MaglevTableSharedPtr
   createMaglevTable(const NormalizedHostWeightVector& normalized_host_weights,
                     double max_normalized_weight, uint64_t table_size,
-                    bool use_hostname_for_hashing, MaglevLoadBalancerStats& stats) {
+                    bool use_hostname_for_hashing, MaglevLoadBalancerStats& stats,
+                    const MaglevTable* previous, MaglevParallelRunner* runner) {
 
     MaglevTableSharedPtr maglev_table;
     if (shouldUseCompactTable(normalized_host_weights.size(), table_size)) {
-      maglev_table =
-          std::make_shared<CompactMaglevTable>(normalized_host_weights, max_normalized_weight,
-                                               table_size, use_hostname_for_hashing, stats);
+      maglev_table = std::make_shared<CompactMaglevTable>(
+          normalized_host_weights, max_normalized_weight, table_size, use_hostname_for_hashing,
+          stats, previous, runner);
       ENVOY_LOG(debug, "creating compact maglev table given table size {} and number of hosts {}",
                 table_size, normalized_host_weights.size());
     } else {
-      maglev_table =
-          std::make_shared<OriginalMaglevTable>(normalized_host_weights, max_normalized_weight,
-                                                table_size, use_hostname_for_hashing, stats);
+      maglev_table = std::make_shared<OriginalMaglevTable>(
+          normalized_host_weights, max_normalized_weight, table_size, use_hostname_for_hashing,
+          stats, previous, runner);
       ENVOY_LOG(debug, "creating original maglev table given table size {} and number of hosts {}",
                 table_size, normalized_host_weights.size());
     }
@@ -61,6 +69,64 @@ public:
 
 } // namespace
 
+MaglevParallelRunner::MaglevParallelRunner(Thread::ThreadFactory& thread_factory,
+                                           uint32_t concurrency)
+    : concurrency_(concurrency) {
+  ASSERT(concurrency > 1);
+  threads_.reserve(concurrency - 1);
+  for (uint32_t shard = 1; shard < concurrency; ++shard) {
+    threads_.push_back(thread_factory.createThread([this, shard]() { worker(shard); },
+                                                   Thread::Options{"MaglevBuild"}));
+  }
+}
+
+MaglevParallelRunner::~MaglevParallelRunner() {
+  {
+    absl::MutexLock lock(&mutex_);
+    terminate_ = true;
+  }
+  for (Thread::ThreadPtr& thread : threads_) {
+    thread->join();
+  }
+}
+
+void MaglevParallelRunner::run(ShardFunction fn) {
+  absl::MutexLock run_lock(&run_mutex_);
+  {
+    absl::MutexLock lock(&mutex_);
+    fn_ = &fn;
+    pending_ = threads_.size();
+    ++generation_;
+  }
+  fn(0, concurrency_);
+  const auto done = [this]() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) { return pending_ == 0; };
+  absl::MutexLock lock(&mutex_);
+  mutex_.Await(absl::Condition(&done));
+  fn_ = nullptr;
+}
+
+void MaglevParallelRunner::worker(uint32_t shard) {
+  uint64_t generation = 0;
+  while (true) {
+    const ShardFunction* fn;
+    {
+      const auto ready = [this, &generation]() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+        return terminate_ || generation_ != generation;
+      };
+      absl::MutexLock lock(&mutex_);
+      mutex_.Await(absl::Condition(&ready));
+      if (terminate_) {
+        return;
+      }
+      generation = generation_;
+      fn = fn_;
+    }
+    (*fn)(shard, concurrency_);
+    absl::MutexLock lock(&mutex_);
+    --pending_;
+  }
+}
+
 LegacyMaglevLbConfig::LegacyMaglevLbConfig(const ClusterProto& cluster) {
   if (cluster.has_maglev_lb_config()) {
     lb_config_ = cluster.maglev_lb_config();
@@ -73,9 +139,28 @@ ThreadAwareLoadBalancerBase::HashingLoadBalancerSharedPtr
 MaglevLoadBalancer::createLoadBalancer(const NormalizedHostWeightVector& normalized_host_weights,
                                        double /* min_normalized_weight */,
                                        double max_normalized_weight) {
-  HashingLoadBalancerSharedPtr maglev_lb =
-      MaglevFactory::createMaglevTable(normalized_host_weights, max_normalized_weight, table_size_,
-                                       use_hostname_for_hashing_, stats_);
+  // All the hosts are from the same host set, so their priority identifies the previous table.
+  const bool keep_table = incremental_rebuild_ && !normalized_host_weights.empty();
+  const uint32_t priority = keep_table ? normalized_host_weights.front().first->priority() : 0;
+  const MaglevTable* previous =
+      keep_table && priority < previous_tables_.size() ? previous_tables_[priority].get() : nullptr;
+
+  MaglevParallelRunner* runner = nullptr;
+  if (parallel_build_ && normalized_host_weights.size() >= MaglevTable::MinHostsForParallelBuild) {
+    runner = parallelRunner();
+  }
+
+  MaglevTableSharedPtr maglev_table = MaglevFactory::createMaglevTable(
+      normalized_host_weights, max_normalized_weight, table_size_, use_hostname_for_hashing_,
+      stats_, previous, runner);
+  if (keep_table) {
+    if (priority >= previous_tables_.size()) {
+      previous_tables_.resize(priority + 1);
+    }
+    previous_tables_[priority] = maglev_table;
+  }
+
+  HashingLoadBalancerSharedPtr maglev_lb = std::move(maglev_table);
 
   if (hash_balance_factor_ == 0) {
     return maglev_lb;
@@ -85,9 +170,28 @@ MaglevLoadBalancer::createLoadBalancer(const NormalizedHostWeightVector& normali
       maglev_lb, std::move(normalized_host_weights), hash_balance_factor_);
 }
 
+MaglevParallelRunner* MaglevLoadBalancer::parallelRunner() {
+  // The threads are only started by the first build of a large table, so that the load balancers
+  // of the other clusters don't have any.
+  if (parallel_runner_ == nullptr) {
+    const uint32_t concurrency = std::min<uint32_t>(std::thread::hardware_concurrency(),
+                                                    MaglevTable::MaxParallelBuildThreads);
+    if (concurrency <= 1) {
+      return nullptr;
+    }
+#ifdef WIN32
+    thread_factory_ = std::make_unique<Thread::ThreadFactoryImplWin32>();
+#else
+    thread_factory_ = Thread::PosixThreadFactory::create();
+#endif
+    parallel_runner_ = std::make_unique<MaglevParallelRunner>(*thread_factory_, concurrency);
+  }
+  return parallel_runner_.get();
+}
+
 void MaglevTable::constructMaglevTableInternal(
     const NormalizedHostWeightVector& normalized_host_weights, double max_normalized_weight,
-    bool use_hostname_for_hashing) {
+    bool use_hostname_for_hashing, const MaglevTable* previous, MaglevParallelRunner* runner) {
   // We can't do anything sensible with no hosts.
   if (normalized_host_weights.empty()) {
     ENVOY_LOG(debug, "maglev: normalized hosts weights is empty, skipping building table");
@@ -122,7 +226,17 @@ void MaglevTable::constructMaglevTableInternal(
                                      weight);
   }
 
+  previous_ = previous;
+  use_hostname_for_hashing_ = use_hostname_for_hashing;
+  runner_ = runner;
+  equal_weights_ =
+      std::all_of(table_build_entries.begin(), table_build_entries.end(),
+                  [max_normalized_weight](const TableBuildEntry& entry) {
+                    return entry.weight_ == max_normalized_weight;
+                  });
   constructImplementationInternals(table_build_entries, max_normalized_weight);
+  previous_ = nullptr;
+  runner_ = nullptr;
 
   // Update Stats
   uint64_t min_entries_per_host = table_size_;
@@ -139,15 +253,45 @@ void MaglevTable::constructMaglevTableInternal(
   }
 }
 
-void OriginalMaglevTable::constructImplementationInternals(
-    std::vector<TableBuildEntry>& table_build_entries, double max_normalized_weight) {
-  // Size internal representation for maglev table correctly.
-  table_.resize(table_size_);
+void MaglevTable::assignEntries(std::vector<TableBuildEntry>& table_build_entries,
+                                double max_normalized_weight, AssignFunction assign) {
+  if (previous_ != nullptr && assignIncrementally(table_build_entries, assign)) {
+    return;
+  }
+  assignAll(table_build_entries, max_normalized_weight, assign);
+}
+
+void MaglevTable::assignAll(std::vector<TableBuildEntry>& table_build_entries,
+                            double max_normalized_weight, AssignFunction assign) {
+  MaglevParallelRunner* runner =
+      table_build_entries.size() >= MinHostsForParallelBuild ? runner_ : nullptr;
+
+  // Vector to track whether or not a given entry of the table is assigned.
+  std::vector<bool> occupied(table_size_, false);
 
   // Iterate through the table build entries as many times as it takes to fill up the table.
   uint64_t table_index = 0;
   for (uint32_t iteration = 1; table_index < table_size_; ++iteration) {
-    for (uint64_t i = 0; i < table_build_entries.size() && table_index < table_size_; i++) {
+    if (runner != nullptr) {
+      // The table isn't modified while the cursors are advanced. A table entry which is occupied
+      // now is still occupied when the host's turn comes below, so the sequential pass would have
+      // skipped it too.
+      runner->run([&](uint32_t shard, uint32_t shards) {
+        const size_t begin = table_build_entries.size() * shard / shards;
+        const size_t end = table_build_entries.size() * (shard + 1) / shards;
+        for (size_t i = begin; i < end; ++i) {
+          TableBuildEntry& entry = table_build_entries[i];
+          if (iteration * entry.weight_ < entry.target_weight_) {
+            continue;
+          }
+          while (occupied[permutation(entry)]) {
+            entry.next_++;
+          }
+        }
+      });
+    }
+
+    for (uint32_t i = 0; i < table_build_entries.size() && table_index < table_size_; i++) {
       TableBuildEntry& entry = table_build_entries[i];
       // To understand how target_weight_ and weight_ are used below, consider a host with weight
       // equal to max_normalized_weight. This would be picked on every single iteration. If it had
@@ -158,26 +302,159 @@ void OriginalMaglevTable::constructImplementationInternals(
       }
       entry.target_weight_ += max_normalized_weight;
       uint64_t c = permutation(entry);
-      while (table_[c] != nullptr) {
+      while (occupied[c]) {
         entry.next_++;
         c = permutation(entry);
       }
 
-      table_[c] = entry.host_;
+      assign(c, i);
+      occupied[c] = true;
+
       entry.next_++;
       entry.count_++;
       table_index++;
     }
   }
 }
+
+bool MaglevTable::assignIncrementally(std::vector<TableBuildEntry>& table_build_entries,
+                                      AssignFunction assign) {
+  if (!equal_weights_ || !previous_->equal_weights_ || previous_->table_size_ != table_size_ ||
+      table_build_entries.size() > table_size_) {
+    return false;
+  }
+  const Assignment previous = previous_->assignment();
+  if (previous.hosts_.empty()) {
+    return false;
+  }
+
+  // Map the hosts of the previous table to the new ones by their hash key.
+  absl::flat_hash_map<absl::string_view, uint32_t> indices;
+  indices.reserve(table_build_entries.size());
+  for (uint32_t i = 0; i < table_build_entries.size(); ++i) {
+    if (!indices.emplace(hashKey(table_build_entries[i].host_, use_hostname_for_hashing_), i)
+             .second) {
+      return false;
+    }
+  }
+  constexpr uint32_t Unassigned = std::numeric_limits<uint32_t>::max();
+  std::vector<uint32_t> new_indices(previous.hosts_.size(), Unassigned);
+  std::vector<bool> kept(table_build_entries.size(), false);
+  uint64_t num_kept = 0;
+  for (size_t i = 0; i < previous.hosts_.size(); ++i) {
+    const auto it = indices.find(hashKey(previous.hosts_[i], use_hostname_for_hashing_));
+    if (it == indices.end()) {
+      continue;
+    }
+    if (kept[it->second]) {
+      return false;
+    }
+    kept[it->second] = true;
+    new_indices[i] = it->second;
+    num_kept++;
+  }
+  const uint64_t removed = previous.hosts_.size() - num_kept;
+  const uint64_t added = table_build_entries.size() - num_kept;
+  if (removed + added >
+      std::max<uint64_t>(1, previous.hosts_.size() * MaxIncrementalRebuildChangePercent / 100)) {
+    return false;
+  }
+
+  // Start from the entries of the hosts which are in both tables.
+  std::vector<uint32_t> entries(table_size_);
+  for (uint64_t c = 0; c < table_size_; ++c) {
+    entries[c] = new_indices[previous.entries_[c]];
+    if (entries[c] != Unassigned) {
+      table_build_entries[entries[c]].count_++;
+    }
+  }
+
+  // Each host gets table_size_ / hosts entries, and table_size_ % hosts of them get one more, as
+  // in a full build. The extra entries go to the hosts which already have more, so that as few
+  // entries as possible move.
+  const uint64_t min_entries = table_size_ / table_build_entries.size();
+  uint64_t extra_entries = table_size_ % table_build_entries.size();
+  std::vector<uint64_t> targets(table_build_entries.size(), min_entries);
+  for (size_t i = 0; i < targets.size() && extra_entries > 0; ++i) {
+    if (table_build_entries[i].count_ > min_entries) {
+      targets[i]++;
+      extra_entries--;
+    }
+  }
+  for (size_t i = 0; i < targets.size() && extra_entries > 0; ++i) {
+    if (targets[i] == min_entries) {
+      targets[i]++;
+      extra_entries--;
+    }
+  }
+
+  // Release the entries of hosts above their target.
+  std::vector<bool> occupied(table_size_, false);
+  uint64_t unassigned = 0;
+  for (uint64_t c = 0; c < table_size_; ++c) {
+    if (entries[c] != Unassigned && table_build_entries[entries[c]].count_ > targets[entries[c]]) {
+      table_build_entries[entries[c]].count_--;
+      entries[c] = Unassigned;
+    }
+    if (entries[c] == Unassigned) {
+      unassigned++;
+    } else {
+      occupied[c] = true;
+    }
+  }
+
+  // The hosts below their target take turns to claim the next free entry of their permutation, as
+  // in a full build.
+  while (unassigned > 0) {
+    for (uint32_t i = 0; i < table_build_entries.size() && unassigned > 0; i++) {
+      TableBuildEntry& entry = table_build_entries[i];
+      if (entry.count_ >= targets[i]) {
+        continue;
+      }
+      uint64_t c = permutation(entry);
+      while (occupied[c]) {
+        entry.next_++;
+        c = permutation(entry);
+      }
+
+      entries[c] = i;
+      occupied[c] = true;
+
+      entry.next_++;
+      entry.count_++;
+      unassigned--;
+    }
+  }
+
+  for (uint64_t c = 0; c < table_size_; ++c) {
+    assign(c, entries[c]);
+  }
+  ENVOY_LOG(debug, "maglev: rebuilt table incrementally with {} hosts added and {} removed", added,
+            removed);
+  return true;
+}
+
+void OriginalMaglevTable::constructImplementationInternals(
+    std::vector<TableBuildEntry>& table_build_entries, double max_normalized_weight) {
+  // Size internal representation for maglev table correctly.
+  table_.resize(table_size_);
+
+  assignEntries(table_build_entries, max_normalized_weight,
+                [this, &table_build_entries](uint64_t table_index, uint32_t entry_index) {
+                  table_[table_index] = table_build_entries[entry_index].host_;
+                });
+}
+
 CompactMaglevTable::CompactMaglevTable(const NormalizedHostWeightVector& normalized_host_weights,
                                        double max_normalized_weight, uint64_t table_size,
                                        bool use_hostname_for_hashing,
-                                       MaglevLoadBalancerStats& stats)
+                                       MaglevLoadBalancerStats& stats,
+                                       const MaglevTable* previous,
+                                       MaglevParallelRunner* runner)
     : MaglevTable(table_size, stats),
       table_(absl::bit_width(normalized_host_weights.size()), table_size) {
   constructMaglevTableInternal(normalized_host_weights, max_normalized_weight,
-                               use_hostname_for_hashing);
+                               use_hostname_for_hashing, previous, runner);
 }
 
 void CompactMaglevTable::constructImplementationInternals(
@@ -190,40 +467,40 @@ void CompactMaglevTable::constructImplementationInternals(
   }
   host_table_.shrink_to_fit();
 
-  // Vector to track whether or not a given fixed width bit is set in the
-  // BitArray used as the maglev table.
-  std::vector<bool> occupied(table_size_, false);
-
-  // Iterate through the table build entries as many times as it takes to fill up the table.
-  uint64_t table_index = 0;
-  for (uint32_t iteration = 1; table_index < table_size_; ++iteration) {
-    for (uint32_t i = 0; i < table_build_entries.size() && table_index < table_size_; i++) {
-      TableBuildEntry& entry = table_build_entries[i];
-      // To understand how target_weight_ and weight_ are used below, consider a host with weight
-      // equal to max_normalized_weight. This would be picked on every single iteration. If it had
-      // weight equal to max_normalized_weight / 3, then it would only be picked every 3 iterations,
-      // etc.
-      if (iteration * entry.weight_ < entry.target_weight_) {
-        continue;
-      }
-      entry.target_weight_ += max_normalized_weight;
-      // As we're using the compact implementation, our table size is limited to
-      // 32-bit, hence static_cast here should be safe.
-      uint32_t c = static_cast<uint32_t>(permutation(entry));
-      while (occupied[c]) {
-        entry.next_++;
-        c = static_cast<uint32_t>(permutation(entry));
-      }
-
-      // Record the index of the given host.
-      table_.set(c, i);
-      occupied[c] = true;
+  assignEntries(table_build_entries, max_normalized_weight,
+                [this](uint64_t table_index, uint32_t entry_index) {
+                  table_.set(table_index, entry_index);
+                });
+}
 
-      entry.next_++;
-      entry.count_++;
-      table_index++;
+MaglevTable::Assignment OriginalMaglevTable::assignment() const {
+  Assignment assignment;
+  if (table_.empty()) {
+    return assignment;
+  }
+  absl::flat_hash_map<const Host*, uint32_t> indices;
+  assignment.entries_.reserve(table_.size());
+  for (const auto& host : table_) {
+    const auto [it, inserted] = indices.try_emplace(host.get(), assignment.hosts_.size());
+    if (inserted) {
+      assignment.hosts_.push_back(host);
     }
+    assignment.entries_.push_back(it->second);
   }
+  return assignment;
+}
+
+MaglevTable::Assignment CompactMaglevTable::assignment() const {
+  Assignment assignment;
+  if (host_table_.empty()) {
+    return assignment;
+  }
+  assignment.hosts_ = host_table_;
+  assignment.entries_.reserve(table_size_);
+  for (uint64_t i = 0; i < table_size_; ++i) {
+    assignment.entries_.push_back(table_.get(i));
+  }
+  return assignment;
 }
 
 void OriginalMaglevTable::logMaglevTable(bool use_hostname_for_hashing) const {
@@ -282,7 +559,13 @@ HostConstSharedPtr CompactMaglevTable::chooseHost(uint64_t hash, uint32_t attemp
   return host_table_[index];
 }
 
-uint64_t MaglevTable::permutation(const TableBuildEntry& entry) {
+HostConstSharedPtr MaglevTable::probeHost(uint64_t hash, uint32_t probe) const {
+  // Each probe looks up an entry of the table chosen by rehashing, so hosts are probed in
+  // proportion to their number of entries.
+  return chooseHost(HashUtil::xxHash64Value(hash, probe), 0);
+}
+
+uint64_t MaglevTable::permutation(const TableBuildEntry& entry) const {
   return (entry.offset_ + (entry.skip_ * entry.next_)) % table_size_;
 }
 
@@ -304,7 +587,10 @@ MaglevLoadBalancer::MaglevLoadBalancer(
               ? common_config.consistent_hashing_lb_config().use_hostname_for_hashing()
               : false),
       hash_balance_factor_(PROTOBUF_GET_WRAPPED_OR_DEFAULT(
-          common_config.consistent_hashing_lb_config(), hash_balance_factor, 0)) {
+          common_config.consistent_hashing_lb_config(), hash_balance_factor, 0)),
+      incremental_rebuild_(false),
+      parallel_build_(
+          Runtime::runtimeFeatureEnabled("envoy.reloadable_features.maglev_parallel_table_build")) {
   ENVOY_LOG(debug, "maglev table size: {}", table_size_);
   // The table size must be prime number.
   if (!Primes::isPrime(table_size_)) {
@@ -326,7 +612,10 @@ MaglevLoadBalancer::MaglevLoadBalancer(
               ? config.consistent_hashing_lb_config().use_hostname_for_hashing()
               : false),
       hash_balance_factor_(PROTOBUF_GET_WRAPPED_OR_DEFAULT(config.consistent_hashing_lb_config(),
-                                                           hash_balance_factor, 0)) {
+                                                           hash_balance_factor, 0)),
+      incremental_rebuild_(config.incremental_table_rebuild()),
+      parallel_build_(
+          Runtime::runtimeFeatureEnabled("envoy.reloadable_features.maglev_parallel_table_build")) {
   ENVOY_LOG(debug, "maglev table size: {}", table_size_);
   // The table size must be prime number.
   if (!Primes::isPrime(table_size_)) {
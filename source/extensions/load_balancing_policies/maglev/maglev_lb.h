@@ -7,11 +7,16 @@
 #include "envoy/extensions/load_balancing_policies/maglev/v3/maglev.pb.validate.h"
 #include "envoy/stats/scope.h"
 #include "envoy/stats/stats_macros.h"
+#include "envoy/thread/thread.h"
 #include "envoy/upstream/load_balancer.h"
 
 #include "source/common/common/bit_array.h"
+#include "source/common/common/non_copyable.h"
 #include "source/extensions/load_balancing_policies/common/thread_aware_lb_impl.h"
 
+#include "absl/functional/function_ref.h"
+#include "absl/synchronization/mutex.h"
+
 namespace Envoy {
 namespace Upstream {
 
@@ -64,6 +69,39 @@ struct MaglevLoadBalancerStats {
 class MaglevTable;
 using MaglevTableSharedPtr = std::shared_ptr<MaglevTable>;
 
+/**
+ * Runs a function on a fixed number of threads, the calling thread included, and waits for all of
+ * them to return. The threads are kept for the lifetime of the runner, so that each run only costs
+ * a wake up per thread. Runs from several threads are serialized.
+ */
+class MaglevParallelRunner : NonCopyable {
+public:
+  using ShardFunction = absl::FunctionRef<void(uint32_t shard, uint32_t shards)>;
+
+  // concurrency is the number of threads of a run, the calling thread included. It must be at
+  // least 2.
+  MaglevParallelRunner(Thread::ThreadFactory& thread_factory, uint32_t concurrency);
+  ~MaglevParallelRunner();
+
+  /**
+   * Calls fn(shard, shards) once for every shard in [0, shards), shard 0 on the calling thread.
+   */
+  void run(ShardFunction fn);
+
+private:
+  void worker(uint32_t shard);
+
+  const uint32_t concurrency_;
+  // Held for the whole of a run.
+  absl::Mutex run_mutex_;
+  absl::Mutex mutex_;
+  const ShardFunction* fn_ ABSL_GUARDED_BY(mutex_){};
+  uint64_t generation_ ABSL_GUARDED_BY(mutex_){};
+  size_t pending_ ABSL_GUARDED_BY(mutex_){};
+  bool terminate_ ABSL_GUARDED_BY(mutex_){};
+  std::vector<Thread::ThreadPtr> threads_;
+};
+
 /**
  * This is an implementation of Maglev consistent hashing as described in:
  * https://static.googleusercontent.com/media/research.google.com/en//pubs/archive/44824.pdf
@@ -76,9 +114,33 @@ public:
   MaglevTable(uint64_t table_size, MaglevLoadBalancerStats& stats);
   ~MaglevTable() override = default;
 
+  // ThreadAwareLoadBalancerBase::HashingLoadBalancer
+  HostConstSharedPtr probeHost(uint64_t hash, uint32_t probe) const override;
+
   // Recommended table size in section 5.3 of the paper.
   static constexpr uint64_t DefaultTableSize = 65537;
   static constexpr uint64_t MaxNumberOfHostsForCompactMaglev = (static_cast<uint64_t>(1) << 32) - 1;
+  // Below this number of hosts, the table is filled on the calling thread only, as the per
+  // iteration synchronization would cost more than it saves.
+  static constexpr uint64_t MinHostsForParallelBuild = 1024;
+  static constexpr uint32_t MaxParallelBuildThreads = 4;
+  // Largest number of added plus removed hosts, in percent of the number of hosts, for which a
+  // table is rebuilt incrementally from the previous one. At least one change is always allowed.
+  static constexpr uint64_t MaxIncrementalRebuildChangePercent = 5;
+
+  /**
+   * The assignment of the table's entries to its hosts.
+   */
+  struct Assignment {
+    std::vector<HostConstSharedPtr> hosts_;
+    // Index into hosts_ of the host of each entry of the table.
+    std::vector<uint32_t> entries_;
+  };
+
+  /**
+   * @return the current assignment of the table's entries, empty if the table has no hosts.
+   */
+  virtual Assignment assignment() const PURE;
 
 protected:
   struct TableBuildEntry {
@@ -94,13 +156,29 @@ protected:
     uint64_t count_{};
   };
 
-  uint64_t permutation(const TableBuildEntry& entry);
+  using AssignFunction = absl::FunctionRef<void(uint64_t table_index, uint32_t entry_index)>;
+
+  uint64_t permutation(const TableBuildEntry& entry) const;
 
   /**
    * Template method for constructing the Maglev table.
+   * @param previous if not null, the table built for the previous membership of the same host
+   *        set. If only a few hosts changed since, and all hosts have the same weight in both
+   *        tables, the previous assignment is repaired rather than recomputed, see
+   *        assignIncrementally().
+   * @param runner if not null, the runner on which the table may be filled, see assignAll().
    */
   void constructMaglevTableInternal(const NormalizedHostWeightVector& normalized_host_weights,
-                                    double max_normalized_weight, bool use_hostname_for_hashing);
+                                    double max_normalized_weight, bool use_hostname_for_hashing,
+                                    const MaglevTable* previous = nullptr,
+                                    MaglevParallelRunner* runner = nullptr);
+
+  /**
+   * Assigns every entry of the table to one of table_build_entries by calling assign once per
+   * table entry, and updates the count_ of table_build_entries.
+   */
+  void assignEntries(std::vector<TableBuildEntry>& table_build_entries,
+                     double max_normalized_weight, AssignFunction assign);
 
   const uint64_t table_size_;
   MaglevLoadBalancerStats& stats_;
@@ -108,11 +186,38 @@ protected:
 private:
   /**
    * Implementation specific construction of data structures to represent the
-   * Maglev Table.
+   * Maglev Table. Implementations call assignEntries() to fill them.
    */
   virtual void constructImplementationInternals(std::vector<TableBuildEntry>& table_build_entries,
                                                 double max_normalized_weight) PURE;
 
+  /**
+   * Implementation of pseudocode listing 1 in the paper (see header file for more info). If
+   * runner_ is set and there are enough hosts, the cursors of the hosts are advanced past the
+   * already occupied entries on several threads at the start of every iteration. This only skips
+   * entries the sequential pass would also skip, so the table is the same as the one built on a
+   * single thread.
+   */
+  void assignAll(std::vector<TableBuildEntry>& table_build_entries, double max_normalized_weight,
+                 AssignFunction assign);
+
+  /**
+   * Builds the table from previous_ by reassigning the entries of removed hosts, and moving as
+   * few entries as needed to give every host table_size_ / hosts entries, give or take one.
+   * The result balances load as well as a full build, but may differ from the table built from
+   * scratch for the same hosts.
+   * @return false, without assigning anything, if the table has to be built from scratch.
+   */
+  bool assignIncrementally(std::vector<TableBuildEntry>& table_build_entries,
+                           AssignFunction assign);
+
+  // Set during construction only.
+  const MaglevTable* previous_{};
+  bool use_hostname_for_hashing_{};
+  MaglevParallelRunner* runner_{};
+  // Whether all hosts have the same weight.
+  bool equal_weights_{};
+
   /**
    * Log each entry of the maglev table (useful for debugging).
    */
@@ -127,16 +232,21 @@ class OriginalMaglevTable : public MaglevTable {
 public:
   OriginalMaglevTable(const NormalizedHostWeightVector& normalized_host_weights,
                       double max_normalized_weight, uint64_t table_size,
-                      bool use_hostname_for_hashing, MaglevLoadBalancerStats& stats)
+                      bool use_hostname_for_hashing, MaglevLoadBalancerStats& stats,
+                      const MaglevTable* previous = nullptr,
+                      MaglevParallelRunner* runner = nullptr)
       : MaglevTable(table_size, stats) {
     constructMaglevTableInternal(normalized_host_weights, max_normalized_weight,
-                                 use_hostname_for_hashing);
+                                 use_hostname_for_hashing, previous, runner);
   }
   ~OriginalMaglevTable() override = default;
 
   // ThreadAwareLoadBalancerBase::HashingLoadBalancer
   HostConstSharedPtr chooseHost(uint64_t hash, uint32_t attempt) const override;
 
+  // MaglevTable
+  Assignment assignment() const override;
+
 private:
   void constructImplementationInternals(std::vector<TableBuildEntry>& table_build_entries,
                                         double max_normalized_weight) override;
@@ -155,12 +265,17 @@ class CompactMaglevTable : public MaglevTable {
 public:
   CompactMaglevTable(const NormalizedHostWeightVector& normalized_host_weights,
                      double max_normalized_weight, uint64_t table_size,
-                     bool use_hostname_for_hashing, MaglevLoadBalancerStats& stats);
+                     bool use_hostname_for_hashing, MaglevLoadBalancerStats& stats,
+                     const MaglevTable* previous = nullptr,
+                     MaglevParallelRunner* runner = nullptr);
   ~CompactMaglevTable() override = default;
 
   // ThreadAwareLoadBalancerBase::HashingLoadBalancer
   HostConstSharedPtr chooseHost(uint64_t hash, uint32_t attempt) const override;
 
+  // MaglevTable
+  Assignment assignment() const override;
+
 private:
   void constructImplementationInternals(std::vector<TableBuildEntry>& table_build_entries,
                                         double max_normalized_weight) override;
@@ -197,12 +312,22 @@ private:
   createLoadBalancer(const NormalizedHostWeightVector& normalized_host_weights,
                      double /* min_normalized_weight */, double max_normalized_weight) override;
   static MaglevLoadBalancerStats generateStats(Stats::Scope& scope);
+  // The runner of the parallel builds, or nullptr if the machine can't run more than one thread.
+  MaglevParallelRunner* parallelRunner();
 
   Stats::ScopeSharedPtr scope_;
   MaglevLoadBalancerStats stats_;
   const uint64_t table_size_;
   const bool use_hostname_for_hashing_;
   const uint32_t hash_balance_factor_;
+  const bool incremental_rebuild_;
+  const bool parallel_build_;
+  // The current table of each priority, which the next table of the priority is rebuilt from, if
+  // incremental_rebuild_ is set.
+  std::vector<MaglevTableSharedPtr> previous_tables_;
+  // Created on the first parallel build.
+  Thread::ThreadFactoryPtr thread_factory_;
+  std::unique_ptr<MaglevParallelRunner> parallel_runner_;
 };
 
 } // namespace Upstream
@@ -1,5 +1,6 @@
 #include "source/extensions/load_balancing_policies/ring_hash/ring_hash_lb.h"
 
+#include <algorithm>
 #include <cstdint>
 #include <iostream>
 #include <string>
@@ -9,7 +10,9 @@
 
 #include "source/common/common/assert.h"
 
+#include "absl/base/prefetch.h"
 #include "absl/container/inlined_vector.h"
+#include "absl/numeric/bits.h"
 #include "absl/strings/string_view.h"
 
 namespace Envoy {
@@ -90,52 +93,63 @@ RingHashLoadBalancerStats RingHashLoadBalancer::generateStats(Stats::Scope& scop
 }
 
 HostConstSharedPtr RingHashLoadBalancer::Ring::chooseHost(uint64_t h, uint32_t attempt) const {
-  if (ring_.empty()) {
+  if (hosts_.empty()) {
     return nullptr;
   }
 
-  // Ported from https://github.com/RJ/ketama/blob/master/libketama/ketama.c (ketama_get_server)
-  // I've generally kept the variable names to make the code easier to compare.
-  // NOTE: The algorithm depends on using signed integers for lowp, midp, and highp. Do not
-  //       change them!
-  int64_t lowp = 0;
-  int64_t highp = ring_.size();
-  int64_t midp = 0;
-  while (true) {
-    midp = (lowp + highp) / 2;
-
-    if (midp == static_cast<int64_t>(ring_.size())) {
-      midp = 0;
-      break;
-    }
+  uint64_t i = lowerBound(h);
 
-    uint64_t midval = ring_[midp].hash_;
-    uint64_t midval1 = midp == 0 ? 0 : ring_[midp - 1].hash_;
+  // If a retry host predicate is being applied, behave as if this host was not in the ring.
+  // Note that this does not guarantee a different host: e.g., attempt == ring size or
+  // when the offset causes us to select the same host at another location in the ring.
+  for (uint64_t step = attempt % (hashes_.size() - 1); step > 0; step--) {
+    i = next(i);
+  }
 
-    if (h <= midval && h > midval1) {
-      break;
-    }
+  return hosts_[host_indexes_->get(i)];
+}
 
-    if (midval < h) {
-      lowp = midp + 1;
-    } else {
-      highp = midp - 1;
+uint64_t RingHashLoadBalancer::Ring::lowerBound(uint64_t h) const {
+  // Descend the tree without branching on the comparisons, recording the turns taken in i.
+  const uint64_t size = hashes_.size();
+  uint64_t i = 1;
+  while (i < size) {
+    // The eight descendants of i three levels down are adjacent, 64 bytes which span at most two
+    // cache lines as the vector is not cache line aligned, so fetch both ends while descending.
+    if (i * 8 < size) {
+      absl::PrefetchToLocalCache(hashes_.data() + i * 8);
+      absl::PrefetchToLocalCache(hashes_.data() + std::min(i * 8 + 7, size - 1));
     }
+    i = 2 * i + (hashes_[i] < h);
+  }
+  // The lower bound is where the last left turn was taken: undo the right turns after it and then
+  // the left turn itself. If there was none, every hash is less than h, so wrap around.
+  i >>= absl::countr_one(i) + 1;
+  return i == 0 ? first_ : i;
+}
 
-    if (lowp > highp) {
-      midp = 0;
-      break;
+uint64_t RingHashLoadBalancer::Ring::next(uint64_t i) const {
+  const uint64_t size = hashes_.size();
+  // The next entry is the leftmost one in the right subtree, if any.
+  if (2 * i + 1 < size) {
+    i = 2 * i + 1;
+    while (2 * i < size) {
+      i = 2 * i;
     }
+    return i;
   }
-
-  // If a retry host predicate is being applied, behave as if this host was not in the ring.
-  // Note that this does not guarantee a different host: e.g., attempt == ring_.size() or
-  // when the offset causes us to select the same host at another location in the ring.
-  if (attempt > 0) {
-    midp = (midp + attempt) % ring_.size();
+  // Otherwise it is the closest ancestor whose left subtree holds i.
+  while (i & 1) {
+    i >>= 1;
   }
+  i >>= 1;
+  return i == 0 ? first_ : i;
+}
 
-  return ring_[midp].host_;
+HostConstSharedPtr RingHashLoadBalancer::Ring::probeHost(uint64_t hash, uint32_t probe) const {
+  // Each probe jumps to the point of the ring chosen by rehashing rather than to the next entry,
+  // so that a host's neighbours on the ring do not take all of its overflow.
+  return chooseHost(HashUtil::xxHash64Value(hash, probe), 0);
 }
 
 using HashFunction = envoy::config::cluster::v3::Cluster::RingHashLbConfig::HashFunction;
@@ -162,7 +176,9 @@ RingHashLoadBalancer::Ring::Ring(const NormalizedHostWeightVector& normalized_ho
 
   // Reserve memory for the entire ring up front.
   const uint64_t ring_size = std::ceil(scale);
-  ring_.reserve(ring_size);
+  std::vector<RingEntry> ring;
+  ring.reserve(ring_size);
+  hosts_.reserve(normalized_host_weights.size());
 
   // Populate the hash ring by walking through the (host, weight) pairs in
   // normalized_host_weights, and generating (scale * weight) hashes for each host. Since these
@@ -189,6 +205,8 @@ RingHashLoadBalancer::Ring::Ring(const NormalizedHostWeightVector& normalized_ho
   uint64_t max_hashes_per_host = 0;
   for (const auto& entry : normalized_host_weights) {
     const auto& host = entry.first;
+    const uint32_t host_index = hosts_.size();
+    hosts_.push_back(host);
     const absl::string_view key_to_hash = hashKey(host, use_hostname_for_hashing);
     ASSERT(!key_to_hash.empty());
 
@@ -213,7 +231,7 @@ RingHashLoadBalancer::Ring::Ring(const NormalizedHostWeightVector& normalized_ho
               : HashUtil::xxHash64(hash_key);
 
       ENVOY_LOG(trace, "ring hash: hash_key={} hash={}", hash_key, hash);
-      ring_.push_back({hash, host});
+      ring.push_back({hash, host_index});
       ++i;
       ++current_hashes;
       hash_key_buffer.erase(offset_start, hash_key_buffer.end());
@@ -222,16 +240,32 @@ RingHashLoadBalancer::Ring::Ring(const NormalizedHostWeightVector& normalized_ho
     max_hashes_per_host = std::max(i, max_hashes_per_host);
   }
 
-  std::sort(ring_.begin(), ring_.end(), [](const RingEntry& lhs, const RingEntry& rhs) -> bool {
+  std::sort(ring.begin(), ring.end(), [](const RingEntry& lhs, const RingEntry& rhs) -> bool {
     return lhs.hash_ < rhs.hash_;
   });
   if (ENVOY_LOG_CHECK_LEVEL(trace)) {
-    for (const auto& entry : ring_) {
-      const absl::string_view key_to_hash = hashKey(entry.host_, use_hostname_for_hashing);
+    for (const auto& entry : ring) {
+      const absl::string_view key_to_hash =
+          hashKey(hosts_[entry.host_index_], use_hostname_for_hashing);
       ENVOY_LOG(trace, "ring hash: host={} hash={}", key_to_hash, entry.hash_);
     }
   }
 
+  // Lay the sorted ring out in Eytzinger order, by walking the positions in order starting from
+  // the leftmost one.
+  hashes_.resize(ring.size() + 1);
+  host_indexes_ = std::make_unique<BitArray>(absl::bit_width(hosts_.size()), ring.size() + 1);
+  first_ = 1;
+  while (2 * first_ < hashes_.size()) {
+    first_ = 2 * first_;
+  }
+  uint64_t position = first_;
+  for (const auto& entry : ring) {
+    hashes_[position] = entry.hash_;
+    host_indexes_->set(position, entry.host_index_);
+    position = next(position);
+  }
+
   stats_.size_.set(ring_size);
   stats_.min_hashes_per_host_.set(min_hashes_per_host);
   stats_.max_hashes_per_host_.set(max_hashes_per_host);
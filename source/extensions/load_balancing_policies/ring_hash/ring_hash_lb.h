@@ -10,6 +10,7 @@
 #include "envoy/stats/stats_macros.h"
 #include "envoy/upstream/load_balancer.h"
 
+#include "source/common/common/bit_array.h"
 #include "source/common/common/logger.h"
 #include "source/extensions/load_balancing_policies/common/thread_aware_lb_impl.h"
 
@@ -91,7 +92,7 @@ private:
 
   struct RingEntry {
     uint64_t hash_;
-    HostConstSharedPtr host_;
+    uint32_t host_index_;
   };
 
   struct Ring : public HashingLoadBalancer {
@@ -101,8 +102,23 @@ private:
 
     // ThreadAwareLoadBalancerBase::HashingLoadBalancer
     HostConstSharedPtr chooseHost(uint64_t hash, uint32_t attempt) const override;
-
-    std::vector<RingEntry> ring_;
+    HostConstSharedPtr probeHost(uint64_t hash, uint32_t probe) const override;
+
+    // Returns the position of the first entry whose hash is not less than h, wrapping around to
+    // the first entry of the ring.
+    uint64_t lowerBound(uint64_t h) const;
+    // Returns the position of the entry after the one at position i, wrapping around.
+    uint64_t next(uint64_t i) const;
+
+    // The sorted ring is stored in Eytzinger order: the children of the entry at position i are
+    // at 2i and 2i+1, and position 0 is unused. The top of the tree stays in cache across lookups
+    // and the rest can be prefetched, unlike with a binary search over the sorted ring.
+    std::vector<uint64_t> hashes_;
+    // The index into hosts_ of each entry, in as few bits as the number of hosts needs.
+    std::unique_ptr<BitArray> host_indexes_;
+    std::vector<HostConstSharedPtr> hosts_;
+    // The position of the entry with the lowest hash.
+    uint64_t first_{};
 
     RingHashLoadBalancerStats& stats_;
   };
@@ -26,7 +26,9 @@
 
 #include "source/common/api/api_impl.h"
 #include "source/common/api/os_sys_calls_impl.h"
+#include "source/common/buffer/slice_pool.h"
 #include "source/common/common/enum_to_int.h"
+#include "source/common/common/matchers.h"
 #include "source/common/common/mutex_tracer_impl.h"
 #include "source/common/common/utility.h"
 #include "source/common/config/utility.h"
@@ -40,6 +42,7 @@
 #include "source/common/network/socket_interface.h"
 #include "source/common/network/socket_interface_impl.h"
 #include "source/common/protobuf/utility.h"
+#include "source/common/runtime/runtime_features.h"
 #include "source/common/runtime/runtime_impl.h"
 #include "source/common/runtime/runtime_keys.h"
 #include "source/common/signal/fatal_error_handler.h"
@@ -106,6 +109,8 @@ InstanceBase::InstanceBase(Init::Manager& init_manager, const Options& options,
 
 InstanceBase::~InstanceBase() {
   terminate();
+  // The matchers of the sharded stats may refer to the server.
+  stats_store_.setShardCount(0, nullptr);
 
   // Stop logging to file before all the AccessLogManager and its dependencies are
   // destructed to avoid crashing at shutdown.
@@ -276,6 +281,17 @@ void InstanceBase::updateServerStats() {
       enumToInt(Utility::serverState(initManager().state(), healthCheckFailed())));
   server_stats_->stats_recent_lookups_.set(
       stats_store_.symbolTable().getRecentLookups([](absl::string_view, uint64_t) {}));
+  if (Buffer::SlicePool::enabled()) {
+    // The pool keeps process wide totals; only add what changed since the last flush.
+    const Buffer::SlicePoolStats pool_stats = Buffer::SlicePool::stats();
+    server_stats_->buffer_slice_pool_hits_.add(pool_stats.hits_ -
+                                               server_stats_->buffer_slice_pool_hits_.value());
+    server_stats_->buffer_slice_pool_misses_.add(pool_stats.misses_ -
+                                                 server_stats_->buffer_slice_pool_misses_.value());
+    server_stats_->buffer_slice_pool_cross_thread_frees_.add(
+        pool_stats.cross_thread_frees_ -
+        server_stats_->buffer_slice_pool_cross_thread_frees_.value());
+  }
 }
 
 void InstanceBase::flushStatsInternal() {
@@ -706,6 +722,28 @@ absl::Status InstanceBase::initializeOrThrow(Network::Address::InstanceConstShar
   runtime_ = component_factory.createRuntime(*this, initial_config);
   validation_context_.setRuntime(runtime());
 
+  // Workers are not created yet, so it is safe to pick the slice allocation strategy here.
+  Buffer::SlicePool::setEnabled(
+      Runtime::runtimeFeatureEnabled("envoy.restart_features.buffer_slice_pool"));
+  // Likewise for the stats which are created from now on, e.g. the cluster stats. One slot per
+  // worker plus one for the main thread.
+  if (Runtime::runtimeFeatureEnabled("envoy.restart_features.sharded_stats") &&
+      bootstrap_.stats_config().has_sharded_stats()) {
+    auto matchers = std::make_shared<
+        std::vector<Matchers::StringMatcherImpl<envoy::type::matcher::v3::StringMatcher>>>();
+    for (const auto& pattern : bootstrap_.stats_config().sharded_stats().patterns()) {
+      matchers->emplace_back(pattern, server_contexts_);
+    }
+    stats_store_.setShardCount(options_.concurrency() + 1, [matchers](absl::string_view name) {
+      for (const auto& matcher : *matchers) {
+        if (matcher.match(name)) {
+          return true;
+        }
+      }
+      return false;
+    });
+  }
+
   if (!runtime().snapshot().getBoolean("envoy.disallow_global_stats", false)) {
     assert_action_registration_ = Assert::addDebugAssertionFailureRecordAction(
         [this](const char*) { server_stats_->debug_assertion_failures_.inc(); });
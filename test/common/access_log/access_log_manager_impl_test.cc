@@ -8,9 +8,12 @@
 #include "test/mocks/api/mocks.h"
 #include "test/mocks/event/mocks.h"
 #include "test/mocks/filesystem/mocks.h"
+#include "test/test_common/test_runtime.h"
 #include "test/test_common/test_time.h"
 #include "test/test_common/utility.h"
 
+#include "absl/strings/match.h"
+#include "absl/strings/str_split.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
@@ -526,6 +529,129 @@ TEST_F(AccessLogManagerImplTest, ReopenAllFiles) {
       .WillOnce(Return(ByMove(Filesystem::resultSuccess<bool>(true))));
 }
 
+
+TEST(AccessLogRingBufferTest, WrapAround) {
+  AccessLogRingBuffer buffer(16);
+  std::string output;
+
+  EXPECT_TRUE(buffer.write("0123456789"));
+  EXPECT_EQ(10, buffer.size());
+  EXPECT_EQ(10, buffer.drainTo(output));
+  EXPECT_EQ("0123456789", output);
+  EXPECT_EQ(0, buffer.size());
+
+  // Wraps around the end of the ring.
+  output.clear();
+  EXPECT_TRUE(buffer.write("abcdefghij"));
+  EXPECT_EQ(10, buffer.drainTo(output));
+  EXPECT_EQ("abcdefghij", output);
+
+  // A write which doesn't fit is rejected as a whole.
+  output.clear();
+  EXPECT_FALSE(buffer.write(std::string(17, 'x')));
+  EXPECT_TRUE(buffer.write(std::string(10, 'y')));
+  EXPECT_FALSE(buffer.write(std::string(7, 'z')));
+  EXPECT_TRUE(buffer.write(std::string(6, 'z')));
+  EXPECT_EQ(16, buffer.drainTo(output));
+  EXPECT_EQ(std::string(10, 'y') + std::string(6, 'z'), output);
+  EXPECT_EQ(0, buffer.drainTo(output));
+}
+
+TEST_F(AccessLogManagerImplTest, PerThreadBuffers) {
+  TestScopedRuntime scoped_runtime;
+  scoped_runtime.mergeValues({{"envoy.reloadable_features.access_log_per_thread_buffers", "true"}});
+  EXPECT_CALL(dispatcher_, createTimer_(_)).WillRepeatedly(ReturnNew<NiceMock<Event::MockTimer>>());
+
+  EXPECT_CALL(*file_, open_(_)).WillOnce(Return(ByMove(Filesystem::resultSuccess<bool>(true))));
+  AccessLogFileSharedPtr log_file =
+      access_log_manager_
+          .createAccessLog(Filesystem::FilePathAndType{Filesystem::DestinationType::File, "foo"})
+          .value();
+
+  absl::Mutex mutex;
+  std::string written;
+  EXPECT_CALL(*file_, write_(_))
+      .WillRepeatedly(Invoke([&](absl::string_view data) -> Api::IoCallSizeResult {
+        absl::MutexLock lock(&mutex);
+        absl::StrAppend(&written, data);
+        return Filesystem::resultSuccess<ssize_t>(static_cast<ssize_t>(data.length()));
+      }));
+
+  // Each thread writes to its own buffer.
+  log_file->write("main1\n");
+  Thread::ThreadPtr thread = thread_factory_.createThread([&log_file]() {
+    log_file->write("worker1\n");
+    log_file->write("worker2\n");
+  });
+  thread->join();
+  log_file->write("main2\n");
+
+  // A line which doesn't fit in the buffer is dropped.
+  log_file->write(std::string(AccessLogFileImpl::THREAD_BUFFER_SIZE + 1, 'x'));
+  EXPECT_EQ(1UL, store_.counter("filesystem.write_dropped").value());
+  EXPECT_EQ(4UL, store_.counter("filesystem.write_buffered").value());
+
+  // Everything written before the flush is on disk once it returns, with the lines of each thread
+  // in order.
+  log_file->flush();
+  {
+    absl::MutexLock lock(&mutex);
+    std::vector<absl::string_view> lines = absl::StrSplit(written, '\n', absl::SkipEmpty());
+    EXPECT_EQ(4, lines.size());
+    std::vector<absl::string_view> main_lines, worker_lines;
+    for (absl::string_view line : lines) {
+      (absl::StartsWith(line, "main") ? main_lines : worker_lines).push_back(line);
+    }
+    EXPECT_THAT(main_lines, testing::ElementsAre("main1", "main2"));
+    EXPECT_THAT(worker_lines, testing::ElementsAre("worker1", "worker2"));
+  }
+  EXPECT_TRUE(waitForGaugeEq("filesystem.write_total_buffered", 0));
+  EXPECT_EQ(0UL, store_.counter("filesystem.write_failed").value());
+
+  EXPECT_CALL(*file_, close_()).WillOnce(Return(ByMove(Filesystem::resultSuccess<bool>(true))));
+}
+
+// The buffer of a thread grows to fit lines larger than its initial capacity, keeping the lines
+// it already holds in order.
+TEST_F(AccessLogManagerImplTest, PerThreadBufferGrows) {
+  TestScopedRuntime scoped_runtime;
+  scoped_runtime.mergeValues({{"envoy.reloadable_features.access_log_per_thread_buffers", "true"}});
+  EXPECT_CALL(dispatcher_, createTimer_(_)).WillRepeatedly(ReturnNew<NiceMock<Event::MockTimer>>());
+
+  EXPECT_CALL(*file_, open_(_)).WillOnce(Return(ByMove(Filesystem::resultSuccess<bool>(true))));
+  AccessLogFileSharedPtr log_file =
+      access_log_manager_
+          .createAccessLog(Filesystem::FilePathAndType{Filesystem::DestinationType::File, "foo"})
+          .value();
+
+  absl::Mutex mutex;
+  std::string written;
+  EXPECT_CALL(*file_, write_(_))
+      .WillRepeatedly(Invoke([&](absl::string_view data) -> Api::IoCallSizeResult {
+        absl::MutexLock lock(&mutex);
+        absl::StrAppend(&written, data);
+        return Filesystem::resultSuccess<ssize_t>(static_cast<ssize_t>(data.length()));
+      }));
+
+  const std::string first(AccessLogFileImpl::INITIAL_THREAD_BUFFER_SIZE / 2, 'a');
+  const std::string second(AccessLogFileImpl::INITIAL_THREAD_BUFFER_SIZE, 'b');
+  const std::string third(AccessLogFileImpl::THREAD_BUFFER_SIZE / 2, 'c');
+  log_file->write(first);
+  log_file->write(second);
+  log_file->write(third);
+  EXPECT_EQ(0UL, store_.counter("filesystem.write_dropped").value());
+  EXPECT_EQ(3UL, store_.counter("filesystem.write_buffered").value());
+
+  log_file->flush();
+  {
+    absl::MutexLock lock(&mutex);
+    EXPECT_EQ(absl::StrCat(first, second, third), written);
+  }
+  EXPECT_TRUE(waitForGaugeEq("filesystem.write_total_buffered", 0));
+
+  EXPECT_CALL(*file_, close_()).WillOnce(Return(ByMove(Filesystem::resultSuccess<bool>(true))));
+}
+
 } // namespace
 } // namespace AccessLog
 } // namespace Envoy
@@ -2,10 +2,12 @@
 #include "envoy/http/stream_reset_handler.h"
 
 #include "source/common/buffer/buffer_impl.h"
+#include "source/common/buffer/slice_pool.h"
 #include "source/common/buffer/watermark_buffer.h"
 #include "source/common/common/assert.h"
 
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
 #include "benchmark/benchmark.h"
 
 namespace Envoy {
@@ -343,6 +345,72 @@ BENCHMARK(bufferReserveCommitPartial)
     ->Arg(64 * 1024)
     ->Arg(128 * 1024);
 
+// Test the read path of a worker from multiple threads at once: reserve a full read reservation,
+// commit it and drain the buffer, so that every iteration allocates and frees default sized slices
+// on the same thread. The first argument selects whether the per-thread slice pool is enabled.
+static void bufferReserveCommitDrainMultiThreaded(benchmark::State& state) {
+  Buffer::SlicePool::setEnabled(state.range(0) != 0);
+  Buffer::OwnedImpl buffer;
+  for (auto _ : state) {
+    UNREFERENCED_PARAMETER(_);
+    Buffer::Reservation reservation = buffer.reserveForRead();
+    reservation.commit(reservation.length());
+    buffer.drain(buffer.length());
+  }
+  benchmark::DoNotOptimize(buffer.length());
+  if (state.thread_index() == 0) {
+    const Buffer::SlicePoolStats stats = Buffer::SlicePool::stats();
+    state.counters["pool_hits"] = stats.hits_;
+    state.counters["pool_misses"] = stats.misses_;
+  }
+}
+BENCHMARK(bufferReserveCommitDrainMultiThreaded)
+    ->Arg(0)
+    ->Arg(1)
+    ->Threads(1)
+    ->Threads(4)
+    ->Threads(16)
+    ->UseRealTime();
+
+// Test slices which are allocated on one thread and freed on another, as happens when data read by
+// one worker is proxied by another. Each thread fills a buffer and hands it over to its neighbor
+// through a mailbox, then drains the buffer handed over to it. The first argument selects whether
+// the per-thread slice pool is enabled.
+static void bufferCrossThreadFree(benchmark::State& state) {
+  static constexpr int MaxThreads = 64;
+  struct Mailbox {
+    absl::Mutex mutex_;
+    Buffer::OwnedImpl buffer_ ABSL_GUARDED_BY(mutex_);
+  };
+  static Mailbox mailboxes[MaxThreads];
+
+  Buffer::SlicePool::setEnabled(state.range(0) != 0);
+  ASSERT(state.threads() <= MaxThreads);
+  const int self = state.thread_index();
+  const int neighbor = (self + 1) % state.threads();
+  for (auto _ : state) {
+    UNREFERENCED_PARAMETER(_);
+    Buffer::OwnedImpl buffer;
+    Buffer::Reservation reservation = buffer.reserveForRead();
+    reservation.commit(reservation.length());
+    {
+      absl::MutexLock lock(&mailboxes[neighbor].mutex_);
+      mailboxes[neighbor].buffer_.move(buffer);
+    }
+    Buffer::OwnedImpl received;
+    {
+      absl::MutexLock lock(&mailboxes[self].mutex_);
+      received.move(mailboxes[self].buffer_);
+    }
+    received.drain(received.length());
+  }
+  if (state.thread_index() == 0) {
+    const Buffer::SlicePoolStats stats = Buffer::SlicePool::stats();
+    state.counters["pool_cross_thread_frees"] = stats.cross_thread_frees_;
+  }
+}
+BENCHMARK(bufferCrossThreadFree)->Arg(0)->Arg(1)->Threads(2)->Threads(8)->UseRealTime();
+
 // Test the linearization of a buffer in the best case where the data is in one slice.
 static void bufferLinearizeSimple(benchmark::State& state) {
   const std::string data(state.range(0), 'a');
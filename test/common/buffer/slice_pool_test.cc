@@ -0,0 +1,113 @@
+#include "source/common/buffer/buffer_impl.h"
+#include "source/common/buffer/slice_pool.h"
+
+#include "test/test_common/thread_factory_for_test.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Buffer {
+namespace {
+
+class SlicePoolTest : public testing::Test {
+protected:
+  SlicePoolTest() { SlicePool::setEnabled(true); }
+  ~SlicePoolTest() override { SlicePool::setEnabled(false); }
+};
+
+TEST_F(SlicePoolTest, ReusesFreedBlocks) {
+  const SlicePoolStats before = SlicePool::stats();
+
+  uint8_t* first;
+  {
+    SliceStoragePtr storage = SlicePool::allocate();
+    first = storage.get();
+  }
+  SliceStoragePtr storage = SlicePool::allocate();
+  EXPECT_EQ(first, storage.get());
+
+  const SlicePoolStats after = SlicePool::stats();
+  EXPECT_EQ(before.hits_ + 1, after.hits_);
+  EXPECT_LE(before.misses_, after.misses_);
+  EXPECT_EQ(before.cross_thread_frees_, after.cross_thread_frees_);
+}
+
+TEST_F(SlicePoolTest, OnlyDefaultSizedSlicesArePooled) {
+  const SlicePoolStats before = SlicePool::stats();
+  { Slice::SizedStorage storage = Slice::newStorage(2 * Slice::default_slice_size_); }
+  const SlicePoolStats after = SlicePool::stats();
+  EXPECT_EQ(before.hits_, after.hits_);
+  EXPECT_EQ(before.misses_, after.misses_);
+}
+
+TEST_F(SlicePoolTest, ReadPathUsesPool) {
+  OwnedImpl buffer;
+  {
+    Reservation reservation = buffer.reserveForRead();
+    reservation.commit(reservation.length());
+  }
+  buffer.drain(buffer.length());
+
+  const SlicePoolStats before = SlicePool::stats();
+  {
+    Reservation reservation = buffer.reserveForRead();
+    reservation.commit(100);
+  }
+  const SlicePoolStats after = SlicePool::stats();
+  EXPECT_EQ(before.misses_, after.misses_);
+  EXPECT_EQ(before.hits_ + Reservation::MAX_SLICES_, after.hits_);
+  EXPECT_EQ(100, buffer.length());
+}
+
+TEST_F(SlicePoolTest, CrossThreadFreeReturnsToOwner) {
+  const SlicePoolStats before = SlicePool::stats();
+
+  OwnedImpl buffer;
+  buffer.add(std::string(Slice::default_slice_size_, 'a'));
+  uint8_t* block = static_cast<uint8_t*>(buffer.frontSlice().mem_);
+
+  Thread::threadFactoryForTest()
+      .createThread([&buffer]() { buffer.drain(buffer.length()); })
+      ->join();
+  EXPECT_EQ(before.cross_thread_frees_ + 1, SlicePool::stats().cross_thread_frees_);
+
+  // The block freed by the other thread is reclaimed by this thread once its free list runs dry.
+  std::vector<SliceStoragePtr> storages;
+  bool reused = false;
+  for (uint32_t i = 0; i <= SlicePool::MaxCachedBlocks && !reused; ++i) {
+    storages.push_back(SlicePool::allocate());
+    reused = storages.back().get() == block;
+  }
+  EXPECT_TRUE(reused);
+}
+
+TEST_F(SlicePoolTest, BlocksOutliveOwningThread) {
+  SliceStoragePtr storage;
+  Thread::threadFactoryForTest()
+      .createThread([&storage]() { storage = SlicePool::allocate(); })
+      ->join();
+  ASSERT_NE(nullptr, storage);
+  storage.get()[SlicePool::BlockSize - 1] = 1;
+  storage.reset();
+}
+
+// Holds a block until the thread exits. It is constructed before the thread's pool, so it is
+// destroyed after the pool's owner has exited.
+struct ExitingThreadHolder {
+  SliceStoragePtr storage_;
+};
+
+// The block must not go back onto the free list of the exited pool, which would leak it and trip
+// the assertion in SlicePool::destroy().
+TEST_F(SlicePoolTest, BlocksReleasedAfterOwnerExited) {
+  Thread::threadFactoryForTest()
+      .createThread([]() {
+        static thread_local ExitingThreadHolder holder;
+        holder.storage_ = SlicePool::allocate();
+      })
+      ->join();
+}
+
+} // namespace
+} // namespace Buffer
+} // namespace Envoy
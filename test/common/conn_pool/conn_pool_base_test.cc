@@ -1,7 +1,10 @@
+#include <cmath>
+
 #include "source/common/conn_pool/conn_pool_base.h"
 
 #include "test/common/upstream/utility.h"
 #include "test/mocks/event/mocks.h"
+#include "test/mocks/server/overload_manager.h"
 #include "test/mocks/upstream/cluster_info.h"
 #include "test/mocks/upstream/host.h"
 #include "test/test_common/simulated_time_system.h"
@@ -354,6 +357,164 @@ TEST_F(ConnPoolImplBaseTest, ExplicitPreconnectNotHealthy) {
   EXPECT_FALSE(pool_.maybePreconnectImpl(1));
 }
 
+TEST(AdaptivePreconnectEstimatorTest, NoPredictionWithoutConnectLatency) {
+  AdaptivePreconnectEstimator estimator({std::chrono::seconds(1), 16});
+  MonotonicTime now;
+  for (int i = 0; i < 100; ++i) {
+    now += std::chrono::milliseconds(10);
+    estimator.onStreamArrival(now);
+  }
+  EXPECT_GT(estimator.streamRate(now), 0);
+  EXPECT_EQ(0, estimator.anticipatedStreams(now));
+}
+
+TEST(AdaptivePreconnectEstimatorTest, PredictsArrivalsWithinConnectLatency) {
+  AdaptivePreconnectEstimator estimator({std::chrono::seconds(1), 16});
+  MonotonicTime now;
+  // 100 streams per second for 5 averaging windows.
+  for (int i = 0; i < 500; ++i) {
+    now += std::chrono::milliseconds(10);
+    estimator.onStreamArrival(now);
+  }
+  EXPECT_NEAR(100, estimator.streamRate(now), 1);
+
+  // 30ms of connection setup at 100 streams per second is 3 streams.
+  estimator.onConnectLatency(std::chrono::milliseconds(30));
+  EXPECT_EQ(3, estimator.anticipatedStreams(now));
+
+  // The prediction is capped.
+  estimator.onConnectLatency(std::chrono::milliseconds(10000));
+  EXPECT_EQ(16, estimator.anticipatedStreams(now));
+}
+
+TEST(AdaptivePreconnectEstimatorTest, ConnectLatencyIsAveraged) {
+  AdaptivePreconnectEstimator estimator({std::chrono::seconds(1), 1000});
+  MonotonicTime now;
+  for (int i = 0; i < 500; ++i) {
+    now += std::chrono::milliseconds(10);
+    estimator.onStreamArrival(now);
+  }
+  // The first sample is taken as is, later ones are weighted by 1/4: 0.25 * 20 + 0.75 * 100 = 80.
+  estimator.onConnectLatency(std::chrono::milliseconds(100));
+  EXPECT_EQ(10, estimator.anticipatedStreams(now));
+  estimator.onConnectLatency(std::chrono::milliseconds(20));
+  EXPECT_EQ(8, estimator.anticipatedStreams(now));
+}
+
+TEST(AdaptivePreconnectEstimatorTest, StreamRateDecaysWhenIdle) {
+  AdaptivePreconnectEstimator estimator({std::chrono::seconds(1), 16});
+  MonotonicTime now;
+  for (int i = 0; i < 500; ++i) {
+    now += std::chrono::milliseconds(10);
+    estimator.onStreamArrival(now);
+  }
+  estimator.onConnectLatency(std::chrono::milliseconds(30));
+  EXPECT_EQ(3, estimator.anticipatedStreams(now));
+
+  // After one averaging window the rate has decayed by a factor of e.
+  now += std::chrono::seconds(1);
+  EXPECT_NEAR(100 * std::exp(-1), estimator.streamRate(now), 1);
+  EXPECT_EQ(1, estimator.anticipatedStreams(now));
+
+  now += std::chrono::seconds(5);
+  EXPECT_EQ(0, estimator.anticipatedStreams(now));
+}
+
+class ConnPoolImplAdaptivePreconnectTest : public testing::Test {
+public:
+  ConnPoolImplAdaptivePreconnectTest()
+      : upstream_ready_cb_(new NiceMock<Event::MockSchedulableCallback>(&dispatcher_)),
+        pool_(host_, Upstream::ResourcePriority::Default, dispatcher_, nullptr, nullptr, state_) {
+    cluster_->resetResourceManager(1024, 1024, 1024, 1, 1);
+    ON_CALL(pool_, instantiateActiveClient).WillByDefault(Invoke([&]() -> ActiveClientPtr {
+      auto ret = std::make_unique<NiceMock<TestActiveClient>>(pool_, 100, concurrent_streams_,
+                                                              /*supports_early_data=*/false);
+      clients_.push_back(ret.get());
+      ret->real_host_description_ = descr_;
+      return ret;
+    }));
+    ON_CALL(pool_, onPoolReady(_, _))
+        .WillByDefault(Invoke([](ActiveClient& client, AttachContext&) {
+          TestActiveClient::incrementActiveStreams(client);
+        }));
+    state_.adaptive_preconnect_load_shed_point_ = &load_shed_point_;
+  }
+
+  static std::shared_ptr<Upstream::MockClusterInfo> adaptivePreconnectCluster() {
+    auto cluster = std::make_shared<NiceMock<Upstream::MockClusterInfo>>();
+    cluster->adaptive_preconnect_ = Upstream::AdaptivePreconnectConfig{std::chrono::seconds(1), 4};
+    return cluster;
+  }
+
+  // Creates a stream on a connection which took a second to connect, so the pool has a connection
+  // setup latency to predict arrivals with.
+  void connectFirstStream() {
+    EXPECT_CALL(pool_, instantiateActiveClient);
+    pool_.newStreamImpl(context_, /*can_send_early_data=*/false);
+    CHECK_STATE(0 /*active*/, 1 /*pending*/, concurrent_streams_ /*connecting capacity*/);
+
+    time_system_.advanceTimeWait(std::chrono::seconds(1));
+    EXPECT_CALL(pool_, onPoolReady);
+    clients_.back()->onEvent(Network::ConnectionEvent::Connected);
+    CHECK_STATE(1 /*active*/, 0 /*pending*/, concurrent_streams_ - 1 /*connecting capacity*/);
+  }
+
+  Event::SimulatedTimeSystemHelper time_system_;
+  Upstream::ClusterConnectivityState state_;
+  NiceMock<Server::MockLoadShedPoint> load_shed_point_;
+  std::shared_ptr<NiceMock<Upstream::MockHostDescription>> descr_{
+      new NiceMock<Upstream::MockHostDescription>()};
+  std::shared_ptr<Upstream::MockClusterInfo> cluster_{adaptivePreconnectCluster()};
+  NiceMock<Event::MockDispatcher> dispatcher_;
+  NiceMock<Event::MockSchedulableCallback>* upstream_ready_cb_;
+  Upstream::HostSharedPtr host_{
+      Upstream::makeTestHost(cluster_, "tcp://127.0.0.1:80", dispatcher_.timeSource())};
+  TestConnPoolImplBase pool_;
+  AttachContext context_;
+  std::vector<TestActiveClient*> clients_;
+  uint32_t concurrent_streams_{1};
+};
+
+TEST_F(ConnPoolImplAdaptivePreconnectTest, PreconnectsForPredictedArrivals) {
+  connectFirstStream();
+
+  // The arrival rate is now 1 + 1/e streams per second, so one more stream is expected to arrive
+  // while a connection is established and the pool connects for it as well as the pending one.
+  EXPECT_CALL(pool_, instantiateActiveClient).Times(2);
+  pool_.newStreamImpl(context_, /*can_send_early_data=*/false);
+  CHECK_STATE(1 /*active*/, 1 /*pending*/, 2 /*connecting capacity*/);
+
+  EXPECT_CALL(pool_, onPoolFailure);
+  pool_.destructAllConnections();
+}
+
+// The idle capacity of the connected client covers the predicted arrival, so no connection is made.
+TEST_F(ConnPoolImplAdaptivePreconnectTest, NoPreconnectWithReadyCapacity) {
+  concurrent_streams_ = 4;
+  connectFirstStream();
+
+  // One more stream is expected to arrive while a connection is established, as above, and after
+  // this one the connected client can still take two streams.
+  EXPECT_CALL(pool_, instantiateActiveClient).Times(0);
+  EXPECT_CALL(pool_, onPoolReady);
+  pool_.newStreamImpl(context_, /*can_send_early_data=*/false);
+  CHECK_STATE(2 /*active*/, 0 /*pending*/, 2 /*connecting capacity*/);
+
+  pool_.destructAllConnections();
+}
+
+TEST_F(ConnPoolImplAdaptivePreconnectTest, NoPreconnectWhileShedding) {
+  connectFirstStream();
+
+  EXPECT_CALL(load_shed_point_, shouldShedLoad()).WillRepeatedly(Return(true));
+  EXPECT_CALL(pool_, instantiateActiveClient);
+  pool_.newStreamImpl(context_, /*can_send_early_data=*/false);
+  CHECK_STATE(1 /*active*/, 1 /*pending*/, 1 /*connecting capacity*/);
+
+  EXPECT_CALL(pool_, onPoolFailure);
+  pool_.destructAllConnections();
+}
+
 TEST_F(ConnPoolImplDispatcherBaseTest, MaxConnectionDurationTimerNull) {
   // Force a null max connection duration optional.
   // newActiveClientAndStream() will expect the connection duration timer to remain null.
@@ -0,0 +1,174 @@
+#include <limits>
+#include <string>
+
+#include "source/common/formatter/compiled_formatter.h"
+#include "source/common/formatter/substitution_formatter.h"
+#include "source/common/http/header_map_impl.h"
+
+#include "test/mocks/stream_info/mocks.h"
+#include "test/test_common/utility.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::NiceMock;
+
+namespace Envoy {
+namespace Formatter {
+namespace {
+
+class CompiledFormatterTest : public testing::Test {
+protected:
+  CompiledFormatterTest()
+      : request_headers_{{":method", "GET"},
+                         {":path", "/path?query=1"},
+                         {"user-agent", "agent \"quoted\"\\\n"},
+                         {"x-number", "42"}},
+        response_headers_{{":status", "200"}},
+        context_(&request_headers_, &response_headers_, &response_trailers_, body_) {
+    stream_info_.protocol_ = Http::Protocol::Http11;
+    stream_info_.response_code_ = 200;
+  }
+
+  void expectTextEqual(absl::string_view format, bool omit_empty_values) {
+    FormatterImpl expected(format, omit_empty_values);
+    CompiledFormatterImpl actual(format, omit_empty_values);
+    EXPECT_EQ(expected.formatWithContext(context_, stream_info_),
+              actual.formatWithContext(context_, stream_info_));
+  }
+
+  void expectJsonEqual(const std::string& yaml, bool preserve_types, bool omit_empty_values) {
+    ProtobufWkt::Struct format;
+    TestUtility::loadFromYaml(yaml, format);
+    JsonFormatterImpl expected(format, preserve_types, omit_empty_values, false);
+    CompiledJsonFormatterImpl actual(format, preserve_types, omit_empty_values);
+    const std::string expected_json = expected.formatWithContext(context_, stream_info_);
+    const std::string actual_json = actual.formatWithContext(context_, stream_info_);
+    EXPECT_TRUE(TestUtility::jsonStringEqual(actual_json, expected_json))
+        << "expected: " << expected_json << "actual: " << actual_json;
+    EXPECT_EQ('\n', actual_json.back());
+  }
+
+  Http::TestRequestHeaderMapImpl request_headers_;
+  Http::TestResponseHeaderMapImpl response_headers_;
+  Http::TestResponseTrailerMapImpl response_trailers_;
+  std::string body_;
+  NiceMock<StreamInfo::MockStreamInfo> stream_info_;
+  HttpFormatterContext context_;
+};
+
+TEST_F(CompiledFormatterTest, Text) {
+  for (const bool omit_empty_values : {false, true}) {
+    expectTextEqual("", omit_empty_values);
+    expectTextEqual("plain text", omit_empty_values);
+    expectTextEqual("[%REQ(:METHOD)% %REQ(:PATH)% %PROTOCOL%] %RESPONSE_CODE% "
+                    "\"%REQ(USER-AGENT)%\" \"%REQ(X-MISSING)%\" 100%%\n",
+                    omit_empty_values);
+    expectTextEqual("%REQ(:PATH):5%%RESP(:STATUS)%", omit_empty_values);
+  }
+}
+
+TEST_F(CompiledFormatterTest, Json) {
+  const std::string format = R"EOF(
+    method: '%REQ(:METHOD)%'
+    path: 'prefix %REQ(:PATH)% "suffix"'
+    protocol: '%PROTOCOL%'
+    response_code: '%RESPONSE_CODE%'
+    user_agent: '%REQ(USER-AGENT)%'
+    missing: '%REQ(X-MISSING)%'
+    missing_in_string: 'a %REQ(X-MISSING)% b'
+    number: '%REQ(X-NUMBER)%'
+    constant: 'a constant "value"'
+    constant_number: 3.5
+    nested:
+      method: '%REQ(:METHOD)%'
+      empty:
+        missing: '%REQ(X-MISSING)%'
+    list:
+    - '%REQ(:METHOD)%'
+    - '%REQ(X-MISSING)%'
+    - 1
+    - nested_in_list: '%RESPONSE_CODE%'
+  )EOF";
+  for (const bool preserve_types : {false, true}) {
+    for (const bool omit_empty_values : {false, true}) {
+      SCOPED_TRACE(absl::StrCat("preserve_types=", preserve_types,
+                                " omit_empty_values=", omit_empty_values));
+      expectJsonEqual(format, preserve_types, omit_empty_values);
+    }
+  }
+}
+
+TEST_F(CompiledFormatterTest, JsonAllOmitted) {
+  const std::string format = R"EOF(
+    missing: '%REQ(X-MISSING)%'
+    nested:
+      missing: '%REQ(X-MISSING)%'
+  )EOF";
+  expectJsonEqual(format, false, true);
+  expectJsonEqual(format, true, true);
+
+  ProtobufWkt::Struct key_mapping;
+  TestUtility::loadFromYaml(format, key_mapping);
+  CompiledJsonFormatterImpl formatter(key_mapping, false, true);
+  EXPECT_EQ("{}\n", formatter.formatWithContext(context_, stream_info_));
+}
+
+// The properties are sorted and the output is built without any whitespace.
+TEST_F(CompiledFormatterTest, JsonLayout) {
+  ProtobufWkt::Struct key_mapping;
+  TestUtility::loadFromYaml(R"EOF(
+    z: '%RESPONSE_CODE%'
+    a: '%REQ(:METHOD)%'
+    m:
+    - 1
+    - '%REQ(X-MISSING)%'
+    - '%REQ(:METHOD)%'
+  )EOF",
+                            key_mapping);
+  CompiledJsonFormatterImpl typed(key_mapping, true, true);
+  EXPECT_EQ(R"({"a":"GET","m":[1,"GET"],"z":200})"
+            "\n",
+            typed.formatWithContext(context_, stream_info_));
+
+  CompiledJsonFormatterImpl untyped(key_mapping, false, false);
+  EXPECT_EQ(R"({"a":"GET","m":["1","-","GET"],"z":"200"})"
+            "\n",
+            untyped.formatWithContext(context_, stream_info_));
+}
+
+// Invalid utf-8 is replaced, like the sorted JSON serializer of JsonFormatterImpl does.
+TEST_F(CompiledFormatterTest, JsonInvalidUtf8) {
+  request_headers_.addCopy("x-invalid", "a\xc3"
+                                        "b\xff");
+  ProtobufWkt::Struct key_mapping;
+  TestUtility::loadFromYaml("invalid: '%REQ(X-INVALID)%'", key_mapping);
+  CompiledJsonFormatterImpl formatter(key_mapping, false, false);
+  EXPECT_EQ("{\"invalid\":\"a\xef\xbf\xbd"
+            "b\xef\xbf\xbd\"}\n",
+            formatter.formatWithContext(context_, stream_info_));
+}
+
+TEST_F(CompiledFormatterTest, JsonValue) {
+  auto render = [](const ProtobufWkt::Value& value) {
+    std::string output;
+    CompiledFormatterUtil::appendJsonValue(output, value);
+    return output;
+  };
+  EXPECT_EQ("null", render(ValueUtil::nullValue()));
+  EXPECT_EQ("true", render(ValueUtil::boolValue(true)));
+  EXPECT_EQ("200", render(ValueUtil::numberValue(200)));
+  EXPECT_EQ("0.5", render(ValueUtil::numberValue(0.5)));
+  EXPECT_EQ("null", render(ValueUtil::numberValue(std::numeric_limits<double>::infinity())));
+  EXPECT_EQ(R"("a\"b")", render(ValueUtil::stringValue("a\"b")));
+
+  ProtobufWkt::Struct nested;
+  (*nested.mutable_fields())["b"] = ValueUtil::numberValue(2);
+  (*nested.mutable_fields())["a"] =
+      ValueUtil::listValue({ValueUtil::stringValue("x"), ValueUtil::nullValue()});
+  EXPECT_EQ(R"({"a":["x",null],"b":2})", render(ValueUtil::structValue(nested)));
+}
+
+} // namespace
+} // namespace Formatter
+} // namespace Envoy
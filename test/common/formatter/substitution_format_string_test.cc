@@ -1,5 +1,6 @@
 #include "envoy/config/core/v3/substitution_format_string.pb.validate.h"
 
+#include "source/common/formatter/compiled_formatter.h"
 #include "source/common/formatter/substitution_format_string.h"
 
 #include "test/common/formatter/command_extension.h"
@@ -7,6 +8,7 @@
 #include "test/mocks/server/factory_context.h"
 #include "test/mocks/stream_info/mocks.h"
 #include "test/test_common/registry.h"
+#include "test/test_common/test_runtime.h"
 #include "test/test_common/utility.h"
 
 #include "gmock/gmock.h"
@@ -77,6 +79,27 @@ TEST_F(SubstitutionFormatStringUtilsTest, TestFromProtoConfigJson) {
   EXPECT_TRUE(TestUtility::jsonStringEqual(out_json, expected));
 }
 
+// The compiled JSON formatter is only used for the formats whose properties are sorted.
+TEST_F(SubstitutionFormatStringUtilsTest, TestCompiledJsonFormatterSortsProperties) {
+  TestScopedRuntime scoped_runtime;
+  scoped_runtime.mergeValues({{"envoy.reloadable_features.compiled_access_log_formatter", "true"}});
+  const std::string yaml = R"EOF(
+  json_format:
+    path: "%REQ(:path)%"
+    code: "%RESPONSE_CODE%"
+)EOF";
+  TestUtility::loadFromYaml(yaml, config_);
+
+  auto unsorted = SubstitutionFormatStringUtils::fromProtoConfig(config_, context_);
+  EXPECT_NE(nullptr, dynamic_cast<JsonFormatterImpl*>(unsorted.get()));
+
+  config_.mutable_json_format_options()->set_sort_properties(true);
+  auto sorted = SubstitutionFormatStringUtils::fromProtoConfig(config_, context_);
+  EXPECT_NE(nullptr, dynamic_cast<CompiledJsonFormatterImpl*>(sorted.get()));
+  EXPECT_EQ("{\"code\":200,\"path\":\"/bar/foo\"}\n",
+            sorted->formatWithContext(formatter_context_, stream_info_));
+}
+
 TEST_F(SubstitutionFormatStringUtilsTest, TestInvalidConfigs) {
   const std::vector<std::string> invalid_configs = {
       R"(
@@ -4993,6 +4993,21 @@ TEST_P(Http1ServerConnectionImplTest, ValueEndsWithNullCharacter) {
   }
 }
 
+TEST_P(Http1ServerConnectionImplTest, ValueWithNullCharacterVectorizedValidation) {
+  TestScopedRuntime scoped_runtime;
+  scoped_runtime.mergeValues(
+      {{"envoy.reloadable_features.http1_vectorized_header_validation", "true"}});
+  // Long enough to have the null character in a vectorized block rather than the scalar tail.
+  const std::string value = absl::StrCat(std::string(20, 'a'), kNullCharacter, "value");
+
+  if (parser_impl_ == Http1ParserImpl::BalsaParser) {
+    testRequestWithValueExpectFailure(value, "http1.invalid_characters",
+                                      "header value contains invalid chars");
+  } else {
+    testRequestWithValueExpectFailure(value, "http1.codec_error", "HPE_INVALID_HEADER_TOKEN");
+  }
+}
+
 TEST_P(Http1ServerConnectionImplTest, ValueStartsWithCR) {
   const absl::string_view value = "\r value starts with carriage return";
 
@@ -0,0 +1,113 @@
+#include <string>
+
+#include "envoy/config/core/v3/protocol.pb.h"
+
+#include "source/common/buffer/buffer_impl.h"
+#include "source/common/http/http1/codec_impl.h"
+#include "source/common/http/http1/header_scanner.h"
+
+#include "test/common/stats/stat_test_utility.h"
+#include "test/mocks/http/mocks.h"
+#include "test/mocks/network/mocks.h"
+#include "test/mocks/server/overload_manager.h"
+#include "test/test_common/test_runtime.h"
+
+#include "absl/strings/str_cat.h"
+#include "benchmark/benchmark.h"
+
+namespace Envoy {
+namespace Http {
+namespace {
+
+using testing::NiceMock;
+using testing::ReturnRef;
+
+enum class HeaderSet { Typical, ManySmall, LongValues };
+
+std::string requestForHeaderSet(HeaderSet header_set) {
+  std::string request = "GET /api/v1/items?page=2 HTTP/1.1\r\nhost: www.example.com\r\n";
+  switch (header_set) {
+  case HeaderSet::Typical:
+    absl::StrAppend(
+        &request,
+        "user-agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko) "
+        "Chrome/124.0.0.0 Safari/537.36\r\n",
+        "accept: text/html,application/xhtml+xml,application/xml;q=0.9,image/avif,image/webp,"
+        "*/*;q=0.8\r\n",
+        "accept-language: en-US,en;q=0.9\r\n", "accept-encoding: gzip, deflate, br\r\n",
+        "connection: keep-alive\r\n", "cache-control: max-age=0\r\n",
+        "upgrade-insecure-requests: 1\r\n", "sec-fetch-dest: document\r\n",
+        "sec-fetch-mode: navigate\r\n", "sec-fetch-site: none\r\n",
+        "x-request-id: 5f2b8d3e-6c1a-4b7e-9d2f-0a1b2c3d4e5f\r\n",
+        "cookie: session=0123456789abcdef0123456789abcdef; theme=dark; lang=en\r\n");
+    break;
+  case HeaderSet::ManySmall:
+    // Just below the default limit of 100 headers.
+    for (int i = 0; i < 95; ++i) {
+      absl::StrAppend(&request, "x-h", i, ": v", i, "\r\n");
+    }
+    break;
+  case HeaderSet::LongValues:
+    for (int i = 0; i < 8; ++i) {
+      absl::StrAppend(&request, "cookie-", i, ": ", std::string(4096, 'a' + i), "\r\n");
+    }
+    break;
+  }
+  absl::StrAppend(&request, "\r\n");
+  return request;
+}
+
+// Measure the cost of dispatching a request header block through the server codec. Arguments are
+// the parser (0: http-parser, 1: balsa), the header set (see HeaderSet) and whether header values
+// are validated with the vectorized HeaderScanner (0: scalar, 1: vectorized).
+static void bmDispatchRequestHeaders(benchmark::State& state) {
+  TestScopedRuntime scoped_runtime;
+  scoped_runtime.mergeValues({{"envoy.reloadable_features.http1_vectorized_header_validation",
+                               state.range(2) != 0 ? "true" : "false"}});
+
+  Stats::TestUtil::TestStore store;
+  Http1::CodecStats::AtomicPtr codec_stats_ptr;
+  Http1::CodecStats& codec_stats = Http1::CodecStats::atomicGet(codec_stats_ptr, *store.rootScope());
+  NiceMock<Network::MockConnection> connection;
+  NiceMock<MockServerConnectionCallbacks> callbacks;
+  NiceMock<MockRequestDecoder> decoder;
+  NiceMock<Server::MockOverloadManager> overload_manager;
+  ON_CALL(callbacks, newStream(testing::_, testing::_)).WillByDefault(ReturnRef(decoder));
+
+  Http1Settings settings;
+  settings.use_balsa_parser_ = state.range(0) != 0;
+  const std::string request = requestForHeaderSet(static_cast<HeaderSet>(state.range(1)));
+
+  for (auto _ : state) { // NOLINT
+    Http1::ServerConnectionImpl codec(
+        connection, codec_stats, callbacks, settings, Http::DEFAULT_MAX_REQUEST_HEADERS_KB,
+        Http::DEFAULT_MAX_HEADERS_COUNT, envoy::config::core::v3::HttpProtocolOptions::ALLOW,
+        overload_manager);
+    Buffer::OwnedImpl buffer(request);
+    const Status status = codec.dispatch(buffer);
+    RELEASE_ASSERT(status.ok(), status.ToString());
+  }
+  state.SetBytesProcessed(state.iterations() * request.size());
+}
+BENCHMARK(bmDispatchRequestHeaders)
+    ->ArgsProduct({{0, 1},
+                   {static_cast<int>(HeaderSet::Typical), static_cast<int>(HeaderSet::ManySmall),
+                    static_cast<int>(HeaderSet::LongValues)},
+                   {0, 1}});
+
+// Measure header value validation alone, scalar versus vectorized, for a range of value lengths.
+static void bmHeaderValueValidation(benchmark::State& state) {
+  const std::string value(state.range(0), 'v');
+  const bool vectorized = state.range(1) != 0;
+  for (auto _ : state) { // NOLINT
+    const bool valid = vectorized ? Http1::HeaderScanner::headerValueIsValid(value)
+                                  : HeaderUtility::headerValueIsValid(value);
+    benchmark::DoNotOptimize(valid);
+  }
+  state.SetBytesProcessed(state.iterations() * value.size());
+}
+BENCHMARK(bmHeaderValueValidation)->ArgsProduct({{8, 32, 128, 1024, 8192}, {0, 1}});
+
+} // namespace
+} // namespace Http
+} // namespace Envoy
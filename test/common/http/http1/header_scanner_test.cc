@@ -0,0 +1,47 @@
+#include <string>
+
+#include "source/common/http/header_utility.h"
+#include "source/common/http/http1/header_scanner.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Http {
+namespace Http1 {
+namespace {
+
+// Every byte value at every position of the vectorized blocks and the scalar tail must be
+// classified exactly like the scalar header value validator does.
+TEST(HeaderScannerTest, MatchesScalarValidator) {
+  for (size_t length : {1, 15, 16, 17, 31, 32, 33, 64}) {
+    for (size_t position = 0; position < length; ++position) {
+      for (int c = 0; c < 256; ++c) {
+        std::string value(length, 'a');
+        value[position] = static_cast<char>(c);
+        const bool valid = HeaderUtility::headerValueIsValid(value);
+        ASSERT_EQ(valid, HeaderScanner::headerValueIsValid(value))
+            << "length " << length << " position " << position << " char " << c;
+        ASSERT_EQ(valid ? absl::string_view::npos : position,
+                  HeaderScanner::findInvalidHeaderValueChar(value));
+        ASSERT_EQ(HeaderScanner::findInvalidHeaderValueCharScalar(value),
+                  HeaderScanner::findInvalidHeaderValueChar(value));
+      }
+    }
+  }
+}
+
+TEST(HeaderScannerTest, ReportsFirstInvalidChar) {
+  EXPECT_TRUE(HeaderScanner::headerValueIsValid(""));
+  EXPECT_TRUE(HeaderScanner::headerValueIsValid("text/html; charset=utf-8\t\x80\xff"));
+  std::string value(40, 'x');
+  value[20] = '\r';
+  value[35] = '\n';
+  EXPECT_EQ(20, HeaderScanner::findInvalidHeaderValueChar(value));
+  value[3] = '\0';
+  EXPECT_EQ(3, HeaderScanner::findInvalidHeaderValueChar(value));
+}
+
+} // namespace
+} // namespace Http1
+} // namespace Http
+} // namespace Envoy
@@ -0,0 +1,376 @@
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "source/common/buffer/buffer_impl.h"
+#include "source/common/http/http2/shared_conn_pool.h"
+
+#include "test/common/http/common.h"
+#include "test/mocks/common.h"
+#include "test/mocks/event/mocks.h"
+#include "test/mocks/http/conn_pool.h"
+#include "test/mocks/http/mocks.h"
+#include "test/mocks/http/stream_decoder.h"
+#include "test/mocks/http/stream_encoder.h"
+#include "test/mocks/stream_info/mocks.h"
+#include "test/mocks/upstream/host.h"
+#include "test/test_common/utility.h"
+
+#include "absl/container/flat_hash_set.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::_;
+using testing::Invoke;
+using testing::NiceMock;
+using testing::Return;
+
+namespace Envoy {
+namespace Http {
+namespace Http2 {
+namespace {
+
+class SharedConnPoolWorkersTest : public testing::Test {
+public:
+  SharedConnPoolWorkersTest() {
+    for (int i = 0; i < 4; i++) {
+      dispatchers_.push_back(
+          std::make_unique<NiceMock<Event::MockDispatcher>>(absl::StrCat("worker_", i)));
+    }
+  }
+
+  NiceMock<Upstream::MockHostDescription> host_;
+  std::vector<std::unique_ptr<NiceMock<Event::MockDispatcher>>> dispatchers_;
+  SharedConnPoolWorkers workers_{4};
+};
+
+TEST_F(SharedConnPoolWorkersTest, NoOwnersUntilAllWorkersRun) {
+  workers_.addWorker(*dispatchers_[0]);
+  workers_.addWorker(*dispatchers_[1]);
+  workers_.addWorker(*dispatchers_[2]);
+  for (auto& dispatcher : dispatchers_) {
+    EXPECT_EQ(nullptr, workers_.ownerFor(host_, *dispatcher, 1));
+  }
+
+  workers_.addWorker(*dispatchers_[3]);
+  workers_.removeWorker(*dispatchers_[1]);
+  for (auto& dispatcher : dispatchers_) {
+    EXPECT_EQ(nullptr, workers_.ownerFor(host_, *dispatcher, 1));
+  }
+}
+
+TEST_F(SharedConnPoolWorkersTest, OwnersDoNotDependOnStartOrder) {
+  for (int i = 3; i >= 0; i--) {
+    workers_.addWorker(*dispatchers_[i]);
+  }
+  SharedConnPoolWorkers other_workers{4};
+  for (auto& dispatcher : dispatchers_) {
+    other_workers.addWorker(*dispatcher);
+  }
+  for (auto& dispatcher : dispatchers_) {
+    EXPECT_EQ(workers_.ownerFor(host_, *dispatcher, 2),
+              other_workers.ownerFor(host_, *dispatcher, 2));
+  }
+}
+
+TEST_F(SharedConnPoolWorkersTest, OtherWorkersHandOffToOwners) {
+  for (auto& dispatcher : dispatchers_) {
+    workers_.addWorker(*dispatcher);
+  }
+
+  for (uint32_t owners_per_host = 1; owners_per_host <= 3; owners_per_host++) {
+    absl::flat_hash_set<Event::Dispatcher*> owners;
+    for (auto& dispatcher : dispatchers_) {
+      if (workers_.ownerFor(host_, *dispatcher, owners_per_host) == nullptr) {
+        owners.insert(dispatcher.get());
+      }
+    }
+    EXPECT_EQ(owners_per_host, owners.size());
+
+    absl::flat_hash_set<Event::Dispatcher*> used_owners;
+    for (auto& dispatcher : dispatchers_) {
+      Event::Dispatcher* owner = workers_.ownerFor(host_, *dispatcher, owners_per_host);
+      if (owner != nullptr) {
+        EXPECT_TRUE(owners.contains(owner));
+        used_owners.insert(owner);
+      }
+    }
+    // The other workers are spread over the owners.
+    EXPECT_EQ(std::min<size_t>(owners_per_host, 4 - owners_per_host), used_owners.size());
+  }
+
+  // With as many owners as workers every worker owns its connections.
+  for (auto& dispatcher : dispatchers_) {
+    EXPECT_EQ(nullptr, workers_.ownerFor(host_, *dispatcher, 8));
+  }
+}
+
+TEST_F(SharedConnPoolWorkersTest, UnknownWorkerOwnsItsConnections) {
+  for (auto& dispatcher : dispatchers_) {
+    workers_.addWorker(*dispatcher);
+  }
+  NiceMock<Event::MockDispatcher> main_thread("main_thread");
+  EXPECT_EQ(nullptr, workers_.ownerFor(host_, main_thread, 1));
+}
+
+class SharedConnPoolClientTest : public testing::Test {
+public:
+  SharedConnPoolClientTest() {
+    // Queue the posts, so that the test controls when each worker runs them.
+    ON_CALL(client_dispatcher_, post(_)).WillByDefault(Invoke([this](Event::PostCb cb) {
+      client_posts_.push_back(std::move(cb));
+    }));
+    ON_CALL(owner_dispatcher_, post(_)).WillByDefault(Invoke([this](Event::PostCb cb) {
+      owner_posts_.push_back(std::move(cb));
+    }));
+    pool_ = std::make_unique<SharedConnPoolClient>(client_dispatcher_, owner_dispatcher_, host_,
+                                                   [this]() { return owner_pool_; });
+  }
+
+  // Runs the posts of both workers until neither has any left.
+  void runPosts() {
+    while (!client_posts_.empty() || !owner_posts_.empty()) {
+      while (!owner_posts_.empty()) {
+        Event::PostCb cb = std::move(owner_posts_.front());
+        owner_posts_.pop_front();
+        cb();
+      }
+      while (!client_posts_.empty()) {
+        Event::PostCb cb = std::move(client_posts_.front());
+        client_posts_.pop_front();
+        cb();
+      }
+    }
+  }
+
+  // Starts a stream and makes it ready on the owner's pool.
+  void startStream() {
+    EXPECT_CALL(owner_pool_mock_, newStream(_, _, _))
+        .WillOnce(Invoke([this](ResponseDecoder& decoder, ConnectionPool::Callbacks& callbacks,
+                                const ConnectionPool::Instance::StreamOptions&) {
+          owner_decoder_ = &decoder;
+          owner_callbacks_ = &callbacks;
+          return &owner_cancellable_;
+        }));
+    EXPECT_NE(nullptr, pool_->newStream(response_decoder_, callbacks_, {false, true}));
+    EXPECT_FALSE(pool_->isIdle());
+    runPosts();
+    ASSERT_NE(nullptr, owner_callbacks_);
+
+    EXPECT_CALL(owner_encoder_.stream_, bufferLimit()).WillOnce(Return(1024));
+    owner_callbacks_->onPoolReady(owner_encoder_, host_, owner_stream_info_, Protocol::Http2);
+    EXPECT_CALL(callbacks_.pool_ready_, ready());
+    runPosts();
+    encoder_ = callbacks_.outer_encoder_;
+    ASSERT_NE(nullptr, encoder_);
+    EXPECT_EQ(1024, encoder_->getStream().bufferLimit());
+  }
+
+  NiceMock<Event::MockDispatcher> client_dispatcher_{"worker_0"};
+  NiceMock<Event::MockDispatcher> owner_dispatcher_{"worker_1"};
+  std::deque<Event::PostCb> client_posts_;
+  std::deque<Event::PostCb> owner_posts_;
+  std::shared_ptr<NiceMock<Upstream::MockHost>> host_{
+      std::make_shared<NiceMock<Upstream::MockHost>>()};
+  NiceMock<ConnectionPool::MockInstance> owner_pool_mock_;
+  ConnectionPool::Instance* owner_pool_{&owner_pool_mock_};
+
+  NiceMock<MockResponseDecoder> response_decoder_;
+  ConnPoolCallbacks callbacks_;
+  RequestEncoder* encoder_{};
+
+  ResponseDecoder* owner_decoder_{};
+  ConnectionPool::Callbacks* owner_callbacks_{};
+  NiceMock<Envoy::ConnectionPool::MockCancellable> owner_cancellable_;
+  NiceMock<MockRequestEncoder> owner_encoder_;
+  NiceMock<StreamInfo::MockStreamInfo> owner_stream_info_;
+  std::unique_ptr<SharedConnPoolClient> pool_;
+};
+
+TEST_F(SharedConnPoolClientTest, HandsOffRequestAndResponse) {
+  startStream();
+
+  TestRequestHeaderMapImpl request_headers{
+      {":method", "POST"}, {":path", "/"}, {":scheme", "http"}, {":authority", "host"}};
+  EXPECT_TRUE(encoder_->encodeHeaders(request_headers, false).ok());
+  Buffer::OwnedImpl request_body("hello");
+  encoder_->encodeData(request_body, true);
+  EXPECT_EQ(0, request_body.length());
+
+  EXPECT_CALL(owner_encoder_, encodeHeaders(HeaderMapEqualRef(&request_headers), false));
+  EXPECT_CALL(owner_encoder_, encodeData(BufferStringEqual("hello"), true));
+  runPosts();
+
+  owner_encoder_.stream_.bytes_meter_->addWireBytesReceived(42);
+  owner_decoder_->decodeHeaders(
+      ResponseHeaderMapPtr{new TestResponseHeaderMapImpl{{":status", "200"}}}, false);
+  Buffer::OwnedImpl response_body("world");
+  owner_decoder_->decodeData(response_body, true);
+  EXPECT_CALL(response_decoder_, decodeHeaders_(_, false));
+  EXPECT_CALL(response_decoder_, decodeData(BufferStringEqual("world"), true));
+  runPosts();
+
+  EXPECT_EQ(42, encoder_->getStream().bytesMeter()->wireBytesReceived());
+  EXPECT_TRUE(pool_->isIdle());
+  // The owner stream no longer listens to the owner's stream.
+  EXPECT_EQ(nullptr, owner_encoder_.stream_.callbacks_[0]);
+}
+
+TEST_F(SharedConnPoolClientTest, ForwardsPoolFailure) {
+  EXPECT_CALL(owner_pool_mock_, newStream(_, _, _))
+      .WillOnce(Invoke([](ResponseDecoder&, ConnectionPool::Callbacks& callbacks,
+                          const ConnectionPool::Instance::StreamOptions&) {
+        callbacks.onPoolFailure(ConnectionPool::PoolFailureReason::RemoteConnectionFailure,
+                                "connection refused", nullptr);
+        return nullptr;
+      }));
+  pool_->newStream(response_decoder_, callbacks_, {false, true});
+  EXPECT_CALL(callbacks_.pool_failure_, ready());
+  runPosts();
+  EXPECT_EQ(ConnectionPool::PoolFailureReason::RemoteConnectionFailure, callbacks_.reason_);
+  EXPECT_EQ("connection refused", callbacks_.transport_failure_reason_);
+  EXPECT_TRUE(pool_->isIdle());
+}
+
+TEST_F(SharedConnPoolClientTest, FailsWithoutOwnerPool) {
+  owner_pool_ = nullptr;
+  pool_->newStream(response_decoder_, callbacks_, {false, true});
+  EXPECT_CALL(callbacks_.pool_failure_, ready());
+  runPosts();
+  EXPECT_EQ(ConnectionPool::PoolFailureReason::LocalConnectionFailure, callbacks_.reason_);
+  EXPECT_EQ("no shared connection pool", callbacks_.transport_failure_reason_);
+  EXPECT_TRUE(pool_->isIdle());
+}
+
+TEST_F(SharedConnPoolClientTest, CancelBeforeReady) {
+  EXPECT_CALL(owner_pool_mock_, newStream(_, _, _)).WillOnce(Return(&owner_cancellable_));
+  ConnectionPool::Cancellable* cancellable =
+      pool_->newStream(response_decoder_, callbacks_, {false, true});
+  runPosts();
+
+  cancellable->cancel(Envoy::ConnectionPool::CancelPolicy::CloseExcess);
+  EXPECT_TRUE(pool_->isIdle());
+  EXPECT_CALL(owner_cancellable_, cancel(Envoy::ConnectionPool::CancelPolicy::CloseExcess));
+  runPosts();
+}
+
+TEST_F(SharedConnPoolClientTest, CancelRacingReady) {
+  ConnectionPool::Callbacks* owner_callbacks = nullptr;
+  EXPECT_CALL(owner_pool_mock_, newStream(_, _, _))
+      .WillOnce(Invoke([&](ResponseDecoder&, ConnectionPool::Callbacks& callbacks,
+                           const ConnectionPool::Instance::StreamOptions&) {
+        owner_callbacks = &callbacks;
+        return &owner_cancellable_;
+      }));
+  ConnectionPool::Cancellable* cancellable =
+      pool_->newStream(response_decoder_, callbacks_, {false, true});
+  runPosts();
+
+  // The stream becomes ready on the owner while the client cancels it.
+  owner_callbacks->onPoolReady(owner_encoder_, host_, owner_stream_info_, Protocol::Http2);
+  cancellable->cancel(Envoy::ConnectionPool::CancelPolicy::Default);
+  EXPECT_CALL(owner_cancellable_, cancel(_)).Times(0);
+  EXPECT_CALL(owner_encoder_.stream_, resetStream(StreamResetReason::LocalReset));
+  EXPECT_CALL(callbacks_.pool_ready_, ready()).Times(0);
+  runPosts();
+}
+
+TEST_F(SharedConnPoolClientTest, LocalReset) {
+  startStream();
+  NiceMock<MockStreamCallbacks> stream_callbacks;
+  encoder_->getStream().addCallbacks(stream_callbacks);
+
+  EXPECT_CALL(stream_callbacks, onResetStream(StreamResetReason::LocalReset, _));
+  encoder_->getStream().resetStream(StreamResetReason::LocalReset);
+  EXPECT_TRUE(pool_->isIdle());
+
+  EXPECT_CALL(owner_encoder_.stream_, resetStream(StreamResetReason::LocalReset));
+  runPosts();
+}
+
+TEST_F(SharedConnPoolClientTest, RemoteReset) {
+  startStream();
+  NiceMock<MockStreamCallbacks> stream_callbacks;
+  encoder_->getStream().addCallbacks(stream_callbacks);
+
+  owner_encoder_.stream_.resetStream(StreamResetReason::RemoteReset);
+  EXPECT_CALL(stream_callbacks, onResetStream(StreamResetReason::RemoteReset, _));
+  runPosts();
+  EXPECT_TRUE(pool_->isIdle());
+}
+
+TEST_F(SharedConnPoolClientTest, ForwardsWatermarks) {
+  startStream();
+  NiceMock<MockStreamCallbacks> stream_callbacks;
+  encoder_->getStream().addCallbacks(stream_callbacks);
+
+  owner_encoder_.stream_.runHighWatermarkCallbacks();
+  owner_encoder_.stream_.runLowWatermarkCallbacks();
+  EXPECT_CALL(stream_callbacks, onAboveWriteBufferHighWatermark());
+  EXPECT_CALL(stream_callbacks, onBelowWriteBufferLowWatermark());
+  runPosts();
+
+  EXPECT_CALL(owner_encoder_.stream_, readDisable(true));
+  encoder_->getStream().readDisable(true);
+  runPosts();
+}
+
+TEST_F(SharedConnPoolClientTest, BoundsDataNotYetWrittenByOwner) {
+  startStream();
+  NiceMock<MockStreamCallbacks> stream_callbacks;
+  encoder_->getStream().addCallbacks(stream_callbacks);
+  TestRequestHeaderMapImpl request_headers{
+      {":method", "POST"}, {":path", "/"}, {":scheme", "http"}, {":authority", "host"}};
+  EXPECT_TRUE(encoder_->encodeHeaders(request_headers, false).ok());
+
+  // Up to the owner stream's buffer limit may be queued for the owner's worker.
+  Buffer::OwnedImpl first(std::string(1024, 'a'));
+  EXPECT_CALL(stream_callbacks, onAboveWriteBufferHighWatermark()).Times(0);
+  encoder_->encodeData(first, false);
+
+  Buffer::OwnedImpl second("b");
+  EXPECT_CALL(stream_callbacks, onAboveWriteBufferHighWatermark());
+  encoder_->encodeData(second, false);
+  Buffer::OwnedImpl third("c");
+  encoder_->encodeData(third, false);
+
+  // Once the owner has written the data, the client may send more.
+  EXPECT_CALL(owner_encoder_, encodeData(_, false)).Times(3);
+  EXPECT_CALL(stream_callbacks, onBelowWriteBufferLowWatermark());
+  runPosts();
+
+  Buffer::OwnedImpl last("d");
+  EXPECT_CALL(stream_callbacks, onAboveWriteBufferHighWatermark()).Times(0);
+  encoder_->encodeData(last, true);
+  EXPECT_CALL(owner_encoder_, encodeData(BufferStringEqual("d"), true));
+  runPosts();
+}
+
+TEST_F(SharedConnPoolClientTest, IdleAfterDrainAndDelete) {
+  startStream();
+  bool idle = false;
+  pool_->addIdleCallback([&idle]() { idle = true; });
+  pool_->drainConnections(Envoy::ConnectionPool::DrainBehavior::DrainAndDelete);
+  EXPECT_FALSE(idle);
+
+  encoder_->getStream().resetStream(StreamResetReason::LocalReset);
+  EXPECT_TRUE(idle);
+  runPosts();
+}
+
+TEST_F(SharedConnPoolClientTest, DestroyWithActiveStream) {
+  startStream();
+  NiceMock<MockStreamCallbacks> stream_callbacks;
+  encoder_->getStream().addCallbacks(stream_callbacks);
+
+  EXPECT_CALL(stream_callbacks, onResetStream(StreamResetReason::ConnectionTermination, _));
+  pool_.reset();
+  EXPECT_CALL(owner_encoder_.stream_, resetStream(StreamResetReason::ConnectionTermination));
+  runPosts();
+}
+
+} // namespace
+} // namespace Http2
+} // namespace Http
+} // namespace Envoy
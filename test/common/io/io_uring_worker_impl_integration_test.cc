@@ -9,6 +9,7 @@
 #include "test/test_common/test_time.h"
 #include "test/test_common/utility.h"
 
+#include "absl/strings/str_cat.h"
 #include "gtest/gtest.h"
 
 namespace Envoy {
@@ -89,8 +90,10 @@ public:
 
 class IoUringWorkerTestImpl : public IoUringWorkerImpl {
 public:
-  IoUringWorkerTestImpl(IoUringPtr io_uring_instance, Event::Dispatcher& dispatcher)
-      : IoUringWorkerImpl(std::move(io_uring_instance), 8192, 1000, dispatcher) {}
+  IoUringWorkerTestImpl(IoUringPtr io_uring_instance, Event::Dispatcher& dispatcher,
+                        uint32_t read_buffer_ring_size = 0)
+      : IoUringWorkerImpl(std::move(io_uring_instance), 8192, 1000, dispatcher,
+                          read_buffer_ring_size) {}
 
   IoUringSocket& addTestSocket(os_fd_t fd) {
     return addSocket(std::make_unique<IoUringSocketTestImpl>(fd, *this));
@@ -109,11 +112,11 @@ protected:
     }
   }
 
-  void initialize() {
+  void initialize(uint32_t read_buffer_ring_size = 0) {
     api_ = Api::createApiForTest(time_system_);
     dispatcher_ = api_->allocateDispatcher("test_thread");
     io_uring_worker_ = std::make_unique<IoUringWorkerTestImpl>(
-        std::make_unique<IoUringImpl>(20, false), *dispatcher_);
+        std::make_unique<IoUringImpl>(20, false), *dispatcher_, read_buffer_ring_size);
   }
 
   void createListenerAndConnectedSocketPair() {
@@ -315,6 +318,79 @@ TEST_F(IoUringWorkerIntegrationTest, ServerSocketRead) {
   cleanup();
 }
 
+TEST_F(IoUringWorkerIntegrationTest, ServerSocketMultishotRead) {
+  initialize(16);
+  if (!io_uring_worker_->supportsMultishot()) {
+    GTEST_SKIP() << "provided buffer rings are not supported by the kernel";
+  }
+  createListenerAndConnectedSocketPair();
+
+  std::string read_data;
+  OptRef<IoUringSocket> socket;
+  socket = io_uring_worker_->addServerSocket(
+      server_socket_,
+      [&socket, &read_data](uint32_t events) {
+        ASSERT(events == Event::FileReadyType::Read);
+        EXPECT_NE(absl::nullopt, socket->getReadParam());
+        EXPECT_GT(socket->getReadParam()->result_, 0);
+        read_data.append(socket->getReadParam()->buf_.toString());
+        socket->getReadParam()->buf_.drain(socket->getReadParam()->buf_.length());
+        return absl::OkStatus();
+      },
+      false);
+
+  // More writes than there are provided buffers, all of which are received, whether the receive
+  // request stays armed or falls back to a buffer of its own.
+  std::string expected_data;
+  for (int i = 0; i < 32; i++) {
+    const std::string write_data = absl::StrCat("hello world ", i, "\n");
+    Api::OsSysCallsSingleton::get().write(client_socket_, write_data.data(), write_data.size());
+    expected_data.append(write_data);
+    while (read_data.size() < expected_data.size()) {
+      dispatcher_->run(Event::Dispatcher::RunType::NonBlock);
+    }
+  }
+  EXPECT_EQ(expected_data, read_data);
+
+  socket->close(false);
+  runToClose(server_socket_);
+  EXPECT_EQ(io_uring_worker_->getSockets().size(), 0);
+  cleanup();
+}
+
+TEST_F(IoUringWorkerIntegrationTest, AcceptSocketMultishotAccept) {
+  initialize(16);
+  if (!io_uring_worker_->supportsMultishot()) {
+    GTEST_SKIP() << "provided buffer rings are not supported by the kernel";
+  }
+  socket(true, true);
+  listen();
+
+  OptRef<IoUringSocket> accept_socket;
+  accept_socket =
+      io_uring_worker_->addAcceptSocket(listen_socket_, [&accept_socket, this](uint32_t events) {
+        EXPECT_EQ(Event::FileReadyType::Read, events);
+        const os_fd_t fd = accept_socket->popAcceptedSocket();
+        if (SOCKET_VALID(fd)) {
+          server_socket_ = fd;
+        }
+        return absl::OkStatus();
+      });
+
+  connect();
+  while (!SOCKET_VALID(server_socket_)) {
+    dispatcher_->run(Event::Dispatcher::RunType::NonBlock);
+  }
+  // The accepted socket is non-blocking, as with accept4(SOCK_NONBLOCK).
+  EXPECT_TRUE(fcntl(server_socket_, F_GETFL) & O_NONBLOCK);
+
+  accept_socket->close(false);
+  runToClose(listen_socket_);
+  EXPECT_EQ(io_uring_worker_->getSockets().size(), 0);
+  Api::OsSysCallsSingleton::get().close(client_socket_);
+  Api::OsSysCallsSingleton::get().close(server_socket_);
+}
+
 TEST_F(IoUringWorkerIntegrationTest, ServerSocketReadError) {
   initialize();
 
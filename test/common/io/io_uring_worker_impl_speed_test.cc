@@ -0,0 +1,276 @@
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include "source/common/api/os_sys_calls_impl.h"
+#include "source/common/buffer/buffer_impl.h"
+#include "source/common/io/io_uring_impl.h"
+#include "source/common/io/io_uring_worker_impl.h"
+#include "source/common/network/io_socket_handle_impl.h"
+
+#include "test/test_common/test_time.h"
+#include "test/test_common/utility.h"
+
+#include "benchmark/benchmark.h"
+
+namespace Envoy {
+namespace Io {
+namespace {
+
+// Compares the ingress of TCP connections over loopback through the libevent path, the io_uring
+// worker with single shot requests, and the io_uring worker with multishot requests into a
+// provided buffer ring.
+enum class IngressPath : int64_t { Libevent = 0, IoUring = 1, IoUringMultishot = 2 };
+
+constexpr uint32_t ReadBufferSize = 8192;
+constexpr uint32_t ReadBufferRingSize = 256;
+
+class IngressFixture {
+public:
+  explicit IngressFixture(IngressPath path)
+      : api_(Api::createApiForTest(time_system_)),
+        dispatcher_(api_->allocateDispatcher("test_thread")) {
+    if (path != IngressPath::Libevent && isIoUringSupported()) {
+      worker_ = std::make_unique<IoUringWorkerImpl>(
+          1024, false, ReadBufferSize, 1000, *dispatcher_,
+          path == IngressPath::IoUringMultishot ? ReadBufferRingSize : 0);
+    }
+
+    auto& os_sys_calls = Api::OsSysCallsSingleton::get();
+    listen_fd_ =
+        os_sys_calls.socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, IPPROTO_TCP).return_value_;
+    RELEASE_ASSERT(SOCKET_VALID(listen_fd_), "");
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    RELEASE_ASSERT(os_sys_calls
+                           .bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr))
+                           .return_value_ == 0,
+                   "");
+    RELEASE_ASSERT(os_sys_calls.listen(listen_fd_, 1024).return_value_ == 0, "");
+    socklen_t len = sizeof(listen_addr_);
+    RELEASE_ASSERT(
+        os_sys_calls.getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&listen_addr_), &len)
+                .return_value_ == 0,
+        "");
+  }
+
+  ~IngressFixture() {
+    worker_.reset();
+    Api::OsSysCallsSingleton::get().close(listen_fd_);
+  }
+
+  // Return why the path can't be benchmarked on this host, or an empty string.
+  std::string unsupportedReason(IngressPath path) const {
+    if (path == IngressPath::Libevent) {
+      return "";
+    }
+    if (worker_ == nullptr) {
+      return "io_uring is not supported by the kernel";
+    }
+    if (path == IngressPath::IoUringMultishot && !worker_->supportsMultishot()) {
+      return "provided buffer rings are not supported by the kernel";
+    }
+    return "";
+  }
+
+  // Start a non-blocking connect to the listener. The connection is reset on close, so that
+  // benchmarks with many connections don't run out of ports to TIME_WAIT.
+  os_fd_t connect() {
+    auto& os_sys_calls = Api::OsSysCallsSingleton::get();
+    const os_fd_t fd =
+        os_sys_calls.socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, IPPROTO_TCP).return_value_;
+    RELEASE_ASSERT(SOCKET_VALID(fd), "");
+    const linger reset_on_close{1, 0};
+    os_sys_calls.setsockopt(fd, SOL_SOCKET, SO_LINGER, &reset_on_close, sizeof(reset_on_close));
+    os_sys_calls.connect(fd, reinterpret_cast<const sockaddr*>(&listen_addr_),
+                         sizeof(listen_addr_));
+    return fd;
+  }
+
+  os_fd_t acceptWithoutEvent() {
+    while (true) {
+      const os_fd_t fd =
+          Api::OsSysCallsSingleton::get().accept(listen_fd_, nullptr, nullptr).return_value_;
+      if (SOCKET_VALID(fd)) {
+        return fd;
+      }
+    }
+  }
+
+  Event::Dispatcher& dispatcher() { return *dispatcher_; }
+  IoUringWorkerImpl& worker() { return *worker_; }
+  os_fd_t listenFd() const { return listen_fd_; }
+
+private:
+  Event::GlobalTimeSystem time_system_;
+  Api::ApiPtr api_;
+  Event::DispatcherPtr dispatcher_;
+  std::unique_ptr<IoUringWorkerImpl> worker_;
+  os_fd_t listen_fd_{INVALID_SOCKET};
+  sockaddr_in listen_addr_{};
+};
+
+// Writes `range(1)` bytes at a time into an established connection, and waits for the server side
+// to read them.
+void bmServerSocketRead(benchmark::State& state) {
+  const auto path = static_cast<IngressPath>(state.range(0));
+  const uint64_t chunk_size = state.range(1);
+  IngressFixture fixture(path);
+  const std::string reason = fixture.unsupportedReason(path);
+  if (!reason.empty()) {
+    state.SkipWithError(reason.c_str());
+    return;
+  }
+
+  auto& os_sys_calls = Api::OsSysCallsSingleton::get();
+  const os_fd_t client_fd = fixture.connect();
+  const os_fd_t server_fd = fixture.acceptWithoutEvent();
+
+  uint64_t received = 0;
+  Network::IoSocketHandleImpl handle(server_fd);
+  Buffer::OwnedImpl read_buffer;
+  Event::FileEventPtr file_event;
+  OptRef<IoUringSocket> socket;
+  if (path == IngressPath::Libevent) {
+    file_event = fixture.dispatcher().createFileEvent(
+        server_fd,
+        [&handle, &read_buffer, &received](uint32_t) {
+          while (true) {
+            const Api::IoCallUint64Result result = handle.read(read_buffer, absl::nullopt);
+            if (!result.ok() || result.return_value_ == 0) {
+              break;
+            }
+            received += result.return_value_;
+            read_buffer.drain(read_buffer.length());
+          }
+          return absl::OkStatus();
+        },
+        Event::PlatformDefaultTriggerType, Event::FileReadyType::Read);
+  } else {
+    socket = fixture.worker().addServerSocket(
+        server_fd,
+        [&socket, &received](uint32_t) {
+          Buffer::Instance& buffer = socket->getReadParam()->buf_;
+          received += buffer.length();
+          buffer.drain(buffer.length());
+          return absl::OkStatus();
+        },
+        false);
+  }
+
+  const std::string data(chunk_size, 'a');
+  uint64_t expected = 0;
+  for (auto _ : state) {
+    UNREFERENCED_PARAMETER(_);
+    uint64_t written = 0;
+    expected += chunk_size;
+    while (received < expected) {
+      if (written < chunk_size) {
+        const Api::SysCallSizeResult result =
+            os_sys_calls.write(client_fd, data.data() + written, chunk_size - written);
+        if (result.return_value_ > 0) {
+          written += result.return_value_;
+        }
+      }
+      fixture.dispatcher().run(Event::Dispatcher::RunType::NonBlock);
+    }
+  }
+  state.SetBytesProcessed(expected);
+
+  os_sys_calls.close(client_fd);
+  if (socket.has_value()) {
+    // Leave the fd to the handle, as the io_uring socket handle does.
+    socket->close(true);
+    while (fixture.worker().getNumOfSockets() > 0) {
+      fixture.dispatcher().run(Event::Dispatcher::RunType::NonBlock);
+    }
+  }
+  file_event.reset();
+}
+BENCHMARK(bmServerSocketRead)
+    ->ArgsProduct({{static_cast<int64_t>(IngressPath::Libevent),
+                    static_cast<int64_t>(IngressPath::IoUring),
+                    static_cast<int64_t>(IngressPath::IoUringMultishot)},
+                   {512, 4096, 65536}})
+    ->Unit(benchmark::kMicrosecond);
+
+// Opens a connection, waits for the listener to accept it, and resets it again. The single shot
+// io_uring worker accepts through libevent, so only the multishot accept is compared.
+void bmAccept(benchmark::State& state) {
+  const auto path = static_cast<IngressPath>(state.range(0));
+  IngressFixture fixture(path);
+  const std::string reason = fixture.unsupportedReason(path);
+  if (!reason.empty()) {
+    state.SkipWithError(reason.c_str());
+    return;
+  }
+
+  auto& os_sys_calls = Api::OsSysCallsSingleton::get();
+  std::vector<os_fd_t> accepted;
+  Event::FileEventPtr file_event;
+  OptRef<IoUringSocket> socket;
+  if (path == IngressPath::Libevent) {
+    file_event = fixture.dispatcher().createFileEvent(
+        fixture.listenFd(),
+        [&fixture, &os_sys_calls, &accepted](uint32_t) {
+          while (true) {
+            sockaddr_storage peer;
+            socklen_t peer_len = sizeof(peer);
+            const os_fd_t fd =
+                os_sys_calls
+                    .accept(fixture.listenFd(), reinterpret_cast<sockaddr*>(&peer), &peer_len)
+                    .return_value_;
+            if (!SOCKET_VALID(fd)) {
+              break;
+            }
+            accepted.push_back(fd);
+          }
+          return absl::OkStatus();
+        },
+        Event::PlatformDefaultTriggerType, Event::FileReadyType::Read);
+  } else {
+    socket =
+        fixture.worker().addAcceptSocket(fixture.listenFd(), [&socket, &os_sys_calls,
+                                                              &accepted](uint32_t) {
+          for (os_fd_t fd = socket->popAcceptedSocket(); SOCKET_VALID(fd);
+               fd = socket->popAcceptedSocket()) {
+            // Multishot accept doesn't report the peer, which the listener asks for.
+            sockaddr_storage peer;
+            socklen_t peer_len = sizeof(peer);
+            os_sys_calls.getpeername(fd, reinterpret_cast<sockaddr*>(&peer), &peer_len);
+            accepted.push_back(fd);
+          }
+          return absl::OkStatus();
+        });
+  }
+
+  for (auto _ : state) {
+    UNREFERENCED_PARAMETER(_);
+    const os_fd_t client_fd = fixture.connect();
+    while (accepted.empty()) {
+      fixture.dispatcher().run(Event::Dispatcher::RunType::NonBlock);
+    }
+    os_sys_calls.close(client_fd);
+    for (const os_fd_t fd : accepted) {
+      os_sys_calls.close(fd);
+    }
+    accepted.clear();
+  }
+
+  if (socket.has_value()) {
+    // The listen fd is closed by the fixture.
+    socket->close(true);
+    while (fixture.worker().getNumOfSockets() > 0) {
+      fixture.dispatcher().run(Event::Dispatcher::RunType::NonBlock);
+    }
+  }
+  file_event.reset();
+}
+BENCHMARK(bmAccept)
+    ->Arg(static_cast<int64_t>(IngressPath::Libevent))
+    ->Arg(static_cast<int64_t>(IngressPath::IoUringMultishot))
+    ->Unit(benchmark::kMicrosecond);
+
+} // namespace
+} // namespace Io
+} // namespace Envoy
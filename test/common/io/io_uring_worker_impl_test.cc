@@ -336,6 +336,320 @@ TEST(IoUringWorkerImplTest, ServerSocketInjectAfterRead) {
   EXPECT_EQ(0, worker.getSockets().size());
 }
 
+TEST(IoUringWorkerImplTest, ServerSocketMultishotRead) {
+  Event::MockDispatcher dispatcher;
+  IoUringPtr io_uring_instance = std::make_unique<MockIoUring>();
+  MockIoUring& mock_io_uring = *dynamic_cast<MockIoUring*>(io_uring_instance.get());
+  Event::FileReadyCb file_event_callback;
+
+  // The ring size is rounded up to a power of two.
+  EXPECT_CALL(mock_io_uring, registerBufferRing(16, 8192)).WillOnce(Return(true));
+  EXPECT_CALL(mock_io_uring, registerFileTable(IoUringWorkerImpl::RegisteredFileTableSize))
+      .WillOnce(Return(true));
+  // Only listening sockets are registered in the file table.
+  EXPECT_CALL(mock_io_uring, registerFile(_)).Times(0);
+  EXPECT_CALL(mock_io_uring, registerEventfd());
+  EXPECT_CALL(dispatcher,
+              createFileEvent_(_, _, Event::PlatformDefaultTriggerType, Event::FileReadyType::Read))
+      .WillOnce(
+          DoAll(SaveArg<1>(&file_event_callback), ReturnNew<NiceMock<Event::MockFileEvent>>()));
+  IoUringWorkerImpl worker(std::move(io_uring_instance), 8192, 1000, dispatcher, 10);
+  EXPECT_TRUE(worker.supportsMultishot());
+
+  os_fd_t fd = 11;
+  SET_SOCKET_INVALID(fd);
+
+  // The server socket arms a single multishot receive request.
+  Request* read_req = nullptr;
+  EXPECT_CALL(mock_io_uring, prepareRecvMultishot(fd, _))
+      .WillOnce(DoAll(SaveArg<1>(&read_req), Return<IoUringResult>(IoUringResult::Ok)));
+  EXPECT_CALL(mock_io_uring, submit()).Times(1).RetiresOnSaturation();
+  std::vector<int32_t> read_results;
+  OptRef<IoUringSocket> socket;
+  socket = worker.addServerSocket(
+      fd,
+      [&socket, &read_results](uint32_t) {
+        read_results.push_back(socket->getReadParam()->result_);
+        return absl::OkStatus();
+      },
+      false);
+  auto& io_uring_socket = socket.ref();
+
+  // A completion with more to come hands over a provided buffer and keeps the request armed.
+  EXPECT_CALL(mock_io_uring, forEveryCompletion(_))
+      .WillOnce(Invoke([&read_req](const CompletionCb& cb) {
+        read_req->setCompletionFlags(IORING_CQE_F_MORE | IORING_CQE_F_BUFFER |
+                                     (3 << IORING_CQE_BUFFER_SHIFT));
+        cb(read_req, 5, false);
+      }));
+  EXPECT_CALL(mock_io_uring, takeProvidedBuffer(3, 5, _))
+      .WillOnce(Invoke([](uint16_t, uint32_t, Buffer::Instance& buffer) { buffer.add("hello"); }));
+  EXPECT_CALL(mock_io_uring, prepareRecvMultishot(_, _)).Times(0);
+  EXPECT_CALL(mock_io_uring, submit()).Times(1).RetiresOnSaturation();
+  ASSERT_TRUE(file_event_callback(Event::FileReadyType::Read).ok());
+  EXPECT_EQ(std::vector<int32_t>({5}), read_results);
+
+  // The provided buffer ring ran dry, so the next read uses a buffer of its own.
+  Request* single_shot_read_req = nullptr;
+  EXPECT_CALL(mock_io_uring, forEveryCompletion(_))
+      .WillOnce(Invoke([&read_req](const CompletionCb& cb) {
+        read_req->setCompletionFlags(0);
+        cb(read_req, -ENOBUFS, false);
+      }));
+  EXPECT_CALL(mock_io_uring, prepareReadv(fd, _, _, _, _))
+      .WillOnce(DoAll(SaveArg<4>(&single_shot_read_req), Return<IoUringResult>(IoUringResult::Ok)));
+  EXPECT_CALL(mock_io_uring, submit()).Times(1).RetiresOnSaturation();
+  ASSERT_TRUE(file_event_callback(Event::FileReadyType::Read).ok());
+  // The undrained data is delivered again, but ENOBUFS is not an error of the socket.
+  EXPECT_EQ(std::vector<int32_t>({5, 5}), read_results);
+
+  Request* cancel_req = nullptr;
+  EXPECT_CALL(mock_io_uring, prepareCancel(_, _))
+      .WillOnce(DoAll(SaveArg<1>(&cancel_req), Return<IoUringResult>(IoUringResult::Ok)))
+      .RetiresOnSaturation();
+  EXPECT_CALL(mock_io_uring, submit()).Times(1).RetiresOnSaturation();
+  io_uring_socket.close(false);
+
+  EXPECT_CALL(mock_io_uring, forEveryCompletion(_))
+      .WillOnce(Invoke([&single_shot_read_req, &cancel_req](const CompletionCb& cb) {
+        cb(single_shot_read_req, -ECANCELED, false);
+        cb(cancel_req, 0, false);
+      }));
+  Request* close_req = nullptr;
+  EXPECT_CALL(mock_io_uring, prepareClose(_, _))
+      .WillOnce(DoAll(SaveArg<1>(&close_req), Return<IoUringResult>(IoUringResult::Ok)))
+      .RetiresOnSaturation();
+  EXPECT_CALL(mock_io_uring, submit()).Times(1).RetiresOnSaturation();
+  ASSERT_TRUE(file_event_callback(Event::FileReadyType::Read).ok());
+
+  EXPECT_CALL(mock_io_uring, forEveryCompletion(_))
+      .WillOnce(Invoke([&close_req](const CompletionCb& cb) { cb(close_req, 0, false); }));
+  EXPECT_CALL(mock_io_uring, removeInjectedCompletion(fd));
+  EXPECT_CALL(dispatcher, deferredDelete_);
+  EXPECT_CALL(dispatcher, clearDeferredDeleteList());
+  EXPECT_CALL(mock_io_uring, submit()).Times(1).RetiresOnSaturation();
+  ASSERT_TRUE(file_event_callback(Event::FileReadyType::Read).ok());
+}
+
+TEST(IoUringWorkerImplTest, ServerSocketMultishotReadDisabled) {
+  Event::MockDispatcher dispatcher;
+  IoUringPtr io_uring_instance = std::make_unique<MockIoUring>();
+  MockIoUring& mock_io_uring = *dynamic_cast<MockIoUring*>(io_uring_instance.get());
+  Event::FileReadyCb file_event_callback;
+
+  EXPECT_CALL(mock_io_uring, registerBufferRing(16, 8192)).WillOnce(Return(true));
+  EXPECT_CALL(mock_io_uring, registerFileTable(IoUringWorkerImpl::RegisteredFileTableSize))
+      .WillOnce(Return(true));
+  EXPECT_CALL(mock_io_uring, registerEventfd());
+  EXPECT_CALL(dispatcher,
+              createFileEvent_(_, _, Event::PlatformDefaultTriggerType, Event::FileReadyType::Read))
+      .WillOnce(
+          DoAll(SaveArg<1>(&file_event_callback), ReturnNew<NiceMock<Event::MockFileEvent>>()));
+  IoUringWorkerImpl worker(std::move(io_uring_instance), 8192, 1000, dispatcher, 10);
+
+  os_fd_t fd = 11;
+  SET_SOCKET_INVALID(fd);
+
+  Request* read_req = nullptr;
+  EXPECT_CALL(mock_io_uring, prepareRecvMultishot(fd, _))
+      .WillOnce(DoAll(SaveArg<1>(&read_req), Return<IoUringResult>(IoUringResult::Ok)));
+  EXPECT_CALL(mock_io_uring, submit()).Times(1).RetiresOnSaturation();
+  std::vector<int32_t> read_results;
+  OptRef<IoUringSocket> socket;
+  socket = worker.addServerSocket(
+      fd,
+      [&socket, &read_results](uint32_t) {
+        read_results.push_back(socket->getReadParam()->result_);
+        return absl::OkStatus();
+      },
+      false);
+  auto& io_uring_socket = dynamic_cast<IoUringServerSocket&>(socket.ref());
+
+  // Disabling reads cancels the multishot receive request.
+  Request* cancel_req = nullptr;
+  EXPECT_CALL(mock_io_uring, prepareCancel(read_req, _))
+      .WillOnce(DoAll(SaveArg<1>(&cancel_req), Return<IoUringResult>(IoUringResult::Ok)));
+  EXPECT_CALL(mock_io_uring, submit()).Times(1).RetiresOnSaturation();
+  io_uring_socket.disableRead();
+
+  // The peer keeps sending. The data received before the cancellation is kept, and then a single
+  // shot read watches for the remote close.
+  Request* single_shot_read_req = nullptr;
+  EXPECT_CALL(mock_io_uring, forEveryCompletion(_))
+      .WillOnce(Invoke([&read_req, &cancel_req](const CompletionCb& cb) {
+        read_req->setCompletionFlags(IORING_CQE_F_MORE | IORING_CQE_F_BUFFER |
+                                     (3 << IORING_CQE_BUFFER_SHIFT));
+        cb(read_req, 5, false);
+        read_req->setCompletionFlags(0);
+        cb(read_req, -ECANCELED, false);
+        cb(cancel_req, 0, false);
+      }));
+  EXPECT_CALL(mock_io_uring, takeProvidedBuffer(3, 5, _))
+      .WillOnce(Invoke([](uint16_t, uint32_t, Buffer::Instance& buffer) { buffer.add("hello"); }));
+  EXPECT_CALL(mock_io_uring, prepareReadv(fd, _, _, _, _))
+      .WillOnce(DoAll(SaveArg<4>(&single_shot_read_req), Return<IoUringResult>(IoUringResult::Ok)))
+      .RetiresOnSaturation();
+  EXPECT_CALL(mock_io_uring, submit()).Times(1).RetiresOnSaturation();
+  ASSERT_TRUE(file_event_callback(Event::FileReadyType::Read).ok());
+
+  // Once a read buffer worth of data is waiting, no more reads are submitted until reads are
+  // enabled again.
+  EXPECT_CALL(mock_io_uring, forEveryCompletion(_))
+      .WillOnce(Invoke([&single_shot_read_req](const CompletionCb& cb) {
+        cb(single_shot_read_req, 8192, false);
+      }));
+  EXPECT_CALL(mock_io_uring, prepareReadv(_, _, _, _, _)).Times(0);
+  EXPECT_CALL(mock_io_uring, prepareRecvMultishot(_, _)).Times(0);
+  EXPECT_CALL(mock_io_uring, submit()).Times(1).RetiresOnSaturation();
+  ASSERT_TRUE(file_event_callback(Event::FileReadyType::Read).ok());
+
+  EXPECT_EQ(8192 + 5, io_uring_socket.getReadBuffer().length());
+  EXPECT_TRUE(read_results.empty());
+
+  // Nothing is in flight, so the socket is closed right away.
+  Request* close_req = nullptr;
+  EXPECT_CALL(mock_io_uring, prepareClose(_, _))
+      .WillOnce(DoAll(SaveArg<1>(&close_req), Return<IoUringResult>(IoUringResult::Ok)));
+  EXPECT_CALL(mock_io_uring, submit()).Times(1).RetiresOnSaturation();
+  io_uring_socket.close(false);
+
+  EXPECT_CALL(mock_io_uring, forEveryCompletion(_))
+      .WillOnce(Invoke([&close_req](const CompletionCb& cb) { cb(close_req, 0, false); }));
+  EXPECT_CALL(mock_io_uring, removeInjectedCompletion(fd));
+  EXPECT_CALL(dispatcher, deferredDelete_);
+  EXPECT_CALL(dispatcher, clearDeferredDeleteList());
+  EXPECT_CALL(mock_io_uring, submit()).Times(1).RetiresOnSaturation();
+  ASSERT_TRUE(file_event_callback(Event::FileReadyType::Read).ok());
+}
+
+TEST(IoUringWorkerImplTest, AcceptSocketMultishotAccept) {
+  Event::MockDispatcher dispatcher;
+  IoUringPtr io_uring_instance = std::make_unique<MockIoUring>();
+  MockIoUring& mock_io_uring = *dynamic_cast<MockIoUring*>(io_uring_instance.get());
+  Event::FileReadyCb file_event_callback;
+
+  EXPECT_CALL(mock_io_uring, registerBufferRing(16, 8192)).WillOnce(Return(true));
+  EXPECT_CALL(mock_io_uring, registerFileTable(IoUringWorkerImpl::RegisteredFileTableSize))
+      .WillOnce(Return(false));
+  EXPECT_CALL(mock_io_uring, registerEventfd());
+  EXPECT_CALL(dispatcher,
+              createFileEvent_(_, _, Event::PlatformDefaultTriggerType, Event::FileReadyType::Read))
+      .WillOnce(
+          DoAll(SaveArg<1>(&file_event_callback), ReturnNew<NiceMock<Event::MockFileEvent>>()));
+  IoUringWorkerImpl worker(std::move(io_uring_instance), 8192, 1000, dispatcher, 16);
+
+  os_fd_t fd = 11;
+  SET_SOCKET_INVALID(fd);
+
+  Request* accept_req = nullptr;
+  EXPECT_CALL(mock_io_uring, prepareAcceptMultishot(fd, _))
+      .WillOnce(DoAll(SaveArg<1>(&accept_req), Return<IoUringResult>(IoUringResult::Ok)));
+  EXPECT_CALL(mock_io_uring, submit()).Times(1).RetiresOnSaturation();
+  std::vector<os_fd_t> accepted;
+  OptRef<IoUringSocket> socket;
+  socket = worker.addAcceptSocket(fd, [&socket, &accepted](uint32_t events) {
+    EXPECT_EQ(Event::FileReadyType::Read, events);
+    for (os_fd_t accepted_fd = socket->popAcceptedSocket(); SOCKET_VALID(accepted_fd);
+         accepted_fd = socket->popAcceptedSocket()) {
+      accepted.push_back(accepted_fd);
+    }
+    return absl::OkStatus();
+  });
+
+  // Every accepted connection is delivered while the request stays armed.
+  EXPECT_CALL(mock_io_uring, forEveryCompletion(_))
+      .WillOnce(Invoke([&accept_req](const CompletionCb& cb) {
+        accept_req->setCompletionFlags(IORING_CQE_F_MORE);
+        cb(accept_req, 20, false);
+        cb(accept_req, 21, false);
+      }));
+  EXPECT_CALL(mock_io_uring, prepareAcceptMultishot(_, _)).Times(0);
+  EXPECT_CALL(mock_io_uring, submit()).Times(1).RetiresOnSaturation();
+  ASSERT_TRUE(file_event_callback(Event::FileReadyType::Read).ok());
+  EXPECT_EQ(std::vector<os_fd_t>({20, 21}), accepted);
+
+  // Closing cancels the accept request before closing the listener.
+  Request* cancel_req = nullptr;
+  EXPECT_CALL(mock_io_uring, prepareCancel(_, _))
+      .WillOnce(DoAll(SaveArg<1>(&cancel_req), Return<IoUringResult>(IoUringResult::Ok)))
+      .RetiresOnSaturation();
+  EXPECT_CALL(mock_io_uring, submit()).Times(1).RetiresOnSaturation();
+  socket->close(false);
+
+  EXPECT_CALL(mock_io_uring, forEveryCompletion(_))
+      .WillOnce(Invoke([&accept_req, &cancel_req](const CompletionCb& cb) {
+        accept_req->setCompletionFlags(0);
+        cb(accept_req, -ECANCELED, false);
+        cb(cancel_req, 0, false);
+      }));
+  Request* close_req = nullptr;
+  EXPECT_CALL(mock_io_uring, prepareClose(fd, _))
+      .WillOnce(DoAll(SaveArg<1>(&close_req), Return<IoUringResult>(IoUringResult::Ok)))
+      .RetiresOnSaturation();
+  EXPECT_CALL(mock_io_uring, submit()).Times(1).RetiresOnSaturation();
+  ASSERT_TRUE(file_event_callback(Event::FileReadyType::Read).ok());
+
+  EXPECT_CALL(mock_io_uring, forEveryCompletion(_))
+      .WillOnce(Invoke([&close_req](const CompletionCb& cb) { cb(close_req, 0, false); }));
+  EXPECT_CALL(mock_io_uring, removeInjectedCompletion(fd));
+  EXPECT_CALL(dispatcher, deferredDelete_);
+  EXPECT_CALL(dispatcher, clearDeferredDeleteList());
+  EXPECT_CALL(mock_io_uring, submit()).Times(1).RetiresOnSaturation();
+  ASSERT_TRUE(file_event_callback(Event::FileReadyType::Read).ok());
+}
+
+TEST(IoUringWorkerImplTest, AcceptSocketRegisteredFile) {
+  Event::MockDispatcher dispatcher;
+  IoUringPtr io_uring_instance = std::make_unique<MockIoUring>();
+  MockIoUring& mock_io_uring = *dynamic_cast<MockIoUring*>(io_uring_instance.get());
+  Event::FileReadyCb file_event_callback;
+
+  EXPECT_CALL(mock_io_uring, registerBufferRing(16, 8192)).WillOnce(Return(true));
+  EXPECT_CALL(mock_io_uring, registerFileTable(IoUringWorkerImpl::RegisteredFileTableSize))
+      .WillOnce(Return(true));
+  EXPECT_CALL(mock_io_uring, registerEventfd());
+  EXPECT_CALL(dispatcher,
+              createFileEvent_(_, _, Event::PlatformDefaultTriggerType, Event::FileReadyType::Read))
+      .WillOnce(
+          DoAll(SaveArg<1>(&file_event_callback), ReturnNew<NiceMock<Event::MockFileEvent>>()));
+  IoUringWorkerImpl worker(std::move(io_uring_instance), 8192, 1000, dispatcher, 16);
+
+  os_fd_t fd = 11;
+  Request* accept_req = nullptr;
+  EXPECT_CALL(mock_io_uring, registerFile(fd));
+  EXPECT_CALL(mock_io_uring, prepareAcceptMultishot(fd, _))
+      .WillOnce(DoAll(SaveArg<1>(&accept_req), Return<IoUringResult>(IoUringResult::Ok)));
+  EXPECT_CALL(mock_io_uring, submit()).Times(1).RetiresOnSaturation();
+  IoUringSocket& socket =
+      worker.addAcceptSocket(fd, [](uint32_t) { return absl::OkStatus(); });
+
+  // The file is unregistered as soon as the socket is closed, before the accept request is
+  // cancelled, since the owner of a kept open descriptor may close it at any time.
+  Request* cancel_req = nullptr;
+  {
+    testing::InSequence sequence;
+    EXPECT_CALL(mock_io_uring, unregisterFile(fd));
+    EXPECT_CALL(mock_io_uring, prepareCancel(accept_req, _))
+        .WillOnce(DoAll(SaveArg<1>(&cancel_req), Return<IoUringResult>(IoUringResult::Ok)));
+    EXPECT_CALL(mock_io_uring, submit());
+  }
+  socket.close(true);
+
+  EXPECT_CALL(mock_io_uring, forEveryCompletion(_))
+      .WillOnce(Invoke([&accept_req, &cancel_req](const CompletionCb& cb) {
+        accept_req->setCompletionFlags(0);
+        cb(accept_req, -ECANCELED, false);
+        cb(cancel_req, 0, false);
+      }));
+  EXPECT_CALL(mock_io_uring, prepareClose(_, _)).Times(0);
+  EXPECT_CALL(mock_io_uring, removeInjectedCompletion(fd));
+  EXPECT_CALL(mock_io_uring, unregisterFile(fd));
+  EXPECT_CALL(dispatcher, deferredDelete_);
+  EXPECT_CALL(dispatcher, clearDeferredDeleteList());
+  EXPECT_CALL(mock_io_uring, submit()).Times(1).RetiresOnSaturation();
+  ASSERT_TRUE(file_event_callback(Event::FileReadyType::Read).ok());
+}
+
 TEST(IoUringWorkerImplTest, CloseAllSocketsWhenDestruction) {
   Event::MockDispatcher dispatcher;
   IoUringPtr io_uring_instance = std::make_unique<MockIoUring>();
@@ -496,7 +810,7 @@ TEST(IoUringWorkerImplTest, CloseDetected) {
       .WillOnce(DoAll(SaveArg<4>(&read_req2), Return<IoUringResult>(IoUringResult::Ok)));
   EXPECT_CALL(mock_io_uring, submit()).Times(1).RetiresOnSaturation();
   socket.onRead(read_req, 1, false);
-  socket.onRead(nullptr, 0, false);
+  socket.onRead(read_req2, 0, false);
 
   EXPECT_CALL(dispatcher, clearDeferredDeleteList());
   delete read_req;
@@ -291,6 +291,45 @@ TEST_F(JsonSanitizerTest, InvalidUtf8) {
   EXPECT_FALSE(TestUtil::isProtoSerializableUtf8("\020\377\377\376\000"));
 }
 
+TEST_F(JsonSanitizerTest, AppendEscaped) {
+  auto escape = [](absl::string_view str) {
+    std::string output = "prefix:";
+    appendEscaped(output, str);
+    return output.substr(7);
+  };
+  EXPECT_EQ("", escape(""));
+  EXPECT_EQ("Hello world, Καλημέρα κόσμε", escape("Hello world, Καλημέρα κόσμε"));
+  EXPECT_EQ("a\\\"b\\\\c\\u0001\\n", escape("a\"b\\c\001\n"));
+
+  // Every 7-bit character at every position of a string spanning more than one vector, compared
+  // with sanitize().
+  for (uint32_t i = 0; i < 128; ++i) {
+    for (size_t pos = 0; pos < 40; ++pos) {
+      std::string str(40, 'x');
+      str[pos] = static_cast<char>(i);
+      EXPECT_EQ(sanitize(str), escape(str)) << "char " << i << " at " << pos;
+    }
+  }
+
+  // Valid utf-8 sequences are copied as they are, also in a string spanning more than one vector.
+  EXPECT_EQ(LambdaUtf8, escape(LambdaUtf8));
+  EXPECT_EQ(TrebleClefUtf8, escape(TrebleClefUtf8));
+  const std::string long_utf8 = absl::StrCat(std::string(20, 'x'), TrebleClefUtf8, "\n");
+  EXPECT_EQ(absl::StrCat(std::string(20, 'x'), TrebleClefUtf8, "\\n"), escape(long_utf8));
+
+  // Invalid ones are replaced with U+FFFD, once per maximal subpart.
+  const std::string replacement = "\xef\xbf\xbd";
+  EXPECT_EQ(absl::StrCat("a", replacement, "b"),
+            escape(absl::StrCat("a", truncate(TrebleClefUtf8), "b")));
+  EXPECT_EQ(replacement, escape(truncate(TrebleClefUtf8)));
+  EXPECT_EQ(absl::StrCat(replacement, replacement), escape("\x80\xff"));
+  // Overlong encoding of '/'.
+  EXPECT_EQ(absl::StrCat(replacement, replacement), escape("\xc0\xaf"));
+  // Encoded surrogate U+D800.
+  EXPECT_EQ(absl::StrCat(replacement, replacement, replacement), escape("\xed\xa0\x80"));
+  // Lead byte followed by an escaped character.
+  EXPECT_EQ(absl::StrCat(replacement, "\\\""), escape("\xc3\""));
+}
 } // namespace
 } // namespace Json
 } // namespace Envoy
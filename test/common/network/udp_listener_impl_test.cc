@@ -20,6 +20,7 @@
 #include "test/mocks/network/mocks.h"
 #include "test/test_common/environment.h"
 #include "test/test_common/network_utility.h"
+#include "test/test_common/test_runtime.h"
 #include "test/test_common/threadsafe_singleton_injector.h"
 #include "test/test_common/utility.h"
 
@@ -98,6 +99,10 @@ public:
     ON_CALL(listener_callbacks_, udpPacketWriter()).WillByDefault(ReturnRef(*udp_packet_writer_));
   }
 
+#ifdef UDP_GRO
+  void testUdpGroBasic(bool segments_without_copy);
+#endif
+
   NiceMock<OverrideOsSysCallsImpl> override_syscall_;
   TestThreadsafeSingletonInjector<Api::OsSysCallsImpl> os_calls{&override_syscall_};
   bool recvbuf_large_enough_{true};
@@ -618,7 +623,10 @@ TEST_P(UdpListenerImplTest, SendDataError) {
  * when UDP GRO is enabled on the platform.
  */
 #ifdef UDP_GRO
-TEST_P(UdpListenerImplTest, UdpGroBasic) {
+void UdpListenerImplTest::testUdpGroBasic(bool segments_without_copy) {
+  TestScopedRuntime scoped_runtime;
+  scoped_runtime.mergeValues({{"envoy.reloadable_features.udp_gro_segments_without_copy",
+                               segments_without_copy ? "true" : "false"}});
   setup(true);
 
   // We send 4 packets (3 of equal length and 1 as a trail), which are concatenated together by
@@ -721,6 +729,7 @@ TEST_P(UdpListenerImplTest, UdpGroBasic) {
       .WillRepeatedly(Return(Api::SysCallSizeResult{-1, EAGAIN}));
 
   EXPECT_CALL(listener_callbacks_, onReadReady()).WillOnce(Invoke([&]() { dispatcher_->exit(); }));
+  const char* previous_segment = nullptr;
   EXPECT_CALL(listener_callbacks_, onData(_))
       .Times(4u)
       .WillRepeatedly(Invoke([&](const UdpRecvData& data) -> void {
@@ -728,6 +737,16 @@ TEST_P(UdpListenerImplTest, UdpGroBasic) {
 
         const std::string data_str = data.buffer_->toString();
         EXPECT_EQ(data_str, client_data[num_packets_received_by_listener_ - 1]);
+
+        if (!segments_without_copy) {
+          return;
+        }
+        // Each packet refers to its segment of the buffer read by recvmsg.
+        const char* segment = static_cast<const char*>(data.buffer_->frontSlice().mem_);
+        if (previous_segment != nullptr) {
+          EXPECT_EQ(previous_segment + 8, segment);
+        }
+        previous_segment = segment;
       }));
 
   EXPECT_CALL(listener_callbacks_, onWriteReady(_)).WillOnce(Invoke([&](const Socket& socket) {
@@ -737,6 +756,10 @@ TEST_P(UdpListenerImplTest, UdpGroBasic) {
   dispatcher_->run(Event::Dispatcher::RunType::Block);
 }
 
+TEST_P(UdpListenerImplTest, UdpGroBasic) { testUdpGroBasic(false); }
+
+TEST_P(UdpListenerImplTest, UdpGroBasicSegmentsWithoutCopy) { testUdpGroBasic(true); }
+
 TEST_P(UdpListenerImplTest, GroLargeDatagramRecvmsgNoDrop) {
   if (!Runtime::runtimeFeatureEnabled(
           "envoy.reloadable_features.udp_socket_apply_aggregated_read_limit")) {
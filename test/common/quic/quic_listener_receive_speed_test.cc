@@ -0,0 +1,123 @@
+#include <memory>
+#include <string>
+
+#include "source/common/api/os_sys_calls_impl.h"
+#include "source/common/buffer/buffer_impl.h"
+#include "source/common/common/utility.h"
+#include "source/common/network/socket_impl.h"
+#include "source/common/network/socket_option_factory.h"
+#include "source/common/network/utility.h"
+#include "source/common/quic/udp_gso_batch_writer.h"
+#include "source/common/runtime/runtime_features.h"
+#include "source/common/stats/isolated_store_impl.h"
+
+#include "benchmark/benchmark.h"
+#include "quiche/quic/core/quic_packets.h"
+
+namespace Envoy {
+namespace Quic {
+namespace {
+
+// A local QUIC load generator for the receive path of the QUIC listener. Bursts of QUIC sized
+// short header packets are sent with UDP GSO, so that a receiver with UDP GRO enabled reads each
+// burst with a single recvmsg call. Each packet is then handed to QUICHE as a view of the received
+// buffer, the way ActiveQuicListener::onDataWorker() does.
+constexpr size_t QuicPacketSize = 1200;
+
+class QuicPacketReceiver : public Network::UdpPacketProcessor {
+public:
+  explicit QuicPacketReceiver(size_t burst) : burst_(burst) {}
+
+  // Network::UdpPacketProcessor
+  void processPacket(Network::Address::InstanceConstSharedPtr,
+                     Network::Address::InstanceConstSharedPtr, Buffer::InstancePtr buffer,
+                     MonotonicTime, uint8_t, Buffer::RawSlice) override {
+    const Buffer::RawSlice slice = buffer->frontSlice();
+    quic::QuicReceivedPacket packet(static_cast<const char*>(slice.mem_), slice.len_,
+                                    quic::QuicTime::Zero());
+    benchmark::DoNotOptimize(packet.data()[0]);
+    packets_received_++;
+  }
+  void onDatagramsDropped(uint32_t dropped) override { packets_dropped_ += dropped; }
+  uint64_t maxDatagramSize() const override { return Network::DEFAULT_UDP_MAX_DATAGRAM_SIZE; }
+  size_t numPacketsExpectedPerEventLoop() const override { return burst_; }
+  const Network::IoHandle::UdpSaveCmsgConfig& saveCmsgConfig() const override {
+    return save_cmsg_config_;
+  }
+
+  const size_t burst_;
+  const Network::IoHandle::UdpSaveCmsgConfig save_cmsg_config_{};
+  uint64_t packets_received_{};
+  uint64_t packets_dropped_{};
+};
+
+// Sends bursts of `range(1)` packets and receives them, with the GRO buffer copied into one buffer
+// per packet if `range(0)` is 0, and referenced by each packet otherwise.
+void bmQuicListenerReceive(benchmark::State& state) {
+  if (!Api::OsSysCallsSingleton::get().supportsUdpGro() ||
+      !Api::OsSysCallsSingleton::get().supportsUdpGso()) {
+    state.SkipWithError("UDP GRO or GSO is not supported by the kernel");
+    return;
+  }
+  Runtime::maybeSetRuntimeGuard("envoy.reloadable_features.udp_gro_segments_without_copy",
+                                state.range(0) != 0);
+  const size_t burst = state.range(1);
+
+  const auto loopback = Network::Utility::parseInternetAddressAndPortNoThrow("127.0.0.1:0");
+  Network::SocketImpl listen_socket(Network::Socket::Type::Datagram, loopback, nullptr,
+                                    Network::SocketCreationOptions{});
+  RELEASE_ASSERT(listen_socket.bind(loopback).return_value_ == 0, "");
+  RELEASE_ASSERT(Network::Socket::applyOptions(Network::SocketOptionFactory::buildUdpGroOptions(),
+                                               listen_socket,
+                                               envoy::config::core::v3::SocketOption::STATE_BOUND),
+                 "");
+  const Network::Address::InstanceConstSharedPtr listen_address =
+      listen_socket.ioHandle().localAddress();
+
+  Network::SocketImpl client_socket(Network::Socket::Type::Datagram, listen_address, nullptr,
+                                    Network::SocketCreationOptions{});
+  Stats::IsolatedStoreImpl stats_store;
+  UdpGsoBatchWriter client_writer(client_socket.ioHandle(), *stats_store.rootScope());
+  // A short header packet: the fixed bit, followed by the destination connection ID.
+  std::string packet_data(QuicPacketSize, 'a');
+  packet_data[0] = 0x40;
+  const Buffer::OwnedImpl packet(packet_data);
+
+  QuicPacketReceiver receiver(burst);
+  RealTimeSource time_source;
+  for (auto _ : state) {
+    UNREFERENCED_PARAMETER(_);
+    for (size_t i = 0; i < burst; i++) {
+      client_writer.writePacket(packet, nullptr, *listen_address);
+    }
+    client_writer.flush();
+
+    const uint64_t expected_packets = receiver.packets_received_ + burst;
+    // Loopback delivers the packets before sendmsg returns, unless the receive buffer overflows.
+    for (int reads = 0; receiver.packets_received_ + receiver.packets_dropped_ < expected_packets;
+         reads++) {
+      if (reads == 100) {
+        state.SkipWithError("packets were lost on the loopback interface");
+        return;
+      }
+      uint32_t packets_dropped = 0;
+      const Api::IoErrorPtr result = Network::Utility::readPacketsFromSocket(
+          listen_socket.ioHandle(), *listen_address, receiver, time_source, /*allow_gro=*/true,
+          /*allow_mmsg=*/false, packets_dropped);
+      if (result != nullptr && result->getErrorCode() != Api::IoError::IoErrorCode::Again) {
+        state.SkipWithError("failed to read from the listen socket");
+        return;
+      }
+    }
+  }
+  state.SetItemsProcessed(receiver.packets_received_);
+  state.counters["packets_dropped"] = receiver.packets_dropped_;
+}
+BENCHMARK(bmQuicListenerReceive)
+    ->ArgsProduct({{0, 1}, {1, 8, 16}})
+    ->Unit(benchmark::kMicrosecond)
+    ->UseRealTime();
+
+} // namespace
+} // namespace Quic
+} // namespace Envoy
@@ -0,0 +1,138 @@
+#include "envoy/config/route/v3/route_components.pb.h"
+
+#include "source/common/router/compiled_route_matcher.h"
+
+#include "test/mocks/server/server_factory_context.h"
+#include "test/test_common/utility.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Router {
+namespace {
+
+using testing::ElementsAre;
+using testing::IsEmpty;
+using testing::NiceMock;
+
+class CompiledRouteMatcherTest : public testing::Test {
+protected:
+  void addRoutes(const std::string& yaml) {
+    envoy::config::route::v3::VirtualHost virtual_host;
+    TestUtility::loadFromYaml(yaml, virtual_host);
+    routes_ = virtual_host.routes();
+  }
+
+  CompiledRouteMatcher::CandidateVector candidates(absl::string_view path,
+                                                   bool ignore_path_parameters = false) {
+    CompiledRouteMatcher matcher(routes_, ignore_path_parameters, factory_context_);
+    CompiledRouteMatcher::CandidateVector out;
+    matcher.candidates(path, out);
+    return out;
+  }
+
+  NiceMock<Server::Configuration::MockServerFactoryContext> factory_context_;
+  Protobuf::RepeatedPtrField<envoy::config::route::v3::Route> routes_;
+};
+
+TEST(RoutePathTrieTest, CollectsPrefixesAndExactPaths) {
+  RoutePathTrie trie;
+  EXPECT_TRUE(trie.empty());
+  trie.addPrefix("/", 0);
+  trie.addPrefix("/foo", 1);
+  trie.addExact("/foo", 2);
+  trie.addPrefix("/foo/bar", 3);
+  trie.addPrefix("/fob", 4);
+  EXPECT_FALSE(trie.empty());
+
+  absl::InlinedVector<uint32_t, 16> out;
+  trie.collect("/foo", out);
+  EXPECT_THAT(out, ElementsAre(0, 1, 2));
+
+  out.clear();
+  trie.collect("/foo/bar/baz", out);
+  EXPECT_THAT(out, ElementsAre(0, 1, 3));
+
+  out.clear();
+  trie.collect("/other", out);
+  EXPECT_THAT(out, ElementsAre(0));
+
+  out.clear();
+  trie.collect("", out);
+  EXPECT_THAT(out, IsEmpty());
+}
+
+TEST_F(CompiledRouteMatcherTest, CandidatesAreOrdered) {
+  addRoutes(R"EOF(
+name: test
+domains: ["*"]
+routes:
+- match: { prefix: "/api" }
+  route: { cluster: a }
+- match: { safe_regex: { regex: "/api/[0-9]+" } }
+  route: { cluster: b }
+- match: { path: "/api/1" }
+  route: { cluster: c }
+- match: { connect_matcher: {} }
+  route: { cluster: d }
+- match: { prefix: "/API/", case_sensitive: false }
+  route: { cluster: e }
+- match: { path_separated_prefix: "/api" }
+  route: { cluster: f }
+)EOF");
+
+  EXPECT_THAT(candidates("/api/1"), ElementsAre(0, 1, 2, 3, 4, 5));
+  EXPECT_THAT(candidates("/api/1?query=/x#fragment"), ElementsAre(0, 1, 2, 3, 4, 5));
+  EXPECT_THAT(candidates("/api/x"), ElementsAre(0, 3, 4, 5));
+  EXPECT_THAT(candidates("/Api/X"), ElementsAre(3, 4));
+  EXPECT_THAT(candidates("/other"), ElementsAre(3));
+}
+
+TEST_F(CompiledRouteMatcherTest, PrefixWithQueryOrFragmentIsAlwaysCandidate) {
+  addRoutes(R"EOF(
+name: test
+domains: ["*"]
+routes:
+- match: { prefix: "/foo" }
+  route: { cluster: a }
+- match: { prefix: "/foo?bar" }
+  route: { cluster: b }
+- match: { prefix: "/foo#bar" }
+  route: { cluster: c }
+- match: { prefix: "/foo;bar" }
+  route: { cluster: d }
+)EOF");
+
+  EXPECT_THAT(candidates("/foo?bar=1"), ElementsAre(0, 1, 2));
+  EXPECT_THAT(candidates("/other?bar=1"), ElementsAre(1, 2));
+}
+
+TEST_F(CompiledRouteMatcherTest, PrefixWithPathParametersIsAlwaysCandidateWhenIgnored) {
+  addRoutes(R"EOF(
+name: test
+domains: ["*"]
+routes:
+- match: { prefix: "/foo;bar" }
+  route: { cluster: a }
+)EOF");
+
+  EXPECT_THAT(candidates("/other", true), ElementsAre(0));
+}
+
+TEST_F(CompiledRouteMatcherTest, IgnorePathParameters) {
+  addRoutes(R"EOF(
+name: test
+domains: ["*"]
+routes:
+- match: { path: "/foo" }
+  route: { cluster: a }
+)EOF");
+
+  EXPECT_THAT(candidates("/foo;bar"), IsEmpty());
+  EXPECT_THAT(candidates("/foo;bar", true), ElementsAre(0));
+}
+
+} // namespace
+} // namespace Router
+} // namespace Envoy
@@ -479,6 +479,113 @@ virtual_hosts:
             config.route(genHeaders("bat5.com", " ", "CONNECT"), 0)->routeEntry()->clusterName());
 }
 
+// Verify that the compiled route matcher picks the same route as the linear scan.
+TEST_F(RouteMatcherTest, CompiledRouteMatcherKeepsFirstMatchSemantics) {
+  const std::string yaml = R"EOF(
+virtual_hosts:
+- name: default
+  domains:
+  - "*"
+  routes:
+  - match:
+      prefix: "/api/v1/users"
+      headers:
+      - name: x-canary
+        present_match: true
+    route:
+      cluster: canary
+  - match:
+      path: "/api/v1/users/me"
+    route:
+      cluster: exact
+  - match:
+      safe_regex:
+        regex: "/api/v[0-9]+/users/[0-9]+"
+    route:
+      cluster: regex
+  - match:
+      prefix: "/API/V2"
+      case_sensitive: false
+    route:
+      cluster: insensitive
+  - match:
+      path_separated_prefix: "/api/v1/items"
+    route:
+      cluster: separated
+  - match:
+      prefix: "/api/v1"
+    route:
+      cluster: prefix
+  - match:
+      connect_matcher: {}
+    route:
+      cluster: connect
+  - match:
+      prefix: "/"
+    route:
+      cluster: fallback
+  )EOF";
+
+  factory_context_.cluster_manager_.initializeClusters({"canary", "exact", "regex", "insensitive",
+                                                        "separated", "prefix", "connect",
+                                                        "fallback"},
+                                                       {});
+  TestConfigImpl linear(parseRouteConfigurationFromYaml(yaml), factory_context_, true,
+                        creation_status_);
+  mergeValues({{"envoy.reloadable_features.compiled_route_matcher", "true"}});
+  TestConfigImpl compiled(parseRouteConfigurationFromYaml(yaml), factory_context_, true,
+                          creation_status_);
+
+  const std::vector<std::pair<std::string, std::string>> cases = {
+      {"/api/v1/users/me", "exact"},
+      {"/api/v1/users/me?x=1", "exact"},
+      {"/api/v1/users/42", "regex"},
+      {"/api/v7/users/42", "regex"},
+      {"/api/v2/items", "insensitive"},
+      {"/Api/V2/Items", "insensitive"},
+      {"/api/v1/items", "separated"},
+      {"/api/v1/items/1", "separated"},
+      {"/api/v1/itemsx", "prefix"},
+      {"/api/v1/users", "prefix"},
+      {"/other", "fallback"},
+      {"/", "fallback"},
+  };
+  for (const auto& [path, cluster] : cases) {
+    SCOPED_TRACE(path);
+    EXPECT_EQ(cluster,
+              linear.route(genHeaders("www.lyft.com", path, "GET"), 0)->routeEntry()->clusterName());
+    EXPECT_EQ(cluster, compiled.route(genHeaders("www.lyft.com", path, "GET"), 0)
+                           ->routeEntry()
+                           ->clusterName());
+  }
+
+  // Earlier routes that fail on non-path criteria fall through to the next candidate.
+  Http::TestRequestHeaderMapImpl canary_headers =
+      genHeaders("www.lyft.com", "/api/v1/users/me", "GET");
+  canary_headers.addCopy("x-canary", "1");
+  EXPECT_EQ("canary", compiled.route(canary_headers, 0)->routeEntry()->clusterName());
+
+  // Pathless requests are still served by routes which support them.
+  EXPECT_EQ("connect", compiled.route(genPathlessHeaders("www.lyft.com", "CONNECT"), 0)
+                           ->routeEntry()
+                           ->clusterName());
+
+  // The route callback observes the same evaluation status as with the linear scan.
+  std::vector<std::pair<std::string, RouteEvalStatus>> linear_evals;
+  std::vector<std::pair<std::string, RouteEvalStatus>> compiled_evals;
+  auto record = [](std::vector<std::pair<std::string, RouteEvalStatus>>& evals) {
+    return [&evals](RouteConstSharedPtr route, RouteEvalStatus status) -> RouteMatchStatus {
+      evals.emplace_back(route->routeEntry()->clusterName(), status);
+      return RouteMatchStatus::Continue;
+    };
+  };
+  linear.route(record(linear_evals), genHeaders("www.lyft.com", "/api/v1/users/1", "GET"));
+  compiled.route(record(compiled_evals), genHeaders("www.lyft.com", "/api/v1/users/1", "GET"));
+  EXPECT_EQ(linear_evals, compiled_evals);
+  EXPECT_EQ(3, compiled_evals.size());
+  EXPECT_EQ(RouteEvalStatus::NoMoreRoutes, compiled_evals.back().second);
+}
+
 TEST_F(RouteMatcherTest, TestRoutes) {
   const std::string yaml = R"EOF(
 virtual_hosts:
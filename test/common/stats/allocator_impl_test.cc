@@ -137,6 +137,149 @@ TEST_F(AllocatorImplTest, RefCountDecAllocRaceSynchronized) {
   EXPECT_FALSE(alloc_.isMutexLockedForTest());
 }
 
+class ShardedAllocatorImplTest : public AllocatorImplTest {
+protected:
+  ShardedAllocatorImplTest() { alloc_.setShardCount(5, nullptr); }
+};
+
+TEST_F(ShardedAllocatorImplTest, ShardCountIsRounded) {
+  EXPECT_EQ(8, alloc_.shardCount());
+  alloc_.setShardCount(1, nullptr);
+  EXPECT_EQ(0, alloc_.shardCount());
+  alloc_.setShardCount(1000, nullptr);
+  EXPECT_EQ(AllocatorImpl::MaxShardCount, alloc_.shardCount());
+}
+
+// The shard count is specific to each allocator.
+TEST_F(ShardedAllocatorImplTest, ShardCountIsPerAllocator) {
+  AllocatorImpl other(symbol_table_);
+  EXPECT_EQ(0, other.shardCount());
+  EXPECT_EQ(8, alloc_.shardCount());
+}
+
+// Resetting a counter also drops the increments which were not latched yet.
+TEST_F(ShardedAllocatorImplTest, CounterResetClearsPending) {
+  CounterSharedPtr counter = alloc_.makeCounter(makeStat("counter.name"), StatName(), {});
+  counter->add(5);
+  counter->reset();
+  EXPECT_EQ(0, counter->value());
+  EXPECT_EQ(0, counter->latch());
+  counter->add(2);
+  EXPECT_EQ(2, counter->value());
+  EXPECT_EQ(2, counter->latch());
+}
+
+// Counters and gauges updated from many threads add up to the same values as unsharded ones.
+TEST_F(ShardedAllocatorImplTest, ConcurrentUpdates) {
+  CounterSharedPtr counter = alloc_.makeCounter(makeStat("counter.name"), StatName(), {});
+  GaugeSharedPtr gauge = alloc_.makeGauge(makeStat("gauge.name"), StatName(), {},
+                                          Gauge::ImportMode::Accumulate);
+  EXPECT_FALSE(counter->used());
+  EXPECT_FALSE(gauge->used());
+
+  Thread::ThreadFactory& thread_factory = Thread::threadFactoryForTest();
+  const uint32_t num_threads = 12;
+  const uint32_t iters = 10000;
+  std::vector<Thread::ThreadPtr> threads;
+  absl::Notification go;
+  for (uint32_t i = 0; i < num_threads; ++i) {
+    threads.push_back(thread_factory.createThread([&]() {
+      go.WaitForNotification();
+      for (uint32_t i = 0; i < iters; ++i) {
+        counter->inc();
+        gauge->add(2);
+        gauge->dec();
+      }
+    }));
+  }
+  go.Notify();
+  for (uint32_t i = 0; i < num_threads; ++i) {
+    threads[i]->join();
+  }
+
+  EXPECT_TRUE(counter->used());
+  EXPECT_TRUE(gauge->used());
+  EXPECT_EQ(num_threads * iters, counter->value());
+  EXPECT_EQ(num_threads * iters, counter->latch());
+  EXPECT_EQ(0, counter->latch());
+  EXPECT_EQ(num_threads * iters, gauge->value());
+}
+
+// A gauge incremented on one thread and decremented on another still sums up correctly.
+TEST_F(ShardedAllocatorImplTest, GaugeCrossThread) {
+  GaugeSharedPtr gauge = alloc_.makeGauge(makeStat("gauge.name"), StatName(), {},
+                                          Gauge::ImportMode::Accumulate);
+  gauge->add(10);
+  Thread::ThreadPtr thread =
+      Thread::threadFactoryForTest().createThread([&gauge]() { gauge->sub(4); });
+  thread->join();
+  EXPECT_EQ(6, gauge->value());
+
+  gauge->setParentValue(5);
+  EXPECT_EQ(11, gauge->value());
+  gauge->set(3);
+  EXPECT_EQ(8, gauge->value());
+}
+
+// Adds made concurrently with a set() are counted either before or after it, never lost.
+TEST_F(ShardedAllocatorImplTest, GaugeSetConcurrentWithAdds) {
+  GaugeSharedPtr gauge = alloc_.makeGauge(makeStat("gauge.name"), StatName(), {},
+                                          Gauge::ImportMode::Accumulate);
+  const uint32_t iters = 10000;
+  absl::Notification go;
+  Thread::ThreadPtr thread = Thread::threadFactoryForTest().createThread([&]() {
+    go.WaitForNotification();
+    for (uint32_t i = 0; i < iters; ++i) {
+      gauge->inc();
+    }
+  });
+  go.Notify();
+  gauge->set(iters);
+  thread->join();
+  EXPECT_GE(gauge->value(), iters);
+  EXPECT_LE(gauge->value(), 2 * iters);
+  // All the adds made after the set() are counted.
+  gauge->set(5);
+  thread = Thread::threadFactoryForTest().createThread([&]() { gauge->add(iters); });
+  thread->join();
+  EXPECT_EQ(iters + 5, gauge->value());
+}
+
+// The predicate sees the names of the new counters and gauges.
+TEST_F(AllocatorImplTest, ShardedStatPredicate) {
+  std::vector<std::string> names;
+  alloc_.setShardCount(4, [&names](absl::string_view name) {
+    names.emplace_back(name);
+    return name == "cluster.hot.upstream_rq_total";
+  });
+  CounterSharedPtr hot =
+      alloc_.makeCounter(makeStat("cluster.hot.upstream_rq_total"), StatName(), {});
+  GaugeSharedPtr cold = alloc_.makeGauge(makeStat("cluster.cold.upstream_rq_active"), StatName(),
+                                         {}, Gauge::ImportMode::Accumulate);
+  alloc_.setShardCount(0, nullptr);
+  alloc_.makeCounter(makeStat("cluster.other.upstream_rq_total"), StatName(), {});
+
+  EXPECT_THAT(names, testing::ElementsAre("cluster.hot.upstream_rq_total",
+                                          "cluster.cold.upstream_rq_active"));
+  hot->add(3);
+  cold->add(4);
+  EXPECT_EQ(3, hot->value());
+  EXPECT_EQ(4, cold->value());
+}
+
+TEST_F(ShardedAllocatorImplTest, CounterReset) {
+  CounterSharedPtr counter = alloc_.makeCounter(makeStat("counter.name"), StatName(), {});
+  counter->add(5);
+  Thread::ThreadPtr thread =
+      Thread::threadFactoryForTest().createThread([&counter]() { counter->add(7); });
+  thread->join();
+  EXPECT_EQ(12, counter->value());
+  counter->reset();
+  EXPECT_EQ(0, counter->value());
+  // Resetting the value doesn't drop what is pending for the sinks.
+  EXPECT_EQ(12, counter->latch());
+}
+
 TEST_F(AllocatorImplTest, HiddenGauge) {
   GaugeSharedPtr hidden_gauge =
       alloc_.makeGauge(makeStat("hidden"), StatName(), {}, Gauge::ImportMode::HiddenAccumulate);
@@ -0,0 +1,92 @@
+#include <vector>
+
+#include "source/common/stats/hybrid_histogram.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Stats {
+namespace {
+
+class HybridHistogramTest : public testing::Test {
+protected:
+  HybridHistogramTest() : expected_(hist_alloc()), actual_(hist_alloc()) {}
+  ~HybridHistogramTest() override {
+    hist_free(expected_);
+    hist_free(actual_);
+  }
+
+  void record(uint64_t value) {
+    hist_insert_intscale(expected_, value, 0, 1);
+    hybrid_.recordValue(value);
+  }
+
+  // Drain the hybrid histogram and compare it, bucket by bucket, with circllhist.
+  void drainAndCompare() {
+    hybrid_.drainInto(actual_);
+    EXPECT_TRUE(hybrid_.empty());
+    ASSERT_EQ(hist_num_buckets(expected_), hist_num_buckets(actual_));
+    for (int i = 0; i < hist_num_buckets(expected_); ++i) {
+      hist_bucket_t expected_bucket, actual_bucket;
+      uint64_t expected_count, actual_count;
+      hist_bucket_idx_bucket(expected_, i, &expected_bucket, &expected_count);
+      hist_bucket_idx_bucket(actual_, i, &actual_bucket, &actual_count);
+      EXPECT_EQ(expected_bucket.val, actual_bucket.val);
+      EXPECT_EQ(expected_bucket.exp, actual_bucket.exp);
+      EXPECT_EQ(expected_count, actual_count);
+    }
+  }
+
+  HybridHistogram hybrid_;
+  histogram_t* expected_;
+  histogram_t* actual_;
+};
+
+TEST_F(HybridHistogramTest, Empty) {
+  EXPECT_TRUE(hybrid_.empty());
+  drainAndCompare();
+  EXPECT_EQ(0, hist_num_buckets(actual_));
+}
+
+TEST_F(HybridHistogramTest, SparseOnly) {
+  record(0);
+  record(1);
+  record(1);
+  record(150);
+  record(123456789);
+  EXPECT_FALSE(hybrid_.empty());
+  EXPECT_EQ(0, hybrid_.denseDecades());
+  drainAndCompare();
+}
+
+TEST_F(HybridHistogramTest, PromoteHotDecade) {
+  for (uint64_t value = 100; value < 100 + 10 * HybridHistogram::PromoteThreshold; value += 10) {
+    record(value);
+  }
+  EXPECT_EQ(1, hybrid_.denseDecades());
+  record(105);
+  record(990);
+  drainAndCompare();
+
+  // Dense storage is kept across drains, and only the buckets changed since are drained.
+  EXPECT_EQ(1, hybrid_.denseDecades());
+  record(110);
+  record(110);
+  record(7);
+  drainAndCompare();
+}
+
+TEST_F(HybridHistogramTest, ManyDecades) {
+  for (uint64_t scale = 1; scale < 1000000000000; scale *= 10) {
+    for (uint64_t value = scale; value < 10 * scale; value += scale / 2 + 1) {
+      record(value);
+    }
+  }
+  EXPECT_GT(hybrid_.denseDecades(), 1);
+  drainAndCompare();
+  drainAndCompare();
+}
+
+} // namespace
+} // namespace Stats
+} // namespace Envoy
@@ -86,6 +86,29 @@ private:
   std::vector<std::unique_ptr<Stats::StatNameManagedStorage>> stat_names_;
 };
 
+// Owns a hot cluster counter and gauge shared by the threads of the contended benchmarks below.
+class ContendedStatsPerf {
+public:
+  explicit ContendedStatsPerf(uint32_t shard_count) : alloc_(symbol_table_), store_(alloc_) {
+    alloc_.setShardCount(shard_count, nullptr);
+    counter_ = &store_.rootScope()->counterFromString("cluster.hot.upstream_rq_total");
+    gauge_ = &store_.rootScope()->gaugeFromString("cluster.hot.upstream_rq_active",
+                                                   Stats::Gauge::ImportMode::Accumulate);
+  }
+
+  ~ContendedStatsPerf() { store_.shutdownThreading(); }
+
+  Stats::Counter& counter() { return *counter_; }
+  Stats::Gauge& gauge() { return *gauge_; }
+
+private:
+  Stats::SymbolTableImpl symbol_table_;
+  Stats::AllocatorImpl alloc_;
+  Stats::ThreadLocalStoreImpl store_;
+  Stats::Counter* counter_;
+  Stats::Gauge* gauge_;
+};
+
 } // namespace Envoy
 
 // Tests the single-threaded performance of the thread-local-store stats caches
@@ -140,3 +163,47 @@ BENCHMARK(BM_StatsWithTlsAndRejectionsWithoutDot);
 
 // TODO(jmarantz): add multi-threaded variant of this test, that aggressively
 // looks up stats in multiple threads to try to trigger contention issues.
+
+// Set up by the first thread of a contended benchmark. The other threads only touch it inside the
+// benchmark loop, which they enter together with the first thread.
+static std::unique_ptr<Envoy::ContendedStatsPerf> contended_perf;
+
+// Tests the scaling of many workers incrementing the same counter, as they do for the hot cluster
+// counters such as upstream_rq_total. The argument is the number of counter shards, where 0 is a
+// single shared value.
+// NOLINTNEXTLINE(readability-identifier-naming)
+static void BM_CounterIncContended(benchmark::State& state) {
+  if (state.thread_index() == 0) {
+    contended_perf = std::make_unique<Envoy::ContendedStatsPerf>(state.range(0));
+  }
+
+  for (auto _ : state) { // NOLINT
+    contended_perf->counter().inc();
+  }
+
+  if (state.thread_index() == 0) {
+    // All threads have left the loop at this point.
+    benchmark::DoNotOptimize(contended_perf->counter().value());
+    contended_perf.reset();
+  }
+}
+BENCHMARK(BM_CounterIncContended)->Arg(0)->Arg(64)->ThreadRange(1, 32)->UseRealTime();
+
+// As above, for a gauge tracking active requests.
+// NOLINTNEXTLINE(readability-identifier-naming)
+static void BM_GaugeIncDecContended(benchmark::State& state) {
+  if (state.thread_index() == 0) {
+    contended_perf = std::make_unique<Envoy::ContendedStatsPerf>(state.range(0));
+  }
+
+  for (auto _ : state) { // NOLINT
+    contended_perf->gauge().inc();
+    contended_perf->gauge().dec();
+  }
+
+  if (state.thread_index() == 0) {
+    benchmark::DoNotOptimize(contended_perf->gauge().value());
+    contended_perf.reset();
+  }
+}
+BENCHMARK(BM_GaugeIncDecContended)->Arg(0)->Arg(64)->ThreadRange(1, 32)->UseRealTime();
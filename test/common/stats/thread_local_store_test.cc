@@ -27,6 +27,7 @@
 #include "test/mocks/stats/mocks.h"
 #include "test/mocks/thread_local/mocks.h"
 #include "test/test_common/logging.h"
+#include "test/test_common/test_runtime.h"
 #include "test/test_common/utility.h"
 
 #include "absl/strings/str_split.h"
@@ -1689,6 +1690,35 @@ TEST_F(HistogramTest, MultiHistogramMultipleMerges) {
   EXPECT_EQ(2, validateMerge());
 }
 
+// Hybrid storage of the thread local histograms yields the same statistics as circllhist, over
+// several merges and with enough distinct values for some decades to be promoted to dense storage.
+TEST_F(HistogramTest, HybridStorageMultipleMerges) {
+  TestScopedRuntime scoped_runtime;
+  scoped_runtime.mergeValues({{"envoy.reloadable_features.hybrid_tls_histograms", "true"}});
+
+  Histogram& h1 = scope_.histogramFromString("h1", Histogram::Unit::Unspecified);
+  Histogram& h2 = scope_.histogramFromString("h2", Histogram::Unit::Unspecified);
+
+  for (uint64_t value = 0; value < 300; value += 7) {
+    expectCallAndAccumulate(h1, value);
+  }
+  expectCallAndAccumulate(h2, 123456789);
+  EXPECT_EQ(2, validateMerge());
+
+  // Values in buckets which were seen before, and in new ones.
+  for (uint64_t value = 5; value < 3000; value += 97) {
+    expectCallAndAccumulate(h1, value);
+  }
+  EXPECT_EQ(2, validateMerge());
+
+  // Nothing recorded, so the interval is empty and the cumulative histogram is unchanged.
+  EXPECT_EQ(2, validateMerge());
+
+  expectCallAndAccumulate(h2, 0);
+  expectCallAndAccumulate(h2, 42);
+  EXPECT_EQ(2, validateMerge());
+}
+
 TEST_F(HistogramTest, BasicScopeHistogramMerge) {
   ScopeSharedPtr scope1 = store_->createScope("scope1.");
 
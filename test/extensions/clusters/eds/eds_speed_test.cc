@@ -115,7 +115,25 @@ public:
   void priorityAndLocalityWeightedHelper(bool ignore_unknown_dynamic_fields, size_t num_hosts,
                                          bool healthy) {
     state_.PauseTiming();
+    auto response = buildResponse(num_hosts, healthy, 1000);
+    // this is what we're actually testing:
+    validation_visitor_.setSkipValidation(ignore_unknown_dynamic_fields);
+    state_.ResumeTiming();
+    deliverResponse(std::move(response), num_hosts);
+  }
 
+  // Loads num_hosts hosts, then times an update which removes one host and adds another.
+  void singleHostUpdateHelper(size_t num_hosts) {
+    state_.PauseTiming();
+    validation_visitor_.setSkipValidation(true);
+    deliverResponse(buildResponse(num_hosts, true, 1000), num_hosts);
+    auto response = buildResponse(num_hosts, true, 1001);
+    state_.ResumeTiming();
+    deliverResponse(std::move(response), num_hosts);
+  }
+
+  std::unique_ptr<envoy::service::discovery::v3::DiscoveryResponse>
+  buildResponse(size_t num_hosts, bool healthy, uint32_t port) {
     envoy::config::endpoint::v3::ClusterLoadAssignment cluster_load_assignment;
     cluster_load_assignment.set_cluster_name("fare");
 
@@ -128,7 +146,6 @@ public:
     locality->set_sub_zone("sub_zone");
     endpoints->mutable_load_balancing_weight()->set_value(1);
 
-    uint32_t port = 1000;
     for (size_t i = 0; i < num_hosts; ++i) {
       auto* lb_endpoint = endpoints->add_lb_endpoints();
       if (healthy) {
@@ -142,15 +159,16 @@ public:
       socket_address->set_port_value((port + i) % 60000);
     }
 
-    // this is what we're actually testing:
-    validation_visitor_.setSkipValidation(ignore_unknown_dynamic_fields);
-
     auto response = std::make_unique<envoy::service::discovery::v3::DiscoveryResponse>();
     response->set_type_url(type_url_);
     response->set_version_info(fmt::format("version-{}", version_++));
     auto* resource = response->mutable_resources()->Add();
     resource->PackFrom(cluster_load_assignment);
-    state_.ResumeTiming();
+    return response;
+  }
+
+  void deliverResponse(std::unique_ptr<envoy::service::discovery::v3::DiscoveryResponse> response,
+                       size_t num_hosts) {
     if (use_unified_mux_) {
       dynamic_cast<Config::XdsMux::GrpcMuxSotw&>(*grpc_mux_)
           .grpcStreamForTest()
@@ -242,3 +260,24 @@ static void healthOnlyUpdate(State& state) {
 }
 
 BENCHMARK(healthOnlyUpdate)->Ranges({{1, 100000}, {false, true}})->Unit(benchmark::kMillisecond);
+
+// Updates replacing a single host of a large cluster, e.g. an endpoint flapping, with and without
+// the reuse of the hosts of unchanged endpoints.
+static void singleHostUpdate(State& state) {
+  Envoy::Thread::MutexBasicLockable lock;
+  Envoy::Logger::Context logging_state(spdlog::level::warn,
+                                       Envoy::Logger::Logger::DEFAULT_LOG_FORMAT, lock, false);
+  Envoy::TestScopedRuntime scoped_runtime;
+  scoped_runtime.mergeValues({{"envoy.reloadable_features.eds_reuse_unchanged_hosts",
+                               state.range(1) ? "true" : "false"}});
+  for (auto _ : state) { // NOLINT: Silences warning about dead store
+    Envoy::Upstream::EdsSpeedTest speed_test(state, false);
+    uint32_t endpoints = skipExpensiveBenchmarks() ? 1 : state.range(0);
+
+    speed_test.singleHostUpdateHelper(endpoints);
+  }
+}
+
+BENCHMARK(singleHostUpdate)
+    ->ArgsProduct({{1000, 50000}, {false, true}})
+    ->Unit(benchmark::kMillisecond);
@@ -386,6 +386,54 @@ TEST_F(EdsTest, EndpointWeightChangeCausesRebuild) {
   EXPECT_EQ(new_hosts[0]->weight(), 31);
 }
 
+// Verify that the hosts of unchanged endpoints are reused by the next update, and that changed
+// endpoints are still updated in place.
+TEST_F(EdsTest, ReuseUnchangedHosts) {
+  TestScopedRuntime scoped_runtime;
+  scoped_runtime.mergeValues({{"envoy.reloadable_features.eds_reuse_unchanged_hosts", "true"}});
+
+  envoy::config::endpoint::v3::ClusterLoadAssignment cluster_load_assignment;
+  cluster_load_assignment.set_cluster_name("fare");
+  auto* endpoints = cluster_load_assignment.add_endpoints();
+  auto add_endpoint = [endpoints](const std::string& address) {
+    auto* socket_address = endpoints->add_lb_endpoints()
+                               ->mutable_endpoint()
+                               ->mutable_address()
+                               ->mutable_socket_address();
+    socket_address->set_address(address);
+    socket_address->set_port_value(80);
+  };
+  add_endpoint("1.2.3.4");
+  add_endpoint("1.2.3.5");
+  add_endpoint("1.2.3.6");
+
+  initialize();
+  doOnConfigUpdateVerifyNoThrow(cluster_load_assignment);
+  EXPECT_TRUE(initialized_);
+  const HostVector initial_hosts = cluster_->prioritySet().hostSetsPerPriority()[0]->hosts();
+  ASSERT_EQ(initial_hosts.size(), 3);
+
+  // Change the weight of the second endpoint, and replace the third one.
+  endpoints->mutable_lb_endpoints(1)->mutable_load_balancing_weight()->set_value(2);
+  endpoints->mutable_lb_endpoints()->RemoveLast();
+  add_endpoint("1.2.3.7");
+  doOnConfigUpdateVerifyNoThrow(cluster_load_assignment);
+  EXPECT_EQ(0UL,
+            stats_.findCounterByString("cluster.name.update_no_rebuild").value().get().value());
+  const HostVector updated_hosts = cluster_->prioritySet().hostSetsPerPriority()[0]->hosts();
+  ASSERT_EQ(updated_hosts.size(), 3);
+  EXPECT_EQ(updated_hosts[0], initial_hosts[0]);
+  EXPECT_EQ(updated_hosts[1], initial_hosts[1]);
+  EXPECT_EQ(updated_hosts[1]->weight(), 2);
+  EXPECT_EQ(updated_hosts[2]->address()->asString(), "1.2.3.7:80");
+
+  // The same update reuses all the hosts, including the one updated in place, without rebuilding.
+  doOnConfigUpdateVerifyNoThrow(cluster_load_assignment);
+  EXPECT_EQ(1UL,
+            stats_.findCounterByString("cluster.name.update_no_rebuild").value().get().value());
+  EXPECT_EQ(cluster_->prioritySet().hostSetsPerPriority()[0]->hosts(), updated_hosts);
+}
+
 // Verify that host weight changes cause a full rebuild.
 TEST_F(EdsTest, DualStackEndpoint) {
   envoy::config::endpoint::v3::ClusterLoadAssignment cluster_load_assignment;
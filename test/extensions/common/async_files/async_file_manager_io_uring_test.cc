@@ -0,0 +1,240 @@
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "envoy/extensions/common/async_files/v3/async_file_manager.pb.h"
+
+#include "source/common/buffer/buffer_impl.h"
+#include "source/common/io/io_uring_impl.h"
+#include "source/extensions/common/async_files/async_file_handle.h"
+#include "source/extensions/common/async_files/async_file_manager.h"
+#include "source/extensions/common/async_files/async_file_manager_factory.h"
+
+#include "test/mocks/server/mocks.h"
+#include "test/test_common/status_utility.h"
+
+#include "absl/status/statusor.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace Common {
+namespace AsyncFiles {
+
+using StatusHelpers::HasStatusCode;
+using StatusHelpers::IsOkAndHolds;
+
+template <typename T> class WaitForResult {
+public:
+  std::function<void(T)> callback() {
+    return [this](T result) { result_.set_value(std::move(result)); };
+  }
+  T getResult() { return result_.get_future().get(); }
+
+private:
+  std::promise<T> result_;
+};
+
+class AsyncFileManagerIoUringTest : public testing::TestWithParam<bool> {
+public:
+  void SetUp() override {
+    if (!Io::isIoUringSupported()) {
+      GTEST_SKIP() << "io_uring is not supported";
+    }
+    singleton_manager_ = std::make_unique<Singleton::ManagerImpl>();
+    factory_ = AsyncFileManagerFactory::singleton(singleton_manager_.get());
+    envoy::extensions::common::async_files::v3::AsyncFileManagerConfig config;
+    config.mutable_io_uring()->set_queue_depth(8);
+    config.mutable_io_uring()->set_direct_io(GetParam());
+    manager_ = factory_->getAsyncFileManager(config);
+  }
+
+  AsyncFileHandle createAnonymousFile() {
+    WaitForResult<absl::StatusOr<AsyncFileHandle>> result;
+    manager_->createAnonymousFile(tmpdir_, result.callback());
+    return result.getResult().value();
+  }
+
+  AsyncFileHandle openExistingFile(absl::string_view filename, AsyncFileManager::Mode mode) {
+    WaitForResult<absl::StatusOr<AsyncFileHandle>> result;
+    manager_->openExistingFile(filename, mode, result.callback());
+    return result.getResult().value();
+  }
+
+  absl::StatusOr<size_t> write(AsyncFileHandle& handle, absl::string_view data, off_t offset) {
+    Buffer::OwnedImpl buffer(data);
+    WaitForResult<absl::StatusOr<size_t>> result;
+    EXPECT_OK(handle->write(buffer, offset, result.callback()));
+    return result.getResult();
+  }
+
+  std::string read(AsyncFileHandle& handle, off_t offset, size_t length) {
+    WaitForResult<absl::StatusOr<Buffer::InstancePtr>> result;
+    EXPECT_OK(handle->read(offset, length, result.callback()));
+    return result.getResult().value()->toString();
+  }
+
+  void close(AsyncFileHandle& handle) {
+    WaitForResult<absl::Status> result;
+    EXPECT_OK(handle->close(result.callback()));
+    EXPECT_OK(result.getResult());
+  }
+
+  // Creates a named file containing contents and returns its name.
+  std::string createFile(absl::string_view contents) {
+    char filename[1024];
+    snprintf(filename, sizeof(filename), "%s/async_file_io_uring.XXXXXX", tmpdir_.c_str());
+    Api::OsSysCalls& posix = Api::OsSysCallsSingleton().get();
+    auto fd = posix.mkstemp(filename);
+    EXPECT_EQ(contents.size(),
+              posix.write(fd.return_value_, contents.data(), contents.size()).return_value_);
+    posix.close(fd.return_value_);
+    files_.push_back(filename);
+    return filename;
+  }
+
+  void TearDown() override {
+    manager_ = nullptr;
+    factory_ = nullptr;
+    for (const std::string& file : files_) {
+      ::unlink(file.c_str());
+    }
+  }
+
+  const char* test_tmpdir = std::getenv("TEST_TMPDIR");
+  std::string tmpdir_ = test_tmpdir ? test_tmpdir : "/tmp";
+  std::unique_ptr<Singleton::ManagerImpl> singleton_manager_;
+  std::shared_ptr<AsyncFileManagerFactory> factory_;
+  std::shared_ptr<AsyncFileManager> manager_;
+  std::vector<std::string> files_;
+};
+
+INSTANTIATE_TEST_SUITE_P(DirectIo, AsyncFileManagerIoUringTest, testing::Bool());
+
+TEST_P(AsyncFileManagerIoUringTest, DescribesConfig) {
+  EXPECT_EQ(manager_->describe(),
+            GetParam() ? "io_uring queue_depth = 8, direct_io" : "io_uring queue_depth = 8");
+}
+
+TEST_P(AsyncFileManagerIoUringTest, WriteReadClose) {
+  AsyncFileHandle handle = createAnonymousFile();
+  EXPECT_THAT(write(handle, "hello", 0), IsOkAndHolds(5U));
+  EXPECT_THAT(write(handle, "p!", 3), IsOkAndHolds(2U));
+  EXPECT_EQ("help!", read(handle, 0, 5));
+  EXPECT_EQ("lp!", read(handle, 2, 3));
+  // Reading past the end of the file returns what there is.
+  EXPECT_EQ("p!", read(handle, 3, 100));
+  close(handle);
+}
+
+TEST_P(AsyncFileManagerIoUringTest, WritesAllSlicesOfAFragmentedBuffer) {
+  AsyncFileHandle handle = createAnonymousFile();
+  Buffer::OwnedImpl buffer;
+  std::string expected;
+  for (int i = 0; i < 100; i++) {
+    std::string slice(1000, 'a' + i % 26);
+    buffer.appendSliceForTest(slice);
+    expected += slice;
+  }
+  WaitForResult<absl::StatusOr<size_t>> result;
+  EXPECT_OK(handle->write(buffer, 0, result.callback()));
+  EXPECT_THAT(result.getResult(), IsOkAndHolds(expected.size()));
+  EXPECT_EQ(expected, read(handle, 0, expected.size()));
+  close(handle);
+}
+
+TEST_P(AsyncFileManagerIoUringTest, ReadsUnalignedRangesOfExistingFile) {
+  std::string contents;
+  for (int i = 0; i < 10000; i++) {
+    contents += static_cast<char>('a' + i % 26);
+  }
+  std::string filename = createFile(contents);
+  AsyncFileHandle handle = openExistingFile(filename, AsyncFileManager::Mode::ReadOnly);
+  EXPECT_EQ(contents.substr(0, 10), read(handle, 0, 10));
+  EXPECT_EQ(contents.substr(4090, 20), read(handle, 4090, 20));
+  EXPECT_EQ(contents.substr(100, 8000), read(handle, 100, 8000));
+  EXPECT_EQ(contents.substr(9000), read(handle, 9000, 5000));
+  EXPECT_EQ("", read(handle, 20000, 10));
+  close(handle);
+}
+
+TEST_P(AsyncFileManagerIoUringTest, ChainedActionsRunInOrder) {
+  AsyncFileHandle handle = createAnonymousFile();
+  Buffer::OwnedImpl hello("hello");
+  std::promise<std::string> read_result;
+  EXPECT_OK(handle->write(hello, 0, [&](absl::StatusOr<size_t> written) {
+    EXPECT_THAT(written, IsOkAndHolds(5U));
+    EXPECT_OK(handle->read(1, 3, [&](absl::StatusOr<Buffer::InstancePtr> read) {
+      read_result.set_value(read.value()->toString());
+    }));
+  }));
+  EXPECT_EQ("ell", read_result.get_future().get());
+  close(handle);
+}
+
+TEST_P(AsyncFileManagerIoUringTest, ManyConcurrentWritesExceedingQueueDepth) {
+  constexpr int file_count = 50;
+  std::vector<AsyncFileHandle> handles;
+  for (int i = 0; i < file_count; i++) {
+    handles.push_back(createAnonymousFile());
+  }
+  std::vector<WaitForResult<absl::StatusOr<size_t>>> results(file_count);
+  for (int i = 0; i < file_count; i++) {
+    Buffer::OwnedImpl data(absl::StrCat("file ", i));
+    EXPECT_OK(handles[i]->write(data, 0, results[i].callback()));
+  }
+  for (int i = 0; i < file_count; i++) {
+    EXPECT_THAT(results[i].getResult(), IsOkAndHolds(absl::StrCat("file ", i).size()));
+    EXPECT_EQ(absl::StrCat("file ", i), read(handles[i], 0, 100));
+    close(handles[i]);
+  }
+}
+
+TEST_P(AsyncFileManagerIoUringTest, ReadFailsOnWriteOnlyFile) {
+  std::string filename = createFile("hello");
+  AsyncFileHandle handle = openExistingFile(filename, AsyncFileManager::Mode::WriteOnly);
+  WaitForResult<absl::StatusOr<Buffer::InstancePtr>> result;
+  EXPECT_OK(handle->read(0, 5, result.callback()));
+  EXPECT_THAT(result.getResult(), HasStatusCode(absl::StatusCode::kFailedPrecondition));
+  close(handle);
+}
+
+TEST_P(AsyncFileManagerIoUringTest, StatLinkAndUnlink) {
+  AsyncFileHandle handle = createAnonymousFile();
+  EXPECT_THAT(write(handle, "hello", 0), IsOkAndHolds(5U));
+  WaitForResult<absl::StatusOr<struct stat>> stat_result;
+  EXPECT_OK(handle->stat(stat_result.callback()));
+  EXPECT_EQ(5, stat_result.getResult().value().st_size);
+  std::string filename = absl::StrCat(tmpdir_, "/async_file_io_uring_link");
+  WaitForResult<absl::Status> link_result;
+  EXPECT_OK(handle->createHardLink(filename, link_result.callback()));
+  EXPECT_OK(link_result.getResult());
+  close(handle);
+  WaitForResult<absl::StatusOr<struct stat>> named_stat_result;
+  manager_->stat(filename, named_stat_result.callback());
+  EXPECT_EQ(5, named_stat_result.getResult().value().st_size);
+  WaitForResult<absl::Status> unlink_result;
+  manager_->unlink(filename, unlink_result.callback());
+  EXPECT_OK(unlink_result.getResult());
+  WaitForResult<absl::Status> second_unlink_result;
+  manager_->unlink(filename, second_unlink_result.callback());
+  EXPECT_THAT(second_unlink_result.getResult(), HasStatusCode(absl::StatusCode::kNotFound));
+}
+
+TEST_P(AsyncFileManagerIoUringTest, DuplicateReadsSameFile) {
+  std::string filename = createFile("hello");
+  AsyncFileHandle handle = openExistingFile(filename, AsyncFileManager::Mode::ReadOnly);
+  WaitForResult<absl::StatusOr<AsyncFileHandle>> duplicate_result;
+  EXPECT_OK(handle->duplicate(duplicate_result.callback()));
+  AsyncFileHandle duplicate = duplicate_result.getResult().value();
+  close(handle);
+  EXPECT_EQ("hello", read(duplicate, 0, 5));
+  close(duplicate);
+}
+
+} // namespace AsyncFiles
+} // namespace Common
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,187 @@
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "envoy/extensions/common/async_files/v3/async_file_manager.pb.h"
+
+#include "source/common/buffer/buffer_impl.h"
+#include "source/common/io/io_uring_impl.h"
+#include "source/common/singleton/manager_impl.h"
+#include "source/extensions/common/async_files/async_file_handle.h"
+#include "source/extensions/common/async_files/async_file_manager.h"
+#include "source/extensions/common/async_files/async_file_manager_factory.h"
+
+#include "absl/synchronization/blocking_counter.h"
+#include "benchmark/benchmark.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace Common {
+namespace AsyncFiles {
+namespace {
+
+// Compares the throughput of the thread pool and io_uring managers for the
+// pattern the file system cache uses: many concurrent files, each read or
+// written in chunks by a chain of actions.
+enum class ManagerType : int64_t { ThreadPool = 0, IoUring = 1, IoUringDirect = 2 };
+
+constexpr int ConcurrentFiles = 64;
+constexpr int ChunksPerFile = 16;
+
+class ManagerFixture {
+public:
+  explicit ManagerFixture(ManagerType type)
+      : factory_(AsyncFileManagerFactory::singleton(&singleton_manager_)) {
+    envoy::extensions::common::async_files::v3::AsyncFileManagerConfig config;
+    if (type == ManagerType::ThreadPool) {
+      config.mutable_thread_pool()->set_thread_count(4);
+    } else if (Io::isIoUringSupported()) {
+      config.mutable_io_uring()->set_direct_io(type == ManagerType::IoUringDirect);
+    } else {
+      return;
+    }
+    manager_ = factory_->getAsyncFileManager(config);
+  }
+
+  AsyncFileManager* manager() { return manager_.get(); }
+
+  // Creates ConcurrentFiles named files of ChunksPerFile chunks of chunk_size.
+  void createFiles(size_t chunk_size) {
+    const std::string chunk(chunk_size, 'a');
+    for (int i = 0; i < ConcurrentFiles; i++) {
+      char filename[1024];
+      snprintf(filename, sizeof(filename), "%s/async_file_speed.XXXXXX", tmpdir_.c_str());
+      const int fd = ::mkstemp(filename);
+      RELEASE_ASSERT(fd != -1, "");
+      for (int chunk_index = 0; chunk_index < ChunksPerFile; chunk_index++) {
+        RELEASE_ASSERT(::write(fd, chunk.data(), chunk.size()) ==
+                           static_cast<ssize_t>(chunk.size()),
+                       "");
+      }
+      ::close(fd);
+      files_.push_back(filename);
+    }
+  }
+
+  const std::vector<std::string>& files() const { return files_; }
+  const std::string& tmpdir() const { return tmpdir_; }
+
+  ~ManagerFixture() {
+    manager_.reset();
+    for (const std::string& file : files_) {
+      ::unlink(file.c_str());
+    }
+  }
+
+private:
+  Singleton::ManagerImpl singleton_manager_;
+  std::shared_ptr<AsyncFileManagerFactory> factory_;
+  std::shared_ptr<AsyncFileManager> manager_;
+  const char* test_tmpdir_ = std::getenv("TEST_TMPDIR");
+  std::string tmpdir_ = test_tmpdir_ ? test_tmpdir_ : "/tmp";
+  std::vector<std::string> files_;
+};
+
+// Reads one file chunk by chunk, chaining each read from the previous one's
+// callback, then closes it.
+void readChunks(AsyncFileHandle handle, size_t chunk_size, int chunk_index,
+                absl::BlockingCounter& done) {
+  if (chunk_index == ChunksPerFile) {
+    handle->close([&done](absl::Status) { done.DecrementCount(); }).IgnoreError();
+    return;
+  }
+  handle
+      ->read(chunk_index * chunk_size, chunk_size,
+             [handle, chunk_size, chunk_index, &done](absl::StatusOr<Buffer::InstancePtr> result) {
+               RELEASE_ASSERT(result.ok() && result.value()->length() == chunk_size, "");
+               readChunks(handle, chunk_size, chunk_index + 1, done);
+             })
+      .IgnoreError();
+}
+
+void writeChunks(AsyncFileHandle handle, size_t chunk_size, int chunk_index,
+                 absl::BlockingCounter& done) {
+  if (chunk_index == ChunksPerFile) {
+    handle->close([&done](absl::Status) { done.DecrementCount(); }).IgnoreError();
+    return;
+  }
+  Buffer::OwnedImpl chunk(std::string(chunk_size, 'a'));
+  handle
+      ->write(chunk, chunk_index * chunk_size,
+              [handle, chunk_size, chunk_index, &done](absl::StatusOr<size_t> result) {
+                RELEASE_ASSERT(result.ok() && result.value() == chunk_size, "");
+                writeChunks(handle, chunk_size, chunk_index + 1, done);
+              })
+      .IgnoreError();
+}
+
+// Opens ConcurrentFiles existing files at once and reads each of them in
+// `range(1)`-byte chunks.
+void bmConcurrentReads(benchmark::State& state) {
+  const auto type = static_cast<ManagerType>(state.range(0));
+  const size_t chunk_size = state.range(1);
+  ManagerFixture fixture(type);
+  if (fixture.manager() == nullptr) {
+    state.SkipWithError("io_uring is not supported by the kernel");
+    return;
+  }
+  fixture.createFiles(chunk_size);
+  for (auto _ : state) {
+    UNREFERENCED_PARAMETER(_);
+    absl::BlockingCounter done(ConcurrentFiles);
+    for (const std::string& file : fixture.files()) {
+      fixture.manager()->openExistingFile(
+          file, AsyncFileManager::Mode::ReadOnly,
+          [chunk_size, &done](absl::StatusOr<AsyncFileHandle> handle) {
+            RELEASE_ASSERT(handle.ok(), "");
+            readChunks(handle.value(), chunk_size, 0, done);
+          });
+    }
+    done.Wait();
+  }
+  state.SetBytesProcessed(state.iterations() * ConcurrentFiles * ChunksPerFile * chunk_size);
+}
+BENCHMARK(bmConcurrentReads)
+    ->ArgsProduct({{static_cast<int64_t>(ManagerType::ThreadPool),
+                    static_cast<int64_t>(ManagerType::IoUring),
+                    static_cast<int64_t>(ManagerType::IoUringDirect)},
+                   {4096, 65536}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+// Creates ConcurrentFiles anonymous files at once and writes each of them in
+// `range(1)`-byte chunks.
+void bmConcurrentWrites(benchmark::State& state) {
+  const auto type = static_cast<ManagerType>(state.range(0));
+  const size_t chunk_size = state.range(1);
+  ManagerFixture fixture(type);
+  if (fixture.manager() == nullptr) {
+    state.SkipWithError("io_uring is not supported by the kernel");
+    return;
+  }
+  for (auto _ : state) {
+    UNREFERENCED_PARAMETER(_);
+    absl::BlockingCounter done(ConcurrentFiles);
+    for (int i = 0; i < ConcurrentFiles; i++) {
+      fixture.manager()->createAnonymousFile(
+          fixture.tmpdir(), [chunk_size, &done](absl::StatusOr<AsyncFileHandle> handle) {
+            RELEASE_ASSERT(handle.ok(), "");
+            writeChunks(handle.value(), chunk_size, 0, done);
+          });
+    }
+    done.Wait();
+  }
+  state.SetBytesProcessed(state.iterations() * ConcurrentFiles * ChunksPerFile * chunk_size);
+}
+BENCHMARK(bmConcurrentWrites)
+    ->ArgsProduct({{static_cast<int64_t>(ManagerType::ThreadPool),
+                    static_cast<int64_t>(ManagerType::IoUring)},
+                   {4096, 65536}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+} // namespace
+} // namespace AsyncFiles
+} // namespace Common
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,88 @@
+// Measures the cost of a rate limit decision as the number of descriptors grows, for static
+// descriptors and for the token buckets created from a descriptor with a wildcard entry.
+
+#include "source/extensions/filters/common/local_ratelimit/local_ratelimit_impl.h"
+
+#include "test/mocks/event/mocks.h"
+
+#include "absl/strings/str_cat.h"
+#include "benchmark/benchmark.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace Filters {
+namespace Common {
+namespace LocalRateLimit {
+namespace {
+
+using Descriptors =
+    Protobuf::RepeatedPtrField<envoy::extensions::common::ratelimit::v3::LocalRateLimitDescriptor>;
+
+void addDescriptor(Descriptors& descriptors, absl::string_view value) {
+  auto* descriptor = descriptors.Add();
+  auto* entry = descriptor->add_entries();
+  entry->set_key("user");
+  entry->set_value(std::string(value));
+  descriptor->mutable_token_bucket()->set_max_tokens(1000000);
+  descriptor->mutable_token_bucket()->mutable_tokens_per_fill()->set_value(1000000);
+  descriptor->mutable_token_bucket()->mutable_fill_interval()->set_seconds(1);
+}
+
+std::vector<std::vector<RateLimit::LocalDescriptor>> requestDescriptors(uint64_t num_users) {
+  std::vector<std::vector<RateLimit::LocalDescriptor>> request_descriptors;
+  request_descriptors.reserve(num_users);
+  for (uint64_t i = 0; i < num_users; i++) {
+    request_descriptors.push_back({{{{"user", absl::StrCat("user", i)}}}});
+  }
+  return request_descriptors;
+}
+
+// Requests cycle through range(0) users, each with a descriptor of its own.
+void bmStaticDescriptors(benchmark::State& state) {
+  const uint64_t num_users = state.range(0);
+  testing::NiceMock<Event::MockDispatcher> dispatcher;
+  Descriptors descriptors;
+  for (uint64_t i = 0; i < num_users; i++) {
+    addDescriptor(descriptors, absl::StrCat("user", i));
+  }
+  LocalRateLimiterImpl rate_limiter(std::chrono::seconds(1), 1000000, 1000000, dispatcher,
+                                    descriptors, false);
+  const auto request_descriptors = requestDescriptors(num_users);
+
+  uint64_t i = 0;
+  for (auto _ : state) { // NOLINT
+    benchmark::DoNotOptimize(
+        rate_limiter.requestAllowed(request_descriptors[i++ % num_users]).allowed);
+  }
+}
+BENCHMARK(bmStaticDescriptors)->Arg(1000)->Arg(10000)->Arg(100000);
+
+// Requests cycle through range(0) users, which share a descriptor with a wildcard entry and keep
+// up to range(1) token buckets, so that with fewer buckets than users every request evicts one.
+void bmDynamicDescriptors(benchmark::State& state) {
+  const uint64_t num_users = state.range(0);
+  testing::NiceMock<Event::MockDispatcher> dispatcher;
+  Descriptors descriptors;
+  addDescriptor(descriptors, "");
+  LocalRateLimiterImpl rate_limiter(std::chrono::seconds(1), 1000000, 1000000, dispatcher,
+                                    descriptors, false, nullptr, state.range(1));
+  const auto request_descriptors = requestDescriptors(num_users);
+
+  uint64_t i = 0;
+  for (auto _ : state) { // NOLINT
+    benchmark::DoNotOptimize(
+        rate_limiter.requestAllowed(request_descriptors[i++ % num_users]).allowed);
+  }
+}
+BENCHMARK(bmDynamicDescriptors)
+    ->Args({1000, 100000})
+    ->Args({10000, 100000})
+    ->Args({100000, 100000})
+    ->Args({100000, 10000});
+
+} // namespace
+} // namespace LocalRateLimit
+} // namespace Common
+} // namespace Filters
+} // namespace Extensions
+} // namespace Envoy
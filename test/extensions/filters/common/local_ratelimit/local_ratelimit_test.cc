@@ -1022,6 +1022,99 @@ TEST_F(LocalRateLimiterDescriptorImplTest, AtomicTokenBucketDescriptorStatus) {
   EXPECT_EQ(rate_limit_result.token_bucket_context->remainingTokens(), 2);
 }
 
+class LocalRateLimiterDynamicDescriptorTest : public LocalRateLimiterDescriptorImplTest {
+public:
+  void initializeWithDynamicDescriptor(uint32_t max_dynamic_descriptors) {
+    TestUtility::loadFromYaml(dynamic_descriptor_config_yaml, *descriptors_.Add());
+    rate_limiter_ = std::make_shared<LocalRateLimiterImpl>(std::chrono::milliseconds(50), 10, 10,
+                                                           dispatcher_, descriptors_, false,
+                                                           nullptr, max_dynamic_descriptors);
+  }
+
+  std::vector<RateLimit::LocalDescriptor> userDescriptor(absl::string_view user) {
+    return {{{{"user", std::string(user)}, {"path", "/foo"}}}};
+  }
+
+  const std::string dynamic_descriptor_config_yaml = R"(
+  entries:
+  - key: user
+  - key: path
+    value: /foo
+  token_bucket:
+    max_tokens: 1
+    tokens_per_fill: 1
+    fill_interval: 1s
+  )";
+};
+
+// Each distinct value of a wildcard entry gets its own token bucket.
+TEST_F(LocalRateLimiterDynamicDescriptorTest, TokenBucketPerValue) {
+  initializeWithDynamicDescriptor(20);
+
+  EXPECT_TRUE(rate_limiter_->requestAllowed(userDescriptor("a")).allowed);
+  EXPECT_FALSE(rate_limiter_->requestAllowed(userDescriptor("a")).allowed);
+  EXPECT_TRUE(rate_limiter_->requestAllowed(userDescriptor("b")).allowed);
+  EXPECT_FALSE(rate_limiter_->requestAllowed(userDescriptor("b")).allowed);
+
+  // The token buckets are refilled without a timer.
+  dispatcher_.globalTimeSystem().advanceTimeWait(std::chrono::milliseconds(1000));
+  EXPECT_TRUE(rate_limiter_->requestAllowed(userDescriptor("a")).allowed);
+  EXPECT_TRUE(rate_limiter_->requestAllowed(userDescriptor("b")).allowed);
+}
+
+// Request descriptors whose other entries do not match fall back to the default token bucket.
+TEST_F(LocalRateLimiterDynamicDescriptorTest, NoMatch) {
+  initializeWithDynamicDescriptor(20);
+
+  const std::vector<RateLimit::LocalDescriptor> other_path{{{{"user", "a"}, {"path", "/bar"}}}};
+  const std::vector<RateLimit::LocalDescriptor> user_only{{{{"user", "a"}}}};
+  for (int i = 0; i < 10; i++) {
+    EXPECT_TRUE(rate_limiter_->requestAllowed(i % 2 == 0 ? other_path : user_only).allowed);
+  }
+  EXPECT_FALSE(rate_limiter_->requestAllowed(other_path).allowed);
+}
+
+// The least recently used token buckets are evicted, and start over full when seen again.
+TEST_F(LocalRateLimiterDynamicDescriptorTest, LruEviction) {
+  initializeWithDynamicDescriptor(2);
+
+  EXPECT_TRUE(rate_limiter_->requestAllowed(userDescriptor("a")).allowed);
+  EXPECT_TRUE(rate_limiter_->requestAllowed(userDescriptor("b")).allowed);
+  // a is now the most recently used, so c evicts b.
+  EXPECT_FALSE(rate_limiter_->requestAllowed(userDescriptor("a")).allowed);
+  EXPECT_TRUE(rate_limiter_->requestAllowed(userDescriptor("c")).allowed);
+
+  EXPECT_FALSE(rate_limiter_->requestAllowed(userDescriptor("a")).allowed);
+  EXPECT_TRUE(rate_limiter_->requestAllowed(userDescriptor("b")).allowed);
+}
+
+// The token bucket context of a dynamic descriptor outlives its eviction.
+TEST_F(LocalRateLimiterDynamicDescriptorTest, TokenBucketContextOutlivesEviction) {
+  initializeWithDynamicDescriptor(1);
+
+  auto result = rate_limiter_->requestAllowed(userDescriptor("a"));
+  EXPECT_TRUE(result.allowed);
+  ASSERT_TRUE(result.token_bucket_context.has_value());
+  EXPECT_NE(result.dynamic_token_bucket, nullptr);
+
+  EXPECT_TRUE(rate_limiter_->requestAllowed(userDescriptor("b")).allowed);
+  EXPECT_EQ(1U, result.token_bucket_context->maxTokens());
+  EXPECT_EQ(0U, result.token_bucket_context->remainingTokens());
+}
+
+// Large maps are sharded, and each shard evicts on its own.
+TEST_F(LocalRateLimiterImplTest, DynamicDescriptorMapSharded) {
+  DynamicDescriptorMap map(100000, dispatcher_.timeSource());
+  map.addDescriptor({{{"user", ""}}}, 1, 1, std::chrono::milliseconds(1000));
+
+  for (int i = 0; i < 200000; i++) {
+    EXPECT_NE(nullptr, map.getBucket({{{"user", absl::StrCat(i)}}}));
+  }
+  EXPECT_LE(map.size(), 100000U);
+  EXPECT_GT(map.size(), 90000U);
+  EXPECT_EQ(nullptr, map.getBucket({{{"other", "1"}}}));
+}
+
 } // Namespace LocalRateLimit
 } // namespace Common
 } // namespace Filters
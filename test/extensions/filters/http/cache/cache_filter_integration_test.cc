@@ -159,6 +159,62 @@ TEST_P(CacheIntegrationTest, MissInsertHit) {
   }
 }
 
+TEST_P(CacheIntegrationTest, ConcurrentMissesCollapsedIntoOneUpstreamRequest) {
+  initializeFilter(R"EOF(
+    name: "envoy.filters.http.cache"
+    typed_config:
+        "@type": "type.googleapis.com/envoy.extensions.filters.http.cache.v3.CacheConfig"
+        typed_config:
+           "@type": "type.googleapis.com/envoy.extensions.http.cache.simple_http_cache.v3.SimpleHttpCacheConfig"
+        request_coalescing_timeout: 60s
+    )EOF");
+
+  // Include test name and params in URL to make each test's requests unique.
+  const Http::TestRequestHeaderMapImpl request_headers =
+      httpRequestHeader("GET", /*authority=*/"ConcurrentMissesCollapsedIntoOneUpstreamRequest");
+  const std::string response_body(42, 'a');
+  Http::TestResponseHeaderMapImpl response_headers = httpResponseHeadersForBody(response_body);
+  const int num_clients = 5;
+
+  // The first request misses and is sent upstream.
+  IntegrationStreamDecoderPtr first_response =
+      codec_client_->makeHeaderOnlyRequest(request_headers);
+  waitForNextUpstreamRequest();
+
+  // The other requests miss too, but wait for the first one's response instead of going upstream.
+  std::vector<IntegrationCodecClientPtr> clients;
+  std::vector<IntegrationStreamDecoderPtr> responses;
+  for (int i = 1; i < num_clients; ++i) {
+    clients.push_back(makeHttpConnection(makeClientConnection((lookupPort("http")))));
+    responses.push_back(clients.back()->makeHeaderOnlyRequest(request_headers));
+  }
+  test_server_->waitForCounterEq("http.config_test.cache.collapsed_requests", num_clients - 1);
+
+  upstream_request_->encodeHeaders(response_headers, /*end_stream=*/false);
+  upstream_request_->encodeData(response_body, /*end_stream=*/true);
+
+  ASSERT_TRUE(first_response->waitForEndStream());
+  EXPECT_THAT(first_response->headers(), IsSupersetOfHeaders(response_headers));
+  EXPECT_EQ(first_response->body(), response_body);
+  for (IntegrationStreamDecoderPtr& response : responses) {
+    ASSERT_TRUE(response->waitForEndStream());
+    EXPECT_THAT(response->headers(), IsSupersetOfHeaders(response_headers));
+    EXPECT_EQ(response->body(), response_body);
+  }
+
+  // A single upstream request served every client.
+  EXPECT_EQ(test_server_->counter("cluster.cluster_0.upstream_rq_total")->value(), 1);
+  EXPECT_EQ(
+      test_server_->counter("http.config_test.cache.collapsed_requests_served_from_cache")->value(),
+      num_clients - 1);
+  EXPECT_EQ(test_server_->counter("http.config_test.cache.collapsed_requests_timed_out")->value(),
+            0);
+
+  for (IntegrationCodecClientPtr& client : clients) {
+    client->close();
+  }
+}
+
 TEST_P(CacheIntegrationTest, ExpiredValidated) {
   initializeFilter(default_config);
 
@@ -31,7 +31,20 @@ protected:
   // The filter has to be created as a shared_ptr to enable shared_from_this() which is used in the
   // cache callbacks.
   CacheFilterSharedPtr makeFilter(std::shared_ptr<HttpCache> cache, bool auto_destroy = true) {
-    auto config = std::make_shared<CacheFilterConfig>(config_, context_.server_factory_context_);
+    return makeFilter(cache, makeConfig(), decoder_callbacks_, encoder_callbacks_, auto_destroy);
+  }
+
+  std::shared_ptr<const CacheFilterConfig> makeConfig() {
+    return std::make_shared<CacheFilterConfig>(config_, "", context_.scope_,
+                                               context_.server_factory_context_);
+  }
+
+  // Filters sharing a config share its in-flight fills.
+  CacheFilterSharedPtr makeFilter(std::shared_ptr<HttpCache> cache,
+                                  std::shared_ptr<const CacheFilterConfig> config,
+                                  Http::MockStreamDecoderFilterCallbacks& decoder_callbacks,
+                                  Http::MockStreamEncoderFilterCallbacks& encoder_callbacks,
+                                  bool auto_destroy = true) {
     std::shared_ptr<CacheFilter> filter(new CacheFilter(config, cache),
                                         [auto_destroy](CacheFilter* f) {
                                           if (auto_destroy) {
@@ -41,8 +54,8 @@ protected:
                                         });
     filter_state_ = std::make_shared<StreamInfo::FilterStateImpl>(
         StreamInfo::FilterState::LifeSpan::FilterChain);
-    filter->setDecoderFilterCallbacks(decoder_callbacks_);
-    filter->setEncoderFilterCallbacks(encoder_callbacks_);
+    filter->setDecoderFilterCallbacks(decoder_callbacks);
+    filter->setEncoderFilterCallbacks(encoder_callbacks);
     return filter;
   }
 
@@ -352,6 +365,89 @@ TEST_F(CacheFilterTest, CacheHitWithBody) {
   }
 }
 
+TEST_F(CacheFilterTest, CollapsedRequestServedFromCacheAfterFill) {
+  request_headers_.setHost("CollapsedRequestServedFromCacheAfterFill");
+  config_.mutable_request_coalescing_timeout()->set_seconds(10);
+  std::shared_ptr<const CacheFilterConfig> config = makeConfig();
+  const std::string body = "abc";
+
+  NiceMock<Http::MockStreamDecoderFilterCallbacks> waiter_decoder_callbacks;
+  NiceMock<Http::MockStreamEncoderFilterCallbacks> waiter_encoder_callbacks;
+  ON_CALL(waiter_decoder_callbacks, dispatcher()).WillByDefault(::testing::ReturnRef(*dispatcher_));
+  ON_CALL(waiter_encoder_callbacks, dispatcher()).WillByDefault(::testing::ReturnRef(*dispatcher_));
+  Http::TestRequestHeaderMapImpl waiter_request_headers = request_headers_;
+
+  // The first request misses and is sent upstream.
+  CacheFilterSharedPtr filter =
+      makeFilter(simple_cache_, config, decoder_callbacks_, encoder_callbacks_);
+  testDecodeRequestMiss(filter);
+
+  // The second request misses too, but waits for the first one's response.
+  CacheFilterSharedPtr waiter =
+      makeFilter(simple_cache_, config, waiter_decoder_callbacks, waiter_encoder_callbacks);
+  EXPECT_CALL(waiter_decoder_callbacks, continueDecoding).Times(0);
+  EXPECT_EQ(waiter->decodeHeaders(waiter_request_headers, true),
+            Http::FilterHeadersStatus::StopAllIterationAndWatermark);
+  dispatcher_->run(Event::Dispatcher::RunType::Block);
+  EXPECT_EQ(TestUtility::findCounter(context_.store_, "cache.collapsed_requests")->value(), 1);
+
+  // Once the first response is in the cache, the second request is served from it.
+  EXPECT_CALL(waiter_decoder_callbacks,
+              encodeHeaders_(IsSupersetOfHeaders(response_headers_), false));
+  EXPECT_CALL(
+      waiter_decoder_callbacks,
+      encodeData(testing::Property(&Buffer::Instance::toString, testing::Eq(body)), true));
+  Buffer::OwnedImpl buffer(body);
+  response_headers_.setContentLength(body.size());
+  EXPECT_EQ(filter->encodeHeaders(response_headers_, false), Http::FilterHeadersStatus::Continue);
+  EXPECT_EQ(filter->encodeData(buffer, true), Http::FilterDataStatus::Continue);
+  dispatcher_->run(Event::Dispatcher::RunType::Block);
+  ::testing::Mock::VerifyAndClearExpectations(&waiter_decoder_callbacks);
+
+  EXPECT_EQ(TestUtility::findCounter(context_.store_, "cache.collapsed_requests_served_from_cache")
+                ->value(),
+            1);
+  EXPECT_EQ(TestUtility::findCounter(context_.store_, "cache.collapsed_requests_timed_out")->value(),
+            0);
+  EXPECT_EQ(config->fillCoalescer()->fillsInFlight(), 0);
+}
+
+TEST_F(CacheFilterTest, CollapsedRequestTimesOut) {
+  request_headers_.setHost("CollapsedRequestTimesOut");
+  config_.mutable_request_coalescing_timeout()->set_seconds(1);
+  std::shared_ptr<const CacheFilterConfig> config = makeConfig();
+
+  NiceMock<Http::MockStreamDecoderFilterCallbacks> waiter_decoder_callbacks;
+  NiceMock<Http::MockStreamEncoderFilterCallbacks> waiter_encoder_callbacks;
+  ON_CALL(waiter_decoder_callbacks, dispatcher()).WillByDefault(::testing::ReturnRef(*dispatcher_));
+  ON_CALL(waiter_encoder_callbacks, dispatcher()).WillByDefault(::testing::ReturnRef(*dispatcher_));
+  Http::TestRequestHeaderMapImpl waiter_request_headers = request_headers_;
+
+  CacheFilterSharedPtr filter =
+      makeFilter(simple_cache_, config, decoder_callbacks_, encoder_callbacks_);
+  testDecodeRequestMiss(filter);
+
+  CacheFilterSharedPtr waiter =
+      makeFilter(simple_cache_, config, waiter_decoder_callbacks, waiter_encoder_callbacks);
+  EXPECT_EQ(waiter->decodeHeaders(waiter_request_headers, true),
+            Http::FilterHeadersStatus::StopAllIterationAndWatermark);
+  dispatcher_->run(Event::Dispatcher::RunType::Block);
+
+  // The first response takes too long, so the second request goes upstream on its own.
+  EXPECT_CALL(waiter_decoder_callbacks, continueDecoding);
+  time_source_.advanceTimeWait(std::chrono::seconds(1));
+  dispatcher_->run(Event::Dispatcher::RunType::Block);
+  ::testing::Mock::VerifyAndClearExpectations(&waiter_decoder_callbacks);
+  EXPECT_EQ(TestUtility::findCounter(context_.store_, "cache.collapsed_requests_timed_out")->value(),
+            1);
+
+  // Completing the first response no longer affects the second request.
+  EXPECT_CALL(waiter_decoder_callbacks, continueDecoding).Times(0);
+  EXPECT_EQ(filter->encodeHeaders(response_headers_, true), Http::FilterHeadersStatus::Continue);
+  dispatcher_->run(Event::Dispatcher::RunType::Block);
+  EXPECT_EQ(config->fillCoalescer()->fillsInFlight(), 0);
+}
+
 TEST_F(CacheFilterTest, WatermarkEventsAreSentIfCacheBlocksStreamAndLimitExceeded) {
   request_headers_.setHost("CacheHitWithBody");
   const std::string body1 = "abcde";
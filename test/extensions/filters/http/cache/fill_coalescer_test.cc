@@ -0,0 +1,82 @@
+#include "source/extensions/filters/http/cache/fill_coalescer.h"
+
+#include "test/mocks/event/mocks.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace Cache {
+namespace {
+
+using ::testing::_;
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+using ::testing::IsNull;
+using ::testing::NotNull;
+
+class FillCoalescerTest : public ::testing::Test {
+protected:
+  FillCompleteCallback recordResult() {
+    return [this](bool fill_succeeded) { results_.push_back(fill_succeeded); };
+  }
+
+  FillCoalescerSharedPtr coalescer_ = std::make_shared<FillCoalescer>();
+  testing::NiceMock<Event::MockDispatcher> dispatcher_;
+  std::vector<bool> results_;
+};
+
+TEST_F(FillCoalescerTest, FirstRequestStartsFillAndOthersWait) {
+  FillSharedPtr fill = coalescer_->joinOrStartFill("key", dispatcher_, recordResult());
+  ASSERT_THAT(fill, NotNull());
+  EXPECT_THAT(coalescer_->joinOrStartFill("key", dispatcher_, recordResult()), IsNull());
+  EXPECT_THAT(coalescer_->joinOrStartFill("key", dispatcher_, recordResult()), IsNull());
+  EXPECT_EQ(coalescer_->fillsInFlight(), 1);
+
+  EXPECT_CALL(dispatcher_, post(_)).Times(2);
+  fill->complete(true);
+  EXPECT_THAT(results_, ElementsAre(true, true));
+  EXPECT_EQ(coalescer_->fillsInFlight(), 0);
+
+  // Completing again, or dropping the fill, has no further effect.
+  fill->complete(false);
+  fill.reset();
+  EXPECT_THAT(results_, ElementsAre(true, true));
+}
+
+TEST_F(FillCoalescerTest, DifferentKeysDoNotWait) {
+  FillSharedPtr fill_a = coalescer_->joinOrStartFill("a", dispatcher_, recordResult());
+  FillSharedPtr fill_b = coalescer_->joinOrStartFill("b", dispatcher_, recordResult());
+  EXPECT_THAT(fill_a, NotNull());
+  EXPECT_THAT(fill_b, NotNull());
+  EXPECT_EQ(coalescer_->fillsInFlight(), 2);
+}
+
+TEST_F(FillCoalescerTest, DroppedFillReleasesWaitersAsFailed) {
+  FillSharedPtr fill = coalescer_->joinOrStartFill("key", dispatcher_, recordResult());
+  EXPECT_THAT(coalescer_->joinOrStartFill("key", dispatcher_, recordResult()), IsNull());
+  fill.reset();
+  EXPECT_THAT(results_, ElementsAre(false));
+
+  // The next request for the key starts a new fill.
+  fill = coalescer_->joinOrStartFill("key", dispatcher_, recordResult());
+  EXPECT_THAT(fill, NotNull());
+  fill->complete(true);
+  EXPECT_THAT(results_, ElementsAre(false));
+}
+
+TEST_F(FillCoalescerTest, FillKeepsCoalescerAlive) {
+  FillSharedPtr fill = coalescer_->joinOrStartFill("key", dispatcher_, recordResult());
+  EXPECT_THAT(coalescer_->joinOrStartFill("key", dispatcher_, recordResult()), IsNull());
+  coalescer_.reset();
+  EXPECT_THAT(results_, IsEmpty());
+  fill->complete(true);
+  EXPECT_THAT(results_, ElementsAre(true));
+}
+
+} // namespace
+} // namespace Cache
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -6,6 +6,7 @@
 
 #include "test/extensions/filters/network/common/redis/mocks.h"
 #include "test/test_common/printers.h"
+#include "test/test_common/test_runtime.h"
 #include "test/test_common/utility.h"
 
 #include "gtest/gtest.h"
@@ -396,6 +397,100 @@ TEST_F(RedisEncoderDecoderImplTest, NestedArray) {
   EXPECT_EQ(value, *decoded_values_[0]);
 }
 
+TEST_F(RedisEncoderDecoderImplTest, BufferedBulkString) {
+  TestScopedRuntime scoped_runtime;
+  scoped_runtime.mergeValues({{"envoy.reloadable_features.redis_buffered_bulk_strings", "true"}});
+  DecoderImpl decoder(*this);
+
+  const std::string payload(DecoderImpl::MinBufferedBulkStringLength, 'a');
+  RespValue value;
+  value.type(RespType::BulkString);
+  value.asString() = payload;
+  encoder_.encode(value, buffer_);
+
+  // To test partial decode we will feed the buffer in 1000 byte chunks.
+  while (buffer_.length() != 0) {
+    Buffer::OwnedImpl temp_buffer;
+    temp_buffer.move(buffer_, 1000);
+    decoder.decode(temp_buffer);
+    EXPECT_EQ(0UL, temp_buffer.length());
+  }
+
+  ASSERT_EQ(1UL, decoded_values_.size());
+  const RespValue& decoded = *decoded_values_[0];
+  ASSERT_NE(nullptr, decoded.bufferedString());
+  EXPECT_EQ(decoded.bufferedString(), decoded.sharedBufferedString().get());
+  EXPECT_EQ(payload.size(), decoded.stringLength());
+  EXPECT_EQ(value, decoded);
+  EXPECT_EQ(fmt::format("\"{}\"", payload), decoded.toString());
+  EXPECT_NE(nullptr, decoded.bufferedString());
+
+  // Copies share the buffer, and asString() copies it into the value.
+  RespValue copy = decoded;
+  EXPECT_EQ(decoded.bufferedString(), copy.bufferedString());
+  EXPECT_EQ(payload, copy.asString());
+  EXPECT_EQ(nullptr, copy.bufferedString());
+  EXPECT_NE(nullptr, decoded.bufferedString());
+}
+
+TEST_F(RedisEncoderDecoderImplTest, BufferedBulkStringConstAsString) {
+  RespValue value;
+  value.type(RespType::BulkString);
+  value.asBufferedString().add("hello");
+  const RespValue& const_value = value;
+
+  // Reading a buffered bulk string through a const value is a bug, but still returns the payload.
+  EXPECT_ENVOY_BUG(EXPECT_EQ("hello", const_value.asString()),
+                   "buffered bulk strings are read with the non-const asString");
+  EXPECT_NE(nullptr, value.bufferedString());
+}
+
+TEST_F(RedisEncoderDecoderImplTest, BufferedBulkStringIsNotCopied) {
+  TestScopedRuntime scoped_runtime;
+  scoped_runtime.mergeValues({{"envoy.reloadable_features.redis_buffered_bulk_strings", "true"}});
+  DecoderImpl decoder(*this);
+
+  const std::string payload(DecoderImpl::MinBufferedBulkStringLength, 'a');
+  Buffer::BufferFragmentImpl fragment(payload.data(), payload.size(), nullptr);
+  buffer_.add(fmt::format("*2\r\n$3\r\nkey\r\n${}\r\n", payload.size()));
+  buffer_.addBufferFragment(fragment);
+  buffer_.add("\r\n");
+  decoder.decode(buffer_);
+  EXPECT_EQ(0UL, buffer_.length());
+
+  // The key is copied and the value references the decoded buffer.
+  ASSERT_EQ(1UL, decoded_values_.size());
+  const RespValue& decoded = *decoded_values_[0];
+  EXPECT_EQ(nullptr, decoded.asArray()[0].bufferedString());
+  EXPECT_EQ("key", decoded.asArray()[0].asString());
+  ASSERT_NE(nullptr, decoded.asArray()[1].bufferedString());
+  EXPECT_EQ(static_cast<const void*>(payload.data()),
+            decoded.asArray()[1].bufferedString()->frontSlice().mem_);
+
+  // The encoded value references the decoded buffer as well.
+  Buffer::OwnedImpl encoded;
+  encoder_.encode(decoded.asArray()[1], encoded);
+  decoded_values_.clear();
+  EXPECT_EQ(fmt::format("${}\r\n{}\r\n", payload.size(), payload), encoded.toString());
+  bool found = false;
+  for (const Buffer::RawSlice& slice : encoded.getRawSlices()) {
+    found |= slice.mem_ == static_cast<const void*>(payload.data());
+  }
+  EXPECT_TRUE(found);
+}
+
+TEST_F(RedisEncoderDecoderImplTest, BufferedBulkStringDisabled) {
+  DecoderImpl decoder(*this);
+
+  const std::string payload(DecoderImpl::MinBufferedBulkStringLength, 'a');
+  buffer_.add(fmt::format("${}\r\n{}\r\n", payload.size(), payload));
+  decoder.decode(buffer_);
+
+  ASSERT_EQ(1UL, decoded_values_.size());
+  EXPECT_EQ(nullptr, decoded_values_[0]->bufferedString());
+  EXPECT_EQ(payload, decoded_values_[0]->asString());
+}
+
 TEST_F(RedisEncoderDecoderImplTest, NullArray) {
   buffer_.add("*-1\r\n");
   decoder_.decode(buffer_);
@@ -2,6 +2,7 @@
 
 #include "test/extensions/filters/network/generic_proxy/mocks/filter.h"
 #include "test/mocks/server/factory_context.h"
+#include "test/test_common/utility.h"
 
 #include "gtest/gtest.h"
 
@@ -37,6 +38,27 @@ TEST(RouterFactoryTest, RouterFactoryTest) {
   fn(mock_cb);
 }
 
+TEST(RouterFactoryTest, RouterFactoryWithUpstreamMultiplexing) {
+  NiceMock<Server::Configuration::MockFactoryContext> factory_context;
+  RouterFactory factory;
+
+  envoy::extensions::filters::network::generic_proxy::router::v3::Router proto_config;
+  proto_config.mutable_upstream_multiplexing()->mutable_max_concurrent_streams()->set_value(16);
+
+  auto fn = factory.createFilterFactoryFromProto(proto_config, "test", factory_context);
+
+  NiceMock<MockFilterChainFactoryCallbacks> mock_cb;
+
+  EXPECT_CALL(mock_cb, addDecoderFilter(_));
+  fn(mock_cb);
+
+  // The upstream connection could not be both bound and multiplexed.
+  proto_config.set_bind_upstream_connection(true);
+  EXPECT_THROW_WITH_MESSAGE(
+      factory.createFilterFactoryFromProto(proto_config, "test", factory_context), EnvoyException,
+      "generic proxy router: upstream_multiplexing and bind_upstream_connection are exclusive");
+}
+
 } // namespace
 } // namespace Router
 } // namespace GenericProxy
@@ -36,6 +36,9 @@ public:
     ON_CALL(*this, removeUpstreamRequest(_)).WillByDefault(Invoke([this](uint64_t stream_id) {
       requests_.erase(stream_id);
     }));
+    ON_CALL(*this, resetUpstreamRequest(_)).WillByDefault(Invoke([this](uint64_t stream_id) {
+      requests_.erase(stream_id);
+    }));
     ON_CALL(*this, upstreamConnection())
         .WillByDefault(Return(makeOptRef<Network::Connection>(mock_upstream_connection_)));
     ON_CALL(*this, upstreamHost()).WillByDefault(Return(host_description_));
@@ -45,10 +48,12 @@ public:
   MOCK_METHOD(void, appendUpstreamRequest,
               (uint64_t stream_id, UpstreamRequestCallbacks* pending_request));
   MOCK_METHOD(void, removeUpstreamRequest, (uint64_t stream_id));
+  MOCK_METHOD(void, resetUpstreamRequest, (uint64_t stream_id));
   MOCK_METHOD(Upstream::HostDescriptionConstSharedPtr, upstreamHost, (), (const));
   MOCK_METHOD(ClientCodec&, clientCodec, ());
   MOCK_METHOD(OptRef<Network::Connection>, upstreamConnection, ());
   MOCK_METHOD(void, cleanUp, (bool close_connection));
+  MOCK_METHOD(void, drainConnection, ());
 
   std::shared_ptr<Upstream::MockHostDescription> host_description_ =
       std::make_shared<NiceMock<Upstream::MockHostDescription>>();
@@ -61,7 +66,7 @@ class MockGenericUpstreamFactory : public GenericUpstreamFactory {
 public:
   MOCK_METHOD(GenericUpstreamSharedPtr, createGenericUpstream,
               (Upstream::ThreadLocalCluster&, Upstream::LoadBalancerContext*, Network::Connection&,
-               const CodecFactory&, bool),
+               const CodecFactory&, bool, OptRef<MultiplexedGenericUpstreamPools>),
               (const));
 };
 
@@ -85,10 +90,15 @@ public:
             StreamInfo::FilterState::LifeSpan::Connection);
   }
 
-  void setup(FrameFlags frame_flags = FrameFlags{}, bool bound_upstream_connection = false) {
+  void setup(FrameFlags frame_flags = FrameFlags{}, bool bound_upstream_connection = false,
+             bool multiplex_upstream_connection = false) {
     envoy::extensions::filters::network::generic_proxy::router::v3::Router router_config;
     router_config.set_bind_upstream_connection(bound_upstream_connection);
-    config_ = std::make_shared<Router::RouterConfig>(router_config);
+    if (multiplex_upstream_connection) {
+      router_config.mutable_upstream_multiplexing();
+    }
+    config_ = std::make_shared<Router::RouterConfig>(
+        router_config, factory_context_.server_factory_context_.thread_local_);
 
     filter_ =
         std::make_shared<Router::RouterFilter>(config_, factory_context_, &mock_upstream_factory_);
@@ -163,7 +173,7 @@ public:
           .WillOnce(Return(OptRef<const Tracing::Config>{}));
     }
 
-    EXPECT_CALL(mock_upstream_factory_, createGenericUpstream(_, _, _, _, _))
+    EXPECT_CALL(mock_upstream_factory_, createGenericUpstream(_, _, _, _, _, _))
         .WillOnce(Return(mock_generic_upstream_));
     EXPECT_CALL(*mock_generic_upstream_, appendUpstreamRequest(_, _));
   }
@@ -350,7 +360,7 @@ TEST_F(RouterFilterTest, UpstreamClusterNoHealthyUpstream) {
       {cluster_name});
 
   // No valid upstream.
-  EXPECT_CALL(mock_upstream_factory_, createGenericUpstream(_, _, _, _, _))
+  EXPECT_CALL(mock_upstream_factory_, createGenericUpstream(_, _, _, _, _, _))
       .WillOnce(Return(nullptr));
 
   EXPECT_CALL(mock_filter_callback_, sendLocalReply(_, _, _))
@@ -370,7 +380,7 @@ TEST_F(RouterFilterTest, KickOffNormalUpstreamRequest) {
   setup();
   kickOffNewUpstreamRequest();
 
-  EXPECT_CALL(*mock_generic_upstream_, removeUpstreamRequest(_));
+  EXPECT_CALL(*mock_generic_upstream_, resetUpstreamRequest(_));
   EXPECT_CALL(*mock_generic_upstream_, cleanUp(true));
 
   cleanUp();
@@ -393,7 +403,7 @@ TEST_F(RouterFilterTest, KickOffNormalUpstreamRequestAndTimeout) {
         EXPECT_EQ(0, filter_->upstreamRequestsSize());
         EXPECT_EQ(status.message(), "timeout");
       }));
-  EXPECT_CALL(*mock_generic_upstream_, removeUpstreamRequest(_));
+  EXPECT_CALL(*mock_generic_upstream_, resetUpstreamRequest(_));
   EXPECT_CALL(*mock_generic_upstream_, cleanUp(true));
 
   response_timeout_->invokeCallback();
@@ -414,7 +424,7 @@ TEST_F(RouterFilterTest, UpstreamRequestResetBeforePoolCallback) {
         EXPECT_EQ(0, filter_->upstreamRequestsSize());
         EXPECT_EQ(status.message(), "local_reset");
       }));
-  EXPECT_CALL(*mock_generic_upstream_, removeUpstreamRequest(_));
+  EXPECT_CALL(*mock_generic_upstream_, resetUpstreamRequest(_));
   EXPECT_CALL(*mock_generic_upstream_, cleanUp(true));
 
   auto* upstream_request = notifyConnectionClose(Network::ConnectionEvent::LocalClose);
@@ -436,7 +446,7 @@ TEST_F(RouterFilterTest, UpstreamRequestPoolFailureConnctionOverflow) {
       .WillOnce(Invoke([](Status status, absl::string_view, ResponseUpdateFunction) {
         EXPECT_EQ(status.message(), "overflow");
       }));
-  EXPECT_CALL(*mock_generic_upstream_, removeUpstreamRequest(_));
+  EXPECT_CALL(*mock_generic_upstream_, resetUpstreamRequest(_));
   EXPECT_CALL(*mock_generic_upstream_, cleanUp(true));
 
   notifyUpstreamFailure(ConnectionPool::PoolFailureReason::Overflow);
@@ -454,7 +464,7 @@ TEST_F(RouterFilterTest, UpstreamRequestPoolFailureConnctionTimeout) {
       .WillOnce(Invoke([](Status status, absl::string_view, ResponseUpdateFunction) {
         EXPECT_EQ(status.message(), "connection_failure");
       }));
-  EXPECT_CALL(*mock_generic_upstream_, removeUpstreamRequest(_));
+  EXPECT_CALL(*mock_generic_upstream_, resetUpstreamRequest(_));
   EXPECT_CALL(*mock_generic_upstream_, cleanUp(true));
 
   notifyUpstreamFailure(ConnectionPool::PoolFailureReason::RemoteConnectionFailure);
@@ -476,7 +486,7 @@ TEST_F(RouterFilterTest, UpstreamRequestPoolFailureConnctionTimeoutAndWithRetryN
   // Retry, expect new upstream request to be kicked off.
   expectNewUpstreamRequest();
 
-  EXPECT_CALL(*mock_generic_upstream_, removeUpstreamRequest(_));
+  EXPECT_CALL(*mock_generic_upstream_, resetUpstreamRequest(_));
   EXPECT_CALL(*mock_generic_upstream_, cleanUp(true));
 
   notifyUpstreamFailure(ConnectionPool::PoolFailureReason::RemoteConnectionFailure);
@@ -489,7 +499,7 @@ TEST_F(RouterFilterTest, UpstreamRequestPoolFailureConnctionTimeoutAndWithRetryN
         EXPECT_EQ(status.message(), "connection_failure");
       }));
 
-  EXPECT_CALL(*mock_generic_upstream_, removeUpstreamRequest(_));
+  EXPECT_CALL(*mock_generic_upstream_, resetUpstreamRequest(_));
   EXPECT_CALL(*mock_generic_upstream_, cleanUp(true));
 
   notifyUpstreamFailure(ConnectionPool::PoolFailureReason::RemoteConnectionFailure);
@@ -515,7 +525,7 @@ TEST_F(RouterFilterTest, UpstreamRequestPoolFailureConnctionTimeoutAndWithRetryW
         EXPECT_EQ(status.message(), "connection_failure");
       }));
 
-  EXPECT_CALL(*mock_generic_upstream_, removeUpstreamRequest(_));
+  EXPECT_CALL(*mock_generic_upstream_, resetUpstreamRequest(_));
   EXPECT_CALL(*mock_generic_upstream_, cleanUp(true));
 
   notifyUpstreamFailure(ConnectionPool::PoolFailureReason::RemoteConnectionFailure);
@@ -528,6 +538,107 @@ TEST_F(RouterFilterTest, UpstreamRequestPoolFailureConnctionTimeoutAndWithRetryW
   mock_downstream_connection_.raiseEvent(Network::ConnectionEvent::RemoteClose);
 }
 
+TEST_F(RouterFilterTest, UpstreamRequestPoolFailureConnctionTimeoutAndWithRetryWithMultiplexing) {
+  setup({}, false, true);
+  RetryPolicy retry_policy{2};
+  EXPECT_CALL(mock_route_entry_, retryPolicy()).WillRepeatedly(ReturnRef(retry_policy));
+
+  kickOffNewUpstreamRequest(true);
+  expectFinalizeUpstreamSpanWithError();
+
+  // Retry, expect new upstream request to be kicked off.
+  expectNewUpstreamRequest();
+
+  // The multiplexed upstream connection is not closed for the connection failure.
+  EXPECT_CALL(*mock_generic_upstream_, resetUpstreamRequest(_));
+  EXPECT_CALL(*mock_generic_upstream_, cleanUp(false));
+
+  notifyUpstreamFailure(ConnectionPool::PoolFailureReason::RemoteConnectionFailure);
+
+  // Retry.
+  EXPECT_EQ(1, filter_->upstreamRequestsSize());
+
+  EXPECT_CALL(mock_filter_callback_, sendLocalReply(_, _, _))
+      .WillOnce(Invoke([](Status status, absl::string_view, ResponseUpdateFunction) {
+        EXPECT_EQ(status.message(), "connection_failure");
+      }));
+
+  EXPECT_CALL(*mock_generic_upstream_, resetUpstreamRequest(_));
+  EXPECT_CALL(*mock_generic_upstream_, cleanUp(false));
+
+  notifyUpstreamFailure(ConnectionPool::PoolFailureReason::RemoteConnectionFailure);
+
+  EXPECT_EQ(0, filter_->upstreamRequestsSize());
+
+  cleanUp();
+  // Mock downstream closing.
+  mock_downstream_connection_.raiseEvent(Network::ConnectionEvent::RemoteClose);
+}
+
+TEST_F(RouterFilterTest, KickOffMultiplexedUpstreamRequestAndTimeout) {
+  setup({}, false, true);
+
+  mock_route_entry_.timeout_ = std::chrono::milliseconds(1000);
+  expectResponseTimerCreate();
+
+  EXPECT_CALL(mock_filter_callback_, tracingConfig())
+      .WillOnce(Return(OptRef<const Tracing::Config>{}));
+  // The multiplexed pools of the worker are passed to the upstream factory.
+  EXPECT_CALL(mock_upstream_factory_, createGenericUpstream(_, _, _, _, false, _))
+      .WillOnce(Invoke([this](Upstream::ThreadLocalCluster&, Upstream::LoadBalancerContext*,
+                              Network::Connection&, const CodecFactory&, bool,
+                              OptRef<MultiplexedGenericUpstreamPools> multiplexed_pools) {
+        EXPECT_TRUE(multiplexed_pools.has_value());
+        return mock_generic_upstream_;
+      }));
+  EXPECT_CALL(*mock_generic_upstream_, appendUpstreamRequest(_, _));
+
+  EXPECT_EQ(filter_->decodeHeaderFrame(*request_), HeaderFilterStatus::StopIteration);
+  EXPECT_EQ(1, filter_->upstreamRequestsSize());
+
+  EXPECT_CALL(mock_filter_callback_, sendLocalReply(_, _, _))
+      .WillOnce(Invoke([this](Status status, absl::string_view, ResponseUpdateFunction) {
+        EXPECT_EQ(0, filter_->upstreamRequestsSize());
+        EXPECT_EQ(status.message(), "timeout");
+      }));
+  // The multiplexed upstream connection is shared with other requests and is not closed for
+  // the timeout of a single request. The stream id stays reserved until the response is received.
+  EXPECT_CALL(*mock_generic_upstream_, resetUpstreamRequest(_));
+  EXPECT_CALL(*mock_generic_upstream_, removeUpstreamRequest(_)).Times(0);
+  EXPECT_CALL(*mock_generic_upstream_, cleanUp(false));
+
+  response_timeout_->invokeCallback();
+
+  cleanUp();
+
+  // Mock downstream closing.
+  mock_downstream_connection_.raiseEvent(Network::ConnectionEvent::RemoteClose);
+}
+
+TEST_F(RouterFilterTest, MultiplexedUpstreamRequestPoolReadyAndRequestEncodingFailure) {
+  setup({}, false, true);
+  kickOffNewUpstreamRequest();
+
+  EXPECT_CALL(mock_generic_upstream_->mock_client_codec_, encode(_, _))
+      .WillOnce(Return(EncodingResult(absl::InvalidArgumentError("encoding-failure"))));
+
+  EXPECT_CALL(mock_filter_callback_, sendLocalReply(_, _, _))
+      .WillOnce(Invoke([this](Status status, absl::string_view data, ResponseUpdateFunction) {
+        EXPECT_EQ(0, filter_->upstreamRequestsSize());
+        EXPECT_TRUE(status.message() == "protocol_error");
+        EXPECT_EQ(data, "encoding-failure");
+      }));
+
+  // The state of the multiplexed upstream connection may be broken and it is closed.
+  EXPECT_CALL(*mock_generic_upstream_, resetUpstreamRequest(_));
+  EXPECT_CALL(*mock_generic_upstream_, cleanUp(true));
+
+  notifyUpstreamSuccess();
+
+  // Mock downstream closing.
+  mock_downstream_connection_.raiseEvent(Network::ConnectionEvent::RemoteClose);
+}
+
 TEST_F(RouterFilterTest, UpstreamRequestPoolReadyAndExpectNoResponse) {
   setup(FrameFlags(0, FrameFlags::FLAG_END_STREAM | FrameFlags::FLAG_ONE_WAY));
   kickOffNewUpstreamRequest(true);
@@ -566,7 +677,7 @@ TEST_F(RouterFilterTest, UpstreamRequestPoolReadyButConnectionErrorBeforeRespons
         EXPECT_EQ(status.message(), "local_reset");
       }));
 
-  EXPECT_CALL(*mock_generic_upstream_, removeUpstreamRequest(_));
+  EXPECT_CALL(*mock_generic_upstream_, resetUpstreamRequest(_));
   EXPECT_CALL(*mock_generic_upstream_, cleanUp(true));
 
   // Mock connection close event.
@@ -592,7 +703,7 @@ TEST_F(RouterFilterTest, UpstreamRequestPoolReadyButConnectionTerminationBeforeR
         EXPECT_EQ(status.message(), "connection_termination");
       }));
 
-  EXPECT_CALL(*mock_generic_upstream_, removeUpstreamRequest(_));
+  EXPECT_CALL(*mock_generic_upstream_, resetUpstreamRequest(_));
   EXPECT_CALL(*mock_generic_upstream_, cleanUp(true));
 
   // Mock connection close event.
@@ -610,7 +721,7 @@ TEST_F(RouterFilterTest, UpstreamRequestPoolReadyButStreamDestroyBeforeResponse)
 
   notifyUpstreamSuccess();
 
-  EXPECT_CALL(*mock_generic_upstream_, removeUpstreamRequest(_));
+  EXPECT_CALL(*mock_generic_upstream_, resetUpstreamRequest(_));
   EXPECT_CALL(*mock_generic_upstream_, cleanUp(true));
 
   filter_->onDestroy();
@@ -766,7 +877,7 @@ TEST_F(RouterFilterTest, UpstreamRequestPoolReadyButEncodingFailure) {
   EXPECT_CALL(mock_generic_upstream_->mock_client_codec_, encode(_, _))
       .WillOnce(Return(absl::UnknownError("encode-failure")));
 
-  EXPECT_CALL(*mock_generic_upstream_, removeUpstreamRequest(_));
+  EXPECT_CALL(*mock_generic_upstream_, resetUpstreamRequest(_));
   EXPECT_CALL(*mock_generic_upstream_, cleanUp(true));
   expectFinalizeUpstreamSpanAny();
 
@@ -855,7 +966,7 @@ TEST_F(RouterFilterTest,
   response->stream_frame_flags_ = FrameFlags(0, FrameFlags::FLAG_EMPTY);
   notifyDecodingSuccess(std::move(response));
 
-  EXPECT_CALL(*mock_generic_upstream_, removeUpstreamRequest(_));
+  EXPECT_CALL(*mock_generic_upstream_, resetUpstreamRequest(_));
   EXPECT_CALL(*mock_generic_upstream_, cleanUp(true));
 
   auto response_2 = std::make_unique<FakeStreamCodecFactory::FakeResponse>();
@@ -880,7 +991,7 @@ TEST_F(RouterFilterTest,
   auto response = std::make_unique<FakeStreamCodecFactory::FakeCommonFrame>();
   response->stream_frame_flags_ = FrameFlags(0, FrameFlags::FLAG_EMPTY);
 
-  EXPECT_CALL(*mock_generic_upstream_, removeUpstreamRequest(_));
+  EXPECT_CALL(*mock_generic_upstream_, resetUpstreamRequest(_));
   EXPECT_CALL(*mock_generic_upstream_, cleanUp(true));
 
   notifyDecodingSuccess(std::move(response));
@@ -898,7 +1009,8 @@ TEST_F(RouterFilterTest, UpstreamRequestPoolReadyAndResponseWithDrainCloseSetInR
   notifyUpstreamSuccess();
 
   EXPECT_CALL(*mock_generic_upstream_, removeUpstreamRequest(_));
-  EXPECT_CALL(*mock_generic_upstream_, cleanUp(true));
+  EXPECT_CALL(*mock_generic_upstream_, drainConnection());
+  EXPECT_CALL(*mock_generic_upstream_, cleanUp(_)).Times(0);
 
   EXPECT_CALL(mock_filter_callback_, onResponseHeaderFrame(_)).WillOnce(Invoke([this](ResponsePtr) {
     // When the response is sent to callback, the upstream request should be removed.
@@ -929,7 +1041,7 @@ TEST_F(RouterFilterTest, UpstreamRequestPoolReadyAndResponseDecodingFailure) {
         EXPECT_EQ(data, "decoding-failure");
       }));
 
-  EXPECT_CALL(*mock_generic_upstream_, removeUpstreamRequest(_));
+  EXPECT_CALL(*mock_generic_upstream_, resetUpstreamRequest(_));
   EXPECT_CALL(*mock_generic_upstream_, cleanUp(true));
 
   notifyDecodingFailure("decoding-failure");
@@ -952,7 +1064,7 @@ TEST_F(RouterFilterTest, UpstreamRequestPoolReadyAndRequestEncodingFailure) {
         EXPECT_EQ(data, "encoding-failure");
       }));
 
-  EXPECT_CALL(*mock_generic_upstream_, removeUpstreamRequest(_));
+  EXPECT_CALL(*mock_generic_upstream_, resetUpstreamRequest(_));
   EXPECT_CALL(*mock_generic_upstream_, cleanUp(true));
 
   notifyUpstreamSuccess();
@@ -0,0 +1,138 @@
+// Note: this should be run with --compilation_mode=opt, and would benefit from a
+// quiescent system with disabled cstate power management.
+
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "source/common/buffer/buffer_impl.h"
+#include "source/extensions/filters/network/generic_proxy/router/upstream.h"
+
+#include "test/extensions/filters/network/generic_proxy/fake_codec.h"
+#include "test/mocks/network/connection.h"
+#include "test/mocks/tcp/mocks.h"
+#include "test/mocks/upstream/thread_local_cluster.h"
+
+#include "benchmark/benchmark.h"
+
+using testing::_;
+using testing::NiceMock;
+
+namespace Envoy {
+namespace Extensions {
+namespace NetworkFilters {
+namespace GenericProxy {
+namespace Router {
+namespace {
+
+constexpr uint64_t RequestsPerIteration = 256;
+
+// A warmed up connection pool which hands out the upstream connections synchronously and
+// reuses the connections that are released back to it.
+class FakeTcpConnPool {
+public:
+  FakeTcpConnPool() {
+    ON_CALL(pool_, newConnection(_))
+        .WillByDefault(testing::Invoke(
+            [this](Tcp::ConnectionPool::Callbacks& callbacks) -> Tcp::ConnectionPool::Cancellable* {
+              Network::MockClientConnection* connection = nullptr;
+              if (idle_connections_.empty()) {
+                connection = &connections_.emplace_back();
+              } else {
+                connection = idle_connections_.back();
+                idle_connections_.pop_back();
+              }
+
+              auto data = std::make_unique<NiceMock<Tcp::ConnectionPool::MockConnectionData>>();
+              ON_CALL(*data, connection()).WillByDefault(testing::ReturnRef(*connection));
+              data->release_callback_ = [this, connection]() {
+                idle_connections_.push_back(connection);
+              };
+              callbacks.onPoolReady(std::move(data), pool_.host_);
+              return nullptr;
+            }));
+  }
+
+  NiceMock<Tcp::ConnectionPool::MockInstance> pool_;
+  std::list<NiceMock<Network::MockClientConnection>> connections_;
+  std::vector<Network::MockClientConnection*> idle_connections_;
+};
+
+class BenchmarkUpstreamRequest : public UpstreamRequestCallbacks {
+public:
+  // UpstreamRequestCallbacks
+  void onUpstreamFailure(ConnectionPool::PoolFailureReason, absl::string_view) override {}
+  void onUpstreamSuccess() override {}
+  void onConnectionClose(Network::ConnectionEvent) override {}
+  void onDecodingSuccess(ResponseHeaderFramePtr, absl::optional<StartTime>) override {
+    upstream_->removeUpstreamRequest(stream_id_);
+    upstream_->cleanUp(false);
+  }
+  void onDecodingSuccess(ResponseCommonFramePtr) override {}
+  void onDecodingFailure(absl::string_view) override {}
+
+  std::shared_ptr<MultiplexedGenericUpstreamHandle> upstream_;
+  uint64_t stream_id_{};
+};
+
+std::string fakeResponse(uint64_t stream_id) {
+  const std::string body = fmt::format("FAKE-RSP|stream_id:{};status_code:0;", stream_id);
+  Buffer::OwnedImpl buffer;
+  buffer.writeBEInt<uint32_t>(body.size());
+  buffer.add(body);
+  return buffer.toString();
+}
+
+// Starts RequestsPerIteration requests on the multiplexed upstreams of one host and then
+// completes them with their responses. At most `range(0)` requests are active on an upstream
+// connection at the same time. The requests use `range(1)` different stream ids, as the requests
+// of different downstream connections do, and requests with the same stream id are never sent on
+// the same upstream connection.
+void bmMultiplexedUpstreamRequests(benchmark::State& state) {
+  FakeTcpConnPool conn_pool;
+  NiceMock<Upstream::MockThreadLocalCluster> cluster;
+  ON_CALL(cluster, tcpConnPool(_, _))
+      .WillByDefault(testing::Return(Upstream::TcpPoolData([]() {}, &conn_pool.pool_)));
+  NiceMock<Network::MockServerConnection> downstream_connection;
+  FakeStreamCodecFactory codec_factory;
+  MultiplexedGenericUpstreamPools pools(state.range(0));
+  const uint64_t stream_ids = state.range(1);
+
+  std::vector<std::string> responses;
+  for (uint64_t i = 0; i < stream_ids; i++) {
+    responses.push_back(fakeResponse(i + 1));
+  }
+  std::vector<BenchmarkUpstreamRequest> requests(RequestsPerIteration);
+  for (uint64_t i = 0; i < RequestsPerIteration; i++) {
+    requests[i].stream_id_ = i % stream_ids + 1;
+  }
+
+  for (auto _ : state) {
+    UNREFERENCED_PARAMETER(_);
+    for (auto& request : requests) {
+      request.upstream_ = std::static_pointer_cast<MultiplexedGenericUpstreamHandle>(
+          DefaultGenericUpstreamFactory::get().createGenericUpstream(
+              cluster, nullptr, downstream_connection, codec_factory, false, pools));
+      request.upstream_->appendUpstreamRequest(request.stream_id_, &request);
+    }
+    for (auto& request : requests) {
+      Buffer::OwnedImpl buffer(responses[request.stream_id_ - 1]);
+      const auto upstream = request.upstream_->upstream();
+      upstream->onUpstreamData(buffer, false);
+      request.upstream_.reset();
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * RequestsPerIteration);
+  state.counters["upstream_connections"] = conn_pool.connections_.size();
+}
+BENCHMARK(bmMultiplexedUpstreamRequests)
+    ->ArgsProduct({{1, 16, 128}, {1, 16, RequestsPerIteration}})
+    ->Unit(benchmark::kMicrosecond);
+
+} // namespace
+} // namespace Router
+} // namespace GenericProxy
+} // namespace NetworkFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -29,13 +29,13 @@ public:
   MockUpstreamRequestCallbacks() {
     ON_CALL(*this, onUpstreamFailure(_, _)).WillByDefault(testing::Invoke([&](auto, auto) {
       if (upstream_ != nullptr) {
-        upstream_->removeUpstreamRequest(1);
+        upstream_->removeUpstreamRequest(stream_id_);
         upstream_->cleanUp(true);
       }
     }));
     ON_CALL(*this, onConnectionClose(_)).WillByDefault(testing::Invoke([&](auto) {
       if (upstream_ != nullptr) {
-        upstream_->removeUpstreamRequest(1);
+        upstream_->removeUpstreamRequest(stream_id_);
         upstream_->cleanUp(true);
       }
     }));
@@ -44,7 +44,11 @@ public:
           if (upstream_ != nullptr) {
             if (frame->frameFlags().endStream()) {
               upstream_->removeUpstreamRequest(frame->frameFlags().streamId());
-              upstream_->cleanUp(false);
+              if (frame->frameFlags().drainClose()) {
+                upstream_->drainConnection();
+              } else {
+                upstream_->cleanUp(false);
+              }
             }
           }
         }));
@@ -53,13 +57,17 @@ public:
           if (upstream_ != nullptr) {
             if (frame->frameFlags().endStream()) {
               upstream_->removeUpstreamRequest(frame->frameFlags().streamId());
-              upstream_->cleanUp(false);
+              if (frame->frameFlags().drainClose()) {
+                upstream_->drainConnection();
+              } else {
+                upstream_->cleanUp(false);
+              }
             }
           }
         }));
     ON_CALL(*this, onDecodingFailure(_)).WillByDefault(testing::Invoke([&](auto) {
       if (upstream_ != nullptr) {
-        upstream_->removeUpstreamRequest(1);
+        upstream_->removeUpstreamRequest(stream_id_);
         upstream_->cleanUp(true);
       }
     }));
@@ -77,6 +85,7 @@ public:
   MOCK_METHOD(void, onDecodingFailure, (absl::string_view reason));
 
   GenericUpstream* upstream_{};
+  uint64_t stream_id_{1};
 };
 
 TEST(SenseLessTest, SenseLessTest) {
@@ -114,19 +123,31 @@ public:
   std::shared_ptr<BoundGenericUpstream> createBoundGenericUpstream(size_t connection_id = 1) {
     if (connection_id == 1) {
       auto result = DefaultGenericUpstreamFactory::get().createGenericUpstream(
-          thread_local_cluster_, nullptr, mock_downstream_connection_1_, mock_codec_factory_, true);
+          thread_local_cluster_, nullptr, mock_downstream_connection_1_, mock_codec_factory_, true,
+          {});
       return std::dynamic_pointer_cast<BoundGenericUpstream>(result);
     } else {
       auto result = DefaultGenericUpstreamFactory::get().createGenericUpstream(
-          thread_local_cluster_, nullptr, mock_downstream_connection_2_, mock_codec_factory_, true);
+          thread_local_cluster_, nullptr, mock_downstream_connection_2_, mock_codec_factory_, true,
+          {});
       return std::dynamic_pointer_cast<BoundGenericUpstream>(result);
     }
   }
   std::shared_ptr<OwnedGenericUpstream> createOwnedGenericUpstream() {
     auto result = DefaultGenericUpstreamFactory::get().createGenericUpstream(
-        thread_local_cluster_, nullptr, mock_downstream_connection_1_, mock_codec_factory_, false);
+        thread_local_cluster_, nullptr, mock_downstream_connection_1_, mock_codec_factory_, false,
+        {});
     return std::dynamic_pointer_cast<OwnedGenericUpstream>(result);
   }
+  std::shared_ptr<MultiplexedGenericUpstreamHandle>
+  createMultiplexedGenericUpstream(size_t connection_id = 1) {
+    auto& downstream_connection =
+        connection_id == 1 ? mock_downstream_connection_1_ : mock_downstream_connection_2_;
+    auto result = DefaultGenericUpstreamFactory::get().createGenericUpstream(
+        thread_local_cluster_, nullptr, downstream_connection, mock_codec_factory_, false,
+        multiplexed_pools_);
+    return std::dynamic_pointer_cast<MultiplexedGenericUpstreamHandle>(result);
+  }
 
   NiceMock<Upstream::MockThreadLocalCluster> thread_local_cluster_;
   NiceMock<MockCodecFactory> mock_codec_factory_;
@@ -139,6 +160,9 @@ public:
 
   NiceMock<Network::MockServerConnection> mock_downstream_connection_1_;
   NiceMock<Network::MockServerConnection> mock_downstream_connection_2_;
+
+  // At most two requests could be active on one multiplexed upstream connection.
+  MultiplexedGenericUpstreamPools multiplexed_pools_{2};
 };
 
 TEST_F(UpstreamTest, BoundGenericUpstreamWillBeReusedForSameConnection) {
@@ -935,6 +959,480 @@ TEST_F(UpstreamTest, OwnedGenericUpstreamUpstreamConnectionClose) {
   EXPECT_EQ(0, generic_upstream->waitingResponseRequestsSize());
 }
 
+TEST_F(UpstreamTest, MultiplexedGenericUpstreamNoHealthyUpstream) {
+  EXPECT_CALL(thread_local_cluster_, tcpConnPool(_, _)).WillOnce(Return(absl::nullopt));
+  auto generic_upstream = createMultiplexedGenericUpstream();
+  EXPECT_EQ(nullptr, generic_upstream);
+  EXPECT_EQ(0, multiplexed_pools_.poolsSize());
+}
+
+TEST_F(UpstreamTest, MultiplexedGenericUpstreamWillBeSharedByDownstreamConnections) {
+  EXPECT_CALL(thread_local_cluster_, tcpConnPool(_, _)).Times(3);
+  auto generic_upstream1 = createMultiplexedGenericUpstream(1);
+  auto generic_upstream2 = createMultiplexedGenericUpstream(2);
+  auto generic_upstream3 = createMultiplexedGenericUpstream(1);
+
+  NiceMock<MockUpstreamRequestCallbacks> mock_upstream_request_callbacks_1;
+  NiceMock<MockUpstreamRequestCallbacks> mock_upstream_request_callbacks_2;
+  NiceMock<MockUpstreamRequestCallbacks> mock_upstream_request_callbacks_3;
+
+  // The first two requests share the same upstream connection.
+  EXPECT_CALL(thread_local_cluster_.tcp_conn_pool_, newConnection(_));
+  generic_upstream1->appendUpstreamRequest(1, &mock_upstream_request_callbacks_1);
+  generic_upstream2->appendUpstreamRequest(2, &mock_upstream_request_callbacks_2);
+
+  EXPECT_EQ(generic_upstream1->upstream(), generic_upstream2->upstream());
+  EXPECT_EQ(2, generic_upstream1->upstream()->waitingUpstreamRequestsSize());
+  EXPECT_EQ(1, multiplexed_pools_.poolsSize());
+
+  // The third request creates a new upstream connection because the first one is full.
+  EXPECT_CALL(thread_local_cluster_.tcp_conn_pool_, newConnection(_));
+  generic_upstream3->appendUpstreamRequest(3, &mock_upstream_request_callbacks_3);
+
+  EXPECT_NE(generic_upstream1->upstream(), generic_upstream3->upstream());
+  EXPECT_EQ(1, generic_upstream3->upstream()->waitingUpstreamRequestsSize());
+  EXPECT_EQ(1, multiplexed_pools_.poolsSize());
+
+  testing::InSequence sequence;
+  EXPECT_CALL(mock_upstream_request_callbacks_1, onUpstreamSuccess());
+  EXPECT_CALL(mock_upstream_request_callbacks_2, onUpstreamSuccess());
+
+  thread_local_cluster_.tcp_conn_pool_.poolReady(mock_upstream_connection_);
+
+  EXPECT_EQ(0, generic_upstream1->upstream()->waitingUpstreamRequestsSize());
+  EXPECT_EQ(2, generic_upstream1->upstream()->waitingResponseRequestsSize());
+  EXPECT_EQ(generic_upstream1->upstreamConnection().ptr(), &mock_upstream_connection_);
+  EXPECT_EQ(generic_upstream1->upstreamHost(), thread_local_cluster_.tcp_conn_pool_.host_);
+  EXPECT_EQ(&generic_upstream1->clientCodec(), mock_client_codec_raw_);
+
+  // Cancel the pending connection of the second upstream.
+  EXPECT_CALL(thread_local_cluster_.tcp_conn_pool_.handles_.front(), cancel(_));
+  generic_upstream3->removeUpstreamRequest(3);
+  generic_upstream3->cleanUp(false);
+
+  EXPECT_FALSE(generic_upstream3->upstream()->attached());
+  EXPECT_TRUE(generic_upstream1->upstream()->attached());
+}
+
+TEST_F(UpstreamTest, MultiplexedGenericUpstreamWillNotBeSharedBySameStreamId) {
+  EXPECT_CALL(thread_local_cluster_, tcpConnPool(_, _)).Times(3);
+  auto generic_upstream1 = createMultiplexedGenericUpstream(1);
+  auto generic_upstream2 = createMultiplexedGenericUpstream(2);
+  auto generic_upstream3 = createMultiplexedGenericUpstream(2);
+
+  NiceMock<MockUpstreamRequestCallbacks> mock_upstream_request_callbacks_1;
+  NiceMock<MockUpstreamRequestCallbacks> mock_upstream_request_callbacks_2;
+  NiceMock<MockUpstreamRequestCallbacks> mock_upstream_request_callbacks_3;
+
+  EXPECT_CALL(thread_local_cluster_.tcp_conn_pool_, newConnection(_)).Times(2);
+  generic_upstream1->appendUpstreamRequest(1, &mock_upstream_request_callbacks_1);
+  // The stream id is already used by the request on the first upstream.
+  generic_upstream2->appendUpstreamRequest(1, &mock_upstream_request_callbacks_2);
+  // The first upstream is picked again because it has no request with stream id 2.
+  generic_upstream3->appendUpstreamRequest(2, &mock_upstream_request_callbacks_3);
+
+  EXPECT_NE(generic_upstream1->upstream(), generic_upstream2->upstream());
+  EXPECT_EQ(generic_upstream1->upstream(), generic_upstream3->upstream());
+
+  // Reset all the requests before the upstream connections are ready.
+  EXPECT_CALL(thread_local_cluster_.tcp_conn_pool_.handles_.front(), cancel(_));
+  EXPECT_CALL(thread_local_cluster_.tcp_conn_pool_.handles_.back(), cancel(_));
+
+  generic_upstream1->removeUpstreamRequest(1);
+  generic_upstream1->cleanUp(false);
+  // The first upstream is still used by the third request.
+  EXPECT_TRUE(generic_upstream1->upstream()->attached());
+
+  generic_upstream3->removeUpstreamRequest(2);
+  generic_upstream3->cleanUp(false);
+  generic_upstream2->removeUpstreamRequest(1);
+  generic_upstream2->cleanUp(false);
+
+  EXPECT_FALSE(generic_upstream1->upstream()->attached());
+  EXPECT_FALSE(generic_upstream2->upstream()->attached());
+  EXPECT_EQ(0, multiplexed_pools_.poolsSize());
+}
+
+TEST_F(UpstreamTest, MultiplexedGenericUpstreamOnPoolFailure) {
+  EXPECT_CALL(thread_local_cluster_, tcpConnPool(_, _)).Times(2);
+  auto generic_upstream1 = createMultiplexedGenericUpstream(1);
+  auto generic_upstream2 = createMultiplexedGenericUpstream(2);
+
+  NiceMock<MockUpstreamRequestCallbacks> mock_upstream_request_callbacks_1;
+  mock_upstream_request_callbacks_1.upstream_ = generic_upstream1.get();
+  NiceMock<MockUpstreamRequestCallbacks> mock_upstream_request_callbacks_2;
+  mock_upstream_request_callbacks_2.upstream_ = generic_upstream2.get();
+  mock_upstream_request_callbacks_2.stream_id_ = 2;
+
+  EXPECT_CALL(thread_local_cluster_.tcp_conn_pool_, newConnection(_));
+  generic_upstream1->appendUpstreamRequest(1, &mock_upstream_request_callbacks_1);
+  generic_upstream2->appendUpstreamRequest(2, &mock_upstream_request_callbacks_2);
+
+  EXPECT_CALL(mock_upstream_request_callbacks_1, onUpstreamFailure(_, _));
+  EXPECT_CALL(mock_upstream_request_callbacks_2, onUpstreamFailure(_, _));
+
+  thread_local_cluster_.tcp_conn_pool_.poolFailure(
+      ConnectionPool::PoolFailureReason::RemoteConnectionFailure);
+
+  EXPECT_FALSE(generic_upstream1->upstream()->attached());
+  EXPECT_EQ(0, generic_upstream1->upstream()->activeRequestsSize());
+  EXPECT_EQ(0, multiplexed_pools_.poolsSize());
+
+  // The failed upstream will not be picked again.
+  EXPECT_CALL(thread_local_cluster_, tcpConnPool(_, _));
+  auto generic_upstream3 = createMultiplexedGenericUpstream(1);
+
+  NiceMock<MockUpstreamRequestCallbacks> mock_upstream_request_callbacks_3;
+  EXPECT_CALL(thread_local_cluster_.tcp_conn_pool_, newConnection(_));
+  generic_upstream3->appendUpstreamRequest(1, &mock_upstream_request_callbacks_3);
+
+  EXPECT_NE(generic_upstream1->upstream(), generic_upstream3->upstream());
+  EXPECT_EQ(1, multiplexed_pools_.poolsSize());
+}
+
+TEST_F(UpstreamTest, MultiplexedGenericUpstreamDecodingSuccessAndRelease) {
+  EXPECT_CALL(thread_local_cluster_, tcpConnPool(_, _)).Times(2);
+  auto generic_upstream1 = createMultiplexedGenericUpstream(1);
+  auto generic_upstream2 = createMultiplexedGenericUpstream(2);
+
+  NiceMock<MockUpstreamRequestCallbacks> mock_upstream_request_callbacks_1;
+  mock_upstream_request_callbacks_1.upstream_ = generic_upstream1.get();
+  NiceMock<MockUpstreamRequestCallbacks> mock_upstream_request_callbacks_2;
+  mock_upstream_request_callbacks_2.upstream_ = generic_upstream2.get();
+  mock_upstream_request_callbacks_2.stream_id_ = 2;
+
+  EXPECT_CALL(thread_local_cluster_.tcp_conn_pool_, newConnection(_));
+  generic_upstream1->appendUpstreamRequest(1, &mock_upstream_request_callbacks_1);
+  generic_upstream2->appendUpstreamRequest(2, &mock_upstream_request_callbacks_2);
+
+  auto upstream = generic_upstream1->upstream();
+
+  EXPECT_CALL(*thread_local_cluster_.tcp_conn_pool_.connection_data_, addUpstreamCallbacks(_))
+      .WillOnce(testing::Invoke([&](Tcp::ConnectionPool::UpstreamCallbacks& cb) {
+        mock_upstream_connection_.addConnectionCallbacks(cb);
+      }));
+  thread_local_cluster_.tcp_conn_pool_.poolReady(mock_upstream_connection_);
+
+  EXPECT_EQ(0, upstream->waitingUpstreamRequestsSize());
+  EXPECT_EQ(2, upstream->waitingResponseRequestsSize());
+
+  auto response_1 = std::make_unique<FakeStreamCodecFactory::FakeResponse>();
+  response_1->stream_frame_flags_ = FrameFlags(1);
+
+  auto response_2 = std::make_unique<FakeStreamCodecFactory::FakeResponse>();
+  response_2->stream_frame_flags_ = FrameFlags(2);
+
+  EXPECT_CALL(*mock_client_codec_raw_, decode(_, _))
+      .WillOnce(testing::Invoke([&](Buffer::Instance&, bool) {
+        // The responses are matched to the requests by the stream id.
+        EXPECT_CALL(mock_upstream_request_callbacks_2, onDecodingSuccess(_, _));
+        cocec_callbacks_->onDecodingSuccess(std::move(response_2), {});
+
+        // The connection is still used by the first request.
+        EXPECT_TRUE(upstream->attached());
+
+        // The connection is released back to the connection pool rather than closed after the
+        // last response.
+        EXPECT_CALL(mock_upstream_request_callbacks_1, onDecodingSuccess(_, _));
+        EXPECT_CALL(mock_upstream_connection_, close(_)).Times(0);
+        EXPECT_CALL(thread_local_cluster_.tcp_conn_pool_,
+                    released(testing::Ref(mock_upstream_connection_)));
+        cocec_callbacks_->onDecodingSuccess(std::move(response_1), {});
+      }));
+
+  Buffer::OwnedImpl fake_buffer;
+  fake_buffer.add("fake data");
+  upstream->onUpstreamData(fake_buffer, false);
+
+  EXPECT_FALSE(upstream->attached());
+  EXPECT_EQ(0, upstream->activeRequestsSize());
+  EXPECT_FALSE(upstream->upstreamConnection().has_value());
+  EXPECT_EQ(0, multiplexed_pools_.poolsSize());
+}
+
+TEST_F(UpstreamTest, MultiplexedGenericUpstreamReserveStreamIdOfResetRequest) {
+  EXPECT_CALL(thread_local_cluster_, tcpConnPool(_, _)).Times(3);
+  auto generic_upstream1 = createMultiplexedGenericUpstream(1);
+  auto generic_upstream2 = createMultiplexedGenericUpstream(2);
+  auto generic_upstream3 = createMultiplexedGenericUpstream(2);
+
+  NiceMock<MockUpstreamRequestCallbacks> mock_upstream_request_callbacks_1;
+  NiceMock<MockUpstreamRequestCallbacks> mock_upstream_request_callbacks_2;
+  mock_upstream_request_callbacks_2.upstream_ = generic_upstream2.get();
+  mock_upstream_request_callbacks_2.stream_id_ = 2;
+  NiceMock<MockUpstreamRequestCallbacks> mock_upstream_request_callbacks_3;
+
+  EXPECT_CALL(thread_local_cluster_.tcp_conn_pool_, newConnection(_));
+  generic_upstream1->appendUpstreamRequest(1, &mock_upstream_request_callbacks_1);
+  generic_upstream2->appendUpstreamRequest(2, &mock_upstream_request_callbacks_2);
+
+  auto upstream = generic_upstream1->upstream();
+
+  EXPECT_CALL(*thread_local_cluster_.tcp_conn_pool_.connection_data_, addUpstreamCallbacks(_))
+      .WillOnce(testing::Invoke([&](Tcp::ConnectionPool::UpstreamCallbacks& cb) {
+        mock_upstream_connection_.addConnectionCallbacks(cb);
+      }));
+  thread_local_cluster_.tcp_conn_pool_.poolReady(mock_upstream_connection_);
+
+  // The first request is reset locally, for example because of a timeout, after it is sent. The
+  // connection is kept for the second request and the stream id is reserved for the late response.
+  EXPECT_CALL(mock_upstream_connection_, close(_)).Times(0);
+  EXPECT_CALL(thread_local_cluster_.tcp_conn_pool_, released(_)).Times(0);
+  generic_upstream1->resetUpstreamRequest(1);
+  generic_upstream1->cleanUp(false);
+
+  EXPECT_TRUE(upstream->attached());
+  EXPECT_TRUE(upstream->containsRequest(1));
+  EXPECT_EQ(2, upstream->waitingResponseRequestsSize());
+  EXPECT_EQ(1, upstream->resetRequestsSize());
+
+  // A new request with the same stream id will not be sent on the connection.
+  EXPECT_CALL(thread_local_cluster_.tcp_conn_pool_, newConnection(_));
+  generic_upstream3->appendUpstreamRequest(1, &mock_upstream_request_callbacks_3);
+  EXPECT_NE(upstream, generic_upstream3->upstream());
+
+  EXPECT_CALL(thread_local_cluster_.tcp_conn_pool_.handles_.back(), cancel(_));
+  generic_upstream3->removeUpstreamRequest(1);
+  generic_upstream3->cleanUp(false);
+
+  auto response_1 = std::make_unique<FakeStreamCodecFactory::FakeResponse>();
+  response_1->stream_frame_flags_ = FrameFlags(1);
+  auto response_2 = std::make_unique<FakeStreamCodecFactory::FakeResponse>();
+  response_2->stream_frame_flags_ = FrameFlags(2);
+
+  EXPECT_CALL(*mock_client_codec_raw_, decode(_, _))
+      .WillOnce(testing::Invoke([&](Buffer::Instance&, bool) {
+        // The late response of the reset request is dropped.
+        EXPECT_CALL(mock_upstream_request_callbacks_1, onDecodingSuccess(_, _)).Times(0);
+        cocec_callbacks_->onDecodingSuccess(std::move(response_1), {});
+        EXPECT_EQ(0, upstream->resetRequestsSize());
+
+        // The connection is released back to the connection pool after the last response.
+        EXPECT_CALL(mock_upstream_request_callbacks_2, onDecodingSuccess(_, _));
+        EXPECT_CALL(thread_local_cluster_.tcp_conn_pool_,
+                    released(testing::Ref(mock_upstream_connection_)));
+        cocec_callbacks_->onDecodingSuccess(std::move(response_2), {});
+      }));
+
+  Buffer::OwnedImpl fake_buffer;
+  fake_buffer.add("fake data");
+  upstream->onUpstreamData(fake_buffer, false);
+
+  EXPECT_FALSE(upstream->attached());
+  EXPECT_EQ(0, upstream->activeRequestsSize());
+  EXPECT_EQ(0, multiplexed_pools_.poolsSize());
+}
+
+TEST_F(UpstreamTest, MultiplexedGenericUpstreamCloseConnectionOfUnansweredResetRequest) {
+  EXPECT_CALL(thread_local_cluster_, tcpConnPool(_, _)).Times(2);
+  auto generic_upstream1 = createMultiplexedGenericUpstream(1);
+  auto generic_upstream2 = createMultiplexedGenericUpstream(2);
+
+  NiceMock<MockUpstreamRequestCallbacks> mock_upstream_request_callbacks_1;
+  NiceMock<MockUpstreamRequestCallbacks> mock_upstream_request_callbacks_2;
+  mock_upstream_request_callbacks_2.upstream_ = generic_upstream2.get();
+  mock_upstream_request_callbacks_2.stream_id_ = 2;
+
+  EXPECT_CALL(thread_local_cluster_.tcp_conn_pool_, newConnection(_));
+  generic_upstream1->appendUpstreamRequest(1, &mock_upstream_request_callbacks_1);
+  generic_upstream2->appendUpstreamRequest(2, &mock_upstream_request_callbacks_2);
+
+  auto upstream = generic_upstream1->upstream();
+
+  EXPECT_CALL(*thread_local_cluster_.tcp_conn_pool_.connection_data_, addUpstreamCallbacks(_))
+      .WillOnce(testing::Invoke([&](Tcp::ConnectionPool::UpstreamCallbacks& cb) {
+        mock_upstream_connection_.addConnectionCallbacks(cb);
+      }));
+  thread_local_cluster_.tcp_conn_pool_.poolReady(mock_upstream_connection_);
+
+  generic_upstream1->resetUpstreamRequest(1);
+  generic_upstream1->cleanUp(false);
+  EXPECT_TRUE(upstream->attached());
+
+  auto response_2 = std::make_unique<FakeStreamCodecFactory::FakeResponse>();
+  response_2->stream_frame_flags_ = FrameFlags(2);
+
+  // The upstream never answers the reset request. Once the second request is complete, only the
+  // reserved stream id is left on the connection and the connection is closed rather than kept
+  // for a response which may never be received.
+  EXPECT_CALL(*mock_client_codec_raw_, decode(_, _))
+      .WillOnce(testing::Invoke([&](Buffer::Instance&, bool) {
+        EXPECT_CALL(mock_upstream_request_callbacks_2, onDecodingSuccess(_, _));
+        EXPECT_CALL(mock_upstream_connection_, close(_));
+        EXPECT_CALL(thread_local_cluster_.tcp_conn_pool_, released(_)).Times(0);
+        cocec_callbacks_->onDecodingSuccess(std::move(response_2), {});
+      }));
+
+  // The reset request is not notified of the connection close.
+  EXPECT_CALL(mock_upstream_request_callbacks_1, onConnectionClose(_)).Times(0);
+
+  Buffer::OwnedImpl fake_buffer;
+  fake_buffer.add("fake data");
+  upstream->onUpstreamData(fake_buffer, false);
+
+  EXPECT_FALSE(upstream->attached());
+  EXPECT_EQ(0, upstream->activeRequestsSize());
+  EXPECT_EQ(0, multiplexed_pools_.poolsSize());
+}
+
+TEST_F(UpstreamTest, MultiplexedGenericUpstreamCloseConnectionOfOnlyResetRequest) {
+  EXPECT_CALL(thread_local_cluster_, tcpConnPool(_, _));
+  auto generic_upstream = createMultiplexedGenericUpstream();
+
+  NiceMock<MockUpstreamRequestCallbacks> mock_upstream_request_callbacks_1;
+
+  EXPECT_CALL(thread_local_cluster_.tcp_conn_pool_, newConnection(_));
+  generic_upstream->appendUpstreamRequest(1, &mock_upstream_request_callbacks_1);
+
+  EXPECT_CALL(*thread_local_cluster_.tcp_conn_pool_.connection_data_, addUpstreamCallbacks(_))
+      .WillOnce(testing::Invoke([&](Tcp::ConnectionPool::UpstreamCallbacks& cb) {
+        mock_upstream_connection_.addConnectionCallbacks(cb);
+      }));
+  thread_local_cluster_.tcp_conn_pool_.poolReady(mock_upstream_connection_);
+
+  // No other request is using the connection, so it is closed right away and the stream id of
+  // the reset request is released. The reset request is not notified of the close.
+  EXPECT_CALL(mock_upstream_connection_, close(_));
+  EXPECT_CALL(mock_upstream_request_callbacks_1, onConnectionClose(_)).Times(0);
+  generic_upstream->resetUpstreamRequest(1);
+  generic_upstream->cleanUp(false);
+
+  EXPECT_FALSE(generic_upstream->upstream()->attached());
+  EXPECT_EQ(0, generic_upstream->upstream()->activeRequestsSize());
+  EXPECT_EQ(0, multiplexed_pools_.poolsSize());
+}
+
+TEST_F(UpstreamTest, MultiplexedGenericUpstreamDrainCloseWaitsForOtherRequests) {
+  EXPECT_CALL(thread_local_cluster_, tcpConnPool(_, _)).Times(3);
+  auto generic_upstream1 = createMultiplexedGenericUpstream(1);
+  auto generic_upstream2 = createMultiplexedGenericUpstream(2);
+
+  NiceMock<MockUpstreamRequestCallbacks> mock_upstream_request_callbacks_1;
+  mock_upstream_request_callbacks_1.upstream_ = generic_upstream1.get();
+  NiceMock<MockUpstreamRequestCallbacks> mock_upstream_request_callbacks_2;
+  mock_upstream_request_callbacks_2.upstream_ = generic_upstream2.get();
+  mock_upstream_request_callbacks_2.stream_id_ = 2;
+
+  EXPECT_CALL(thread_local_cluster_.tcp_conn_pool_, newConnection(_));
+  generic_upstream1->appendUpstreamRequest(1, &mock_upstream_request_callbacks_1);
+  generic_upstream2->appendUpstreamRequest(2, &mock_upstream_request_callbacks_2);
+
+  auto upstream = generic_upstream1->upstream();
+
+  EXPECT_CALL(*thread_local_cluster_.tcp_conn_pool_.connection_data_, addUpstreamCallbacks(_))
+      .WillOnce(testing::Invoke([&](Tcp::ConnectionPool::UpstreamCallbacks& cb) {
+        mock_upstream_connection_.addConnectionCallbacks(cb);
+      }));
+  thread_local_cluster_.tcp_conn_pool_.poolReady(mock_upstream_connection_);
+
+  auto response_1 = std::make_unique<FakeStreamCodecFactory::FakeResponse>();
+  response_1->stream_frame_flags_ =
+      FrameFlags(1, FrameFlags::FLAG_END_STREAM | FrameFlags::FLAG_DRAIN_CLOSE);
+  auto response_2 = std::make_unique<FakeStreamCodecFactory::FakeResponse>();
+  response_2->stream_frame_flags_ = FrameFlags(2);
+
+  // The first response asks to close the connection. The connection is no longer picked for new
+  // requests, but the second request still waits for its response on it.
+  EXPECT_CALL(*mock_client_codec_raw_, decode(_, _))
+      .WillOnce(testing::Invoke([&](Buffer::Instance&, bool) {
+        EXPECT_CALL(mock_upstream_request_callbacks_1, onDecodingSuccess(_, _));
+        EXPECT_CALL(mock_upstream_request_callbacks_2, onConnectionClose(_)).Times(0);
+        EXPECT_CALL(mock_upstream_connection_, close(_)).Times(0);
+        cocec_callbacks_->onDecodingSuccess(std::move(response_1), {});
+      }));
+
+  Buffer::OwnedImpl fake_buffer;
+  fake_buffer.add("fake data");
+  upstream->onUpstreamData(fake_buffer, false);
+
+  EXPECT_FALSE(upstream->attached());
+  EXPECT_EQ(1, upstream->activeRequestsSize());
+  EXPECT_EQ(0, multiplexed_pools_.poolsSize());
+
+  // A new request gets a new upstream connection.
+  auto generic_upstream3 = createMultiplexedGenericUpstream(1);
+  NiceMock<MockUpstreamRequestCallbacks> mock_upstream_request_callbacks_3;
+  EXPECT_CALL(thread_local_cluster_.tcp_conn_pool_, newConnection(_));
+  generic_upstream3->appendUpstreamRequest(3, &mock_upstream_request_callbacks_3);
+  EXPECT_NE(upstream, generic_upstream3->upstream());
+
+  // The connection is closed rather than released once the second request is complete.
+  EXPECT_CALL(*mock_client_codec_raw_, decode(_, _))
+      .WillOnce(testing::Invoke([&](Buffer::Instance&, bool) {
+        EXPECT_CALL(mock_upstream_request_callbacks_2, onDecodingSuccess(_, _));
+        EXPECT_CALL(mock_upstream_connection_, close(_));
+        EXPECT_CALL(thread_local_cluster_.tcp_conn_pool_, released(_)).Times(0);
+        cocec_callbacks_->onDecodingSuccess(std::move(response_2), {});
+      }));
+
+  fake_buffer.add("fake data");
+  upstream->onUpstreamData(fake_buffer, false);
+
+  EXPECT_EQ(0, upstream->activeRequestsSize());
+  EXPECT_FALSE(upstream->upstreamConnection().has_value());
+}
+
+TEST_F(UpstreamTest, MultiplexedGenericUpstreamCloseConnectionAndResetOtherRequests) {
+  EXPECT_CALL(thread_local_cluster_, tcpConnPool(_, _)).Times(2);
+  auto generic_upstream1 = createMultiplexedGenericUpstream(1);
+  auto generic_upstream2 = createMultiplexedGenericUpstream(2);
+
+  NiceMock<MockUpstreamRequestCallbacks> mock_upstream_request_callbacks_1;
+  NiceMock<MockUpstreamRequestCallbacks> mock_upstream_request_callbacks_2;
+  mock_upstream_request_callbacks_2.upstream_ = generic_upstream2.get();
+  mock_upstream_request_callbacks_2.stream_id_ = 2;
+
+  EXPECT_CALL(thread_local_cluster_.tcp_conn_pool_, newConnection(_));
+  generic_upstream1->appendUpstreamRequest(1, &mock_upstream_request_callbacks_1);
+  generic_upstream2->appendUpstreamRequest(2, &mock_upstream_request_callbacks_2);
+
+  auto upstream = generic_upstream1->upstream();
+
+  EXPECT_CALL(*thread_local_cluster_.tcp_conn_pool_.connection_data_, addUpstreamCallbacks(_))
+      .WillOnce(testing::Invoke([&](Tcp::ConnectionPool::UpstreamCallbacks& cb) {
+        mock_upstream_connection_.addConnectionCallbacks(cb);
+      }));
+  thread_local_cluster_.tcp_conn_pool_.poolReady(mock_upstream_connection_);
+
+  // The first request is reset because of a protocol error and the shared connection is closed.
+  EXPECT_CALL(mock_upstream_connection_, close(_));
+  EXPECT_CALL(mock_upstream_request_callbacks_2, onConnectionClose(_));
+
+  generic_upstream1->removeUpstreamRequest(1);
+  generic_upstream1->cleanUp(true);
+
+  EXPECT_FALSE(upstream->attached());
+  EXPECT_EQ(0, upstream->activeRequestsSize());
+  EXPECT_EQ(0, multiplexed_pools_.poolsSize());
+}
+
+TEST_F(UpstreamTest, MultiplexedGenericUpstreamUpstreamConnectionClose) {
+  EXPECT_CALL(thread_local_cluster_, tcpConnPool(_, _));
+  auto generic_upstream = createMultiplexedGenericUpstream();
+
+  NiceMock<MockUpstreamRequestCallbacks> mock_upstream_request_callbacks_1;
+  mock_upstream_request_callbacks_1.upstream_ = generic_upstream.get();
+
+  EXPECT_CALL(thread_local_cluster_.tcp_conn_pool_, newConnection(_));
+  generic_upstream->appendUpstreamRequest(1, &mock_upstream_request_callbacks_1);
+
+  EXPECT_CALL(*thread_local_cluster_.tcp_conn_pool_.connection_data_, addUpstreamCallbacks(_))
+      .WillOnce(testing::Invoke([&](Tcp::ConnectionPool::UpstreamCallbacks& cb) {
+        mock_upstream_connection_.addConnectionCallbacks(cb);
+      }));
+  thread_local_cluster_.tcp_conn_pool_.poolReady(mock_upstream_connection_);
+
+  EXPECT_EQ(1, generic_upstream->upstream()->waitingResponseRequestsSize());
+
+  EXPECT_CALL(mock_upstream_request_callbacks_1, onConnectionClose(_));
+
+  mock_upstream_connection_.close(Network::ConnectionCloseType::NoFlush);
+
+  EXPECT_FALSE(generic_upstream->upstream()->attached());
+  EXPECT_EQ(0, generic_upstream->upstream()->activeRequestsSize());
+  EXPECT_EQ(0, multiplexed_pools_.poolsSize());
+}
+
 } // namespace
 } // namespace Router
 } // namespace GenericProxy
@@ -129,6 +129,22 @@ stat_prefix: name
   Filters::Common::RateLimit::RequestCallbacks* request_callbacks_{};
 };
 
+TEST(RateLimitConfigTest, EmptyDescriptorValue) {
+  const std::string yaml = R"EOF(
+domain: foo
+descriptors:
+- entries:
+   - key: hello
+stat_prefix: name
+)EOF";
+  envoy::extensions::filters::network::ratelimit::v3::RateLimit proto_config{};
+  TestUtility::loadFromYaml(yaml, proto_config);
+  Stats::TestUtil::TestStore stats_store;
+  NiceMock<Runtime::MockLoader> runtime;
+  EXPECT_THROW_WITH_MESSAGE(Config(proto_config, *stats_store.rootScope(), runtime),
+                            EnvoyException, "rate limit descriptor entry 'hello' must have a value");
+}
+
 TEST_F(RateLimitFilterTest, OK) {
   InSequence s;
   setUpTest(filter_config_);
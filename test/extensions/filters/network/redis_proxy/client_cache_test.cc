@@ -0,0 +1,334 @@
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "envoy/extensions/filters/network/redis_proxy/v3/redis_proxy.pb.h"
+
+#include "source/common/buffer/buffer_impl.h"
+#include "source/common/stats/isolated_store_impl.h"
+#include "source/extensions/filters/network/redis_proxy/client_cache.h"
+
+#include "test/mocks/event/mocks.h"
+#include "test/mocks/network/mocks.h"
+#include "test/mocks/upstream/host.h"
+#include "test/test_common/simulated_time_system.h"
+#include "test/test_common/utility.h"
+
+#include "absl/strings/str_cat.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::_;
+using testing::Invoke;
+using testing::NiceMock;
+using testing::Return;
+using testing::SaveArg;
+
+namespace Envoy {
+namespace Extensions {
+namespace NetworkFilters {
+namespace RedisProxy {
+namespace ConnPool {
+
+namespace {
+
+// Returns the wire format of a command.
+std::string command(const std::vector<std::string>& args) {
+  std::string wire = absl::StrCat("*", args.size(), "\r\n");
+  for (const std::string& arg : args) {
+    absl::StrAppend(&wire, "$", arg.size(), "\r\n", arg, "\r\n");
+  }
+  return wire;
+}
+
+const std::string SubscribedReply =
+    "*3\r\n$9\r\nsubscribe\r\n$20\r\n__redis__:invalidate\r\n:1\r\n";
+
+Common::Redis::RespValue bulkString(const std::string& value) {
+  Common::Redis::RespValue response;
+  response.type(Common::Redis::RespType::BulkString);
+  response.asString() = value;
+  return response;
+}
+
+} // namespace
+
+class ClientCacheTest : public testing::Test, public Event::TestUsingSimulatedTime {
+public:
+  ~ClientCacheTest() override {
+    cache_.reset();
+    EXPECT_EQ(0, gauge("size_bytes"));
+    EXPECT_EQ(0, gauge("tracked_hosts"));
+  }
+
+  void setup(const std::string& yaml = "max_size_bytes: 1048576") {
+    envoy::extensions::filters::network::redis_proxy::v3::RedisProxy::ClientCache proto;
+    TestUtility::loadFromYaml(yaml, proto);
+    config_ = std::make_shared<ClientCacheConfig>(proto, *store_.rootScope());
+    cache_ = std::make_unique<ClientCache>(config_, dispatcher_);
+  }
+
+  void expectTrackingConnection() {
+    connection_ = new NiceMock<Network::MockClientConnection>();
+    Upstream::MockHost::MockCreateConnectionData conn_info;
+    conn_info.connection_ = connection_;
+    EXPECT_CALL(*host_, createConnection_(_, _)).WillOnce(Return(conn_info));
+    EXPECT_CALL(*connection_, addReadFilter(_)).WillOnce(SaveArg<0>(&read_filter_));
+    EXPECT_CALL(*connection_, connect());
+    ON_CALL(*connection_, write(_, _)).WillByDefault(Invoke([this](Buffer::Instance& data, bool) {
+      written_ += data.toString();
+      data.drain(data.length());
+    }));
+  }
+
+  void respond(const std::string& wire) {
+    Buffer::OwnedImpl buffer(wire);
+    read_filter_->onData(buffer, false);
+  }
+
+  // Walks the tracking connection of host_ through its handshake.
+  void subscribe(const std::vector<std::string>& tracking) {
+    expectTrackingConnection();
+    EXPECT_EQ(0, cache_->startFill("key", host_, "", ""));
+    EXPECT_EQ(command({"CLIENT", "ID"}), written_);
+    written_.clear();
+
+    respond(":7\r\n");
+    EXPECT_EQ(command(tracking) + command({"SUBSCRIBE", "__redis__:invalidate"}), written_);
+    written_.clear();
+    respond("+OK\r\n");
+    EXPECT_EQ(0, cache_->startFill("key", host_, "", ""));
+    respond(SubscribedReply);
+  }
+
+  void subscribe() { subscribe({"CLIENT", "TRACKING", "ON", "REDIRECT", "7", "BCAST"}); }
+
+  void cache(const std::string& key, const std::string& value) {
+    const uint64_t fill_id = cache_->startFill(key, host_, "", "");
+    EXPECT_NE(0, fill_id);
+    cache_->fill(key, fill_id, bulkString(value));
+  }
+
+  static uint64_t entrySizeBytes(const std::string& key, const std::string& value) {
+    return sizeof(ClientCache::Entry) + key.size() + value.size();
+  }
+
+  uint64_t counter(const std::string& name) {
+    return store_.counterFromString("client_cache." + name).value();
+  }
+  uint64_t gauge(const std::string& name) {
+    return store_.gaugeFromString("client_cache." + name, Stats::Gauge::ImportMode::Accumulate)
+        .value();
+  }
+
+  Stats::IsolatedStoreImpl store_;
+  NiceMock<Event::MockDispatcher> dispatcher_;
+  std::shared_ptr<Upstream::MockHost> host_{new NiceMock<Upstream::MockHost>()};
+  NiceMock<Network::MockClientConnection>* connection_{};
+  Network::ReadFilterSharedPtr read_filter_;
+  std::string written_;
+  ClientCacheConfigSharedPtr config_;
+  ClientCachePtr cache_;
+};
+
+TEST_F(ClientCacheTest, OverlappingPrefixes) {
+  envoy::extensions::filters::network::redis_proxy::v3::RedisProxy::ClientCache proto;
+  TestUtility::loadFromYaml(R"EOF(
+key_prefixes: ["user:", "session:", "user:profile:"]
+max_size_bytes: 1024
+)EOF",
+                            proto);
+  EXPECT_THROW_WITH_MESSAGE(ClientCacheConfig(proto, *store_.rootScope()), EnvoyException,
+                            "redis client cache key prefixes 'user:' and 'user:profile:' overlap");
+}
+
+TEST_F(ClientCacheTest, KeyPrefixes) {
+  setup(R"EOF(
+key_prefixes: ["user:", "session:"]
+max_size_bytes: 1048576
+)EOF");
+  EXPECT_TRUE(cache_->cacheable("user:1"));
+  EXPECT_TRUE(cache_->cacheable("session:1"));
+  EXPECT_FALSE(cache_->cacheable("order:1"));
+
+  subscribe({"CLIENT", "TRACKING", "ON", "REDIRECT", "7", "BCAST", "PREFIX", "session:", "PREFIX",
+             "user:"});
+}
+
+TEST_F(ClientCacheTest, HitAndMiss) {
+  setup();
+  subscribe();
+  EXPECT_EQ(1, gauge("tracked_hosts"));
+
+  EXPECT_EQ(nullptr, cache_->lookup("key"));
+  cache("key", "value");
+  const Common::Redis::RespValue* cached = cache_->lookup("key");
+  ASSERT_NE(nullptr, cached);
+  EXPECT_EQ(bulkString("value"), *cached);
+  EXPECT_EQ(1, counter("hit"));
+  EXPECT_EQ(1, counter("miss"));
+  EXPECT_EQ(cache_->sizeBytes(), gauge("size_bytes"));
+
+  // Null responses are cached, other responses aren't.
+  const uint64_t fill_id = cache_->startFill("missing", host_, "", "");
+  cache_->fill("missing", fill_id, Common::Redis::RespValue());
+  EXPECT_NE(nullptr, cache_->lookup("missing"));
+
+  Common::Redis::RespValue error;
+  error.type(Common::Redis::RespType::Error);
+  error.asString() = "WRONGTYPE";
+  cache_->fill("other", cache_->startFill("other", host_, "", ""), error);
+  EXPECT_EQ(nullptr, cache_->lookup("other"));
+}
+
+TEST_F(ClientCacheTest, FillUntilSubscribed) {
+  setup();
+  expectTrackingConnection();
+  EXPECT_EQ(0, cache_->startFill("key", host_, "", ""));
+  respond(":7\r\n");
+  EXPECT_EQ(0, cache_->startFill("key", host_, "", ""));
+  respond("+OK\r\n");
+  EXPECT_EQ(0, cache_->startFill("key", host_, "", ""));
+  respond(SubscribedReply);
+  EXPECT_NE(0, cache_->startFill("key", host_, "", ""));
+}
+
+TEST_F(ClientCacheTest, Auth) {
+  setup();
+  expectTrackingConnection();
+  EXPECT_EQ(0, cache_->startFill("key", host_, "user", "password"));
+  EXPECT_EQ(command({"auth", "user", "password"}) + command({"CLIENT", "ID"}), written_);
+
+  respond("+OK\r\n:7\r\n+OK\r\n" + SubscribedReply);
+  EXPECT_NE(0, cache_->startFill("key", host_, "user", "password"));
+}
+
+TEST_F(ClientCacheTest, InvalidationDuringFill) {
+  setup();
+  subscribe();
+
+  const uint64_t fill_id = cache_->startFill("key", host_, "", "");
+  // A concurrent GET command for the key shares the fill.
+  EXPECT_EQ(fill_id, cache_->startFill("key", host_, "", ""));
+  respond("*3\r\n$7\r\nmessage\r\n$20\r\n__redis__:invalidate\r\n*1\r\n$3\r\nkey\r\n");
+  cache_->fill("key", fill_id, bulkString("stale"));
+  EXPECT_EQ(nullptr, cache_->lookup("key"));
+  EXPECT_EQ(1, counter("invalidation"));
+
+  // A later fill has a new ID.
+  EXPECT_NE(fill_id, cache_->startFill("key", host_, "", ""));
+}
+
+TEST_F(ClientCacheTest, CancelFill) {
+  setup();
+  subscribe();
+
+  const uint64_t fill_id = cache_->startFill("key", host_, "", "");
+  cache_->cancelFill("key", fill_id);
+  cache_->fill("key", fill_id, bulkString("value"));
+  EXPECT_EQ(nullptr, cache_->lookup("key"));
+}
+
+TEST_F(ClientCacheTest, Invalidation) {
+  setup();
+  subscribe();
+  cache("a", "1");
+  cache("b", "2");
+  cache("c", "3");
+
+  respond("*3\r\n$7\r\nmessage\r\n$20\r\n__redis__:invalidate\r\n*2\r\n$1\r\na\r\n$1\r\nb\r\n");
+  EXPECT_EQ(nullptr, cache_->lookup("a"));
+  EXPECT_EQ(nullptr, cache_->lookup("b"));
+  EXPECT_NE(nullptr, cache_->lookup("c"));
+  EXPECT_EQ(2, counter("invalidation"));
+
+  // A null payload means the database was flushed.
+  respond("*3\r\n$7\r\nmessage\r\n$20\r\n__redis__:invalidate\r\n$-1\r\n");
+  EXPECT_EQ(nullptr, cache_->lookup("c"));
+  EXPECT_EQ(1, counter("flush"));
+  EXPECT_EQ(0, cache_->sizeBytes());
+}
+
+TEST_F(ClientCacheTest, Eviction) {
+  const std::string value(1000, 'v');
+  const uint64_t max_size_bytes = entrySizeBytes("a", value) * 5 / 2;
+  setup(absl::StrCat("max_size_bytes: ", max_size_bytes));
+  subscribe();
+
+  cache("a", value);
+  cache("b", value);
+  EXPECT_NE(nullptr, cache_->lookup("a"));
+  cache("c", value);
+  EXPECT_NE(nullptr, cache_->lookup("a"));
+  EXPECT_EQ(nullptr, cache_->lookup("b"));
+  EXPECT_NE(nullptr, cache_->lookup("c"));
+  EXPECT_EQ(1, counter("eviction"));
+  EXPECT_LE(cache_->sizeBytes(), max_size_bytes);
+
+  // A response which doesn't fit the cache is not cached.
+  cache("d", std::string(max_size_bytes, 'v'));
+  EXPECT_EQ(nullptr, cache_->lookup("d"));
+  EXPECT_NE(nullptr, cache_->lookup("a"));
+}
+
+TEST_F(ClientCacheTest, TrackingConnectionClosed) {
+  setup();
+  subscribe();
+  cache("key", "value");
+
+  connection_->raiseEvent(Network::ConnectionEvent::RemoteClose);
+  EXPECT_EQ(nullptr, cache_->lookup("key"));
+  EXPECT_EQ(1, counter("flush"));
+  EXPECT_EQ(1, counter("tracking_failure"));
+  EXPECT_EQ(0, gauge("tracked_hosts"));
+
+  // The tracking connection is retried after a delay.
+  EXPECT_EQ(0, cache_->startFill("key", host_, "", ""));
+  simTime().advanceTimeWait(ClientCache::TrackingRetryDelay);
+  expectTrackingConnection();
+  EXPECT_EQ(0, cache_->startFill("key", host_, "", ""));
+}
+
+TEST_F(ClientCacheTest, TrackingUnsupported) {
+  setup();
+  expectTrackingConnection();
+  EXPECT_EQ(0, cache_->startFill("key", host_, "", ""));
+
+  EXPECT_CALL(*connection_, close(Network::ConnectionCloseType::NoFlush))
+      .WillOnce(Invoke([this](Network::ConnectionCloseType) {
+        connection_->raiseEvent(Network::ConnectionEvent::LocalClose);
+      }));
+  respond(":7\r\n-ERR unknown subcommand 'TRACKING'\r\n");
+  EXPECT_EQ(1, counter("tracking_failure"));
+  EXPECT_EQ(0, counter("flush"));
+  EXPECT_EQ(0, cache_->startFill("key", host_, "", ""));
+}
+
+TEST_F(ClientCacheTest, RemoveHost) {
+  setup();
+  subscribe();
+  cache("key", "value");
+
+  EXPECT_CALL(*connection_, close(Network::ConnectionCloseType::NoFlush));
+  cache_->removeHost(host_);
+  EXPECT_EQ(nullptr, cache_->lookup("key"));
+  EXPECT_EQ(1, counter("flush"));
+  EXPECT_EQ(0, counter("tracking_failure"));
+}
+
+TEST_F(ClientCacheTest, RemoveAllHosts) {
+  setup();
+  subscribe();
+  cache("key", "value");
+
+  EXPECT_CALL(*connection_, close(Network::ConnectionCloseType::NoFlush));
+  cache_->removeAllHosts();
+  EXPECT_EQ(nullptr, cache_->lookup("key"));
+  EXPECT_EQ(1, counter("flush"));
+}
+
+} // namespace ConnPool
+} // namespace RedisProxy
+} // namespace NetworkFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,115 @@
+// Note: this should be run with --compilation_mode=opt, and would benefit from a
+// quiescent system with disabled cstate power management.
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "source/common/buffer/buffer_impl.h"
+#include "source/common/common/fmt.h"
+#include "source/common/runtime/runtime_features.h"
+#include "source/extensions/filters/network/common/redis/codec_impl.h"
+
+#include "absl/strings/string_view.h"
+#include "benchmark/benchmark.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace NetworkFilters {
+namespace RedisProxy {
+namespace {
+
+// The size of the slices that a connection reads into.
+constexpr uint64_t ReadSliceSize = 16 * 1024;
+
+// Passes GET and SET commands through the codec the way the proxy filter does: the request is
+// decoded from the downstream connection, its key is read for routing and it is encoded to the
+// upstream connection, then the response is decoded from the upstream connection and encoded to
+// the downstream connection. Bulk strings are copied in and out of the values if `range(0)` is 0,
+// and referenced by the values otherwise.
+class CodecSpeedTest : public Common::Redis::DecoderCallbacks {
+public:
+  CodecSpeedTest(bool buffer_bulk_strings, uint64_t value_size) {
+    Runtime::maybeSetRuntimeGuard("envoy.reloadable_features.redis_buffered_bulk_strings",
+                                  buffer_bulk_strings);
+    decoder_ = std::make_unique<Common::Redis::DecoderImpl>(*this);
+
+    const std::string value(value_size, 'v');
+    get_request_ = "*2\r\n$3\r\nget\r\n$3\r\nkey\r\n";
+    get_response_ = fmt::format("${}\r\n{}\r\n", value_size, value);
+    set_request_ = fmt::format("*3\r\n$3\r\nset\r\n$3\r\nkey\r\n${}\r\n{}\r\n", value_size, value);
+    set_response_ = "+OK\r\n";
+  }
+
+  // Common::Redis::DecoderCallbacks
+  void onRespValue(Common::Redis::RespValuePtr&& value) override { decoded_ = std::move(value); }
+
+  void roundTrip(absl::string_view request, absl::string_view response) {
+    read(request);
+    benchmark::DoNotOptimize(decoded_->asArray()[1].asString().data());
+    write();
+    read(response);
+    write();
+  }
+
+  std::string get_request_;
+  std::string get_response_;
+  std::string set_request_;
+  std::string set_response_;
+
+private:
+  // Decodes `wire` from read slices which reference it, so that only the decoder copies it.
+  void read(absl::string_view wire) {
+    Buffer::OwnedImpl read_buffer;
+    for (uint64_t offset = 0; offset < wire.size(); offset += ReadSliceSize) {
+      read_buffer.addBufferFragment(*new Buffer::BufferFragmentImpl(
+          wire.data() + offset, std::min(ReadSliceSize, wire.size() - offset), release_));
+    }
+    decoder_->decode(read_buffer);
+  }
+
+  void write() {
+    encoder_.encode(*decoded_, write_buffer_);
+    decoded_.reset();
+    // Drain the buffer as if it was written to the connection.
+    write_buffer_.drain(write_buffer_.length());
+  }
+
+  const std::function<void(const void*, size_t, const Buffer::BufferFragmentImpl*)> release_ =
+      [](const void*, size_t, const Buffer::BufferFragmentImpl* fragment) { delete fragment; };
+  std::unique_ptr<Common::Redis::DecoderImpl> decoder_;
+  Common::Redis::EncoderImpl encoder_;
+  Common::Redis::RespValuePtr decoded_;
+  Buffer::OwnedImpl write_buffer_;
+};
+
+void bmGet(benchmark::State& state) {
+  CodecSpeedTest context(state.range(0) != 0, state.range(1));
+  for (auto _ : state) {
+    UNREFERENCED_PARAMETER(_);
+    context.roundTrip(context.get_request_, context.get_response_);
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(1));
+}
+BENCHMARK(bmGet)
+    ->ArgsProduct({{0, 1}, {1024, 100 * 1024, 1024 * 1024}})
+    ->Unit(benchmark::kMicrosecond);
+
+void bmSet(benchmark::State& state) {
+  CodecSpeedTest context(state.range(0) != 0, state.range(1));
+  for (auto _ : state) {
+    UNREFERENCED_PARAMETER(_);
+    context.roundTrip(context.set_request_, context.set_response_);
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(1));
+}
+BENCHMARK(bmSet)
+    ->ArgsProduct({{0, 1}, {1024, 100 * 1024, 1024 * 1024}})
+    ->Unit(benchmark::kMicrosecond);
+
+} // namespace
+} // namespace RedisProxy
+} // namespace NetworkFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -16,6 +16,7 @@
 #include "test/mocks/stats/mocks.h"
 #include "test/mocks/stream_info/mocks.h"
 #include "test/test_common/simulated_time_system.h"
+#include "test/test_common/test_runtime.h"
 
 using testing::_;
 using testing::DoAll;
@@ -564,6 +565,8 @@ public:
     mirror_pool_requests_.swap(tmp_mirrored_pool_requests);
 
     EXPECT_CALL(callbacks_, connectionAllowed()).WillOnce(Return(true));
+    // No key shares a shard, so that every key is sent on its own.
+    EXPECT_CALL(*conn_pool_, shard(_, _)).WillRepeatedly(Return(absl::nullopt));
 
     std::vector<Common::Redis::Client::MockPoolRequest> dummy_requests(num_gets);
     for (uint32_t i = 0; i < num_gets; i++) {
@@ -1043,6 +1046,236 @@ INSTANTIATE_TEST_SUITE_P(
     RedisSplitKeysSumResultHandlerTest, RedisSplitKeysSumResultHandlerTest,
     testing::ValuesIn(Common::Redis::SupportedCommands::hashMultipleSumResultCommands()));
 
+class RedisBatchedFragmentedRequestTest : public RedisCommandSplitterImplTest {
+public:
+  RedisBatchedFragmentedRequestTest() {
+    scoped_runtime_.mergeValues(
+        {{"envoy.reloadable_features.redis_batch_multi_key_commands", "true"}});
+  }
+
+  // Keys are numbers, and the keys with the same parity share a shard.
+  void setupShards() {
+    EXPECT_CALL(*conn_pool_, shard(_, _))
+        .WillRepeatedly(Invoke([](const std::string& key,
+                                  const Common::Redis::RespValue&) -> absl::optional<uint64_t> {
+          return std::stoul(key) % 2;
+        }));
+  }
+
+  void expectBatchRequest(const std::vector<std::string>& request_strings, uint32_t index) {
+    Common::Redis::RespValue request;
+    makeBulkStringArray(request, request_strings);
+    EXPECT_CALL(*conn_pool_, makeRequest_(request_strings[1], RespVariantEq(request), _))
+        .WillOnce(DoAll(WithArg<2>(SaveArgAddress(&pool_callbacks_[index])),
+                        Return(&pool_requests_[index])));
+  }
+
+  void expectSingleRequest(const std::vector<std::string>& request_strings, uint32_t index) {
+    EXPECT_CALL(*conn_pool_, makeRequest_(request_strings[1], CompositeArrayEq(request_strings), _))
+        .WillOnce(DoAll(WithArg<2>(SaveArgAddress(&pool_callbacks_[index])),
+                        Return(&pool_requests_[index])));
+  }
+
+  void makeRequest(const std::vector<std::string>& request_strings) {
+    Common::Redis::RespValuePtr request{new Common::Redis::RespValue()};
+    makeBulkStringArray(*request, request_strings);
+    handle_ = splitter_.makeRequest(std::move(request), callbacks_, dispatcher_, stream_info_);
+  }
+
+  Common::Redis::RespValue value(Common::Redis::RespType type, const std::string& string = "") {
+    Common::Redis::RespValue value;
+    value.type(type);
+    if (type != Common::Redis::RespType::Null) {
+      value.asString() = string;
+    }
+    return value;
+  }
+
+  Common::Redis::RespValuePtr array(std::vector<Common::Redis::RespValue>&& elements) {
+    Common::Redis::RespValuePtr array = std::make_unique<Common::Redis::RespValue>();
+    array->type(Common::Redis::RespType::Array);
+    array->asArray().swap(elements);
+    return array;
+  }
+
+  Common::Redis::RespValuePtr integer(int64_t integer) {
+    Common::Redis::RespValuePtr value = std::make_unique<Common::Redis::RespValue>();
+    value->type(Common::Redis::RespType::Integer);
+    value->asInteger() = integer;
+    return value;
+  }
+
+  TestScopedRuntime scoped_runtime_;
+  ConnPool::PoolCallbacks* pool_callbacks_[2]{};
+  Common::Redis::Client::MockPoolRequest pool_requests_[2];
+};
+
+TEST_F(RedisBatchedFragmentedRequestTest, MGET) {
+  InSequence s;
+
+  EXPECT_CALL(callbacks_, connectionAllowed()).WillOnce(Return(true));
+  setupShards();
+  expectBatchRequest({"mget", "0", "2"}, 0);
+  expectBatchRequest({"mget", "1", "3"}, 1);
+  makeRequest({"mget", "0", "1", "2", "3"});
+  EXPECT_NE(nullptr, handle_);
+
+  pool_callbacks_[1]->onResponse(array({value(Common::Redis::RespType::BulkString, "one"),
+                                        value(Common::Redis::RespType::BulkString, "three")}));
+
+  Common::Redis::RespValuePtr expected_response =
+      array({value(Common::Redis::RespType::BulkString, "zero"),
+             value(Common::Redis::RespType::BulkString, "one"),
+             value(Common::Redis::RespType::Null),
+             value(Common::Redis::RespType::BulkString, "three")});
+  EXPECT_CALL(callbacks_, onResponse_(PointeesEq(expected_response.get())));
+  pool_callbacks_[0]->onResponse(array({value(Common::Redis::RespType::BulkString, "zero"),
+                                        value(Common::Redis::RespType::Null)}));
+
+  EXPECT_EQ(1UL, store_.counter("redis.foo.command.mget.total").value());
+  EXPECT_EQ(1UL, store_.counter("redis.foo.command.mget.success").value());
+};
+
+TEST_F(RedisBatchedFragmentedRequestTest, MGETError) {
+  InSequence s;
+
+  EXPECT_CALL(callbacks_, connectionAllowed()).WillOnce(Return(true));
+  setupShards();
+  expectBatchRequest({"mget", "0", "2"}, 0);
+  expectSingleRequest({"get", "1"}, 1);
+  makeRequest({"mget", "0", "1", "2"});
+  EXPECT_NE(nullptr, handle_);
+
+  pool_callbacks_[1]->onResponse(std::make_unique<Common::Redis::RespValue>(
+      value(Common::Redis::RespType::BulkString, "one")));
+
+  // Each key of the failed MGET gets its error.
+  Common::Redis::RespValuePtr expected_response =
+      array({value(Common::Redis::RespType::Error, "TRYAGAIN"),
+             value(Common::Redis::RespType::BulkString, "one"),
+             value(Common::Redis::RespType::Error, "TRYAGAIN")});
+  EXPECT_CALL(callbacks_, onResponse_(PointeesEq(expected_response.get())));
+  pool_callbacks_[0]->onResponse(std::make_unique<Common::Redis::RespValue>(
+      value(Common::Redis::RespType::Error, "TRYAGAIN")));
+
+  EXPECT_EQ(1UL, store_.counter("redis.foo.command.mget.total").value());
+  EXPECT_EQ(1UL, store_.counter("redis.foo.command.mget.error").value());
+};
+
+TEST_F(RedisBatchedFragmentedRequestTest, MGETCancel) {
+  InSequence s;
+
+  EXPECT_CALL(callbacks_, connectionAllowed()).WillOnce(Return(true));
+  setupShards();
+  expectBatchRequest({"mget", "0", "2"}, 0);
+  expectBatchRequest({"mget", "1", "3"}, 1);
+  makeRequest({"mget", "0", "1", "2", "3"});
+  EXPECT_NE(nullptr, handle_);
+
+  EXPECT_CALL(pool_requests_[0], cancel());
+  EXPECT_CALL(pool_requests_[1], cancel());
+  handle_->cancel();
+};
+
+TEST_F(RedisBatchedFragmentedRequestTest, MSET) {
+  InSequence s;
+
+  EXPECT_CALL(callbacks_, connectionAllowed()).WillOnce(Return(true));
+  setupShards();
+  expectBatchRequest({"mset", "0", "a", "2", "c"}, 0);
+  expectBatchRequest({"mset", "1", "b", "3", "d"}, 1);
+  makeRequest({"mset", "0", "a", "1", "b", "2", "c", "3", "d"});
+  EXPECT_NE(nullptr, handle_);
+
+  pool_callbacks_[0]->onResponse(std::make_unique<Common::Redis::RespValue>(
+      value(Common::Redis::RespType::SimpleString, Response::get().OK)));
+
+  // Both keys of the failed MSET count as errors.
+  Common::Redis::RespValue expected_response =
+      value(Common::Redis::RespType::Error, "finished with 2 error(s)");
+  EXPECT_CALL(callbacks_, onResponse_(PointeesEq(&expected_response)));
+  pool_callbacks_[1]->onFailure();
+
+  EXPECT_EQ(1UL, store_.counter("redis.foo.command.mset.total").value());
+  EXPECT_EQ(1UL, store_.counter("redis.foo.command.mset.error").value());
+};
+
+TEST_F(RedisBatchedFragmentedRequestTest, SplitKeysSumResult) {
+  InSequence s;
+
+  EXPECT_CALL(callbacks_, connectionAllowed()).WillOnce(Return(true));
+  setupShards();
+  expectBatchRequest({"del", "0", "2"}, 0);
+  expectBatchRequest({"del", "1", "3"}, 1);
+  makeRequest({"del", "0", "1", "2", "3"});
+  EXPECT_NE(nullptr, handle_);
+
+  pool_callbacks_[0]->onResponse(integer(2));
+
+  Common::Redis::RespValuePtr expected_response = integer(3);
+  EXPECT_CALL(callbacks_, onResponse_(PointeesEq(expected_response.get())));
+  pool_callbacks_[1]->onResponse(integer(1));
+
+  EXPECT_EQ(1UL, store_.counter("redis.foo.command.del.total").value());
+  EXPECT_EQ(1UL, store_.counter("redis.foo.command.del.success").value());
+};
+
+TEST_F(RedisBatchedFragmentedRequestTest, NoUpstreamHost) {
+  // No InSequence as the response is sent while the request is made.
+
+  EXPECT_CALL(callbacks_, connectionAllowed()).WillOnce(Return(true));
+  setupShards();
+  Common::Redis::RespValue request;
+  makeBulkStringArray(request, {"mget", "0", "2"});
+  EXPECT_CALL(*conn_pool_, makeRequest_("0", RespVariantEq(request), _)).WillOnce(Return(nullptr));
+
+  Common::Redis::RespValuePtr expected_response =
+      array({value(Common::Redis::RespType::Error, Response::get().NoUpstreamHost),
+             value(Common::Redis::RespType::Error, Response::get().NoUpstreamHost)});
+  EXPECT_CALL(callbacks_, onResponse_(PointeesEq(expected_response.get())));
+  makeRequest({"mget", "0", "2"});
+  EXPECT_EQ(nullptr, handle_);
+
+  EXPECT_EQ(1UL, store_.counter("redis.foo.command.mget.total").value());
+  EXPECT_EQ(1UL, store_.counter("redis.foo.command.mget.error").value());
+};
+
+TEST_F(RedisBatchedFragmentedRequestTest, Mirrored) {
+  InSequence s;
+
+  setupMirrorPolicy();
+  EXPECT_CALL(callbacks_, connectionAllowed()).WillOnce(Return(true));
+  EXPECT_CALL(*conn_pool_, shard(_, _)).Times(0);
+  expectSingleRequest({"get", "0"}, 0);
+  EXPECT_CALL(*mirror_conn_pool_, makeRequest_("0", _, _)).WillOnce(Return(nullptr));
+  expectSingleRequest({"get", "2"}, 1);
+  EXPECT_CALL(*mirror_conn_pool_, makeRequest_("2", _, _)).WillOnce(Return(nullptr));
+  makeRequest({"mget", "0", "2"});
+  EXPECT_NE(nullptr, handle_);
+
+  EXPECT_CALL(pool_requests_[0], cancel());
+  EXPECT_CALL(pool_requests_[1], cancel());
+  handle_->cancel();
+};
+
+TEST_F(RedisBatchedFragmentedRequestTest, Disabled) {
+  InSequence s;
+
+  scoped_runtime_.mergeValues(
+      {{"envoy.reloadable_features.redis_batch_multi_key_commands", "false"}});
+
+  EXPECT_CALL(callbacks_, connectionAllowed()).WillOnce(Return(true));
+  EXPECT_CALL(*conn_pool_, shard(_, _)).Times(0);
+  expectSingleRequest({"get", "0"}, 0);
+  expectSingleRequest({"get", "2"}, 1);
+  makeRequest({"mget", "0", "2"});
+  EXPECT_NE(nullptr, handle_);
+
+  EXPECT_CALL(pool_requests_[0], cancel());
+  EXPECT_CALL(pool_requests_[1], cancel());
+  handle_->cancel();
+};
+
 class RedisSingleServerRequestWithLatencyMicrosTest : public RedisSingleServerRequestTest {
 public:
   RedisSingleServerRequestWithLatencyMicrosTest() : RedisSingleServerRequestTest(true) {}
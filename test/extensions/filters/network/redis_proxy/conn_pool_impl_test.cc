@@ -779,6 +779,42 @@ TEST_F(RedisConnPoolImplTest, NoHost) {
   tls_.shutdownThread();
 }
 
+TEST_F(RedisConnPoolImplTest, Shard) {
+  InSequence s;
+
+  EXPECT_CALL(*cm_.thread_local_cluster_.cluster_.info_, loadBalancerFactory())
+      .WillOnce(
+          ReturnRef(Config::Utility::getAndCheckFactoryByName<Upstream::TypedLoadBalancerFactory>(
+              "envoy.load_balancing_policies.ring_hash")));
+
+  setup();
+
+  // Keys are grouped by the host which the consistent hashing load balancer chooses for them.
+  Common::Redis::RespValue value;
+  EXPECT_CALL(cm_.thread_local_cluster_.lb_, chooseHost(_))
+      .Times(2)
+      .WillRepeatedly(Return(cm_.thread_local_cluster_.lb_.host_));
+  const absl::optional<uint64_t> shard = conn_pool_->shard("foo", value);
+  ASSERT_TRUE(shard.has_value());
+  EXPECT_EQ(shard, conn_pool_->shard("bar", value));
+
+  EXPECT_CALL(cm_.thread_local_cluster_.lb_, chooseHost(_)).WillOnce(Return(nullptr));
+  EXPECT_EQ(absl::nullopt, conn_pool_->shard("foo", value));
+
+  tls_.shutdownThread();
+}
+
+TEST_F(RedisConnPoolImplTest, ShardNotConsistentHashLb) {
+  setup();
+
+  // Keys are not grouped, as the host chosen for a key may not serve the command of its group.
+  Common::Redis::RespValue value;
+  EXPECT_CALL(cm_.thread_local_cluster_.lb_, chooseHost(_)).Times(0);
+  EXPECT_EQ(absl::nullopt, conn_pool_->shard("foo", value));
+
+  tls_.shutdownThread();
+}
+
 TEST_F(RedisConnPoolImplTest, RemoteClose) {
   InSequence s;
 
@@ -1195,6 +1231,30 @@ TEST_F(RedisConnPoolImplTest, MakeRequestToRedisClusterHashtag) {
   tls_.shutdownThread();
 };
 
+TEST_F(RedisConnPoolImplTest, ShardRedisCluster) {
+  envoy::config::cluster::v3::Cluster::CustomClusterType cluster_type;
+  cluster_type.set_name("envoy.clusters.redis");
+
+  EXPECT_CALL(*cm_.thread_local_cluster_.cluster_.info_, clusterType())
+      .WillOnce(Return(
+          makeOptRef<const envoy::config::cluster::v3::Cluster::CustomClusterType>(cluster_type)));
+  EXPECT_CALL(*cm_.thread_local_cluster_.cluster_.info_, loadBalancerFactory())
+      .WillOnce(
+          ReturnRef(Config::Utility::getAndCheckFactoryByName<Upstream::TypedLoadBalancerFactory>(
+              "envoy.load_balancing_policies.cluster_provided")));
+
+  setup();
+
+  // Keys are grouped by their slot, without choosing a host.
+  Common::Redis::RespValue value;
+  EXPECT_CALL(cm_.thread_local_cluster_.lb_, chooseHost(_)).Times(0);
+  EXPECT_EQ(absl::optional<uint64_t>(44950), conn_pool_->shard("foo", value));
+  EXPECT_EQ(absl::optional<uint64_t>(44950), conn_pool_->shard("{foo}bar", value));
+  EXPECT_EQ(absl::optional<uint64_t>(37829), conn_pool_->shard("bar", value));
+
+  tls_.shutdownThread();
+};
+
 TEST_F(RedisConnPoolImplTest, MovedRedirectionSuccess) {
   InSequence s;
 
@@ -95,6 +95,8 @@ public:
   MOCK_METHOD(Common::Redis::Client::PoolRequest*, makeRequest_,
               (const std::string& hash_key, RespVariant& request, PoolCallbacks& callbacks));
   MOCK_METHOD(bool, onRedirection, ());
+  MOCK_METHOD(absl::optional<uint64_t>, shard,
+              (const std::string& hash_key, const Common::Redis::RespValue& request));
 };
 } // namespace ConnPool
 
@@ -0,0 +1,166 @@
+// Note: this should be run with --compilation_mode=opt, and would benefit from a
+// quiescent system with disabled cstate power management.
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "source/common/runtime/runtime_features.h"
+#include "source/common/stats/isolated_store_impl.h"
+#include "source/extensions/filters/network/common/redis/client_impl.h"
+#include "source/extensions/filters/network/redis_proxy/command_splitter_impl.h"
+
+#include "test/extensions/filters/network/redis_proxy/mocks.h"
+#include "test/mocks/event/mocks.h"
+#include "test/mocks/stream_info/mocks.h"
+#include "test/test_common/simulated_time_system.h"
+
+#include "benchmark/benchmark.h"
+
+using testing::NiceMock;
+
+namespace Envoy {
+namespace Extensions {
+namespace NetworkFilters {
+namespace RedisProxy {
+namespace {
+
+class NoOpSplitCallbacks : public CommandSplitter::SplitCallbacks {
+public:
+  bool connectionAllowed() override { return true; }
+  void onQuit() override {}
+  void onAuth(const std::string&) override {}
+  void onAuth(const std::string&, const std::string&) override {}
+  void onResponse(Common::Redis::RespValuePtr&& response) override {
+    benchmark::DoNotOptimize(response.get());
+  }
+  Common::Redis::Client::Transaction& transaction() override { return transaction_; }
+
+private:
+  Common::Redis::Client::NoOpTransaction transaction_;
+};
+
+class NoOpPoolRequest : public Common::Redis::Client::PoolRequest {
+public:
+  void cancel() override {}
+};
+
+// A pool of a single upstream host, which holds the requests until respond() is called. Each
+// request is answered with a value per key, as Redis would answer GET and MGET.
+class SingleHostConnPool : public ConnPool::Instance {
+public:
+  // ConnPool::Instance
+  Common::Redis::Client::PoolRequest* makeRequest(const std::string&,
+                                                  ConnPool::RespVariant&& request,
+                                                  ConnPool::PoolCallbacks& callbacks,
+                                                  Common::Redis::Client::Transaction&) override {
+    // Single keys are sent as composite arrays, and batches as shared arrays.
+    uint64_t num_keys = 1;
+    if (absl::holds_alternative<Common::Redis::RespValueConstSharedPtr>(request)) {
+      num_keys = absl::get<Common::Redis::RespValueConstSharedPtr>(request)->asArray().size() - 1;
+    }
+    pending_.push_back({&callbacks, num_keys});
+    return &pool_request_;
+  }
+  absl::optional<uint64_t> shard(const std::string&, const Common::Redis::RespValue&) override {
+    return 0;
+  }
+
+  void respond() {
+    for (const auto& [callbacks, num_keys] : pending_) {
+      Common::Redis::RespValuePtr response = std::make_unique<Common::Redis::RespValue>();
+      if (num_keys == 1) {
+        response->type(Common::Redis::RespType::BulkString);
+        response->asString() = value_;
+      } else {
+        response->type(Common::Redis::RespType::Array);
+        response->asArray().resize(num_keys);
+        for (Common::Redis::RespValue& element : response->asArray()) {
+          element.type(Common::Redis::RespType::BulkString);
+          element.asString() = value_;
+        }
+      }
+      callbacks->onResponse(std::move(response));
+    }
+    pending_.clear();
+  }
+
+private:
+  const std::string value_ = std::string(64, 'v');
+  NoOpPoolRequest pool_request_;
+  std::vector<std::pair<ConnPool::PoolCallbacks*, uint64_t>> pending_;
+};
+
+class SingleRouteRouter : public Router {
+public:
+  SingleRouteRouter(RouteSharedPtr route) : route_(std::move(route)) {}
+
+  RouteSharedPtr upstreamPool(std::string&, const StreamInfo::StreamInfo&) override {
+    return route_;
+  }
+
+private:
+  const RouteSharedPtr route_;
+};
+
+// Splits an MGET of `range(1)` keys, with the keys batched per shard if `range(0)` is 1, and
+// gathers the responses of the upstream host.
+class MultiKeyCommandSpeedTest {
+public:
+  MultiKeyCommandSpeedTest(bool batch, uint64_t num_keys) {
+    Runtime::maybeSetRuntimeGuard("envoy.reloadable_features.redis_batch_multi_key_commands",
+                                  batch);
+    splitter_ = std::make_unique<CommandSplitter::InstanceImpl>(
+        std::make_unique<SingleRouteRouter>(std::make_shared<NiceMock<MockRoute>>(conn_pool_)),
+        *store_.rootScope(), "redis.foo.", time_system_, false,
+        std::make_unique<NiceMock<MockFaultManager>>(fault_manager_));
+
+    keys_.reserve(num_keys + 1);
+    keys_.push_back("mget");
+    for (uint64_t i = 0; i < num_keys; i++) {
+      keys_.push_back(std::string(36, 'k') + std::to_string(i));
+    }
+  }
+
+  void mget() {
+    auto request = std::make_unique<Common::Redis::RespValue>();
+    std::vector<Common::Redis::RespValue> values(keys_.size());
+    for (uint64_t i = 0; i < keys_.size(); i++) {
+      values[i].type(Common::Redis::RespType::BulkString);
+      values[i].asString() = keys_[i];
+    }
+    request->type(Common::Redis::RespType::Array);
+    request->asArray().swap(values);
+
+    CommandSplitter::SplitRequestPtr handle =
+        splitter_->makeRequest(std::move(request), callbacks_, dispatcher_, stream_info_);
+    conn_pool_->respond();
+  }
+
+private:
+  std::vector<std::string> keys_;
+  std::shared_ptr<SingleHostConnPool> conn_pool_{std::make_shared<SingleHostConnPool>()};
+  Stats::IsolatedStoreImpl store_;
+  Event::SimulatedTimeSystem time_system_;
+  NiceMock<MockFaultManager> fault_manager_;
+  NiceMock<Event::MockDispatcher> dispatcher_;
+  NiceMock<StreamInfo::MockStreamInfo> stream_info_;
+  std::unique_ptr<CommandSplitter::InstanceImpl> splitter_;
+  NoOpSplitCallbacks callbacks_;
+};
+
+void bmMget(benchmark::State& state) {
+  MultiKeyCommandSpeedTest context(state.range(0) != 0, state.range(1));
+  for (auto _ : state) {
+    UNREFERENCED_PARAMETER(_);
+    context.mget();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(1));
+}
+BENCHMARK(bmMget)->ArgsProduct({{0, 1}, {1, 10, 100, 1000}})->Unit(benchmark::kMicrosecond);
+
+} // namespace
+} // namespace RedisProxy
+} // namespace NetworkFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -96,6 +96,13 @@ const std::string CONFIG_WITH_BATCHING = CONFIG + R"EOF(
             buffer_flush_timeout: 0.003s
 )EOF";
 
+// This is a configuration with the client cache enabled for keys starting with "cached:".
+const std::string CONFIG_WITH_CLIENT_CACHE = CONFIG + R"EOF(
+            client_cache:
+              key_prefixes: ["cached:"]
+              max_size_bytes: 1048576
+)EOF";
+
 const std::string CONFIG_WITH_ROUTES_BASE = fmt::format(R"EOF(
 admin:
   access_log:
@@ -508,6 +515,12 @@ public:
   RedisProxyWithBatchingIntegrationTest() : RedisProxyIntegrationTest(CONFIG_WITH_BATCHING, 2) {}
 };
 
+class RedisProxyWithClientCacheIntegrationTest : public RedisProxyIntegrationTest {
+public:
+  RedisProxyWithClientCacheIntegrationTest()
+      : RedisProxyIntegrationTest(CONFIG_WITH_CLIENT_CACHE, 2) {}
+};
+
 class RedisProxyWithRoutesIntegrationTest : public RedisProxyIntegrationTest {
 public:
   RedisProxyWithRoutesIntegrationTest() : RedisProxyIntegrationTest(CONFIG_WITH_ROUTES, 6) {}
@@ -647,6 +660,10 @@ INSTANTIATE_TEST_SUITE_P(IpVersions, RedisProxyWithBatchingIntegrationTest,
                          testing::ValuesIn(TestEnvironment::getIpVersionsForTest()),
                          TestUtility::ipTestParamsToString);
 
+INSTANTIATE_TEST_SUITE_P(IpVersions, RedisProxyWithClientCacheIntegrationTest,
+                         testing::ValuesIn(TestEnvironment::getIpVersionsForTest()),
+                         TestUtility::ipTestParamsToString);
+
 INSTANTIATE_TEST_SUITE_P(IpVersions, RedisProxyWithRoutesIntegrationTest,
                          testing::ValuesIn(TestEnvironment::getIpVersionsForTest()),
                          TestUtility::ipTestParamsToString);
@@ -1114,6 +1131,59 @@ TEST_P(RedisProxyWithBatchingIntegrationTest, SimpleBatching) {
   EXPECT_TRUE(fake_upstream_connection->close());
 }
 
+// This test verifies that GET commands are served from the client cache once the upstream host
+// is tracked, until their key is invalidated.
+
+TEST_P(RedisProxyWithClientCacheIntegrationTest, CachedGetUntilInvalidated) {
+  initialize();
+
+  const std::string request = makeBulkStringArray({"get", "cached:foo"});
+  const std::string response = "$3\r\nbar\r\n";
+  IntegrationTcpClientPtr redis_client = makeTcpConnection(lookupPort("redis_proxy"));
+
+  // The first GET command starts tracking the host, so its response isn't cached.
+  ASSERT_TRUE(redis_client->write(request));
+  FakeRawConnectionPtr tracking_connection;
+  EXPECT_TRUE(fake_upstreams_[0]->waitForRawConnection(tracking_connection));
+  FakeRawConnectionPtr fake_upstream_connection;
+  expectUpstreamRequestResponse(fake_upstreams_[0], request, response, fake_upstream_connection);
+  proxyResponseOnlyStep(response, redis_client);
+
+  const std::string client_id = makeBulkStringArray({"CLIENT", "ID"});
+  const std::string tracking =
+      makeBulkStringArray(
+          {"CLIENT", "TRACKING", "ON", "REDIRECT", "7", "BCAST", "PREFIX", "cached:"}) +
+      makeBulkStringArray({"SUBSCRIBE", "__redis__:invalidate"});
+  std::string tracking_data;
+  EXPECT_TRUE(tracking_connection->waitForData(client_id.size(), &tracking_data));
+  EXPECT_EQ(client_id, tracking_data);
+  EXPECT_TRUE(tracking_connection->write(":7\r\n"));
+  EXPECT_TRUE(tracking_connection->waitForData(client_id.size() + tracking.size(), &tracking_data));
+  EXPECT_EQ(client_id + tracking, tracking_data);
+  EXPECT_TRUE(tracking_connection->write(
+      "+OK\r\n*3\r\n$9\r\nsubscribe\r\n$20\r\n__redis__:invalidate\r\n:1\r\n"));
+  test_server_->waitForGaugeEq("cluster.cluster_0.redis_cluster.client_cache.tracked_hosts", 1);
+
+  // The next response fills the cache.
+  fake_upstream_connection->clearData();
+  roundtripToUpstreamStep(fake_upstreams_[0], request, response, redis_client,
+                          fake_upstream_connection, "", "");
+  proxyResponseStep(request, response, redis_client);
+  EXPECT_EQ(1, test_server_->counter("cluster.cluster_0.redis_cluster.client_cache.hit")->value());
+
+  // Once the key is invalidated, its GET command is sent upstream again.
+  EXPECT_TRUE(tracking_connection->write("*3\r\n$7\r\nmessage\r\n$20\r\n__redis__:invalidate\r\n"
+                                         "*1\r\n$10\r\ncached:foo\r\n"));
+  test_server_->waitForCounterEq("cluster.cluster_0.redis_cluster.client_cache.invalidation", 1);
+  fake_upstream_connection->clearData();
+  roundtripToUpstreamStep(fake_upstreams_[0], request, "$3\r\nbaz\r\n", redis_client,
+                          fake_upstream_connection, "", "");
+
+  EXPECT_TRUE(fake_upstream_connection->close());
+  EXPECT_TRUE(tracking_connection->close());
+  redis_client->close();
+}
+
 // This test verifies that it's possible to route keys to 3 different upstream pools.
 
 TEST_P(RedisProxyWithRoutesIntegrationTest, SimpleRequestAndResponseRoutedByPrefix) {
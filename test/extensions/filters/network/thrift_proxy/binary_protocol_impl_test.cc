@@ -624,6 +624,118 @@ TEST_F(BinaryProtocolTest, ReadBinary) {
   EXPECT_EQ(buffer.length(), 0);
 }
 
+TEST_F(BinaryProtocolTest, SkipValue) {
+  BinaryProtocolImpl proto;
+
+  // No data
+  {
+    Buffer::OwnedImpl buffer;
+    EXPECT_FALSE(proto.skipValue(buffer, FieldType::Bool));
+  }
+
+  // Primitive values
+  {
+    Buffer::OwnedImpl buffer;
+    proto.writeBool(buffer, true);
+    proto.writeByte(buffer, 1);
+    proto.writeInt16(buffer, 2);
+    proto.writeInt32(buffer, 3);
+    proto.writeInt64(buffer, 4);
+    proto.writeDouble(buffer, 5.0);
+    proto.writeString(buffer, "string");
+    buffer.writeByte(0xff);
+
+    for (FieldType field_type : {FieldType::Bool, FieldType::Byte, FieldType::I16, FieldType::I32,
+                                 FieldType::I64, FieldType::Double, FieldType::String}) {
+      EXPECT_TRUE(proto.skipValue(buffer, field_type));
+    }
+    EXPECT_EQ(buffer.length(), 1);
+  }
+
+  // Nested structs, lists, sets, and maps
+  {
+    Buffer::OwnedImpl buffer;
+    proto.writeStructBegin(buffer, "");
+    proto.writeFieldBegin(buffer, "", FieldType::List, 1);
+    proto.writeListBegin(buffer, FieldType::Struct, 2);
+    for (int i = 0; i < 2; i++) {
+      proto.writeStructBegin(buffer, "");
+      proto.writeFieldBegin(buffer, "", FieldType::Map, 1);
+      proto.writeMapBegin(buffer, FieldType::String, FieldType::Set, 1);
+      proto.writeString(buffer, "key");
+      proto.writeSetBegin(buffer, FieldType::I64, 2);
+      proto.writeInt64(buffer, 1);
+      proto.writeInt64(buffer, 2);
+      proto.writeFieldBegin(buffer, "", FieldType::Map, 2);
+      proto.writeMapBegin(buffer, FieldType::I32, FieldType::Double, 2);
+      for (int j = 0; j < 2; j++) {
+        proto.writeInt32(buffer, j);
+        proto.writeDouble(buffer, j);
+      }
+      proto.writeFieldBegin(buffer, "", FieldType::List, 3);
+      proto.writeListBegin(buffer, FieldType::String, 0);
+      proto.writeFieldBegin(buffer, "", FieldType::Stop, 0);
+    }
+    proto.writeFieldBegin(buffer, "", FieldType::Stop, 0);
+    const uint64_t length = buffer.length();
+    buffer.writeByte(0xff);
+
+    // Insufficient data for each prefix of the value.
+    for (uint64_t i = 1; i < length; i++) {
+      Buffer::OwnedImpl partial(buffer.toString().substr(0, i));
+      EXPECT_FALSE(proto.skipValue(partial, FieldType::Struct));
+      EXPECT_EQ(partial.length(), i);
+    }
+
+    EXPECT_TRUE(proto.skipValue(buffer, FieldType::Struct));
+    EXPECT_EQ(buffer.length(), 1);
+  }
+
+  // Invalid string length
+  {
+    Buffer::OwnedImpl buffer;
+    buffer.writeBEInt<int32_t>(-1);
+
+    EXPECT_THROW_WITH_MESSAGE(proto.skipValue(buffer, FieldType::String), EnvoyException,
+                              "negative binary protocol string/binary length -1");
+    EXPECT_EQ(buffer.length(), 4);
+  }
+
+  // Invalid list size
+  {
+    Buffer::OwnedImpl buffer;
+    buffer.writeByte(static_cast<int8_t>(FieldType::I32));
+    buffer.writeBEInt<int32_t>(-1);
+
+    EXPECT_THROW_WITH_MESSAGE(proto.skipValue(buffer, FieldType::List), EnvoyException,
+                              "negative binary protocol list/set size -1");
+    EXPECT_EQ(buffer.length(), 5);
+  }
+
+  // Invalid map size
+  {
+    Buffer::OwnedImpl buffer;
+    buffer.writeByte(static_cast<int8_t>(FieldType::I32));
+    buffer.writeByte(static_cast<int8_t>(FieldType::I32));
+    buffer.writeBEInt<int32_t>(-1);
+
+    EXPECT_THROW_WITH_MESSAGE(proto.skipValue(buffer, FieldType::Map), EnvoyException,
+                              "negative binary protocol map size -1");
+    EXPECT_EQ(buffer.length(), 6);
+  }
+
+  // Invalid field type
+  {
+    Buffer::OwnedImpl buffer;
+    buffer.writeByte(static_cast<int8_t>(FieldType::Void));
+    buffer.writeBEInt<int16_t>(1);
+
+    EXPECT_THROW_WITH_MESSAGE(proto.skipValue(buffer, FieldType::Struct), EnvoyException,
+                              "unknown field type 1");
+    EXPECT_EQ(buffer.length(), 3);
+  }
+}
+
 TEST_F(BinaryProtocolTest, WriteMessageBegin) {
   BinaryProtocolImpl proto;
 
@@ -460,6 +460,31 @@ TEST(BufferHelperTest, WriteZigZagI64) {
   }
 }
 
+TEST(BufferPeekerTest, PeekAcrossSlices) {
+  Buffer::OwnedImpl buffer;
+  buffer.appendSliceForTest("abc");
+  buffer.appendSliceForTest("defg");
+  buffer.appendSliceForTest("h");
+
+  BufferPeeker peeker(buffer);
+  EXPECT_EQ(8, peeker.length());
+  // Within the front slice.
+  EXPECT_EQ("ab", absl::string_view(reinterpret_cast<const char*>(peeker.peek(0, 2)), 2));
+  // Spanning the first and second slices.
+  EXPECT_EQ("cde", absl::string_view(reinterpret_cast<const char*>(peeker.peek(2, 3)), 3));
+  // Within the second slice.
+  EXPECT_EQ("fg", absl::string_view(reinterpret_cast<const char*>(peeker.peek(5, 2)), 2));
+  // Clamped to the end of the buffer.
+  EXPECT_EQ("gh", absl::string_view(reinterpret_cast<const char*>(peeker.peek(6, 4)), 2));
+  EXPECT_EQ('h', peeker.peek(7, 1)[0]);
+  // Nothing is peeked at the end of the buffer.
+  EXPECT_NE(nullptr, peeker.peek(8, 1));
+
+  // The buffer isn't changed.
+  EXPECT_EQ(3, buffer.getRawSlices().size());
+  EXPECT_EQ("abcdefgh", buffer.toString());
+}
+
 } // namespace ThriftProxy
 } // namespace NetworkFilters
 } // namespace Extensions
@@ -997,6 +997,171 @@ TEST_F(CompactProtocolTest, ReadBinary) {
   EXPECT_EQ(buffer.length(), 0);
 }
 
+TEST_F(CompactProtocolTest, SkipValue) {
+  // No data
+  {
+    CompactProtocolImpl proto;
+    Buffer::OwnedImpl buffer;
+    EXPECT_FALSE(proto.skipValue(buffer, FieldType::Bool));
+  }
+
+  // Primitive values
+  {
+    CompactProtocolImpl proto;
+    Buffer::OwnedImpl buffer;
+    proto.writeBool(buffer, true);
+    proto.writeByte(buffer, 1);
+    proto.writeInt16(buffer, -2);
+    proto.writeInt32(buffer, 300000);
+    proto.writeInt64(buffer, std::numeric_limits<int64_t>::min());
+    proto.writeDouble(buffer, 5.0);
+    proto.writeString(buffer, "string");
+    buffer.writeByte(0xff);
+
+    for (FieldType field_type : {FieldType::Bool, FieldType::Byte, FieldType::I16, FieldType::I32,
+                                 FieldType::I64, FieldType::Double, FieldType::String}) {
+      EXPECT_TRUE(proto.skipValue(buffer, field_type));
+    }
+    EXPECT_EQ(buffer.length(), 1);
+  }
+
+  // Boolean struct field
+  {
+    CompactProtocolImpl proto;
+    Buffer::OwnedImpl buffer;
+    std::string name;
+    FieldType field_type;
+    int16_t field_id;
+
+    buffer.writeByte(0x11);
+    buffer.writeByte(0xff);
+
+    EXPECT_TRUE(proto.readFieldBegin(buffer, name, field_type, field_id));
+    EXPECT_EQ(field_type, FieldType::Bool);
+    EXPECT_TRUE(proto.skipValue(buffer, field_type));
+    EXPECT_TRUE(proto.readFieldEnd(buffer));
+    EXPECT_EQ(buffer.length(), 1);
+  }
+
+  // Nested structs, lists, sets, and maps
+  {
+    CompactProtocolImpl proto;
+    Buffer::OwnedImpl buffer;
+    proto.writeStructBegin(buffer, "");
+    proto.writeFieldBegin(buffer, "", FieldType::List, 1);
+    proto.writeListBegin(buffer, FieldType::Struct, 2);
+    for (int i = 0; i < 2; i++) {
+      proto.writeStructBegin(buffer, "");
+      proto.writeFieldBegin(buffer, "", FieldType::Bool, 1);
+      proto.writeBool(buffer, i == 0);
+      proto.writeFieldEnd(buffer);
+      // Long form field header.
+      proto.writeFieldBegin(buffer, "", FieldType::Map, 100);
+      proto.writeMapBegin(buffer, FieldType::String, FieldType::Set, 1);
+      proto.writeString(buffer, "key");
+      proto.writeSetBegin(buffer, FieldType::Bool, 2);
+      proto.writeBool(buffer, true);
+      proto.writeBool(buffer, false);
+      proto.writeSetEnd(buffer);
+      proto.writeMapEnd(buffer);
+      proto.writeFieldEnd(buffer);
+      proto.writeFieldBegin(buffer, "", FieldType::Map, 101);
+      proto.writeMapBegin(buffer, FieldType::Byte, FieldType::Double, 2);
+      for (int j = 0; j < 2; j++) {
+        proto.writeByte(buffer, j);
+        proto.writeDouble(buffer, j);
+      }
+      proto.writeMapEnd(buffer);
+      proto.writeFieldEnd(buffer);
+      proto.writeFieldBegin(buffer, "", FieldType::Map, 102);
+      proto.writeMapBegin(buffer, FieldType::I32, FieldType::I64, 0);
+      proto.writeMapEnd(buffer);
+      proto.writeFieldEnd(buffer);
+      // Long form list header.
+      proto.writeFieldBegin(buffer, "", FieldType::List, 103);
+      proto.writeListBegin(buffer, FieldType::I32, 20);
+      for (int j = 0; j < 20; j++) {
+        proto.writeInt32(buffer, j * 1000);
+      }
+      proto.writeListEnd(buffer);
+      proto.writeFieldEnd(buffer);
+      proto.writeFieldBegin(buffer, "", FieldType::Stop, 0);
+      proto.writeStructEnd(buffer);
+    }
+    proto.writeListEnd(buffer);
+    proto.writeFieldEnd(buffer);
+    proto.writeFieldBegin(buffer, "", FieldType::Stop, 0);
+    proto.writeStructEnd(buffer);
+    const uint64_t length = buffer.length();
+    buffer.writeByte(0xff);
+
+    // Insufficient data for each prefix of the value.
+    for (uint64_t i = 1; i < length; i++) {
+      Buffer::OwnedImpl partial(buffer.toString().substr(0, i));
+      EXPECT_FALSE(proto.skipValue(partial, FieldType::Struct));
+      EXPECT_EQ(partial.length(), i);
+    }
+
+    EXPECT_TRUE(proto.skipValue(buffer, FieldType::Struct));
+    EXPECT_EQ(buffer.length(), 1);
+  }
+
+  // Invalid varint
+  {
+    CompactProtocolImpl proto;
+    Buffer::OwnedImpl buffer;
+    addRepeated(buffer, 5, 0x81);
+
+    EXPECT_THROW_WITH_MESSAGE(proto.skipValue(buffer, FieldType::I32), EnvoyException,
+                              "invalid compact protocol varint");
+    EXPECT_EQ(buffer.length(), 5);
+  }
+
+  // Invalid string length
+  {
+    CompactProtocolImpl proto;
+    Buffer::OwnedImpl buffer;
+    addSeq(buffer, {0xFF, 0xFF, 0xFF, 0xFF, 0x0F}); // -1
+
+    EXPECT_THROW_WITH_MESSAGE(proto.skipValue(buffer, FieldType::String), EnvoyException,
+                              "negative compact protocol string/binary length -1");
+    EXPECT_EQ(buffer.length(), 5);
+  }
+
+  // Invalid list size
+  {
+    CompactProtocolImpl proto;
+    Buffer::OwnedImpl buffer;
+    addSeq(buffer, {0xF5, 0xFF, 0xFF, 0xFF, 0xFF, 0x0F}); // -1
+
+    EXPECT_THROW_WITH_MESSAGE(proto.skipValue(buffer, FieldType::List), EnvoyException,
+                              "negative compact protocol list/set size -1");
+    EXPECT_EQ(buffer.length(), 6);
+  }
+
+  // Invalid map size
+  {
+    CompactProtocolImpl proto;
+    Buffer::OwnedImpl buffer;
+    addSeq(buffer, {0xFF, 0xFF, 0xFF, 0xFF, 0x0F}); // -1
+
+    EXPECT_THROW_WITH_MESSAGE(proto.skipValue(buffer, FieldType::Map), EnvoyException,
+                              "negative compact protocol map size -1");
+    EXPECT_EQ(buffer.length(), 5);
+  }
+
+  // Invalid field type
+  {
+    CompactProtocolImpl proto;
+    Buffer::OwnedImpl buffer;
+    buffer.writeByte(0x1D);
+
+    EXPECT_THROW_WITH_MESSAGE(proto.skipValue(buffer, FieldType::Struct), EnvoyException,
+                              "unknown compact protocol field type 13");
+    EXPECT_EQ(buffer.length(), 1);
+  }
+}
+
 class CompactProtocolFieldTypeTest : public testing::TestWithParam<uint8_t> {};
 
 TEST_P(CompactProtocolFieldTypeTest, ConvertsToFieldType) {
@@ -0,0 +1,123 @@
+// Note: this should be run with --compilation_mode=opt, and would benefit from a
+// quiescent system with disabled cstate power management.
+
+#include <memory>
+#include <string>
+
+#include "source/common/buffer/buffer_impl.h"
+#include "source/extensions/filters/network/thrift_proxy/binary_protocol_impl.h"
+#include "source/extensions/filters/network/thrift_proxy/compact_protocol_impl.h"
+#include "source/extensions/filters/network/thrift_proxy/decoder.h"
+#include "source/extensions/filters/network/thrift_proxy/passthrough_decoder_event_handler.h"
+
+#include "benchmark/benchmark.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace NetworkFilters {
+namespace ThriftProxy {
+namespace {
+
+// Decodes every field, or skips the values of all the fields but the top level field 1, as the
+// payload to metadata filter does for the fields which can't match its rules.
+class FieldSelectingHandler : public DecoderCallbacks, public PassThroughDecoderEventHandler {
+public:
+  FieldSelectingHandler(bool skip) : skip_(skip) {}
+
+  // DecoderCallbacks
+  DecoderEventHandler& newDecoderEventHandler() override { return *this; }
+  bool passthroughEnabled() const override { return false; }
+  bool isRequest() const override { return true; }
+  bool headerKeysPreserveCase() const override { return false; }
+  bool skipFieldValue(FieldType, int16_t field_id) override { return skip_ && field_id != 1; }
+
+  // PassThroughDecoderEventHandler
+  FilterStatus stringValue(absl::string_view value) override {
+    benchmark::DoNotOptimize(value.data());
+    return FilterStatus::Continue;
+  }
+
+private:
+  const bool skip_;
+};
+
+ProtocolPtr createProtocol(bool compact) {
+  if (compact) {
+    return std::make_unique<CompactProtocolImpl>();
+  }
+  return std::make_unique<BinaryProtocolImpl>();
+}
+
+// Writes a struct which nests `depth` levels of structs, each with a few primitive fields, a list,
+// and a map.
+void writeNestedStruct(Protocol& proto, Buffer::Instance& buffer, uint64_t depth) {
+  proto.writeStructBegin(buffer, "");
+
+  proto.writeFieldBegin(buffer, "", FieldType::String, 1);
+  proto.writeString(buffer, "request-id");
+  proto.writeFieldEnd(buffer);
+
+  proto.writeFieldBegin(buffer, "", FieldType::I64, 2);
+  proto.writeInt64(buffer, 1234567890);
+  proto.writeFieldEnd(buffer);
+
+  proto.writeFieldBegin(buffer, "", FieldType::Bool, 3);
+  proto.writeBool(buffer, true);
+  proto.writeFieldEnd(buffer);
+
+  proto.writeFieldBegin(buffer, "", FieldType::List, 4);
+  proto.writeListBegin(buffer, FieldType::I32, 16);
+  for (int32_t i = 0; i < 16; i++) {
+    proto.writeInt32(buffer, i * 1000);
+  }
+  proto.writeListEnd(buffer);
+  proto.writeFieldEnd(buffer);
+
+  proto.writeFieldBegin(buffer, "", FieldType::Map, 5);
+  proto.writeMapBegin(buffer, FieldType::String, FieldType::String, 4);
+  for (int i = 0; i < 4; i++) {
+    proto.writeString(buffer, "key" + std::to_string(i));
+    proto.writeString(buffer, std::string(32, 'v'));
+  }
+  proto.writeMapEnd(buffer);
+  proto.writeFieldEnd(buffer);
+
+  if (depth > 0) {
+    proto.writeFieldBegin(buffer, "", FieldType::Struct, 6);
+    writeNestedStruct(proto, buffer, depth - 1);
+    proto.writeFieldEnd(buffer);
+  }
+
+  proto.writeFieldBegin(buffer, "", FieldType::Stop, 0);
+  proto.writeStructEnd(buffer);
+}
+
+// Decodes a struct nested `range(1)` levels deep, with the binary protocol if `range(2)` is 0 or
+// the compact protocol if it is 1. The values of the fields which aren't needed are skipped if
+// `range(0)` is 1.
+void bmDecodeNestedStruct(benchmark::State& state) {
+  const bool compact = state.range(2) != 0;
+  Buffer::OwnedImpl body;
+  writeNestedStruct(*createProtocol(compact), body, state.range(1));
+  const std::string data = body.toString();
+
+  ProtocolPtr proto = createProtocol(compact);
+  FieldSelectingHandler handler(state.range(0) != 0);
+  MessageMetadataSharedPtr metadata = std::make_shared<MessageMetadata>();
+  for (auto _ : state) {
+    UNREFERENCED_PARAMETER(_);
+    Buffer::OwnedImpl buffer(data);
+    DecoderStateMachine state_machine(*proto, metadata, handler, handler);
+    state_machine.runPassthroughData(buffer);
+  }
+  state.SetBytesProcessed(state.iterations() * data.size());
+}
+BENCHMARK(bmDecodeNestedStruct)
+    ->ArgsProduct({{0, 1}, {1, 8, 32}, {0, 1}})
+    ->Unit(benchmark::kMicrosecond);
+
+} // namespace
+} // namespace ThriftProxy
+} // namespace NetworkFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -287,6 +287,60 @@ TEST_P(DecoderStateMachineValueTest, FieldValue) {
   EXPECT_EQ(dsm.currentState(), ProtocolState::FieldBegin);
 }
 
+TEST_P(DecoderStateMachineValueTest, SkipFieldValue) {
+  FieldType field_type = GetParam();
+  Buffer::OwnedImpl buffer;
+  InSequence dummy;
+
+  EXPECT_CALL(proto_, readFieldBegin(Ref(buffer), _, _, _))
+      .WillOnce(DoAll(SetArgReferee<1>(std::string("")), SetArgReferee<2>(field_type),
+                      SetArgReferee<3>(1), Return(true)));
+  EXPECT_CALL(handler_, fieldBegin(absl::string_view(), _, _))
+      .WillOnce(Return(FilterStatus::Continue));
+  EXPECT_CALL(callbacks_, skipFieldValue(field_type, 1)).WillOnce(Return(true));
+  EXPECT_CALL(proto_, skipValue(Ref(buffer), field_type)).WillOnce(Return(false));
+  EXPECT_CALL(proto_, skipValue(Ref(buffer), field_type)).WillOnce(Return(true));
+  EXPECT_CALL(proto_, readFieldEnd(Ref(buffer))).WillOnce(Return(true));
+  EXPECT_CALL(handler_, fieldEnd()).WillOnce(Return(FilterStatus::Continue));
+  EXPECT_CALL(proto_, readFieldBegin(Ref(buffer), _, _, _)).WillOnce(Return(false));
+
+  DecoderStateMachine dsm(proto_, metadata_, handler_, callbacks_);
+
+  dsm.setCurrentState(ProtocolState::FieldBegin);
+  EXPECT_EQ(dsm.run(buffer), ProtocolState::WaitForData);
+  EXPECT_EQ(dsm.currentState(), ProtocolState::FieldValue);
+
+  EXPECT_EQ(dsm.run(buffer), ProtocolState::WaitForData);
+  EXPECT_EQ(dsm.currentState(), ProtocolState::FieldBegin);
+}
+
+TEST_F(DecoderStateMachineTest, SkipStructFieldValue) {
+  Buffer::OwnedImpl buffer;
+  InSequence dummy;
+
+  EXPECT_CALL(proto_, readFieldBegin(Ref(buffer), _, _, _))
+      .WillOnce(DoAll(SetArgReferee<2>(FieldType::Struct), SetArgReferee<3>(1), Return(true)));
+  EXPECT_CALL(callbacks_, skipFieldValue(FieldType::Struct, 1)).WillOnce(Return(true));
+  EXPECT_CALL(proto_, skipValue(Ref(buffer), FieldType::Struct)).WillOnce(Return(true));
+  EXPECT_CALL(proto_, readStructBegin(_, _)).Times(0);
+  EXPECT_CALL(handler_, structBegin(_)).Times(0);
+  EXPECT_CALL(proto_, readFieldEnd(Ref(buffer))).WillOnce(Return(true));
+
+  // The next field is decoded.
+  EXPECT_CALL(proto_, readFieldBegin(Ref(buffer), _, _, _))
+      .WillOnce(DoAll(SetArgReferee<2>(FieldType::I32), SetArgReferee<3>(2), Return(true)));
+  EXPECT_CALL(callbacks_, skipFieldValue(FieldType::I32, 2)).WillOnce(Return(false));
+  expectValue(proto_, handler_, FieldType::I32);
+  EXPECT_CALL(proto_, readFieldEnd(Ref(buffer))).WillOnce(Return(true));
+  EXPECT_CALL(proto_, readFieldBegin(Ref(buffer), _, _, _)).WillOnce(Return(false));
+
+  DecoderStateMachine dsm(proto_, metadata_, handler_, callbacks_);
+
+  dsm.setCurrentState(ProtocolState::FieldBegin);
+  EXPECT_EQ(dsm.run(buffer), ProtocolState::WaitForData);
+  EXPECT_EQ(dsm.currentState(), ProtocolState::FieldBegin);
+}
+
 TEST_F(DecoderStateMachineTest, NoListValueData) {
   Buffer::OwnedImpl buffer;
   InSequence dummy;
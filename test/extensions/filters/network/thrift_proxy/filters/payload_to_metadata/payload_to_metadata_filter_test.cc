@@ -6,6 +6,7 @@
 #include "test/mocks/network/mocks.h"
 #include "test/mocks/server/mocks.h"
 #include "test/mocks/stream_info/mocks.h"
+#include "test/test_common/test_runtime.h"
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
@@ -331,6 +332,39 @@ request_rules:
   filter_->onDestroy();
 }
 
+TEST_F(PayloadToMetadataTest, MatchSecondLayerStringSkippingUnmatchedFields) {
+  TestScopedRuntime scoped_runtime;
+  scoped_runtime.mergeValues(
+      {{"envoy.reloadable_features.thrift_payload_to_metadata_skip_unmatched_fields", "true"}});
+
+  const std::string request_config_yaml = R"EOF(
+request_rules:
+  - method_name: foo
+    field_selector:
+      name: payload
+      id: 3
+      child:
+        name: f7
+        id: 7
+    on_present:
+      metadata_namespace: envoy.lb
+      key: present
+    on_missing:
+      metadata_namespace: envoy.lb
+      key: missing
+      value: unknown
+)EOF";
+
+  const std::map<std::string, std::string> expected = {{"present", "seven"}};
+
+  initializeFilter(request_config_yaml);
+  EXPECT_CALL(req_info_, setDynamicMetadata("envoy.lb", MapEq(expected)));
+  EXPECT_CALL(decoder_callbacks_, streamInfo()).WillRepeatedly(ReturnRef(req_info_));
+
+  writeMessage();
+  filter_->onDestroy();
+}
+
 TEST_F(PayloadToMetadataTest, MatchFirstLayerNumber) {
   const std::string request_config_yaml = R"EOF(
 request_rules:
@@ -91,6 +91,7 @@ public:
   MOCK_METHOD(bool, readDouble, (Buffer::Instance & buffer, double& value));
   MOCK_METHOD(bool, readString, (Buffer::Instance & buffer, std::string& value));
   MOCK_METHOD(bool, readBinary, (Buffer::Instance & buffer, std::string& value));
+  MOCK_METHOD(bool, skipValue, (Buffer::Instance & buffer, FieldType field_type));
 
   MOCK_METHOD(void, writeMessageBegin,
               (Buffer::Instance & buffer, const MessageMetadata& metadata));
@@ -138,6 +139,7 @@ public:
   MOCK_METHOD(bool, passthroughEnabled, (), (const));
   MOCK_METHOD(bool, isRequest, (), (const));
   MOCK_METHOD(bool, headerKeysPreserveCase, (), (const));
+  MOCK_METHOD(bool, skipFieldValue, (FieldType field_type, int16_t field_id));
 };
 
 class MockDecoderEventHandler : public DecoderEventHandler {
@@ -17,6 +17,7 @@
 #include "test/extensions/filters/udp/udp_proxy/session_filters/drainer_filter.pb.h"
 #include "test/mocks/api/mocks.h"
 #include "test/mocks/http/stream_encoder.h"
+#include "test/mocks/network/mocks.h"
 #include "test/mocks/network/socket.h"
 #include "test/mocks/server/factory_context.h"
 #include "test/mocks/server/listener_factory_context.h"
@@ -26,11 +27,13 @@
 #include "test/mocks/upstream/host.h"
 #include "test/mocks/upstream/load_balancer_context.h"
 #include "test/mocks/upstream/thread_local_cluster.h"
+#include "test/test_common/registry.h"
 #include "test/test_common/threadsafe_singleton_injector.h"
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
+using testing::Assign;
 using testing::AtLeast;
 using testing::ByMove;
 using testing::DoAll;
@@ -39,6 +42,7 @@ using testing::InSequence;
 using testing::InvokeWithoutArgs;
 using testing::Return;
 using testing::ReturnNew;
+using testing::ReturnPointee;
 using testing::ReturnRef;
 using testing::SaveArg;
 
@@ -65,6 +69,73 @@ Api::IoCallUint64Result makeError(int sys_errno) {
   return {0, Network::IoSocketError::create(sys_errno)};
 }
 
+// State shared with the writers created by TestUdpPacketWriterFactoryFactory.
+struct TestBatchWriterState {
+  std::vector<std::string> buffered_;
+  std::vector<std::string> flushed_;
+  uint64_t max_packet_size_{1452};
+  bool write_blocked_{};
+  // If set, flush() returns EAGAIN and blocks the writer.
+  bool flush_blocked_{};
+  // If set, flush() fails and drops the buffered datagrams.
+  bool flush_error_{};
+};
+
+// Stands in for a batching writer such as the GSO writer: datagrams are buffered until flushed.
+class TestUdpPacketWriterFactoryFactory : public Network::UdpPacketWriterFactoryFactory {
+public:
+  explicit TestUdpPacketWriterFactoryFactory(TestBatchWriterState& state) : state_(state) {}
+
+  std::string name() const override { return "envoy.udp_packet_writer.test"; }
+  Network::UdpPacketWriterFactoryPtr
+  createUdpPacketWriterFactory(const envoy::config::core::v3::TypedExtensionConfig&) override {
+    auto factory = std::make_unique<NiceMock<Network::MockUdpPacketWriterFactory>>();
+    ON_CALL(*factory, createUdpPacketWriter(_, _))
+        .WillByDefault(Invoke([this](Network::IoHandle&, Stats::Scope&) {
+          return Network::UdpPacketWriterPtr{createWriter()};
+        }));
+    return factory;
+  }
+  ProtobufTypes::MessagePtr createEmptyConfigProto() override {
+    return std::make_unique<ProtobufWkt::Struct>();
+  }
+
+private:
+  Network::MockUdpPacketWriter* createWriter() {
+    auto* writer = new NiceMock<Network::MockUdpPacketWriter>();
+    ON_CALL(*writer, isBatchMode()).WillByDefault(Return(true));
+    ON_CALL(*writer, isWriteBlocked()).WillByDefault(ReturnPointee(&state_.write_blocked_));
+    ON_CALL(*writer, setWritable()).WillByDefault(Assign(&state_.write_blocked_, false));
+    ON_CALL(*writer, getMaxPacketSize(_)).WillByDefault(ReturnPointee(&state_.max_packet_size_));
+    ON_CALL(*writer, writePacket(_, _, _))
+        .WillByDefault(Invoke([this](const Buffer::Instance& buffer, const Network::Address::Ip*,
+                                     const Network::Address::Instance&) {
+          state_.buffered_.push_back(buffer.toString());
+          return makeNoError(buffer.length());
+        }));
+    ON_CALL(*writer, flush()).WillByDefault(Invoke([this]() -> Api::IoCallUint64Result {
+      if (state_.flush_blocked_) {
+        state_.write_blocked_ = true;
+        return {0, Network::IoSocketError::getIoSocketEagainError()};
+      }
+      if (state_.flush_error_) {
+        state_.buffered_.clear();
+        return makeError(SOCKET_ERROR_MSG_SIZE);
+      }
+      uint64_t flushed_bytes = 0;
+      for (std::string& datagram : state_.buffered_) {
+        flushed_bytes += datagram.size();
+        state_.flushed_.push_back(std::move(datagram));
+      }
+      state_.buffered_.clear();
+      return makeNoError(flushed_bytes);
+    }));
+    return writer;
+  }
+
+  TestBatchWriterState& state_;
+};
+
 class UdpProxyFilterBase : public testing::Test {
 public:
   UdpProxyFilterBase() {
@@ -270,7 +341,8 @@ public:
     filter_->onData(data);
   }
 
-  void expectSessionCreate(const Network::Address::InstanceConstSharedPtr& address) {
+  void expectSessionCreate(const Network::Address::InstanceConstSharedPtr& address,
+                           uint32_t file_events = Event::FileReadyType::Read) {
     test_sessions_.emplace_back(*this, address);
     TestSession& new_session = test_sessions_.back();
     new_session.idle_timer_ = new Event::MockTimer(&callbacks_.udp_listener_.dispatcher_);
@@ -278,7 +350,7 @@ public:
         .WillOnce(Return(ByMove(Network::SocketPtr{test_sessions_.back().socket_})));
     EXPECT_CALL(
         *new_session.socket_->io_handle_,
-        createFileEvent_(_, _, Event::PlatformDefaultTriggerType, Event::FileReadyType::Read))
+        createFileEvent_(_, _, Event::PlatformDefaultTriggerType, file_events))
         .WillOnce(SaveArg<1>(&new_session.file_event_cb_));
     // Internal Buffer is Empty, flush will be a no-op
     ON_CALL(callbacks_.udp_listener_, flush())
@@ -1096,6 +1168,150 @@ tunneling_config:
       "Only one of use_per_packet_load_balancing or tunneling_config can be used.");
 }
 
+TEST_F(UdpProxyFilterTest, MutualExcludeUpstreamPacketWriterAndTunneling) {
+  TestBatchWriterState writer_state;
+  TestUdpPacketWriterFactoryFactory writer_factory(writer_state);
+  Registry::InjectFactory<Network::UdpPacketWriterFactoryFactory> registration(writer_factory);
+
+  auto config = R"EOF(
+stat_prefix: foo
+matcher:
+  on_no_match:
+    action:
+      name: route
+      typed_config:
+        '@type': type.googleapis.com/envoy.extensions.filters.udp.udp_proxy.v3.Route
+        cluster: fake_cluster
+upstream_packet_writer_config:
+  name: envoy.udp_packet_writer.test
+  typed_config:
+    '@type': type.googleapis.com/google.protobuf.Struct
+tunneling_config:
+  proxy_host: host.com
+  target_host: host.com
+  default_target_port: 30
+  )EOF";
+
+  EXPECT_THROW_WITH_MESSAGE(
+      setup(readConfig(config)), EnvoyException,
+      "Only one of upstream_packet_writer_config or tunneling_config can be used.");
+}
+
+class UdpProxyFilterBatchWriterTest : public UdpProxyFilterTest {
+public:
+  UdpProxyFilterBatchWriterTest()
+      : writer_factory_(writer_state_), registration_(writer_factory_) {}
+
+  // The sessions' writers refer to writer_state_, so destroy them first.
+  ~UdpProxyFilterBatchWriterTest() override { filter_.reset(); }
+
+  void setupBatchWriter() {
+    setup(readConfig(R"EOF(
+stat_prefix: foo
+matcher:
+  on_no_match:
+    action:
+      name: route
+      typed_config:
+        '@type': type.googleapis.com/envoy.extensions.filters.udp.udp_proxy.v3.Route
+        cluster: fake_cluster
+upstream_packet_writer_config:
+  name: envoy.udp_packet_writer.test
+  typed_config:
+    '@type': type.googleapis.com/google.protobuf.Struct
+    )EOF"));
+
+    expectSessionCreate(upstream_address_,
+                        Event::FileReadyType::Read | Event::FileReadyType::Write);
+    flush_cb_ = new NiceMock<Event::MockSchedulableCallback>(&callbacks_.udp_listener_.dispatcher_);
+    EXPECT_CALL(*test_sessions_[0].idle_timer_, enableTimer(_, _)).Times(AtLeast(1));
+    EXPECT_CALL(*test_sessions_[0].socket_->io_handle_, connect(_))
+        .WillOnce(Return(Api::SysCallIntResult{0, 0}));
+  }
+
+  uint64_t clusterCounter(const std::string& name) {
+    return TestUtility::findCounter(factory_context_.server_factory_context_.cluster_manager_
+                                        .thread_local_cluster_.cluster_.info_->stats_store_,
+                                    name)
+        ->value();
+  }
+
+  TestBatchWriterState writer_state_;
+  TestUdpPacketWriterFactoryFactory writer_factory_;
+  Registry::InjectFactory<Network::UdpPacketWriterFactoryFactory> registration_;
+  NiceMock<Event::MockSchedulableCallback>* flush_cb_{};
+};
+
+// Datagrams written upstream during an event loop iteration are flushed together at its end.
+TEST_F(UdpProxyFilterBatchWriterTest, FlushAtEndOfIteration) {
+  setupBatchWriter();
+
+  recvDataFromDownstream("10.0.0.1:1000", "10.0.0.2:80", "hello1");
+  recvDataFromDownstream("10.0.0.1:1000", "10.0.0.2:80", "hello2");
+  recvDataFromDownstream("10.0.0.1:1000", "10.0.0.2:80", "hello3");
+  EXPECT_TRUE(flush_cb_->enabled_);
+  EXPECT_THAT(writer_state_.buffered_, testing::ElementsAre("hello1", "hello2", "hello3"));
+  EXPECT_TRUE(writer_state_.flushed_.empty());
+  EXPECT_EQ(3, clusterCounter("udp.sess_tx_datagrams"));
+
+  flush_cb_->invokeCallback();
+  EXPECT_THAT(writer_state_.flushed_, testing::ElementsAre("hello1", "hello2", "hello3"));
+  EXPECT_TRUE(writer_state_.buffered_.empty());
+
+  // A datagram too large for the writer flushes what is buffered and is written directly.
+  recvDataFromDownstream("10.0.0.1:1000", "10.0.0.2:80", "hello4");
+  writer_state_.max_packet_size_ = 8;
+  EXPECT_CALL(*test_sessions_[0].socket_->io_handle_, wasConnected()).WillOnce(Return(true));
+  EXPECT_CALL(*test_sessions_[0].socket_->io_handle_, writev(_, 1))
+      .WillOnce(Invoke([](const Buffer::RawSlice* slices, uint64_t) -> Api::IoCallUint64Result {
+        EXPECT_EQ("oversized datagram", absl::string_view(static_cast<const char*>(slices[0].mem_),
+                                                          slices[0].len_));
+        return makeNoError(slices[0].len_);
+      }));
+  recvDataFromDownstream("10.0.0.1:1000", "10.0.0.2:80", "oversized datagram");
+  EXPECT_THAT(writer_state_.flushed_,
+              testing::ElementsAre("hello1", "hello2", "hello3", "hello4"));
+  EXPECT_EQ(5, clusterCounter("udp.sess_tx_datagrams"));
+
+  // Buffered datagrams are flushed when the session is destroyed.
+  writer_state_.max_packet_size_ = 1452;
+  flush_cb_->invokeCallback();
+  recvDataFromDownstream("10.0.0.1:1000", "10.0.0.2:80", "bye");
+  filter_.reset();
+  EXPECT_EQ("bye", writer_state_.flushed_.back());
+  EXPECT_EQ(0, clusterCounter("udp.sess_tx_errors"));
+}
+
+// A flush which would block is retried once the upstream socket becomes writable, and datagrams
+// written while the writer is blocked are dropped.
+TEST_F(UdpProxyFilterBatchWriterTest, WriteBlocked) {
+  setupBatchWriter();
+
+  recvDataFromDownstream("10.0.0.1:1000", "10.0.0.2:80", "hello1");
+  writer_state_.flush_blocked_ = true;
+  flush_cb_->invokeCallback();
+  EXPECT_TRUE(writer_state_.write_blocked_);
+  EXPECT_EQ(0, clusterCounter("udp.sess_tx_errors"));
+
+  recvDataFromDownstream("10.0.0.1:1000", "10.0.0.2:80", "hello2");
+  EXPECT_FALSE(flush_cb_->enabled_);
+  EXPECT_EQ(1, clusterCounter("udp.sess_tx_errors"));
+  EXPECT_EQ(1, clusterCounter("udp.sess_tx_datagrams"));
+
+  writer_state_.flush_blocked_ = false;
+  EXPECT_TRUE(test_sessions_[0].file_event_cb_(Event::FileReadyType::Write).ok());
+  EXPECT_FALSE(writer_state_.write_blocked_);
+  EXPECT_THAT(writer_state_.flushed_, testing::ElementsAre("hello1"));
+
+  // A failed flush counts as a single error.
+  recvDataFromDownstream("10.0.0.1:1000", "10.0.0.2:80", "hello3");
+  recvDataFromDownstream("10.0.0.1:1000", "10.0.0.2:80", "hello4");
+  writer_state_.flush_error_ = true;
+  flush_cb_->invokeCallback();
+  EXPECT_EQ(2, clusterCounter("udp.sess_tx_errors"));
+  EXPECT_EQ(3, clusterCounter("udp.sess_tx_datagrams"));
+}
+
 // Verify that on second data packet sent from the client, another upstream host is selected.
 TEST_F(UdpProxyFilterTest, PerPacketLoadBalancingBasicFlow) {
   InSequence s;
@@ -0,0 +1,92 @@
+#include <memory>
+#include <string>
+
+#include "source/common/api/os_sys_calls_impl.h"
+#include "source/common/buffer/buffer_impl.h"
+#include "source/common/network/socket_impl.h"
+#include "source/common/network/utility.h"
+#include "source/common/quic/udp_gso_batch_writer.h"
+#include "source/common/stats/isolated_store_impl.h"
+
+#include "benchmark/benchmark.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace UdpFilters {
+namespace UdpProxy {
+namespace {
+
+// Compares the upstream packet rate of a UDP proxy session writing each datagram with its own
+// sendmsg to buffering the datagrams in the GSO batch writer and flushing once per burst, which is
+// what a session does per event loop iteration when upstream_packet_writer_config is set.
+enum class WriterType : int64_t { Direct = 0, GsoBatch = 1 };
+
+class UpstreamSocketFixture {
+public:
+  UpstreamSocketFixture() {
+    const auto loopback = Network::Utility::parseInternetAddressAndPortNoThrow("127.0.0.1:0");
+    receiver_ = std::make_unique<Network::SocketImpl>(Network::Socket::Type::Datagram, loopback,
+                                                      nullptr, Network::SocketCreationOptions{});
+    RELEASE_ASSERT(receiver_->bind(loopback).return_value_ == 0, "");
+    upstream_address_ = receiver_->ioHandle().localAddress();
+
+    // The upstream socket is connected, as in UdpActiveSession::writeUpstream().
+    upstream_ = std::make_unique<Network::SocketImpl>(Network::Socket::Type::Datagram,
+                                                      upstream_address_, nullptr,
+                                                      Network::SocketCreationOptions{});
+    RELEASE_ASSERT(upstream_->ioHandle().connect(upstream_address_).return_value_ == 0, "");
+  }
+
+  Network::IoHandle& upstreamIoHandle() { return upstream_->ioHandle(); }
+  const Network::Address::Instance& upstreamAddress() const { return *upstream_address_; }
+
+private:
+  // Datagrams which do not fit the receive buffer are dropped, which doesn't affect the sender.
+  Network::SocketPtr receiver_;
+  Network::SocketPtr upstream_;
+  Network::Address::InstanceConstSharedPtr upstream_address_;
+};
+
+// Writes bursts of `range(1)` datagrams of `range(2)` bytes upstream.
+void bmUpstreamPacketRate(benchmark::State& state) {
+  const auto type = static_cast<WriterType>(state.range(0));
+  const int64_t burst = state.range(1);
+  const Buffer::OwnedImpl datagram(std::string(state.range(2), 'a'));
+  if (type == WriterType::GsoBatch && !Api::OsSysCallsSingleton::get().supportsUdpGso()) {
+    state.SkipWithError("UDP GSO is not supported by the kernel");
+    return;
+  }
+
+  UpstreamSocketFixture fixture;
+  Stats::IsolatedStoreImpl stats_store;
+  Quic::UdpGsoBatchWriter gso_writer(fixture.upstreamIoHandle(), *stats_store.rootScope());
+  for (auto _ : state) {
+    UNREFERENCED_PARAMETER(_);
+    for (int64_t i = 0; i < burst; i++) {
+      const Api::IoCallUint64Result rc =
+          type == WriterType::Direct
+              ? Network::Utility::writeToSocket(fixture.upstreamIoHandle(), datagram, nullptr,
+                                                fixture.upstreamAddress())
+              : gso_writer.writePacket(datagram, nullptr, fixture.upstreamAddress());
+      benchmark::DoNotOptimize(rc.return_value_);
+    }
+    if (type == WriterType::GsoBatch) {
+      const Api::IoCallUint64Result rc = gso_writer.flush();
+      benchmark::DoNotOptimize(rc.return_value_);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * burst);
+  state.SetBytesProcessed(state.iterations() * burst * datagram.length());
+}
+BENCHMARK(bmUpstreamPacketRate)
+    ->ArgsProduct({{static_cast<int64_t>(WriterType::Direct),
+                    static_cast<int64_t>(WriterType::GsoBatch)},
+                   {1, 8, 32},
+                   {64, 512, 1200}})
+    ->Unit(benchmark::kMicrosecond);
+
+} // namespace
+} // namespace UdpProxy
+} // namespace UdpFilters
+} // namespace Extensions
+} // namespace Envoy
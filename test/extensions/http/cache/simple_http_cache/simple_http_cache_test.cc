@@ -1,3 +1,4 @@
+#include "envoy/extensions/http/cache/simple_http_cache/v3/config.pb.h"
 #include "envoy/http/header_map.h"
 #include "envoy/registry/registry.h"
 
@@ -45,6 +46,133 @@ TEST(Registration, GetFactory) {
             "envoy.extensions.http.cache.simple");
 }
 
+TEST(Registration, ChangedMaxCacheSize) {
+  HttpCacheFactory* factory = Registry::FactoryRegistry<HttpCacheFactory>::getFactoryByType(
+      "envoy.extensions.http.cache.simple_http_cache.v3.SimpleHttpCacheConfig");
+  ASSERT_NE(factory, nullptr);
+  testing::NiceMock<Server::Configuration::MockFactoryContext> factory_context;
+  envoy::extensions::http::cache::simple_http_cache::v3::SimpleHttpCacheConfig cache_config;
+  cache_config.mutable_max_cache_size_bytes()->set_value(1024 * 1024);
+  envoy::extensions::filters::http::cache::v3::CacheConfig config;
+  config.mutable_typed_config()->PackFrom(cache_config);
+  std::shared_ptr<HttpCache> cache = factory->getCache(config, factory_context);
+  EXPECT_EQ(dynamic_cast<SimpleHttpCache&>(*cache).maxCacheSizeBytes(), 1024 * 1024);
+  // The cache is shared, so other filters get the same one.
+  EXPECT_EQ(factory->getCache(config, factory_context), cache);
+
+  // A filter with another size, e.g. after a listener update, resizes the shared cache.
+  cache_config.mutable_max_cache_size_bytes()->set_value(2048);
+  config.mutable_typed_config()->PackFrom(cache_config);
+  EXPECT_EQ(factory->getCache(config, factory_context), cache);
+  EXPECT_EQ(dynamic_cast<SimpleHttpCache&>(*cache).maxCacheSizeBytes(), 2048);
+  EXPECT_EQ(dynamic_cast<SimpleHttpCache&>(*cache).maxEntrySizeBytes(),
+            2048 / SimpleHttpCache::NumShards);
+}
+
+class SimpleHttpCacheEvictionTest : public testing::Test {
+protected:
+  // Each shard holds up to 1000 bytes.
+  SimpleHttpCacheEvictionTest()
+      : cache_(1000 * SimpleHttpCache::NumShards),
+        vary_allow_list_(Protobuf::RepeatedPtrField<envoy::type::matcher::v3::StringMatcher>(),
+                         factory_context_),
+        lookup_request_(request_headers_, SystemTime(), vary_allow_list_) {}
+
+  // Returns a new key of the first shard, so that the tests know which entries compete.
+  Key keyOfFirstShard() {
+    while (true) {
+      Key key;
+      key.set_path(absl::StrCat("/", next_path_++));
+      if (SimpleHttpCache::HashedKey(key).hash_ % SimpleHttpCache::NumShards == 0) {
+        return key;
+      }
+    }
+  }
+
+  bool insert(const Key& key, size_t body_size) {
+    return cache_.insert(SimpleHttpCache::HashedKey(key),
+                         Http::createHeaderMap<Http::ResponseHeaderMapImpl>(
+                             {{Http::Headers::get().Status, "200"}}),
+                         {}, std::make_shared<const std::string>(body_size, 'a'), nullptr);
+  }
+
+  SimpleHttpCache::Entry lookup(const Key& key) {
+    return cache_.lookup(lookup_request_, SimpleHttpCache::HashedKey(key));
+  }
+
+  // Inserts entries looked up only once, which are evicted first.
+  void insertColdEntries(int count) {
+    for (int i = 0; i < count; ++i) {
+      EXPECT_TRUE(insert(keyOfFirstShard(), 200));
+    }
+  }
+
+  SimpleHttpCache cache_;
+  testing::NiceMock<Server::Configuration::MockServerFactoryContext> factory_context_;
+  VaryAllowList vary_allow_list_;
+  Http::TestRequestHeaderMapImpl request_headers_{
+      {":path", "/"}, {":method", "GET"}, {":scheme", "https"}, {":authority", "example.com"}};
+  LookupRequest lookup_request_;
+  int next_path_ = 0;
+};
+
+TEST_F(SimpleHttpCacheEvictionTest, StaysWithinMaxSize) {
+  const Key first = keyOfFirstShard();
+  EXPECT_TRUE(insert(first, 200));
+  insertColdEntries(20);
+  EXPECT_GT(cache_.sizeBytes(), 600);
+  EXPECT_LE(cache_.sizeBytes(), 1000);
+  EXPECT_EQ(lookup(first).response_headers_, nullptr);
+}
+
+TEST_F(SimpleHttpCacheEvictionTest, ShrinkEvicts) {
+  insertColdEntries(4);
+  EXPECT_GT(cache_.sizeBytes(), 800);
+  cache_.setMaxCacheSizeBytes(500 * SimpleHttpCache::NumShards);
+  EXPECT_LE(cache_.sizeBytes(), 500);
+  EXPECT_FALSE(insert(keyOfFirstShard(), 501));
+}
+
+TEST_F(SimpleHttpCacheEvictionTest, RejectsLargeEntries) {
+  EXPECT_FALSE(insert(keyOfFirstShard(), 1001));
+  EXPECT_EQ(cache_.sizeBytes(), 0);
+}
+
+TEST_F(SimpleHttpCacheEvictionTest, KeepsEntriesLookedUpAgain) {
+  const Key hot = keyOfFirstShard();
+  EXPECT_TRUE(insert(hot, 200));
+  EXPECT_NE(lookup(hot).response_headers_, nullptr);
+  insertColdEntries(20);
+  EXPECT_NE(lookup(hot).response_headers_, nullptr);
+}
+
+TEST_F(SimpleHttpCacheEvictionTest, KeepsEntriesInsertedAgainSoonAfterEviction) {
+  const Key hot = keyOfFirstShard();
+  EXPECT_TRUE(insert(hot, 200));
+  EXPECT_NE(lookup(hot).response_headers_, nullptr);
+  // The fifth entry doesn't fit, which moves the hot entry to the main queue, and evicts the
+  // oldest entry of the small queue.
+  const Key evicted = keyOfFirstShard();
+  EXPECT_TRUE(insert(evicted, 200));
+  insertColdEntries(3);
+  EXPECT_EQ(lookup(evicted).response_headers_, nullptr);
+
+  // Once inserted again, the entry goes to the main queue, and outlives newer entries.
+  EXPECT_TRUE(insert(evicted, 200));
+  insertColdEntries(20);
+  EXPECT_NE(lookup(evicted).response_headers_, nullptr);
+  EXPECT_NE(lookup(hot).response_headers_, nullptr);
+}
+
+TEST_F(SimpleHttpCacheEvictionTest, SharesBodies) {
+  const Key key = keyOfFirstShard();
+  EXPECT_TRUE(insert(key, 200));
+  const SimpleHttpCache::Entry first = lookup(key);
+  const SimpleHttpCache::Entry second = lookup(key);
+  ASSERT_NE(first.body_, nullptr);
+  EXPECT_EQ(first.body_, second.body_);
+}
+
 } // namespace
 } // namespace Cache
 } // namespace HttpFilters
@@ -1,6 +1,9 @@
 #pragma once
 
+#include <algorithm>
+#include <deque>
 #include <memory>
+#include <random>
 
 #include "envoy/config/cluster/v3/cluster.pb.h"
 
@@ -81,5 +84,50 @@ inline uint64_t hashInt(uint64_t i) {
   return HashUtil::xxHash64(absl::string_view(reinterpret_cast<const char*>(&i), sizeof(i)));
 }
 
+// Sends `requests` requests for keys drawn from a Zipf distribution over `num_keys` keys to lb and
+// counts the requests each host gets. At most `concurrency` requests are active at once, tracked in
+// the host and cluster gauges which bounded load hashing reads.
+inline void simulateZipfLoad(::benchmark::State& state, LoadBalancer& lb, uint64_t num_keys,
+                             uint64_t requests, uint64_t concurrency,
+                             absl::node_hash_map<std::string, uint64_t>& hit_counter) {
+  std::vector<double> cdf(num_keys);
+  double sum = 0;
+  for (uint64_t i = 0; i < num_keys; i++) {
+    sum += 1.0 / (i + 1);
+    cdf[i] = sum;
+  }
+  // Not using Random::RandomGenerator, so that every run draws the same keys.
+  std::mt19937_64 random(0);
+  std::uniform_real_distribution<double> uniform(0, sum);
+
+  TestLoadBalancerContext context;
+  std::deque<HostConstSharedPtr> active;
+  for (uint64_t i = 0; i < requests; i++) {
+    const uint64_t key = std::lower_bound(cdf.begin(), cdf.end(), uniform(random)) - cdf.begin();
+    context.hash_key_ = hashInt(key);
+    HostConstSharedPtr host = lb.chooseHost(&context);
+    hit_counter[host->address()->asString()] += 1;
+    host->stats().rq_active_.inc();
+    host->cluster().trafficStats()->upstream_rq_active_.inc();
+    active.push_back(std::move(host));
+    if (active.size() > concurrency) {
+      active.front()->stats().rq_active_.dec();
+      active.front()->cluster().trafficStats()->upstream_rq_active_.dec();
+      active.pop_front();
+    }
+  }
+  for (const HostConstSharedPtr& host : active) {
+    host->stats().rq_active_.dec();
+    host->cluster().trafficStats()->upstream_rq_active_.dec();
+  }
+
+  uint64_t max_hits = 0;
+  for (const auto& pair : hit_counter) {
+    max_hits = std::max(max_hits, pair.second);
+  }
+  computeHitStats(state, hit_counter);
+  state.counters["max_over_mean_hits"] = max_hits / state.counters["mean_hits"];
+}
+
 } // namespace Upstream
 } // namespace Envoy
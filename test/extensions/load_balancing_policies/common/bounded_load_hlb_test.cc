@@ -6,6 +6,7 @@
 
 #include "test/common/upstream/utility.h"
 #include "test/mocks/upstream/mocks.h"
+#include "test/test_common/test_runtime.h"
 
 namespace Envoy {
 namespace Upstream {
@@ -21,10 +22,26 @@ public:
     return ring_.at(hash).first;
   }
 
-private:
+protected:
   const NormalizedHostWeightVector ring_;
 };
 
+// Probes the entries after the one the hash maps to, or a single host if probe_host_ is set.
+class TestProbingHashingLoadBalancer : public TestHashingLoadBalancer {
+public:
+  using TestHashingLoadBalancer::TestHashingLoadBalancer;
+  HostConstSharedPtr probeHost(uint64_t hash, uint32_t probe) const override {
+    probes_++;
+    if (probe_host_ != nullptr) {
+      return probe_host_;
+    }
+    return ring_.at((hash + probe + 1) % ring_.size()).first;
+  }
+
+  HostConstSharedPtr probe_host_;
+  mutable uint32_t probes_{};
+};
+
 using HostOverloadFactorPredicate = std::function<double(const Host& host, double weight)>;
 class TestBoundedLoadHashingLoadBalancer
     : public ThreadAwareLoadBalancerBase::BoundedLoadHashingLoadBalancer {
@@ -298,6 +315,141 @@ TEST_F(BoundedLoadHashingLoadBalancerTest, AllHostsOverloaded) {
   EXPECT_EQ(host->address()->asString(), "127.0.0.11:90");
 };
 
+// Probes the hashing load balancer before falling back to visiting every host.
+TEST_F(BoundedLoadHashingLoadBalancerTest, ProbesHashingLoadBalancer) {
+  TestScopedRuntime scoped_runtime;
+  scoped_runtime.mergeValues({{"envoy.reloadable_features.bounded_load_probe_hashing_lb", "true"}});
+
+  // Hosts 2 and 3 are overloaded, so probing from hash 2 skips host 3 and picks host 4.
+  std::vector<std::string> addresses;
+  addresses.push_back("127.0.0.12:90");
+  addresses.push_back("127.0.0.13:90");
+  host_overload_factor_predicate_ = getHostOverloadFactorPredicate(addresses);
+
+  NormalizedHostWeightVector normalized_host_weights;
+  createHosts(5, normalized_host_weights);
+
+  auto probing_hlb = std::make_shared<TestProbingHashingLoadBalancer>(normalized_host_weights);
+  hlb_ = probing_hlb;
+  lb_ = std::make_unique<TestBoundedLoadHashingLoadBalancer>(hlb_, normalized_host_weights, 1,
+                                                             host_overload_factor_predicate_);
+
+  HostConstSharedPtr host = lb_->chooseHost(2, 1);
+  EXPECT_NE(host, nullptr);
+  EXPECT_EQ(host->address()->asString(), "127.0.0.14:90");
+  EXPECT_EQ(probing_hlb->probes_, 2U);
+};
+
+// Falls back to visiting every host when no probe finds a host that is not overloaded.
+TEST_F(BoundedLoadHashingLoadBalancerTest, ProbesExhausted) {
+  TestScopedRuntime scoped_runtime;
+  scoped_runtime.mergeValues({{"envoy.reloadable_features.bounded_load_probe_hashing_lb", "true"}});
+
+  std::vector<std::string> addresses;
+  addresses.push_back("127.0.0.12:90");
+  addresses.push_back("127.0.0.13:90");
+  host_overload_factor_predicate_ = getHostOverloadFactorPredicate(addresses);
+
+  NormalizedHostWeightVector normalized_host_weights;
+  createHosts(5, normalized_host_weights);
+
+  auto probing_hlb = std::make_shared<TestProbingHashingLoadBalancer>(normalized_host_weights);
+  probing_hlb->probe_host_ = normalized_host_weights[3].first;
+  hlb_ = probing_hlb;
+  lb_ = std::make_unique<TestBoundedLoadHashingLoadBalancer>(hlb_, normalized_host_weights, 1,
+                                                             host_overload_factor_predicate_);
+
+  HostConstSharedPtr host = lb_->chooseHost(2, 1);
+  EXPECT_NE(host, nullptr);
+  EXPECT_NE(host->address()->asString(), "127.0.0.12:90");
+  EXPECT_NE(host->address()->asString(), "127.0.0.13:90");
+  EXPECT_EQ(probing_hlb->probes_, 5U);
+};
+
+// Probes at most MaxBoundedLoadProbes times before visiting every host.
+TEST_F(BoundedLoadHashingLoadBalancerTest, ProbesCapped) {
+  TestScopedRuntime scoped_runtime;
+  scoped_runtime.mergeValues({{"envoy.reloadable_features.bounded_load_probe_hashing_lb", "true"}});
+
+  std::vector<std::string> addresses;
+  addresses.push_back("127.0.0.12:90");
+  addresses.push_back("127.0.0.13:90");
+  host_overload_factor_predicate_ = getHostOverloadFactorPredicate(addresses);
+
+  NormalizedHostWeightVector normalized_host_weights;
+  createHosts(20, normalized_host_weights);
+
+  auto probing_hlb = std::make_shared<TestProbingHashingLoadBalancer>(normalized_host_weights);
+  probing_hlb->probe_host_ = normalized_host_weights[3].first;
+  hlb_ = probing_hlb;
+  lb_ = std::make_unique<TestBoundedLoadHashingLoadBalancer>(hlb_, normalized_host_weights, 1,
+                                                             host_overload_factor_predicate_);
+
+  HostConstSharedPtr host = lb_->chooseHost(2, 1);
+  EXPECT_NE(host, nullptr);
+  EXPECT_NE(host->address()->asString(), "127.0.0.12:90");
+  EXPECT_NE(host->address()->asString(), "127.0.0.13:90");
+  EXPECT_EQ(probing_hlb->probes_,
+            ThreadAwareLoadBalancerBase::BoundedLoadHashingLoadBalancer::MaxBoundedLoadProbes);
+};
+
+// Does not visit every host when the probes already covered them all.
+TEST_F(BoundedLoadHashingLoadBalancerTest, ProbesCoveredAllHosts) {
+  TestScopedRuntime scoped_runtime;
+  scoped_runtime.mergeValues({{"envoy.reloadable_features.bounded_load_probe_hashing_lb", "true"}});
+
+  std::vector<std::string> addresses;
+  addresses.push_back("127.0.0.11:90");
+  addresses.push_back("127.0.0.10:90");
+  addresses.push_back("127.0.0.12:90");
+  uint32_t overload_factor_calls = 0;
+  host_overload_factor_predicate_ = [&overload_factor_calls,
+                                     predicate = getHostOverloadFactorPredicate(addresses)](
+                                        const Host& host, double weight) {
+    overload_factor_calls++;
+    return predicate(host, weight);
+  };
+
+  NormalizedHostWeightVector normalized_host_weights;
+  createHosts(3, normalized_host_weights);
+
+  auto probing_hlb = std::make_shared<TestProbingHashingLoadBalancer>(normalized_host_weights);
+  hlb_ = probing_hlb;
+  lb_ = std::make_unique<TestBoundedLoadHashingLoadBalancer>(hlb_, normalized_host_weights, 1,
+                                                             host_overload_factor_predicate_);
+
+  // All hosts are overloaded and host 1 the least, which the probes of hosts 1 and 2 find.
+  HostConstSharedPtr host = lb_->chooseHost(0, 1);
+  EXPECT_NE(host, nullptr);
+  EXPECT_EQ(host->address()->asString(), "127.0.0.11:90");
+  EXPECT_EQ(probing_hlb->probes_, 2U);
+  EXPECT_EQ(overload_factor_calls, 3U);
+};
+
+// The hashing load balancer is not probed when the runtime guard is disabled.
+TEST_F(BoundedLoadHashingLoadBalancerTest, ProbingDisabled) {
+  TestScopedRuntime scoped_runtime;
+  scoped_runtime.mergeValues(
+      {{"envoy.reloadable_features.bounded_load_probe_hashing_lb", "false"}});
+
+  std::vector<std::string> addresses;
+  addresses.push_back("127.0.0.12:90");
+  host_overload_factor_predicate_ = getHostOverloadFactorPredicate(addresses);
+
+  NormalizedHostWeightVector normalized_host_weights;
+  createHosts(5, normalized_host_weights);
+
+  auto probing_hlb = std::make_shared<TestProbingHashingLoadBalancer>(normalized_host_weights);
+  hlb_ = probing_hlb;
+  lb_ = std::make_unique<TestBoundedLoadHashingLoadBalancer>(hlb_, normalized_host_weights, 1,
+                                                             host_overload_factor_predicate_);
+
+  HostConstSharedPtr host = lb_->chooseHost(2, 1);
+  EXPECT_NE(host, nullptr);
+  EXPECT_NE(host->address()->asString(), "127.0.0.12:90");
+  EXPECT_EQ(probing_hlb->probes_, 0U);
+};
+
 } // namespace
 } // namespace Upstream
 } // namespace Envoy
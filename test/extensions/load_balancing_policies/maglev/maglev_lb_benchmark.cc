@@ -2,6 +2,7 @@
 
 #include "test/benchmark/main.h"
 #include "test/extensions/load_balancing_policies/common/benchmark_base_tester.h"
+#include "test/test_common/thread_factory_for_test.h"
 
 namespace Envoy {
 namespace Upstream {
@@ -9,8 +10,13 @@ namespace {
 
 class MaglevTester : public BaseTester {
 public:
-  MaglevTester(uint64_t num_hosts, uint32_t weighted_subset_percent = 0, uint32_t weight = 0)
+  MaglevTester(uint64_t num_hosts, uint32_t weighted_subset_percent = 0, uint32_t weight = 0,
+               uint32_t hash_balance_factor = 0)
       : BaseTester(num_hosts, weighted_subset_percent, weight) {
+    if (hash_balance_factor > 0) {
+      common_config_.mutable_consistent_hashing_lb_config()->mutable_hash_balance_factor()->set_value(
+          hash_balance_factor);
+    }
     maglev_lb_ = std::make_unique<MaglevLoadBalancer>(
         priority_set_, stats_, stats_scope_, runtime_, random_,
         config_.has_value()
@@ -56,6 +62,33 @@ BENCHMARK(benchmarkMaglevLoadBalancerChooseHost)
     ->Args({500, 100000})
     ->Unit(::benchmark::kMillisecond);
 
+// Compares the load distribution of a skewed key workload with and without bounded loads. A
+// hash_balance_factor of 0 does not bound the load. Probing for an alternative to an overloaded
+// host is enabled with
+// `--runtime_feature=envoy.reloadable_features.bounded_load_probe_hashing_lb:true`.
+void benchmarkMaglevLoadBalancerZipfLoad(::benchmark::State& state) {
+  for (auto _ : state) { // NOLINT: Silences warning about dead store
+    state.PauseTiming();
+    const uint64_t num_hosts = state.range(0);
+    const uint32_t hash_balance_factor = state.range(1);
+    MaglevTester tester(num_hosts, 0, 0, hash_balance_factor);
+    ASSERT_TRUE(tester.maglev_lb_->initialize().ok());
+    LoadBalancerPtr lb = tester.maglev_lb_->factory()->create(tester.lb_params_);
+    absl::node_hash_map<std::string, uint64_t> hit_counter;
+    state.ResumeTiming();
+
+    simulateZipfLoad(state, *lb, 10000, 100000, num_hosts * 10, hit_counter);
+  }
+}
+BENCHMARK(benchmarkMaglevLoadBalancerZipfLoad)
+    ->Args({100, 0})
+    ->Args({100, 125})
+    ->Args({100, 150})
+    ->Args({500, 0})
+    ->Args({500, 125})
+    ->Args({500, 150})
+    ->Unit(::benchmark::kMillisecond);
+
 void benchmarkMaglevLoadBalancerBuildTable(::benchmark::State& state) {
   for (auto _ : state) { // NOLINT: Silences warning about dead store
     state.PauseTiming();
@@ -80,6 +113,47 @@ BENCHMARK(benchmarkMaglevLoadBalancerBuildTable)
     ->Arg(500)
     ->Unit(::benchmark::kMillisecond);
 
+enum class RebuildMode { Full, Parallel, Incremental };
+
+NormalizedHostWeightVector equalHostWeights(HostVector::const_iterator begin,
+                                            HostVector::const_iterator end) {
+  NormalizedHostWeightVector host_weights;
+  const double weight = 1.0 / std::distance(begin, end);
+  for (auto it = begin; it != end; ++it) {
+    host_weights.push_back({*it, weight});
+  }
+  return host_weights;
+}
+
+// Latency of rebuilding the table of a cluster after one of its hosts was replaced by a new one.
+void benchmarkMaglevLoadBalancerRebuildTable(::benchmark::State& state) {
+  const uint64_t num_hosts = state.range(0);
+  const auto mode = static_cast<RebuildMode>(state.range(1));
+
+  // The table is rebuilt without the first host and with the extra last one.
+  MaglevTester tester(num_hosts + 1);
+  const HostVector& hosts = tester.priority_set_.hostSetsPerPriority()[0]->hosts();
+  const NormalizedHostWeightVector before = equalHostWeights(hosts.begin(), hosts.end() - 1);
+  const NormalizedHostWeightVector after = equalHostWeights(hosts.begin() + 1, hosts.end());
+  const double weight = 1.0 / num_hosts;
+  MaglevLoadBalancerStats stats{ALL_MAGLEV_LOAD_BALANCER_STATS(POOL_GAUGE(tester.stats_scope_))};
+  const CompactMaglevTable previous(before, weight, MaglevTable::DefaultTableSize, false, stats);
+  MaglevParallelRunner runner(Thread::threadFactoryForTest(), MaglevTable::MaxParallelBuildThreads);
+
+  for (auto _ : state) { // NOLINT: Silences warning about dead store
+    CompactMaglevTable table(after, weight, MaglevTable::DefaultTableSize, false, stats,
+                             mode == RebuildMode::Incremental ? &previous : nullptr,
+                             mode == RebuildMode::Parallel ? &runner : nullptr);
+    ::benchmark::DoNotOptimize(table);
+  }
+}
+BENCHMARK(benchmarkMaglevLoadBalancerRebuildTable)
+    ->ArgsProduct({{100, 1000, 5000, 10000},
+                   {static_cast<int64_t>(RebuildMode::Full),
+                    static_cast<int64_t>(RebuildMode::Parallel),
+                    static_cast<int64_t>(RebuildMode::Incremental)}})
+    ->Unit(::benchmark::kMillisecond);
+
 void benchmarkMaglevLoadBalancerHostLoss(::benchmark::State& state) {
   for (auto _ : state) { // NOLINT: Silences warning about dead store
     const uint64_t num_hosts = state.range(0);
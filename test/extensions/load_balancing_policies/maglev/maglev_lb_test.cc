@@ -14,6 +14,7 @@
 #include "test/test_common/simulated_time_system.h"
 #include "test/test_common/test_runtime.h"
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/types/optional.h"
 
 namespace Envoy {
@@ -71,6 +72,16 @@ public:
     EXPECT_TRUE(lb_->initialize().ok());
   }
 
+  // Creates a load balancer from the typed config, which rebuilds its tables incrementally.
+  void initIncremental(uint64_t table_size) {
+    envoy::extensions::load_balancing_policies::maglev::v3::Maglev config;
+    config.mutable_table_size()->set_value(table_size);
+    config.set_incremental_table_rebuild(true);
+    lb_ = std::make_unique<MaglevLoadBalancer>(priority_set_, stats_, *stats_store_.rootScope(),
+                                               runtime_, random_, 50, config);
+    EXPECT_TRUE(lb_->initialize().ok());
+  }
+
   NiceMock<MockPrioritySet> priority_set_;
 
   // Just use this as parameters of create() method but thread aware load balancer will not use it.
@@ -566,6 +577,116 @@ TEST_F(MaglevLoadBalancerTest, LocalityWeightedLopsided) {
   EXPECT_EQ(MaglevTable::DefaultTableSize - 1023, counts[0]);
 }
 
+// The table is the same whether it is filled on one thread or on several.
+TEST_F(MaglevLoadBalancerTest, ParallelBuild) {
+  for (uint32_t i = 0; i < 2 * MaglevTable::MinHostsForParallelBuild; ++i) {
+    host_set_.hosts_.push_back(
+        makeTestHost(info_, fmt::format("tcp://127.0.0.1:{}", i), simTime(), 1 + i % 3));
+  }
+  host_set_.healthy_hosts_ = host_set_.hosts_;
+  host_set_.runCallbacks({}, {});
+  init(MaglevTable::DefaultTableSize);
+  LoadBalancerPtr sequential_lb = lb_->factory()->create(lb_params_);
+
+  TestScopedRuntime scoped_runtime;
+  scoped_runtime.mergeValues({{"envoy.reloadable_features.maglev_parallel_table_build", "true"}});
+  init(MaglevTable::DefaultTableSize);
+  LoadBalancerPtr parallel_lb = lb_->factory()->create(lb_params_);
+
+  uint64_t different = 0;
+  for (uint64_t i = 0; i < MaglevTable::DefaultTableSize; ++i) {
+    TestLoadBalancerContext context(i);
+    if (sequential_lb->chooseHost(&context) != parallel_lb->chooseHost(&context)) {
+      ++different;
+    }
+  }
+  EXPECT_EQ(0, different);
+}
+
+// A small membership change only moves the entries of the removed host and the entries needed to
+// rebalance the hosts. A large one rebuilds the table from scratch.
+TEST_F(MaglevLoadBalancerTest, IncrementalRebuild) {
+  const uint64_t table_size = 1009;
+  for (uint32_t i = 0; i < 100; ++i) {
+    host_set_.hosts_.push_back(
+        makeTestHost(info_, fmt::format("tcp://127.0.0.1:{}", i), simTime()));
+  }
+  host_set_.healthy_hosts_ = host_set_.hosts_;
+  host_set_.runCallbacks({}, {});
+  initIncremental(table_size);
+
+  LoadBalancerPtr lb = lb_->factory()->create(lb_params_);
+  std::vector<HostConstSharedPtr> before;
+  for (uint64_t i = 0; i < table_size; ++i) {
+    TestLoadBalancerContext context(i);
+    before.push_back(lb->chooseHost(&context));
+  }
+
+  HostSharedPtr removed = host_set_.hosts_[10];
+  HostSharedPtr added = makeTestHost(info_, "tcp://127.0.0.1:100", simTime());
+  host_set_.hosts_[10] = added;
+  host_set_.healthy_hosts_ = host_set_.hosts_;
+  host_set_.runCallbacks({added}, {removed});
+  EXPECT_EQ(10, lb_->stats().min_entries_per_host_.value());
+  EXPECT_EQ(11, lb_->stats().max_entries_per_host_.value());
+
+  lb = lb_->factory()->create(lb_params_);
+  absl::flat_hash_map<HostConstSharedPtr, uint64_t> counts;
+  for (uint64_t i = 0; i < table_size; ++i) {
+    TestLoadBalancerContext context(i);
+    HostConstSharedPtr host = lb->chooseHost(&context);
+    counts[host]++;
+    // The hosts which were kept don't lose any entry.
+    if (before[i] != removed) {
+      EXPECT_EQ(before[i], host);
+    }
+  }
+  EXPECT_EQ(100, counts.size());
+  EXPECT_EQ(0, counts.count(removed));
+  EXPECT_GE(counts[added], 10);
+
+  // Replacing more than 5% of the hosts builds the same table as a new load balancer.
+  for (uint32_t i = 0; i < 10; ++i) {
+    host_set_.hosts_[i] =
+        makeTestHost(info_, fmt::format("tcp://127.0.0.1:{}", 200 + i), simTime());
+  }
+  host_set_.healthy_hosts_ = host_set_.hosts_;
+  host_set_.runCallbacks({}, {});
+  lb = lb_->factory()->create(lb_params_);
+  init(table_size);
+  LoadBalancerPtr new_lb = lb_->factory()->create(lb_params_);
+  for (uint64_t i = 0; i < table_size; ++i) {
+    TestLoadBalancerContext context(i);
+    EXPECT_EQ(new_lb->chooseHost(&context), lb->chooseHost(&context));
+  }
+}
+
+// Unless incremental rebuilds are configured, the table only depends on the current hosts.
+TEST_F(MaglevLoadBalancerTest, FullRebuildByDefault) {
+  const uint64_t table_size = 1009;
+  for (uint32_t i = 0; i < 100; ++i) {
+    host_set_.hosts_.push_back(
+        makeTestHost(info_, fmt::format("tcp://127.0.0.1:{}", i), simTime()));
+  }
+  host_set_.healthy_hosts_ = host_set_.hosts_;
+  host_set_.runCallbacks({}, {});
+  init(table_size);
+
+  HostSharedPtr removed = host_set_.hosts_[10];
+  HostSharedPtr added = makeTestHost(info_, "tcp://127.0.0.1:100", simTime());
+  host_set_.hosts_[10] = added;
+  host_set_.healthy_hosts_ = host_set_.hosts_;
+  host_set_.runCallbacks({added}, {removed});
+  LoadBalancerPtr lb = lb_->factory()->create(lb_params_);
+
+  init(table_size);
+  LoadBalancerPtr new_lb = lb_->factory()->create(lb_params_);
+  for (uint64_t i = 0; i < table_size; ++i) {
+    TestLoadBalancerContext context(i);
+    EXPECT_EQ(new_lb->chooseHost(&context), lb->chooseHost(&context));
+  }
+}
+
 } // namespace
 } // namespace Upstream
 } // namespace Envoy
@@ -9,7 +9,12 @@ namespace {
 
 class RingHashTester : public BaseTester {
 public:
-  RingHashTester(uint64_t num_hosts, uint64_t min_ring_size) : BaseTester(num_hosts) {
+  RingHashTester(uint64_t num_hosts, uint64_t min_ring_size, uint32_t hash_balance_factor = 0)
+      : BaseTester(num_hosts) {
+    if (hash_balance_factor > 0) {
+      common_config_.mutable_consistent_hashing_lb_config()->mutable_hash_balance_factor()->set_value(
+          hash_balance_factor);
+    }
     config_ = envoy::config::cluster::v3::Cluster::RingHashLbConfig();
     config_.value().mutable_minimum_ring_size()->set_value(min_ring_size);
     ring_hash_lb_ = std::make_unique<RingHashLoadBalancer>(
@@ -41,6 +46,8 @@ void benchmarkRingHashLoadBalancerBuildRing(::benchmark::State& state) {
     const size_t end_mem = Memory::Stats::totalCurrentlyAllocated();
     state.counters["memory"] = end_mem - start_mem;
     state.counters["memory_per_host"] = (end_mem - start_mem) / num_hosts;
+    state.counters["memory_per_entry"] =
+        static_cast<double>(end_mem - start_mem) / tester.ring_hash_lb_->stats().size_.value();
     state.ResumeTiming();
   }
 }
@@ -51,8 +58,33 @@ BENCHMARK(benchmarkRingHashLoadBalancerBuildRing)
     ->Args({100, 256000})
     ->Args({200, 256000})
     ->Args({500, 256000})
+    ->Args({100, 1048576})
+    ->Args({500, 1048576})
     ->Unit(::benchmark::kMillisecond);
 
+// Times only the ring lookups, for rings which do and do not fit in the CPU caches.
+void benchmarkRingHashLoadBalancerLookup(::benchmark::State& state) {
+  const uint64_t num_hosts = state.range(0);
+  const uint64_t min_ring_size = state.range(1);
+  RingHashTester tester(num_hosts, min_ring_size);
+  ASSERT_TRUE(tester.ring_hash_lb_->initialize().ok());
+  LoadBalancerPtr lb = tester.ring_hash_lb_->factory()->create(tester.lb_params_);
+  TestLoadBalancerContext context;
+
+  uint64_t i = 0;
+  for (auto _ : state) { // NOLINT: Silences warning about dead store
+    context.hash_key_ = hashInt(i++);
+    ::benchmark::DoNotOptimize(lb->chooseHost(&context));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(benchmarkRingHashLoadBalancerLookup)
+    ->Args({100, 1024})
+    ->Args({100, 65536})
+    ->Args({100, 256000})
+    ->Args({100, 1048576})
+    ->Args({500, 1048576});
+
 void benchmarkRingHashLoadBalancerChooseHost(::benchmark::State& state) {
   for (auto _ : state) { // NOLINT: Silences warning about dead store
     // Do not time the creation of the ring.
@@ -92,6 +124,33 @@ BENCHMARK(benchmarkRingHashLoadBalancerChooseHost)
     ->Args({500, 256000, 100000})
     ->Unit(::benchmark::kMillisecond);
 
+// Compares the load distribution of a skewed key workload with and without bounded loads. A
+// hash_balance_factor of 0 does not bound the load. Probing for an alternative to an overloaded
+// host is enabled with
+// `--runtime_feature=envoy.reloadable_features.bounded_load_probe_hashing_lb:true`.
+void benchmarkRingHashLoadBalancerZipfLoad(::benchmark::State& state) {
+  for (auto _ : state) { // NOLINT: Silences warning about dead store
+    state.PauseTiming();
+    const uint64_t num_hosts = state.range(0);
+    const uint32_t hash_balance_factor = state.range(1);
+    RingHashTester tester(num_hosts, 65536, hash_balance_factor);
+    ASSERT_TRUE(tester.ring_hash_lb_->initialize().ok());
+    LoadBalancerPtr lb = tester.ring_hash_lb_->factory()->create(tester.lb_params_);
+    absl::node_hash_map<std::string, uint64_t> hit_counter;
+    state.ResumeTiming();
+
+    simulateZipfLoad(state, *lb, 10000, 100000, num_hosts * 10, hit_counter);
+  }
+}
+BENCHMARK(benchmarkRingHashLoadBalancerZipfLoad)
+    ->Args({100, 0})
+    ->Args({100, 125})
+    ->Args({100, 150})
+    ->Args({500, 0})
+    ->Args({500, 125})
+    ->Args({500, 150})
+    ->Unit(::benchmark::kMillisecond);
+
 void benchmarkRingHashLoadBalancerHostLoss(::benchmark::State& state) {
   const uint64_t num_hosts = state.range(0);
   const uint64_t min_ring_size = state.range(1);
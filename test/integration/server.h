@@ -316,6 +316,10 @@ public:
     UNREFERENCED_PARAMETER(sink_predicates);
   }
   OptRef<SinkPredicates> sinkPredicates() override { return OptRef<SinkPredicates>{}; }
+  void setShardCount(uint32_t shard_count, Allocator::ShardedStatPredicate predicate) override {
+    UNREFERENCED_PARAMETER(shard_count);
+    UNREFERENCED_PARAMETER(predicate);
+  }
   void deliverHistogramToSinks(const Histogram& histogram, uint64_t value) override {
     Thread::LockGuard lock(lock_);
     store_.deliverHistogramToSinks(histogram, value);
@@ -16,12 +16,14 @@ public:
   MOCK_METHOD(IoUringResult, prepareAccept,
               (os_fd_t fd, struct sockaddr* remote_addr, socklen_t* remote_addr_len,
                Request* user_data));
+  MOCK_METHOD(IoUringResult, prepareAcceptMultishot, (os_fd_t fd, Request* user_data));
   MOCK_METHOD(IoUringResult, prepareConnect,
               (os_fd_t fd, const Network::Address::InstanceConstSharedPtr& address,
                Request* user_data));
   MOCK_METHOD(IoUringResult, prepareReadv,
               (os_fd_t fd, const struct iovec* iovecs, unsigned nr_vecs, off_t offset,
                Request* user_data));
+  MOCK_METHOD(IoUringResult, prepareRecvMultishot, (os_fd_t fd, Request* user_data));
   MOCK_METHOD(IoUringResult, prepareWritev,
               (os_fd_t fd, const struct iovec* iovecs, unsigned nr_vecs, off_t offset,
                Request* user_data));
@@ -31,6 +33,13 @@ public:
   MOCK_METHOD(IoUringResult, submit, ());
   MOCK_METHOD(void, injectCompletion, (os_fd_t fd, Request* user_data, int32_t result));
   MOCK_METHOD(void, removeInjectedCompletion, (os_fd_t fd));
+  MOCK_METHOD(bool, registerBufferRing, (uint32_t buffer_count, uint32_t buffer_size));
+  MOCK_METHOD(void, takeProvidedBuffer,
+              (uint16_t buffer_id, uint32_t length, Buffer::Instance& buffer));
+  MOCK_METHOD(void, recycleProvidedBuffer, (uint16_t buffer_id));
+  MOCK_METHOD(bool, registerFileTable, (uint32_t size));
+  MOCK_METHOD(void, registerFile, (os_fd_t fd));
+  MOCK_METHOD(void, unregisterFile, (os_fd_t fd));
 };
 
 class MockIoUringSocket : public IoUringSocket {
@@ -57,6 +66,7 @@ public:
   MOCK_METHOD(const OptRef<ReadParam>&, getReadParam, (), (const));
   MOCK_METHOD(const OptRef<WriteParam>&, getWriteParam, (), (const));
   MOCK_METHOD(void, setFileReadyCb, (Event::FileReadyCb cb));
+  MOCK_METHOD(os_fd_t, popAcceptedSocket, ());
 };
 
 class MockIoUringWorker : public IoUringWorker {
@@ -68,9 +78,12 @@ public:
                bool enable_close_event));
   MOCK_METHOD(IoUringSocket&, addClientSocket,
               (os_fd_t fd, Event::FileReadyCb cb, bool enable_close_event));
+  MOCK_METHOD(IoUringSocket&, addAcceptSocket, (os_fd_t fd, Event::FileReadyCb cb));
+  MOCK_METHOD(bool, supportsMultishot, (), (const));
   MOCK_METHOD(Event::Dispatcher&, dispatcher, ());
   MOCK_METHOD(Request*, submitConnectRequest,
               (IoUringSocket & socket, const Network::Address::InstanceConstSharedPtr& address));
+  MOCK_METHOD(Request*, submitAcceptRequest, (IoUringSocket & socket));
   MOCK_METHOD(Request*, submitReadRequest, (IoUringSocket & socket));
   MOCK_METHOD(Request*, submitWriteRequest,
               (IoUringSocket & socket, const Buffer::RawSliceVector& slices));